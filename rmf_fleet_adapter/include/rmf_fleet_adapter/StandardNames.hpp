@@ -33,10 +33,13 @@ const std::string AdapterDoorRequestTopicName = "adapter_door_requests";
 const std::string DoorStateTopicName = "door_states";
 const std::string DoorSupervisorHeartbeatTopicName =
   "door_supervisor_heartbeat";
+const std::string UpcomingDoorSessionsTopicName =
+  "adapter_upcoming_door_sessions";
 
 const std::string FinalLiftRequestTopicName = "lift_requests";
 const std::string AdapterLiftRequestTopicName = "adapter_lift_requests";
 const std::string LiftStateTopicName = "lift_states";
+const std::string LiftSupervisorQueueTopicName = "lift_supervisor_queues";
 
 const std::string DispenserRequestTopicName = "dispenser_requests";
 const std::string DispenserResultTopicName = "dispenser_results";
@@ -55,10 +58,17 @@ const std::string BidProposalTopicName = "rmf_task/bid_proposal";
 const std::string DispatchRequestTopicName = "rmf_task/dispatch_request";
 const std::string DispatchAckTopicName = "rmf_task/dispatch_ack";
 
+const std::string FleetShardTopicPrefix = "rmf_fleet_adapter/fleet_shards/";
+
 const std::string DockSummaryTopicName = "dock_summary";
 
 const std::string LaneClosureRequestTopicName = "lane_closure_requests";
 const std::string ClosedLaneTopicName = "closed_lanes";
+const std::string LaneStateUpdateTopicName = "lane_state_updates";
+
+const std::string WorkerDiagnosticsTopicName =
+  "fleet_adapter_worker_diagnostics";
+const std::string MemoryReportServiceName = "fleet_adapter_memory_report";
 
 const std::string TaskApiRequests = "task_api_requests";
 const std::string TaskApiResponses = "task_api_responses";
@@ -149,6 +149,74 @@ public:
   EasyTrafficLight& fleet_state_publish_period(
     std::optional<rmf_traffic::Duration> value);
 
+  /// The state of one robot, to be given to update_states(~). Use the static
+  /// functions of this class to create it.
+  struct State
+  {
+    enum class Type : uint8_t
+    {
+      /// Equivalent to calling moving_from(checkpoint, location)
+      MovingFrom = 0,
+
+      /// Equivalent to calling waiting_at(checkpoint)
+      WaitingAt,
+
+      /// Equivalent to calling waiting_after(checkpoint, location)
+      WaitingAfter,
+
+      /// Equivalent to calling update_idle_location(map_name, location)
+      Idle
+    };
+
+    std::shared_ptr<EasyTrafficLight> robot;
+    Type type;
+    std::size_t checkpoint = 0;
+    Eigen::Vector3d location = Eigen::Vector3d::Zero();
+    std::string map_name;
+
+    static State moving_from(
+      std::shared_ptr<EasyTrafficLight> robot,
+      std::size_t checkpoint,
+      Eigen::Vector3d location);
+
+    static State waiting_at(
+      std::shared_ptr<EasyTrafficLight> robot,
+      std::size_t checkpoint);
+
+    static State waiting_after(
+      std::shared_ptr<EasyTrafficLight> robot,
+      std::size_t checkpoint,
+      Eigen::Vector3d location);
+
+    static State idle(
+      std::shared_ptr<EasyTrafficLight> robot,
+      std::string map_name,
+      Eigen::Vector3d location);
+  };
+
+  /// The instruction for one robot, as returned by update_states(~). Only the
+  /// field that matches the type of the state will have a value.
+  struct Instruction
+  {
+    std::optional<MovingInstruction> moving;
+    std::optional<WaitingInstruction> waiting;
+  };
+
+  /// Update the states of many robots at once. This has the same effect as
+  /// calling the individual function of each state in order, except the
+  /// resulting traffic updates are all handed to the adapter together instead
+  /// of one robot at a time. This is meant for fleet managers that report the
+  /// states of many robots together.
+  ///
+  /// \param[in] states
+  ///   The states of the robots. A robot may appear more than once, in which
+  ///   case its states are applied in the order that they are given.
+  ///
+  /// eturn the instructions for the robots, in the same order as the states.
+  [[nodiscard]]
+  static std::vector<Instruction> update_states(
+    const std::vector<State>& states);
+
   class Implementation;
 private:
   EasyTrafficLight();
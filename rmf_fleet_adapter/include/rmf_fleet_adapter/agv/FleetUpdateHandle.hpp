@@ -75,6 +75,37 @@ public:
     rmf_traffic::agv::Plan::StartSet start,
     std::function<void(std::shared_ptr<RobotUpdateHandle> handle)> handle_cb);
 
+  /// The information that add_robots() needs for each robot. Each field has
+  /// the same meaning as the matching argument of add_robot().
+  struct NewRobot
+  {
+    std::shared_ptr<RobotCommandHandle> command;
+    std::string name;
+    rmf_traffic::Profile profile;
+    rmf_traffic::agv::Plan::StartSet start;
+  };
+
+  /// Add a batch of robots to this fleet adapter. The schedule registrations
+  /// of all the robots are requested at once instead of one after another,
+  /// and the rest of the setup of each robot proceeds as soon as its own
+  /// registration is done, so bringing up a large fleet this way is much
+  /// faster than calling add_robot() for each robot.
+  ///
+  /// \param[in] robots
+  ///   The robots that should be added.
+  ///
+  /// \param[in] handles_cb
+  ///   This callback function will get triggered once every robot is ready to
+  ///   be used by the Fleet API side of the Adapter. The handles are given in
+  ///   the same order as the robots.
+  ///
+  /// 	hrows std::runtime_error if the StartSet of any robot is empty. In that
+  /// case none of the robots will be added.
+  void add_robots(
+    std::vector<NewRobot> robots,
+    std::function<void(std::vector<std::shared_ptr<RobotUpdateHandle>> handles)>
+    handles_cb);
+
   /// Confirmation is a class used by the task acceptance callbacks to decide if
   /// a task description should be accepted.
   class Confirmation
@@ -220,6 +251,77 @@ public:
   /// Specify a set of lanes that should be open.
   void open_lanes(std::vector<std::size_t> lane_indices);
 
+  /// Open one set of lanes and close another as a single change, so the
+  /// planner only gets reconfigured once. If a lane appears in both sets, it
+  /// will be closed.
+  void change_lanes(
+    std::vector<std::size_t> open_lanes,
+    std::vector<std::size_t> close_lanes);
+
+  /// The position of one robot, to be given to update_positions(~). Use the
+  /// static functions of this class to create it.
+  struct RobotPosition
+  {
+    enum class Type : uint8_t
+    {
+      /// Equivalent to RobotUpdateHandle::update_position(waypoint,
+      /// orientation). Only the yaw of the position is used.
+      OnWaypoint = 0,
+
+      /// Equivalent to RobotUpdateHandle::update_position(position, lanes)
+      OnLanes,
+
+      /// Equivalent to RobotUpdateHandle::update_position(position, waypoint)
+      OffGrid,
+
+      /// Equivalent to RobotUpdateHandle::update_position(map_name, position)
+      /// with the default merge distances
+      Lost
+    };
+
+    std::shared_ptr<RobotUpdateHandle> robot;
+    Type type;
+    Eigen::Vector3d position = Eigen::Vector3d::Zero();
+    std::size_t waypoint = 0;
+    std::vector<std::size_t> lanes;
+    std::string map_name;
+
+    static RobotPosition on_waypoint(
+      std::shared_ptr<RobotUpdateHandle> robot,
+      std::size_t waypoint,
+      double orientation);
+
+    static RobotPosition on_lanes(
+      std::shared_ptr<RobotUpdateHandle> robot,
+      Eigen::Vector3d position,
+      std::vector<std::size_t> lanes);
+
+    static RobotPosition off_grid(
+      std::shared_ptr<RobotUpdateHandle> robot,
+      Eigen::Vector3d position,
+      std::size_t target_waypoint);
+
+    static RobotPosition lost(
+      std::shared_ptr<RobotUpdateHandle> robot,
+      std::string map_name,
+      Eigen::Vector3d position);
+  };
+
+  /// Update the positions of many robots of this fleet at once. This has the
+  /// same effect as calling the matching RobotUpdateHandle::update_position(~)
+  /// for each robot, except the current time is only read once for the whole
+  /// batch and each robot only gets one update handed to its worker. This is
+  /// meant for fleet managers that report the positions of all their robots
+  /// together.
+  ///
+  /// \param[in] positions
+  ///   The positions of the robots. If a robot appears more than once, its
+  ///   last position is the one that gets used.
+  ///
+  /// 	hrows std::runtime_error if an OnLanes position has no lanes. In that
+  /// case none of the positions are applied.
+  void update_positions(const std::vector<RobotPosition>& positions);
+
   /// Set the parameters required for task planning. Without calling this
   /// function, this fleet will not bid for and accept tasks.
   ///
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_FLEET_ADAPTER__AGV__GRAPHEVENTINDEX_HPP
+#define RMF_FLEET_ADAPTER__AGV__GRAPHEVENTINDEX_HPP
+
+#include <rmf_traffic/agv/Graph.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// An index from the names that appear in the lane events of a graph (docks,
+/// doors, and lifts) to the lanes that carry those events. Build this once
+/// when the graph is loaded instead of scanning every lane of the graph to
+/// find the lanes for a name.
+///
+/// The index refers to lanes by their index in the graph, so it needs to be
+/// rebuilt if lanes are added to the graph afterwards.
+class GraphEventIndex
+{
+public:
+
+  /// Constructor
+  ///
+  /// \param[in] graph
+  ///   The graph to index
+  GraphEventIndex(const rmf_traffic::agv::Graph& graph);
+
+  /// Get the lanes whose entry event docks into the named dock. The entry
+  /// waypoint of each of these lanes is where the robot begins docking.
+  const std::vector<std::size_t>& dock_lanes(
+    const std::string& dock_name) const;
+
+  /// Get the lanes that open or close the named door
+  const std::vector<std::size_t>& door_lanes(
+    const std::string& door_name) const;
+
+  /// Get the lanes that have an event for the named lift
+  const std::vector<std::size_t>& lift_lanes(
+    const std::string& lift_name) const;
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // RMF_FLEET_ADAPTER__AGV__GRAPHEVENTINDEX_HPP
@@ -98,6 +98,16 @@ public:
   /// charge as a fraction of its total charge capacity
   void update_battery_soc(const double battery_soc);
 
+  /// Hold back battery updates from the rest of the fleet adapter until the
+  /// battery level has changed by at least change_threshold. When the level
+  /// turns around, it must change by the hysteresis on top of that. This is
+  /// useful for drivers that report a noisy battery level at a high rate. By
+  /// default the battery_soc_change_threshold and battery_soc_hysteresis
+  /// parameters of the fleet are used.
+  RobotUpdateHandle& set_battery_soc_filter(
+    double change_threshold,
+    double hysteresis = 0.0);
+
   /// Specify how high the delay of the current itinerary can become before it
   /// gets interrupted and replanned. A nullopt value will allow for an
   /// arbitrarily long delay to build up without being interrupted.
@@ -82,8 +82,10 @@ public:
     UpdateHandle& update_battery_soc(double battery_soc);
 
     /// Specify a period for how often the fleet state message is published for
-    /// this fleet. Passing in std::nullopt will disable the fleet state message
-    /// publishing. The default value is 1s.
+    /// this fleet. The traffic light robots of a fleet are published together
+    /// in one message, so this period is shared by all of them. Passing in
+    /// std::nullopt will leave this robot out of the fleet state message. The
+    /// default value is 1s.
     UpdateHandle& fleet_state_publish_period(
       std::optional<rmf_traffic::Duration> value);
 
@@ -34,6 +34,20 @@ rmf_traffic::agv::Graph parse_graph(
   const std::string& filename,
   const rmf_traffic::agv::VehicleTraits& vehicle_traits);
 
+/// Parse the graph described by a yaml file, using a compiled copy of it from
+/// the cache directory when one is available. The compiled copy is keyed by
+/// the content of the yaml file, so the yaml file only gets parsed again after
+/// it changes. If the cache directory is empty, this is the same as the
+/// overload above. The cache directory must already exist; if the compiled
+/// copy cannot be written there, the graph is still returned.
+///
+/// \warning This will throw a std::runtime_error if the file has a syntax
+/// error.
+rmf_traffic::agv::Graph parse_graph(
+  const std::string& filename,
+  const rmf_traffic::agv::VehicleTraits& vehicle_traits,
+  const std::string& cache_directory);
+
 } // namespace agv
 } // namespace rmf_fleet_adapter
 
@@ -72,7 +72,19 @@ public:
   void stop();
 
   /// Submit a task request
-  void dispatch_task(std::string task_id, const nlohmann::json& request);
+  ///
+  /// \param[in] on_bid
+  ///   If this is provided, it will be told the name of the robot that won the
+  ///   task once the fleets have finished bidding on it, or std::nullopt if
+  ///   the task was rejected.
+  void dispatch_task(
+    std::string task_id,
+    const nlohmann::json& request,
+    std::function<void(std::optional<std::string> robot)> on_bid = nullptr);
+
+  /// Run a job on the worker that the fleets of this adapter share. How long
+  /// the job waits before it runs shows how far behind the worker is.
+  void schedule(std::function<void()> job);
 
   ~MockAdapter();
 
@@ -20,6 +20,7 @@
 
 #include <rmf_rxcpp/detail/TransportDetail.hpp>
 #include <rmf_rxcpp/RxJobs.hpp>
+#include <rmf_rxcpp/WorkerMonitor.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rxcpp/rx.hpp>
 #include <utility>
@@ -60,7 +61,20 @@ public:
 
     while (keep_spinning())
     {
-      _work_scheduled = true;
+      // Block on the wait set until some entity is ready. Adding a node,
+      // shutting down the context, or calling stop() will trigger the
+      // interrupt guard condition of the executor, which wakes this up.
+      wait_for_work(std::chrono::nanoseconds(-1));
+      if (!keep_spinning())
+        break;
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _work_scheduled = true;
+      }
+
+      // Only wake up the worker when there is ready work for it to execute.
+      WorkerMonitor::Tag tag("ros_callbacks");
       _worker.schedule([w = weak_from_this()](const auto&)
         {
           if (const auto& self = w.lock())
@@ -77,25 +91,15 @@ public:
         });
 
       {
+        // Wait until the worker has finished executing the ready work before
+        // we wait on the wait set again, otherwise the same work would wake
+        // us up a second time.
         std::unique_lock<std::mutex> lock(_mutex);
-        while (_work_scheduled && keep_spinning())
-        {
-          // If work is already scheduled to be done, wait until there is no
-          // longer any work scheduled (or if we're no longer supposed to keep
-          // spinning).
-          _cv.wait_for(lock, std::chrono::milliseconds(50), [&]()
-            {
-              return !_work_scheduled || !keep_spinning();
-            });
-        }
+        _cv.wait(lock, [&]()
+          {
+            return !_work_scheduled || !keep_spinning();
+          });
       }
-
-      // TODO(MXG): It would be better if we could check whether work is really
-      // available before we keep looping. Or if we could interrupt an
-      // indefinite wait when a stop is requested (maybe by creating a no-op
-      // timer callback?).
-      if (keep_spinning())
-        wait_for_work(std::chrono::milliseconds(50));
     }
 
     _started = false;
@@ -104,10 +108,23 @@ public:
 
   void stop()
   {
-    _stopping = true;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+
+    // Interrupt the wait set in case the spin thread is blocked on it
+    cancel();
     _cv.notify_all();
   }
 
+  /// Change the worker that the callbacks are executed on. This must not be
+  /// called while the executor is spinning.
+  void worker(rxcpp::schedulers::worker new_worker)
+  {
+    _worker = std::move(new_worker);
+  }
+
   void wait_until_started()
   {
     while (!_started)
@@ -197,6 +214,14 @@ public:
     _executor->add_node(node);
   }
 
+  /// Change the worker that the callbacks of this transport are executed on,
+  /// for example to a worker that is measured by a WorkerMonitor. This must be
+  /// called before start().
+  void worker(rxcpp::schedulers::worker new_worker)
+  {
+    _executor->worker(std::move(new_worker));
+  }
+
   void start()
   {
     std::unique_lock<std::mutex> lock(_stopping_mutex);
@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_RXCPP__WORKERMONITOR_HPP
+#define RMF_RXCPP__WORKERMONITOR_HPP
+
+#include <rxcpp/rx.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rmf_rxcpp {
+
+//==============================================================================
+/// Writes the items of monitored workers to a file in the Chrome trace event
+/// format, which can be opened with chrome://tracing or Perfetto. Several
+/// monitors can share one file.
+class TraceFile
+{
+public:
+
+  using Clock = std::chrono::steady_clock;
+
+  explicit TraceFile(const std::string& path)
+  : _file(path),
+    _start(Clock::now())
+  {
+    // The closing bracket of the array is optional in this format, so the
+    // file can still be read if the process does not exit cleanly.
+    _file << "[\n";
+  }
+
+  bool good() const
+  {
+    return _file.good();
+  }
+
+  void write(
+    const std::string& worker,
+    const char* tag,
+    const Clock::time_point start,
+    const Clock::time_point finish)
+  {
+    const auto us = [](const Clock::duration d)
+      {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+          .count();
+      };
+
+    const auto tid = static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _file << (_first ? "" : ",\n")
+          << "{\"name\":\"" << (tag ? tag : "untagged")
+          << "\",\"cat\":\"" << worker
+          << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+          << ",\"ts\":" << us(start - _start)
+          << ",\"dur\":" << us(finish - start) << "}";
+    _first = false;
+  }
+
+  ~TraceFile()
+  {
+    _file << "\n]\n";
+  }
+
+private:
+  std::mutex _mutex;
+  std::ofstream _file;
+  Clock::time_point _start;
+  bool _first = true;
+};
+
+//==============================================================================
+/// Measures the items that get scheduled on a worker: how many are waiting to
+/// run, how long they wait, and which ones run for too long. Use wrap() to get
+/// a worker that reports to this monitor. Everything that gets scheduled
+/// through the wrapped worker is measured, including the items that rxcpp
+/// operators like observe_on schedule.
+class WorkerMonitor : public std::enable_shared_from_this<WorkerMonitor>
+{
+public:
+
+  using Clock = std::chrono::steady_clock;
+
+  /// Items that get scheduled from a thread while a Tag is alive on it are
+  /// tagged with its name, so that long running items can be traced back to
+  /// where they were scheduled from. Items that are scheduled from inside a
+  /// monitored item inherit the tag of that item. The name must be a string
+  /// literal or otherwise outlive the items that it tags.
+  class Tag
+  {
+  public:
+
+    explicit Tag(const char* name)
+    : _previous(current())
+    {
+      current() = name;
+    }
+
+    ~Tag()
+    {
+      current() = _previous;
+    }
+
+    static const char*& current()
+    {
+      static thread_local const char* tag = nullptr;
+      return tag;
+    }
+
+  private:
+    const char* _previous;
+  };
+
+  struct LongItem
+  {
+    std::string tag;
+    Clock::duration run_time;
+  };
+
+  /// A summary of the items that ran since the last report
+  struct Report
+  {
+    std::string name;
+
+    /// How many items are waiting to run right now
+    std::size_t depth = 0;
+
+    /// The most items that were waiting at once
+    std::size_t max_depth = 0;
+
+    /// How many items ran
+    std::size_t executed = 0;
+
+    /// How long the items waited past the time that they were scheduled for
+    Clock::duration mean_latency = Clock::duration(0);
+    Clock::duration max_latency = Clock::duration(0);
+
+    /// How long the longest item ran for
+    Clock::duration max_run_time = Clock::duration(0);
+
+    /// The items that ran for longer than the threshold of the monitor. Only
+    /// the first few are kept.
+    std::vector<LongItem> long_items;
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] name
+  ///   The name of the worker in reports and traces
+  ///
+  /// \param[in] long_item_threshold
+  ///   Items that run for longer than this are reported as long items
+  ///
+  /// \param[in] max_long_items
+  ///   The most long items to keep in each report
+  WorkerMonitor(
+    std::string name,
+    Clock::duration long_item_threshold = std::chrono::milliseconds(50),
+    std::size_t max_long_items = 16)
+  : _name(std::move(name)),
+    _long_item_threshold(long_item_threshold),
+    _max_long_items(max_long_items)
+  {
+    _report.name = _name;
+  }
+
+  const std::string& name() const
+  {
+    return _name;
+  }
+
+  /// Get a worker that schedules its items on the inner worker and measures
+  /// them with this monitor
+  rxcpp::schedulers::worker wrap(const rxcpp::schedulers::worker& inner);
+
+  /// Write every item that runs into a trace file
+  void trace(std::shared_ptr<TraceFile> file)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _trace = std::move(file);
+  }
+
+  /// Get the report of the items that ran since the last call, and begin a new
+  /// report
+  Report take_report()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Report report = std::move(_report);
+    report.depth = _depth.load();
+    report.max_depth = std::max(report.max_depth, report.depth);
+    if (report.executed > 0)
+      report.mean_latency = _total_latency / report.executed;
+
+    _report = Report();
+    _report.name = _name;
+    _report.max_depth = report.depth;
+    _total_latency = Clock::duration(0);
+    return report;
+  }
+
+  /// Called by the wrapped worker when an item is scheduled
+  void queued()
+  {
+    const auto depth = ++_depth;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _report.max_depth = std::max(_report.max_depth, depth);
+  }
+
+  /// Called by the wrapped worker when an item has finished
+  void executed(
+    const Clock::time_point due,
+    const Clock::time_point start,
+    const Clock::time_point finish,
+    const char* tag)
+  {
+    --_depth;
+    const auto latency = std::max(start - due, Clock::duration(0));
+    const auto run_time = finish - start;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_report.executed;
+    _total_latency += latency;
+    _report.max_latency = std::max(_report.max_latency, latency);
+    _report.max_run_time = std::max(_report.max_run_time, run_time);
+    if (run_time > _long_item_threshold
+      && _report.long_items.size() < _max_long_items)
+    {
+      _report.long_items.push_back({tag ? tag : "untagged", run_time});
+    }
+
+    if (_trace)
+      _trace->write(_name, tag, start, finish);
+  }
+
+private:
+  std::string _name;
+  Clock::duration _long_item_threshold;
+  std::size_t _max_long_items;
+  std::atomic<std::size_t> _depth{0};
+
+  std::mutex _mutex;
+  Report _report;
+  Clock::duration _total_latency = Clock::duration(0);
+  std::shared_ptr<TraceFile> _trace;
+};
+
+namespace detail {
+
+//==============================================================================
+class MonitoredWorker : public rxcpp::schedulers::worker_interface
+{
+public:
+
+  MonitoredWorker(
+    rxcpp::schedulers::worker inner,
+    std::shared_ptr<WorkerMonitor> monitor)
+  : _inner(std::move(inner)),
+    _monitor(std::move(monitor))
+  {
+    // Do nothing
+  }
+
+  clock_type::time_point now() const final
+  {
+    return _inner.now();
+  }
+
+  void schedule(const rxcpp::schedulers::schedulable& scbl) const final
+  {
+    _inner.schedule(_make(scbl, clock_type::now()));
+  }
+
+  void schedule(
+    clock_type::time_point when,
+    const rxcpp::schedulers::schedulable& scbl) const final
+  {
+    _inner.schedule(when, _make(scbl, when));
+  }
+
+private:
+
+  rxcpp::schedulers::schedulable _make(
+    const rxcpp::schedulers::schedulable& scbl,
+    const clock_type::time_point due) const
+  {
+    _monitor->queued();
+
+    // The measuring item does not share the lifetime of the original one, so
+    // that it still runs, and counts as finished, if the original gets
+    // unsubscribed while it waits.
+    return rxcpp::schedulers::make_schedulable(
+      _inner,
+      [scbl, due, tag = WorkerMonitor::Tag::current(), monitor = _monitor](
+        const rxcpp::schedulers::schedulable&)
+      {
+        const auto start = WorkerMonitor::Clock::now();
+        {
+          WorkerMonitor::Tag scope(tag);
+
+          // Tail recursion is not allowed here, so if the original item asks
+          // to be run again it gets scheduled through this worker again and
+          // is measured as a new item.
+          const rxcpp::schedulers::recursion recursion(false);
+          scbl(recursion.get_recurse());
+        }
+        monitor->executed(due, start, WorkerMonitor::Clock::now(), tag);
+      });
+  }
+
+  rxcpp::schedulers::worker _inner;
+  std::shared_ptr<WorkerMonitor> _monitor;
+};
+
+} // namespace detail
+
+//==============================================================================
+inline rxcpp::schedulers::worker WorkerMonitor::wrap(
+  const rxcpp::schedulers::worker& inner)
+{
+  return rxcpp::schedulers::worker(
+    inner.get_subscription(),
+    std::make_shared<detail::MonitoredWorker>(inner, shared_from_this()));
+}
+
+} // namespace rmf_rxcpp
+
+#endif // RMF_RXCPP__WORKERMONITOR_HPP
@@ -22,8 +22,13 @@
 
 #include <rclcpp/contexts/default_context.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -112,6 +117,78 @@ TEST_CASE("publish subscribe loopback", "[Transport]")
     msg.data = "hello";
   }
 
+  SECTION("callbacks run in order under a light load")
+  {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> received;
+    std::vector<std::chrono::steady_clock::time_point> arrivals;
+
+    auto subscription = obs->observe().subscribe(
+      [&](const auto& msg)
+      {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(msg->data);
+        arrivals.push_back(now);
+        cv.notify_all();
+      });
+
+    int loop_count = 10;
+    while (transport->count_subscribers(topic_name) == 0 && loop_count > 0)
+    {
+      std::this_thread::sleep_for(100ms);
+      --loop_count;
+    }
+    REQUIRE(transport->count_subscribers(topic_name) == 1);
+
+    // Give the executor time to settle into waiting on its wait set
+    std::this_thread::sleep_for(200ms);
+
+    // Each message must arrive before the next one is sent. The timeout is
+    // generous so that a loaded machine does not make this test flaky.
+    std::vector<std::string> expected;
+    std::vector<std::chrono::steady_clock::time_point> sent;
+    for (std::size_t i = 0; i < 5; ++i)
+    {
+      std_msgs::msg::String msg;
+      msg.data = "hello " + std::to_string(i);
+      expected.push_back(msg.data);
+      sent.push_back(std::chrono::steady_clock::now());
+      publisher->publish(msg);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      REQUIRE(cv.wait_for(
+          lock, 5s, [&]() { return received.size() == expected.size(); }));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      CHECK(received == expected);
+
+      // The latency depends too much on the machine to be checked, so it is
+      // only reported to keep an eye on how long callbacks wait to run.
+      std::chrono::steady_clock::duration total{0};
+      std::chrono::steady_clock::duration worst{0};
+      for (std::size_t i = 0; i < sent.size(); ++i)
+      {
+        const auto latency = arrivals[i] - sent[i];
+        total += latency;
+        worst = std::max(worst, latency);
+      }
+
+      using us = std::chrono::microseconds;
+      WARN(
+        "Callback latency over " << sent.size() << " messages: mean "
+          << std::chrono::duration_cast<us>(
+            total / static_cast<int>(sent.size())).count()
+          << "us, max " << std::chrono::duration_cast<us>(worst).count()
+          << "us");
+    }
+
+    subscription.unsubscribe();
+  }
+
   SECTION("multiple subscriptions are multiplexed")
   {
     rxcpp::composite_subscription subscription{};
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_rxcpp/WorkerMonitor.hpp>
+
+#include <future>
+
+TEST_CASE("worker monitor", "[WorkerMonitor]")
+{
+  using namespace std::chrono_literals;
+  const auto monitor = std::make_shared<rmf_rxcpp::WorkerMonitor>(
+    "test_worker", 20ms);
+  const auto worker = monitor->wrap(
+    rxcpp::schedulers::make_event_loop().create_worker());
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> finished;
+
+  {
+    rmf_rxcpp::WorkerMonitor::Tag tag("blocking_item");
+    worker.schedule([released](const auto&)
+      {
+        released.wait();
+        std::this_thread::sleep_for(30ms);
+      });
+  }
+
+  worker.schedule([](const auto&) {});
+  worker.schedule([&finished](const auto&) { finished.set_value(); });
+
+  auto report = monitor->take_report();
+  CHECK(report.name == "test_worker");
+  CHECK(report.depth == 3);
+  CHECK(report.max_depth == 3);
+
+  release.set_value();
+  REQUIRE(finished.get_future().wait_for(5s) == std::future_status::ready);
+
+  // The last item counts as finished just after its callback returns
+  std::this_thread::sleep_for(50ms);
+  report = monitor->take_report();
+  CHECK(report.depth == 0);
+  CHECK(report.executed == 3);
+  CHECK(report.max_latency >= 30ms);
+  CHECK(report.max_run_time >= 30ms);
+  REQUIRE(report.long_items.size() == 1);
+  CHECK(report.long_items.front().tag == "blocking_item");
+
+  report = monitor->take_report();
+  CHECK(report.executed == 0);
+  CHECK(report.max_depth == 0);
+}
@@ -19,17 +19,40 @@
 
 #include <rmf_fleet_adapter/StandardNames.hpp>
 
+#include <rmf_traffic/Time.hpp>
+
 namespace rmf_fleet_adapter {
 namespace door_supervisor {
 
 const std::string DoorSupervisorRequesterID = "door_supervisor";
 
+namespace {
+//==============================================================================
+std::chrono::nanoseconds to_period(const double seconds)
+{
+  return rmf_traffic::time::from_seconds(std::max(0.0, seconds));
+}
+} // anonymous namespace
+
 //==============================================================================
 Node::Node()
 : rclcpp::Node("door_supervisor")
 {
   const auto default_qos = rclcpp::SystemDefaultsQoS();
 
+  _reminder_initial_period = to_period(
+    declare_parameter("reminder_initial_period", 1.0));
+  _reminder_max_period = std::max(
+    _reminder_initial_period,
+    to_period(declare_parameter("reminder_max_period", 30.0)));
+  const auto heartbeat_period = to_period(
+    declare_parameter("heartbeat_period", 5.0));
+  const auto platoon_window = to_period(
+    declare_parameter("platoon_window", 10.0));
+  _platoon_window = rclcpp::Duration(platoon_window);
+  _platoon_grace = rclcpp::Duration(
+    to_period(declare_parameter("platoon_grace", 10.0)));
+
   _door_request_pub = create_publisher<DoorRequest>(
     FinalDoorRequestTopicName, default_qos);
 
@@ -49,36 +72,85 @@ Node::Node()
 
   _door_heartbeat_pub = create_publisher<Heartbeat>(
     DoorSupervisorHeartbeatTopicName, default_qos);
+
+  // Heartbeats are published whenever the sessions change. This timer only
+  // refreshes them for anyone who missed the last change.
+  if (heartbeat_period > std::chrono::nanoseconds(0))
+  {
+    _heartbeat_timer = create_wall_timer(
+      heartbeat_period, [this]() { _publish_heartbeat(); });
+  }
+
+  // Doors are only held open for a following robot if there is a window to
+  // wait for one.
+  if (platoon_window > std::chrono::nanoseconds(0))
+  {
+    _upcoming_door_sessions_sub = create_subscription<Heartbeat>(
+      UpcomingDoorSessionsTopicName, default_qos,
+      [&](Heartbeat::UniquePtr msg)
+      {
+        _upcoming_door_sessions_update(std::move(msg));
+      });
+
+    _platoon_timer = create_wall_timer(
+      std::chrono::seconds(1), [this]() { _check_held_doors(); });
+  }
 }
 
 //==============================================================================
 void Node::_adapter_door_request_update(DoorRequest::UniquePtr msg)
 {
+  bool changed = false;
   if (DoorMode::MODE_OPEN == msg->requested_mode.value)
-    _process_open_request(msg->door_name, msg->requester_id, msg->request_time);
+  {
+    changed = _process_open_request(
+      msg->door_name, msg->requester_id, msg->request_time);
+  }
 
   if (DoorMode::MODE_CLOSED == msg->requested_mode.value)
-    _process_close_request(msg->door_name, msg->requester_id,
-      msg->request_time);
+  {
+    changed = _process_close_request(
+      msg->door_name, msg->requester_id, msg->request_time);
+  }
+
+  if (changed)
+  {
+    _heartbeat_outdated = true;
+    _publish_heartbeat();
+  }
 }
 
 //==============================================================================
-void Node::_process_open_request(
+bool Node::_process_open_request(
   const std::string& door_name,
   const std::string& requester_id,
   const builtin_interfaces::msg::Time& time)
 {
+  // The robot has arrived, so it is no longer expected at this door
+  const auto upcoming_it = _upcoming.find(door_name);
+  if (upcoming_it != _upcoming.end())
+    upcoming_it->second.erase(requester_id);
+
+  // A door that was being held open for this robot is already open
+  _held.erase(door_name);
+
   auto& open_requests = _log[door_name];
   auto insertion = open_requests.insert(std::make_pair(requester_id, time));
+  bool changed = insertion.second;
   if (!insertion.second)
   {
     // Use the latest time in the log
     auto& logged_request_time = insertion.first->second;
-    logged_request_time = std::max(logged_request_time, rclcpp::Time(time));
+    const auto new_request_time = rclcpp::Time(time);
+    if (logged_request_time < new_request_time)
+    {
+      logged_request_time = new_request_time;
+      changed = true;
+    }
   }
 
   _send_open_request(door_name);
-  _publish_heartbeat();
+  return changed;
 }
 
 //==============================================================================
@@ -90,39 +162,114 @@ void Node::_send_open_request(const std::string& door_name)
   request.requester_id = DoorSupervisorRequesterID;
   request.requested_mode.value = DoorMode::MODE_OPEN;
   _door_request_pub->publish(request);
+  _reset_reminder(door_name, DoorMode::MODE_OPEN);
 }
 
 //==============================================================================
-void Node::_process_close_request(
+bool Node::_process_close_request(
   const std::string& door_name,
   const std::string& requester_id,
   const builtin_interfaces::msg::Time& time)
 {
   auto door_it = _log.find(door_name);
   if (door_it == _log.end())
-    return _publish_heartbeat();
+    return false;
 
   auto& door_log = door_it->second;
   auto request_it = door_log.find(requester_id);
   if (request_it == door_log.end())
-    return _publish_heartbeat();
+    return false;
 
   auto& logged_request_time = request_it->second;
   const auto new_request_time = rclcpp::Time(time);
   if (new_request_time < logged_request_time)
-    return _publish_heartbeat();
+    return false;
 
   // We can remove this requester from the log of open requests
   door_log.erase(request_it);
 
   if (!door_log.empty())
-    return _publish_heartbeat();
+    return true;
+
+  // If another robot is about to pass through this door, keep it open until
+  // that robot arrives or stops being expected.
+  if (_expecting(door_name))
+  {
+    _held.insert(door_name);
+    return true;
+  }
 
   // If all the open requests have been erased for this door, then we can
   // safely close it.
   // TODO(MXG): Consider whether the door_it should be erased from _log
   _send_close_request(door_name);
-  _publish_heartbeat();
+  return true;
+}
+
+//==============================================================================
+void Node::_upcoming_door_sessions_update(Heartbeat::UniquePtr msg)
+{
+  for (const auto& door : msg->all_sessions)
+  {
+    auto& upcoming = _upcoming[door.door_name];
+    for (const auto& session : door.sessions)
+      upcoming.insert_or_assign(session.requester_id, session.request_time);
+  }
+}
+
+//==============================================================================
+bool Node::_expecting(const std::string& door_name)
+{
+  const auto door_it = _upcoming.find(door_name);
+  if (door_it == _upcoming.end())
+    return false;
+
+  const auto now = get_clock()->now();
+  bool expecting = false;
+  auto& upcoming = door_it->second;
+  for (auto it = upcoming.begin(); it != upcoming.end(); )
+  {
+    if (it->second + _platoon_grace < now)
+    {
+      it = upcoming.erase(it);
+      continue;
+    }
+
+    if (it->second <= now + _platoon_window)
+      expecting = true;
+
+    ++it;
+  }
+
+  if (upcoming.empty())
+    _upcoming.erase(door_it);
+
+  return expecting;
+}
+
+//==============================================================================
+void Node::_check_held_doors()
+{
+  for (auto it = _held.begin(); it != _held.end(); )
+  {
+    const auto& door_name = *it;
+    const auto log_it = _log.find(door_name);
+    if (log_it != _log.end() && !log_it->second.empty())
+    {
+      // Someone has requested the door again, so it is no longer being held
+      it = _held.erase(it);
+      continue;
+    }
+
+    if (_expecting(door_name))
+    {
+      ++it;
+      continue;
+    }
+
+    _send_close_request(door_name);
+    it = _held.erase(it);
+  }
 }
 
 //==============================================================================
@@ -134,6 +281,7 @@ void Node::_send_close_request(const std::string& door_name)
   request.requester_id = DoorSupervisorRequesterID;
   request.requested_mode.value = DoorMode::MODE_CLOSED;
   _door_request_pub->publish(request);
+  _reset_reminder(door_name, DoorMode::MODE_CLOSED);
 }
 
 //==============================================================================
@@ -145,13 +293,14 @@ void Node::_door_state_update(DoorState::UniquePtr msg)
   // TODO(MXG): Instead of MOVE_MOVING, we may want to consider having a
   // MODE_OPENING and MODE_CLOSING to be more precise about what the door is
   // doing.
-  if (door_it == _log.end() || door_it->second.empty())
+  const bool held = _held.count(door_name) > 0;
+  if (!held && (door_it == _log.end() || door_it->second.empty()))
   {
     if (DoorMode::MODE_OPEN == msg->current_mode.value
       || DoorMode::MODE_MOVING == msg->current_mode.value)
     {
       // If the door is not closed but it's supposed to be, then send a reminder
-      _send_close_request(door_name);
+      return _remind(door_name, DoorMode::MODE_CLOSED);
     }
   }
   else
@@ -160,31 +309,75 @@ void Node::_door_state_update(DoorState::UniquePtr msg)
       || DoorMode::MODE_MOVING == msg->current_mode.value)
     {
       // If the door is not open but it's supposed to be, then send a reminder
-      _send_open_request(door_name);
+      return _remind(door_name, DoorMode::MODE_OPEN);
     }
   }
+
+  // The door is where it should be, so the next reminder can be sent right
+  // away if it ever drifts.
+  _reminders.erase(door_name);
+}
+
+//==============================================================================
+void Node::_reset_reminder(const std::string& door_name, const uint32_t mode)
+{
+  _reminders.insert_or_assign(
+    door_name, Reminder{mode, get_clock()->now(), _reminder_initial_period});
+}
+
+//==============================================================================
+void Node::_remind(const std::string& door_name, const uint32_t mode)
+{
+  const auto now = get_clock()->now();
+  const auto it = _reminders.find(door_name);
+  if (it != _reminders.end() && it->second.mode == mode)
+  {
+    auto& reminder = it->second;
+    if (now - reminder.last_sent < rclcpp::Duration(reminder.period))
+      return;
+
+    // Back off for as long as the door ignores the reminders
+    const auto period = std::min(2*reminder.period, _reminder_max_period);
+    if (DoorMode::MODE_OPEN == mode)
+      _send_open_request(door_name);
+    else
+      _send_close_request(door_name);
+
+    it->second.period = period;
+    return;
+  }
+
+  if (DoorMode::MODE_OPEN == mode)
+    _send_open_request(door_name);
+  else
+    _send_close_request(door_name);
 }
 
 //==============================================================================
 void Node::_publish_heartbeat()
 {
-  rmf_door_msgs::msg::SupervisorHeartbeat msg;
-  for (const auto& door : _log)
+  if (_heartbeat_outdated)
   {
-    rmf_door_msgs::msg::DoorSessions sessions;
-    sessions.door_name = door.first;
-    for (const auto& session : door.second)
+    _heartbeat.all_sessions.clear();
+    for (const auto& door : _log)
     {
-      rmf_door_msgs::msg::Session s;
-      s.request_time = session.second;
-      s.requester_id = session.first;
-      sessions.sessions.emplace_back(std::move(s));
+      rmf_door_msgs::msg::DoorSessions sessions;
+      sessions.door_name = door.first;
+      for (const auto& session : door.second)
+      {
+        rmf_door_msgs::msg::Session s;
+        s.request_time = session.second;
+        s.requester_id = session.first;
+        sessions.sessions.emplace_back(std::move(s));
+      }
+
+      _heartbeat.all_sessions.emplace_back(std::move(sessions));
     }
 
-    msg.all_sessions.emplace_back(std::move(sessions));
+    _heartbeat_outdated = false;
   }
 
-  _door_heartbeat_pub->publish(msg);
+  _door_heartbeat_pub->publish(_heartbeat);
 }
 
 } // namespace door_supervisor
@@ -22,8 +22,10 @@
 #include <rmf_door_msgs/msg/door_request.hpp>
 #include <rmf_door_msgs/msg/supervisor_heartbeat.hpp>
 
+#include <chrono>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace rmf_fleet_adapter {
 namespace door_supervisor {
@@ -47,14 +49,14 @@ private:
   DoorRequestSub::SharedPtr _adapter_door_request_sub;
   void _adapter_door_request_update(DoorRequest::UniquePtr msg);
 
-  void _process_open_request(
+  bool _process_open_request(
     const std::string& door_name,
     const std::string& requester_id,
     const builtin_interfaces::msg::Time& time);
 
   void _send_open_request(const std::string& door_name);
 
-  void _process_close_request(
+  bool _process_close_request(
     const std::string& door_name,
     const std::string& requester_id,
     const builtin_interfaces::msg::Time& time);
@@ -66,9 +68,33 @@ private:
   DoorStateSub::SharedPtr _door_state_sub;
   void _door_state_update(DoorState::UniquePtr msg);
 
+  // Reminders that are sent to a door which is not in the mode that it should
+  // be in. Each door waits longer between reminders for as long as it stays in
+  // the wrong mode, so a stuck door does not flood the door request topic.
+  struct Reminder
+  {
+    uint32_t mode;
+    rclcpp::Time last_sent;
+    std::chrono::nanoseconds period;
+  };
+  std::unordered_map<std::string, Reminder> _reminders;
+  std::chrono::nanoseconds _reminder_initial_period;
+  std::chrono::nanoseconds _reminder_max_period;
+
+  // Note that a request was just sent to a door, so a reminder is not needed
+  // until the initial reminder period has passed.
+  void _reset_reminder(const std::string& door_name, uint32_t mode);
+
+  void _remind(const std::string& door_name, uint32_t mode);
+
   using Heartbeat = rmf_door_msgs::msg::SupervisorHeartbeat;
   using HeartbeatPub = rclcpp::Publisher<Heartbeat>;
   HeartbeatPub::SharedPtr _door_heartbeat_pub;
+  rclcpp::TimerBase::SharedPtr _heartbeat_timer;
+
+  // The heartbeat is only rebuilt after the sessions have changed
+  Heartbeat _heartbeat;
+  bool _heartbeat_outdated = false;
   void _publish_heartbeat();
 
   using OpenRequestLog =
@@ -76,6 +102,25 @@ private:
     std::string,
     std::unordered_map<std::string, rclcpp::Time>>;
   OpenRequestLog _log;
+
+  // The times that robots expect to reach each door, as announced by their
+  // fleet adapters. When the last robot leaves a door while another robot is
+  // expected within the platoon window, the door is held open for it instead
+  // of being closed and then opened again.
+  using HeartbeatSub = rclcpp::Subscription<Heartbeat>;
+  HeartbeatSub::SharedPtr _upcoming_door_sessions_sub;
+  void _upcoming_door_sessions_update(Heartbeat::UniquePtr msg);
+
+  OpenRequestLog _upcoming;
+  std::unordered_set<std::string> _held;
+  rclcpp::Duration _platoon_window = rclcpp::Duration(0, 0);
+  rclcpp::Duration _platoon_grace = rclcpp::Duration(0, 0);
+  rclcpp::TimerBase::SharedPtr _platoon_timer;
+
+  // Whether a robot is expected to reach this door soon. Announcements that
+  // are older than the platoon grace get forgotten.
+  bool _expecting(const std::string& door_name);
+  void _check_held_doors();
 };
 
 } // namespace door_supervisor
@@ -0,0 +1,724 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark measures how many robots a single fleet adapter process
+/// can handle. It uses agv::test::MockAdapter to run one fleet of simulated
+/// robots on a generated grid graph, feeds the fleet a steady stream of patrol
+/// tasks, and moves each robot along its paths in time with the waypoints it
+/// was given. At the end it reports:
+///  - startup: from adding the robots until every robot has an update handle,
+///    and until the first fleet state that lists every robot
+///  - bid latency: from dispatching a task until the fleet has bid on it
+///  - plan latency: from a robot starting a task until it receives a path
+///  - replans: paths received for a task after its first one
+///  - worker lag: how long a job waits on the worker that the fleet shares
+///  - CPU and resident memory of the process, also divided by the robots
+///  - heap allocations per second, which is dominated by the task state
+///    updates that each robot publishes while it is working on a task
+///  - footprint: the approximate bytes that each component holds per robot
+///    and per fleet, as reported by the memory report service of the adapter
+///
+/// Set footprint_file to append the footprint per robot to a CSV file, one
+/// row of footprint_label,robots,component,bytes for each component, so that
+/// it can be compared across releases.
+///
+/// The MockAdapter does not take part in traffic negotiations, so traffic
+/// conflicts between the robots show up in this report as replans.
+///
+/// Usage:
+///   ros2 run rmf_fleet_adapter fleet_adapter_benchmark --ros-args
+///     -p robots:=20 -p grid_size:=0 -p spacing:=5.0 -p task_rate:=1.0
+///     -p duration:=60 -p footprint_file:=footprint.csv
+///     -p footprint_label:=main
+
+#include <rmf_fleet_adapter/agv/test/MockAdapter.hpp>
+#include <rmf_fleet_adapter/agv/RobotCommandHandle.hpp>
+#include <rmf_fleet_adapter/agv/RobotUpdateHandle.hpp>
+#include <rmf_fleet_adapter/StandardNames.hpp>
+
+#include <rmf_fleet_msgs/msg/fleet_state.hpp>
+
+#include <diagnostic_msgs/srv/self_test.hpp>
+
+#include <rmf_battery/agv/BatterySystem.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include <rmf_traffic_ros2/Time.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using rmf_fleet_adapter::agv::RobotCommandHandle;
+using rmf_fleet_adapter::agv::RobotUpdateHandle;
+using SteadyClock = std::chrono::steady_clock;
+
+namespace {
+std::atomic_size_t allocations{0};
+} // anonymous namespace
+
+//==============================================================================
+// Count every heap allocation that the process makes
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+//==============================================================================
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+//==============================================================================
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace {
+const std::string MapName = "benchmark_map";
+
+//==============================================================================
+double percentile(std::vector<double> samples, const double q)
+{
+  if (samples.empty())
+    return 0.0;
+
+  std::sort(samples.begin(), samples.end());
+  const auto i = static_cast<std::size_t>(q * samples.size());
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+//==============================================================================
+double ms_since(const SteadyClock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(
+    SteadyClock::now() - start).count();
+}
+
+//==============================================================================
+/// Seconds of CPU time used by this process so far
+double cpu_seconds()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  const auto seconds = [](const timeval& t)
+    {
+      return static_cast<double>(t.tv_sec) + 1e-6 * t.tv_usec;
+    };
+
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+//==============================================================================
+/// Resident memory of this process in MiB
+double resident_mib()
+{
+  std::ifstream statm("/proc/self/statm");
+  std::size_t size = 0;
+  std::size_t resident = 0;
+  statm >> size >> resident;
+  return static_cast<double>(resident * sysconf(_SC_PAGESIZE)) / (1 << 20);
+}
+
+//==============================================================================
+/// The footprint that the memory report service of the adapter gave
+struct Footprint
+{
+  /// The mean bytes of each component of the robots
+  std::map<std::string, double> per_robot;
+
+  /// The bytes of each component of the fleet and the schedule mirror
+  std::map<std::string, std::size_t> shared;
+};
+
+//==============================================================================
+std::optional<Footprint> request_footprint(
+  const std::shared_ptr<rclcpp::Node>& node,
+  const std::string& fleet_name)
+{
+  using SelfTest = diagnostic_msgs::srv::SelfTest;
+  const auto client = node->create_client<SelfTest>(
+    rmf_fleet_adapter::MemoryReportServiceName);
+  if (!client->wait_for_service(std::chrono::seconds(5)))
+    return std::nullopt;
+
+  auto future = client->async_send_request(
+    std::make_shared<SelfTest::Request>());
+  if (rclcpp::spin_until_future_complete(
+      node, future, std::chrono::seconds(5)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+    return std::nullopt;
+
+  const auto ends_with = [](const std::string& s, const std::string& suffix)
+    {
+      return s.size() >= suffix.size()
+        && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+  Footprint footprint;
+  std::size_t robots = 0;
+  const std::string fleet_suffix = "/memory/" + fleet_name;
+  for (const auto& status : future.get()->status)
+  {
+    const bool is_robot =
+      status.name.find(fleet_suffix + "/") != std::string::npos;
+    const bool is_shared = ends_with(status.name, fleet_suffix)
+      || ends_with(status.name, "/memory/schedule_mirror");
+    if (!is_robot && !is_shared)
+      continue;
+
+    if (is_robot && !status.values.empty())
+      ++robots;
+
+    const auto prefix = ends_with(status.name, fleet_suffix) ?
+      "fleet." : "mirror.";
+    for (const auto& kv : status.values)
+    {
+      const auto bytes = std::stoull(kv.value);
+      if (is_robot)
+        footprint.per_robot[kv.key] += static_cast<double>(bytes);
+      else
+        footprint.shared[prefix + kv.key] = bytes;
+    }
+  }
+
+  for (auto& [_, bytes] : footprint.per_robot)
+    bytes /= static_cast<double>(std::max<std::size_t>(robots, 1));
+
+  return footprint;
+}
+
+//==============================================================================
+/// The samples that the benchmark collects. These are written from the worker
+/// of the adapter and from the executor of its node.
+struct Metrics
+{
+  std::mutex mutex;
+  std::vector<double> bid_latency;
+  std::vector<double> plan_latency;
+  std::vector<double> worker_lag;
+  std::size_t awarded = 0;
+  std::size_t rejected = 0;
+  std::size_t completed = 0;
+  std::size_t replans = 0;
+
+  void add(std::vector<double>& samples, const double value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    samples.push_back(value);
+  }
+
+  void count(std::size_t& counter)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counter;
+  }
+};
+
+//==============================================================================
+/// A robot that arrives at each waypoint of its path at the time that the
+/// waypoint asks for
+class SimulatedRobot : public RobotCommandHandle
+{
+public:
+
+  SimulatedRobot(Metrics& metrics)
+  : _metrics(metrics)
+  {
+    // Do nothing
+  }
+
+  std::shared_ptr<RobotUpdateHandle> updater;
+
+  void follow_new_path(
+    const std::vector<rmf_traffic::agv::Plan::Waypoint>& waypoints,
+    ArrivalEstimator next_arrival_estimator,
+    RequestCompleted path_finished_callback) final
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_task_start.has_value())
+    {
+      _metrics.add(_metrics.plan_latency, ms_since(*_task_start));
+      _task_start = std::nullopt;
+    }
+    else if (!_goals.empty())
+    {
+      _metrics.count(_metrics.replans);
+    }
+
+    _path = waypoints;
+    _next = 0;
+    _estimator = std::move(next_arrival_estimator);
+    _finished = std::move(path_finished_callback);
+  }
+
+  void stop() final
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _path.clear();
+    _finished = nullptr;
+  }
+
+  void dock(const std::string&, RequestCompleted docking_finished) final
+  {
+    docking_finished();
+  }
+
+  /// Tell the robot that it has won a task that ends at this waypoint
+  void award(const std::size_t goal)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_goals.empty())
+      _task_start = SteadyClock::now();
+
+    _goals.push_back(goal);
+  }
+
+  /// Move the robot up to the current time
+  void step(const rmf_traffic::Time now)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_path.empty() || !updater)
+      return;
+
+    std::optional<rmf_traffic::agv::Plan::Waypoint> reached;
+    while (_next < _path.size() && _path[_next].time() <= now)
+      reached = _path[_next++];
+
+    if (!reached.has_value())
+      return;
+
+    RequestCompleted finished;
+    ArrivalEstimator estimator;
+    if (_next < _path.size())
+    {
+      estimator = _estimator;
+    }
+    else
+    {
+      finished = std::move(_finished);
+      _path.clear();
+      _finish_goal(reached->graph_index());
+    }
+
+    const auto next_time = estimator ? _path[_next].time() - now :
+      rmf_traffic::Duration(0);
+    const auto next_index = _next;
+    lock.unlock();
+
+    if (reached->graph_index().has_value())
+      updater->update_position(*reached->graph_index(), reached->position()[2]);
+    else
+      updater->update_position(MapName, reached->position());
+
+    if (estimator)
+      estimator(next_index, next_time);
+
+    if (finished)
+      finished();
+  }
+
+private:
+
+  void _finish_goal(const std::optional<std::size_t> wp)
+  {
+    if (_goals.empty() || wp != _goals.front())
+      return;
+
+    _goals.pop_front();
+    _metrics.count(_metrics.completed);
+    if (!_goals.empty())
+      _task_start = SteadyClock::now();
+  }
+
+  Metrics& _metrics;
+  std::mutex _mutex;
+  std::vector<rmf_traffic::agv::Plan::Waypoint> _path;
+  std::size_t _next = 0;
+  ArrivalEstimator _estimator;
+  RequestCompleted _finished;
+  std::deque<std::size_t> _goals;
+  std::optional<SteadyClock::time_point> _task_start;
+};
+
+//==============================================================================
+rmf_traffic::agv::Graph make_grid(
+  const std::size_t grid_size,
+  const double spacing)
+{
+  rmf_traffic::agv::Graph graph;
+  for (std::size_t i = 0; i < grid_size; ++i)
+  {
+    for (std::size_t j = 0; j < grid_size; ++j)
+    {
+      const auto wp = graph.add_waypoint(
+        MapName, {spacing * static_cast<double>(i),
+          spacing * static_cast<double>(j)}).index();
+      graph.add_key("wp_" + std::to_string(wp), wp);
+    }
+  }
+
+  const auto index = [grid_size](std::size_t i, std::size_t j)
+    {
+      return i * grid_size + j;
+    };
+
+  for (std::size_t i = 0; i < grid_size; ++i)
+  {
+    for (std::size_t j = 0; j < grid_size; ++j)
+    {
+      if (i + 1 < grid_size)
+      {
+        graph.add_lane(index(i, j), index(i + 1, j));
+        graph.add_lane(index(i + 1, j), index(i, j));
+      }
+
+      if (j + 1 < grid_size)
+      {
+        graph.add_lane(index(i, j), index(i, j + 1));
+        graph.add_lane(index(i, j + 1), index(i, j));
+      }
+    }
+  }
+
+  return graph;
+}
+
+//==============================================================================
+void configure_task_planner(rmf_fleet_adapter::agv::FleetUpdateHandle& fleet)
+{
+  using namespace rmf_battery::agv;
+  auto battery_system = std::make_shared<BatterySystem>(
+    *BatterySystem::make(24.0, 40.0, 8.8));
+
+  auto mechanical_system = MechanicalSystem::make(70.0, 40.0, 0.22);
+  auto motion_sink = std::make_shared<SimpleMotionPowerSink>(
+    *battery_system, *mechanical_system);
+
+  auto ambient_power_system = PowerSystem::make(20.0);
+  auto ambient_sink = std::make_shared<SimpleDevicePowerSink>(
+    *battery_system, *ambient_power_system);
+
+  auto tool_power_system = PowerSystem::make(10.0);
+  auto tool_sink = std::make_shared<SimpleDevicePowerSink>(
+    *battery_system, *tool_power_system);
+
+  fleet.set_task_planner_params(
+    battery_system, motion_sink, ambient_sink, tool_sink, 0.2, 1.0, false);
+
+  fleet.consider_patrol_requests(
+    [](const nlohmann::json&,
+    rmf_fleet_adapter::agv::FleetUpdateHandle::Confirmation& confirm)
+    {
+      confirm.accept();
+    });
+}
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto settings = std::make_shared<rclcpp::Node>("fleet_adapter_benchmark");
+  const auto robots = static_cast<std::size_t>(
+    std::max<int64_t>(1, settings->declare_parameter("robots", 20)));
+  const double spacing = settings->declare_parameter("spacing", 5.0);
+  const double task_rate = settings->declare_parameter("task_rate", 1.0);
+  const auto duration = std::chrono::seconds(
+    std::max<int64_t>(1, settings->declare_parameter("duration", 60)));
+  const auto footprint_file =
+    settings->declare_parameter<std::string>("footprint_file", "");
+  const auto footprint_label =
+    settings->declare_parameter<std::string>("footprint_label", "");
+
+  // Leave at least one free waypoint next to every robot unless a bigger grid
+  // was asked for
+  const auto min_grid_size = static_cast<std::size_t>(
+    std::ceil(std::sqrt(2.0 * static_cast<double>(robots))));
+  const auto grid_size = std::max<std::size_t>(
+    min_grid_size,
+    static_cast<std::size_t>(
+      std::max<int64_t>(0, settings->declare_parameter("grid_size", 0))));
+  const std::size_t num_waypoints = grid_size * grid_size;
+
+  // Spread the robots out over the grid and give each one a charger
+  auto graph = make_grid(grid_size, spacing);
+  std::vector<std::size_t> start_wps;
+  for (std::size_t i = 0; i < robots; ++i)
+  {
+    const auto wp = i * num_waypoints / robots;
+    graph.get_waypoint(wp).set_charger(true);
+    start_wps.push_back(wp);
+  }
+
+  const rmf_traffic::Profile profile{
+    rmf_traffic::geometry::make_final_convex<
+      rmf_traffic::geometry::Circle>(0.5)
+  };
+
+  const rmf_traffic::agv::VehicleTraits traits{
+    {0.7, 0.3},
+    {1.0, 0.45},
+    profile
+  };
+
+  // These are declared ahead of the adapter so that they outlive its worker
+  Metrics metrics;
+  std::unordered_map<std::string, std::shared_ptr<SimulatedRobot>> sims;
+  std::vector<std::shared_ptr<SimulatedRobot>> sim_list;
+  std::mutex ready_mutex;
+  std::size_t ready = 0;
+  double ready_ms = 0.0;
+  std::optional<double> first_fleet_state_ms;
+
+  const auto baseline_mib = resident_mib();
+
+  const auto adapter = std::make_shared<
+    rmf_fleet_adapter::agv::test::MockAdapter>("fleet_adapter_benchmark");
+  const auto fleet = adapter->add_fleet("benchmark_fleet", traits, graph);
+  configure_task_planner(*fleet);
+
+  const auto startup_begin = SteadyClock::now();
+  const auto fleet_state_sub = adapter->node()->create_subscription<
+    rmf_fleet_msgs::msg::FleetState>(
+    rmf_fleet_adapter::FleetStateTopicName, rclcpp::QoS(10).best_effort(),
+    [robots, startup_begin, &ready_mutex, &first_fleet_state_ms](
+      const rmf_fleet_msgs::msg::FleetState& msg)
+    {
+      std::lock_guard<std::mutex> lock(ready_mutex);
+      if (!first_fleet_state_ms.has_value() && msg.robots.size() >= robots)
+        first_fleet_state_ms = ms_since(startup_begin);
+    });
+
+  const auto now = rmf_traffic_ros2::convert(adapter->node()->now());
+  for (std::size_t i = 0; i < robots; ++i)
+  {
+    const auto name = "robot_" + std::to_string(i);
+    const auto sim = std::make_shared<SimulatedRobot>(metrics);
+    sims[name] = sim;
+    sim_list.push_back(sim);
+    fleet->add_robot(
+      sim, name, profile, {{now, start_wps[i], 0.0}},
+      [sim, robots, startup_begin, &ready_mutex, &ready, &ready_ms](
+        std::shared_ptr<RobotUpdateHandle> updater)
+      {
+        updater->update_battery_soc(1.0);
+        sim->updater = std::move(updater);
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        if (++ready == robots)
+          ready_ms = ms_since(startup_begin);
+      });
+  }
+
+  const auto sim_timer = adapter->node()->create_wall_timer(
+    std::chrono::milliseconds(20),
+    [node = adapter->node(), &sim_list]()
+    {
+      const auto now = rmf_traffic_ros2::convert(node->now());
+      for (const auto& sim : sim_list)
+        sim->step(now);
+    });
+
+  adapter->start();
+
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> lock(ready_mutex);
+      if (ready == robots)
+        break;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  const auto robots_mib = resident_mib();
+  const double cpu_start = cpu_seconds();
+  const std::size_t allocations_start = allocations.load();
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<std::size_t> pick_wp(0, num_waypoints - 1);
+  std::size_t dispatched = 0;
+  SteadyClock::time_point last_probe;
+  const auto start = SteadyClock::now();
+  while (SteadyClock::now() - start < duration)
+  {
+    const double elapsed = std::chrono::duration<double>(
+      SteadyClock::now() - start).count();
+    const auto due = static_cast<std::size_t>(elapsed * task_rate);
+    for (; dispatched < due; ++dispatched)
+    {
+      const auto goal = pick_wp(rng);
+      nlohmann::json request;
+      request["category"] = "patrol";
+      request["description"]["places"] = {"wp_" + std::to_string(goal)};
+      request["description"]["rounds"] = 1;
+
+      const auto sent = SteadyClock::now();
+      adapter->dispatch_task(
+        "benchmark_task_" + std::to_string(dispatched), request,
+        [&metrics, &sims, sent, goal](std::optional<std::string> robot)
+        {
+          metrics.add(metrics.bid_latency, ms_since(sent));
+          if (!robot.has_value())
+          {
+            metrics.count(metrics.rejected);
+            return;
+          }
+
+          metrics.count(metrics.awarded);
+          const auto it = sims.find(*robot);
+          if (it != sims.end())
+            it->second->award(goal);
+        });
+    }
+
+    if (SteadyClock::now() - last_probe > std::chrono::milliseconds(100))
+    {
+      last_probe = SteadyClock::now();
+      adapter->schedule(
+        [&metrics, sent = last_probe]()
+        {
+          metrics.add(metrics.worker_lag, ms_since(sent));
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  const double seconds = std::chrono::duration<double>(
+    SteadyClock::now() - start).count();
+  const double cpu = cpu_seconds() - cpu_start;
+  const double run_mib = resident_mib();
+  const auto allocated =
+    static_cast<double>(allocations.load() - allocations_start);
+
+  // The robots are measured while the adapter is still running, since they
+  // get measured on their workers
+  const auto footprint = request_footprint(settings, "benchmark_fleet");
+
+  sim_timer->cancel();
+  adapter->stop();
+
+  std::lock_guard<std::mutex> lock(metrics.mutex);
+  const double n = static_cast<double>(robots);
+  std::printf(
+    "Fleet adapter with %lu robots on a %lux%lu grid for %.1f s\n",
+    robots, grid_size, grid_size, seconds);
+  std::printf(
+    "  tasks: %lu dispatched | %lu awarded | %lu rejected | %lu completed\n",
+    dispatched, metrics.awarded, metrics.rejected, metrics.completed);
+
+  const auto report = [](const char* label, const std::vector<double>& s)
+    {
+      std::printf(
+        "  %s (ms): p50 %.3f | p90 %.3f | p99 %.3f | max %.3f | n %lu\n",
+        label, percentile(s, 0.5), percentile(s, 0.9), percentile(s, 0.99),
+        s.empty() ? 0.0 : *std::max_element(s.begin(), s.end()), s.size());
+    };
+
+  {
+    std::lock_guard<std::mutex> ready_lock(ready_mutex);
+    std::printf(
+      "  startup (ms): %.1f until every robot has a handle | ",
+      ready_ms);
+    if (first_fleet_state_ms.has_value())
+      std::printf("%.1f until a fleet state lists them all\n",
+        *first_fleet_state_ms);
+    else
+      std::printf("no fleet state listed them all\n");
+  }
+
+  report("bid latency", metrics.bid_latency);
+  report("plan latency", metrics.plan_latency);
+  report("worker lag", metrics.worker_lag);
+  std::printf(
+    "  replans: %lu | %.2f per robot per minute\n",
+    metrics.replans, 60.0 * metrics.replans / (n * seconds));
+  std::printf(
+    "  cpu: %.1f%% of one core | %.3f%% per robot\n",
+    100.0 * cpu / seconds, 100.0 * cpu / (seconds * n));
+  std::printf(
+    "  memory (MiB): %.1f resident | %.3f per robot when added | "
+    "%.3f per robot after running\n",
+    run_mib, (robots_mib - baseline_mib) / n, (run_mib - baseline_mib) / n);
+  std::printf(
+    "  heap allocations: %.0f per second | %.1f per robot per second\n",
+    allocated / seconds, allocated / (seconds * n));
+
+  if (footprint.has_value())
+  {
+    std::printf("  footprint per robot (bytes):");
+    for (const auto& [component, bytes] : footprint->per_robot)
+      std::printf(" %s %.0f |", component.c_str(), bytes);
+
+    std::printf("\n  footprint shared (bytes):");
+    for (const auto& [component, bytes] : footprint->shared)
+      std::printf(" %s %lu |", component.c_str(), bytes);
+
+    std::printf("\n");
+
+    if (!footprint_file.empty())
+    {
+      std::ofstream csv(footprint_file, std::ios::app);
+      for (const auto& [component, bytes] : footprint->per_robot)
+      {
+        csv << footprint_label << "," << robots << "," << component << ","
+            << static_cast<std::size_t>(bytes) << "\n";
+      }
+
+      csv << footprint_label << "," << robots << ",resident,"
+          << static_cast<std::size_t>(
+        (run_mib - baseline_mib) * (1 << 20) / n) << "\n";
+    }
+  }
+  else
+  {
+    std::printf("  footprint: the memory report service did not respond\n");
+  }
+
+  rclcpp::shutdown();
+  return 0;
+}
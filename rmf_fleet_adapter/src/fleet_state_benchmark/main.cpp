@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark measures how quickly robot states make it through the
+/// robot state aggregator to a fleet adapter. It publishes synthetic robot
+/// states and subscribes to the fleet states the same way full_control does,
+/// then reports the throughput and the latency from each robot state being
+/// published until it arrives inside a fleet state.
+///
+/// With composed:=true the aggregator is loaded into this process, and every
+/// node uses intra-process communication, which is how the aggregator is
+/// deployed by robot_state_aggregator.composition.launch.xml. With
+/// composed:=false an aggregator must already be running in a separate
+/// process with fleet_name:=benchmark_fleet.
+///
+/// Usage:
+///   ros2 run rmf_fleet_adapter fleet_state_benchmark --ros-args
+///     -p composed:=true -p robots:=50 -p rate:=10.0 -p duration:=10
+///     -p publish_period:=0 -p publish_updated_only:=false
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_components/node_factory.hpp>
+
+#include <class_loader/class_loader.hpp>
+
+#include <rmf_fleet_msgs/msg/fleet_state.hpp>
+#include <rmf_fleet_msgs/msg/robot_state.hpp>
+
+#include <rmf_fleet_adapter/StandardNames.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using RobotState = rmf_fleet_msgs::msg::RobotState;
+using FleetState = rmf_fleet_msgs::msg::FleetState;
+
+namespace {
+const std::string FleetName = "benchmark_fleet";
+
+//==============================================================================
+double percentile(std::vector<double>& samples, const double q)
+{
+  if (samples.empty())
+    return 0.0;
+
+  std::sort(samples.begin(), samples.end());
+  const auto i = static_cast<std::size_t>(q * samples.size());
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+//==============================================================================
+/// Load the aggregator component that is linked into this executable
+rclcpp_components::NodeInstanceWrapper load_aggregator(
+  class_loader::ClassLoader& loader,
+  const rclcpp::NodeOptions& options)
+{
+  for (const auto& name :
+    loader.getAvailableClasses<rclcpp_components::NodeFactory>())
+  {
+    if (name.find("RobotStateAggregator") == std::string::npos)
+      continue;
+
+    const auto factory =
+      loader.createInstance<rclcpp_components::NodeFactory>(name);
+    return factory->create_node_instance(options);
+  }
+
+  throw std::runtime_error("The RobotStateAggregator component is missing");
+}
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto settings = std::make_shared<rclcpp::Node>("fleet_state_benchmark");
+  const bool composed = settings->declare_parameter("composed", true);
+  const auto robots = static_cast<std::size_t>(
+    std::max<int64_t>(1, settings->declare_parameter("robots", 50)));
+  const double rate = settings->declare_parameter("rate", 10.0);
+  const auto duration = std::chrono::seconds(
+    std::max<int64_t>(1, settings->declare_parameter("duration", 10)));
+  const int64_t publish_period = settings->declare_parameter(
+    "publish_period", 0);
+  const bool publish_updated_only = settings->declare_parameter(
+    "publish_updated_only", false);
+
+  const auto options = rclcpp::NodeOptions()
+    .use_intra_process_comms(composed);
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  auto source = std::make_shared<rclcpp::Node>(
+    "fleet_state_benchmark_source", options);
+  auto sink = std::make_shared<rclcpp::Node>(
+    "fleet_state_benchmark_sink", options);
+  executor.add_node(source);
+  executor.add_node(sink);
+
+  std::unique_ptr<class_loader::ClassLoader> loader;
+  std::optional<rclcpp_components::NodeInstanceWrapper> aggregator;
+  if (composed)
+  {
+    loader = std::make_unique<class_loader::ClassLoader>("");
+    aggregator = load_aggregator(
+      *loader,
+      rclcpp::NodeOptions(options).parameter_overrides(
+        {
+          {"fleet_name", FleetName},
+          {"publish_period", publish_period},
+          {"publish_updated_only", publish_updated_only}
+        }));
+    executor.add_node(aggregator->get_node_base_interface());
+  }
+
+  const auto robot_state_pub = source->create_publisher<RobotState>(
+    "/robot_state",
+    rclcpp::SystemDefaultsQoS().keep_last(100).durability_volatile());
+
+  // Only the robot states that are newer than the last one seen for the same
+  // robot count as arrivals, since the aggregator resends unchanged states.
+  std::unordered_map<std::string, rclcpp::Time> last_seen;
+  std::vector<double> latencies;
+  std::size_t fleet_states = 0;
+  std::size_t robot_states = 0;
+  const auto fleet_state_sub = sink->create_subscription<FleetState>(
+    rmf_fleet_adapter::FleetStateTopicName,
+    rclcpp::SystemDefaultsQoS().durability_volatile(),
+    [&](const FleetState::ConstSharedPtr msg)
+    {
+      if (msg->name != FleetName)
+        return;
+
+      const auto now = sink->get_clock()->now();
+      ++fleet_states;
+      robot_states += msg->robots.size();
+      for (const auto& state : msg->robots)
+      {
+        const rclcpp::Time t(state.location.t, RCL_ROS_TIME);
+        const auto it = last_seen.find(state.name);
+        if (it != last_seen.end() && t <= it->second)
+          continue;
+
+        last_seen.insert_or_assign(state.name, t);
+        latencies.push_back((now - t).seconds() * 1e3);
+      }
+    });
+
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i < robots; ++i)
+    names.push_back("benchmark_robot_" + std::to_string(i));
+
+  // Give discovery a moment when the aggregator runs in another process
+  if (!composed)
+  {
+    const auto wait_start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - wait_start
+      < std::chrono::seconds(2))
+    {
+      executor.spin_some(std::chrono::milliseconds(10));
+    }
+  }
+
+  const double total_rate = rate * static_cast<double>(robots);
+  std::size_t sent = 0;
+  const auto start = std::chrono::steady_clock::now();
+  const auto timer = source->create_wall_timer(
+    std::chrono::milliseconds(1),
+    [&]()
+    {
+      const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+      const auto due = static_cast<std::size_t>(elapsed * total_rate);
+      for (; sent < due; ++sent)
+      {
+        auto msg = std::make_unique<RobotState>();
+        msg->name = names[sent % robots];
+        msg->location.t = source->get_clock()->now();
+        msg->location.level_name = "benchmark_level";
+        msg->location.x = static_cast<double>(sent % robots);
+        robot_state_pub->publish(std::move(msg));
+      }
+    });
+
+  while (std::chrono::steady_clock::now() - start < duration)
+    executor.spin_some(std::chrono::milliseconds(10));
+
+  timer->cancel();
+  const auto drain_start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - drain_start
+    < std::chrono::milliseconds(500))
+  {
+    executor.spin_some(std::chrono::milliseconds(10));
+  }
+
+  const double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  std::printf(
+    "%s deployment with %lu robots at %.1f Hz each\n",
+    composed ? "Composed" : "Separate process", robots, rate);
+  std::printf(
+    "  %lu robot states sent | %lu delivered | %.1f fleet states/s | "
+    "%.1f robot states/s received\n",
+    sent, latencies.size(), static_cast<double>(fleet_states) / seconds,
+    static_cast<double>(robot_states) / seconds);
+  const double p50 = percentile(latencies, 0.5);
+  const double p99 = percentile(latencies, 0.99);
+  std::printf(
+    "  latency (ms): p50 %.3f | p99 %.3f | max %.3f\n",
+    p50, p99, latencies.empty() ? 0.0 : latencies.back());
+
+  if (aggregator.has_value())
+    executor.remove_node(aggregator->get_node_base_interface());
+
+  aggregator.reset();
+  rclcpp::shutdown();
+  return 0;
+}
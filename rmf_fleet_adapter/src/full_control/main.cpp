@@ -16,11 +16,13 @@
 */
 
 // Internal implementation-specific headers
+#include "../rmf_fleet_adapter/LaneStates.hpp"
 #include "../rmf_fleet_adapter/ParseArgs.hpp"
 #include "../rmf_fleet_adapter/load_param.hpp"
 
 // Public rmf_fleet_adapter API headers
 #include <rmf_fleet_adapter/agv/Adapter.hpp>
+#include <rmf_fleet_adapter/agv/GraphEventIndex.hpp>
 #include <rmf_fleet_adapter/agv/parse_graph.hpp>
 
 // Standard topic names for communicating with fleet drivers
@@ -60,6 +62,13 @@
 #include <Eigen/Geometry>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <thread>
 #include <unordered_set>
 #include <optional>
 
@@ -150,6 +159,371 @@ std::optional<DistanceFromGraph> distance_from_graph(
   return output;
 }
 
+//==============================================================================
+/// A fixed pool of threads that estimates the states of many robots at once.
+/// The estimate of each robot only touches that robot's own command handle,
+/// and the results are handed to its RobotUpdateHandle, which applies them on
+/// the adapter's worker, so the robots can be estimated in any order. Threads
+/// take the next robot as soon as they finish their last one, so a few slow
+/// robots do not hold up the rest.
+class EstimationWorkers
+{
+public:
+
+  using Job = std::function<void(std::size_t)>;
+
+  /// The thread that calls run() also does work, so a pool of size 1 will not
+  /// spawn any additional threads.
+  EstimationWorkers(const std::size_t num_workers)
+  {
+    for (std::size_t i = 1; i < num_workers; ++i)
+      _threads.emplace_back([this]() { _work(); });
+  }
+
+  /// Call job(i) for every i in [0, num_jobs) and block until every job is
+  /// finished
+  void run(const std::size_t num_jobs, const Job& job)
+  {
+    if (_threads.empty() || num_jobs < 2)
+    {
+      for (std::size_t i = 0; i < num_jobs; ++i)
+        job(i);
+
+      return;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _job = &job;
+      _num_jobs = num_jobs;
+      _next_job = 0;
+      _busy_workers = _threads.size();
+      ++_generation;
+    }
+    _start_cv.notify_all();
+
+    for (std::size_t i = _next_job++; i < num_jobs; i = _next_job++)
+      job(i);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finish_cv.wait(lock, [&]() { return _busy_workers == 0; });
+    _job = nullptr;
+  }
+
+  ~EstimationWorkers()
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _quit = true;
+    }
+    _start_cv.notify_all();
+
+    for (auto& thread : _threads)
+      thread.join();
+  }
+
+private:
+
+  void _work()
+  {
+    uint64_t last_generation = 0;
+    while (true)
+    {
+      const Job* job = nullptr;
+      std::size_t num_jobs = 0;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _start_cv.wait(lock, [&]()
+          {
+            return _quit || _generation != last_generation;
+          });
+
+        if (_quit)
+          return;
+
+        last_generation = _generation;
+        job = _job;
+        num_jobs = _num_jobs;
+      }
+
+      for (std::size_t i = _next_job++; i < num_jobs; i = _next_job++)
+        (*job)(i);
+
+      bool finished = false;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        finished = (--_busy_workers == 0);
+      }
+
+      if (finished)
+        _finish_cv.notify_all();
+    }
+  }
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _start_cv;
+  std::condition_variable _finish_cv;
+
+  const Job* _job = nullptr;
+  std::size_t _num_jobs = 0;
+  std::atomic_size_t _next_job = 0;
+  std::size_t _busy_workers = 0;
+  uint64_t _generation = 0;
+  bool _quit = false;
+};
+
+//==============================================================================
+/// Asks the lift watchdog service whether robots are clear to enter lifts.
+/// At most max_concurrent checks are sent at a time, and the rest wait in
+/// line for their turn. A robot that asks about the same lift again while a
+/// check is in flight shares the answer of that check, and answers are
+/// remembered for cache_ttl. A check that is not answered within the timeout
+/// is decided as Undefined, which makes the robot release the lift and try
+/// again later.
+class LiftClearanceChecker
+  : public std::enable_shared_from_this<LiftClearanceChecker>
+{
+public:
+
+  using Service = rmf_fleet_msgs::srv::LiftClearance;
+  using Unstable = rmf_fleet_adapter::agv::RobotUpdateHandle::Unstable;
+  using Decision = Unstable::Decision;
+  using Decide = Unstable::Decide;
+
+  struct Options
+  {
+    std::size_t max_concurrent = 4;
+    std::chrono::nanoseconds cache_ttl = std::chrono::seconds(2);
+    std::chrono::nanoseconds timeout = std::chrono::seconds(5);
+  };
+
+  static std::shared_ptr<LiftClearanceChecker> make(
+    std::shared_ptr<rclcpp::Node> node,
+    rclcpp::Client<Service>::SharedPtr client,
+    Options options)
+  {
+    auto checker = std::shared_ptr<LiftClearanceChecker>(
+      new LiftClearanceChecker);
+    checker->_node = std::move(node);
+    checker->_client = std::move(client);
+    checker->_options = options;
+    checker->_options.max_concurrent =
+      std::max<std::size_t>(1, options.max_concurrent);
+    return checker;
+  }
+
+  void check(
+    const std::string& lift_name,
+    const std::string& robot_name,
+    Decide decide)
+  {
+    if (!_client->service_is_ready())
+    {
+      RCLCPP_ERROR(
+        _node->get_logger(),
+        "Failed to get lift clearance service");
+      decide(Decision::Undefined);
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    const Key key{lift_name, robot_name};
+    const auto cached = _cache.find(key);
+    if (cached != _cache.end())
+    {
+      if (std::chrono::steady_clock::now() < cached->second.expires)
+      {
+        const auto decision = cached->second.decision;
+        lock.unlock();
+        decide(decision);
+        return;
+      }
+
+      _cache.erase(cached);
+    }
+
+    auto& pending = _checks[key];
+    pending.waiting.push_back(std::move(decide));
+    if (pending.waiting.size() > 1)
+      return;
+
+    pending.id = _next_id++;
+    if (_in_flight < _options.max_concurrent)
+      _send(key);
+    else
+      _queue.push_back(key);
+  }
+
+private:
+
+  LiftClearanceChecker() = default;
+
+  // The lift name and the robot name
+  using Key = std::pair<std::string, std::string>;
+
+  struct Pending
+  {
+    uint64_t id = 0;
+    std::vector<Decide> waiting;
+    rclcpp::TimerBase::SharedPtr timeout;
+  };
+
+  struct Cached
+  {
+    Decision decision;
+    std::chrono::steady_clock::time_point expires;
+  };
+
+  // This must be called while _mutex is locked
+  void _send(const Key& key)
+  {
+    ++_in_flight;
+    auto& pending = _checks.at(key);
+    const auto id = pending.id;
+
+    auto request = std::make_shared<Service::Request>(
+      rmf_fleet_msgs::build<Service::Request>()
+      .robot_name(key.second)
+      .lift_name(key.first));
+
+    _client->async_send_request(
+      request,
+      [w = weak_from_this(), key, id](
+        rclcpp::Client<Service>::SharedFuture response)
+      {
+        if (const auto self = w.lock())
+          self->_finish(key, id, convert_decision(response.get()->decision));
+      });
+
+    pending.timeout = _node->create_wall_timer(
+      _options.timeout,
+      [w = weak_from_this(), key, id]()
+      {
+        const auto self = w.lock();
+        if (!self)
+          return;
+
+        RCLCPP_WARN(
+          self->_node->get_logger(),
+          "Lift clearance check for robot [%s] to enter lift [%s] timed out",
+          key.second.c_str(), key.first.c_str());
+        self->_finish(key, id, std::nullopt);
+      });
+  }
+
+  // A nullopt decision means that the check timed out
+  void _finish(
+    const Key& key,
+    const uint64_t id,
+    const std::optional<Decision> decision)
+  {
+    std::vector<Decide> waiting;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto it = _checks.find(key);
+      if (it == _checks.end() || it->second.id != id)
+      {
+        // This is a late response to a check that already timed out
+        return;
+      }
+
+      waiting = std::move(it->second.waiting);
+      _checks.erase(it);
+      --_in_flight;
+
+      const auto now = std::chrono::steady_clock::now();
+      if (decision.has_value() && *decision != Decision::Undefined)
+        _cache[key] = Cached{*decision, now + _options.cache_ttl};
+
+      for (auto c = _cache.begin(); c != _cache.end(); )
+      {
+        if (c->second.expires <= now)
+          c = _cache.erase(c);
+        else
+          ++c;
+      }
+
+      while (_in_flight < _options.max_concurrent && !_queue.empty())
+      {
+        const auto next = _queue.front();
+        _queue.pop_front();
+        _send(next);
+      }
+    }
+
+    for (const auto& decide : waiting)
+      decide(decision.value_or(Decision::Undefined));
+  }
+
+  std::shared_ptr<rclcpp::Node> _node;
+  rclcpp::Client<Service>::SharedPtr _client;
+  Options _options;
+
+  std::mutex _mutex;
+  std::map<Key, Pending> _checks;
+  std::deque<Key> _queue;
+  std::map<Key, Cached> _cache;
+  std::size_t _in_flight = 0;
+  uint64_t _next_id = 0;
+};
+
+//==============================================================================
+/// Keeps track of which robots have paths that use each lane, so that closing
+/// a lane only needs to check the robots that would travel along it. A robot
+/// stays on its lanes until it is given another command, which is a superset
+/// of the lanes that it still has ahead of it.
+class LaneUsageIndex
+{
+public:
+
+  /// Set the lanes that a robot's path uses. Pass no lanes when the robot is
+  /// given a command that is not a path.
+  void set(const std::string& robot, std::unordered_set<std::size_t> lanes)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& current = _lanes_of_robot[robot];
+    for (const auto lane : current)
+    {
+      const auto it = _robots_on_lane.find(lane);
+      if (it == _robots_on_lane.end())
+        continue;
+
+      it->second.erase(robot);
+      if (it->second.empty())
+        _robots_on_lane.erase(it);
+    }
+
+    for (const auto lane : lanes)
+      _robots_on_lane[lane].insert(robot);
+
+    current = std::move(lanes);
+  }
+
+  /// Get the robots whose paths use any of these lanes
+  std::unordered_set<std::string> robots_on(
+    const std::unordered_set<std::size_t>& lanes) const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_set<std::string> robots;
+    for (const auto lane : lanes)
+    {
+      const auto it = _robots_on_lane.find(lane);
+      if (it != _robots_on_lane.end())
+        robots.insert(it->second.begin(), it->second.end());
+    }
+
+    return robots;
+  }
+
+private:
+  mutable std::mutex _mutex;
+  std::unordered_map<std::size_t, std::unordered_set<std::string>>
+  _robots_on_lane;
+  std::unordered_map<std::string, std::unordered_set<std::size_t>>
+  _lanes_of_robot;
+};
+
 //==============================================================================
 class FleetDriverRobotCommandHandle
   : public rmf_fleet_adapter::agv::RobotCommandHandle,
@@ -166,17 +540,39 @@ public:
   using ActionExecution =
     rmf_fleet_adapter::agv::RobotUpdateHandle::ActionExecution;
 
+  using Location = rmf_fleet_msgs::msg::Location;
+
+  /// How path requests get sent to the fleet driver
+  struct PathRequestOptions
+  {
+    /// Do not send a new path request when the adapter gives the robot the
+    /// same path that it was already asked to follow
+    bool skip_identical = false;
+
+    /// The fleet driver accepts delta path requests. When a new path begins
+    /// with some of the locations of the path that the robot is following, only
+    /// the rest of the new path is sent, with a task_id of
+    /// "<new task id>/<previous task id>/<kept count>". The driver keeps the
+    /// first <kept count> locations of the previous path, follows the locations
+    /// of the request after them, and reports <new task id> as its task_id.
+    bool deltas = false;
+  };
+
   FleetDriverRobotCommandHandle(
     rclcpp::Node& node,
     std::string fleet_name,
     std::string robot_name,
     std::shared_ptr<const rmf_traffic::agv::Graph> graph,
+    std::shared_ptr<const rmf_fleet_adapter::agv::GraphEventIndex> graph_index,
     std::shared_ptr<const rmf_traffic::agv::VehicleTraits> traits,
     PathRequestPub path_request_pub,
-    ModeRequestPub mode_request_pub)
+    ModeRequestPub mode_request_pub,
+    std::shared_ptr<LaneUsageIndex> lane_usage)
   : _node(&node),
+    _graph_index(std::move(graph_index)),
     _path_request_pub(std::move(path_request_pub)),
-    _mode_request_pub(std::move(mode_request_pub))
+    _mode_request_pub(std::move(mode_request_pub)),
+    _lane_usage(std::move(lane_usage))
   {
     _current_path_request.fleet_name = fleet_name;
     _current_path_request.robot_name = robot_name;
@@ -207,13 +603,22 @@ public:
     _travel_info.waypoints = waypoints;
     _travel_info.next_arrival_estimator = std::move(next_arrival_estimator);
     _travel_info.path_finished_callback = std::move(path_finished_callback);
+    const bool was_interrupted = _interrupted;
     _interrupted = false;
 
-    _current_path_request.task_id = std::to_string(++_current_task_id);
-    _current_path_request.path.clear();
+    std::unordered_set<std::size_t> lanes;
+    for (const auto& wp : waypoints)
+    {
+      const auto& approach_lanes = wp.approach_lanes();
+      lanes.insert(approach_lanes.begin(), approach_lanes.end());
+    }
+    _lane_usage->set(_travel_info.robot_name, std::move(lanes));
+
+    std::vector<Location> path;
+    path.reserve(waypoints.size());
     for (const auto& wp : waypoints)
     {
-      rmf_fleet_msgs::msg::Location location;
+      Location location;
       const Eigen::Vector3d p = wp.position();
       location.t = rmf_traffic_ros2::convert(wp.time());
       location.x = p.x();
@@ -253,47 +658,66 @@ public:
           _travel_info.graph->get_waypoint(*wp.graph_index()).get_map_name();
       }
 
-      _current_path_request.path.emplace_back(std::move(location));
+      path.emplace_back(std::move(location));
     }
 
-    _path_requested_time = std::chrono::steady_clock::now();
-    _path_request_pub->publish(_current_path_request);
-  }
+    // The robot may carry on with the path that it was already given
+    const bool can_reuse = !was_interrupted && !_current_path.empty();
+    if (_path_request_options.skip_identical && can_reuse
+      && path == _current_path)
+    {
+      RCLCPP_DEBUG(
+        _node->get_logger(),
+        "Skipping a path request for robot [%s] of [%s] because it is "
+        "identical to task [%s]",
+        _current_path_request.robot_name.c_str(),
+        _current_path_request.fleet_name.c_str(),
+        _current_path_task_id.c_str());
+      return;
+    }
 
-  void stop() final
-  {
-    // This is currently not used by the fleet drivers
-  }
+    // Only send a delta when the robot is known to be following the path that
+    // it refers to
+    const std::string base_task_id = _current_path_task_id;
+    const bool base_acknowledged = _last_known_state.has_value()
+      && _last_known_state->task_id == base_task_id;
 
-  class DockFinder : public rmf_traffic::agv::Graph::Lane::Executor
-  {
-  public:
+    std::size_t kept = 0;
+    if (_path_request_options.deltas && can_reuse && base_acknowledged)
+    {
+      while (kept < _current_path.size() && kept < path.size()
+        && _current_path[kept] == path[kept])
+      {
+        ++kept;
+      }
+    }
 
-    bool is_dock = false;
+    _current_path_task_id = std::to_string(++_current_task_id);
+    _current_path = std::move(path);
+    _path_delta_base = std::nullopt;
 
-    DockFinder(const std::string& dock_name)
-    : _dock_name(std::move(dock_name))
+    if (kept > 0)
     {
-      // Do nothing
+      _path_delta_base = base_task_id;
+      _current_path_request.task_id = _current_path_task_id + "/"
+        + base_task_id + "/" + std::to_string(kept);
+      _current_path_request.path.assign(
+        _current_path.begin() + kept, _current_path.end());
     }
-
-    void execute(const Dock& dock) final
+    else
     {
-      if (dock.dock_name() == _dock_name)
-        is_dock = true;
+      _current_path_request.task_id = _current_path_task_id;
+      _current_path_request.path = _current_path;
     }
 
-    void execute(const Wait&) final {}
-    void execute(const DoorOpen&) final {}
-    void execute(const DoorClose&) final {}
-    void execute(const LiftSessionBegin&) final {}
-    void execute(const LiftMove&) final {}
-    void execute(const LiftDoorOpen&) final {}
-    void execute(const LiftSessionEnd&) final {}
+    _path_requested_time = std::chrono::steady_clock::now();
+    _path_request_pub->publish(_current_path_request);
+  }
 
-  private:
-    const std::string& _dock_name;
-  };
+  void stop() final
+  {
+    // This is currently not used by the fleet drivers
+  }
 
   void dock(
     const std::string& dock_name,
@@ -303,6 +727,9 @@ public:
     _clear_last_command();
 
     _dock_finished_callback = std::move(docking_finished_callback);
+    _lane_usage->set(_travel_info.robot_name, {});
+    _current_path.clear();
+    _path_delta_base = std::nullopt;
     _current_dock_request.parameters.front().value = dock_name;
     _current_dock_request.task_id = std::to_string(++_current_task_id);
 
@@ -312,20 +739,12 @@ public:
     // TODO(MXG): We should come up with a better way to identify the docking
     // lanes.
     _dock_target_wp = rmf_utils::nullopt;
-    DockFinder finder(dock_name);
-    for (std::size_t i = 0; i < _travel_info.graph->num_lanes(); ++i)
+    const auto& dock_lanes = _graph_index->dock_lanes(dock_name);
+    if (!dock_lanes.empty())
     {
-      const auto& lane = _travel_info.graph->get_lane(i);
-      const auto entry_event = lane.entry().event();
-      if (entry_event)
-      {
-        entry_event->execute(finder);
-        if (finder.is_dock)
-        {
-          _dock_target_wp = lane.entry().waypoint_index();
-          break;
-        }
-      }
+      _dock_target_wp =
+        _travel_info.graph->get_lane(dock_lanes.front()).entry()
+        .waypoint_index();
     }
 
     assert(_dock_target_wp);
@@ -342,10 +761,47 @@ public:
       wp_name.c_str());
   }
 
+  /// Run the estimation for at most one state per period. States that change
+  /// what the robot is doing are always handled right away.
+  void set_estimation_period(
+    std::optional<std::chrono::steady_clock::duration> period)
+  {
+    auto lock = _lock();
+    _estimation_period = period;
+  }
+
+  void set_path_request_options(PathRequestOptions options)
+  {
+    auto lock = _lock();
+    _path_request_options = options;
+  }
+
   void update_state(const rmf_fleet_msgs::msg::RobotState& state)
   {
     auto lock = _lock();
+    const auto now = std::chrono::steady_clock::now();
+    if (_last_known_state.has_value())
+    {
+      const auto& last = *_last_known_state;
+      const bool transition = last.task_id != state.task_id
+        || last.mode.mode != state.mode.mode
+        || last.path.size() != state.path.size();
+
+      // Nothing about the robot has changed, or it has not been long enough
+      // since the last estimate, so only make sure our requests have gone out.
+      const bool unchanged = last == state;
+      const bool throttled = !transition && _estimation_period.has_value()
+        && now - _last_estimation_time < *_estimation_period;
+
+      if (unchanged || throttled)
+      {
+        _last_known_state = state;
+        return _retry_requests(state, now);
+      }
+    }
+
     _last_known_state = state;
+    _last_estimation_time = now;
 
     // Update battery soc
     const double battery_soc = state.battery_percent / 100.0;
@@ -378,7 +834,7 @@ public:
       // The arrival estimator should be available
       assert(_travel_info.next_arrival_estimator);
 
-      if (state.task_id != _current_path_request.task_id)
+      if (state.task_id != _current_path_task_id)
       {
         // The robot has not received our path request yet
         const auto now = std::chrono::steady_clock::now();
@@ -387,7 +843,7 @@ public:
           // We published the request a while ago, so we'll send it again in
           // case it got dropped.
           _path_requested_time = now;
-          _path_request_pub->publish(_current_path_request);
+          _resend_path_request(state);
         }
 
         return estimate_state(_node, state.location, _travel_info);
@@ -610,12 +1066,24 @@ public:
 private:
 
   rclcpp::Node* _node;
+  std::shared_ptr<const rmf_fleet_adapter::agv::GraphEventIndex> _graph_index;
 
   PathRequestPub _path_request_pub;
+  PathRequestOptions _path_request_options;
   rmf_fleet_msgs::msg::PathRequest _current_path_request;
+
+  // The task_id that the robot reports while it follows the current path,
+  // and the whole of that path, even when only a delta of it was sent
+  std::string _current_path_task_id;
+  std::vector<Location> _current_path;
+
+  // The task that the current path request is a delta of
+  std::optional<std::string> _path_delta_base;
   std::chrono::steady_clock::time_point _path_requested_time;
   TravelInfo _travel_info;
   std::optional<rmf_fleet_msgs::msg::RobotState> _last_known_state;
+  std::optional<std::chrono::steady_clock::duration> _estimation_period;
+  std::chrono::steady_clock::time_point _last_estimation_time;
   bool _interrupted = false;
 
   rmf_fleet_msgs::msg::ModeRequest _current_dock_request;
@@ -625,6 +1093,7 @@ private:
     std::chrono::steady_clock::now();
   RequestCompleted _dock_finished_callback;
   ModeRequestPub _mode_request_pub;
+  std::shared_ptr<LaneUsageIndex> _lane_usage;
 
   uint32_t _current_task_id = 0;
 
@@ -644,6 +1113,44 @@ private:
     return lock;
   }
 
+  void _retry_requests(
+    const rmf_fleet_msgs::msg::RobotState& state,
+    const std::chrono::steady_clock::time_point now)
+  {
+    if (_travel_info.path_finished_callback)
+    {
+      if (state.task_id != _current_path_task_id
+        && std::chrono::milliseconds(200) < now - _path_requested_time)
+      {
+        _path_requested_time = now;
+        _resend_path_request(state);
+      }
+    }
+    else if (_dock_finished_callback)
+    {
+      if (state.task_id != _current_dock_request.task_id
+        && std::chrono::milliseconds(200) < now - _dock_requested_time)
+      {
+        _dock_requested_time = now;
+        _mode_request_pub->publish(_current_dock_request);
+      }
+    }
+  }
+
+  void _resend_path_request(const rmf_fleet_msgs::msg::RobotState& state)
+  {
+    if (_path_delta_base.has_value() && state.task_id != *_path_delta_base)
+    {
+      // The robot is no longer following the path that the delta refers to,
+      // so it needs the whole path.
+      _current_path_request.task_id = _current_path_task_id;
+      _current_path_request.path = _current_path;
+      _path_delta_base = std::nullopt;
+    }
+
+    _path_request_pub->publish(_current_path_request);
+  }
+
   void _clear_last_command()
   {
     _travel_info.next_arrival_estimator = nullptr;
@@ -668,6 +1175,9 @@ struct Connections : public std::enable_shared_from_this<Connections>
   /// The navigation graph for the robot
   std::shared_ptr<const rmf_traffic::agv::Graph> graph;
 
+  /// Where to find the lanes of each dock, door, and lift in the graph
+  std::shared_ptr<const rmf_fleet_adapter::agv::GraphEventIndex> graph_index;
+
   /// The traits of the vehicles
   std::shared_ptr<const rmf_traffic::agv::VehicleTraits> traits;
 
@@ -687,9 +1197,8 @@ struct Connections : public std::enable_shared_from_this<Connections>
   rclcpp::Subscription<rmf_fleet_msgs::msg::ModeRequest>::SharedPtr
     mode_request_sub;
 
-  /// The client for listening to whether there is clearance in a lift
-  rclcpp::Client<rmf_fleet_msgs::srv::LiftClearance>::SharedPtr
-    lift_watchdog_client;
+  /// Checks with the lift watchdog whether there is clearance in a lift
+  std::shared_ptr<LiftClearanceChecker> lift_clearance_checker;
 
   /// The topic subscription for listening for lane closure requests
   rclcpp::Subscription<rmf_fleet_msgs::msg::LaneRequest>::SharedPtr
@@ -702,18 +1211,72 @@ struct Connections : public std::enable_shared_from_this<Connections>
   /// Container for remembering which lanes are currently closed
   std::unordered_set<std::size_t> closed_lanes;
 
+  /// Which robots have paths along each lane
+  std::shared_ptr<LaneUsageIndex> lane_usage =
+    std::make_shared<LaneUsageIndex>();
+
+  /// The topic subscription for listening to versioned lane state updates
+  rclcpp::Subscription<std_msgs::msg::String>::SharedPtr lane_state_update_sub;
+
+  /// Works out how the lane state updates affect this fleet
+  std::optional<rmf_fleet_adapter::LaneStateTracker> lane_state_tracker;
+
   /// The container for robot update handles
   std::unordered_map<std::string, FleetDriverRobotCommandHandlePtr>
   robots;
 
+  /// How often the state of each robot gets estimated
+  std::optional<std::chrono::steady_clock::duration> estimation_period;
+
+  /// How path requests get sent to the fleet driver
+  FleetDriverRobotCommandHandle::PathRequestOptions path_request_options;
+
+  /// The threads that estimate the states of the robots in each fleet state
+  std::optional<EstimationWorkers> estimation_workers;
+
+  void change_lanes(
+    const std::string& fleet_name,
+    const std::vector<std::size_t>& open_lanes,
+    const std::vector<std::size_t>& close_lanes)
+  {
+    fleet->change_lanes(open_lanes, close_lanes);
+
+    // Closing takes precedence over opening, the same as in change_lanes
+    for (const auto& l : open_lanes)
+      closed_lanes.erase(l);
+
+    std::unordered_set<std::size_t> newly_closed_lanes;
+    for (const auto& l : close_lanes)
+    {
+      if (closed_lanes.insert(l).second)
+        newly_closed_lanes.insert(l);
+    }
+
+    for (const auto& name : lane_usage->robots_on(newly_closed_lanes))
+    {
+      const auto robot = robots.find(name);
+      if (robot != robots.end())
+        robot->second->newly_closed_lanes(newly_closed_lanes);
+    }
+
+    rmf_fleet_msgs::msg::ClosedLanes state_msg;
+    state_msg.fleet_name = fleet_name;
+    state_msg.closed_lanes.insert(
+      state_msg.closed_lanes.begin(),
+      closed_lanes.begin(),
+      closed_lanes.end());
+
+    closed_lanes_pub->publish(state_msg);
+  }
+
   void add_robot(
     const std::string& fleet_name,
     const rmf_fleet_msgs::msg::RobotState& state)
   {
     const auto& robot_name = state.name;
     const auto command = std::make_shared<FleetDriverRobotCommandHandle>(
-      *adapter->node(), fleet_name, robot_name, graph, traits,
-      path_request_pub, mode_request_pub);
+      *adapter->node(), fleet_name, robot_name, graph, graph_index, traits,
+      path_request_pub, mode_request_pub, lane_usage);
 
     const auto& l = state.location;
     const auto& starts = rmf_traffic::agv::compute_plan_starts(
@@ -789,42 +1352,21 @@ struct Connections : public std::enable_shared_from_this<Connections>
 
         auto lock = connections->lock();
 
-        if (connections->lift_watchdog_client)
+        if (connections->lift_clearance_checker)
         {
           updater->unstable().set_lift_entry_watchdog(
-            [robot_name, connections](
+            [robot_name, checker = connections->lift_clearance_checker](
               const std::string& lift_name,
               auto decide)
             {
-              auto request =
-              std::make_shared<rmf_fleet_msgs::srv::LiftClearance::Request>(
-                rmf_fleet_msgs::build<rmf_fleet_msgs::srv::LiftClearance::Request>()
-                .robot_name(robot_name)
-                .lift_name(lift_name));
-
-              const auto client = connections->lift_watchdog_client;
-              if (!client->service_is_ready())
-              {
-                RCLCPP_ERROR(
-                  connections->adapter->node()->get_logger(),
-                  "Failed to get lift clearance service");
-                decide(convert_decision(0));
-                return;
-              }
-
-              client->async_send_request(
-                request,
-                [decide](
-                  rclcpp::Client<rmf_fleet_msgs::srv::LiftClearance>::
-                  SharedFuture response)
-                {
-                  const auto r = response.get();
-                  decide(convert_decision(r->decision));
-                });
+              checker->check(lift_name, robot_name, std::move(decide));
             });
         }
 
         command->set_updater(updater);
+        command->set_estimation_period(connections->estimation_period);
+        command->set_path_request_options(
+          connections->path_request_options);
         connections->robots[robot_name] = command;
       });
   }
@@ -878,9 +1420,17 @@ std::shared_ptr<Connections> make_fleet(
     return nullptr;
   }
 
+  const std::string graph_cache_directory =
+    node->declare_parameter("nav_graph_cache_directory", std::string());
+
   connections->graph =
     std::make_shared<rmf_traffic::agv::Graph>(
-    rmf_fleet_adapter::agv::parse_graph(graph_file, *connections->traits));
+    rmf_fleet_adapter::agv::parse_graph(
+      graph_file, *connections->traits, graph_cache_directory));
+
+  connections->graph_index =
+    std::make_shared<rmf_fleet_adapter::agv::GraphEventIndex>(
+    *connections->graph);
 
   std::cout << "The fleet [" << fleet_name
             << "] has the following named waypoints:\n";
@@ -926,32 +1476,35 @@ std::shared_ptr<Connections> make_fleet(
       !request_msg->fleet_name.empty())
         return;
 
-      connections->fleet->open_lanes(request_msg->open_lanes);
-      connections->fleet->close_lanes(request_msg->close_lanes);
-
-      std::unordered_set<std::size_t> newly_closed_lanes;
-      for (const auto& l : request_msg->close_lanes)
-      {
-        if (connections->closed_lanes.count(l) == 0)
-          newly_closed_lanes.insert(l);
-
-        connections->closed_lanes.insert(l);
-      }
+      connections->change_lanes(
+        fleet_name, request_msg->open_lanes, request_msg->close_lanes);
+    });
 
-      for (const auto& l : request_msg->open_lanes)
-        connections->closed_lanes.erase(l);
+  // When a lane_state_server is running, lane changes arrive as versioned
+  // deltas, so each change is applied once instead of being requested again
+  // until it is confirmed.
+  connections->lane_state_tracker.emplace(fleet_name);
+  connections->lane_state_update_sub =
+    adapter->node()->create_subscription<std_msgs::msg::String>(
+    rmf_fleet_adapter::LaneStateUpdateTopicName,
+    rclcpp::SystemDefaultsQoS().reliable().keep_last(64).transient_local(),
+    [w = connections->weak_from_this(), fleet_name](
+      std_msgs::msg::String::UniquePtr msg)
+    {
+      const auto connections = w.lock();
+      if (!connections)
+        return;
 
-      for (auto& [_, robot] : connections->robots)
-        robot->newly_closed_lanes(newly_closed_lanes);
+      const auto update = rmf_fleet_adapter::convert(*msg);
+      if (!update)
+        return;
 
-      rmf_fleet_msgs::msg::ClosedLanes state_msg;
-      state_msg.fleet_name = fleet_name;
-      state_msg.closed_lanes.insert(
-        state_msg.closed_lanes.begin(),
-        connections->closed_lanes.begin(),
-        connections->closed_lanes.end());
+      const auto change = connections->lane_state_tracker->receive(*update);
+      if (!change)
+        return;
 
-      connections->closed_lanes_pub->publish(state_msg);
+      connections->change_lanes(
+        fleet_name, change->open_lanes, change->close_lanes);
     });
 
   /* *INDENT-OFF* */
@@ -1161,6 +1714,40 @@ std::shared_ptr<Connections> make_fleet(
     "teleop",
     consider);
 
+  // Estimate where each robot is at most this many times per second. States
+  // that arrive in between are skipped unless the robot's task, mode, or path
+  // has changed. Use 0 to estimate every state that arrives.
+  const double max_estimation_rate =
+    node->declare_parameter<double>("max_estimation_rate", 0.0);
+  if (max_estimation_rate > 0.0)
+  {
+    connections->estimation_period =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / max_estimation_rate));
+  }
+
+  // Do not send a robot a path that is identical to the one it was already
+  // asked to follow, for example when a replan does not change anything.
+  connections->path_request_options.skip_identical =
+    node->declare_parameter<bool>("skip_identical_paths", false);
+
+  // Set this when the fleet driver accepts delta path requests. A new path
+  // that begins with locations of the path that the robot is following is
+  // then sent as a task_id of "<new task id>/<previous task id>/<kept count>"
+  // with only the locations after the kept ones. The driver keeps the first
+  // <kept count> locations of the previous path and reports <new task id>.
+  connections->path_request_options.deltas =
+    node->declare_parameter<bool>("path_request_deltas", false);
+
+  // Number of threads that estimate the states of the robots in each fleet
+  // state message. A value of 0 will use one thread per hardware core.
+  const auto estimation_threads =
+    node->declare_parameter<int>("estimation_threads", 1);
+  connections->estimation_workers.emplace(
+    estimation_threads > 0 ?
+    static_cast<std::size_t>(estimation_threads) :
+    std::max(1u, std::thread::hardware_concurrency()));
+
   if (node->declare_parameter<bool>("disable_delay_threshold", false))
   {
     connections->fleet->default_maximum_delay(rmf_utils::nullopt);
@@ -1185,7 +1772,7 @@ std::shared_ptr<Connections> make_fleet(
     rmf_fleet_adapter::FleetStateTopicName,
     rclcpp::SystemDefaultsQoS(),
     [c = std::weak_ptr<Connections>(connections), fleet_name](
-      const rmf_fleet_msgs::msg::FleetState::SharedPtr msg)
+      const rmf_fleet_msgs::msg::FleetState::ConstSharedPtr msg)
     {
       if (msg->name != fleet_name)
         return;
@@ -1194,6 +1781,9 @@ std::shared_ptr<Connections> make_fleet(
       if (!connections)
         return;
 
+      std::vector<std::pair<FleetDriverRobotCommandHandlePtr,
+        const rmf_fleet_msgs::msg::RobotState*>> updates;
+      updates.reserve(msg->robots.size());
       for (const auto& state : msg->robots)
       {
         const auto insertion = connections->robots.insert({state.name,
@@ -1209,9 +1799,15 @@ std::shared_ptr<Connections> make_fleet(
         if (command)
         {
           // We are ready to command this robot, so let's update its state
-          command->update_state(state);
+          updates.push_back({command, &state});
         }
       }
+
+      connections->estimation_workers->run(
+        updates.size(), [&updates](const std::size_t i)
+        {
+          updates[i].first->update_state(*updates[i].second);
+        });
     });
 
   const std::string lift_clearance_srv =
@@ -1219,9 +1815,22 @@ std::shared_ptr<Connections> make_fleet(
     "experimental_lift_watchdog_service", "");
   if (!lift_clearance_srv.empty())
   {
-    connections->lift_watchdog_client =
+    LiftClearanceChecker::Options options;
+    options.max_concurrent = static_cast<std::size_t>(
+      std::max<int64_t>(1, node->declare_parameter<int64_t>(
+        "experimental_lift_watchdog_concurrency", 4)));
+    options.cache_ttl = rmf_traffic::time::from_seconds(
+      node->declare_parameter<double>(
+        "experimental_lift_watchdog_cache_ttl", 2.0));
+    options.timeout = rmf_traffic::time::from_seconds(
+      node->declare_parameter<double>(
+        "experimental_lift_watchdog_timeout", 5.0));
+
+    connections->lift_clearance_checker = LiftClearanceChecker::make(
+      node,
       node->create_client<rmf_fleet_msgs::srv::LiftClearance>(
-      lift_clearance_srv);
+        lift_clearance_srv),
+      options);
   }
 
   return connections;
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: The lane state server turns lane closure requests into a versioned
+/// stream of lane state updates. Every change is published once as a delta
+/// that only contains the lanes that changed, so a site-wide closure reaches
+/// every fleet adapter in a single message. Snapshots of the full state are
+/// published periodically, and after every few deltas, so that listeners which
+/// join late or miss a delta can catch up. It takes these ROS 2 parameters:
+///  - snapshot_period: How many seconds to wait between snapshots
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <rmf_fleet_msgs/msg/lane_request.hpp>
+
+#include <rmf_fleet_adapter/StandardNames.hpp>
+
+#include "../rmf_fleet_adapter/LaneStates.hpp"
+
+#include <random>
+
+using namespace rmf_fleet_adapter;
+
+//==============================================================================
+class LaneStateServer : public rclcpp::Node
+{
+public:
+
+  using LaneRequest = rmf_fleet_msgs::msg::LaneRequest;
+  using UpdateMsg = std_msgs::msg::String;
+
+  // The transient local history is twice as deep as the number of deltas
+  // between snapshots, so a late joiner will always find a snapshot in it.
+  static constexpr std::size_t DeltasPerSnapshot = 32;
+
+  LaneStateServer()
+  : Node("lane_state_server"),
+    _sequencer(std::random_device()())
+  {
+    const double snapshot_period =
+      declare_parameter<double>("snapshot_period", 10.0);
+
+    _update_pub = create_publisher<UpdateMsg>(
+      LaneStateUpdateTopicName,
+      rclcpp::SystemDefaultsQoS()
+      .reliable().keep_last(2*DeltasPerSnapshot).transient_local());
+
+    _request_sub = create_subscription<LaneRequest>(
+      LaneClosureRequestTopicName,
+      rclcpp::SystemDefaultsQoS(),
+      [this](LaneRequest::UniquePtr msg)
+      {
+        _handle_request(*msg);
+      });
+
+    _snapshot_timer = create_wall_timer(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(snapshot_period)),
+      [this]()
+      {
+        _publish_snapshots();
+      });
+
+    _publish_snapshots();
+  }
+
+private:
+
+  void _handle_request(const LaneRequest& msg)
+  {
+    std::vector<std::size_t> open_lanes(
+      msg.open_lanes.begin(), msg.open_lanes.end());
+    std::vector<std::size_t> close_lanes(
+      msg.close_lanes.begin(), msg.close_lanes.end());
+
+    const auto update =
+      _sequencer.request(msg.fleet_name, open_lanes, close_lanes);
+    if (!update)
+      return;
+
+    _update_pub->publish(convert(*update));
+    if (update->sequence % DeltasPerSnapshot == 0)
+      _update_pub->publish(convert(_sequencer.snapshot(msg.fleet_name)));
+  }
+
+  void _publish_snapshots()
+  {
+    // Always include the site-wide state so that listeners learn the session
+    bool published_site = false;
+    for (const auto& name : _sequencer.fleet_names())
+    {
+      published_site = published_site || name.empty();
+      _update_pub->publish(convert(_sequencer.snapshot(name)));
+    }
+
+    if (!published_site)
+      _update_pub->publish(convert(_sequencer.snapshot("")));
+  }
+
+  LaneStateSequencer _sequencer;
+  rclcpp::Publisher<UpdateMsg>::SharedPtr _update_pub;
+  rclcpp::Subscription<LaneRequest>::SharedPtr _request_sub;
+  rclcpp::TimerBase::SharedPtr _snapshot_timer;
+};
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<LaneStateServer>());
+  rclcpp::shutdown();
+}
@@ -20,6 +20,11 @@
 #include <rmf_fleet_adapter/StandardNames.hpp>
 #include <rmf_traffic_ros2/StandardNames.hpp>
 
+#include <rmf_traffic/Time.hpp>
+
+#include <algorithm>
+#include <cassert>
+
 namespace rmf_fleet_adapter {
 namespace lift_supervisor {
 
@@ -48,46 +53,112 @@ Node::Node()
 
   _emergency_notice_pub = create_publisher<EmergencyNotice>(
     rmf_traffic_ros2::EmergencyTopicName, default_qos);
+
+  _queue_timeout = rclcpp::Duration(
+    rmf_traffic::time::from_seconds(
+      declare_parameter<double>("queue_timeout", 10.0)));
+
+  const double queue_status_period =
+    declare_parameter<double>("queue_status_period", 1.0);
+
+  _queue_status_pub = create_publisher<QueueStatus>(
+    LiftSupervisorQueueTopicName, default_qos);
+
+  _last_queue_status = get_clock()->now();
+  if (queue_status_period > 0.0)
+  {
+    _queue_status_timer = create_wall_timer(
+      rmf_traffic::time::from_seconds(queue_status_period),
+      [this]() { _publish_queue_status(); });
+  }
 }
 
 //==============================================================================
 void Node::_adapter_lift_request_update(LiftRequest::UniquePtr msg)
 {
-  auto& curr_request = _active_sessions.insert(
-    std::make_pair(msg->lift_name, nullptr)).first->second;
+  auto& lift = _lifts[msg->lift_name];
+  const auto now = get_clock()->now();
 
-  if (curr_request)
+  if (lift.active && lift.active->session_id == msg->session_id)
   {
-    if (curr_request->session_id == msg->session_id)
+    if (msg->request_type != LiftRequest::REQUEST_END_SESSION)
     {
-      if (msg->request_type != LiftRequest::REQUEST_END_SESSION)
-        curr_request = std::move(msg);
-      else
-      {
-        _lift_request_pub->publish(*msg);
-        curr_request = nullptr;
-      }
+      lift.active = std::move(msg);
+      return;
     }
+
+    _lift_request_pub->publish(*msg);
+    lift.active = nullptr;
+    _serve_next(lift);
+    return;
   }
-  else
+
+  const auto waiting_it = lift.waiting.find(msg->session_id);
+  if (msg->request_type == LiftRequest::REQUEST_END_SESSION)
   {
-    if (msg->request_type != LiftRequest::REQUEST_END_SESSION)
+    // The session gave up on the lift before it got its turn
+    if (waiting_it != lift.waiting.end())
     {
-      curr_request = std::move(msg);
+      lift.queue.erase(
+        std::find(lift.queue.begin(), lift.queue.end(), msg->session_id));
+      lift.waiting.erase(waiting_it);
     }
+
+    return;
+  }
+
+  if (waiting_it != lift.waiting.end())
+  {
+    // Repeated requests only refresh the session, it keeps its place
+    waiting_it->second.request = std::move(msg);
+    waiting_it->second.last_heard = now;
+    return;
   }
 
-  // TODO(MXG): Make this more intelligent by scheduling the lift
+  const std::string session_id = msg->session_id;
+  lift.queue.push_back(session_id);
+  lift.waiting.insert({session_id, Waiting{std::move(msg), now, now}});
+
+  if (!lift.active)
+    _serve_next(lift);
 }
 
 //==============================================================================
-void Node::_lift_state_update(LiftState::UniquePtr msg)
+void Node::_serve_next(Lift& lift)
 {
-  auto& lift_request = _active_sessions.insert(
-    std::make_pair(msg->lift_name, nullptr)).first->second;
+  const auto now = get_clock()->now();
+  while (!lift.queue.empty())
+  {
+    const auto it = lift.waiting.find(lift.queue.front());
+    lift.queue.pop_front();
+    assert(it != lift.waiting.end());
+
+    Waiting next = std::move(it->second);
+    lift.waiting.erase(it);
+
+    // Skip sessions that stopped asking for the lift while they waited
+    if (now - next.last_heard > _queue_timeout)
+      continue;
+
+    const double wait = (now - next.enqueued).seconds();
+    ++lift.sessions_served;
+    ++lift.recently_served;
+    lift.total_wait += wait;
+    lift.max_wait = std::max(lift.max_wait, wait);
+
+    lift.active = std::move(next.request);
+    _lift_request_pub->publish(*lift.active);
+    return;
+  }
+}
 
-  if (lift_request)
+//==============================================================================
+void Node::_lift_state_update(LiftState::UniquePtr msg)
+{
+  const auto lift_it = _lifts.find(msg->lift_name);
+  if (lift_it != _lifts.end() && lift_it->second.active)
   {
+    const auto& lift_request = lift_it->second.active;
     if ((lift_request->destination_floor != msg->current_floor) ||
       (lift_request->door_state != msg->door_state))
       _lift_request_pub->publish(*lift_request);
@@ -107,5 +178,75 @@ void Node::_lift_state_update(LiftState::UniquePtr msg)
 //  _emergency_notice_pub->publish(emergency_msg);
 }
 
+namespace {
+//==============================================================================
+diagnostic_msgs::msg::KeyValue make_key_value(
+  std::string key,
+  std::string value)
+{
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = std::move(key);
+  kv.value = std::move(value);
+  return kv;
+}
+} // anonymous namespace
+
+//==============================================================================
+void Node::_publish_queue_status()
+{
+  const auto now = get_clock()->now();
+  const double elapsed = (now - _last_queue_status).seconds();
+  _last_queue_status = now;
+
+  if (_lifts.empty())
+    return;
+
+  QueueStatus msg;
+  msg.header.stamp = now;
+  for (auto& [name, lift] : _lifts)
+  {
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = "lift_supervisor: " + name;
+    status.hardware_id = name;
+    status.message = lift.active ?
+      "serving [" + lift.active->session_id + "]" : "idle";
+
+    auto& values = status.values;
+    values.push_back(make_key_value(
+      "active_session", lift.active ? lift.active->session_id : ""));
+    values.push_back(make_key_value(
+      "queue_length", std::to_string(lift.queue.size())));
+
+    // The position of a session in the queue is its index in these values
+    for (std::size_t i = 0; i < lift.queue.size(); ++i)
+    {
+      const auto& session_id = lift.queue[i];
+      const auto& waiting = lift.waiting.at(session_id);
+      const std::string prefix = "queue[" + std::to_string(i) + "]";
+      values.push_back(make_key_value(prefix + ".session", session_id));
+      values.push_back(make_key_value(
+        prefix + ".wait", std::to_string((now - waiting.enqueued).seconds())));
+    }
+
+    const double mean_wait = lift.sessions_served > 0 ?
+      lift.total_wait / static_cast<double>(lift.sessions_served) : 0.0;
+    const double per_minute = elapsed > 0.0 ?
+      60.0 * static_cast<double>(lift.recently_served) / elapsed : 0.0;
+    lift.recently_served = 0;
+
+    values.push_back(make_key_value(
+      "sessions_served", std::to_string(lift.sessions_served)));
+    values.push_back(make_key_value(
+      "sessions_per_minute", std::to_string(per_minute)));
+    values.push_back(make_key_value("mean_wait", std::to_string(mean_wait)));
+    values.push_back(make_key_value("max_wait", std::to_string(lift.max_wait)));
+
+    msg.status.emplace_back(std::move(status));
+  }
+
+  _queue_status_pub->publish(msg);
+}
+
 } // namespace lift_supervisor
 } // namespace rmf_fleet_adapter
@@ -23,8 +23,11 @@
 
 #include <std_msgs/msg/bool.hpp>
 
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
 #include <rclcpp/node.hpp>
 
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -57,7 +60,48 @@ private:
   using EmergencyNoticePub = rclcpp::Publisher<EmergencyNotice>;
   EmergencyNoticePub::SharedPtr _emergency_notice_pub;
 
-  std::unordered_map<std::string, LiftRequest::UniquePtr> _active_sessions;
+  using QueueStatus = diagnostic_msgs::msg::DiagnosticArray;
+  using QueueStatusPub = rclcpp::Publisher<QueueStatus>;
+  QueueStatusPub::SharedPtr _queue_status_pub;
+  rclcpp::TimerBase::SharedPtr _queue_status_timer;
+  void _publish_queue_status();
+
+  // A session that is waiting for its turn to use a lift
+  struct Waiting
+  {
+    LiftRequest::UniquePtr request;
+    rclcpp::Time enqueued;
+    rclcpp::Time last_heard;
+  };
+
+  struct Lift
+  {
+    // The session that the lift is currently serving
+    LiftRequest::UniquePtr active;
+
+    // The sessions that are waiting for the lift in the order that they first
+    // asked for it. A session that repeats its request keeps its place.
+    std::deque<std::string> queue;
+    std::unordered_map<std::string, Waiting> waiting;
+
+    // Metrics since the node started
+    std::size_t sessions_served = 0;
+    double total_wait = 0.0;
+    double max_wait = 0.0;
+
+    // Sessions that were given the lift since the last queue status
+    std::size_t recently_served = 0;
+  };
+
+  std::unordered_map<std::string, Lift> _lifts;
+
+  // Queued sessions that have not repeated their request for this long are
+  // assumed to have given up on the lift
+  rclcpp::Duration _queue_timeout = rclcpp::Duration(std::chrono::seconds(10));
+  rclcpp::Time _last_queue_status;
+
+  // Give the lift to the next session in its queue
+  void _serve_next(Lift& lift);
 };
 
 } // namespace lift_supervisor
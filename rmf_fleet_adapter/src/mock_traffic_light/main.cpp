@@ -38,6 +38,12 @@
 
 // ROS2 utilities for rmf_traffic
 #include <rmf_traffic_ros2/Time.hpp>
+#include <rmf_traffic_ros2/StandardNames.hpp>
+
+// Negotiation messages that are counted by the load mode
+#include <rmf_traffic_msgs/msg/negotiation_notice.hpp>
+#include <rmf_traffic_msgs/msg/negotiation_rejection.hpp>
+#include <rmf_traffic_msgs/msg/negotiation_conclusion.hpp>
 
 // Utility functions for estimating where a robot is on the graph based on
 // the information provided by fleet drivers.
@@ -46,7 +52,12 @@
 // Utility to help with modular arithmetic
 #include <rmf_utils/Modular.hpp>
 
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
 #include <deque>
+#include <random>
 
 namespace {
 //==============================================================================
@@ -68,6 +79,31 @@ rmf_fleet_msgs::msg::Location make_location(
     .index(index);
 }
 
+//==============================================================================
+double percentile(std::vector<double> samples, const double q)
+{
+  if (samples.empty())
+    return 0.0;
+
+  std::sort(samples.begin(), samples.end());
+  const auto i = static_cast<std::size_t>(q * samples.size());
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+//==============================================================================
+/// Seconds of CPU time used by this process so far
+double cpu_seconds()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  const auto seconds = [](const timeval& t)
+    {
+      return static_cast<double>(t.tv_sec) + 1e-6 * t.tv_usec;
+    };
+
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
 } // anonymous namespace
 
 //==============================================================================
@@ -769,9 +805,13 @@ std::shared_ptr<Connections> make_fleet(
     return nullptr;
   }
 
+  const std::string graph_cache_directory =
+    node->declare_parameter("nav_graph_cache_directory", std::string());
+
   auto graph =
     std::make_shared<rmf_traffic::agv::Graph>(
-    rmf_fleet_adapter::agv::parse_graph(graph_file, *connections->traits));
+    rmf_fleet_adapter::agv::parse_graph(
+      graph_file, *connections->traits, graph_cache_directory));
 
   // We add pseudo-events on every lane to force the planner to include every
   // intermediate waypoint in its plan.
@@ -919,6 +959,537 @@ std::shared_ptr<Connections> make_fleet(
   return connections;
 }
 
+//==============================================================================
+/// Load mode for measuring how the traffic light scales. Instead of driving
+/// robots that a fleet driver reports, this simulates load_robots robots
+/// inside the process. Each robot drives to a random waypoint of the graph,
+/// obeying the instructions of its EasyTrafficLight, then picks a new one.
+/// With a probability of load_pause_probability a robot also stops at a
+/// checkpoint for a random time of up to load_max_pause seconds. The states
+/// of all the robots are reported together with update_states(~) at
+/// load_update_rate, and every load_stats_period seconds a summary is
+/// logged of:
+///  - approval latency: from following a new path until the traffic light
+///    lets the robot leave its first checkpoint
+///  - update latency: how long each batch of state updates took
+///  - the paths that were finished and the wait and pause instructions
+///  - the negotiation notices, rejections and conclusions on the site
+///  - the CPU used by the process
+class LoadGenerator : public std::enable_shared_from_this<LoadGenerator>
+{
+public:
+
+  using EasyTrafficLight = rmf_fleet_adapter::agv::EasyTrafficLight;
+  using EasyTrafficLightPtr = rmf_fleet_adapter::agv::EasyTrafficLightPtr;
+  using SteadyClock = std::chrono::steady_clock;
+
+  struct Options
+  {
+    std::size_t robots = 0;
+    double update_rate = 10.0;
+    double pause_probability = 0.2;
+    double max_pause = 5.0;
+    double stats_period = 10.0;
+    uint64_t seed = 42;
+  };
+
+  static std::shared_ptr<LoadGenerator> make(
+    std::shared_ptr<Connections> connections,
+    const std::string& fleet_name,
+    Options options)
+  {
+    auto generator = std::shared_ptr<LoadGenerator>(new LoadGenerator);
+    generator->_connections = std::move(connections);
+    generator->_options = options;
+    generator->_random.seed(options.seed);
+
+    const auto& graph = *generator->_connections->graph;
+    if (graph.num_waypoints() < 2)
+    {
+      RCLCPP_ERROR(
+        generator->_node()->get_logger(),
+        "The load mode needs a graph with at least two waypoints");
+      return nullptr;
+    }
+
+    std::uniform_int_distribution<std::size_t> pick(
+      0, graph.num_waypoints() - 1);
+    for (std::size_t i = 0; i < options.robots; ++i)
+    {
+      auto robot = std::make_shared<Robot>();
+      robot->name = "load_robot_" + std::to_string(i);
+      robot->waypoint = pick(generator->_random);
+      const auto& wp = graph.get_waypoint(robot->waypoint);
+      robot->map_name = wp.get_map_name();
+      robot->position = {wp.get_location().x(), wp.get_location().y(), 0.0};
+      generator->_robots.push_back(robot);
+
+      generator->_connections->adapter->add_easy_traffic_light(
+        [w = generator->weak_from_this(), robot](EasyTrafficLightPtr light)
+        {
+          const auto self = w.lock();
+          if (!self)
+            return;
+
+          std::lock_guard<std::mutex> lock(self->_mutex);
+          light->fleet_state_publish_period(std::nullopt);
+          robot->light = std::move(light);
+        },
+        fleet_name, robot->name, *generator->_connections->traits,
+        [w = generator->weak_from_this(), robot]()
+        {
+          if (const auto self = w.lock())
+          {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            robot->paused = true;
+            ++self->_stats.pause_callbacks;
+          }
+        },
+        [w = generator->weak_from_this(), robot]()
+        {
+          if (const auto self = w.lock())
+          {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            robot->paused = false;
+          }
+        });
+    }
+
+    generator->_subscribe_to_negotiations();
+
+    const auto node = generator->_node();
+    const auto update_period = std::chrono::duration_cast<
+      std::chrono::nanoseconds>(
+      std::chrono::duration<double>(1.0 / options.update_rate));
+    generator->_update_timer = node->create_wall_timer(
+      update_period,
+      [w = generator->weak_from_this()]()
+      {
+        if (const auto self = w.lock())
+          self->_update();
+      });
+
+    generator->_stats_timer = node->create_wall_timer(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(options.stats_period)),
+      [w = generator->weak_from_this()]()
+      {
+        if (const auto self = w.lock())
+          self->_report();
+      });
+
+    generator->_stats_start = SteadyClock::now();
+    generator->_cpu_start = cpu_seconds();
+    generator->_last_update = SteadyClock::now();
+
+    RCLCPP_INFO(
+      node->get_logger(),
+      "Starting the load mode with [%lu] robots",
+      options.robots);
+
+    return generator;
+  }
+
+private:
+
+  LoadGenerator() = default;
+
+  struct Robot
+  {
+    std::string name;
+    EasyTrafficLightPtr light;
+
+    std::string map_name;
+    Eigen::Vector3d position;
+    std::size_t waypoint;
+
+    // The checkpoints of the current path, if the robot has one
+    std::vector<Eigen::Vector3d> path;
+    std::size_t checkpoint = 0;
+    bool moving = false;
+    bool continue_at_next = false;
+    bool paused = false;
+    std::optional<SteadyClock::time_point> pause_until;
+
+    // When the current path was given to the traffic light, until the robot
+    // gets to leave its first checkpoint
+    std::optional<SteadyClock::time_point> requested;
+  };
+
+  struct Stats
+  {
+    std::vector<double> approval_ms;
+    std::vector<double> update_ms;
+    std::size_t paths_finished = 0;
+    std::size_t plan_failures = 0;
+    std::size_t wait_instructions = 0;
+    std::size_t pause_instructions = 0;
+    std::size_t pause_callbacks = 0;
+    std::size_t errors = 0;
+    std::size_t notices = 0;
+    std::size_t rejections = 0;
+    std::size_t resolved = 0;
+    std::size_t failed = 0;
+  };
+
+  std::shared_ptr<rclcpp::Node> _node() const
+  {
+    return _connections->adapter->node();
+  }
+
+  void _subscribe_to_negotiations()
+  {
+    const auto node = _node();
+    const auto qos = rclcpp::ServicesQoS().reliable().keep_last(1000);
+    using Notice = rmf_traffic_msgs::msg::NegotiationNotice;
+    _notice_sub = node->create_subscription<Notice>(
+      rmf_traffic_ros2::NegotiationNoticeTopicName, qos,
+      [w = weak_from_this()](const Notice::SharedPtr)
+      {
+        if (const auto self = w.lock())
+        {
+          std::lock_guard<std::mutex> lock(self->_mutex);
+          ++self->_stats.notices;
+        }
+      });
+
+    using Rejection = rmf_traffic_msgs::msg::NegotiationRejection;
+    _rejection_sub = node->create_subscription<Rejection>(
+      rmf_traffic_ros2::NegotiationRejectionTopicName, qos,
+      [w = weak_from_this()](const Rejection::SharedPtr)
+      {
+        if (const auto self = w.lock())
+        {
+          std::lock_guard<std::mutex> lock(self->_mutex);
+          ++self->_stats.rejections;
+        }
+      });
+
+    using Conclusion = rmf_traffic_msgs::msg::NegotiationConclusion;
+    _conclusion_sub = node->create_subscription<Conclusion>(
+      rmf_traffic_ros2::NegotiationConclusionTopicName, qos,
+      [w = weak_from_this()](const Conclusion::SharedPtr msg)
+      {
+        if (const auto self = w.lock())
+        {
+          std::lock_guard<std::mutex> lock(self->_mutex);
+          if (msg->resolved)
+            ++self->_stats.resolved;
+          else
+            ++self->_stats.failed;
+        }
+      });
+  }
+
+  void _update()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto now = SteadyClock::now();
+    const double dt = std::chrono::duration<double>(now - _last_update).count();
+    _last_update = now;
+
+    std::vector<EasyTrafficLight::State> states;
+    std::vector<std::shared_ptr<Robot>> robots;
+    states.reserve(_robots.size());
+    robots.reserve(_robots.size());
+    for (const auto& robot : _robots)
+    {
+      if (!robot->light)
+        continue;
+
+      if (robot->path.empty())
+        _start_new_path(*robot, now);
+
+      if (robot->moving && !robot->paused)
+        _advance(*robot, dt, now);
+
+      if (robot->path.empty())
+      {
+        states.push_back(
+          EasyTrafficLight::State::idle(
+            robot->light, robot->map_name, robot->position));
+      }
+      else if (robot->moving)
+      {
+        states.push_back(
+          EasyTrafficLight::State::moving_from(
+            robot->light, robot->checkpoint, robot->position));
+      }
+      else if (_at_checkpoint(*robot))
+      {
+        states.push_back(
+          EasyTrafficLight::State::waiting_at(
+            robot->light, robot->checkpoint));
+      }
+      else
+      {
+        states.push_back(
+          EasyTrafficLight::State::waiting_after(
+            robot->light, robot->checkpoint, robot->position));
+      }
+
+      robots.push_back(robot);
+    }
+
+    const auto update_start = SteadyClock::now();
+    const auto instructions = EasyTrafficLight::update_states(states);
+    _stats.update_ms.push_back(
+      std::chrono::duration<double, std::milli>(
+        SteadyClock::now() - update_start).count());
+
+    for (std::size_t i = 0; i < instructions.size(); ++i)
+      _apply(*robots[i], states[i], instructions[i], now);
+  }
+
+  bool _at_checkpoint(const Robot& robot) const
+  {
+    const auto& p = robot.path.at(robot.checkpoint);
+    return (robot.position.block<2, 1>(0, 0) - p.block<2, 1>(0, 0)).norm()
+      < 1e-3;
+  }
+
+  void _start_new_path(Robot& robot, const SteadyClock::time_point now)
+  {
+    const auto& graph = *_connections->graph;
+    std::uniform_int_distribution<std::size_t> pick(
+      0, graph.num_waypoints() - 1);
+    auto goal = pick(_random);
+    if (goal == robot.waypoint)
+      goal = (goal + 1) % graph.num_waypoints();
+
+    const auto start = rmf_traffic::agv::Plan::Start(
+      rmf_traffic_ros2::convert(_node()->now()),
+      robot.waypoint, robot.position[2]);
+    const auto plan = _connections->planner->plan(start, goal);
+    if (!plan || plan->get_waypoints().size() < 2)
+    {
+      ++_stats.plan_failures;
+      return;
+    }
+
+    std::vector<rmf_fleet_adapter::agv::Waypoint> new_path;
+    std::vector<Eigen::Vector3d> positions;
+    std::size_t last_index = robot.waypoint;
+    for (const auto& wp : plan->get_waypoints())
+    {
+      const Eigen::Vector3d p = wp.position();
+      if (!positions.empty()
+        && (p.block<2, 1>(0, 0) - positions.back().block<2, 1>(0, 0)).norm()
+        < 0.01)
+        continue;
+
+      std::string map_name = robot.map_name;
+      if (wp.graph_index().has_value())
+      {
+        last_index = *wp.graph_index();
+        map_name = graph.get_waypoint(last_index).get_map_name();
+      }
+
+      new_path.emplace_back(map_name, p);
+      positions.push_back(p);
+    }
+
+    if (positions.size() < 2)
+    {
+      ++_stats.plan_failures;
+      return;
+    }
+
+    robot.light->follow_new_path(new_path);
+    robot.path = std::move(positions);
+    robot.position = robot.path.front();
+    robot.waypoint = last_index;
+    robot.checkpoint = 0;
+    robot.moving = false;
+    robot.continue_at_next = false;
+    robot.pause_until = std::nullopt;
+    robot.requested = now;
+  }
+
+  void _advance(
+    Robot& robot,
+    const double dt,
+    const SteadyClock::time_point now)
+  {
+    double remaining =
+      _connections->traits->linear().get_nominal_velocity() * dt;
+    while (remaining > 0.0 && robot.moving)
+    {
+      const auto& next = robot.path.at(robot.checkpoint + 1);
+      const Eigen::Vector2d d =
+        next.block<2, 1>(0, 0) - robot.position.block<2, 1>(0, 0);
+      const double distance = d.norm();
+      if (distance > remaining)
+      {
+        robot.position.block<2, 1>(0, 0) += d / distance * remaining;
+        robot.position[2] = std::atan2(d.y(), d.x());
+        return;
+      }
+
+      remaining -= distance;
+      robot.position[0] = next[0];
+      robot.position[1] = next[1];
+      ++robot.checkpoint;
+
+      if (robot.checkpoint + 1 == robot.path.size())
+      {
+        robot.moving = false;
+        return;
+      }
+
+      std::uniform_real_distribution<double> chance(0.0, 1.0);
+      if (chance(_random) < _options.pause_probability)
+      {
+        robot.moving = false;
+        robot.pause_until = now + std::chrono::duration_cast<
+          SteadyClock::duration>(std::chrono::duration<double>(
+            chance(_random) * _options.max_pause));
+        return;
+      }
+
+      if (!robot.continue_at_next)
+      {
+        robot.moving = false;
+        return;
+      }
+
+      robot.continue_at_next = false;
+    }
+  }
+
+  void _apply(
+    Robot& robot,
+    const EasyTrafficLight::State& state,
+    const EasyTrafficLight::Instruction& instruction,
+    const SteadyClock::time_point now)
+  {
+    using Type = EasyTrafficLight::State::Type;
+    using Moving = EasyTrafficLight::MovingInstruction;
+    using Waiting = EasyTrafficLight::WaitingInstruction;
+
+    if (state.type == Type::Idle)
+      return;
+
+    if (instruction.moving.has_value())
+    {
+      switch (*instruction.moving)
+      {
+        case Moving::ContinueAtNextCheckpoint:
+          robot.continue_at_next = true;
+          break;
+        case Moving::WaitAtNextCheckpoint:
+          robot.continue_at_next = false;
+          break;
+        case Moving::PauseImmediately:
+          robot.moving = false;
+          ++_stats.pause_instructions;
+          break;
+        case Moving::MovingError:
+          ++_stats.errors;
+          break;
+      }
+
+      return;
+    }
+
+    if (!instruction.waiting.has_value())
+      return;
+
+    if (*instruction.waiting == Waiting::WaitingError)
+    {
+      ++_stats.errors;
+      return;
+    }
+
+    if (*instruction.waiting == Waiting::Wait)
+    {
+      ++_stats.wait_instructions;
+      return;
+    }
+
+    if (state.type == Type::WaitingAt
+      && robot.checkpoint + 1 == robot.path.size())
+    {
+      // The robot has finished its path, so it can be given a new one
+      ++_stats.paths_finished;
+      robot.path.clear();
+      return;
+    }
+
+    if (robot.pause_until.has_value())
+    {
+      if (now < *robot.pause_until)
+        return;
+
+      robot.pause_until = std::nullopt;
+    }
+
+    if (robot.requested.has_value())
+    {
+      _stats.approval_ms.push_back(
+        std::chrono::duration<double, std::milli>(
+          now - *robot.requested).count());
+      robot.requested = std::nullopt;
+    }
+
+    robot.moving = true;
+    robot.continue_at_next = false;
+  }
+
+  void _report()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto now = SteadyClock::now();
+    const double elapsed =
+      std::chrono::duration<double>(now - _stats_start).count();
+    const double cpu = cpu_seconds();
+    const auto& s = _stats;
+
+    RCLCPP_INFO(
+      _node()->get_logger(),
+      "Load summary for [%lu] robots over %.1fs:\n"
+      "  approval latency [ms]: p50 %.1f | p90 %.1f | p99 %.1f (%lu)\n"
+      "  update latency [ms]: p50 %.2f | p90 %.2f | p99 %.2f (%lu)\n"
+      "  paths finished: %lu | plan failures: %lu\n"
+      "  wait instructions: %lu | pauses: %lu | pause callbacks: %lu | "
+      "errors: %lu\n"
+      "  negotiations: %lu | rejections: %lu | resolved: %lu | failed: %lu\n"
+      "  CPU: %.1f%%",
+      _robots.size(), elapsed,
+      percentile(s.approval_ms, 0.5), percentile(s.approval_ms, 0.9),
+      percentile(s.approval_ms, 0.99), s.approval_ms.size(),
+      percentile(s.update_ms, 0.5), percentile(s.update_ms, 0.9),
+      percentile(s.update_ms, 0.99), s.update_ms.size(),
+      s.paths_finished, s.plan_failures,
+      s.wait_instructions, s.pause_instructions, s.pause_callbacks,
+      s.errors,
+      s.notices, s.rejections, s.resolved, s.failed,
+      elapsed > 0.0 ? 100.0 * (cpu - _cpu_start) / elapsed : 0.0);
+
+    _stats = Stats();
+    _stats_start = now;
+    _cpu_start = cpu;
+  }
+
+  std::shared_ptr<Connections> _connections;
+  Options _options;
+  std::mt19937_64 _random;
+
+  std::mutex _mutex;
+  std::vector<std::shared_ptr<Robot>> _robots;
+  Stats _stats;
+  SteadyClock::time_point _stats_start;
+  SteadyClock::time_point _last_update;
+  double _cpu_start = 0.0;
+
+  rclcpp::TimerBase::SharedPtr _update_timer;
+  rclcpp::TimerBase::SharedPtr _stats_timer;
+  rclcpp::SubscriptionBase::SharedPtr _notice_sub;
+  rclcpp::SubscriptionBase::SharedPtr _rejection_sub;
+  rclcpp::SubscriptionBase::SharedPtr _conclusion_sub;
+};
+
+//==============================================================================
 int main(int argc, char* argv[])
 {
   rclcpp::init(argc, argv);
@@ -930,6 +1501,34 @@ int main(int argc, char* argv[])
   if (!fleet_connections)
     return 1;
 
+  // Setting load_robots to a positive number simulates that many robots
+  // instead of waiting for a fleet driver to report them
+  const auto& node = adapter->node();
+  LoadGenerator::Options load_options;
+  load_options.robots = static_cast<std::size_t>(std::max<int64_t>(
+      0, node->declare_parameter<int64_t>("load_robots", 0)));
+  load_options.update_rate = std::max(
+    1e-3, node->declare_parameter<double>("load_update_rate", 10.0));
+  load_options.pause_probability =
+    node->declare_parameter<double>("load_pause_probability", 0.2);
+  load_options.max_pause =
+    node->declare_parameter<double>("load_max_pause", 5.0);
+  load_options.stats_period = std::max(
+    1e-3, node->declare_parameter<double>("load_stats_period", 10.0));
+  load_options.seed = static_cast<uint64_t>(
+    node->declare_parameter<int64_t>("load_seed", 42));
+
+  std::shared_ptr<LoadGenerator> load_generator;
+  if (load_options.robots > 0)
+  {
+    load_generator = LoadGenerator::make(
+      fleet_connections, node->get_parameter("fleet_name").as_string(),
+      load_options);
+
+    if (!load_generator)
+      return 1;
+  }
+
   RCLCPP_INFO(adapter->node()->get_logger(), "Starting Mock Traffic Light");
 
   adapter->start().wait();
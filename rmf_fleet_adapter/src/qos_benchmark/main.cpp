@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark shows how the history depth of a state topic affects
+/// the memory and the latency of a subscriber like the fleet adapter. A set of
+/// doors publish their states on one topic in bursts, like many door adapters
+/// do, and a subscriber spends some time on each message, like a busy fleet
+/// adapter does. It reports how many states get delivered, how stale they are
+/// when they arrive, and how much history the middleware may keep for the
+/// subscriber. It then adds a late joining subscriber to show how many old
+/// states get replayed to it.
+///
+/// The same qos.<topic>.depth, qos.<topic>.reliable and
+/// qos.<topic>.transient_local parameters that configure the fleet adapter
+/// node can be given here for the door_states topic.
+///
+/// Usage:
+///   ros2 run rmf_fleet_adapter qos_benchmark --ros-args
+///     -p doors:=300 -p rate:=1.0 -p duration:=10 -p callback_cost_us:=100
+///     -p qos.door_states.depth:=10 -p qos.door_states.transient_local:=false
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp/serialization.hpp>
+
+#include <rmf_door_msgs/msg/door_state.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using DoorState = rmf_door_msgs::msg::DoorState;
+
+namespace {
+//==============================================================================
+double percentile(std::vector<double>& samples, const double q)
+{
+  if (samples.empty())
+    return 0.0;
+
+  std::sort(samples.begin(), samples.end());
+  const auto i = static_cast<std::size_t>(q * samples.size());
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+//==============================================================================
+void spin_for(
+  rclcpp::executors::SingleThreadedExecutor& executor,
+  const std::chrono::steady_clock::duration duration)
+{
+  const auto start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - start < duration)
+    executor.spin_some(std::chrono::milliseconds(10));
+}
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto settings = std::make_shared<rclcpp::Node>("qos_benchmark");
+  const auto doors = static_cast<std::size_t>(
+    std::max<int64_t>(1, settings->declare_parameter("doors", 300)));
+  const double rate = settings->declare_parameter("rate", 1.0);
+  const auto duration = std::chrono::seconds(
+    std::max<int64_t>(1, settings->declare_parameter("duration", 10)));
+  const auto callback_cost = std::chrono::microseconds(
+    settings->declare_parameter("callback_cost_us", 100));
+  const auto depth = static_cast<std::size_t>(std::max<int64_t>(
+      1, settings->declare_parameter("qos.door_states.depth", 10)));
+  const bool reliable =
+    settings->declare_parameter("qos.door_states.reliable", true);
+  const bool transient_local =
+    settings->declare_parameter("qos.door_states.transient_local", false);
+
+  auto qos = rclcpp::SystemDefaultsQoS().keep_last(depth);
+  if (reliable)
+    qos.reliable();
+  else
+    qos.best_effort();
+
+  if (transient_local)
+    qos.transient_local();
+  else
+    qos.durability_volatile();
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  auto source = std::make_shared<rclcpp::Node>("qos_benchmark_source");
+  auto sink = std::make_shared<rclcpp::Node>("qos_benchmark_sink");
+  executor.add_node(source);
+  executor.add_node(sink);
+
+  const auto door_state_pub =
+    source->create_publisher<DoorState>("qos_benchmark_door_states", qos);
+
+  std::vector<double> latencies;
+  const auto door_state_sub = sink->create_subscription<DoorState>(
+    "qos_benchmark_door_states", qos,
+    [&](const DoorState::ConstSharedPtr msg)
+    {
+      const rclcpp::Time t(msg->door_time, RCL_ROS_TIME);
+      latencies.push_back((sink->get_clock()->now() - t).seconds() * 1e3);
+      std::this_thread::sleep_for(callback_cost);
+    });
+
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i < doors; ++i)
+    names.push_back("benchmark_door_" + std::to_string(i));
+
+  // Give discovery a moment before anything gets published
+  spin_for(executor, std::chrono::milliseconds(500));
+
+  std::size_t sent = 0;
+  std::size_t bytes_per_state = 0;
+  rclcpp::Serialization<DoorState> serialization;
+  const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(1.0 / std::max(rate, 1e-3)));
+  const auto timer = source->create_wall_timer(
+    period,
+    [&]()
+    {
+      for (const auto& name : names)
+      {
+        DoorState msg;
+        msg.door_time = source->get_clock()->now();
+        msg.door_name = name;
+        msg.current_mode.value = static_cast<uint32_t>((sent / doors) % 2);
+        if (bytes_per_state == 0)
+        {
+          rclcpp::SerializedMessage serialized;
+          serialization.serialize_message(&msg, &serialized);
+          bytes_per_state = serialized.size();
+        }
+
+        door_state_pub->publish(msg);
+        ++sent;
+      }
+    });
+
+  spin_for(executor, duration);
+  timer->cancel();
+  spin_for(executor, std::chrono::milliseconds(500));
+
+  const std::size_t delivered = latencies.size();
+  const double p50 = percentile(latencies, 0.5);
+  const double p99 = percentile(latencies, 0.99);
+
+  // A subscriber that joins late only gets old states replayed if both sides
+  // are transient local.
+  std::size_t replayed = 0;
+  const auto late_sub = sink->create_subscription<DoorState>(
+    "qos_benchmark_door_states", qos,
+    [&](const DoorState::ConstSharedPtr)
+    {
+      ++replayed;
+    });
+  spin_for(executor, std::chrono::seconds(1));
+
+  std::printf(
+    "%lu doors at %.1f Hz, depth %lu, %s, %s, %ld us per callback\n",
+    doors, rate, depth, reliable ? "reliable" : "best effort",
+    transient_local ? "transient local" : "volatile",
+    static_cast<long>(callback_cost.count()));
+  std::printf(
+    "  %lu door states sent | %lu delivered (%.1f%%)\n",
+    sent, delivered,
+    sent == 0 ? 0.0 : 100.0 * static_cast<double>(delivered) / sent);
+  std::printf(
+    "  latency (ms): p50 %.3f | p99 %.3f | max %.3f\n",
+    p50, p99, latencies.empty() ? 0.0 : latencies.back());
+  std::printf(
+    "  history per subscriber: up to %lu bytes (%lu bytes per state)\n",
+    depth * bytes_per_state, bytes_per_state);
+  std::printf("  states replayed to a late joiner: %lu\n", replayed);
+
+  rclcpp::shutdown();
+  return 0;
+}
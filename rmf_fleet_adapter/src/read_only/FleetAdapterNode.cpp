@@ -24,12 +24,15 @@
 #include <rmf_traffic_ros2/StandardNames.hpp>
 #include <rmf_traffic_ros2/Time.hpp>
 #include <rmf_traffic_ros2/Trajectory.hpp>
+#include <rmf_traffic_ros2/schedule/RouteBox.hpp>
 
 #include <rmf_fleet_adapter/StandardNames.hpp>
 
 #include <rclcpp/macros.hpp>
 #include <rclcpp/executors.hpp>
 
+#include <cmath>
+
 #include "../rmf_fleet_adapter/load_param.hpp"
 
 #include "../rmf_fleet_adapter/make_trajectory.hpp"
@@ -48,6 +51,18 @@ std::shared_ptr<FleetAdapterNode> FleetAdapterNode::make()
   node->_delay_threshold =
     get_parameter_or_default_time(*node, "delay_threshold", 5.0);
 
+  node->_position_tolerance =
+    get_parameter_or_default(*node, "state_position_tolerance", 0.01);
+
+  node->_yaw_tolerance =
+    get_parameter_or_default(*node, "state_yaw_tolerance", 0.01);
+
+  node->_unchanged_refresh_period =
+    get_parameter_or_default_time(*node, "unchanged_state_refresh_period", 1.0);
+
+  node->_route_push_period =
+    get_parameter_or_default_time(*node, "route_push_period", 0.5);
+
   auto mirror_future = rmf_traffic_ros2::schedule::make_mirror(
     node, rmf_traffic::schedule::query_all());
 
@@ -117,6 +132,19 @@ FleetAdapterNode::ScheduleEntry::ScheduleEntry(
 
           const auto proposals = table->base_proposals();
           const auto& profile = this->schedule->description().profile();
+
+          // Boxing our own routes once lets us skip the conflict checks of
+          // every route pair that is nowhere near each other.
+          std::vector<std::optional<rmf_traffic_ros2::schedule::RouteBox>>
+          boxes;
+          boxes.reserve(itinerary.size());
+          for (const auto& item : itinerary)
+          {
+            boxes.push_back(
+              rmf_traffic_ros2::schedule::compute_box(
+                item.route->trajectory(), profile));
+          }
+
           for (const auto& p : proposals)
           {
             const auto other_participant =
@@ -135,11 +163,20 @@ FleetAdapterNode::ScheduleEntry::ScheduleEntry(
             const auto& other_profile = other_participant->profile();
             for (const auto& other_route : p.itinerary)
             {
-              for (const auto& item : itinerary)
+              const auto other_box = rmf_traffic_ros2::schedule::compute_box(
+                other_route->trajectory(), other_profile);
+              if (!other_box.has_value())
+                continue;
+
+              for (std::size_t i = 0; i < itinerary.size(); ++i)
               {
+                const auto& item = itinerary[i];
                 if (item.route->map() != other_route->map())
                   continue;
 
+                if (!boxes[i].has_value() || !boxes[i]->overlaps(*other_box))
+                  continue;
+
                 if (rmf_traffic::DetectConflict::between(
                   profile,
                   item.route->trajectory(),
@@ -191,18 +228,76 @@ void FleetAdapterNode::fleet_state_update(FleetState::UniquePtr state)
   if (ignore_fleet(state->name))
     return;
 
+  const auto now = rmf_traffic_ros2::convert(this->now());
   for (const auto& robot : state->robots)
   {
     const auto insertion = _schedule_entries.insert(
       std::make_pair(robot.name, nullptr));
 
     if (insertion.second)
+    {
       register_robot(robot, insertion.first);
-    else if (insertion.first->second->schedule)
-      update_robot(robot, insertion.first);
+      continue;
+    }
+
+    auto& entry = *insertion.first->second;
+    if (!entry.schedule)
+      continue;
+
+    // Most vendor fleets publish the full state of every robot at a high rate
+    // even when nothing is changing, so we skip any robot whose state has not
+    // changed since we last looked at it.
+    const auto robot_fingerprint = fingerprint(robot);
+    if (entry.fingerprint == robot_fingerprint && entry.last_processed
+      && now - *entry.last_processed < _unchanged_refresh_period)
+      continue;
+
+    if (update_robot(robot, insertion.first, now))
+    {
+      entry.fingerprint = robot_fingerprint;
+      entry.last_processed = now;
+    }
   }
 }
 
+//==============================================================================
+uint64_t FleetAdapterNode::fingerprint(const RobotState& state) const
+{
+  uint64_t seed = 0;
+  const auto combine = [&seed](const std::size_t h)
+    {
+      seed ^= h + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+    };
+
+  const auto quantize = [](const double value, const double tolerance)
+    {
+      if (tolerance <= 0.0)
+        return std::hash<double>()(value);
+
+      return std::hash<int64_t>()(
+        static_cast<int64_t>(std::llround(value/tolerance)));
+    };
+
+  const auto& l = state.location;
+  combine(quantize(l.x, _position_tolerance));
+  combine(quantize(l.y, _position_tolerance));
+  combine(quantize(l.yaw, _yaw_tolerance));
+  combine(std::hash<std::string>()(l.level_name));
+  combine(std::hash<uint32_t>()(state.mode.mode));
+
+  // The path is hashed exactly, because handle_delay(~) treats any change to
+  // it as a new path.
+  combine(std::hash<std::size_t>()(state.path.size()));
+  for (const auto& p : state.path)
+  {
+    combine(std::hash<double>()(p.x));
+    combine(std::hash<double>()(p.y));
+    combine(std::hash<double>()(p.yaw));
+  }
+
+  return seed;
+}
+
 //==============================================================================
 void FleetAdapterNode::push_route(
   const RobotState& state,
@@ -213,7 +308,10 @@ void FleetAdapterNode::push_route(
     it->second->path.push_back(location);
 
   it->second->cumulative_delay = std::chrono::seconds(0);
-  it->second->route = make_route(state, _traits, it->second->sitting);
+  it->second->route = rmf_traffic::Route{
+    state.location.level_name,
+    it->second->trajectory_builder.build(state, _traits, it->second->sitting)
+  };
   it->second->schedule->push_routes({*it->second->route});
 }
 
@@ -230,14 +328,31 @@ void FleetAdapterNode::register_robot(
 }
 
 //==============================================================================
-void FleetAdapterNode::update_robot(
+bool FleetAdapterNode::update_robot(
   const RobotState& state,
-  const ScheduleEntries::iterator& it)
+  const ScheduleEntries::iterator& it,
+  const rmf_traffic::Time now)
 {
-  if (handle_delay(state, it))
-    return;
+  auto& entry = *it->second;
+
+  // Once we know that the route needs replacing, handle_delay(~) cannot be
+  // trusted anymore because it has already taken in the new path.
+  if (!entry.route_pending && handle_delay(state, it))
+    return true;
+
+  if (entry.route && entry.last_route_push
+    && now - *entry.last_route_push < _route_push_period)
+  {
+    // Leave the route on the schedule as it is for now. A later state will
+    // push the new route once the rate limit allows it.
+    entry.route_pending = true;
+    return false;
+  }
 
   push_route(state, it);
+  entry.last_route_push = now;
+  entry.route_pending = false;
+  return true;
 }
 
 //==============================================================================
@@ -276,7 +391,7 @@ bool FleetAdapterNode::handle_delay(
     entry.path.push_back(location);
 
   bool sitting = false;
-  auto new_trajectory = make_trajectory(state, _traits, sitting);
+  auto new_trajectory = entry.trajectory_builder.build(state, _traits, sitting);
 
   if (entry.sitting && sitting)
   {
@@ -26,6 +26,7 @@
 
 #include <rclcpp/node.hpp>
 
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -34,6 +35,7 @@
 #include <rmf_traffic_ros2/schedule/MirrorManager.hpp>
 
 #include "../rmf_fleet_adapter/ScheduleManager.hpp"
+#include "../rmf_fleet_adapter/make_trajectory.hpp"
 
 namespace rmf_fleet_adapter {
 namespace read_only {
@@ -59,6 +61,18 @@ private:
 
   rmf_traffic::Duration _delay_threshold;
 
+  /// Robot states that fall within these tolerances of the last processed
+  /// state are considered unchanged
+  double _position_tolerance;
+  double _yaw_tolerance;
+
+  /// How often an unchanged robot state still gets processed, so that the
+  /// schedule can keep up with robots that are sitting still or stuck
+  rmf_traffic::Duration _unchanged_refresh_period;
+
+  /// The minimum time between two route pushes for the same robot
+  rmf_traffic::Duration _route_push_period;
+
   using FleetState = rmf_fleet_msgs::msg::FleetState;
   rclcpp::Subscription<FleetState>::SharedPtr _fleet_state_subscription;
 
@@ -74,9 +88,22 @@ private:
     rmf_utils::optional<ScheduleManager> schedule;
     std::vector<Location> path;
     rmf_utils::optional<rmf_traffic::Route> route;
+
+    /// Keeps the interpolated segments of the path between robot states
+    TrajectoryBuilder trajectory_builder;
+
     rmf_traffic::Duration cumulative_delay = rmf_traffic::Duration(0);
     bool sitting = false;
 
+    /// A fingerprint of the last robot state that was processed
+    std::optional<uint64_t> fingerprint;
+    std::optional<rmf_traffic::Time> last_processed;
+    std::optional<rmf_traffic::Time> last_route_push;
+
+    /// True if a new route needs to be pushed, but the push was held back by
+    /// the rate limit
+    bool route_pending = false;
+
     ScheduleEntry(
       FleetAdapterNode* node,
       std::string name,
@@ -97,9 +124,14 @@ private:
     const RobotState& state,
     const ScheduleEntries::iterator& it);
 
-  void update_robot(
+  /// Returns false if the update could not be applied yet, because pushing its
+  /// route is being rate limited.
+  bool update_robot(
     const RobotState& state,
-    const ScheduleEntries::iterator& it);
+    const ScheduleEntries::iterator& it,
+    rmf_traffic::Time now);
+
+  uint64_t fingerprint(const RobotState& state) const;
 
   bool handle_delay(
     const RobotState& state,
@@ -35,6 +35,9 @@
 
 #include "../rmf_fleet_adapter/make_trajectory.hpp"
 
+#include <cmath>
+#include <limits>
+
 namespace rmf_fleet_adapter {
 namespace read_only_blockade {
 
@@ -57,7 +60,11 @@ std::shared_ptr<FleetAdapterNode> FleetAdapterNode::make()
     return nullptr;
   }
 
-  auto graph = rmf_fleet_adapter::agv::parse_graph(graph_file, node->_traits);
+  const std::string graph_cache_directory =
+    node->declare_parameter("nav_graph_cache_directory", std::string());
+
+  auto graph = rmf_fleet_adapter::agv::parse_graph(
+    graph_file, node->_traits, graph_cache_directory);
   auto planner = rmf_traffic::agv::Planner(
     rmf_traffic::agv::Planner::Configuration(std::move(graph), node->_traits),
     rmf_traffic::agv::Planner::Options(nullptr)
@@ -279,6 +286,7 @@ void FleetAdapterNode::update_robot(
       robot->current_goal = std::nullopt;
       robot->schedule->set(make_hold(state, now));
       robot->blockade.cancel();
+      robot->reserved_path = std::nullopt;
       return;
     }
     else if (robot->current_goal.value() == state.task_id
@@ -297,6 +305,7 @@ void FleetAdapterNode::update_robot(
   {
     // It doesn't hurt to make sure we're not blockading anything
     robot->blockade.cancel();
+    robot->reserved_path = std::nullopt;
     robot->expectation = std::nullopt;
 
     if (state.task_id.empty())
@@ -402,6 +411,68 @@ FleetAdapterNode::Robot::Expectation convert_to_expectation(
   };
 }
 
+//==============================================================================
+/// Plans are reused for starts that are within these tolerances of each other
+const double PlanKeyPositionTolerance = 0.25;
+const double PlanKeyYawTolerance = 10.0*M_PI/180.0;
+
+//==============================================================================
+std::vector<int64_t> make_plan_key(
+  const std::string& map_name,
+  const std::vector<rmf_traffic::agv::Plan::Start>& starts,
+  const std::size_t goal)
+{
+  const auto quantize = [](const double value, const double tolerance)
+    {
+      return static_cast<int64_t>(std::llround(value/tolerance));
+    };
+
+  std::vector<int64_t> key;
+  key.reserve(2 + 6*starts.size());
+  key.push_back(static_cast<int64_t>(std::hash<std::string>()(map_name)));
+  key.push_back(static_cast<int64_t>(goal));
+  for (const auto& start : starts)
+  {
+    key.push_back(static_cast<int64_t>(start.waypoint()));
+    key.push_back(
+      start.lane().has_value() ? static_cast<int64_t>(*start.lane()) : -1);
+    key.push_back(quantize(start.orientation(), PlanKeyYawTolerance));
+    if (start.location().has_value())
+    {
+      key.push_back(quantize(start.location()->x(), PlanKeyPositionTolerance));
+      key.push_back(quantize(start.location()->y(), PlanKeyPositionTolerance));
+    }
+    else
+    {
+      // Mark the absence of a location so it cannot be mistaken for one
+      key.push_back(std::numeric_limits<int64_t>::min());
+      key.push_back(std::numeric_limits<int64_t>::min());
+    }
+  }
+
+  return key;
+}
+
+//==============================================================================
+bool same_path(
+  const std::vector<rmf_traffic::blockade::Writer::Checkpoint>& a,
+  const std::vector<rmf_traffic::blockade::Writer::Checkpoint>& b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    if (a[i].map_name != b[i].map_name || a[i].can_hold != b[i].can_hold)
+      return false;
+
+    if ((a[i].position - b[i].position).norm() > 1e-3)
+      return false;
+  }
+
+  return true;
+}
+
 //==============================================================================
 void add_offset_itinerary(
   rmf_traffic::Duration offset,
@@ -464,67 +535,150 @@ void FleetAdapterNode::make_plan(
     return;
   }
 
-  const auto result = _connect->planner.plan(starts, goal_wp->index());
-  if (!result.success())
+  // Vendor robots often re-report the same few paths, so we look for a plan
+  // that was already found from the same start to the same goal.
+  const auto key = make_plan_key(location.level_name, starts, goal_wp->index());
+  auto cached = find_cached_plan(key);
+  if (!cached)
   {
-    std::stringstream ss;
-    ss << "Unable to find a plan for [" << state.name << "] for fleet ["
-       << _fleet_name << "] to navigate from map [" << location.level_name
-       << "], position (" << location.x << ", " << location.y << ") to the "
-       << "waypoint named [" << state.task_id << "], graph index ["
-       << goal_wp->index() << "]";
+    const auto result = _connect->planner.plan(starts, goal_wp->index());
+    if (!result.success())
+    {
+      std::stringstream ss;
+      ss << "Unable to find a plan for [" << state.name << "] for fleet ["
+         << _fleet_name << "] to navigate from map [" << location.level_name
+         << "], position (" << location.x << ", " << location.y << ") to the "
+         << "waypoint named [" << state.task_id << "], graph index ["
+         << goal_wp->index() << "]";
+
+      RCLCPP_ERROR(get_logger(), "%s", ss.str().c_str());
+      return;
+    }
 
-    RCLCPP_ERROR(get_logger(), "%s", ss.str().c_str());
-    return;
+    auto plan = std::make_shared<CachedPlan>(CachedPlan{now, std::nullopt, {}});
+    if (result->get_waypoints().size() >= 2)
+    {
+      auto expectation = convert_to_expectation(*result, state, graph);
+      if (expectation.path.size() > 1)
+      {
+        auto original = result->get_itinerary();
+        const auto& last_wp = original.back().trajectory().back();
+        original.back().trajectory().insert(
+          last_wp.time() + std::chrono::seconds(60),
+          last_wp.position(),
+          Eigen::Vector3d::Zero());
+
+        auto itinerary = original;
+        add_offset_itinerary(std::chrono::seconds(5), original, itinerary);
+        add_offset_itinerary(std::chrono::seconds(10), original, itinerary);
+        add_offset_itinerary(std::chrono::seconds(15), original, itinerary);
+        add_offset_itinerary(std::chrono::seconds(20), original, itinerary);
+
+        plan->expectation = std::move(expectation);
+        plan->itinerary = std::move(itinerary);
+      }
+    }
+
+    cached = plan;
+    cache_plan(key, std::move(plan));
   }
 
-  if (result->get_waypoints().size() < 2)
+  if (!cached->expectation.has_value())
   {
-    // TODO(MXG): Refactor this condition with the one down below
     // We don't actually need to go anywhere
     robot.schedule->set(make_hold(state, now));
     robot.blockade.cancel();
+    robot.reserved_path = std::nullopt;
     robot.expectation = std::nullopt;
     robot.current_goal = std::nullopt;
     return;
   }
 
-  robot.expectation = convert_to_expectation(*result, state, graph);
+  // The cached plan may have been made for an earlier time, so shift it to
+  // start from now.
+  const auto shift = now - cached->planned_at;
+  robot.expectation = *cached->expectation;
+  for (auto& t : robot.expectation->timing)
+    t += shift;
 
-  if (robot.expectation->path.size() == 1)
+  auto itinerary = cached->itinerary;
+  for (auto& route : itinerary)
   {
-    // We don't actually need to go anywhere
-    robot.schedule->set(make_hold(state, now));
-    robot.blockade.cancel();
-    robot.expectation = std::nullopt;
-    robot.current_goal = std::nullopt;
-    return;
+    if (route.trajectory().size() > 0)
+      route.trajectory().front().adjust_times(shift);
   }
 
-  auto original = result->get_itinerary();
-  const auto& last_wp = original.back().trajectory().back();
-  original.back().trajectory().insert(
-    last_wp.time() + std::chrono::seconds(60),
-    last_wp.position(),
-    Eigen::Vector3d::Zero());
+  robot.schedule->set(std::move(itinerary));
 
-  auto itinerary = original;
-  add_offset_itinerary(std::chrono::seconds(5), original, itinerary);
-  add_offset_itinerary(std::chrono::seconds(10), original, itinerary);
-  add_offset_itinerary(std::chrono::seconds(15), original, itinerary);
-  add_offset_itinerary(std::chrono::seconds(20), original, itinerary);
+  // If the robot is still at the start of the reservation that it already has
+  // for this same path, then there is no need to make a new reservation.
+  const bool reuse_reservation = robot.reserved_path.has_value()
+    && robot.blockade.last_reached() == 0
+    && same_path(*robot.reserved_path, robot.expectation->path);
 
-  robot.schedule->set(std::move(itinerary));
-  robot.blockade.set(robot.expectation->path);
+  if (!reuse_reservation)
+  {
+    robot.blockade.set(robot.expectation->path);
+    robot.reserved_path = robot.expectation->path;
 
-  // Immediately report that all checkpoints are ready. This will (hopefully)
-  // block all traffic light robots from trying to enter our space.
-  for (std::size_t i = 0; i < robot.blockade.path().size(); ++i)
-    robot.blockade.ready(i);
+    // Immediately report that all checkpoints are ready. This will (hopefully)
+    // block all traffic light robots from trying to enter our space.
+    for (std::size_t i = 0; i < robot.blockade.path().size(); ++i)
+      robot.blockade.ready(i);
+  }
 
   robot.current_goal = state.task_id;
 }
 
+//==============================================================================
+std::size_t FleetAdapterNode::PlanKeyHash::operator()(
+  const PlanKey& key) const
+{
+  std::size_t seed = key.size();
+  for (const auto value : key)
+  {
+    seed ^= std::hash<int64_t>()(value)
+      + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+
+  return seed;
+}
+
+//==============================================================================
+auto FleetAdapterNode::find_cached_plan(const PlanKey& key)
+-> std::shared_ptr<const CachedPlan>
+{
+  const auto it = _plan_cache.find(key);
+  if (it == _plan_cache.end())
+    return nullptr;
+
+  _plan_lru.splice(_plan_lru.begin(), _plan_lru, it->second);
+  return it->second->second;
+}
+
+//==============================================================================
+void FleetAdapterNode::cache_plan(
+  PlanKey key,
+  std::shared_ptr<const CachedPlan> plan)
+{
+  const auto it = _plan_cache.find(key);
+  if (it != _plan_cache.end())
+  {
+    it->second->second = std::move(plan);
+    _plan_lru.splice(_plan_lru.begin(), _plan_lru, it->second);
+    return;
+  }
+
+  _plan_lru.emplace_front(key, std::move(plan));
+  _plan_cache.insert({std::move(key), _plan_lru.begin()});
+
+  while (_plan_lru.size() > _plan_cache_capacity)
+  {
+    _plan_cache.erase(_plan_lru.back().first);
+    _plan_lru.pop_back();
+  }
+}
+
 //==============================================================================
 std::optional<std::size_t> FleetAdapterNode::get_last_reached(
   const FleetAdapterNode::RobotState& state,
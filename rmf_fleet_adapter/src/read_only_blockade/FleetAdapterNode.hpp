@@ -11,6 +11,7 @@
 
 #include <rclcpp/node.hpp>
 
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -51,6 +52,10 @@ public:
     std::optional<Expectation> expectation;
 
     std::optional<std::string> current_goal;
+
+    /// The path of the blockade reservation that is currently active, if any
+    std::optional<std::vector<rmf_traffic::blockade::Writer::Checkpoint>>
+    reserved_path = std::nullopt;
   };
 
 private:
@@ -85,6 +90,37 @@ private:
 
   std::optional<Connections> _connect;
 
+  /// A plan that was found for a robot, kept for any robot that later needs a
+  /// plan from the same start to the same goal
+  struct CachedPlan
+  {
+    /// The time that the plan was made for
+    rmf_traffic::Time planned_at;
+
+    /// The expectation for the robot, or std::nullopt if the robot does not
+    /// need to move
+    std::optional<Robot::Expectation> expectation;
+
+    /// The itinerary to put on the schedule, including its offset shadows
+    std::vector<rmf_traffic::Route> itinerary;
+  };
+
+  using PlanKey = std::vector<int64_t>;
+  struct PlanKeyHash
+  {
+    std::size_t operator()(const PlanKey& key) const;
+  };
+
+  using PlanLRU =
+    std::list<std::pair<PlanKey, std::shared_ptr<const CachedPlan>>>;
+  PlanLRU _plan_lru;
+  std::unordered_map<PlanKey, PlanLRU::iterator, PlanKeyHash> _plan_cache;
+  const std::size_t _plan_cache_capacity = 32;
+
+  std::shared_ptr<const CachedPlan> find_cached_plan(const PlanKey& key);
+
+  void cache_plan(PlanKey key, std::shared_ptr<const CachedPlan> plan);
+
   using Robots = std::unordered_map<std::string, std::unique_ptr<Robot>>;
   Robots _robots;
 
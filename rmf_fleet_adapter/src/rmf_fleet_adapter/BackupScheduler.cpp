@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "BackupScheduler.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+class BackupScheduler::Shared
+  : public std::enable_shared_from_this<Shared>
+{
+public:
+
+  using Clock = rxcpp::schedulers::scheduler::clock_type;
+
+  Shared(std::string file_, std::chrono::nanoseconds interval_)
+  : file(std::move(file_)),
+    interval(interval_),
+    worker(rxcpp::schedulers::make_event_loop().create_worker())
+  {
+    // Do nothing
+  }
+
+  const std::string file;
+  const std::chrono::nanoseconds interval;
+
+  mutable std::mutex mutex;
+  std::optional<Stored> latest;
+  std::size_t pushed = 0;
+  std::size_t written = 0;
+  bool write_scheduled = false;
+  Clock::time_point last_write;
+
+  // Must be called while mutex is locked
+  void schedule_write()
+  {
+    if (file.empty() || write_scheduled)
+      return;
+
+    write_scheduled = true;
+    const auto when = std::max(
+      Clock::now(),
+      last_write + std::chrono::duration_cast<Clock::duration>(interval));
+
+    worker.schedule(
+      when,
+      [self = shared_from_this()](const auto&)
+      {
+        self->write();
+      });
+  }
+
+  void write()
+  {
+    std::optional<Stored> backup;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      write_scheduled = false;
+      last_write = Clock::now();
+      backup = latest;
+      ++written;
+    }
+
+    if (!backup.has_value())
+    {
+      std::remove(file.c_str());
+      return;
+    }
+
+    nlohmann::json json;
+    json["task_id"] = backup->task_id;
+    json["sequence"] = backup->sequence;
+    json["state"] = backup->state;
+
+    // Write to a temporary file first so that a crash in the middle of a write
+    // never leaves a corrupted backup behind.
+    const std::string tmp = file + ".tmp";
+    {
+      std::ofstream output(tmp, std::ios::trunc);
+      output << json.dump();
+      if (!output)
+        return;
+    }
+
+    std::rename(tmp.c_str(), file.c_str());
+  }
+
+private:
+  rxcpp::schedulers::worker worker;
+};
+
+//==============================================================================
+auto BackupScheduler::get_settings(rclcpp::Node& node) -> Settings
+{
+  const std::string interval_param = "task_backup_interval";
+  const std::string directory_param = "task_backup_directory";
+  if (!node.has_parameter(interval_param))
+    node.declare_parameter<double>(interval_param, 1.0);
+
+  if (!node.has_parameter(directory_param))
+    node.declare_parameter<std::string>(directory_param, "");
+
+  Settings settings;
+  settings.interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(
+      std::max(0.0, node.get_parameter(interval_param).as_double())));
+  settings.directory = node.get_parameter(directory_param).as_string();
+
+  return settings;
+}
+
+//==============================================================================
+auto BackupScheduler::load(const std::string& file) -> std::optional<Stored>
+{
+  std::ifstream input(file);
+  if (!input)
+    return std::nullopt;
+
+  try
+  {
+    const auto json = nlohmann::json::parse(input);
+    return Stored{
+      json.at("task_id").get<std::string>(),
+      json.at("sequence").get<uint64_t>(),
+      json.at("state").get<std::string>()
+    };
+  }
+  catch (const std::exception&)
+  {
+    return std::nullopt;
+  }
+}
+
+//==============================================================================
+BackupScheduler::BackupScheduler(
+  const std::string& group,
+  const std::string& name,
+  Settings settings)
+{
+  std::string file;
+  if (!settings.directory.empty())
+  {
+    std::string robot = group + "__" + name;
+    std::replace(robot.begin(), robot.end(), '/', '_');
+    file = settings.directory + "/" + robot + ".task_backup.json";
+  }
+
+  _shared = std::make_shared<Shared>(std::move(file), settings.interval);
+}
+
+//==============================================================================
+const std::string& BackupScheduler::file() const
+{
+  return _shared->file;
+}
+
+//==============================================================================
+void BackupScheduler::push(
+  std::string task_id,
+  rmf_task::Task::Active::Backup backup)
+{
+  std::lock_guard<std::mutex> lock(_shared->mutex);
+  _shared->latest = Stored{
+    std::move(task_id),
+    backup.sequence(),
+    backup.state()
+  };
+  ++_shared->pushed;
+  _shared->schedule_write();
+}
+
+//==============================================================================
+void BackupScheduler::clear(const std::string& task_id)
+{
+  std::lock_guard<std::mutex> lock(_shared->mutex);
+  if (!_shared->latest.has_value() || _shared->latest->task_id != task_id)
+    return;
+
+  _shared->latest = std::nullopt;
+  _shared->schedule_write();
+}
+
+//==============================================================================
+auto BackupScheduler::latest() const -> std::optional<Stored>
+{
+  std::lock_guard<std::mutex> lock(_shared->mutex);
+  return _shared->latest;
+}
+
+//==============================================================================
+std::size_t BackupScheduler::pushed() const
+{
+  std::lock_guard<std::mutex> lock(_shared->mutex);
+  return _shared->pushed;
+}
+
+//==============================================================================
+std::size_t BackupScheduler::written() const
+{
+  std::lock_guard<std::mutex> lock(_shared->mutex);
+  return _shared->written;
+}
+
+} // namespace rmf_fleet_adapter
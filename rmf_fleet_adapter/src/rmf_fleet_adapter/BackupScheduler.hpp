@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__BACKUPSCHEDULER_HPP
+#define SRC__RMF_FLEET_ADAPTER__BACKUPSCHEDULER_HPP
+
+#include <rmf_task/Task.hpp>
+
+#include <rclcpp/node.hpp>
+
+#include <rxcpp/rx.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+// Tasks can emit a new backup at every checkpoint, which happens many times
+// per second for complex composed tasks. This keeps the latest backup of a
+// robot's active task in memory, and writes it to disk off of the robot's
+// worker, at most once per interval, so a restarted adapter can find out which
+// task was interrupted and where.
+class BackupScheduler
+{
+public:
+
+  struct Settings
+  {
+    // Backups that arrive within this interval of the last write get combined
+    // into one write of the latest backup.
+    std::chrono::nanoseconds interval = std::chrono::seconds(1);
+
+    // Backups are written into this directory. If it is empty, backups are
+    // only kept in memory.
+    std::string directory;
+  };
+
+  // Read the settings from the task_backup_interval and task_backup_directory
+  // parameters of the node. These may be read by many schedulers, so they only
+  // get declared once.
+  static Settings get_settings(rclcpp::Node& node);
+
+  struct Stored
+  {
+    std::string task_id;
+    uint64_t sequence;
+    std::string state;
+  };
+
+  // Load a backup that was written by a BackupScheduler. Returns nullopt if
+  // the file does not exist or cannot be parsed.
+  static std::optional<Stored> load(const std::string& file);
+
+  // The backups of each robot go to their own file, named after the robot.
+  BackupScheduler(
+    const std::string& group,
+    const std::string& name,
+    Settings settings);
+
+  // The file that the backups get written to, or an empty string if they are
+  // only kept in memory.
+  const std::string& file() const;
+
+  // Replace the latest backup. This never blocks on writing to disk.
+  void push(std::string task_id, rmf_task::Task::Active::Backup backup);
+
+  // Forget the backup of this task because it has finished.
+  void clear(const std::string& task_id);
+
+  // The latest backup that was pushed. It may not be on disk yet.
+  std::optional<Stored> latest() const;
+
+  // How many backups have been pushed, and how many writes they were
+  // combined into.
+  std::size_t pushed() const;
+  std::size_t written() const;
+
+  class Shared;
+private:
+  std::shared_ptr<Shared> _shared;
+};
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__BACKUPSCHEDULER_HPP
@@ -17,17 +17,80 @@
 
 #include "BroadcastClient.hpp"
 
+#include "MemoryUsage.hpp"
 #include "agv/internal_FleetUpdateHandle.hpp"
 
+#include <algorithm>
+
 namespace rmf_fleet_adapter {
+//==============================================================================
+const std::string BroadcastClient::CborSubprotocol = "rmf.cbor";
+const std::string BroadcastClient::MessagePackSubprotocol = "rmf.msgpack";
+const std::string BroadcastClient::BatchSubprotocol = "rmf.batch";
+const std::string BroadcastClient::CborBatchSubprotocol = "rmf.cbor.batch";
+const std::string BroadcastClient::MessagePackBatchSubprotocol =
+  "rmf.msgpack.batch";
+const std::size_t BroadcastClient::MaxQueuedMessages = 1000;
+const std::size_t BroadcastClient::MaxBatchSize = 100;
+
+namespace {
+//==============================================================================
+// State updates only need their most recent value to be sent, so they are
+// keyed by what they describe. Other messages, like logs, get no key.
+std::optional<std::string> latest_value_key(const nlohmann::json& msg)
+{
+  const auto type_it = msg.find("type");
+  const auto data_it = msg.find("data");
+  if (type_it == msg.end() || !type_it->is_string() || data_it == msg.end())
+    return std::nullopt;
+
+  const auto& type = type_it->get_ref<const std::string&>();
+  const auto& data = *data_it;
+  try
+  {
+    if (type == "fleet_state_update")
+      return type + "/" + data.at("name").get<std::string>();
+
+    if (type == "task_state_update")
+      return type + "/" + data.at("booking").at("id").get<std::string>();
+  }
+  catch (const nlohmann::json::exception&)
+  {
+    // A malformed update simply gets queued like any other message
+  }
+
+  return std::nullopt;
+}
+} // anonymous namespace
+
 //==============================================================================
 std::shared_ptr<BroadcastClient> BroadcastClient::make(
   const std::string& uri,
-  std::weak_ptr<agv::FleetUpdateHandle> fleet_handle)
+  std::weak_ptr<agv::FleetUpdateHandle> fleet_handle,
+  const bool offer_compact_encoding,
+  const bool offer_batching)
 {
   std::shared_ptr<BroadcastClient> client(new BroadcastClient());
   client->_uri = std::move(uri);
   client->_fleet_handle = fleet_handle;
+
+  // Subprotocols are offered in the order that we prefer them
+  auto& offered = client->_offered_subprotocols;
+  if (offer_batching && offer_compact_encoding)
+  {
+    offered.push_back(CborBatchSubprotocol);
+    offered.push_back(MessagePackBatchSubprotocol);
+  }
+
+  if (offer_batching)
+    offered.push_back(BatchSubprotocol);
+
+  if (offer_compact_encoding)
+  {
+    offered.push_back(CborSubprotocol);
+    offered.push_back(MessagePackSubprotocol);
+  }
+
   client->_shutdown = false;
   client->_connected = false;
 
@@ -43,8 +106,26 @@ std::shared_ptr<BroadcastClient> BroadcastClient::make(
     });
 
   client->_client.set_open_handler(
-    [c = client](websocketpp::connection_hdl)
+    [c = client](websocketpp::connection_hdl hdl)
     {
+      // The server chooses the encoding by accepting one of the subprotocols
+      // that we offered
+      websocketpp::lib::error_code ec;
+      const auto con = c->_client.get_con_from_hdl(hdl, ec);
+      const std::string subprotocol = con ? con->get_subprotocol() : "";
+      if (subprotocol == CborSubprotocol
+        || subprotocol == CborBatchSubprotocol)
+        c->_encoding = Encoding::Cbor;
+      else if (subprotocol == MessagePackSubprotocol
+        || subprotocol == MessagePackBatchSubprotocol)
+        c->_encoding = Encoding::MessagePack;
+      else
+        c->_encoding = Encoding::Json;
+
+      c->_batching = subprotocol == BatchSubprotocol
+        || subprotocol == CborBatchSubprotocol
+        || subprotocol == MessagePackBatchSubprotocol;
+
       c->_connected = true;
       const auto fleet = c->_fleet_handle.lock();
       if (!fleet)
@@ -59,6 +140,17 @@ std::shared_ptr<BroadcastClient> BroadcastClient::make(
         impl.node->get_logger(),
         "BroadcastClient successfully connected to uri: [%s]",
         c->_uri.c_str());
+
+      const auto stats = c->queue_stats();
+      if (stats.dropped > 0)
+      {
+        RCLCPP_WARN(
+          impl.node->get_logger(),
+          "BroadcastClient has dropped %lu messages so far because its queue "
+          "was full. %lu state updates were replaced by newer ones and %lu "
+          "messages are waiting to be sent.",
+          stats.dropped, stats.replaced, stats.depth);
+      }
     });
 
   client->_client.set_close_handler(
@@ -91,6 +183,8 @@ std::shared_ptr<BroadcastClient> BroadcastClient::make(
           websocketpp::lib::error_code ec;
           WebsocketClient::connection_ptr con = c->_client.get_connection(
             c->_uri, ec);
+          for (const auto& subprotocol : c->_offered_subprotocols)
+            con->add_subprotocol(subprotocol, ec);
           c->_hdl = con->get_handle();
           c->_client.connect(con);
           // TOD(YV): Without sending a test payload, ec seems to be 0 even
@@ -122,12 +216,30 @@ std::shared_ptr<BroadcastClient> BroadcastClient::make(
           return !c->_queue.empty();
         });
 
-        while (!c->_queue.empty())
+        while (true)
         {
           std::lock_guard<std::mutex> lock(c->_queue_mutex);
+          if (c->_queue.empty())
+            break;
+
           websocketpp::lib::error_code ec;
-          const std::string& msg = c->_queue.front().dump();
-          c->_client.send(c->_hdl, msg, websocketpp::frame::opcode::text, ec);
+          std::size_t count = 1;
+          if (c->_batching)
+          {
+            // Drain whatever is waiting, up to the batch size, into one frame
+            count = std::min(MaxBatchSize, c->_queue.size());
+            auto batch = nlohmann::json::array();
+            auto it = c->_queue.begin();
+            for (std::size_t i = 0; i < count; ++i, ++it)
+              batch.push_back(it->msg);
+
+            c->_send(batch, ec);
+          }
+          else
+          {
+            c->_send(c->_queue.front().msg, ec);
+          }
+
           if (ec)
           {
             RCLCPP_ERROR(
@@ -136,7 +248,8 @@ std::shared_ptr<BroadcastClient> BroadcastClient::make(
             // TODO(YV): Check if we should re-connect to server
             break;
           }
-          c->_queue.pop();
+          for (std::size_t i = 0; i < count; ++i)
+            c->_pop();
         }
       }
     });
@@ -149,7 +262,7 @@ std::shared_ptr<BroadcastClient> BroadcastClient::make(
 void BroadcastClient::publish(const nlohmann::json& msg)
 {
   std::lock_guard<std::mutex> lock(_queue_mutex);
-  _queue.push(msg);
+  _push(msg);
   _cv.notify_all();
 }
 
@@ -158,10 +271,103 @@ void BroadcastClient::publish(const std::vector<nlohmann::json>& msgs)
 {
   std::lock_guard<std::mutex> lock(_queue_mutex);
   for (const auto& msg : msgs)
-    _queue.push(msg);
+    _push(msg);
   _cv.notify_all();
 }
 
+//==============================================================================
+auto BroadcastClient::queue_stats() const -> QueueStats
+{
+  std::lock_guard<std::mutex> lock(_queue_mutex);
+  auto stats = _stats;
+  stats.depth = _queue.size();
+  return stats;
+}
+
+//==============================================================================
+std::size_t BroadcastClient::approximate_queue_bytes() const
+{
+  std::lock_guard<std::mutex> lock(_queue_mutex);
+  std::size_t bytes = _fifo.size() * sizeof(Queue::iterator);
+  for (const auto& queued : _queue)
+  {
+    bytes += ContainerNodeBytes + sizeof(queued)
+      + approximate_bytes(queued.msg);
+    if (queued.key.has_value())
+    {
+      // The key is also held by the index of the latest state updates
+      bytes += ContainerNodeBytes + sizeof(std::string)
+        + sizeof(Queue::iterator) + 2 * approximate_bytes(*queued.key);
+    }
+  }
+
+  return bytes;
+}
+
+//==============================================================================
+void BroadcastClient::_send(
+  const nlohmann::json& payload,
+  websocketpp::lib::error_code& ec)
+{
+  const Encoding encoding = _encoding;
+  if (encoding == Encoding::Json)
+  {
+    _client.send(_hdl, payload.dump(), websocketpp::frame::opcode::text, ec);
+    return;
+  }
+
+  const std::vector<uint8_t> msg = encoding == Encoding::Cbor ?
+    nlohmann::json::to_cbor(payload) :
+    nlohmann::json::to_msgpack(payload);
+
+  _client.send(
+    _hdl, msg.data(), msg.size(), websocketpp::frame::opcode::binary, ec);
+}
+
+//==============================================================================
+void BroadcastClient::_push(const nlohmann::json& msg)
+{
+  auto key = latest_value_key(msg);
+  if (key.has_value())
+  {
+    const auto it = _latest.find(*key);
+    if (it != _latest.end())
+    {
+      // Keep the place in line of the update that is being replaced so that
+      // a steady stream of updates cannot starve it
+      it->second->msg = msg;
+      ++_stats.replaced;
+      return;
+    }
+
+    _queue.push_back({key, msg});
+    _latest.insert({std::move(*key), std::prev(_queue.end())});
+    return;
+  }
+
+  if (_fifo.size() >= MaxQueuedMessages)
+  {
+    _queue.erase(_fifo.front());
+    _fifo.pop_front();
+    ++_stats.dropped;
+  }
+
+  _queue.push_back({std::nullopt, msg});
+  _fifo.push_back(std::prev(_queue.end()));
+}
+
+//==============================================================================
+void BroadcastClient::_pop()
+{
+  const auto& front = _queue.front();
+  if (front.key.has_value())
+    _latest.erase(*front.key);
+  else
+    _fifo.pop_front();
+
+  _queue.pop_front();
+}
+
 //==============================================================================
 BroadcastClient::BroadcastClient()
 {
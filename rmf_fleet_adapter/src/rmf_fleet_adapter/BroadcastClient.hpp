@@ -25,9 +25,14 @@
 
 #include <rmf_fleet_adapter/agv/FleetUpdateHandle.hpp>
 
+#include <deque>
+#include <list>
 #include <memory>
+#include <optional>
 #include <set>
-#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
 #include <thread>
 #include <atomic>
@@ -46,11 +51,52 @@ public:
   using ConnectionHDL = websocketpp::connection_hdl;
   using Connections = std::set<ConnectionHDL, std::owner_less<ConnectionHDL>>;
 
+  // How messages get encoded before they are sent to the server
+  enum class Encoding
+  {
+    // JSON text frames
+    Json,
+
+    // CBOR binary frames
+    Cbor,
+
+    // MessagePack binary frames
+    MessagePack
+  };
+
+  // The websocket subprotocols that may be offered to the server. The server
+  // chooses how it receives messages by accepting one of them when the
+  // connection is opened. If it accepts none of them, every message is sent
+  // as its own JSON text frame.
+  //
+  //   rmf.cbor, rmf.msgpack
+  //     Every message is sent as its own CBOR or MessagePack binary frame.
+  //
+  //   rmf.batch, rmf.cbor.batch, rmf.msgpack.batch
+  //     Up to MaxBatchSize of the messages that are waiting to be sent go out
+  //     together as one frame that holds an array of messages, in the order
+  //     that they will be processed. rmf.batch frames are JSON text and the
+  //     others are CBOR or MessagePack binary frames.
+  static const std::string CborSubprotocol;
+  static const std::string MessagePackSubprotocol;
+  static const std::string BatchSubprotocol;
+  static const std::string CborBatchSubprotocol;
+  static const std::string MessagePackBatchSubprotocol;
+  static const std::size_t MaxBatchSize;
+
   /// \param[in] uri
   ///   "ws://localhost:9000"
+  ///
+  /// \param[in] offer_compact_encoding
+  ///   If true, offer the CBOR and MessagePack subprotocols to the server.
+  ///
+  /// \param[in] offer_batching
+  ///   If true, offer the batch subprotocols to the server.
   static std::shared_ptr<BroadcastClient> make(
     const std::string& uri,
-    std::weak_ptr<agv::FleetUpdateHandle> fleet_handle);
+    std::weak_ptr<agv::FleetUpdateHandle> fleet_handle,
+    bool offer_compact_encoding = false,
+    bool offer_batching = false);
 
   // Publish a single message
   void publish(const nlohmann::json& msg);
@@ -58,6 +104,30 @@ public:
   // Publish a vector of messages
   void publish(const std::vector<nlohmann::json>& msgs);
 
+  // Messages wait in a queue until they can be sent to the server. Only the
+  // latest fleet_state_update of each fleet and task_state_update of each task
+  // is kept in the queue, and at most MaxQueuedMessages other messages are
+  // kept, dropping the oldest ones first.
+  static const std::size_t MaxQueuedMessages;
+
+  struct QueueStats
+  {
+    // The number of messages waiting to be sent
+    std::size_t depth = 0;
+
+    // The number of messages that were replaced by a newer state update
+    // before they could be sent
+    uint64_t replaced = 0;
+
+    // The number of messages that were dropped because the queue was full
+    uint64_t dropped = 0;
+  };
+
+  QueueStats queue_stats() const;
+
+  // Approximately how many bytes the messages waiting in the queue are holding
+  std::size_t approximate_queue_bytes() const;
+
   ~BroadcastClient();
 
 private:
@@ -67,13 +137,35 @@ private:
   WebsocketClient _client;
   websocketpp::connection_hdl _hdl;
   std::mutex _wait_mutex;
-  std::mutex _queue_mutex;
+  mutable std::mutex _queue_mutex;
   std::condition_variable _cv;
-  std::queue<nlohmann::json> _queue;
+
+  // The caller must be holding _queue_mutex for these
+  void _push(const nlohmann::json& msg);
+  void _pop();
+
+  struct QueuedMessage
+  {
+    // Set for state updates that only need their latest value to be sent
+    std::optional<std::string> key;
+    nlohmann::json msg;
+  };
+
+  using Queue = std::list<QueuedMessage>;
+  Queue _queue;
+  std::unordered_map<std::string, Queue::iterator> _latest;
+  std::deque<Queue::iterator> _fifo;
+  QueueStats _stats;
   std::thread _processing_thread;
   std::thread _client_thread;
   std::atomic_bool _connected;
   std::atomic_bool _shutdown;
+  std::vector<std::string> _offered_subprotocols;
+  std::atomic<Encoding> _encoding = Encoding::Json;
+  std::atomic_bool _batching = false;
+
+  // Send one frame in the encoding that the server chose
+  void _send(const nlohmann::json& payload, websocketpp::lib::error_code& ec);
 };
 
 } // namespace rmf_fleet_adapter
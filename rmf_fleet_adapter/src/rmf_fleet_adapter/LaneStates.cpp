@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "LaneStates.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+std_msgs::msg::String convert(const LaneStateUpdate& update)
+{
+  nlohmann::json json;
+  json["fleet_name"] = update.fleet_name;
+  json["session"] = update.session;
+  json["sequence"] = update.sequence;
+  json["snapshot"] = update.snapshot;
+  json["open_lanes"] = update.open_lanes;
+  json["close_lanes"] = update.close_lanes;
+
+  std_msgs::msg::String msg;
+  msg.data = json.dump();
+  return msg;
+}
+
+//==============================================================================
+std::optional<LaneStateUpdate> convert(const std_msgs::msg::String& msg)
+{
+  try
+  {
+    const auto json = nlohmann::json::parse(msg.data);
+    LaneStateUpdate update;
+    update.fleet_name = json.at("fleet_name").get<std::string>();
+    update.session = json.at("session").get<uint64_t>();
+    update.sequence = json.at("sequence").get<uint64_t>();
+    update.snapshot = json.at("snapshot").get<bool>();
+    update.open_lanes = json.at("open_lanes").get<std::vector<std::size_t>>();
+    update.close_lanes = json.at("close_lanes").get<std::vector<std::size_t>>();
+    return update;
+  }
+  catch (const nlohmann::json::exception&)
+  {
+    return std::nullopt;
+  }
+}
+
+//==============================================================================
+LaneStateSequencer::LaneStateSequencer(const uint64_t session)
+: _session(session)
+{
+  // Do nothing
+}
+
+//==============================================================================
+std::optional<LaneStateUpdate> LaneStateSequencer::request(
+  const std::string& fleet_name,
+  const std::vector<std::size_t>& open_lanes,
+  const std::vector<std::size_t>& close_lanes)
+{
+  auto& state = _states[fleet_name];
+
+  // Closing takes precedence over opening, the same as in
+  // FleetUpdateHandle::change_lanes
+  const std::set<std::size_t> closing(close_lanes.begin(), close_lanes.end());
+  LaneStateUpdate update;
+  for (const auto& lane : open_lanes)
+  {
+    if (state.closed.count(lane) && !closing.count(lane))
+      update.open_lanes.push_back(lane);
+  }
+
+  for (const auto& lane : closing)
+  {
+    if (!state.closed.count(lane))
+      update.close_lanes.push_back(lane);
+  }
+
+  if (update.open_lanes.empty() && update.close_lanes.empty())
+    return std::nullopt;
+
+  std::sort(update.open_lanes.begin(), update.open_lanes.end());
+  update.open_lanes.erase(
+    std::unique(update.open_lanes.begin(), update.open_lanes.end()),
+    update.open_lanes.end());
+
+  for (const auto& lane : update.open_lanes)
+    state.closed.erase(lane);
+
+  state.closed.insert(update.close_lanes.begin(), update.close_lanes.end());
+
+  update.fleet_name = fleet_name;
+  update.session = _session;
+  update.sequence = ++state.sequence;
+  return update;
+}
+
+//==============================================================================
+LaneStateUpdate LaneStateSequencer::snapshot(
+  const std::string& fleet_name) const
+{
+  LaneStateUpdate update;
+  update.fleet_name = fleet_name;
+  update.session = _session;
+  update.snapshot = true;
+
+  const auto it = _states.find(fleet_name);
+  if (it != _states.end())
+  {
+    update.sequence = it->second.sequence;
+    update.close_lanes.assign(
+      it->second.closed.begin(), it->second.closed.end());
+  }
+
+  return update;
+}
+
+//==============================================================================
+std::vector<std::string> LaneStateSequencer::fleet_names() const
+{
+  std::vector<std::string> names;
+  names.reserve(_states.size());
+  for (const auto& [name, _] : _states)
+    names.push_back(name);
+
+  return names;
+}
+
+//==============================================================================
+LaneStateTracker::LaneStateTracker(std::string fleet_name)
+: _fleet_name(std::move(fleet_name))
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto LaneStateTracker::receive(const LaneStateUpdate& update)
+-> std::optional<Change>
+{
+  Channel* channel = nullptr;
+  if (update.fleet_name.empty())
+    channel = &_site;
+  else if (update.fleet_name == _fleet_name)
+    channel = &_fleet;
+  else
+    return std::nullopt;
+
+  const bool same_session = channel->session == update.session;
+  if (update.snapshot)
+  {
+    if (same_session && channel->sequence
+      && update.sequence <= *channel->sequence)
+    {
+      // We are already up to date with this snapshot
+      return std::nullopt;
+    }
+
+    channel->session = update.session;
+    channel->sequence = update.sequence;
+    channel->closed = std::set<std::size_t>(
+      update.close_lanes.begin(), update.close_lanes.end());
+  }
+  else
+  {
+    if (update.sequence == 1 && (!same_session || !channel->sequence))
+    {
+      // This is the first delta of the session, so it starts from a state
+      // where every lane is open
+      channel->session = update.session;
+      channel->sequence = 0;
+      channel->closed.clear();
+    }
+    else if (!same_session || !channel->sequence)
+    {
+      // We need a snapshot before we can make sense of any deltas
+      return std::nullopt;
+    }
+
+    if (update.sequence <= *channel->sequence)
+    {
+      // This is a repeat of a delta that was already applied
+      return std::nullopt;
+    }
+
+    if (update.sequence != *channel->sequence + 1)
+    {
+      // A delta was missed, so wait for the next snapshot
+      channel->sequence = std::nullopt;
+      return std::nullopt;
+    }
+
+    channel->sequence = update.sequence;
+    for (const auto& lane : update.open_lanes)
+      channel->closed.erase(lane);
+
+    channel->closed.insert(
+      update.close_lanes.begin(), update.close_lanes.end());
+  }
+
+  std::set<std::size_t> closed = _site.closed;
+  closed.insert(_fleet.closed.begin(), _fleet.closed.end());
+
+  Change change;
+  std::set_difference(
+    _closed.begin(), _closed.end(), closed.begin(), closed.end(),
+    std::back_inserter(change.open_lanes));
+  std::set_difference(
+    closed.begin(), closed.end(), _closed.begin(), _closed.end(),
+    std::back_inserter(change.close_lanes));
+
+  _closed = std::move(closed);
+  if (change.open_lanes.empty() && change.close_lanes.empty())
+    return std::nullopt;
+
+  return change;
+}
+
+//==============================================================================
+const std::set<std::size_t>& LaneStateTracker::closed_lanes() const
+{
+  return _closed;
+}
+
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__LANESTATES_HPP
+#define SRC__RMF_FLEET_ADAPTER__LANESTATES_HPP
+
+#include <std_msgs/msg/string.hpp>
+
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+/// A versioned change to the closed lanes of one fleet, or of every fleet when
+/// the fleet name is empty. These are published by the lane_state_server on
+/// the LaneStateUpdateTopicName topic as a JSON string.
+///
+/// Each fleet name has its own sequence of updates, which counts up by one for
+/// every delta. A snapshot carries the full set of closed lanes in close_lanes
+/// along with the sequence number of the latest delta, so that a listener
+/// which joined late or missed a delta can catch up.
+struct LaneStateUpdate
+{
+  std::string fleet_name;
+
+  /// Chosen randomly each time the server starts, so listeners can tell when
+  /// the sequence numbers have been restarted
+  uint64_t session = 0;
+
+  uint64_t sequence = 0;
+  bool snapshot = false;
+  std::vector<std::size_t> open_lanes;
+  std::vector<std::size_t> close_lanes;
+};
+
+//==============================================================================
+std_msgs::msg::String convert(const LaneStateUpdate& update);
+
+//==============================================================================
+/// Returns std::nullopt if the message is not a valid lane state update
+std::optional<LaneStateUpdate> convert(const std_msgs::msg::String& msg);
+
+//==============================================================================
+/// Assigns sequence numbers to lane closure requests and keeps the latest
+/// state of every fleet name so that snapshots can be produced.
+class LaneStateSequencer
+{
+public:
+
+  LaneStateSequencer(uint64_t session);
+
+  /// Record a request. Returns the delta that should be published, or
+  /// std::nullopt if the request does not change anything.
+  std::optional<LaneStateUpdate> request(
+    const std::string& fleet_name,
+    const std::vector<std::size_t>& open_lanes,
+    const std::vector<std::size_t>& close_lanes);
+
+  /// Get a snapshot of the current state of one fleet name
+  LaneStateUpdate snapshot(const std::string& fleet_name) const;
+
+  /// Get the fleet names that have received any requests
+  std::vector<std::string> fleet_names() const;
+
+private:
+
+  struct State
+  {
+    uint64_t sequence = 0;
+    std::set<std::size_t> closed;
+  };
+
+  uint64_t _session;
+  std::map<std::string, State> _states;
+};
+
+//==============================================================================
+/// Follows the lane state updates that apply to one fleet and works out how
+/// the lanes of the fleet need to change. The site-wide closures and those of
+/// the fleet are tracked separately, and a lane is closed if either of them
+/// closes it.
+///
+/// A delta is only applied if it immediately follows the last update that was
+/// received for its fleet name, or if it is the first delta of a session.
+/// After a gap, deltas are ignored until the next snapshot arrives.
+class LaneStateTracker
+{
+public:
+
+  struct Change
+  {
+    std::vector<std::size_t> open_lanes;
+    std::vector<std::size_t> close_lanes;
+  };
+
+  LaneStateTracker(std::string fleet_name);
+
+  /// Receive an update. Returns the change that should be applied to the
+  /// fleet, or std::nullopt if nothing needs to change.
+  std::optional<Change> receive(const LaneStateUpdate& update);
+
+  /// The lanes that are closed according to the updates so far
+  const std::set<std::size_t>& closed_lanes() const;
+
+private:
+
+  struct Channel
+  {
+    std::optional<uint64_t> session;
+    std::optional<uint64_t> sequence;
+    std::set<std::size_t> closed;
+  };
+
+  std::string _fleet_name;
+  Channel _site;
+  Channel _fleet;
+  std::set<std::size_t> _closed;
+};
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__LANESTATES_HPP
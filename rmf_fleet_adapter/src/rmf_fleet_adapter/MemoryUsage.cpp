@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "MemoryUsage.hpp"
+
+namespace rmf_fleet_adapter {
+
+namespace {
+//==============================================================================
+// A trajectory keeps each of its waypoints in a list node, along with its time,
+// position, velocity and an entry in an index that is ordered by time.
+constexpr std::size_t TrajectoryWaypointBytes = 128;
+} // anonymous namespace
+
+//==============================================================================
+std::size_t total(const MemoryUsage& usage)
+{
+  std::size_t bytes = 0;
+  for (const auto& [_, component] : usage)
+    bytes += component;
+
+  return bytes;
+}
+
+//==============================================================================
+void accumulate(MemoryUsage& into, const MemoryUsage& from)
+{
+  for (const auto& [name, bytes] : from)
+    into[name] += bytes;
+}
+
+//==============================================================================
+std::size_t approximate_bytes(const std::string& s)
+{
+  // Short strings are stored inside of the std::string itself
+  const std::string empty;
+  return s.capacity() > empty.capacity() ? s.capacity() + 1 : 0;
+}
+
+//==============================================================================
+std::size_t approximate_bytes(const nlohmann::json& json)
+{
+  switch (json.type())
+  {
+    case nlohmann::json::value_t::object:
+    {
+      const auto& object = json.get_ref<const nlohmann::json::object_t&>();
+      std::size_t bytes = sizeof(object);
+      for (const auto& [key, value] : object)
+      {
+        bytes += ContainerNodeBytes + sizeof(key) + approximate_bytes(key)
+          + sizeof(value) + approximate_bytes(value);
+      }
+
+      return bytes;
+    }
+    case nlohmann::json::value_t::array:
+    {
+      const auto& array = json.get_ref<const nlohmann::json::array_t&>();
+      std::size_t bytes = sizeof(array) + approximate_bytes(array);
+      for (const auto& value : array)
+        bytes += approximate_bytes(value);
+
+      return bytes;
+    }
+    case nlohmann::json::value_t::string:
+    {
+      const auto& s = json.get_ref<const nlohmann::json::string_t&>();
+      return sizeof(s) + approximate_bytes(s);
+    }
+    case nlohmann::json::value_t::binary:
+    {
+      const auto& binary = json.get_ref<const nlohmann::json::binary_t&>();
+      return sizeof(binary) + binary.capacity();
+    }
+    default:
+      // Every other type is stored inside of the json value itself
+      return 0;
+  }
+}
+
+//==============================================================================
+std::size_t approximate_bytes(const rmf_traffic::Route& route)
+{
+  return sizeof(route) + approximate_bytes(route.map())
+    + TrajectoryWaypointBytes * route.trajectory().size();
+}
+
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__MEMORYUSAGE_HPP
+#define SRC__RMF_FLEET_ADAPTER__MEMORYUSAGE_HPP
+
+#include <rmf_traffic/Route.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+// The approximate number of bytes that each component of an object is holding
+// on to, keyed by the name of the component. These are estimates based on the
+// sizes of the containers and what they hold, not measurements of the heap, so
+// they leave out allocator overhead and anything that is hidden behind another
+// library's API.
+using MemoryUsage = std::map<std::string, std::size_t>;
+
+// The bookkeeping of one node in a std::map, std::set, std::list or
+// std::unordered_map, on top of the value that it holds
+constexpr std::size_t ContainerNodeBytes = 4 * sizeof(void*);
+
+//==============================================================================
+// Add up every component of a report
+std::size_t total(const MemoryUsage& usage);
+
+//==============================================================================
+// Add the components of one report into another
+void accumulate(MemoryUsage& into, const MemoryUsage& from);
+
+//==============================================================================
+std::size_t approximate_bytes(const std::string& s);
+
+//==============================================================================
+std::size_t approximate_bytes(const nlohmann::json& json);
+
+//==============================================================================
+std::size_t approximate_bytes(const rmf_traffic::Route& route);
+
+//==============================================================================
+template<typename T>
+std::size_t approximate_bytes(const std::vector<T>& v)
+{
+  return v.capacity() * sizeof(T);
+}
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__MEMORYUSAGE_HPP
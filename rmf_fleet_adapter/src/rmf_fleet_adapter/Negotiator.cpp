@@ -45,6 +45,13 @@ void Negotiator::respond(
     return;
   }
 
+  using namespace std::chrono_literals;
+  const auto wait_duration = 2s + table_viewer->sequence().back().version * 10s;
+
+  // Offer the best plan found so far before the negotiation timer runs out,
+  // and keep improving on it until then.
+  service->anytime(wait_duration / 2);
+
   auto negotiate_sub =
     rmf_rxcpp::make_job<services::Negotiate::Result>(service)
     .observe_on(rxcpp::identity_same_worker(_context->worker()))
@@ -54,7 +61,8 @@ void Negotiator::respond(
       if (auto self = w.lock())
       {
         result.respond();
-        self->_negotiate_services.erase(result.service);
+        if (!result.interim)
+          self->_negotiate_services.erase(result.service);
       }
       else
       {
@@ -67,8 +75,6 @@ void Negotiator::respond(
       }
     });
 
-  using namespace std::chrono_literals;
-  const auto wait_duration = 2s + table_viewer->sequence().back().version * 10s;
   auto negotiation_timer = _context->node()->try_create_wall_timer(
     wait_duration,
     [s = service->weak_from_this()]
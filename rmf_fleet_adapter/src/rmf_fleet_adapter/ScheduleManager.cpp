@@ -16,6 +16,7 @@
 */
 
 #include "ScheduleManager.hpp"
+#include "route_shape.hpp"
 
 #include <rmf_traffic_ros2/Trajectory.hpp>
 #include <rmf_traffic_ros2/StandardNames.hpp>
@@ -60,10 +61,41 @@ void ScheduleManager::push_routes(const std::vector<rmf_traffic::Route>& routes)
   // TODO(MXG): Consider putting some debug output here.
   if (valid_routes.empty())
   {
+    _shape_hashes.clear();
     _participant.clear();
     return;
   }
 
+  std::vector<std::size_t> hashes;
+  hashes.reserve(valid_routes.size());
+  for (const auto& r : valid_routes)
+    hashes.push_back(route_shape_hash(r));
+
+  // Replans and negotiations often produce the same itinerary that is already
+  // on the schedule, or the same one shifted in time. The hashes rule out most
+  // changed itineraries cheaply, and a full comparison confirms the rest.
+  const auto& current = _participant.itinerary();
+  if (hashes == _shape_hashes && current.size() == valid_routes.size())
+  {
+    std::optional<rmf_traffic::Duration> shift;
+    bool uniform = true;
+    for (std::size_t i = 0; i < current.size() && uniform; ++i)
+    {
+      const auto s = route_time_shift(*current[i].route, valid_routes[i]);
+      uniform = s.has_value() && (!shift.has_value() || *shift == *s);
+      shift = s;
+    }
+
+    if (uniform)
+    {
+      if (*shift != rmf_traffic::Duration(0))
+        _participant.delay(*shift);
+
+      return;
+    }
+  }
+
+  _shape_hashes = std::move(hashes);
   _participant.set(std::move(valid_routes));
 }
 
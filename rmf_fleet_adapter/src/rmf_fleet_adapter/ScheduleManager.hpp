@@ -79,6 +79,10 @@ private:
   rmf_traffic::schedule::Participant _participant;
   Negotiator* _negotiator;
   std::shared_ptr<void> _negotiator_handle;
+
+  // The route_shape_hash of each route that was last set on the schedule.
+  // Delays do not change these hashes.
+  std::vector<std::size_t> _shape_hashes;
 };
 
 //==============================================================================
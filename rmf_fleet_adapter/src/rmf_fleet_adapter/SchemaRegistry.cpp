@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "SchemaRegistry.hpp"
+
+#include <rclcpp/logging.hpp>
+
+#include <rmf_api_msgs/schemas/cancel_task_request.hpp>
+#include <rmf_api_msgs/schemas/cancel_task_response.hpp>
+#include <rmf_api_msgs/schemas/dispatch_task_response.hpp>
+#include <rmf_api_msgs/schemas/error.hpp>
+#include <rmf_api_msgs/schemas/fleet_state.hpp>
+#include <rmf_api_msgs/schemas/fleet_state_update.hpp>
+#include <rmf_api_msgs/schemas/interrupt_task_request.hpp>
+#include <rmf_api_msgs/schemas/interrupt_task_response.hpp>
+#include <rmf_api_msgs/schemas/kill_task_request.hpp>
+#include <rmf_api_msgs/schemas/kill_task_response.hpp>
+#include <rmf_api_msgs/schemas/location_2D.hpp>
+#include <rmf_api_msgs/schemas/log_entry.hpp>
+#include <rmf_api_msgs/schemas/resume_task_request.hpp>
+#include <rmf_api_msgs/schemas/resume_task_response.hpp>
+#include <rmf_api_msgs/schemas/rewind_task_request.hpp>
+#include <rmf_api_msgs/schemas/rewind_task_response.hpp>
+#include <rmf_api_msgs/schemas/robot_state.hpp>
+#include <rmf_api_msgs/schemas/robot_task_request.hpp>
+#include <rmf_api_msgs/schemas/robot_task_response.hpp>
+#include <rmf_api_msgs/schemas/simple_response.hpp>
+#include <rmf_api_msgs/schemas/skip_phase_request.hpp>
+#include <rmf_api_msgs/schemas/skip_phase_response.hpp>
+#include <rmf_api_msgs/schemas/task_log.hpp>
+#include <rmf_api_msgs/schemas/task_log_update.hpp>
+#include <rmf_api_msgs/schemas/task_request.hpp>
+#include <rmf_api_msgs/schemas/task_state.hpp>
+#include <rmf_api_msgs/schemas/task_state_update.hpp>
+#include <rmf_api_msgs/schemas/token_response.hpp>
+#include <rmf_api_msgs/schemas/undo_skip_phase_request.hpp>
+#include <rmf_api_msgs/schemas/undo_skip_phase_response.hpp>
+#include <rmf_fleet_adapter/schemas/cancel_tasks_request.hpp>
+#include <rmf_fleet_adapter/schemas/task_log_request.hpp>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+SchemaRegistry& SchemaRegistry::get()
+{
+  static SchemaRegistry registry;
+  return registry;
+}
+
+//==============================================================================
+const nlohmann::json* SchemaRegistry::find(const std::string& url) const
+{
+  const auto it = _schemas.find(url);
+  if (it == _schemas.end())
+    return nullptr;
+
+  return &it->second;
+}
+
+//==============================================================================
+auto SchemaRegistry::loader() const -> const Loader&
+{
+  return _loader;
+}
+
+//==============================================================================
+auto SchemaRegistry::validator(const nlohmann::json& schema)
+-> const Validator&
+{
+  const auto id = schema["$id"].get<std::string>();
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& validator = _validators[id];
+  if (!validator)
+    validator = std::make_unique<Validator>(schema, _loader);
+
+  return *validator;
+}
+
+//==============================================================================
+SchemaRegistry::SchemaRegistry()
+{
+  const std::vector<nlohmann::json> schemas = {
+    rmf_api_msgs::schemas::task_state,
+    rmf_api_msgs::schemas::task_log,
+    rmf_api_msgs::schemas::log_entry,
+    rmf_api_msgs::schemas::task_state_update,
+    rmf_api_msgs::schemas::task_log_update,
+    rmf_api_msgs::schemas::simple_response,
+    rmf_api_msgs::schemas::token_response,
+    rmf_api_msgs::schemas::cancel_task_request,
+    rmf_api_msgs::schemas::cancel_task_response,
+    rmf_api_msgs::schemas::kill_task_request,
+    rmf_api_msgs::schemas::kill_task_response,
+    rmf_api_msgs::schemas::interrupt_task_request,
+    rmf_api_msgs::schemas::interrupt_task_response,
+    rmf_api_msgs::schemas::resume_task_request,
+    rmf_api_msgs::schemas::resume_task_response,
+    rmf_api_msgs::schemas::rewind_task_request,
+    rmf_api_msgs::schemas::rewind_task_response,
+    rmf_api_msgs::schemas::robot_task_request,
+    rmf_api_msgs::schemas::dispatch_task_response,
+    rmf_api_msgs::schemas::error,
+    rmf_api_msgs::schemas::robot_task_response,
+    rmf_api_msgs::schemas::skip_phase_request,
+    rmf_api_msgs::schemas::skip_phase_response,
+    rmf_api_msgs::schemas::task_request,
+    rmf_api_msgs::schemas::undo_skip_phase_request,
+    rmf_api_msgs::schemas::undo_skip_phase_response,
+    rmf_api_msgs::schemas::fleet_state_update,
+    rmf_api_msgs::schemas::fleet_state,
+    rmf_api_msgs::schemas::robot_state,
+    rmf_api_msgs::schemas::location_2D,
+    rmf_fleet_adapter::schemas::cancel_tasks_request,
+    rmf_fleet_adapter::schemas::task_log_request
+  };
+
+  for (const auto& schema : schemas)
+  {
+    const auto json_uri = nlohmann::json_uri{schema["$id"]};
+    _schemas.insert({json_uri.url(), schema});
+  }
+
+  _loader = [this](const nlohmann::json_uri& id, nlohmann::json& value)
+    {
+      const auto* schema = find(id.url());
+      if (!schema)
+      {
+        RCLCPP_ERROR(
+          rclcpp::get_logger("rmf_fleet_adapter"),
+          "url: %s not found in schema dictionary", id.url().c_str());
+        return;
+      }
+
+      value = *schema;
+    };
+}
+
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__SCHEMAREGISTRY_HPP
+#define SRC__RMF_FLEET_ADAPTER__SCHEMAREGISTRY_HPP
+
+#include <nlohmann/json.hpp>
+#include <nlohmann/json-schema.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+// One process-wide set of the standard API schemas that the fleet handles and
+// task managers validate their messages against. The schemas never change
+// after the registry is made, so every fleet and robot shares this single
+// copy of them, along with a single compiled validator for each schema.
+class SchemaRegistry
+{
+public:
+
+  using Loader =
+    std::function<void(const nlohmann::json_uri&, nlohmann::json&)>;
+  using Validator = nlohmann::json_schema::json_validator;
+
+  // Get the registry of this process
+  static SchemaRegistry& get();
+
+  // Get the schema with this url, or a nullptr if it is not registered
+  const nlohmann::json* find(const std::string& url) const;
+
+  // A loader that resolves references to the registered schemas
+  const Loader& loader() const;
+
+  // Get the validator for this schema. It gets compiled the first time that
+  // any fleet or robot asks for it.
+  const Validator& validator(const nlohmann::json& schema);
+
+private:
+
+  SchemaRegistry();
+
+  std::unordered_map<std::string, nlohmann::json> _schemas;
+  Loader _loader;
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, std::unique_ptr<Validator>> _validators;
+};
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__SCHEMAREGISTRY_HPP
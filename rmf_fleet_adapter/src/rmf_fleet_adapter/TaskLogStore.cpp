@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "TaskLogStore.hpp"
+#include "MemoryUsage.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace rmf_fleet_adapter {
+
+namespace {
+//==============================================================================
+int64_t entry_time(const nlohmann::json& entry)
+{
+  const auto it = entry.find("unix_millis_time");
+  if (it == entry.end() || !it->is_number_integer())
+    return 0;
+
+  return it->get<int64_t>();
+}
+
+//==============================================================================
+void append_entry(
+  nlohmann::json& logs,
+  const std::string& phase,
+  const std::string& event,
+  nlohmann::json entry)
+{
+  logs["phases"][phase]["events"][event].push_back(std::move(entry));
+}
+} // anonymous namespace
+
+//==============================================================================
+auto TaskLogStore::get_settings(rclcpp::Node& node) -> Settings
+{
+  const std::string entries_param = "task_log_max_entries";
+  const std::string age_param = "task_log_max_age";
+  const std::string directory_param = "task_log_spill_directory";
+  if (!node.has_parameter(entries_param))
+    node.declare_parameter<int64_t>(entries_param, 0);
+
+  if (!node.has_parameter(age_param))
+    node.declare_parameter<double>(age_param, 0.0);
+
+  if (!node.has_parameter(directory_param))
+    node.declare_parameter<std::string>(directory_param, "");
+
+  Settings settings;
+  settings.max_entries = static_cast<std::size_t>(
+    std::max<int64_t>(0, node.get_parameter(entries_param).as_int()));
+  settings.max_age = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::duration<double>(
+      std::max(0.0, node.get_parameter(age_param).as_double())));
+  settings.spill_directory = node.get_parameter(directory_param).as_string();
+
+  return settings;
+}
+
+//==============================================================================
+TaskLogStore::TaskLogStore(Settings settings)
+: _settings(std::move(settings))
+{
+  // Do nothing
+}
+
+//==============================================================================
+void TaskLogStore::append(const nlohmann::json& new_logs)
+{
+  const auto task_id = new_logs.at("task_id").get<std::string>();
+  const auto phases_it = new_logs.find("phases");
+  if (phases_it == new_logs.end())
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& log = _logs[task_id];
+  log.json["task_id"] = task_id;
+  auto& all_phase_logs = log.json["phases"];
+  for (const auto& phase : phases_it->items())
+  {
+    const auto events_it = phase.value().find("events");
+    if (events_it == phase.value().end())
+      continue;
+
+    auto& all_event_logs = all_phase_logs[phase.key()]["events"];
+    for (const auto& event : events_it->items())
+    {
+      auto& entries = all_event_logs[event.key()];
+      for (const auto& entry : event.value())
+      {
+        const auto time = entry_time(entry);
+        if (log.entries == 0)
+        {
+          log.oldest_millis = time;
+          log.newest_millis = time;
+        }
+        else
+        {
+          log.oldest_millis = std::min(log.oldest_millis, time);
+          log.newest_millis = std::max(log.newest_millis, time);
+        }
+
+        entries.push_back(entry);
+        ++log.entries;
+      }
+    }
+  }
+
+  _enforce(task_id, log);
+}
+
+//==============================================================================
+std::vector<nlohmann::json> TaskLogStore::in_memory() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<nlohmann::json> logs;
+  logs.reserve(_logs.size());
+  for (const auto& [_, log] : _logs)
+    logs.push_back(log.json);
+
+  return logs;
+}
+
+//==============================================================================
+std::optional<nlohmann::json> TaskLogStore::fetch(
+  const std::string& task_id) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _logs.find(task_id);
+  if (it == _logs.end())
+    return std::nullopt;
+
+  nlohmann::json full;
+  full["task_id"] = task_id;
+
+  // The spilled entries are older than the ones in memory, so they go first
+  if (!_settings.spill_directory.empty())
+  {
+    std::ifstream spilled(_spill_file(task_id));
+    std::string line;
+    while (std::getline(spilled, line))
+    {
+      const auto record = nlohmann::json::parse(line, nullptr, false);
+      if (record.is_discarded())
+        continue;
+
+      append_entry(
+        full,
+        record["phase"].get<std::string>(),
+        record["event"].get<std::string>(),
+        record["entry"]);
+    }
+  }
+
+  const auto phases_it = it->second.json.find("phases");
+  if (phases_it != it->second.json.end())
+  {
+    for (const auto& phase : phases_it->items())
+    {
+      for (const auto& event : phase.value().at("events").items())
+      {
+        for (const auto& entry : event.value())
+          append_entry(full, phase.key(), event.key(), entry);
+      }
+    }
+  }
+
+  return full;
+}
+
+//==============================================================================
+void TaskLogStore::erase(const std::string& task_id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _logs.erase(task_id);
+  if (!_settings.spill_directory.empty())
+    std::remove(_spill_file(task_id).c_str());
+}
+
+//==============================================================================
+std::size_t TaskLogStore::approximate_bytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t bytes = 0;
+  for (const auto& [task_id, log] : _logs)
+  {
+    bytes += ContainerNodeBytes + sizeof(task_id) + sizeof(log)
+      + rmf_fleet_adapter::approximate_bytes(task_id)
+      + rmf_fleet_adapter::approximate_bytes(log.json);
+  }
+
+  return bytes;
+}
+
+//==============================================================================
+void TaskLogStore::_enforce(const std::string& task_id, TaskLog& log)
+{
+  const bool too_many =
+    _settings.max_entries > 0 && log.entries > _settings.max_entries;
+
+  const int64_t max_age = _settings.max_age.count();
+  const int64_t cutoff = log.newest_millis - max_age;
+  const bool too_old = max_age > 0 && log.oldest_millis < cutoff;
+
+  if (!too_many && !too_old)
+    return;
+
+  struct Entry
+  {
+    int64_t time;
+    std::string phase;
+    std::string event;
+    nlohmann::json* list;
+    std::size_t index;
+  };
+
+  std::vector<Entry> entries;
+  entries.reserve(log.entries);
+  auto& phases = log.json["phases"];
+  for (auto& phase : phases.items())
+  {
+    for (auto& event : phase.value()["events"].items())
+    {
+      auto& list = event.value();
+      for (std::size_t i = 0; i < list.size(); ++i)
+      {
+        entries.push_back(
+          {entry_time(list[i]), phase.key(), event.key(), &list, i});
+      }
+    }
+  }
+
+  std::stable_sort(
+    entries.begin(), entries.end(),
+    [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+  std::size_t evict = 0;
+  if (too_many)
+    evict = entries.size() - _settings.max_entries * 3 / 4;
+
+  if (too_old)
+  {
+    const auto first_kept = std::find_if(
+      entries.begin(), entries.end(),
+      [cutoff](const Entry& e) { return e.time >= cutoff; });
+    evict = std::max<std::size_t>(evict, first_kept - entries.begin());
+  }
+
+  if (!_settings.spill_directory.empty())
+  {
+    std::ofstream spill(_spill_file(task_id), std::ios::app);
+    for (std::size_t i = 0; i < evict; ++i)
+    {
+      const auto& e = entries[i];
+      nlohmann::json record;
+      record["phase"] = e.phase;
+      record["event"] = e.event;
+      record["entry"] = (*e.list)[e.index];
+      spill << record.dump() << '\n';
+    }
+  }
+
+  // Entries get logged in order, so the evicted entries of each event are at
+  // the front of its list.
+  std::unordered_map<nlohmann::json*, std::size_t> evicted_from;
+  for (std::size_t i = 0; i < evict; ++i)
+    ++evicted_from[entries[i].list];
+
+  for (const auto& [list, count] : evicted_from)
+    list->erase(list->begin(), list->begin() + count);
+
+  for (auto phase = phases.begin(); phase != phases.end(); )
+  {
+    auto& events = (*phase)["events"];
+    for (auto event = events.begin(); event != events.end(); )
+    {
+      if (event->empty())
+        event = events.erase(event);
+      else
+        ++event;
+    }
+
+    if (events.empty())
+      phase = phases.erase(phase);
+    else
+      ++phase;
+  }
+
+  log.entries -= evict;
+  log.oldest_millis = evict < entries.size() ?
+    entries[evict].time : log.newest_millis;
+}
+
+//==============================================================================
+std::string TaskLogStore::_spill_file(const std::string& task_id) const
+{
+  std::string name = task_id;
+  std::replace(name.begin(), name.end(), '/', '_');
+  return _settings.spill_directory + "/" + name + ".log.jsonl";
+}
+
+} // namespace rmf_fleet_adapter
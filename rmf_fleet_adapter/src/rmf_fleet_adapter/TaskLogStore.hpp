@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__TASKLOGSTORE_HPP
+#define SRC__RMF_FLEET_ADAPTER__TASKLOGSTORE_HPP
+
+#include <rclcpp/node.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+// Keeps the task_log.json of every task that a TaskManager is responsible for,
+// so the full logs can be sent whenever the BroadcastClient reconnects. Long
+// tasks can log a lot, so a retention policy can bound how many entries of
+// each task stay in memory. The entries that fall outside of it are appended
+// to a spill file on disk, one line per entry, from where they can still be
+// fetched on demand.
+class TaskLogStore
+{
+public:
+
+  struct Settings
+  {
+    // Keep at most this many entries of each task in memory. When the limit is
+    // reached, the oldest quarter of them get spilled at once, so spilling
+    // does not happen on every update. Zero means there is no limit.
+    std::size_t max_entries = 0;
+
+    // Entries that are older than this, compared to the newest entry of their
+    // task, get spilled. Zero means there is no limit.
+    std::chrono::milliseconds max_age = std::chrono::milliseconds(0);
+
+    // The directory that spilled entries are written to. If it is empty, the
+    // entries outside of the retention policy are discarded.
+    std::string spill_directory;
+  };
+
+  // Read the settings from the task_log_max_entries, task_log_max_age and
+  // task_log_spill_directory parameters of the node. These may be read by
+  // many stores, so they only get declared once.
+  static Settings get_settings(rclcpp::Node& node);
+
+  TaskLogStore(Settings settings);
+
+  // Add the entries of the data field of a task_log_update message
+  void append(const nlohmann::json& new_logs);
+
+  // The in-memory logs of every task, as data for task_log_update messages
+  std::vector<nlohmann::json> in_memory() const;
+
+  // The full log of a task, including the entries that were spilled to disk.
+  // Returns nullopt if nothing has been logged for this task.
+  std::optional<nlohmann::json> fetch(const std::string& task_id) const;
+
+  // Forget the logs of a task, including any that were spilled
+  void erase(const std::string& task_id);
+
+  // Approximately how many bytes the in-memory logs are holding
+  std::size_t approximate_bytes() const;
+
+private:
+
+  struct TaskLog
+  {
+    nlohmann::json json;
+    std::size_t entries = 0;
+    int64_t oldest_millis = 0;
+    int64_t newest_millis = 0;
+  };
+
+  // Must be called while _mutex is locked
+  void _enforce(const std::string& task_id, TaskLog& log);
+
+  std::string _spill_file(const std::string& task_id) const;
+
+  Settings _settings;
+  mutable std::mutex _mutex;
+  std::unordered_map<std::string, TaskLog> _logs;
+};
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__TASKLOGSTORE_HPP
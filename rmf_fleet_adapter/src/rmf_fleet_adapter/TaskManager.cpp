@@ -36,6 +36,7 @@
 
 #include "phases/ResponsiveWait.hpp"
 #include "events/EmergencyPullover.hpp"
+#include "tracing.hpp"
 
 #include <rmf_api_msgs/schemas/task_state_update.hpp>
 #include <rmf_api_msgs/schemas/task_state.hpp>
@@ -59,6 +60,8 @@
 #include <rmf_api_msgs/schemas/task_state.hpp>
 #include <rmf_api_msgs/schemas/error.hpp>
 #include <rmf_api_msgs/schemas/robot_task_response.hpp>
+#include <rmf_fleet_adapter/schemas/cancel_tasks_request.hpp>
+#include <rmf_fleet_adapter/schemas/task_log_request.hpp>
 #include <rmf_api_msgs/schemas/skip_phase_request.hpp>
 #include <rmf_api_msgs/schemas/skip_phase_response.hpp>
 #include <rmf_api_msgs/schemas/task_request.hpp>
@@ -66,6 +69,8 @@
 #include <rmf_api_msgs/schemas/undo_skip_phase_response.hpp>
 #include <rmf_api_msgs/schemas/error.hpp>
 
+#include <cmath>
+
 namespace rmf_fleet_adapter {
 
 //==============================================================================
@@ -80,6 +85,14 @@ TaskManagerPtr TaskManager::make(
       std::move(broadcast_client),
       std::move(fleet_handle)));
 
+  mgr->_validators = std::make_shared<ValidatorCache>(
+    ValidatorCache::get_settings(*mgr->_context->node()));
+
+  // The BroadcastClient may ask for the task logs from its own thread as soon
+  // as it connects, so the store must exist before anything can call back.
+  mgr->_task_logs = std::make_shared<TaskLogStore>(
+    TaskLogStore::get_settings(*mgr->_context->node()));
+
   auto begin_pullover = [w = mgr->weak_from_this()]()
     {
       const auto self = w.lock();
@@ -135,94 +148,103 @@ TaskManagerPtr TaskManager::make(
       }
     });
 
-  mgr->_task_timer = mgr->context()->node()->try_create_wall_timer(
-    std::chrono::seconds(1),
-    [w = mgr->weak_from_this()]()
+  // Check whether the robot should retreat to its charger each time its
+  // battery drains by another percent.
+  mgr->_retreat_check_soc = mgr->_context->current_battery_soc();
+  mgr->_battery_soc_sub = mgr->_context->observe_battery_soc()
+    .observe_on(rxcpp::identity_same_worker(mgr->_context->worker()))
+    .subscribe(
+    [w = mgr->weak_from_this()](double battery_soc)
     {
-      if (auto mgr = w.lock())
-      {
-        mgr->_begin_next_task();
-      }
+      const auto mgr = w.lock();
+      if (!mgr)
+        return;
+
+      if (std::abs(battery_soc - mgr->_retreat_check_soc) < 0.01)
+        return;
+
+      mgr->_retreat_check_soc = battery_soc;
+      mgr->retreat_to_charger();
     });
 
-  mgr->_retreat_timer = mgr->context()->node()->try_create_wall_timer(
-    std::chrono::seconds(10),
-    [w = mgr->weak_from_this()]()
+  // The robot already shows up in the schedule and in the fleet state. The
+  // rest of its startup happens in a later job on its worker, so that adding
+  // many robots at once does not hold up the first fleet state.
+  mgr->_context->worker().schedule(
+    [w = mgr->weak_from_this()](const auto&)
     {
-      if (auto mgr = w.lock())
-      {
-        mgr->retreat_to_charger();
-      }
+      if (const auto self = w.lock())
+        self->_finish_startup();
     });
 
-  mgr->_begin_waiting();
+  return mgr;
+}
+
+//==============================================================================
+void TaskManager::_finish_startup()
+{
+  if (_started)
+    return;
+
+  _started = true;
 
-  // TODO(MXG): The tests allow a task manager to be created before a task
-  // planner is available. To deal with that we'll skip making the
-  // travel_estimator here. This code is unsound and the flow of object
-  // construction and inter-dependencies should be improved.
-  if (mgr->_context->task_planner())
+  const auto& backups = _backup_scheduler();
+  if (!backups.file().empty())
   {
-    mgr->_travel_estimator = std::make_shared<rmf_task::TravelEstimator>(
-      mgr->_context->task_planner()->configuration().parameters());
+    if (const auto previous = BackupScheduler::load(backups.file()))
+    {
+      RCLCPP_WARN(
+        _context->node()->get_logger(),
+        "Found a backup of task [%s] for robot [%s] from checkpoint [%lu] in "
+        "[%s]. The task was interrupted by a previous run of the fleet adapter "
+        "and needs to be dispatched again.",
+        previous->task_id.c_str(),
+        _context->requester_id().c_str(),
+        previous->sequence,
+        backups.file().c_str());
+    }
   }
 
-  mgr->_update_timer = mgr->_context->node()->try_create_wall_timer(
-    std::chrono::milliseconds(100),
-    [w = mgr->weak_from_this()]()
+  // A task may have been given to the robot before its startup finished
+  if (!_active_task && !_waiting)
+    _begin_waiting();
+
+  // Tasks begin when the queue changes, when the previous task finishes, or
+  // when the next task is due, so this is only a safety poll.
+  _task_timer = _context->node()->try_create_wall_timer(
+    std::chrono::seconds(10),
+    [w = weak_from_this()]()
     {
-      if (const auto self = w.lock())
-        self->_consider_publishing_updates();
+      if (auto mgr = w.lock())
+      {
+        mgr->_begin_next_task();
+        mgr->retreat_to_charger();
+      }
     });
 
-  mgr->_task_request_api_sub = mgr->_context->node()->task_api_request()
-    .observe_on(rxcpp::identity_same_worker(mgr->_context->worker()))
-    .subscribe(
-    [w = mgr->weak_from_this()](
-      const rmf_task_msgs::msg::ApiRequest::SharedPtr& request)
+  // Task state changes get published as they happen. This timer is the
+  // heartbeat for anyone who missed the last change.
+  _update_timer = _context->node()->try_create_wall_timer(
+    std::chrono::milliseconds(500),
+    [w = weak_from_this()]()
     {
       if (const auto self = w.lock())
-        self->_handle_request(request->json_msg, request->request_id);
+        self->_consider_publishing_updates();
     });
+}
 
-  const std::vector<nlohmann::json> schemas = {
-    rmf_api_msgs::schemas::task_state,
-    rmf_api_msgs::schemas::task_log,
-    rmf_api_msgs::schemas::log_entry,
-    rmf_api_msgs::schemas::task_state_update,
-    rmf_api_msgs::schemas::task_log_update,
-    rmf_api_msgs::schemas::simple_response,
-    rmf_api_msgs::schemas::token_response,
-    rmf_api_msgs::schemas::cancel_task_request,
-    rmf_api_msgs::schemas::cancel_task_response,
-    rmf_api_msgs::schemas::kill_task_request,
-    rmf_api_msgs::schemas::kill_task_response,
-    rmf_api_msgs::schemas::interrupt_task_request,
-    rmf_api_msgs::schemas::interrupt_task_response,
-    rmf_api_msgs::schemas::resume_task_request,
-    rmf_api_msgs::schemas::resume_task_response,
-    rmf_api_msgs::schemas::rewind_task_request,
-    rmf_api_msgs::schemas::rewind_task_response,
-    rmf_api_msgs::schemas::robot_task_request,
-    rmf_api_msgs::schemas::dispatch_task_response,
-    rmf_api_msgs::schemas::task_state,
-    rmf_api_msgs::schemas::error,
-    rmf_api_msgs::schemas::robot_task_response,
-    rmf_api_msgs::schemas::skip_phase_request,
-    rmf_api_msgs::schemas::skip_phase_response,
-    rmf_api_msgs::schemas::task_request,
-    rmf_api_msgs::schemas::undo_skip_phase_request,
-    rmf_api_msgs::schemas::undo_skip_phase_response,
-    rmf_api_msgs::schemas::error
-  };
-
-  for (const auto& schema : schemas)
+//==============================================================================
+BackupScheduler& TaskManager::_backup_scheduler()
+{
+  if (!_backups.has_value())
   {
-    const auto json_uri = nlohmann::json_uri{schema["$id"]};
-    mgr->_schema_dictionary.insert({json_uri.url(), schema});
+    _backups.emplace(
+      _context->group(),
+      _context->name(),
+      BackupScheduler::get_settings(*_context->node()));
   }
 
-  return mgr;
+  return *_backups;
 }
 
 //==============================================================================
@@ -332,11 +354,33 @@ nlohmann::json log_to_json(const rmf_task::Log::Entry& entry)
   return output;
 }
 
+//==============================================================================
+/// The reader only gives back strings that have changed since it last read
+/// them, so the string that was already published gets reused otherwise.
+void copy_versioned_string(
+  nlohmann::json& output,
+  const rmf_task::VersionedString::View& view,
+  rmf_task::VersionedString::Reader& reader)
+{
+  const auto changed = reader.read(view);
+  if (changed)
+  {
+    output = *changed;
+  }
+  else if (output.is_null())
+  {
+    // The message was reset since this string was last read, e.g. because a
+    // new task began, so we need to read it again.
+    output = *rmf_task::VersionedString::Reader().read(view);
+  }
+}
+
 //==============================================================================
 nlohmann::json& copy_phase_data(
   nlohmann::json& phases,
   const rmf_task::Phase::Active& snapshot,
   rmf_task::Log::Reader& reader,
+  rmf_task::VersionedString::Reader& string_reader,
   nlohmann::json& all_phase_logs)
 {
   const auto& tag = *snapshot.tag();
@@ -358,10 +402,6 @@ nlohmann::json& copy_phase_data(
   std::vector<rmf_task::Event::ConstStatePtr> event_queue;
   event_queue.push_back(snapshot.final_event());
 
-  auto& phase_logs = all_phase_logs[std::to_string(id)];
-  auto& event_logs = phase_logs["events"];
-  event_logs = std::unordered_map<std::string, std::vector<nlohmann::json>>();
-
   while (!event_queue.empty())
   {
     const auto top = event_queue.back();
@@ -371,20 +411,20 @@ nlohmann::json& copy_phase_data(
     event_state["id"] = top->id();
     event_state["status"] = status_to_string(top->status());
 
-    // TODO(MXG): Keep a VersionedString Reader to know when to actually update
-    // this string
-    event_state["name"] =
-      *rmf_task::VersionedString::Reader().read(top->name());
-
-    event_state["detail"] =
-      *rmf_task::VersionedString::Reader().read(top->detail());
+    copy_versioned_string(event_state["name"], top->name(), string_reader);
+    copy_versioned_string(event_state["detail"], top->detail(), string_reader);
 
+    // The reader only gives back the entries that it has not read before, so
+    // only new log entries get published.
     std::vector<nlohmann::json> logs;
     for (const auto& log : reader.read(top->log()))
       logs.push_back(log_to_json(log));
 
     if (!logs.empty())
-      event_logs[std::to_string(top->id())] = std::move(logs);
+    {
+      all_phase_logs[std::to_string(id)]["events"][std::to_string(top->id())] =
+        std::move(logs);
+    }
 
     std::vector<uint32_t> deps;
     deps.reserve(top->dependencies().size());
@@ -488,20 +528,38 @@ void TaskManager::ActiveTask::publish_task_state(TaskManager& mgr)
   task_logs["task_id"] = booking.id();
   auto& phase_logs = task_logs["phases"];
 
+  // Only the phases that were completed since the last update need to be
+  // copied. If the task was rewound, the phases that were completed after the
+  // rewind point are copied again.
+  const auto& completed_phases = _task->completed_phases();
+  std::size_t unchanged = 0;
+  while (unchanged < _published_completed.size()
+    && unchanged < completed_phases.size()
+    && _published_completed[unchanged] == completed_phases[unchanged])
+  {
+    ++unchanged;
+  }
+  _published_completed.resize(unchanged);
+
   std::vector<uint64_t> completed_ids;
-  completed_ids.reserve(_task->completed_phases().size());
-  for (const auto& completed : _task->completed_phases())
+  completed_ids.reserve(completed_phases.size());
+  for (std::size_t i = 0; i < completed_phases.size(); ++i)
   {
+    const auto& completed = completed_phases[i];
     const auto& snapshot = completed->snapshot();
+    completed_ids.push_back(snapshot->tag()->id());
+    if (i < unchanged)
+      continue;
+
     auto& phase = copy_phase_data(
-      phases, *snapshot, mgr._log_reader, phase_logs);
+      phases, *snapshot, mgr._log_reader, mgr._string_reader, phase_logs);
     phase["unix_millis_start_time"] =
       to_millis(completed->start_time().time_since_epoch()).count();
 
     phase["unix_millis_finish_time"] =
       to_millis(completed->finish_time().time_since_epoch()).count();
 
-    completed_ids.push_back(snapshot->tag()->id());
+    _published_completed.push_back(completed);
   }
   _state_msg["completed"] = std::move(completed_ids);
 
@@ -509,7 +567,8 @@ void TaskManager::ActiveTask::publish_task_state(TaskManager& mgr)
   if (active_phase == nullptr)
     return;
   auto& active =
-    copy_phase_data(phases, *active_phase, mgr._log_reader, phase_logs);
+    copy_phase_data(
+    phases, *active_phase, mgr._log_reader, mgr._string_reader, phase_logs);
   if (_task->active_phase_start_time().has_value())
   {
     active["unix_millis_start_time"] =
@@ -554,15 +613,23 @@ void TaskManager::ActiveTask::publish_task_state(TaskManager& mgr)
 
   task_state_update["data"] = _state_msg;
 
-  static const auto task_update_validator =
+  const auto& task_update_validator =
     mgr._make_validator(rmf_api_msgs::schemas::task_state_update);
   mgr._validate_and_publish_websocket(task_state_update, task_update_validator);
 
+  if (phase_logs.is_null())
+  {
+    // Nothing new has been logged since the last update
+    return;
+  }
+
+  mgr._task_logs->append(task_logs);
+
   auto task_log_update = nlohmann::json();
   task_log_update["type"] = "task_log_update";
   task_log_update["data"] = task_logs;
 
-  static const auto log_update_validator =
+  const auto& log_update_validator =
     mgr._make_validator(rmf_api_msgs::schemas::task_log_update);
   mgr._validate_and_publish_websocket(task_log_update, log_update_validator);
 }
@@ -771,6 +838,7 @@ std::vector<std::string> TaskManager::ActiveTask::remove_skips(
 //==============================================================================
 std::optional<std::string> TaskManager::current_task_id() const
 {
+  std::lock_guard<std::mutex> lock(_mutex);
   if (_active_task)
     return _active_task.id();
 
@@ -778,36 +846,54 @@ std::optional<std::string> TaskManager::current_task_id() const
 }
 
 //==============================================================================
-auto TaskManager::get_queue() const -> const std::vector<Assignment>&
+auto TaskManager::get_queue() const -> std::vector<Assignment>
 {
+  std::lock_guard<std::mutex> lock(_mutex);
   return _queue;
 }
 
 //==============================================================================
-bool TaskManager::cancel_task_if_present(const std::string& task_id)
+bool TaskManager::has_task(const std::string& task_id) const
 {
+  std::lock_guard<std::mutex> lock(_mutex);
   if (_active_task && _active_task.id() == task_id)
-  {
-    _active_task.cancel({"DispatchRequest"}, _context->now());
     return true;
-  }
 
+  return _is_queued(task_id);
+}
+
+//==============================================================================
+bool TaskManager::cancel_task_if_present(const std::string& task_id)
+{
   std::lock_guard<std::mutex> lock(_mutex);
-  for (auto it = _queue.begin(); it != _queue.end(); ++it)
+  if (_active_task && _active_task.id() == task_id)
   {
-    if (it->request()->booking()->id() == task_id)
-    {
-      _queue.erase(it);
-      return true;
-    }
+    // The active task may only be touched by the worker of this robot, which
+    // might not be the worker that is calling this function.
+    _context->worker().schedule(
+      [w = weak_from_this(), task_id](const auto&)
+      {
+        const auto self = w.lock();
+        if (!self)
+          return;
+
+        if (self->_active_task && self->_active_task.id() == task_id)
+          self->_active_task.cancel({"DispatchRequest"}, self->_context->now());
+      });
+
+    return true;
   }
 
-  return false;
+  if (_dispatched_ids.count(task_id) == 0)
+    return false;
+
+  return _remove_queued_task(task_id);
 }
 
 //==============================================================================
 std::string TaskManager::robot_status() const
 {
+  std::lock_guard<std::mutex> lock(_mutex);
   if (!_active_task)
     return "idle";
 
@@ -868,11 +954,15 @@ void TaskManager::set_queue(
     {
       return;
     }
-    _queue = assignments;
+    _set_dispatched_queue(assignments);
     _publish_task_queue();
+    if (_active_task)
+      _plan_ahead();
   }
 
-  _begin_next_task();
+  // The fleet may be setting the queue from its own worker, so the next task
+  // must be started on the worker of this robot
+  _schedule_begin_next_task();
 }
 
 //==============================================================================
@@ -897,6 +987,7 @@ const std::vector<rmf_task::ConstRequestPtr> TaskManager::requests() const
 //==============================================================================
 TaskManager::RobotModeMsg TaskManager::robot_mode() const
 {
+  std::lock_guard<std::mutex> lock(_mutex);
   const auto mode = rmf_fleet_msgs::build<RobotModeMsg>()
     .mode(_active_task ?
       RobotModeMsg::MODE_IDLE :
@@ -910,13 +1001,14 @@ TaskManager::RobotModeMsg TaskManager::robot_mode() const
 std::vector<nlohmann::json> TaskManager::task_log_updates() const
 {
   std::vector<nlohmann::json> logs;
-  for (const auto& it : _task_logs)
+  const auto& validator =
+    _make_validator(rmf_api_msgs::schemas::task_log_update);
+  for (auto& log : _task_logs->in_memory())
   {
     nlohmann::json update_msg = _task_log_update_msg;
-    update_msg["data"] = it.second;
+    update_msg["data"] = std::move(log);
     std::string error = "";
-    if (_validate_json(
-        update_msg, rmf_api_msgs::schemas::task_log_update, error))
+    if (_validate_json(update_msg, validator, error))
     {
       logs.push_back(update_msg);
     }
@@ -941,14 +1033,13 @@ void TaskManager::_begin_next_task()
   if (_queue.empty() && _direct_queue.empty())
   {
     if (!_waiting)
+    {
       _begin_waiting();
 
-    return;
-  }
+      // The robot has just become idle, so it may need to charge
+      _schedule_retreat_to_charger();
+    }
 
-  if (_waiting)
-  {
-    _waiting->cancel();
     return;
   }
 
@@ -971,10 +1062,22 @@ void TaskManager::_begin_next_task()
   const rmf_traffic::Time now = rmf_traffic_ros2::convert(
     _context->node()->now());
 
+  if (_waiting)
+  {
+    // The robot keeps waiting responsively until the next task is due
+    if (now >= deployment_time)
+      _waiting->cancel();
+    else
+      _schedule_begin_next_task(deployment_time - now);
+
+    return;
+  }
+
   if (now >= deployment_time)
   {
     // Update state in RobotContext and Assign active task
     const auto& id = assignment.request()->booking()->id();
+    tracing::Span span("begin_task", id);
     _context->current_task_end_state(assignment.finish_state());
     _context->current_task_id(id);
     _active_task = ActiveTask::start(
@@ -983,15 +1086,12 @@ void TaskManager::_begin_next_task()
         _context->task_parameters(),
         *assignment.request(),
         _update_cb(),
-        _checkpoint_cb(),
+        _checkpoint_cb(id),
         _phase_finished_cb(),
         _task_finished(id)),
       _context->now());
 
-    if (is_next_task_direct)
-      _direct_queue.erase(_direct_queue.begin());
-    else
-      _queue.erase(_queue.begin());
+    _pop_next_assignment(is_next_task_direct);
 
     if (!_active_task)
     {
@@ -1005,12 +1105,7 @@ void TaskManager::_begin_next_task()
         info.category.c_str(),
         assignment.request()->booking()->id().c_str());
 
-      _context->worker().schedule(
-        [w = weak_from_this()](const auto&)
-        {
-          if (const auto self = w.lock())
-            self->_begin_next_task();
-        });
+      _schedule_begin_next_task();
 
       return;
     }
@@ -1023,12 +1118,157 @@ void TaskManager::_begin_next_task()
       _queue.size());
 
     _register_executed_task(_active_task.id());
+    _plan_ahead();
   }
   else
   {
     if (!_waiting)
       _begin_waiting();
+
+    _schedule_begin_next_task(deployment_time - now);
+  }
+}
+
+//==============================================================================
+void TaskManager::_schedule_begin_next_task(const rmf_traffic::Duration delay)
+{
+  // The delay is measured on the ROS clock, but the worker waits on the steady
+  // clock. They drift apart when simulation time runs faster or slower than
+  // real time, so in that case we check the ROS clock again every second.
+  auto wait = std::max(delay, rmf_traffic::Duration(0));
+  const auto sim_time_check = std::chrono::seconds(1);
+  if (wait > sim_time_check
+    && _context->node()->get_clock()->ros_time_is_active())
+  {
+    wait = sim_time_check;
+  }
+
+  using Clock = rxcpp::schedulers::scheduler::clock_type;
+  const auto when = Clock::now()
+    + std::chrono::duration_cast<Clock::duration>(wait);
+
+  // An earlier wakeup will check again when it happens, so there is no need
+  // to pile up more of them.
+  if (wait > rmf_traffic::Duration(0))
+  {
+    if (_next_task_wakeup.has_value() && *_next_task_wakeup <= when)
+      return;
+
+    _next_task_wakeup = when;
+  }
+
+  _context->worker().schedule(
+    when,
+    [w = weak_from_this(), when](const auto&)
+    {
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      if (self->_next_task_wakeup == when)
+        self->_next_task_wakeup = std::nullopt;
+
+      self->_begin_next_task();
+    });
+}
+
+//==============================================================================
+void TaskManager::_schedule_retreat_to_charger()
+{
+  _context->worker().schedule(
+    [w = weak_from_this()](const auto&)
+    {
+      if (const auto self = w.lock())
+      {
+        self->_retreat_check_soc = self->_context->current_battery_soc();
+        self->retreat_to_charger();
+      }
+    });
+}
+
+//==============================================================================
+namespace {
+std::optional<std::size_t> first_goal(
+  const rmf_task::Request& request,
+  const agv::RobotContext& context)
+{
+  using namespace rmf_task::requests;
+  const auto& description = request.description();
+  if (const auto d =
+    std::dynamic_pointer_cast<const Delivery::Description>(description))
+    return d->pickup_waypoint();
+
+  if (const auto d =
+    std::dynamic_pointer_cast<const Clean::Description>(description))
+    return d->start_waypoint();
+
+  if (const auto d =
+    std::dynamic_pointer_cast<const Loop::Description>(description))
+    return d->start_waypoint();
+
+  if (const auto d =
+    std::dynamic_pointer_cast<const Bookshelf::Description>(description))
+    return d->start_waypoint();
+
+  if (std::dynamic_pointer_cast<const ChargeBattery::Description>(description))
+    return context.dedicated_charger_wp();
+
+  // Composed tasks can begin with any kind of event, so we do not try to
+  // guess where they will go first.
+  return std::nullopt;
+}
+} // anonymous namespace
+
+//==============================================================================
+void TaskManager::_plan_ahead()
+{
+  _lookahead_sub = rmf_rxcpp::subscription_guard();
+  if (_lookahead_job)
+  {
+    _lookahead_job->discard();
+    _lookahead_job = nullptr;
   }
+
+  const Assignment* next = nullptr;
+  if (!_direct_queue.empty())
+    next = &_direct_queue.begin()->assignment;
+  else if (!_queue.empty())
+    next = &_queue.front();
+
+  if (!next)
+    return;
+
+  const auto& finish = _context->current_task_end_state();
+  const auto start_wp = finish.waypoint();
+  const auto start_time = finish.time();
+  if (!start_wp.has_value() || !start_time.has_value())
+    return;
+
+  const auto goal_wp = first_goal(*next->request(), *_context);
+  if (!goal_wp.has_value() || *goal_wp == *start_wp)
+    return;
+
+  const rmf_traffic::agv::Plan::Start start(
+    *start_time, *start_wp, finish.orientation().value_or(0.0));
+
+  _lookahead_job = std::make_shared<jobs::Planning>(
+    _context->planner(),
+    rmf_traffic::agv::Plan::StartSet({start}),
+    rmf_traffic::agv::Plan::Goal(*goal_wp),
+    rmf_traffic::agv::Plan::Options(nullptr));
+
+  // Yield often so this never delays plans that are needed right away
+  _lookahead_job->policy(
+    jobs::Planning::Policy{
+      jobs::Planning::Priority::Background,
+      std::chrono::milliseconds(50),
+      std::nullopt
+    });
+
+  // The result itself is not needed. The job is kept until the next call so
+  // that it can be discarded if the queue changes before it finishes.
+  _lookahead_sub = rmf_rxcpp::make_job<jobs::Planning::Result>(_lookahead_job)
+    .subscribe([](const jobs::Planning::Result&) {});
 }
 
 //==============================================================================
@@ -1053,7 +1293,8 @@ void TaskManager::_begin_waiting()
   }
 
   _waiting = phases::ResponsiveWait::make_indefinite(
-    _context, waiting_point)->begin();
+    _context, waiting_point, std::chrono::seconds(30),
+    _context->idle_wait_horizon())->begin();
 
   _task_sub = _waiting->observe()
     .observe_on(rxcpp::identity_same_worker(_context->worker()))
@@ -1154,7 +1395,10 @@ void TaskManager::_resume_from_emergency()
 //==============================================================================
 void TaskManager::retreat_to_charger()
 {
-  if (!_travel_estimator)
+  // The travel estimator is shared by the whole fleet, and it will not be
+  // available until the fleet has been given its task planner params.
+  const auto travel_estimator = _context->travel_estimator();
+  if (!travel_estimator)
     return;
 
   {
@@ -1181,12 +1425,24 @@ void TaskManager::retreat_to_charger()
   const double retreat_threshold = 1.2 * threshold_soc; // safety factor
   const double current_battery_soc = _context->current_battery_soc();
 
+  // The energy table gives an optimistic drain for the journey to the charger
+  // without integrating the power sinks. When a retreat that used twice as
+  // much charge would still leave the robot above the retreat threshold, the
+  // full estimate cannot ask for a retreat either, so we skip it.
+  const auto retreat_start = current_state.extract_plan_start().value();
+  if (const auto energy_table = _context->energy_table())
+  {
+    const auto drain =
+      energy_table->change_in_charge(retreat_start, charging_waypoint);
+    if (drain.has_value()
+      && current_battery_soc - 2.0 * *drain > retreat_threshold)
+      return;
+  }
+
   const auto& parameters = task_planner->configuration().parameters();
-  // TODO(YV): Expose the TravelEstimator in the TaskPlanner to benefit from
-  // caching
   const rmf_traffic::agv::Planner::Goal retreat_goal{charging_waypoint};
-  const auto result = _travel_estimator->estimate(
-    current_state.extract_plan_start().value(), retreat_goal);
+  const auto result =
+    travel_estimator->estimate(retreat_start, retreat_goal);
   if (!result.has_value())
   {
     RCLCPP_WARN(
@@ -1203,24 +1459,53 @@ void TaskManager::retreat_to_charger()
     (battery_soc_after_retreat > threshold_soc))
   {
     // Add a new charging task to the task queue
-    const auto charging_request = rmf_task::requests::ChargeBattery::make(
+    auto charging_request = rmf_task::requests::ChargeBattery::make(
       current_state.time().value());
-    const auto model = charging_request->description()->make_model(
+    auto model = charging_request->description()->make_model(
       current_state.time().value(),
       parameters);
 
-    const auto finish = model->estimate_finish(
+    auto finish = model->estimate_finish(
       current_state,
       constraints,
-      *_travel_estimator);
+      *travel_estimator);
 
     if (!finish)
       return;
 
+    auto deployment_time = current_state.time().value();
+    if (const auto& scheduler = _context->charger_scheduler())
+    {
+      // Other robots of the fleet may have booked the charger, in which case
+      // the robot either goes to another charger or leaves later.
+      const auto charging_duration = finish->finish_state().time().value()
+        - current_state.time().value() - result->duration();
+
+      auto charge_state = current_state;
+      const auto leave_at = _book_charger(
+        *scheduler, charge_state, retreat_start, result->duration(),
+        charging_duration);
+
+      if (leave_at != deployment_time
+        || charge_state.dedicated_charging_waypoint() != charging_waypoint)
+      {
+        deployment_time = leave_at;
+        charging_request =
+          rmf_task::requests::ChargeBattery::make(deployment_time);
+        model = charging_request->description()->make_model(
+          deployment_time, parameters);
+        finish = model->estimate_finish(
+          charge_state, constraints, *travel_estimator);
+
+        if (!finish)
+          return;
+      }
+    }
+
     rmf_task::TaskPlanner::Assignment charging_assignment(
       charging_request,
       finish.value().finish_state(),
-      current_state.time().value());
+      deployment_time);
 
     const DirectAssignment assignment = DirectAssignment{
       _next_sequence_number,
@@ -1228,8 +1513,9 @@ void TaskManager::retreat_to_charger()
     ++_next_sequence_number;
     {
       std::lock_guard<std::mutex> lock(_mutex);
-      _direct_queue.insert(assignment);
+      _insert_direct_assignment(assignment);
     }
+    _schedule_begin_next_task();
 
     RCLCPP_INFO(
       _context->node()->get_logger(),
@@ -1248,12 +1534,116 @@ void TaskManager::retreat_to_charger()
   }
 }
 
+//==============================================================================
+rmf_traffic::Time TaskManager::_book_charger(
+  agv::ChargerScheduler& scheduler,
+  rmf_task::State& state,
+  const rmf_traffic::agv::Planner::Start& start,
+  const rmf_traffic::Duration travel,
+  const rmf_traffic::Duration charging)
+{
+  const auto now = state.time().value();
+  const auto dedicated = state.dedicated_charging_waypoint().value();
+
+  // The travel estimator was already used for the dedicated charger, and the
+  // table of the fleet gives a quick estimate for the other chargers.
+  std::vector<agv::ChargerScheduler::Option> options;
+  options.push_back({dedicated, rmf_traffic::time::to_seconds(travel)});
+  if (const auto& table = _context->travel_time_table())
+  {
+    for (const auto wp : scheduler.chargers())
+    {
+      if (wp == dedicated)
+        continue;
+
+      if (const auto time = table->travel_time(start, wp))
+        options.push_back({wp, *time});
+    }
+  }
+
+  const auto reservation =
+    scheduler.reserve(_context->name(), options, charging, now);
+  if (!reservation.has_value())
+    return now;
+
+  double travel_time = 0.0;
+  for (const auto& option : options)
+  {
+    if (option.charger == reservation->charger)
+      travel_time = option.travel_time;
+  }
+
+  if (reservation->charger != dedicated)
+  {
+    RCLCPP_INFO(
+      _context->node()->get_logger(),
+      "Charger [%lu] of robot [%s] is booked by another robot, so it will "
+      "charge at [%lu] instead",
+      dedicated,
+      _context->name().c_str(),
+      reservation->charger);
+
+    _context->dedicated_charger_wp(reservation->charger);
+    state.dedicated_charging_waypoint(reservation->charger);
+  }
+
+  return std::max(
+    now,
+    reservation->window.begin - rmf_traffic::time::from_seconds(travel_time));
+}
+
 //==============================================================================
 const std::vector<std::string>& TaskManager::get_executed_tasks() const
 {
   return _executed_task_registry;
 }
 
+//==============================================================================
+MemoryUsage TaskManager::memory_usage() const
+{
+  const auto string_bytes = [](const std::string& s)
+    {
+      return sizeof(s) + approximate_bytes(s);
+    };
+
+  MemoryUsage usage;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::size_t queue = approximate_bytes(_queue);
+    for (const auto& id : _dispatched_ids)
+      queue += ContainerNodeBytes + string_bytes(id);
+
+    usage["task_queue"] = queue;
+
+    std::size_t direct_queue =
+      _direct_queue.size() * (ContainerNodeBytes + sizeof(DirectAssignment));
+    for (const auto& [id, _] : _direct_index)
+    {
+      direct_queue +=
+        ContainerNodeBytes + string_bytes(id) + sizeof(DirectQueue::iterator);
+    }
+
+    usage["direct_queue"] = direct_queue;
+  }
+
+  std::size_t pending = 0;
+  for (const auto& [id, cache] : _pending_task_cache)
+  {
+    pending += ContainerNodeBytes + string_bytes(id) + sizeof(cache)
+      + approximate_bytes(cache.json);
+  }
+
+  usage["pending_task_cache"] = pending;
+  usage["task_logs"] = _task_logs->approximate_bytes();
+
+  std::size_t executed = approximate_bytes(_executed_task_registry);
+  for (const auto& id : _executed_task_registry)
+    executed += approximate_bytes(id);
+
+  usage["executed_task_registry"] = executed;
+  return usage;
+}
+
 //==============================================================================
 void TaskManager::_register_executed_task(const std::string& id)
 {
@@ -1300,29 +1690,14 @@ void TaskManager::_populate_task_summary(
   msg.state = task_summary_state;
 }
 
-//==============================================================================
-void TaskManager::_schema_loader(
-  const nlohmann::json_uri& id, nlohmann::json& value) const
-{
-  const auto it = _schema_dictionary.find(id.url());
-  if (it == _schema_dictionary.end())
-  {
-    RCLCPP_ERROR(
-      _context->node()->get_logger(),
-      "[TaskManager] url: %s not found in schema dictionary", id.url().c_str());
-    return;
-  }
-
-  value = it->second;
-}
-
 //==============================================================================
 void TaskManager::_validate_and_publish_websocket(
   const nlohmann::json& msg,
   const nlohmann::json_schema::json_validator& validator) const
 {
   std::string error = "";
-  if (!_validate_json(msg, validator, error))
+  if (_validators->check_outbound(validator)
+    && !_validate_json(msg, validator, error))
   {
     RCLCPP_ERROR(
       _context->node()->get_logger(),
@@ -1354,7 +1729,8 @@ void TaskManager::_validate_and_publish_api_response(
   const std::string& request_id)
 {
   std::string error;
-  if (!_validate_json(response, validator, error))
+  if (_validators->check_outbound(validator)
+    && !_validate_json(response, validator, error))
   {
     RCLCPP_ERROR(
       _context->node()->get_logger(),
@@ -1392,6 +1768,32 @@ void TaskManager::_consider_publishing_updates()
   }
 }
 
+//==============================================================================
+void TaskManager::_schedule_task_state_update()
+{
+  _task_state_update_available = true;
+  if (_task_state_update_scheduled)
+    return;
+
+  // Updates that arrive close together get combined, so the task state is
+  // published at most ten times per second.
+  _task_state_update_scheduled = true;
+  const auto when = std::max(
+    std::chrono::steady_clock::now(),
+    _last_update_time + std::chrono::milliseconds(100));
+
+  _context->worker().schedule(
+    when,
+    [w = weak_from_this()](const auto&)
+    {
+      if (const auto self = w.lock())
+      {
+        self->_task_state_update_scheduled = false;
+        self->_consider_publishing_updates();
+      }
+    });
+}
+
 //==============================================================================
 void TaskManager::_publish_task_state()
 {
@@ -1401,21 +1803,48 @@ void TaskManager::_publish_task_state()
   _active_task.publish_task_state(*this);
 }
 
+//==============================================================================
+bool TaskManager::PendingTaskCache::matches(
+  const Assignment& assignment,
+  const rmf_task::State& start_state) const
+{
+  return request == assignment.request()
+    && deployment_time == assignment.deployment_time()
+    && finish_time == assignment.finish_state().time()
+    && start_waypoint == start_state.waypoint()
+    && start_orientation == start_state.orientation()
+    && start_time == start_state.time();
+}
+
 //==============================================================================
 void TaskManager::_publish_task_queue()
 {
   rmf_task::State expected_state = _context->current_task_end_state();
   const auto& parameters = *_context->task_parameters();
-  static const auto validator =
+  const auto& validator =
     _make_validator(rmf_api_msgs::schemas::task_state_update);
 
+  std::unordered_set<std::string> queued_ids;
   for (const auto& pending : _queue)
   {
+    const auto& booking = *pending.request()->booking();
+    queued_ids.insert(booking.id());
+
+    auto& cache = _pending_task_cache[booking.id()];
+    if (!cache.json.is_null() && cache.matches(pending, expected_state))
+    {
+      auto task_state_update = _task_state_update_json;
+      task_state_update["data"] = cache.json;
+      _validate_and_publish_websocket(task_state_update, validator);
+
+      expected_state = pending.finish_state();
+      continue;
+    }
+
     const auto info = pending.request()->description()->generate_info(
       expected_state, parameters);
 
     nlohmann::json pending_json;
-    const auto& booking = *pending.request()->booking();
     copy_booking_data(pending_json["booking"], booking);
 
     pending_json["category"] = info.category;
@@ -1437,13 +1866,32 @@ void TaskManager::_publish_task_queue()
     copy_assignment(pending_json["assigned_to"], *_context);
     pending_json["status"] = "queued";
 
+    cache = PendingTaskCache{
+      pending.request(),
+      pending.deployment_time(),
+      pending.finish_state().time(),
+      expected_state.waypoint(),
+      expected_state.orientation(),
+      expected_state.time(),
+      pending_json
+    };
+
     auto task_state_update = _task_state_update_json;
-    task_state_update["data"] = pending_json;
+    task_state_update["data"] = std::move(pending_json);
 
     _validate_and_publish_websocket(task_state_update, validator);
 
     expected_state = pending.finish_state();
   }
+
+  // Forget the tasks that have left the queue
+  for (auto it = _pending_task_cache.begin(); it != _pending_task_cache.end();)
+  {
+    if (queued_ids.count(it->first) > 0)
+      ++it;
+    else
+      it = _pending_task_cache.erase(it);
+  }
 }
 
 //==============================================================================
@@ -1485,7 +1933,7 @@ void TaskManager::_send_simple_success_response(const std::string& request_id)
 {
   static const auto response = make_simple_success_response();
 
-  static const auto simple_response_validator =
+  const auto& simple_response_validator =
     _make_validator(rmf_api_msgs::schemas::simple_response);
 
   _validate_and_publish_api_response(
@@ -1501,7 +1949,7 @@ void TaskManager::_send_token_success_response(
   response["success"] = true;
   response["token"] = std::move(token);
 
-  static const auto token_response_validator =
+  const auto& token_response_validator =
     _make_validator(rmf_api_msgs::schemas::token_response);
 
   _validate_and_publish_api_response(
@@ -1509,19 +1957,10 @@ void TaskManager::_send_token_success_response(
 }
 
 //==============================================================================
-nlohmann::json_schema::json_validator TaskManager::_make_validator(
+const nlohmann::json_schema::json_validator& TaskManager::_make_validator(
   const nlohmann::json& schema) const
 {
-  return nlohmann::json_schema::json_validator(
-    schema,
-    [w = weak_from_this()](const nlohmann::json_uri& id,
-    nlohmann::json& value)
-    {
-      const auto self = w.lock();
-      if (!self)
-        return;
-      self->_schema_loader(id, value);
-    });
+  return _validators->get(schema);
 }
 
 //==============================================================================
@@ -1531,7 +1970,7 @@ void TaskManager::_send_simple_error_response(
   std::string category,
   std::string detail)
 {
-  static const auto error_validator =
+  const auto& error_validator =
     _make_validator(rmf_api_msgs::schemas::simple_response);
 
   _validate_and_publish_api_response(
@@ -1546,30 +1985,85 @@ void TaskManager::_send_simple_error_if_queued(
   const std::string& request_id,
   const std::string& type)
 {
-  // TODO(YV): We could cache the task_ids of direct and dispatched tasks in
-  // unordered_sets and perform a lookup to see which queue to iterate.
   std::lock_guard<std::mutex> lock(_mutex);
+  if (_is_queued(task_id))
+  {
+    return _send_simple_error_response(
+      request_id, 6, "Invalid Circumstances",
+      type + " a task that is queued (not yet active) "
+      "is not currently supported");
+  }
+}
+
+//==============================================================================
+void TaskManager::_set_dispatched_queue(std::vector<Assignment> assignments)
+{
+  _queue = std::move(assignments);
+  _dispatched_ids.clear();
   for (const auto& a : _queue)
+    _dispatched_ids.insert(a.request()->booking()->id());
+}
+
+//==============================================================================
+void TaskManager::_insert_direct_assignment(DirectAssignment assignment)
+{
+  const auto id = assignment.assignment.request()->booking()->id();
+  const auto it = _direct_queue.insert(std::move(assignment)).first;
+  _direct_index.insert_or_assign(id, it);
+}
+
+//==============================================================================
+void TaskManager::_pop_next_assignment(const bool direct)
+{
+  if (direct)
   {
-    if (a.request()->booking()->id() == task_id)
-    {
-      return _send_simple_error_response(
-        request_id, 6, "Invalid Circumstances",
-        type + " a task that is queued (not yet active) "
-        "is not currently supported");
-    }
+    const auto it = _direct_queue.begin();
+    _direct_index.erase(it->assignment.request()->booking()->id());
+    _direct_queue.erase(it);
+    return;
   }
 
-  for (const auto& a : _direct_queue)
+  _dispatched_ids.erase(_queue.front().request()->booking()->id());
+  _queue.erase(_queue.begin());
+}
+
+//==============================================================================
+bool TaskManager::_remove_queued_task(const std::string& task_id)
+{
+  // If the task is queued, then we should make sure to remove it from the
+  // queue, just in case it reaches an active state before the dispatcher
+  // issues its cancellation request.
+  //
+  // TODO(MXG): We should do a much better of job of coordinating these
+  // different moving parts in the system. E.g. who is ultimately responsible
+  // for issuing the response to the request or updating the task state?
+  const auto direct_it = _direct_index.find(task_id);
+  if (direct_it != _direct_index.end())
   {
-    if (a.assignment.request()->booking()->id() == task_id)
-    {
-      return _send_simple_error_response(
-        request_id, 6, "Invalid Circumstances",
-        type + " a task that is queued (not yet active) "
-        "is not currently supported");
-    }
+    _direct_queue.erase(direct_it->second);
+    _direct_index.erase(direct_it);
+    return true;
   }
+
+  if (_dispatched_ids.erase(task_id) == 0)
+    return false;
+
+  const auto it = std::find_if(
+    _queue.begin(), _queue.end(), [&](const Assignment& a)
+    {
+      return a.request()->booking()->id() == task_id;
+    });
+
+  if (it != _queue.end())
+    _queue.erase(it);
+
+  return true;
+}
+
+//==============================================================================
+bool TaskManager::_is_queued(const std::string& task_id) const
+{
+  return _direct_index.count(task_id) > 0 || _dispatched_ids.count(task_id) > 0;
 }
 
 //==============================================================================
@@ -1601,22 +2095,24 @@ TaskManager::_update_cb()
       if (!self)
         return;
 
-      self->_task_state_update_available = true;
+      self->_schedule_task_state_update();
       // TODO(MXG): Use this callback to make the state updates more efficient
     };
 }
 
 //==============================================================================
 std::function<void(rmf_task::Task::Active::Backup)>
-TaskManager::_checkpoint_cb()
+TaskManager::_checkpoint_cb(std::string id)
 {
-  return [w = weak_from_this()](rmf_task::Task::Active::Backup)
+  return [w = weak_from_this(), id](rmf_task::Task::Active::Backup backup)
     {
       const auto self = w.lock();
       if (!self)
         return;
 
-      // TODO(MXG): Save the backup
+      // The scheduler combines backups that arrive close together and writes
+      // them off of this thread, so this is cheap to do at every checkpoint.
+      self->_backup_scheduler().push(id, std::move(backup));
     };
 }
 
@@ -1630,7 +2126,7 @@ TaskManager::_phase_finished_cb()
       if (!self)
         return;
 
-      self->_task_state_update_available = true;
+      self->_schedule_task_state_update();
       // TODO(MXG): Use this callback to make the state updates more efficient
     };
 }
@@ -1640,42 +2136,29 @@ std::function<void()> TaskManager::_task_finished(std::string id)
 {
   return [w = weak_from_this(), id]()
     {
+      tracing::instant("task_finished", id);
       const auto self = w.lock();
       if (!self)
         return;
 
       // Publish the final state of the task before destructing it
       self->_publish_task_state();
-      self->_active_task = ActiveTask();
+      {
+        std::lock_guard<std::mutex> lock(self->_mutex);
+        self->_active_task = ActiveTask();
+      }
+      self->_task_logs->erase(id);
+      self->_backup_scheduler().clear(id);
 
-      self->_context->worker().schedule(
-        [w = self->weak_from_this()](const auto&)
-        {
-          if (const auto self = w.lock())
-            self->_begin_next_task();
-        });
+      self->_schedule_begin_next_task();
     };
 }
 
 //==============================================================================
-void TaskManager::_handle_request(
-  const std::string& request_msg,
+void TaskManager::handle_api_request(
+  const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  nlohmann::json request_json;
-  try
-  {
-    request_json = nlohmann::json::parse(request_msg);
-  }
-  catch (const std::exception& e)
-  {
-    RCLCPP_ERROR(
-      _context->node()->get_logger(),
-      "Error parsing json_msg: %s",
-      e.what());
-    return;
-  }
-
   const auto type_it = request_json.find("type");
   if (type_it == request_json.end())
     return;
@@ -1689,12 +2172,16 @@ void TaskManager::_handle_request(
     const auto& type_str = type.get<std::string>();
     if (type_str == "cancel_task_request")
       _handle_cancel_request(request_json, request_id);
+    else if (type_str == "cancel_tasks_request")
+      _handle_bulk_cancel_request(request_json, request_id);
     else if (type_str == "kill_task_request")
       _handle_kill_request(request_json, request_id);
     else if (type_str == "interrupt_task_request")
       _handle_interrupt_request(request_json, request_id);
     else if (type_str == "resume_task_request")
       _handle_resume_request(request_json, request_id);
+    else if (type_str == "task_log_request")
+      _handle_task_log_request(request_json, request_id);
     else if (type_str == "rewind_task_request")
       _handle_rewind_request(request_json, request_id);
     else if (type_str == "skip_phase_request")
@@ -1725,51 +2212,6 @@ std::vector<std::string> get_labels(const nlohmann::json& request)
   return {};
 }
 
-//==============================================================================
-bool remove_task_from_queue(
-  const std::string& task_id,
-  std::vector<TaskManager::Assignment>& queue)
-{
-  // If the task is queued, then we should make sure to remove it from the
-  // queue, just in case it reaches an active state before the dispatcher
-  // issues its cancellation request.
-  //
-  // TODO(MXG): We should do a much better of job of coordinating these
-  // different moving parts in the system. E.g. who is ultimately responsible
-  // for issuing the response to the request or updating the task state?
-  for (auto it = queue.begin(); it != queue.end(); ++it)
-  {
-    if (it->request()->booking()->id() == task_id)
-    {
-      queue.erase(it);
-      return true;
-    }
-  }
-  return false;
-}
-
-//==============================================================================
-bool remove_task_from_queue(
-  const std::string& task_id,
-  TaskManager::DirectQueue& queue)
-{
-  // If the task is queued, then we should make sure to remove it from the
-  // queue, just in case it reaches an active state before the dispatcher
-  // issues its cancellation request.
-  //
-  // TODO(MXG): We should do a much better of job of coordinating these
-  // different moving parts in the system. E.g. who is ultimately responsible
-  // for issuing the response to the request or updating the task state?
-  for (auto it = queue.begin(); it != queue.end(); ++it)
-  {
-    if (it->assignment.request()->booking()->id() == task_id)
-    {
-      queue.erase(it);
-      return true;
-    }
-  }
-  return false;
-}
 } // namespace anonymous
 
 //==============================================================================
@@ -1777,10 +2219,10 @@ void TaskManager::_handle_direct_request(
   const  nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::robot_task_request);
 
-  static const auto response_validator =
+  const auto& response_validator =
     _make_validator(rmf_api_msgs::schemas::robot_task_response);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -1825,7 +2267,8 @@ void TaskManager::_handle_direct_request(
   }
   // Generate Assignment for the request
   const auto task_planner = _context->task_planner();
-  if (!task_planner)
+  const auto travel_estimator = _context->travel_estimator();
+  if (!task_planner || !travel_estimator)
   {
     RCLCPP_ERROR(
       _context->node()->get_logger(),
@@ -1844,7 +2287,7 @@ void TaskManager::_handle_direct_request(
   const auto estimate = model->estimate_finish(
     current_state,
     constraints,
-    *_travel_estimator);
+    *travel_estimator);
 
   rmf_task::State finish_state;
   rmf_traffic::Time deployment_time;
@@ -1876,8 +2319,9 @@ void TaskManager::_handle_direct_request(
   ++_next_sequence_number;
   {
     std::lock_guard<std::mutex> lock(_mutex);
-    _direct_queue.insert(assignment);
+    _insert_direct_assignment(assignment);
   }
+  _schedule_begin_next_task();
 
   RCLCPP_INFO(
     _context->node()->get_logger(),
@@ -1911,7 +2355,7 @@ void TaskManager::_handle_cancel_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::cancel_task_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -1922,14 +2366,44 @@ void TaskManager::_handle_cancel_request(
   if (_active_task && _active_task.id() == task_id)
   {
     _active_task.cancel(get_labels(request_json), _context->now());
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     return _send_simple_success_response(request_id);
   }
-  // TODO(YV): We could cache the task_ids of direct and dispatched tasks in
-  // unordered_sets and perform a lookup to see which function to call.
   std::lock_guard<std::mutex> lock(_mutex);
-  if (!remove_task_from_queue(task_id, _queue))
-    remove_task_from_queue(task_id, _direct_queue);
+  _remove_queued_task(task_id);
+}
+
+//==============================================================================
+void TaskManager::_handle_bulk_cancel_request(
+  const nlohmann::json& request_json,
+  const std::string& request_id)
+{
+  const auto& request_validator =
+    _make_validator(rmf_fleet_adapter::schemas::cancel_tasks_request);
+
+  if (!_validate_request_message(request_json, request_validator, request_id))
+    return;
+
+  const auto labels = get_labels(request_json);
+  const auto task_ids =
+    request_json["task_ids"].get<std::vector<std::string>>();
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& task_id : task_ids)
+      _remove_queued_task(task_id);
+  }
+
+  for (const auto& task_id : task_ids)
+  {
+    if (_active_task && _active_task.id() == task_id)
+    {
+      _active_task.cancel(labels, _context->now());
+      _schedule_task_state_update();
+    }
+  }
+
+  _send_simple_success_response(request_id);
 }
 
 //==============================================================================
@@ -1937,7 +2411,7 @@ void TaskManager::_handle_kill_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::kill_task_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -1947,16 +2421,13 @@ void TaskManager::_handle_kill_request(
 
   if (_active_task && _active_task.id() == task_id)
   {
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     _active_task.kill(get_labels(request_json), _context->now());
     return _send_simple_success_response(request_id);
   }
 
-  // TODO(YV): We could cache the task_ids of direct and dispatched tasks in
-  // unordered_sets and perform a lookup to see which function to call.
   std::lock_guard<std::mutex> lock(_mutex);
-  if (!remove_task_from_queue(task_id, _queue))
-    remove_task_from_queue(task_id, _direct_queue);
+  _remove_queued_task(task_id);
 }
 
 //==============================================================================
@@ -1964,7 +2435,7 @@ void TaskManager::_handle_interrupt_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::interrupt_task_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -1974,7 +2445,7 @@ void TaskManager::_handle_interrupt_request(
 
   if (_active_task && _active_task.id() == task_id)
   {
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     return _send_token_success_response(
       _active_task.add_interruption(
         get_labels(request_json), _context->now(), []() {}),
@@ -1989,7 +2460,7 @@ void TaskManager::_handle_resume_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::resume_task_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -1999,7 +2470,7 @@ void TaskManager::_handle_resume_request(
 
   if (_active_task && _active_task.id() == task_id)
   {
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     auto unknown_tokens = _active_task.remove_interruption(
       request_json["for_tokens"].get<std::vector<std::string>>(),
       get_labels(request_json),
@@ -2024,12 +2495,39 @@ void TaskManager::_handle_resume_request(
   _send_simple_error_if_queued(task_id, request_id, "Resuming");
 }
 
+//==============================================================================
+void TaskManager::_handle_task_log_request(
+  const nlohmann::json& request_json,
+  const std::string& request_id)
+{
+  const auto& request_validator =
+    _make_validator(rmf_fleet_adapter::schemas::task_log_request);
+
+  if (!_validate_request_message(request_json, request_validator, request_id))
+    return;
+
+  const auto& task_id = request_json["task_id"].get<std::string>();
+  auto logs = _task_logs->fetch(task_id);
+  if (!logs.has_value())
+  {
+    return _send_simple_error_if_queued(
+      task_id, request_id, "Fetching the logs of");
+  }
+
+  nlohmann::json update_msg = _task_log_update_msg;
+  update_msg["data"] = std::move(*logs);
+  _validate_and_publish_websocket(
+    update_msg, _make_validator(rmf_api_msgs::schemas::task_log_update));
+
+  _send_simple_success_response(request_id);
+}
+
 //==============================================================================
 void TaskManager::_handle_rewind_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::rewind_task_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -2039,7 +2537,7 @@ void TaskManager::_handle_rewind_request(
 
   if (_active_task && _active_task.id() == task_id)
   {
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     _active_task.rewind(request_json["phase_id"].get<uint64_t>());
     return _send_simple_success_response(request_id);
   }
@@ -2052,7 +2550,7 @@ void TaskManager::_handle_skip_phase_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::skip_phase_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -2062,7 +2560,7 @@ void TaskManager::_handle_skip_phase_request(
 
   if (_active_task && _active_task.id() == task_id)
   {
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     return _send_token_success_response(
       _active_task.skip(
         request_json["phase_id"].get<uint64_t>(),
@@ -2079,7 +2577,7 @@ void TaskManager::_handle_undo_skip_phase_request(
   const nlohmann::json& request_json,
   const std::string& request_id)
 {
-  static const auto request_validator =
+  const auto& request_validator =
     _make_validator(rmf_api_msgs::schemas::undo_skip_phase_request);
 
   if (!_validate_request_message(request_json, request_validator, request_id))
@@ -2089,7 +2587,7 @@ void TaskManager::_handle_undo_skip_phase_request(
 
   if (_active_task && _active_task.id() == task_id)
   {
-    _task_state_update_available = true;
+    _schedule_task_state_update();
     auto unknown_tokens = _active_task.remove_skips(
       request_json["for_tokens"].get<std::vector<std::string>>(),
       get_labels(request_json),
@@ -21,6 +21,11 @@
 #include "LegacyTask.hpp"
 #include "agv/RobotContext.hpp"
 #include "BroadcastClient.hpp"
+#include "ValidatorCache.hpp"
+#include "BackupScheduler.hpp"
+#include "TaskLogStore.hpp"
+#include "MemoryUsage.hpp"
+#include "jobs/Planning.hpp"
 
 #include <rmf_traffic/agv/Planner.hpp>
 
@@ -37,6 +42,7 @@
 
 #include <mutex>
 #include <set>
+#include <unordered_set>
 
 namespace rmf_fleet_adapter {
 
@@ -118,10 +124,23 @@ public:
 
   std::optional<std::string> current_task_id() const;
 
-  const std::vector<Assignment>& get_queue() const;
+  /// Get a copy of the dispatched queue. This may be called from a worker
+  /// other than the one that this robot runs on.
+  std::vector<Assignment> get_queue() const;
+
+  /// Check whether this task manager holds the task, either as its active
+  /// task or in one of its queues. This may be called from a worker other
+  /// than the one that this robot runs on.
+  bool has_task(const std::string& task_id) const;
 
   bool cancel_task_if_present(const std::string& task_id);
 
+  /// Handle an API request that has already been parsed by the fleet. This
+  /// must be called on the worker of this robot.
+  void handle_api_request(
+    const nlohmann::json& request_json,
+    const std::string& request_id);
+
   std::string robot_status() const;
 
   /// The state of the robot. If the direct assignment queue is not empty,
@@ -130,8 +149,9 @@ public:
   /// is returned
   State expected_finish_state() const;
 
-  /// Callback for the retreat timer. Appends a charging task to the task queue
-  /// when robot is idle and battery level drops below a retreat threshold.
+  /// Appends a charging task to the task queue when robot is idle and battery
+  /// level drops below a retreat threshold. This gets checked whenever the
+  /// robot becomes idle or its battery drains further, and by a slow poll.
   void retreat_to_charger();
 
   /// Get the list of task ids for tasks that have started execution.
@@ -143,6 +163,11 @@ public:
   /// Get a vector of task logs that are validated against the schema
   std::vector<nlohmann::json> task_log_updates() const;
 
+  /// Approximate how much memory this task manager is holding on to for its
+  /// queues, logs and cached task states. This must be called on the worker
+  /// of this robot.
+  MemoryUsage memory_usage() const;
+
 private:
 
   TaskManager(
@@ -205,6 +230,10 @@ private:
     rmf_traffic::Time _start_time;
     nlohmann::json _state_msg;
 
+    // Completed phases do not change anymore, so these have already been
+    // copied into _state_msg and do not need to be copied again.
+    std::vector<rmf_task::Phase::ConstCompletedPtr> _published_completed;
+
     std::unordered_map<std::string, nlohmann::json> _active_interruptions;
     std::unordered_map<std::string, nlohmann::json> _removed_interruptions;
     std::optional<rmf_task::Task::Active::Resume> _resume_task;
@@ -249,6 +278,31 @@ private:
   std::size_t _next_sequence_number;
   // Queue for directly assigned tasks
   DirectQueue _direct_queue;
+  // Look up queued tasks by their task_id. These must stay in sync with the
+  // queues, so only modify the queues while holding _mutex and through
+  // _set_dispatched_queue(), _insert_direct_assignment(),
+  // _pop_next_assignment() and _remove_queued_task().
+  std::unordered_set<std::string> _dispatched_ids;
+  std::unordered_map<std::string, DirectQueue::iterator> _direct_index;
+
+  /// The "queued" state of a pending task only changes when its assignment
+  /// or the state that it is expected to start from changes, so we reuse it
+  /// across queue publications until then.
+  struct PendingTaskCache
+  {
+    rmf_task::ConstRequestPtr request;
+    rmf_traffic::Time deployment_time;
+    std::optional<rmf_traffic::Time> finish_time;
+    std::optional<std::size_t> start_waypoint;
+    std::optional<double> start_orientation;
+    std::optional<rmf_traffic::Time> start_time;
+    nlohmann::json json;
+
+    bool matches(
+      const Assignment& assignment,
+      const rmf_task::State& start_state) const;
+  };
+  std::unordered_map<std::string, PendingTaskCache> _pending_task_cache;
   rmf_utils::optional<Start> _expected_finish_location;
   rxcpp::subscription _task_sub;
   rxcpp::subscription _emergency_sub;
@@ -262,25 +316,39 @@ private:
   // manager so that modifications of shared data only happen on designated
   // rxcpp worker
   mutable std::mutex _mutex;
+  // The task manager reacts to changes in its queue, its tasks and the
+  // battery of its robot. These timers are only a slow safety poll in case an
+  // event gets missed, and a heartbeat for the task state.
   rclcpp::TimerBase::SharedPtr _task_timer;
-  rclcpp::TimerBase::SharedPtr _retreat_timer;
   rclcpp::TimerBase::SharedPtr _update_timer;
   bool _task_state_update_available = true;
+  bool _task_state_update_scheduled = false;
   std::chrono::steady_clock::time_point _last_update_time;
 
+  // When the next task should be checked because it is due to begin
+  std::optional<std::chrono::steady_clock::time_point> _next_task_wakeup;
+
+  // The battery level when the need to retreat to a charger was last checked
+  rxcpp::subscription _battery_soc_sub;
+  double _retreat_check_soc = 1.0;
+
   // Container to keep track of tasks that have been started by this TaskManager
   // Use the _register_executed_task() to populate this container.
   std::vector<std::string> _executed_task_registry;
 
-  // TravelEstimator for caching travel estimates for automatic charging
-  // retreat. TODO(YV): Expose the TaskPlanner's TravelEstimator.
-  std::shared_ptr<rmf_task::TravelEstimator> _travel_estimator;
 
-  // Map schema url to schema for validator.
-  // TODO: Get this and loader from FleetUpdateHandle
-  std::unordered_map<std::string, nlohmann::json> _schema_dictionary = {};
+  std::shared_ptr<ValidatorCache> _validators;
+
+  // Keeps the latest backup of the active task
+  std::optional<BackupScheduler> _backups;
 
-  rmf_rxcpp::subscription_guard _task_request_api_sub;
+  // A background plan from where the active task is expected to finish to
+  // where the next queued task begins. It is never executed. It lets the
+  // planner fill in its heuristic for the next goal while the robot is still
+  // busy, so the plan that gets validated against the schedule when the next
+  // task starts can be found quickly.
+  std::shared_ptr<jobs::Planning> _lookahead_job;
+  rmf_rxcpp::subscription_guard _lookahead_sub;
 
   // Constant jsons with validated schemas for internal use
   // TODO(YV): Replace these with codegen tools
@@ -299,15 +367,56 @@ private:
 
   rmf_task::Log::Reader _log_reader;
 
-  // Map task_id to task_log.json for all tasks managed by this TaskManager
-  std::unordered_map<std::string, nlohmann::json> _task_logs = {};
+  // Event names and details rarely change, so this lets us skip copying them
+  // into the task state unless they have changed since the last update.
+  rmf_task::VersionedString::Reader _string_reader;
+
+  // The task_log.json of all tasks managed by this TaskManager. Each
+  // task_log_update only carries the entries that were logged since the last
+  // update, so the logs are kept here to be sent whenever the BroadcastClient
+  // reconnects, or fetched through a task_log_request. This is built in make()
+  // and is internally synchronized because the BroadcastClient reads it from
+  // its own thread.
+  std::shared_ptr<TaskLogStore> _task_logs;
 
   /// Callback for task timer which begins next task if its deployment time has passed
   void _begin_next_task();
 
+  /// Begin the next task on the worker of the robot after a delay, measured on
+  /// the ROS clock
+  void _schedule_begin_next_task(
+    rmf_traffic::Duration delay = rmf_traffic::Duration(0));
+
+  /// Check on the worker of the robot whether it needs to retreat to a charger
+  void _schedule_retreat_to_charger();
+
+  /// Book a window at the charger where the robot can begin charging soonest.
+  /// The dedicated charger of the robot and of the state are changed if the
+  /// robot needs to charge somewhere else. This gives back when the robot
+  /// should leave for the charger.
+  rmf_traffic::Time _book_charger(
+    agv::ChargerScheduler& scheduler,
+    rmf_task::State& state,
+    const rmf_traffic::agv::Planner::Start& start,
+    rmf_traffic::Duration travel,
+    rmf_traffic::Duration charging);
+
   /// Begin responsively waiting for the next task
   void _begin_waiting();
 
+  /// Build the parts of the task manager that are not needed for the robot to
+  /// show up in the fleet state. This runs in the job after make(), and does
+  /// nothing if it has already run.
+  void _finish_startup();
+  bool _started = false;
+
+  /// The backups are built on first use
+  BackupScheduler& _backup_scheduler();
+
+  /// Start planning ahead for the next task in the queue. The _mutex must be
+  /// locked when this is called.
+  void _plan_ahead();
+
   /// Make the callback for resuming
   std::function<void()> _make_resume_from_emergency();
 
@@ -320,16 +429,15 @@ private:
   /// Check whether publishing should happen
   void _consider_publishing_updates();
 
+  /// Note that the task state has changed, and publish it soon
+  void _schedule_task_state_update();
+
   /// Publish the current task state
   void _publish_task_state();
 
   /// Publish the current pending task list
   void _publish_task_queue();
 
-  /// Schema loader for validating jsons
-  void _schema_loader(
-    const nlohmann::json_uri& id, nlohmann::json& value) const;
-
   /// Returns true if json is valid.
   // TODO: Move this into a utils?
   bool _validate_json(
@@ -353,8 +461,9 @@ private:
     std::string token,
     const std::string& request_id);
 
-  /// Make a validator for the given schema
-  nlohmann::json_schema::json_validator _make_validator(
+  /// Get the validator for the given schema. Each validator only gets compiled
+  /// once and is then kept in _validators.
+  const nlohmann::json_schema::json_validator& _make_validator(
     const nlohmann::json& schema) const;
 
   void _send_simple_error_response(
@@ -363,6 +472,13 @@ private:
     std::string category,
     std::string detail);
 
+  /// The caller must be holding _mutex for these
+  void _set_dispatched_queue(std::vector<Assignment> assignments);
+  void _insert_direct_assignment(DirectAssignment assignment);
+  void _pop_next_assignment(bool direct);
+  bool _remove_queued_task(const std::string& task_id);
+  bool _is_queued(const std::string& task_id) const;
+
   void _send_simple_error_if_queued(
     const std::string& task_id,
     const std::string& request_id,
@@ -390,7 +506,8 @@ private:
   std::function<void(rmf_task::Phase::ConstSnapshotPtr)> _update_cb();
 
   /// Callback for when the task reaches a checkpoint
-  std::function<void(rmf_task::Task::Active::Backup)> _checkpoint_cb();
+  std::function<void(rmf_task::Task::Active::Backup)> _checkpoint_cb(
+    std::string id);
 
   /// Callback for when a phase within a task has finished
   std::function<void(rmf_task::Phase::ConstCompletedPtr)> _phase_finished_cb();
@@ -408,10 +525,6 @@ private:
     uint32_t task_summary_state,
     TaskSummaryMsg& msg);
 
-  void _handle_request(
-    const std::string& request_msg,
-    const std::string& request_id);
-
   void _handle_direct_request(
     const nlohmann::json& request_json,
     const std::string& request_id);
@@ -420,6 +533,10 @@ private:
     const nlohmann::json& request_json,
     const std::string& request_id);
 
+  void _handle_bulk_cancel_request(
+    const nlohmann::json& request_json,
+    const std::string& request_id);
+
   void _handle_kill_request(
     const nlohmann::json& request_json,
     const std::string& request_id);
@@ -432,6 +549,10 @@ private:
     const nlohmann::json& request_json,
     const std::string& request_id);
 
+  void _handle_task_log_request(
+    const nlohmann::json& request_json,
+    const std::string& request_id);
+
   void _handle_rewind_request(
     const nlohmann::json& request_json,
     const std::string& request_id);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ValidatorCache.hpp"
+
+#include <algorithm>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+auto ValidatorCache::get_settings(rclcpp::Node& node) -> Settings
+{
+  const std::string policy_param = "outbound_json_validation";
+  const std::string period_param = "outbound_json_validation_sample_period";
+  if (!node.has_parameter(policy_param))
+    node.declare_parameter<std::string>(policy_param, "always");
+
+  if (!node.has_parameter(period_param))
+    node.declare_parameter<int64_t>(period_param, 100);
+
+  Settings settings;
+  const auto policy = node.get_parameter(policy_param).as_string();
+  if (policy == "sampled")
+    settings.policy = OutboundPolicy::Sampled;
+  else if (policy == "debug_only")
+    settings.policy = OutboundPolicy::DebugOnly;
+  else if (policy != "always")
+  {
+    RCLCPP_WARN(
+      node.get_logger(),
+      "Unknown value [%s] for parameter [%s]. Options are [always], "
+      "[sampled], or [debug_only]. Every outbound message will be validated.",
+      policy.c_str(),
+      policy_param.c_str());
+  }
+
+  settings.sample_period = static_cast<std::size_t>(
+    std::max<int64_t>(1, node.get_parameter(period_param).as_int()));
+
+  return settings;
+}
+
+//==============================================================================
+ValidatorCache::ValidatorCache(Settings settings)
+: _settings(settings)
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto ValidatorCache::get(const nlohmann::json& schema) -> const Validator&
+{
+  return SchemaRegistry::get().validator(schema);
+}
+
+//==============================================================================
+bool ValidatorCache::check_outbound(const Validator& validator)
+{
+  switch (_settings.policy)
+  {
+    case OutboundPolicy::Always:
+      return true;
+    case OutboundPolicy::DebugOnly:
+#ifdef NDEBUG
+      return false;
+#else
+      return true;
+#endif
+    case OutboundPolicy::Sampled:
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto& count = _outbound_count[&validator];
+      return (count++ % _settings.sample_period) == 0;
+    }
+  }
+
+  return true;
+}
+
+} // namespace rmf_fleet_adapter
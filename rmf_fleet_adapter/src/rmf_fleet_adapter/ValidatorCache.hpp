@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__VALIDATORCACHE_HPP
+#define SRC__RMF_FLEET_ADAPTER__VALIDATORCACHE_HPP
+
+#include "SchemaRegistry.hpp"
+
+#include <rclcpp/node.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+// Compiling a json_validator is expensive, so the validator of each schema $id
+// is compiled once and shared through the SchemaRegistry. This decides how
+// often the messages that the adapter generates itself get validated before
+// they are sent out. Messages that come in through the API should always be
+// validated.
+class ValidatorCache
+{
+public:
+
+  using Validator = SchemaRegistry::Validator;
+
+  enum class OutboundPolicy
+  {
+    // Validate every outbound message
+    Always,
+
+    // Validate one out of every sample_period outbound messages of each schema
+    Sampled,
+
+    // Only validate outbound messages in debug builds
+    DebugOnly
+  };
+
+  struct Settings
+  {
+    OutboundPolicy policy = OutboundPolicy::Always;
+    std::size_t sample_period = 100;
+  };
+
+  // Read the settings from the outbound_json_validation and
+  // outbound_json_validation_sample_period parameters of the node. These may
+  // be read by many caches, so they only get declared once.
+  static Settings get_settings(rclcpp::Node& node);
+
+  ValidatorCache(Settings settings);
+
+  // Get the validator for this schema. It gets compiled the first time that
+  // the schema is asked for by any cache.
+  const Validator& get(const nlohmann::json& schema);
+
+  // Returns true if the next outbound message for this validator should be
+  // validated according to the policy.
+  bool check_outbound(const Validator& validator);
+
+private:
+  Settings _settings;
+  std::mutex _mutex;
+  std::unordered_map<const Validator*, std::size_t> _outbound_count;
+};
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__VALIDATORCACHE_HPP
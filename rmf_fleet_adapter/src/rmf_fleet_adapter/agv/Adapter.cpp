@@ -28,8 +28,16 @@
 
 #include "internal_TrafficLight.hpp"
 #include "internal_EasyTrafficLight.hpp"
+#include "internal_SharedMirror.hpp"
+#include "internal_MemoryReport.hpp"
 
+#include "../jobs/PlanningPool.hpp"
 #include "../load_param.hpp"
+#include "../tracing.hpp"
+
+#include <rmf_rxcpp/WorkerMonitor.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 
 namespace rmf_fleet_adapter {
 namespace agv {
@@ -39,8 +47,14 @@ class WorkerWrapper : public rmf_traffic_ros2::schedule::Negotiation::Worker
 {
 public:
 
-  WorkerWrapper(rxcpp::schedulers::worker worker)
-  : _worker(std::move(worker))
+  /// Negotiations are spread across the negotiation workers based on their
+  /// conflict version, so each negotiation is still handled by one worker in
+  /// order while independent negotiations can be handled concurrently.
+  WorkerWrapper(
+    rxcpp::schedulers::worker worker,
+    std::vector<rxcpp::schedulers::worker> negotiation_workers = {})
+  : _worker(std::move(worker)),
+    _negotiation_workers(std::move(negotiation_workers))
   {
     // Do nothing
   }
@@ -50,8 +64,161 @@ public:
     _worker.schedule([job = std::move(job)](const auto&) { job(); });
   }
 
+  void schedule_negotiation(
+    uint64_t conflict_version,
+    std::function<void()> job) final
+  {
+    if (_negotiation_workers.empty())
+      return schedule(std::move(job));
+
+    _negotiation_workers[conflict_version % _negotiation_workers.size()]
+    .schedule([job = std::move(job)](const auto&) { job(); });
+  }
+
 private:
   rxcpp::schedulers::worker _worker;
+  std::vector<rxcpp::schedulers::worker> _negotiation_workers;
+};
+
+//==============================================================================
+/// Measures the workers of an adapter when the worker_diagnostics_period or
+/// worker_trace_file parameter asks for it. Measuring costs a little time for
+/// every item that a worker runs, so by default the workers are left alone.
+class WorkerMonitors
+{
+public:
+
+  WorkerMonitors(Node& node)
+  {
+    _period = get_parameter_or_default_time(
+      node, "worker_diagnostics_period", 0.0);
+    _long_item_threshold = get_parameter_or_default_time(
+      node, "worker_long_item_threshold", 0.05);
+
+    const auto trace_file =
+      node.declare_parameter<std::string>("worker_trace_file", "");
+    if (!trace_file.empty())
+    {
+      _trace = std::make_shared<rmf_rxcpp::TraceFile>(trace_file);
+      if (!_trace->good())
+      {
+        RCLCPP_ERROR(
+          node.get_logger(),
+          "Unable to open worker_trace_file [%s]", trace_file.c_str());
+        _trace = nullptr;
+      }
+    }
+  }
+
+  bool enabled() const
+  {
+    return _period > std::chrono::nanoseconds(0) || _trace;
+  }
+
+  /// Get a worker that is measured under this name, or the same worker if
+  /// monitoring is not enabled
+  rxcpp::schedulers::worker wrap(
+    const std::string& name,
+    const rxcpp::schedulers::worker& worker)
+  {
+    if (!enabled())
+      return worker;
+
+    auto monitor = std::make_shared<rmf_rxcpp::WorkerMonitor>(
+      name, _long_item_threshold);
+    monitor->trace(_trace);
+    _monitors.push_back(monitor);
+    return monitor->wrap(worker);
+  }
+
+  /// Begin publishing the diagnostics of the workers
+  void start(Node& node)
+  {
+    if (_period <= std::chrono::nanoseconds(0) || _monitors.empty())
+      return;
+
+    _publisher = node.create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+      WorkerDiagnosticsTopicName, rclcpp::SystemDefaultsQoS());
+
+    _timer = node.try_create_wall_timer(
+      _period,
+      [monitors = _monitors, publisher = _publisher,
+      node_name = node.get_fully_qualified_name(),
+      threshold = _long_item_threshold, clock = node.get_clock()]()
+      {
+        publisher->publish(
+          make_diagnostics(monitors, node_name, threshold, clock->now()));
+      });
+  }
+
+private:
+
+  static diagnostic_msgs::msg::DiagnosticArray make_diagnostics(
+    const std::vector<std::shared_ptr<rmf_rxcpp::WorkerMonitor>>& monitors,
+    const std::string& node_name,
+    const std::chrono::nanoseconds threshold,
+    const rclcpp::Time& now)
+  {
+    using diagnostic_msgs::msg::DiagnosticStatus;
+    const auto key_value = [](std::string key, std::string value)
+      {
+        diagnostic_msgs::msg::KeyValue kv;
+        kv.key = std::move(key);
+        kv.value = std::move(value);
+        return kv;
+      };
+
+    const auto ms = [](const std::chrono::nanoseconds d)
+      {
+        return std::to_string(std::chrono::duration<double, std::milli>(d)
+          .count());
+      };
+
+    diagnostic_msgs::msg::DiagnosticArray msg;
+    msg.header.stamp = now;
+    for (const auto& monitor : monitors)
+    {
+      const auto report = monitor->take_report();
+      DiagnosticStatus status;
+      status.name = node_name + "/worker/" + report.name;
+      status.hardware_id = node_name;
+      const bool behind = report.max_latency > threshold;
+      status.level = report.long_items.empty() && !behind ?
+        DiagnosticStatus::OK : DiagnosticStatus::WARN;
+      status.message = behind ? "Items are waiting too long to run" :
+        report.long_items.empty() ? "OK" : "Some items ran for too long";
+
+      status.values.push_back(
+        key_value("depth", std::to_string(report.depth)));
+      status.values.push_back(
+        key_value("max_depth", std::to_string(report.max_depth)));
+      status.values.push_back(
+        key_value("executed", std::to_string(report.executed)));
+      status.values.push_back(
+        key_value("mean_latency_ms", ms(report.mean_latency)));
+      status.values.push_back(
+        key_value("max_latency_ms", ms(report.max_latency)));
+      status.values.push_back(
+        key_value("max_run_time_ms", ms(report.max_run_time)));
+      for (const auto& item : report.long_items)
+      {
+        status.values.push_back(
+          key_value("long_item_ms: " + item.tag, ms(item.run_time)));
+      }
+
+      msg.status.push_back(std::move(status));
+    }
+
+    return msg;
+  }
+
+  std::chrono::nanoseconds _period;
+  std::chrono::nanoseconds _long_item_threshold;
+  std::shared_ptr<rmf_rxcpp::TraceFile> _trace;
+  std::vector<std::shared_ptr<rmf_rxcpp::WorkerMonitor>> _monitors;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr
+    _publisher;
+  rclcpp::TimerBase::SharedPtr _timer;
 };
 
 //==============================================================================
@@ -61,10 +228,15 @@ public:
 
   rxcpp::schedulers::worker worker;
   std::shared_ptr<Node> node;
+  std::vector<rxcpp::schedulers::worker> robot_workers;
+  bool precompute_travel_times = false;
+
+  // Each fleet saves its planning cache here when the adapter is destroyed
+  std::string planning_cache_directory;
   std::shared_ptr<rmf_traffic_ros2::schedule::Negotiation> negotiation;
   std::shared_ptr<ParticipantFactory> schedule_writer;
   std::shared_ptr<rmf_traffic_ros2::blockade::Writer> blockade_writer;
-  rmf_traffic_ros2::schedule::MirrorManager mirror_manager;
+  std::shared_ptr<rmf_traffic_ros2::schedule::MirrorManager> mirror_manager;
 
   std::vector<std::shared_ptr<FleetUpdateHandle>> fleets = {};
 
@@ -88,12 +260,18 @@ public:
   // This mutex protects the initialization of traffic lights
   std::mutex _traffic_light_init_mutex;
 
+  std::optional<WorkerMonitors> worker_monitors;
+  std::unique_ptr<MemoryReportService> memory_report;
+
+  // The task traces are written here when the adapter is destroyed
+  std::string task_trace_file;
+
   Implementation(
     rxcpp::schedulers::worker worker_,
     std::shared_ptr<Node> node_,
     std::shared_ptr<rmf_traffic_ros2::schedule::Negotiation> negotiation_,
     std::shared_ptr<ParticipantFactory> writer_,
-    rmf_traffic_ros2::schedule::MirrorManager mirror_manager_)
+    std::shared_ptr<rmf_traffic_ros2::schedule::MirrorManager> mirror_manager_)
   : worker{std::move(worker_)},
     node{std::move(node_)},
     negotiation{std::move(negotiation_)},
@@ -104,6 +282,34 @@ public:
     // Do nothing
   }
 
+  ~Implementation()
+  {
+    if (!planning_cache_directory.empty())
+    {
+      for (const auto& fleet : fleets)
+      {
+        const auto& fleet_impl = FleetUpdateHandle::Implementation::get(*fleet);
+        fleet_impl.save_planning_cache(planning_cache_file(fleet_impl.name));
+      }
+    }
+
+    if (task_trace_file.empty())
+      return;
+
+    if (!tracing::write_chrome_trace(task_trace_file))
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Unable to write the task traces to [%s]",
+        task_trace_file.c_str());
+    }
+  }
+
+  std::string planning_cache_file(const std::string& fleet_name) const
+  {
+    return planning_cache_directory + "/" + fleet_name + ".planning_cache";
+  }
+
   static rmf_utils::unique_impl_ptr<Implementation> make(
     const std::string& node_name,
     const rclcpp::NodeOptions& node_options,
@@ -120,17 +326,38 @@ public:
       // *INDENT-ON*
     }
 
-    const auto worker = rxcpp::schedulers::make_event_loop().create_worker();
+    auto worker = rxcpp::schedulers::make_event_loop().create_worker();
     auto node = Node::make(worker, node_name, node_options);
 
+    WorkerMonitors worker_monitors(*node);
+    worker = worker_monitors.wrap("main", worker);
+    node->worker(worker);
+
     if (!discovery_timeout)
     {
       discovery_timeout =
         get_parameter_or_default_time(*node, "discovery_timeout", 60.0);
     }
 
-    auto mirror_future = rmf_traffic_ros2::schedule::make_mirror(
-      node, rmf_traffic::schedule::query_all());
+    // Adapters that share one process can share one mirror of the schedule
+    // instead of each keeping and updating a copy of it.
+    std::shared_ptr<SharedMirror> shared_mirror;
+    std::optional<rmf_traffic_ros2::schedule::MirrorManagerFuture>
+    mirror_future;
+    if (get_parameter_or_default<bool>(*node, "shared_schedule_mirror", false))
+    {
+      shared_mirror = SharedMirror::get(node_options.context());
+    }
+    else
+    {
+      // Planning jobs take snapshots of the mirror far more often than the
+      // schedule changes, so let them grab prebuilt snapshots instead of
+      // competing with the mirror updates.
+      mirror_future = rmf_traffic_ros2::schedule::make_mirror(
+        node, rmf_traffic::schedule::query_all(),
+        rmf_traffic_ros2::schedule::MirrorManager::Options()
+        .prebuilt_snapshots(true));
+    }
 
     auto writer = rmf_traffic_ros2::schedule::Writer::make(node);
 
@@ -151,23 +378,139 @@ public:
 
       bool ready = true;
       ready &= writer->ready();
-      ready &= (mirror_future.wait_for(0s) == std::future_status::ready);
+      if (shared_mirror)
+        ready &= shared_mirror->ready();
+      else
+        ready &= (mirror_future->wait_for(0s) == std::future_status::ready);
 
       if (ready)
       {
-        auto mirror_manager = mirror_future.get();
+        auto mirror_manager = shared_mirror ?
+          shared_mirror->manager() :
+          std::make_shared<rmf_traffic_ros2::schedule::MirrorManager>(
+          mirror_future->get());
+
+        // With a single worker, every negotiation gets handled one after
+        // another on the main worker of the adapter.
+        std::vector<rxcpp::schedulers::worker> negotiation_workers;
+        const auto negotiation_worker_count =
+          get_parameter_or_default<int64_t>(*node, "negotiation_workers", 1);
+        if (negotiation_worker_count > 1)
+        {
+          const auto event_loop = rxcpp::schedulers::make_event_loop();
+          for (int64_t i = 0; i < negotiation_worker_count; ++i)
+          {
+            negotiation_workers.push_back(
+              worker_monitors.wrap(
+                "negotiation_" + std::to_string(i),
+                event_loop.create_worker()));
+          }
+        }
 
         auto negotiation =
           std::make_shared<rmf_traffic_ros2::schedule::Negotiation>(
-          *node, mirror_manager.snapshot_handle(),
-          std::make_shared<WorkerWrapper>(worker));
-
-        return rmf_utils::make_unique_impl<Implementation>(
+          *node, mirror_manager->snapshot_handle(),
+          std::make_shared<WorkerWrapper>(
+            worker, std::move(negotiation_workers)));
+
+        // Adapters that do not observe every negotiation on the site can skip
+        // the ones that none of their robots are part of.
+        negotiation->follow_unrelated_negotiations(
+          get_parameter_or_default<bool>(
+            *node, "follow_unrelated_negotiations", true));
+
+        // Negotiations between the robots of this adapter can be approved as
+        // soon as they are resolved instead of waiting for the schedule node
+        // to conclude them. This is opt-in because it changes how robots
+        // react to the conclusions of those negotiations.
+        negotiation->resolve_local_negotiations(
+          get_parameter_or_default<bool>(
+            *node, "resolve_local_negotiations", false));
+
+        // The tables that are waiting for a response can be ordered by
+        // "most_recent", "depth", or "deadline"
+        using TablePriority =
+          rmf_traffic_ros2::schedule::Negotiation::TablePriority;
+        const auto table_priority =
+          node->declare_parameter<std::string>(
+          "negotiation_table_priority", "most_recent");
+        if (table_priority == "depth")
+          negotiation->table_priority(TablePriority::Depth);
+        else if (table_priority == "deadline")
+          negotiation->table_priority(TablePriority::Deadline);
+        else if (table_priority != "most_recent")
+        {
+          RCLCPP_WARN(
+            node->get_logger(),
+            "Unknown negotiation_table_priority [%s]; using [most_recent]",
+            table_priority.c_str());
+        }
+
+        // With a single worker, every robot shares the main worker of the
+        // adapter. Otherwise the robots are spread across a pool of workers
+        // that run on the threads of an event loop.
+        std::vector<rxcpp::schedulers::worker> robot_workers;
+        const auto robot_worker_count =
+          get_parameter_or_default<int64_t>(*node, "robot_workers", 1);
+        if (robot_worker_count > 1)
+        {
+          const auto event_loop = rxcpp::schedulers::make_event_loop();
+          for (int64_t i = 0; i < robot_worker_count; ++i)
+          {
+            robot_workers.push_back(
+              worker_monitors.wrap(
+                "robot_" + std::to_string(i), event_loop.create_worker()));
+          }
+        }
+
+        // Without any planning threads, each planning job keeps advancing on
+        // the worker that it was started on.
+        const auto planning_threads =
+          get_parameter_or_default<int64_t>(*node, "planning_threads", 0);
+        const auto planning_admission_limit =
+          get_parameter_or_default<int64_t>(
+          *node, "planning_admission_limit", planning_threads - 1);
+        jobs::PlanningPool::configure(
+          static_cast<std::size_t>(std::max<int64_t>(planning_threads, 0)),
+          static_cast<std::size_t>(
+            std::max<int64_t>(planning_admission_limit, 0)));
+
+        auto impl = rmf_utils::make_unique_impl<Implementation>(
           worker,
           std::move(node),
           std::move(negotiation),
           std::make_shared<ParticipantFactoryRos2>(std::move(writer)),
           std::move(mirror_manager));
+
+        impl->robot_workers = std::move(robot_workers);
+        impl->precompute_travel_times =
+          get_parameter_or_default(
+          *impl->node, "precompute_travel_times", false);
+        impl->planning_cache_directory =
+          impl->node->declare_parameter<std::string>(
+          "planning_cache_directory", "");
+        worker_monitors.start(*impl->node);
+        impl->worker_monitors = std::move(worker_monitors);
+        impl->memory_report = std::make_unique<MemoryReportService>(
+          *impl->node,
+          [self = impl.get()]()
+          {
+            auto lock = self->lock_mutex();
+            return self->fleets;
+          },
+          impl->mirror_manager->snapshot_handle());
+
+        // Task tracing is process wide, so the ring buffer is shared by all
+        // the adapters in this process.
+        const auto task_trace_capacity = get_parameter_or_default<int64_t>(
+          *impl->node, "task_trace_capacity", 0);
+        if (task_trace_capacity > 0)
+        {
+          tracing::enable(static_cast<std::size_t>(task_trace_capacity));
+          impl->task_trace_file = impl->node->declare_parameter<std::string>(
+            "task_trace_file", "fleet_adapter_task_trace.json");
+        }
+        return impl;
       }
     }
 
@@ -221,9 +564,21 @@ std::shared_ptr<FleetUpdateHandle> Adapter::add_fleet(
 
   auto fleet = FleetUpdateHandle::Implementation::make(
     fleet_name, std::move(planner), _pimpl->node, _pimpl->worker,
-    _pimpl->schedule_writer, _pimpl->mirror_manager.snapshot_handle(),
+    _pimpl->schedule_writer, _pimpl->mirror_manager->snapshot_handle(),
     _pimpl->negotiation, server_uri);
 
+  auto& fleet_impl = FleetUpdateHandle::Implementation::get(*fleet);
+  fleet_impl.robot_workers = _pimpl->robot_workers;
+  if (!_pimpl->planning_cache_directory.empty())
+  {
+    fleet_impl.load_planning_cache(
+      _pimpl->planning_cache_file(fleet_impl.name));
+  }
+
+  if (_pimpl->precompute_travel_times)
+    fleet_impl.precompute_travel_times();
+
+  auto lock = _pimpl->lock_mutex();
   _pimpl->fleets.push_back(fleet);
   return fleet;
 }
@@ -262,7 +617,7 @@ void Adapter::add_traffic_light(
     command = std::move(command),
     traits = std::move(traits),
     blockade_writer = _pimpl->blockade_writer,
-    schedule = _pimpl->mirror_manager.snapshot_handle(),
+    schedule = _pimpl->mirror_manager->snapshot_handle(),
     worker = _pimpl->worker,
     handle_cb = std::move(handle_cb),
     negotiation = _pimpl->negotiation,
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_ChargerScheduler.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+ChargerScheduler::ChargerScheduler(
+  std::vector<std::size_t> chargers,
+  Config config)
+: _chargers(std::move(chargers)),
+  _config(config)
+{
+  std::sort(_chargers.begin(), _chargers.end());
+}
+
+//==============================================================================
+const std::vector<std::size_t>& ChargerScheduler::chargers() const
+{
+  return _chargers;
+}
+
+//==============================================================================
+std::optional<std::size_t> ChargerScheduler::assign(
+  const std::string& robot,
+  const std::vector<Option>& options)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto previous = _charger_of.find(robot);
+
+  std::optional<std::size_t> best;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (const auto& option : options)
+  {
+    std::size_t others = 0;
+    const auto count = _dedicated_count.find(option.charger);
+    if (count != _dedicated_count.end())
+      others = count->second;
+
+    if (previous != _charger_of.end() && previous->second == option.charger)
+      --others;
+
+    const double cost = option.travel_time + _config.share_penalty * others;
+    if (cost < best_cost)
+    {
+      best_cost = cost;
+      best = option.charger;
+    }
+  }
+
+  if (!best.has_value())
+    return std::nullopt;
+
+  if (previous != _charger_of.end())
+    --_dedicated_count[previous->second];
+
+  _charger_of[robot] = *best;
+  ++_dedicated_count[*best];
+  return best;
+}
+
+//==============================================================================
+void ChargerScheduler::assign(const std::string& robot, std::size_t charger)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto insertion = _charger_of.insert({robot, charger});
+  if (!insertion.second)
+  {
+    --_dedicated_count[insertion.first->second];
+    insertion.first->second = charger;
+  }
+
+  ++_dedicated_count[charger];
+}
+
+//==============================================================================
+std::optional<std::size_t> ChargerScheduler::charger_of(
+  const std::string& robot) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _charger_of.find(robot);
+  if (it == _charger_of.end())
+    return std::nullopt;
+
+  return it->second;
+}
+
+//==============================================================================
+auto ChargerScheduler::reserve(
+  const std::string& robot,
+  const std::vector<Option>& options,
+  const rmf_traffic::Duration duration,
+  const rmf_traffic::Time now) -> std::optional<Reservation>
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  // Windows that have already ended are no longer in anyone's way
+  for (auto& [_, windows] : _windows)
+  {
+    windows.erase(
+      std::remove_if(
+        windows.begin(), windows.end(),
+        [now](const Window& w) { return w.end <= now; }),
+      windows.end());
+  }
+
+  std::optional<std::size_t> dedicated;
+  const auto current = _charger_of.find(robot);
+  if (current != _charger_of.end())
+    dedicated = current->second;
+
+  std::optional<Reservation> best;
+  for (const auto& option : options)
+  {
+    const auto arrival = now + rmf_traffic::time::from_seconds(
+      std::max(0.0, option.travel_time));
+    const auto begin =
+      _earliest_free(option.charger, robot, arrival, duration);
+
+    const bool better = !best.has_value()
+      || begin < best->window.begin
+      || (begin == best->window.begin && option.charger == dedicated);
+
+    if (better)
+    {
+      best = Reservation{
+        option.charger, Window{robot, begin, begin + duration}};
+    }
+  }
+
+  if (!best.has_value())
+    return std::nullopt;
+
+  _release(robot);
+  auto& windows = _windows[best->charger];
+  windows.insert(
+    std::upper_bound(
+      windows.begin(), windows.end(), best->window,
+      [](const Window& a, const Window& b) { return a.begin < b.begin; }),
+    best->window);
+
+  if (dedicated != best->charger)
+  {
+    if (dedicated.has_value())
+      --_dedicated_count[*dedicated];
+
+    _charger_of[robot] = best->charger;
+    ++_dedicated_count[best->charger];
+  }
+
+  return best;
+}
+
+//==============================================================================
+void ChargerScheduler::release(const std::string& robot)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _release(robot);
+}
+
+//==============================================================================
+void ChargerScheduler::remove(const std::string& robot)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _release(robot);
+  const auto it = _charger_of.find(robot);
+  if (it == _charger_of.end())
+    return;
+
+  --_dedicated_count[it->second];
+  _charger_of.erase(it);
+}
+
+//==============================================================================
+auto ChargerScheduler::windows(std::size_t charger) const -> std::vector<Window>
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _windows.find(charger);
+  if (it == _windows.end())
+    return {};
+
+  return it->second;
+}
+
+//==============================================================================
+rmf_traffic::Time ChargerScheduler::_earliest_free(
+  const std::size_t charger,
+  const std::string& robot,
+  rmf_traffic::Time time,
+  const rmf_traffic::Duration duration) const
+{
+  const auto it = _windows.find(charger);
+  if (it == _windows.end())
+    return time;
+
+  // The windows are ordered by when they begin, so the first gap that is long
+  // enough is the earliest one.
+  for (const auto& window : it->second)
+  {
+    if (window.robot == robot || window.end <= time)
+      continue;
+
+    if (time + duration <= window.begin)
+      break;
+
+    time = window.end;
+  }
+
+  return time;
+}
+
+//==============================================================================
+void ChargerScheduler::_release(const std::string& robot)
+{
+  for (auto& [_, windows] : _windows)
+  {
+    windows.erase(
+      std::remove_if(
+        windows.begin(), windows.end(),
+        [&robot](const Window& w) { return w.robot == robot; }),
+      windows.end());
+  }
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
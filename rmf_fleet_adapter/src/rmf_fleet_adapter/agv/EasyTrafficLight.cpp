@@ -16,6 +16,7 @@
 */
 
 #include "internal_EasyTrafficLight.hpp"
+#include "internal_TrafficLight.hpp"
 
 namespace rmf_fleet_adapter {
 namespace agv {
@@ -647,6 +648,95 @@ EasyTrafficLight& EasyTrafficLight::fleet_state_publish_period(
   return *this;
 }
 
+//==============================================================================
+auto EasyTrafficLight::State::moving_from(
+  std::shared_ptr<EasyTrafficLight> robot,
+  const std::size_t checkpoint,
+  Eigen::Vector3d location) -> State
+{
+  return State{std::move(robot), Type::MovingFrom, checkpoint, location, {}};
+}
+
+//==============================================================================
+auto EasyTrafficLight::State::waiting_at(
+  std::shared_ptr<EasyTrafficLight> robot,
+  const std::size_t checkpoint) -> State
+{
+  return State{
+    std::move(robot), Type::WaitingAt, checkpoint,
+    Eigen::Vector3d::Zero(), {}
+  };
+}
+
+//==============================================================================
+auto EasyTrafficLight::State::waiting_after(
+  std::shared_ptr<EasyTrafficLight> robot,
+  const std::size_t checkpoint,
+  Eigen::Vector3d location) -> State
+{
+  return State{std::move(robot), Type::WaitingAfter, checkpoint, location, {}};
+}
+
+//==============================================================================
+auto EasyTrafficLight::State::idle(
+  std::shared_ptr<EasyTrafficLight> robot,
+  std::string map_name,
+  Eigen::Vector3d location) -> State
+{
+  return State{
+    std::move(robot), Type::Idle, 0, location, std::move(map_name)
+  };
+}
+
+//==============================================================================
+auto EasyTrafficLight::update_states(const std::vector<State>& states)
+-> std::vector<Instruction>
+{
+  std::vector<Instruction> instructions;
+  instructions.reserve(states.size());
+
+  // Every traffic update that gets triggered in here will be handed to the
+  // worker of the adapter together when this goes out of scope.
+  TrafficLight::UpdateHandle::Implementation::BatchUpdates batch;
+
+  for (const auto& state : states)
+  {
+    Instruction instruction;
+    if (!state.robot)
+    {
+      instructions.push_back(instruction);
+      continue;
+    }
+
+    auto& impl = *state.robot->_pimpl;
+    auto lock = impl.lock();
+    switch (state.type)
+    {
+      case State::Type::MovingFrom:
+        instruction.moving = impl.moving_from(state.checkpoint, state.location);
+        break;
+      case State::Type::WaitingAt:
+        instruction.waiting = impl.waiting_at(state.checkpoint);
+        break;
+      case State::Type::WaitingAfter:
+        instruction.waiting =
+          impl.waiting_after(state.checkpoint, state.location);
+        break;
+      case State::Type::Idle:
+        if (!impl.current_path.empty())
+          impl.clear();
+
+        impl.update_handle->update_idle_location(
+          state.map_name, state.location);
+        break;
+    }
+
+    instructions.push_back(instruction);
+  }
+
+  return instructions;
+}
+
 //==============================================================================
 EasyTrafficLightPtr EasyTrafficLight::Implementation::make(
   TrafficLight::UpdateHandlePtr update_handle_,
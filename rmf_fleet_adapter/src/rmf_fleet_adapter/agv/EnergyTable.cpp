@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_EnergyTable.hpp"
+#include "../MemoryUsage.hpp"
+
+#include <rmf_traffic/agv/Interpolate.hpp>
+
+#include <cmath>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+const double Unreachable = std::numeric_limits<double>::infinity();
+const double Unknown = std::numeric_limits<double>::quiet_NaN();
+
+//==============================================================================
+double lane_motion_charge(
+  const rmf_traffic::agv::Graph::Waypoint& entry,
+  const rmf_traffic::agv::Graph::Waypoint& exit,
+  const rmf_traffic::agv::VehicleTraits& traits,
+  const rmf_battery::MotionPowerSink& motion_sink)
+{
+  // Lanes between maps are taken by lifts, which the robot does not drive
+  if (entry.get_map_name() != exit.get_map_name())
+    return 0.0;
+
+  const Eigen::Vector2d p0 = entry.get_location();
+  const Eigen::Vector2d p1 = exit.get_location();
+  const Eigen::Vector2d d = p1 - p0;
+  if (d.norm() < 1e-8)
+    return 0.0;
+
+  const double yaw = std::atan2(d.y(), d.x());
+  const auto trajectory = rmf_traffic::agv::Interpolate::positions(
+    traits, std::chrono::steady_clock::time_point(),
+    {{p0.x(), p0.y(), yaw}, {p1.x(), p1.y(), yaw}});
+
+  return motion_sink.compute_change_in_charge(trajectory);
+}
+} // anonymous namespace
+
+//==============================================================================
+EnergyTable::EnergyTable(
+  std::shared_ptr<const TravelTimeTable> travel_times,
+  const rmf_traffic::agv::Planner::Configuration& config,
+  std::shared_ptr<rmf_battery::MotionPowerSink> motion_sink,
+  std::shared_ptr<rmf_battery::DevicePowerSink> ambient_sink)
+: _travel_times(std::move(travel_times)),
+  _ambient_sink(std::move(ambient_sink)),
+  _num_waypoints(config.graph().num_waypoints())
+{
+  const auto& graph = config.graph();
+  _lane_charge.reserve(graph.num_lanes());
+  _lane_entry.reserve(graph.num_lanes());
+  for (std::size_t i = 0; i < graph.num_lanes(); ++i)
+  {
+    const auto& lane = graph.get_lane(i);
+    const auto entry = lane.entry().waypoint_index();
+    const auto exit = lane.exit().waypoint_index();
+    _lane_charge.push_back(
+      lane_motion_charge(
+        graph.get_waypoint(entry), graph.get_waypoint(exit),
+        config.vehicle_traits(), *motion_sink));
+    _lane_entry.push_back(entry);
+  }
+}
+
+//==============================================================================
+std::optional<double> EnergyTable::change_in_charge(
+  const std::size_t from,
+  const std::size_t to) const
+{
+  const auto time = _travel_times->travel_time(from, to);
+  if (!time.has_value())
+    return std::nullopt;
+
+  double motion = 0.0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    motion = _row(from).at(to);
+  }
+
+  if (motion == Unreachable)
+    return std::nullopt;
+
+  return motion + _ambient_sink->compute_change_in_charge(*time);
+}
+
+//==============================================================================
+std::optional<double> EnergyTable::change_in_charge(
+  const rmf_traffic::agv::Planner::Start& start,
+  const std::size_t to) const
+{
+  const auto charge = change_in_charge(start.waypoint(), to);
+  if (!charge.has_value())
+    return std::nullopt;
+
+  const auto total_time = _travel_times->travel_time(start, to);
+  const auto waypoint_time = _travel_times->travel_time(start.waypoint(), to);
+  if (!total_time.has_value() || !waypoint_time.has_value())
+    return charge;
+
+  return *charge + _ambient_sink->compute_change_in_charge(
+    *total_time - *waypoint_time);
+}
+
+//==============================================================================
+void EnergyTable::precompute() const
+{
+  for (std::size_t i = 0; i < _num_waypoints; ++i)
+  {
+    // The lock is taken for one row at a time so that lookups do not need to
+    // wait for the whole table.
+    std::lock_guard<std::mutex> lock(_mutex);
+    _row(i);
+  }
+}
+
+//==============================================================================
+void EnergyTable::update_lane_closures()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _rows.clear();
+}
+
+//==============================================================================
+std::size_t EnergyTable::approximate_bytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t bytes = 0;
+  for (const auto& [_, row] : _rows)
+  {
+    bytes += ContainerNodeBytes + sizeof(std::size_t) + sizeof(row)
+      + rmf_fleet_adapter::approximate_bytes(row);
+  }
+
+  return bytes;
+}
+
+//==============================================================================
+const std::vector<double>& EnergyTable::_row(const std::size_t from) const
+{
+  auto it = _rows.find(from);
+  if (it == _rows.end())
+    it = _rows.insert({from, _search(from)}).first;
+
+  return it->second;
+}
+
+//==============================================================================
+std::vector<double> EnergyTable::_search(const std::size_t from) const
+{
+  const auto arrival = _travel_times->arrival_lanes(from);
+  std::vector<double> charge(_num_waypoints, Unknown);
+  charge.at(from) = 0.0;
+
+  std::vector<std::size_t> path;
+  for (std::size_t to = 0; to < _num_waypoints; ++to)
+  {
+    // Walk back along the shortest path until we reach a waypoint whose drain
+    // is already known, then add up the lanes on the way forward again.
+    std::size_t wp = to;
+    path.clear();
+    while (std::isnan(charge[wp]))
+    {
+      if (arrival[wp] == TravelTimeTable::NoLane)
+      {
+        charge[wp] = Unreachable;
+        break;
+      }
+
+      path.push_back(wp);
+      wp = _lane_entry[arrival[wp]];
+    }
+
+    for (auto p = path.rbegin(); p != path.rend(); ++p)
+    {
+      const auto lane = arrival[*p];
+      charge[*p] = charge[_lane_entry[lane]] + _lane_charge[lane];
+    }
+  }
+
+  return charge;
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_FleetShards.hpp"
+
+#include <rmf_fleet_adapter/StandardNames.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+std::string shard_topic(const std::string& fleet, const std::string& topic)
+{
+  // Fleet names may contain characters that are not allowed in topic names
+  std::string name = fleet;
+  for (auto& c : name)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(c)))
+      c = '_';
+  }
+
+  return FleetShardTopicPrefix + name + "/" + topic;
+}
+} // anonymous namespace
+
+//==============================================================================
+std::shared_ptr<FleetShards> FleetShards::make(
+  const std::shared_ptr<rclcpp::Node>& node,
+  Config config,
+  ReceiveNotice receive_notice,
+  ReceiveDispatch receive_dispatch)
+{
+  auto shards =
+    std::shared_ptr<FleetShards>(new FleetShards(std::move(config)));
+  shards->_node = node;
+  shards->_receive_notice = std::move(receive_notice);
+  shards->_receive_dispatch = std::move(receive_dispatch);
+
+  const auto& fleet = shards->_config.fleet;
+  const auto qos = rclcpp::ServicesQoS().reliable();
+  const auto dispatch_qos =
+    rclcpp::ServicesQoS().keep_last(20).transient_local();
+
+  shards->_notice_sub = node->create_subscription<BidNoticeMsg>(
+    shard_topic(fleet, "bid_notices"), qos,
+    [w = shards->weak_from_this()](const BidNoticeMsg::SharedPtr msg)
+    {
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      self->_receive_notice(
+        *msg,
+        std::chrono::steady_clock::now() + self->_config.bid_timeout,
+        [w, task_id = msg->task_id](
+          rmf_task_ros2::bidding::Response response)
+        {
+          const auto self = w.lock();
+          if (!self)
+            return;
+
+          // Tell the coordinator which shard this proposal came from
+          if (response.proposal.has_value())
+            response.proposal->fleet_name = self->_config.shard;
+
+          self->_response_pub->publish(
+            rmf_task_ros2::bidding::convert(response, task_id));
+        });
+    });
+
+  shards->_response_pub = node->create_publisher<BidResponseMsg>(
+    shard_topic(fleet, "bid_responses"), qos);
+
+  shards->_dispatch_sub = node->create_subscription<DispatchCmdMsg>(
+    shard_topic(fleet, "dispatch_commands"), dispatch_qos,
+    [w = shards->weak_from_this()](const DispatchCmdMsg::SharedPtr msg)
+    {
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      // A command for every shard carries the name of the fleet itself
+      auto command = std::make_shared<DispatchCmdMsg>(*msg);
+      if (msg->fleet_name == self->_config.shard)
+        command->fleet_name = self->_config.fleet;
+      else if (msg->fleet_name != self->_config.fleet)
+        command->fleet_name = "";
+
+      self->_receive_dispatch(std::move(command));
+    });
+
+  if (shards->_config.coordinator)
+  {
+    shards->_notice_pub = node->create_publisher<BidNoticeMsg>(
+      shard_topic(fleet, "bid_notices"), qos);
+
+    shards->_dispatch_pub = node->create_publisher<DispatchCmdMsg>(
+      shard_topic(fleet, "dispatch_commands"), dispatch_qos);
+
+    shards->_response_sub = node->create_subscription<BidResponseMsg>(
+      shard_topic(fleet, "bid_responses"), qos,
+      [w = shards->weak_from_this()](const BidResponseMsg::SharedPtr msg)
+      {
+        if (const auto self = w.lock())
+          self->_receive_response(*msg);
+      });
+  }
+
+  return shards;
+}
+
+//==============================================================================
+auto FleetShards::config() const -> const Config&
+{
+  return _config;
+}
+
+//==============================================================================
+void FleetShards::auction(const BidNoticeMsg& notice, Respond respond)
+{
+  const auto node = _node.lock();
+  if (!node || !_config.coordinator)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& auction = _auctions[notice.task_id];
+    auction.respond = std::move(respond);
+    auction.waiting_for = _config.shards;
+    if (std::find(
+        auction.waiting_for.begin(), auction.waiting_for.end(),
+        _config.shard) == auction.waiting_for.end())
+    {
+      auction.waiting_for.push_back(_config.shard);
+    }
+
+    auction.timeout = node->create_wall_timer(
+      _config.bid_timeout,
+      [w = weak_from_this(), task_id = notice.task_id]()
+      {
+        if (const auto self = w.lock())
+          self->_conclude(task_id);
+      });
+  }
+
+  _notice_pub->publish(notice);
+}
+
+//==============================================================================
+void FleetShards::forward(const DispatchCmdMsg& command)
+{
+  if (!_config.coordinator)
+    return;
+
+  auto shard_command = command;
+  if (command.fleet_name == _config.fleet)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _owners.find(command.task_id);
+    if (it != _owners.end())
+    {
+      shard_command.fleet_name = it->second;
+      if (command.type == DispatchCmdMsg::TYPE_REMOVE)
+        _owners.erase(it);
+    }
+  }
+  else
+  {
+    // The task went to another fleet, so none of the shards own it
+    std::lock_guard<std::mutex> lock(_mutex);
+    _owners.erase(command.task_id);
+  }
+
+  _dispatch_pub->publish(shard_command);
+}
+
+//==============================================================================
+FleetShards::FleetShards(Config config)
+: _config(std::move(config))
+{
+  // Do nothing
+}
+
+//==============================================================================
+void FleetShards::_receive_response(const BidResponseMsg& msg)
+{
+  bool finished = false;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _auctions.find(msg.task_id);
+    if (it == _auctions.end())
+      return;
+
+    auto& auction = it->second;
+    auto response = rmf_task_ros2::bidding::convert(msg);
+    auction.errors.insert(
+      auction.errors.end(), response.errors.begin(), response.errors.end());
+
+    std::string shard;
+    if (response.proposal.has_value())
+    {
+      shard = response.proposal->fleet_name;
+      const auto& p = *response.proposal;
+      const auto& best = auction.best;
+      if (!best.has_value()
+        || p.new_cost - p.prev_cost < best->new_cost - best->prev_cost)
+      {
+        auction.best = p;
+        auction.best_shard = shard;
+      }
+    }
+
+    // A shard that declines does not say who it is, so the auction can only
+    // end early once every shard has made a proposal.
+    auto& waiting = auction.waiting_for;
+    waiting.erase(
+      std::remove(waiting.begin(), waiting.end(), shard), waiting.end());
+    finished = waiting.empty();
+  }
+
+  if (finished)
+    _conclude(msg.task_id);
+}
+
+//==============================================================================
+void FleetShards::_conclude(const std::string& task_id)
+{
+  Auction auction;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _auctions.find(task_id);
+    if (it == _auctions.end())
+      return;
+
+    auction = std::move(it->second);
+    _auctions.erase(it);
+
+    if (auction.best.has_value())
+      _owners[task_id] = auction.best_shard;
+  }
+
+  auction.timeout->cancel();
+  if (auction.best.has_value())
+    auction.best->fleet_name = _config.fleet;
+
+  auction.respond({auction.best, std::move(auction.errors)});
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_FleetStateAggregator.hpp"
+
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+std::shared_ptr<FleetStateAggregator> FleetStateAggregator::make(
+  FleetStatePub publisher,
+  MakeTimer make_timer)
+{
+  return std::shared_ptr<FleetStateAggregator>(
+    new FleetStateAggregator(std::move(publisher), std::move(make_timer)));
+}
+
+//==============================================================================
+auto FleetStateAggregator::add(const std::string& fleet_name, Report report)
+-> RegistrationPtr
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto id = _next_id++;
+  auto& fleet = _fleets[fleet_name];
+  fleet.robots.insert({id, std::move(report)});
+  if (!fleet.timer)
+    fleet.timer = _make_timer(fleet_name, fleet.period);
+
+  return RegistrationPtr(new Registration(weak_from_this(), fleet_name, id));
+}
+
+//==============================================================================
+void FleetStateAggregator::set_period(
+  const std::string& fleet_name,
+  const std::chrono::nanoseconds period)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& fleet = _fleets[fleet_name];
+  if (fleet.period == period && fleet.timer)
+    return;
+
+  fleet.period = period;
+  if (!fleet.robots.empty())
+    fleet.timer = _make_timer(fleet_name, period);
+}
+
+//==============================================================================
+FleetStateAggregator::FleetStateAggregator(
+  FleetStatePub publisher,
+  MakeTimer make_timer)
+: _publisher(std::move(publisher)),
+  _timer_factory(std::move(make_timer))
+{
+  // Do nothing
+}
+
+//==============================================================================
+TimerWheel::TimerPtr FleetStateAggregator::_make_timer(
+  const std::string& fleet_name,
+  const std::chrono::nanoseconds period)
+{
+  return _timer_factory(
+    period,
+    [w = weak_from_this(), fleet_name]()
+    {
+      if (const auto self = w.lock())
+        self->_publish(fleet_name);
+    });
+}
+
+//==============================================================================
+void FleetStateAggregator::_remove(const std::string& fleet_name, uint64_t id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _fleets.find(fleet_name);
+  if (it == _fleets.end())
+    return;
+
+  it->second.robots.erase(id);
+  if (it->second.robots.empty())
+  {
+    // Keep the period of the fleet in case its robots come back, but stop
+    // publishing for it.
+    it->second.timer = nullptr;
+  }
+}
+
+//==============================================================================
+void FleetStateAggregator::_publish(const std::string& fleet_name)
+{
+  std::vector<Report> reports;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _fleets.find(fleet_name);
+    if (it == _fleets.end())
+      return;
+
+    reports.reserve(it->second.robots.size());
+    for (const auto& [_, report] : it->second.robots)
+      reports.push_back(report);
+  }
+
+  // The reports are called outside of the lock since they may take a while
+  // to put together.
+  FleetState msg;
+  msg.name = fleet_name;
+  msg.robots.reserve(reports.size());
+  for (const auto& report : reports)
+  {
+    if (auto state = report())
+      msg.robots.emplace_back(std::move(*state));
+  }
+
+  if (msg.robots.empty())
+    return;
+
+  _publisher->publish(std::move(msg));
+}
+
+//==============================================================================
+FleetStateAggregator::Registration::~Registration()
+{
+  if (const auto aggregator = _aggregator.lock())
+    aggregator->_remove(_fleet_name, _id);
+}
+
+//==============================================================================
+FleetStateAggregator::Registration::Registration(
+  std::weak_ptr<FleetStateAggregator> aggregator,
+  std::string fleet_name,
+  const uint64_t id)
+: _aggregator(std::move(aggregator)),
+  _fleet_name(std::move(fleet_name)),
+  _id(id)
+{
+  // Do nothing
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -33,6 +33,8 @@
 #include "../tasks/Compose.hpp"
 #include "../events/GoToPlace.hpp"
 #include "../events/PerformAction.hpp"
+#include "../jobs/PlanningPool.hpp"
+#include "../tracing.hpp"
 
 #include <rmf_task/Constraints.hpp>
 #include <rmf_task/Parameters.hpp>
@@ -43,10 +45,18 @@
 
 #include <rmf_task_sequence/phases/SimplePhase.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <stdexcept>
+#include <limits>
+#include <mutex>
 
 #include <rmf_fleet_adapter/schemas/place.hpp>
 #include <rmf_api_msgs/schemas/task_request.hpp>
@@ -134,6 +144,56 @@ TaskDeserialization::TaskDeserialization()
     };
 }
 
+//==============================================================================
+ValidatedDescriptions::ValidatedDescriptions(std::size_t capacity)
+: _capacity(capacity)
+{
+  // Do nothing
+}
+
+//==============================================================================
+bool ValidatedDescriptions::contains(
+  const std::string& category,
+  const nlohmann::json& description)
+{
+  const auto key = _key(category, description);
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _index.find(key);
+  if (it == _index.end())
+    return false;
+
+  _order.splice(_order.begin(), _order, it->second);
+  return true;
+}
+
+//==============================================================================
+void ValidatedDescriptions::insert(
+  const std::string& category,
+  const nlohmann::json& description)
+{
+  auto key = _key(category, description);
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_index.count(key) > 0)
+    return;
+
+  _order.push_front(std::move(key));
+  _index.insert({_order.front(), _order.begin()});
+  while (_order.size() > _capacity)
+  {
+    _index.erase(_order.back());
+    _order.pop_back();
+  }
+}
+
+//==============================================================================
+std::string ValidatedDescriptions::_key(
+  const std::string& category,
+  const nlohmann::json& description)
+{
+  // The keys of json objects are kept sorted, so equal descriptions always
+  // dump to the same string.
+  return category + '\n' + description.dump();
+}
 
 //==============================================================================
 void FleetUpdateHandle::Implementation::dock_summary_cb(
@@ -155,7 +215,7 @@ void FleetUpdateHandle::Implementation::dock_summary_cb(
 
 //==============================================================================
 std::string FleetUpdateHandle::Implementation::make_error_str(
-  uint64_t code, std::string category, std::string detail) const
+  uint64_t code, std::string category, std::string detail)
 {
   nlohmann::json error;
   error["code"] = code;
@@ -188,7 +248,11 @@ std::shared_ptr<rmf_task::Request> FleetUpdateHandle::Implementation::convert(
 
   try
   {
-    task_deser_handler.validator->validate(description_msg);
+    if (!validated_descriptions.contains(category, description_msg))
+    {
+      task_deser_handler.validator->validate(description_msg);
+      validated_descriptions.insert(category, description_msg);
+    }
   }
   catch (const std::exception& e)
   {
@@ -269,10 +333,12 @@ std::shared_ptr<rmf_task::Request> FleetUpdateHandle::Implementation::convert(
 //==============================================================================
 void FleetUpdateHandle::Implementation::bid_notice_cb(
   const BidNoticeMsg& bid_notice,
+  rmf_task_ros2::bidding::AsyncBidder::Deadline deadline,
   rmf_task_ros2::bidding::AsyncBidder::Respond respond)
 {
   // TODO(YV): Consider moving these checks into convert()
   const auto& task_id = bid_notice.task_id;
+  tracing::Span span("bid_notice", task_id);
   if (task_managers.empty())
   {
     RCLCPP_INFO(
@@ -280,7 +346,9 @@ void FleetUpdateHandle::Implementation::bid_notice_cb(
       "Fleet [%s] does not have any robots to accept task [%s]. Use "
       "FleetUpdateHandle::add_robot(~) to add robots to this fleet. ",
       name.c_str(), task_id.c_str());
-    return;
+
+    // Decline so the auction does not need to wait for us
+    return respond({std::nullopt, {}});
   }
 
   if (task_id.empty())
@@ -304,7 +372,46 @@ void FleetUpdateHandle::Implementation::bid_notice_cb(
       "Use FleetUpdateHandle::set_task_planner_params(~) to set the "
       "parameters required.", name.c_str());
 
-    return;
+    return respond({std::nullopt, {}});
+  }
+
+  // A proposal that arrives after the auction has closed is thrown away, so
+  // decline now and let the auction conclude without waiting for us.
+  const auto evaluation_start = std::chrono::steady_clock::now();
+  if (bid_evaluation_estimate.has_value()
+    && evaluation_start + *bid_evaluation_estimate > deadline)
+  {
+    RCLCPP_WARN(
+      node->get_logger(),
+      "Fleet [%s] is declining task [%s] because its bid would take about "
+      "[%.2f]s to evaluate, which is longer than the auction has left.",
+      name.c_str(), task_id.c_str(),
+      rmf_traffic::time::to_seconds(*bid_evaluation_estimate));
+
+    // Shrink the estimate so that a single slow evaluation cannot keep this
+    // fleet out of every auction
+    bid_evaluation_estimate =
+      std::chrono::duration_cast<rmf_traffic::Duration>(
+      0.8 * *bid_evaluation_estimate);
+
+    return respond(
+      {
+        std::nullopt,
+        {make_error_str(
+            9, "Not feasible",
+            "Not enough time left in the auction to evaluate the task")}
+      });
+  }
+
+  const auto admission = admit_bid(task_id);
+  if (admission == BidAdmission::Decision::Decline)
+  {
+    return respond(
+      {
+        std::nullopt,
+        {make_error_str(
+            12, "Busy", "The fleet is too busy to evaluate the task right now")}
+      });
   }
 
   const auto request_msg = nlohmann::json::parse(bid_notice.request);
@@ -341,16 +448,181 @@ void FleetUpdateHandle::Implementation::bid_notice_cb(
       });
   }
 
-  // TODO(MXG): Make the task planning asynchronous. The worker should schedule
-  // a job to perform the planning which should then spawn a job to save the
-  // plan result and respond. I started to refactor allocate_tasks(~) to make it
-  // async, but I will save the remaining effort for later, when there is more
-  // time to spare.
-  auto allocation_result = allocate_tasks(new_request, &errors);
-  if (!allocation_result.has_value())
+  // Map robot index to name to populate robot_name in BidProposal. This is
+  // taken now because the set of robots may change while the planning runs.
+  std::vector<std::string> robot_names;
+  robot_names.reserve(task_managers.size());
+  for (const auto& t : task_managers)
+    robot_names.push_back(t.first->name());
+
+  // Task planning can take seconds for a large fleet, so it runs on the event
+  // loop and the result comes back to the worker.
+  auto& job = bid_allocations[task_id];
+  job.allocation = std::make_shared<BidAllocation>(
+    BidAllocation{
+      task_planner,
+      node,
+      aggregate_expectations(),
+      new_request,
+      allocation_cost_per_task,
+      incremental_allocation_threshold,
+      admission == BidAdmission::Decision::Approximate
+    });
+
+  job.subscription = rmf_rxcpp::make_job<BidAllocation::Result>(
+    job.allocation)
+    .observe_on(rxcpp::identity_same_worker(worker))
+    .subscribe(
+    [w = weak_self, task_id, robot_names = std::move(robot_names),
+    errors = std::move(errors), respond = std::move(respond),
+    trace_start = tracing::start(), evaluation_start](
+      const BidAllocation::Result& result)
+    {
+      tracing::record("bid_allocation", task_id, trace_start);
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      // Weigh the latest evaluation time against the ones before it
+      auto& estimate = self->_pimpl->bid_evaluation_estimate;
+      const auto elapsed = std::chrono::steady_clock::now() - evaluation_start;
+      estimate = estimate.has_value() ?
+        std::chrono::duration_cast<rmf_traffic::Duration>(
+        0.8 * *estimate + 0.2 * elapsed) : elapsed;
+
+      auto all_errors = errors;
+      all_errors.insert(
+        all_errors.end(), result.errors.begin(), result.errors.end());
+
+      auto& impl = *self->_pimpl;
+      if (result.assignments.has_value() && !result.incremental)
+        impl.record_full_allocation(*result.assignments);
+      impl.respond_to_bid(
+        task_id, robot_names, result.assignments, std::move(all_errors),
+        respond);
+
+      // Let go of the job on a later turn of the worker instead of from
+      // inside its own subscription
+      impl.worker.schedule(
+        [w, task_id](const auto&)
+        {
+          if (const auto self = w.lock())
+            self->_pimpl->bid_allocations.erase(task_id);
+        });
+    });
+}
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::advertise_bid_capabilities()
+{
+  if (!advertise_capabilities || !bidder)
+    return;
+
+  rmf_task_ros2::bidding::Capabilities capabilities;
+  capabilities.fleet_name = name;
+
+  const auto consider = [&](const char* category, const auto&... considers)
+    {
+      if (((considers && *considers) && ...))
+        capabilities.categories.insert(category);
+    };
+
+  consider("delivery",
+    deserialization.consider_pickup, deserialization.consider_dropoff);
+  consider("clean", deserialization.consider_clean);
+  consider("bookshelf", deserialization.consider_bookshelf);
+  consider("patrol", deserialization.consider_patrol);
+  consider("compose", deserialization.consider_composed);
+
+  if (deserialization.consider_actions)
+  {
+    for (const auto& [action, consider_action] :
+      *deserialization.consider_actions)
+    {
+      if (consider_action)
+        capabilities.actions.insert(action);
+    }
+  }
+
+  bidder->advertise(std::move(capabilities));
+}
+
+//==============================================================================
+auto FleetUpdateHandle::Implementation::admit_bid(const std::string& task_id)
+-> BidAdmission::Decision
+{
+  auto& admission = bid_admission;
+  std::size_t load = bid_allocations.size();
+  if (const auto pool = jobs::PlanningPool::get())
+    load += pool->load().queued;
+
+  using Decision = BidAdmission::Decision;
+  auto decision = Decision::Full;
+  if (admission.decline_load > 0 && load >= admission.decline_load)
+    decision = Decision::Decline;
+  else if (admission.approximate_load > 0 && load >= admission.approximate_load)
+    decision = Decision::Approximate;
+
+  switch (decision)
+  {
+    case Decision::Full:
+      ++admission.full;
+      break;
+    case Decision::Approximate:
+      ++admission.approximate;
+      tracing::instant("bid_approximate", task_id);
+      break;
+    case Decision::Decline:
+      ++admission.declined;
+      tracing::instant("bid_declined_busy", task_id);
+      break;
+  }
+
+  RCLCPP_DEBUG(
+    node->get_logger(),
+    "Fleet [%s] has a load of [%lu] for the bid of task [%s]",
+    name.c_str(), load, task_id.c_str());
+
+  if (decision != admission.last)
+  {
+    const auto describe = [](const Decision d)
+      {
+        switch (d)
+        {
+          case Decision::Full: return "full";
+          case Decision::Approximate: return "approximate";
+          case Decision::Decline: return "declined";
+        }
+        return "unknown";
+      };
+
+    RCLCPP_INFO(
+      node->get_logger(),
+      "Fleet [%s] bids are now [%s] at a load of [%lu]. Bids so far: [%lu] "
+      "full, [%lu] approximate, [%lu] declined.",
+      name.c_str(), describe(decision), load,
+      admission.full, admission.approximate, admission.declined);
+    admission.last = decision;
+  }
+
+  return decision;
+}
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::respond_to_bid(
+  const std::string& task_id,
+  const std::vector<std::string>& robot_names,
+  std::optional<Assignments> allocation,
+  std::vector<std::string> errors,
+  const rmf_task_ros2::bidding::AsyncBidder::Respond& respond)
+{
+  if (!allocation.has_value())
+    return respond({std::nullopt, std::move(errors)});
+
+  if (!task_planner)
     return respond({std::nullopt, std::move(errors)});
 
-  const auto& assignments = allocation_result.value();
+  const auto& assignments = allocation.value();
 
   const double cost = task_planner->compute_cost(assignments);
 
@@ -381,18 +653,9 @@ void FleetUpdateHandle::Implementation::bid_notice_cb(
 
   RCLCPP_DEBUG(node->get_logger(), "%s", debug_stream.str().c_str());
 
-  // Map robot index to name to populate robot_name in BidProposal
-  std::unordered_map<std::size_t, std::string> robot_name_map;
-  std::size_t index = 0;
-  for (const auto& t : task_managers)
-  {
-    robot_name_map.insert({index, t.first->name()});
-    ++index;
-  }
-
   std::optional<std::string> robot_name;
   std::optional<rmf_traffic::Time> finish_time;
-  index = 0;
+  std::size_t index = 0;
   for (const auto& agent : assignments)
   {
     for (const auto& assignment : agent)
@@ -400,8 +663,8 @@ void FleetUpdateHandle::Implementation::bid_notice_cb(
       if (assignment.request()->booking()->id() == task_id)
       {
         finish_time = assignment.finish_state().time().value();
-        if (robot_name_map.find(index) != robot_name_map.end())
-          robot_name = robot_name_map[index];
+        if (index < robot_names.size())
+          robot_name = robot_names[index];
         break;
       }
     }
@@ -441,11 +704,194 @@ void FleetUpdateHandle::Implementation::bid_notice_cb(
   bid_notice_assignments.insert({task_id, assignments});
 }
 
+//==============================================================================
+namespace {
+//==============================================================================
+/// Get the IDs of the tasks that an API request refers to. This returns a
+/// nullopt if the request is not a type that task managers handle. The result
+/// is empty if the request is missing its task IDs.
+std::optional<std::vector<std::string>> requested_task_ids(
+  const std::string& type,
+  const nlohmann::json& request)
+{
+  std::string field;
+  if (type == "cancel_tasks_request")
+  {
+    std::vector<std::string> task_ids;
+    const auto it = request.find("task_ids");
+    if (it == request.end() || !it->is_array())
+      return task_ids;
+
+    for (const auto& task_id : *it)
+    {
+      if (task_id.is_string())
+        task_ids.push_back(task_id.get<std::string>());
+    }
+
+    return task_ids;
+  }
+  else if (type == "cancel_task_request"
+    || type == "kill_task_request"
+    || type == "interrupt_task_request"
+    || type == "task_log_request"
+    || type == "rewind_task_request"
+    || type == "skip_phase_request")
+  {
+    field = "task_id";
+  }
+  else if (type == "resume_task_request" || type == "undo_phase_skip_request")
+  {
+    field = "for_task";
+  }
+  else
+  {
+    return std::nullopt;
+  }
+
+  const auto it = request.find(field);
+  if (it == request.end() || !it->is_string())
+    return std::vector<std::string>();
+
+  return std::vector<std::string>({it->get<std::string>()});
+}
+} // anonymous namespace
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::route_api_request(
+  const rmf_task_msgs::msg::ApiRequest& request)
+{
+  auto request_json = std::make_shared<nlohmann::json>();
+  try
+  {
+    *request_json = nlohmann::json::parse(request.json_msg);
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_ERROR(
+      node->get_logger(),
+      "Error parsing json_msg: %s",
+      e.what());
+    return;
+  }
+
+  const auto type_it = request_json->find("type");
+  if (type_it == request_json->end() || !type_it->is_string())
+    return;
+
+  const auto type = type_it->get<std::string>();
+  std::vector<std::shared_ptr<TaskManager>> targets;
+  if (type == "robot_task_request")
+  {
+    const auto fleet_it = request_json->find("fleet");
+    if (fleet_it == request_json->end() || *fleet_it != name)
+      return;
+
+    const auto robot_it = request_json->find("robot");
+    if (robot_it == request_json->end() || !robot_it->is_string())
+      return;
+
+    const auto& robot = robot_it->get_ref<const std::string&>();
+    for (const auto& [context, mgr] : task_managers)
+    {
+      if (context->name() == robot)
+        targets.push_back(mgr);
+    }
+  }
+  else
+  {
+    const auto task_ids = requested_task_ids(type, *request_json);
+    if (!task_ids.has_value() || task_managers.empty())
+      return;
+
+    if (task_ids->empty())
+    {
+      // The request is malformed, so let one task manager report the schema
+      // errors for it.
+      targets.push_back(task_managers.begin()->second);
+    }
+
+    for (const auto& task_id : *task_ids)
+    {
+      const auto owner = find_task_owner(task_id);
+      if (owner && std::find(targets.begin(), targets.end(), owner)
+        == targets.end())
+      {
+        targets.push_back(owner);
+      }
+    }
+
+    if (targets.empty())
+    {
+      // None of the queues hold the task, but it may have finished recently
+      // and still have logs waiting in one of the task managers.
+      for (const auto& [_, mgr] : task_managers)
+        targets.push_back(mgr);
+    }
+  }
+
+  for (const auto& mgr : targets)
+  {
+    mgr->context()->worker().schedule(
+      [w = std::weak_ptr<TaskManager>(mgr),
+      request_json,
+      request_id = request.request_id](const auto&)
+      {
+        if (const auto mgr = w.lock())
+          mgr->handle_api_request(*request_json, request_id);
+      });
+  }
+}
+
+//==============================================================================
+std::shared_ptr<TaskManager>
+FleetUpdateHandle::Implementation::find_task_owner(const std::string& task_id)
+{
+  const auto it = task_owners.find(task_id);
+  if (it != task_owners.end())
+  {
+    const auto mgr = it->second.lock();
+    if (mgr && mgr->has_task(task_id))
+      return mgr;
+
+    task_owners.erase(it);
+  }
+
+  for (const auto& [_, mgr] : task_managers)
+  {
+    if (!mgr->has_task(task_id))
+      continue;
+
+    if (task_owners.size() >= 10 * task_managers.size())
+    {
+      // Forget the tasks that have moved on so the index stays small
+      for (auto o = task_owners.begin(); o != task_owners.end(); )
+      {
+        const auto owner = o->second.lock();
+        if (!owner || !owner->has_task(o->first))
+          o = task_owners.erase(o);
+        else
+          ++o;
+      }
+    }
+
+    task_owners[task_id] = mgr;
+    return mgr;
+  }
+
+  return nullptr;
+}
+
 //==============================================================================
 void FleetUpdateHandle::Implementation::dispatch_command_cb(
   const DispatchCmdMsg::SharedPtr msg)
 {
   const auto& task_id = msg->task_id;
+  tracing::Span span("dispatch_command", task_id);
+
+  // The auction for this task is over, so there is no point in finishing any
+  // planning that is still being done for it.
+  bid_allocations.erase(task_id);
+
   if (msg->fleet_name != name)
   {
     // This task is either being awarded or canceled for another fleet. Either
@@ -585,6 +1031,7 @@ void FleetUpdateHandle::Implementation::dispatch_command_cb(
       }
 
       assignments = replan_results.value();
+      record_full_allocation(assignments);
       // We do not need to re-check if assignments are valid as this function
       // is being called by the ROS2 executor and is running on the main
       // rxcpp worker. Hence, no new tasks would have started during this
@@ -620,19 +1067,33 @@ void FleetUpdateHandle::Implementation::dispatch_command_cb(
     else
     {
       bool task_was_found = false;
+      std::size_t robot_index = 0;
       // Make sure the task isn't running in any of the task managers
       for (const auto& [_, tm] : task_managers)
       {
         task_was_found = tm->cancel_task_if_present(task_id);
         if (task_was_found)
           break;
+
+        ++robot_index;
       }
 
       if (task_was_found)
       {
-        // Re-plan assignments while ignoring request for task to be cancelled
+        // Only the robot that lost the task needs new assignments, unless that
+        // leaves the fleet too far from what a full allocation would give.
         std::vector<std::string> errors;
-        const auto replan_results = allocate_tasks(nullptr, &errors);
+        auto replan_results = repair_assignments(robot_index);
+        const bool repaired = replan_results.has_value();
+        if (!repaired)
+        {
+          // Re-plan assignments while ignoring request for task to be
+          // cancelled
+          replan_results = allocate_tasks(nullptr, &errors);
+          if (replan_results.has_value())
+            record_full_allocation(*replan_results);
+        }
+
         if (!replan_results.has_value())
         {
           std::stringstream ss;
@@ -661,7 +1122,9 @@ void FleetUpdateHandle::Implementation::dispatch_command_cb(
           std::size_t index = 0;
           for (auto& t : task_managers)
           {
-            t.second->set_queue(assignments[index]);
+            if (!repaired || index == robot_index)
+              t.second->set_queue(assignments[index]);
+
             ++index;
           }
 
@@ -701,6 +1164,7 @@ auto FleetUpdateHandle::Implementation::is_valid_assignments(
     executed_tasks.insert(tasks.begin(), tasks.end());
   }
 
+  std::unordered_set<std::string> assigned_tasks;
   for (const auto& agent : assignments)
   {
     for (const auto& a : agent)
@@ -708,6 +1172,20 @@ auto FleetUpdateHandle::Implementation::is_valid_assignments(
       if (executed_tasks.find(a.request()->booking()->id()) !=
         executed_tasks.end())
         return false;
+
+      assigned_tasks.insert(a.request()->booking()->id());
+    }
+  }
+
+  // Several auctions may be open at once, and each of them was planned without
+  // the tasks of the others. If one of those tasks was awarded to us in the
+  // meantime, these assignments would drop it from its queue.
+  for (const auto& [context, mgr] : task_managers)
+  {
+    for (const auto& request : mgr->requests())
+    {
+      if (assigned_tasks.count(request->booking()->id()) == 0)
+        return false;
     }
   }
 
@@ -722,6 +1200,19 @@ get_nearest_charger(
   if (charging_waypoints.empty())
     return std::nullopt;
 
+  if (travel_time_table)
+  {
+    const auto nearest = travel_time_table->nearest(
+      start,
+      std::vector<std::size_t>(
+        charging_waypoints.begin(), charging_waypoints.end()));
+
+    if (!nearest.has_value())
+      return std::nullopt;
+
+    return nearest->waypoint;
+  }
+
   double min_cost = std::numeric_limits<double>::max();
   std::optional<std::size_t> nearest_charger = std::nullopt;
   for (const auto& wp : charging_waypoints)
@@ -739,6 +1230,31 @@ get_nearest_charger(
   return nearest_charger;
 }
 
+//==============================================================================
+std::optional<std::size_t> FleetUpdateHandle::Implementation::assign_charger(
+  const std::string& robot,
+  const rmf_traffic::agv::Planner::Start& start)
+{
+  if (charger_scheduler && travel_time_table)
+  {
+    std::vector<ChargerScheduler::Option> options;
+    for (const auto wp : charger_scheduler->chargers())
+    {
+      if (const auto time = travel_time_table->travel_time(start, wp))
+        options.push_back({wp, *time});
+    }
+
+    if (const auto charger = charger_scheduler->assign(robot, options))
+      return charger;
+  }
+
+  const auto nearest = get_nearest_charger(start);
+  if (nearest.has_value() && charger_scheduler)
+    charger_scheduler->assign(robot, *nearest);
+
+  return nearest;
+}
+
 namespace {
 //==============================================================================
 rmf_fleet_msgs::msg::Location convert_location(const agv::RobotContext& context)
@@ -751,7 +1267,7 @@ rmf_fleet_msgs::msg::Location convert_location(const agv::RobotContext& context)
   }
 
   const auto& graph = context.planner()->get_configuration().graph();
-  const auto& l = context.location().front();
+  const auto l = context.location().front();
   const auto& wp = graph.get_waypoint(l.waypoint());
   const Eigen::Vector2d p = l.location().value_or(wp.get_location());
 
@@ -795,12 +1311,123 @@ rmf_fleet_msgs::msg::RobotState convert_state(const TaskManager& mgr)
 }
 } // anonymous namespace
 
+//==============================================================================
+auto FleetUpdateHandle::Implementation::refresh_robot_state_snapshots() const
+-> std::unordered_map<const RobotContext*, RobotStateSnapshot>&
+{
+  // Timers that are due at the same moment get to share a snapshot
+  const auto max_age = std::chrono::milliseconds(50);
+  const auto now = std::chrono::steady_clock::now();
+  if (robot_state_snapshots_time.has_value()
+    && now - *robot_state_snapshots_time < max_age)
+    return robot_state_snapshots;
+
+  std::unordered_map<const RobotContext*, RobotStateSnapshot> snapshots;
+  snapshots.reserve(task_managers.size());
+  for (const auto& [context, mgr] : task_managers)
+  {
+    RobotStateSnapshot snapshot{convert_state(*mgr), mgr->robot_status(), {}};
+
+    // Keep the encoded json of robots whose state has not changed
+    const auto old = robot_state_snapshots.find(context.get());
+    if (old != robot_state_snapshots.end()
+      && old->second.msg == snapshot.msg
+      && old->second.status == snapshot.status)
+      snapshot.json = std::move(old->second.json);
+
+    snapshots.insert({context.get(), std::move(snapshot)});
+  }
+
+  robot_state_snapshots = std::move(snapshots);
+  robot_state_snapshots_time = now;
+  return robot_state_snapshots;
+}
+
+//==============================================================================
+MemoryUsage FleetUpdateHandle::Implementation::memory_usage() const
+{
+  MemoryUsage usage;
+  const auto travel_times = travel_time_table;
+  usage["travel_time_table"] = travel_times ?
+    travel_times->approximate_bytes() : 0;
+
+  const auto energy = energy_table;
+  usage["energy_table"] = energy ? energy->approximate_bytes() : 0;
+
+  usage["broadcast_client_queue"] = broadcast_client ?
+    broadcast_client->approximate_queue_bytes() : 0;
+
+  std::size_t snapshots = 0;
+  {
+    std::lock_guard<std::mutex> lock(robot_state_snapshots_mutex);
+    for (const auto& [_, snapshot] : robot_state_snapshots)
+    {
+      snapshots += ContainerNodeBytes + sizeof(snapshot)
+        + approximate_bytes(snapshot.status)
+        + (snapshot.json.has_value() ? approximate_bytes(*snapshot.json) : 0);
+    }
+  }
+
+  usage["robot_state_snapshots"] = snapshots;
+  return usage;
+}
+
+//==============================================================================
+auto FleetUpdateHandle::Implementation::robot_memory_usage() const
+-> std::vector<std::pair<std::string, std::future<MemoryUsage>>>
+{
+  const auto measure = [](
+    const std::weak_ptr<RobotContext>& w_context,
+    const std::weak_ptr<TaskManager>& w_mgr)
+    {
+      MemoryUsage usage;
+      if (const auto robot = w_context.lock())
+        accumulate(usage, robot->memory_usage());
+
+      if (const auto manager = w_mgr.lock())
+        accumulate(usage, manager->memory_usage());
+
+      return usage;
+    };
+
+  std::vector<std::pair<std::string, std::future<MemoryUsage>>> output;
+  output.reserve(task_managers.size());
+  for (const auto& [context, mgr] : task_managers)
+  {
+    auto promise = std::make_shared<std::promise<MemoryUsage>>();
+    output.emplace_back(context->name(), promise->get_future());
+
+    // Without a pool of robot workers, every robot runs on the worker of the
+    // fleet, which is the one that we are being called on. Scheduling the
+    // measurement onto it would never run while the caller waits for it.
+    if (robot_workers.empty())
+    {
+      promise->set_value(measure(context, mgr));
+      continue;
+    }
+
+    context->worker().schedule(
+      [promise, measure, w_context = std::weak_ptr<RobotContext>(context),
+      w_mgr = std::weak_ptr<TaskManager>(mgr)](const auto&)
+      {
+        promise->set_value(measure(w_context, w_mgr));
+      });
+  }
+
+  return output;
+}
+
 //==============================================================================
 void FleetUpdateHandle::Implementation::publish_fleet_state_topic() const
 {
   std::vector<rmf_fleet_msgs::msg::RobotState> robot_states;
-  for (const auto& [context, mgr] : task_managers)
-    robot_states.emplace_back(convert_state(*mgr));
+  {
+    std::lock_guard<std::mutex> lock(robot_state_snapshots_mutex);
+    const auto& snapshots = refresh_robot_state_snapshots();
+    robot_states.reserve(snapshots.size());
+    for (const auto& [_, snapshot] : snapshots)
+      robot_states.push_back(snapshot.msg);
+  }
 
   auto fleet_state = rmf_fleet_msgs::build<rmf_fleet_msgs::msg::FleetState>()
     .name(name)
@@ -818,134 +1445,519 @@ void FleetUpdateHandle::Implementation::update_fleet_state() const
     nlohmann::json fleet_state_msg;
     fleet_state_msg["name"] = name;
     auto& robots = fleet_state_msg["robots"];
-    for (const auto& [context, mgr] : task_managers)
     {
-      const auto& name = context->name();
-      nlohmann::json& json = robots[name];
-      json["name"] = name;
-      json["status"] = mgr->robot_status();
-      json["task_id"] = mgr->current_task_id().value_or("");
-      json["unix_millis_time"] =
+      const auto unix_millis_time =
         std::chrono::duration_cast<std::chrono::milliseconds>(
-        context->now().time_since_epoch()).count();
-      json["battery"] = context->current_battery_soc();
-
-      nlohmann::json& location = json["location"];
-      const auto location_msg = convert_location(*context);
-      location["map"] = location_msg.level_name;
-      location["x"] = location_msg.x;
-      location["y"] = location_msg.y;
-      location["yaw"] = location_msg.yaw;
+        rmf_traffic_ros2::convert(node->now()).time_since_epoch()).count();
 
-      // TODO(YV): json["issues"]
-    }
-
-    const auto fleet_schema = rmf_api_msgs::schemas::fleet_state_update;
-    const auto loader =
-      [n = node, s = schema_dictionary](const nlohmann::json_uri& id,
-        nlohmann::json& value)
+      std::lock_guard<std::mutex> lock(robot_state_snapshots_mutex);
+      for (auto& [_, snapshot] : refresh_robot_state_snapshots())
       {
-        const auto it = s.find(id.url());
-        if (it == s.end())
+        const auto& state = snapshot.msg;
+        if (!snapshot.json.has_value())
         {
-          RCLCPP_ERROR(
-            n->get_logger(),
-            "url: %s not found in schema dictionary", id.url().c_str());
-          return;
+          nlohmann::json json;
+          json["name"] = state.name;
+          json["status"] = snapshot.status;
+          json["task_id"] = state.task_id;
+          // The message has the battery as a percentage
+          json["battery"] = state.battery_percent / 100.0;
+
+          nlohmann::json& location = json["location"];
+          location["map"] = state.location.level_name;
+          location["x"] = state.location.x;
+          location["y"] = state.location.y;
+          location["yaw"] = state.location.yaw;
+
+          // TODO(YV): json["issues"]
+          snapshot.json = std::move(json);
         }
 
-        value = it->second;
-      };
+        nlohmann::json& json = robots[state.name];
+        json = *snapshot.json;
+        json["unix_millis_time"] = unix_millis_time;
+      }
+    }
 
     nlohmann::json fleet_state_update_msg;
     fleet_state_update_msg["type"] = "fleet_state_update";
     fleet_state_update_msg["data"] = fleet_state_msg;
     try
     {
-      static const nlohmann::json_schema::json_validator
-        validator(fleet_schema, loader);
+      const auto& validator =
+        validators->get(rmf_api_msgs::schemas::fleet_state_update);
+
+      if (validators->check_outbound(validator))
+        validator.validate(fleet_state_update_msg);
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Unable to publish fleet state json message: %s",
+        e.what());
+      return;
+    }
+
+    broadcast_client->publish(fleet_state_update_msg);
+  }
+}
+
+namespace {
+PlaceDeserializer make_place_deserializer(
+  std::shared_ptr<const std::shared_ptr<const rmf_traffic::agv::Planner>>
+  planner)
+{
+  return [planner = std::move(planner)](const nlohmann::json& msg)
+    -> agv::DeserializedPlace
+    {
+      std::optional<rmf_traffic::agv::Plan::Goal> place;
+      const auto& graph = (*planner)->get_configuration().graph();
+      if (msg.is_number() || (msg.is_object() && msg["waypoint"].is_number()))
+      {
+        const auto wp_index = msg.is_number() ?
+          msg.get<std::size_t>() : msg["waypoint"].get<std::size_t>();
+
+        if (graph.num_waypoints() <= wp_index)
+        {
+          return {
+            std::nullopt,
+            {"waypoint index value for Place ["
+              + std::to_string(wp_index) + "] exceeds the limits for the nav "
+              "graph size [" + std::to_string(graph.num_waypoints()) + "]"}
+          };
+        }
+
+        place = rmf_traffic::agv::Plan::Goal(wp_index);
+      }
+      else if (msg.is_string() ||
+        (msg.is_object() && msg["waypoint"].is_string()))
+      {
+        const auto& wp_name = msg.is_string() ?
+          msg.get<std::string>() : msg["waypoint"].get<std::string>();
+
+        const auto* wp = graph.find_waypoint(wp_name);
+        if (!wp)
+        {
+          return {
+            std::nullopt,
+            {"waypoint name for Place [" + wp_name + "] cannot be "
+              "found in the navigation graph"}
+          };
+        }
+
+        place = rmf_traffic::agv::Plan::Goal(wp->index());
+      }
+      else
+      {
+        return {
+          std::nullopt,
+          {"invalid data type provided for Place: expected a number "
+            "or a string or an object but got " + std::string(msg.type_name())
+            + " type instead"}
+        };
+      }
+
+      if (msg.is_object())
+      {
+        const auto& ori_it = msg.find("orientation");
+        if (ori_it != msg.end())
+          place->orientation(ori_it->get<double>());
+      }
+
+      return {place, {}};
+    };
+}
+} // anonymous namespace
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::update_travel_estimator(
+  const bool prewarm)
+{
+  if (!task_planner)
+    return;
+
+  auto parameters = task_planner->configuration().parameters();
+  parameters.planner(*planner);
+  travel_estimator = std::make_shared<rmf_task::TravelEstimator>(parameters);
+
+  // Travel estimators that were made for other planners were also made with
+  // the old task planner parameters, so they cannot be reused anymore.
+  for (auto& cached : planner_cache)
+  {
+    cached.travel_estimator =
+      cached.planner == *planner ? travel_estimator : nullptr;
+  }
+
+  for (const auto& [context, _] : task_managers)
+  {
+    context->travel_estimator(travel_estimator);
+    if (!prewarm)
+      continue;
+
+    const auto location = context->location();
+    if (location.empty())
+      continue;
+
+    // These are the legs that will be asked for by automatic retreats
+    travel_estimator->estimate(
+      location.front(),
+      rmf_traffic::agv::Plan::Goal(context->dedicated_charger_wp()));
+  }
+}
+
+//==============================================================================
+namespace {
+std::vector<std::size_t> closed_lanes_of(
+  const rmf_traffic::agv::Planner::Configuration& config)
+{
+  std::vector<std::size_t> closed;
+  const auto& closures = config.lane_closures();
+  for (std::size_t i = 0; i < config.graph().num_lanes(); ++i)
+  {
+    if (closures.is_closed(i))
+      closed.push_back(i);
+  }
+
+  return closed;
+}
+} // anonymous namespace
+
+//==============================================================================
+const std::vector<std::size_t>&
+FleetUpdateHandle::Implementation::current_closed_lanes()
+{
+  if (!closed_lanes.has_value())
+    closed_lanes = closed_lanes_of((*planner)->get_configuration());
+
+  return *closed_lanes;
+}
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::set_lane_closures(
+  rmf_traffic::agv::LaneClosure closures,
+  std::vector<std::size_t> closed)
+{
+  const auto current_closed = current_closed_lanes();
+  const auto is_current = [&](const CachedPlanner& cached)
+    {
+      return cached.planner == *planner;
+    };
+
+  // Make sure the planner that is being replaced can be found again later
+  if (std::find_if(planner_cache.begin(), planner_cache.end(), is_current)
+    == planner_cache.end())
+  {
+    planner_cache.push_front(
+      CachedPlanner{current_closed, *planner, travel_estimator});
+  }
+
+  auto new_config = (*planner)->get_configuration();
+  new_config.lane_closures() = std::move(closures);
+  closed_lanes = closed;
+
+  const auto it = std::find_if(
+    planner_cache.begin(), planner_cache.end(),
+    [&](const CachedPlanner& cached)
+    {
+      return cached.closed_lanes == closed;
+    });
+
+  if (it != planner_cache.end())
+  {
+    planner_cache.splice(planner_cache.begin(), planner_cache, it);
+    const auto& cached = planner_cache.front();
+    *planner = cached.planner;
+    task_parameters->planner(*planner);
+    if (travel_time_table)
+    {
+      travel_time_table->update_lane_closures(
+        (*planner)->get_configuration().lane_closures());
+    }
+
+    if (energy_table)
+      energy_table->update_lane_closures();
+
+    if (cached.travel_estimator && task_planner)
+    {
+      travel_estimator = cached.travel_estimator;
+      for (const auto& [context, _] : task_managers)
+        context->travel_estimator(travel_estimator);
+    }
+    else
+    {
+      update_travel_estimator();
+    }
+
+    return;
+  }
+
+  *planner = std::make_shared<const rmf_traffic::agv::Planner>(
+    new_config, rmf_traffic::agv::Planner::Options(nullptr));
+  task_parameters->planner(*planner);
+  if (travel_time_table)
+    travel_time_table->update_lane_closures(new_config.lane_closures());
+
+  if (energy_table)
+    energy_table->update_lane_closures();
+
+  // When there is a planning pool, the warm up happens in the background
+  // instead of holding up the fleet worker.
+  update_travel_estimator(!warm_up_planner(*planner));
+
+  planner_cache.push_front(
+    CachedPlanner{std::move(closed), *planner, travel_estimator});
+  while (planner_cache.size() > planner_cache_capacity)
+    planner_cache.pop_back();
+}
+
+//==============================================================================
+bool FleetUpdateHandle::Implementation::warm_up_planner(
+  const std::shared_ptr<const rmf_traffic::agv::Planner>& new_planner) const
+{
+  const auto pool = jobs::PlanningPool::get();
+  if (!pool)
+    return false;
+
+  for (const auto& [context, _] : task_managers)
+  {
+    const auto location = context->location();
+    if (location.empty())
+      continue;
+
+    pool->schedule(
+      jobs::PlanningPool::Priority::Background,
+      [w = std::weak_ptr<const rmf_traffic::agv::Planner>(new_planner),
+      start = location.front(),
+      goal = rmf_traffic::agv::Plan::Goal(context->dedicated_charger_wp())]()
+      {
+        // Skip the warm up if the planner was already dropped
+        if (const auto p = w.lock())
+          p->plan(start, goal);
+      });
+  }
+
+  return true;
+}
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::precompute_travel_times() const
+{
+  if (!travel_time_table)
+    return;
+
+  const auto job = [
+    w = std::weak_ptr<TravelTimeTable>(travel_time_table),
+    parking = parking_waypoints,
+    k = pullover_candidates]()
+    {
+      if (const auto table = w.lock())
+      {
+        table->precompute();
+        table->precompute_nearest(parking, k);
+      }
+    };
+
+  if (const auto pool = jobs::PlanningPool::get())
+  {
+    pool->schedule(jobs::PlanningPool::Priority::Background, job);
+    return;
+  }
+
+  worker.schedule([job](const auto&) { job(); });
+}
+
+namespace {
+//==============================================================================
+const char PlanningCacheMagic[] = "RMFPCACHE1";
+
+//==============================================================================
+uint64_t planning_cache_key(
+  const TravelTimeTable& table,
+  const rmf_traffic::agv::VehicleTraits& traits)
+{
+  // The table covers the lanes and the nominal linear velocity. The rest of
+  // the traits change the plans without changing the table.
+  uint64_t hash = table.fingerprint();
+  const double values[] = {
+    traits.linear().get_nominal_acceleration(),
+    traits.rotational().get_nominal_velocity(),
+    traits.rotational().get_nominal_acceleration()
+  };
+
+  for (const double value : values)
+  {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    hash = (hash ^ bits) * 1099511628211ull;
+  }
+
+  return hash;
+}
+} // anonymous namespace
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::save_planning_cache(
+  const std::string& file) const
+{
+  if (!travel_time_table)
+    return;
+
+  std::set<std::pair<std::size_t, std::size_t>> legs;
+  for (const auto& [context, _] : task_managers)
+  {
+    for (const auto& leg : context->plan_cache().legs())
+      legs.insert(leg);
+  }
+
+  // Write to a temporary file first so that a crash while saving leaves the
+  // last complete cache in place.
+  const std::string tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    const uint64_t key = planning_cache_key(
+      *travel_time_table,
+      (*planner)->get_configuration().vehicle_traits());
+    const uint64_t num_legs = legs.size();
+    out.write(PlanningCacheMagic, sizeof(PlanningCacheMagic));
+    out.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    out.write(reinterpret_cast<const char*>(&num_legs), sizeof(num_legs));
+    for (const auto& [start, goal] : legs)
+    {
+      const uint64_t ends[2] = {start, goal};
+      out.write(reinterpret_cast<const char*>(ends), sizeof(ends));
+    }
+
+    travel_time_table->save(out);
+    if (!out)
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Unable to write the planning cache of fleet [%s] to [%s]",
+        name.c_str(), tmp.c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tmp.c_str(), file.c_str()) != 0)
+  {
+    RCLCPP_ERROR(
+      node->get_logger(),
+      "Unable to replace the planning cache of fleet [%s] at [%s]",
+      name.c_str(), file.c_str());
+  }
+}
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::load_planning_cache(
+  const std::string& file)
+{
+  if (!travel_time_table)
+    return;
+
+  std::ifstream in(file, std::ios::binary);
+  if (!in)
+    return;
 
-      validator.validate(fleet_state_update_msg);
-    }
-    catch (const std::exception& e)
-    {
-      RCLCPP_ERROR(
-        node->get_logger(),
-        "Unable to publish fleet state json message: %s",
-        e.what());
+  char magic[sizeof(PlanningCacheMagic)];
+  uint64_t key = 0;
+  uint64_t num_legs = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&key), sizeof(key));
+  in.read(reinterpret_cast<char*>(&num_legs), sizeof(num_legs));
+
+  const auto& config = (*planner)->get_configuration();
+  const std::size_t num_waypoints = config.graph().num_waypoints();
+  if (!in
+    || std::memcmp(magic, PlanningCacheMagic, sizeof(magic)) != 0
+    || key != planning_cache_key(*travel_time_table, config.vehicle_traits())
+    || num_legs > num_waypoints * num_waypoints)
+  {
+    RCLCPP_INFO(
+      node->get_logger(),
+      "Ignoring the planning cache of fleet [%s] at [%s] because it was "
+      "saved for a different graph or vehicle",
+      name.c_str(), file.c_str());
+    return;
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> legs;
+  legs.reserve(num_legs);
+  for (uint64_t i = 0; i < num_legs; ++i)
+  {
+    uint64_t ends[2] = {0, 0};
+    in.read(reinterpret_cast<char*>(ends), sizeof(ends));
+    if (!in || ends[0] >= num_waypoints || ends[1] >= num_waypoints)
       return;
-    }
 
-    broadcast_client->publish(fleet_state_update_msg);
+    legs.push_back({ends[0], ends[1]});
   }
-}
 
-namespace {
-PlaceDeserializer make_place_deserializer(
-  std::shared_ptr<const std::shared_ptr<const rmf_traffic::agv::Planner>>
-  planner)
-{
-  return [planner = std::move(planner)](const nlohmann::json& msg)
-    -> agv::DeserializedPlace
+  if (!travel_time_table->load(in))
+  {
+    RCLCPP_WARN(
+      node->get_logger(),
+      "The travel times in the planning cache of fleet [%s] at [%s] are "
+      "malformed and will be ignored",
+      name.c_str(), file.c_str());
+  }
+
+  const auto job = [
+    w = std::weak_ptr<const rmf_traffic::agv::Planner>(*planner),
+    legs = std::move(legs)]()
     {
-      std::optional<rmf_traffic::agv::Plan::Goal> place;
-      const auto& graph = (*planner)->get_configuration().graph();
-      if (msg.is_number() || (msg.is_object() && msg["waypoint"].is_number()))
+      for (const auto& [start, goal] : legs)
       {
-        const auto wp_index = msg.is_number() ?
-          msg.get<std::size_t>() : msg["waypoint"].get<std::size_t>();
-
-        if (graph.num_waypoints() <= wp_index)
-        {
-          return {
-            std::nullopt,
-            {"waypoint index value for Place ["
-              + std::to_string(wp_index) + "] exceeds the limits for the nav "
-              "graph size [" + std::to_string(graph.num_waypoints()) + "]"}
-          };
-        }
+        // Skip the rest of the warm up if the planner was already replaced
+        const auto p = w.lock();
+        if (!p)
+          return;
 
-        place = rmf_traffic::agv::Plan::Goal(wp_index);
+        p->plan(
+          rmf_traffic::agv::Plan::Start(
+            std::chrono::steady_clock::now(), start, 0.0),
+          rmf_traffic::agv::Plan::Goal(goal));
       }
-      else if (msg.is_string() ||
-        (msg.is_object() && msg["waypoint"].is_string()))
-      {
-        const auto& wp_name = msg.is_string() ?
-          msg.get<std::string>() : msg["waypoint"].get<std::string>();
+    };
 
-        const auto* wp = graph.find_waypoint(wp_name);
-        if (!wp)
-        {
-          return {
-            std::nullopt,
-            {"waypoint name for Place [" + wp_name + "] cannot be "
-              "found in the navigation graph"}
-          };
-        }
+  if (const auto pool = jobs::PlanningPool::get())
+  {
+    pool->schedule(jobs::PlanningPool::Priority::Background, job);
+    return;
+  }
 
-        place = rmf_traffic::agv::Plan::Goal(wp->index());
-      }
-      else
-      {
-        return {
-          std::nullopt,
-          {"invalid data type provided for Place: expected a number "
-            "or a string or an object but got " + std::string(msg.type_name())
-            + " type instead"}
-        };
-      }
+  worker.schedule([job](const auto&) { job(); });
+}
 
-      if (msg.is_object())
-      {
-        const auto& ori_it = msg.find("orientation");
-        if (ori_it != msg.end())
-          place->orientation(ori_it->get<double>());
-      }
+//==============================================================================
+void FleetUpdateHandle::Implementation::update_energy_table(
+  std::shared_ptr<rmf_battery::MotionPowerSink> motion_sink,
+  std::shared_ptr<rmf_battery::DevicePowerSink> ambient_sink)
+{
+  if (!travel_time_table)
+    return;
 
-      return {place, {}};
+  energy_table = std::make_shared<EnergyTable>(
+    travel_time_table, (*planner)->get_configuration(),
+    std::move(motion_sink), std::move(ambient_sink));
+
+  for (const auto& [context, _] : task_managers)
+    context->energy_table(energy_table);
+
+  const auto job = [w = std::weak_ptr<EnergyTable>(energy_table)]()
+    {
+      if (const auto table = w.lock())
+        table->precompute();
     };
+
+  if (const auto pool = jobs::PlanningPool::get())
+  {
+    pool->schedule(jobs::PlanningPool::Priority::Background, job);
+    return;
+  }
+
+  worker.schedule([job](const auto&) { job(); });
 }
-} // anonymous namespace
 
 //==============================================================================
 void FleetUpdateHandle::Implementation::add_standard_tasks()
@@ -1017,6 +2029,7 @@ FleetUpdateHandle& FleetUpdateHandle::add_performable_action(
 
   _pimpl->deserialization.consider_actions->insert_or_assign(
     category, consider);
+  _pimpl->advertise_bid_capabilities();
 
   return *this;
 }
@@ -1032,11 +2045,178 @@ auto FleetUpdateHandle::Implementation::aggregate_expectations() const
     const auto requests = t.second->requests();
     expect.pending_requests.insert(
       expect.pending_requests.end(), requests.begin(), requests.end());
+
+    std::vector<rmf_task::ConstRequestPtr> queue;
+    for (const auto& a : t.second->get_queue())
+      queue.push_back(a.request());
+    expect.queues.push_back(std::move(queue));
   }
 
   return expect;
 }
 
+//==============================================================================
+auto FleetUpdateHandle::Implementation::estimate_queue(
+  const rmf_task::TaskPlanner& planner,
+  rmf_task::State start,
+  const std::vector<rmf_task::ConstRequestPtr>& requests,
+  rmf_task::TravelEstimator& estimator)
+-> std::optional<std::vector<Assignment>>
+{
+  const auto& parameters = planner.configuration().parameters();
+  const auto& constraints = planner.configuration().constraints();
+
+  std::vector<Assignment> queue;
+  queue.reserve(requests.size());
+  for (const auto& request : requests)
+  {
+    const auto model = request->description()->make_model(
+      request->booking()->earliest_start_time(),
+      parameters);
+
+    const auto estimate = model->estimate_finish(start, constraints, estimator);
+    if (!estimate.has_value())
+      return std::nullopt;
+
+    queue.emplace_back(
+      request, estimate->finish_state(), estimate->wait_until());
+    start = estimate->finish_state();
+  }
+
+  return queue;
+}
+
+//==============================================================================
+auto FleetUpdateHandle::Implementation::insert_request(
+  const rmf_task::TaskPlanner& planner,
+  const Expectations& expect,
+  const rmf_task::ConstRequestPtr& request) -> std::optional<Assignments>
+{
+  rmf_task::TravelEstimator estimator(planner.configuration().parameters());
+
+  // The queues as they are now, estimated from the current robot states
+  Assignments current;
+  current.reserve(expect.states.size());
+  for (std::size_t i = 0; i < expect.states.size(); ++i)
+  {
+    auto queue = estimate_queue(
+      planner, expect.states[i], expect.queues[i], estimator);
+    if (!queue.has_value())
+      return std::nullopt;
+
+    current.push_back(std::move(*queue));
+  }
+
+  std::optional<Assignments> best;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < current.size(); ++i)
+  {
+    const auto& queue = expect.queues[i];
+    for (std::size_t k = 0; k <= queue.size(); ++k)
+    {
+      // Everything before the insertion point keeps its estimate
+      const auto& start = k == 0 ?
+        expect.states[i] : current[i][k-1].finish_state();
+
+      std::vector<rmf_task::ConstRequestPtr> remaining = {request};
+      remaining.insert(remaining.end(), queue.begin() + k, queue.end());
+      auto tail = estimate_queue(planner, start, remaining, estimator);
+      if (!tail.has_value())
+        continue;
+
+      auto candidate = current;
+      auto& candidate_queue = candidate[i];
+      candidate_queue.erase(candidate_queue.begin() + k, candidate_queue.end());
+      candidate_queue.insert(
+        candidate_queue.end(), tail->begin(), tail->end());
+
+      const double cost = planner.compute_cost(candidate);
+      if (cost < best_cost)
+      {
+        best_cost = cost;
+        best = std::move(candidate);
+      }
+    }
+  }
+
+  return best;
+}
+
+//==============================================================================
+bool FleetUpdateHandle::Implementation::within_cost_threshold(
+  const rmf_task::TaskPlanner& planner,
+  const Assignments& assignments,
+  std::optional<double> cost_per_task,
+  double threshold)
+{
+  if (!cost_per_task.has_value() || threshold < 0.0)
+    return false;
+
+  std::size_t num_tasks = 0;
+  for (const auto& queue : assignments)
+    num_tasks += queue.size();
+
+  const double limit = (1.0 + threshold) * (*cost_per_task) * num_tasks;
+  return planner.compute_cost(assignments) <= limit;
+}
+
+//==============================================================================
+auto FleetUpdateHandle::Implementation::repair_assignments(
+  std::size_t robot_index) const -> std::optional<Assignments>
+{
+  if (!task_planner || !travel_estimator)
+    return std::nullopt;
+
+  if (!allocation_cost_per_task.has_value()
+    || incremental_allocation_threshold < 0.0)
+    return std::nullopt;
+
+  Assignments assignments;
+  assignments.reserve(task_managers.size());
+  std::size_t index = 0;
+  for (const auto& [_, tm] : task_managers)
+  {
+    if (index++ != robot_index)
+    {
+      assignments.push_back(tm->get_queue());
+      continue;
+    }
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (const auto& a : tm->get_queue())
+      requests.push_back(a.request());
+
+    auto queue = estimate_queue(
+      *task_planner, tm->expected_finish_state(), requests, *travel_estimator);
+    if (!queue.has_value())
+      return std::nullopt;
+
+    assignments.push_back(std::move(*queue));
+  }
+
+  if (!within_cost_threshold(
+      *task_planner, assignments, allocation_cost_per_task,
+      incremental_allocation_threshold))
+    return std::nullopt;
+
+  return assignments;
+}
+
+//==============================================================================
+void FleetUpdateHandle::Implementation::record_full_allocation(
+  const Assignments& assignments)
+{
+  std::size_t num_tasks = 0;
+  for (const auto& queue : assignments)
+    num_tasks += queue.size();
+
+  if (num_tasks == 0)
+    return;
+
+  allocation_cost_per_task =
+    task_planner->compute_cost(assignments) / num_tasks;
+}
+
 //==============================================================================
 auto FleetUpdateHandle::Implementation::allocate_tasks(
   rmf_task::ConstRequestPtr new_request,
@@ -1061,8 +2241,21 @@ auto FleetUpdateHandle::Implementation::allocate_tasks(
     expect.states.size(),
     expect.pending_requests.size());
 
+  return plan_assignments(task_planner, node, expect, id, errors);
+}
+
+//==============================================================================
+auto FleetUpdateHandle::Implementation::plan_assignments(
+  const std::shared_ptr<const rmf_task::TaskPlanner>& planner,
+  const std::shared_ptr<Node>& node,
+  const Expectations& expect,
+  const std::string& id,
+  std::vector<std::string>* errors) -> std::optional<Assignments>
+{
+  tracing::Span span("plan_assignments", id);
+
   // Generate new task assignments
-  const auto result = task_planner->plan(
+  const auto result = planner->plan(
     rmf_traffic_ros2::convert(node->now()),
     expect.states,
     expect.pending_requests);
@@ -1174,7 +2367,8 @@ void FleetUpdateHandle::add_robot(
       if (!fleet)
         return;
 
-      const auto charger_wp = fleet->_pimpl->get_nearest_charger(start[0]);
+      const auto charger_wp = fleet->_pimpl->assign_charger(
+        participant.description().name(), start[0]);
 
       if (!charger_wp.has_value())
       {
@@ -1189,6 +2383,15 @@ void FleetUpdateHandle::add_robot(
       rmf_task::State state;
       state.load_basic(start[0], charger_wp.value(), 1.0);
 
+      auto& fleet_impl = *fleet->_pimpl;
+      auto robot_worker = fleet_impl.worker;
+      if (!fleet_impl.robot_workers.empty())
+      {
+        const auto index =
+          fleet_impl.next_robot_worker++ % fleet_impl.robot_workers.size();
+        robot_worker = fleet_impl.robot_workers[index];
+      }
+
       auto context = std::make_shared<RobotContext>(
         RobotContext
         {
@@ -1200,12 +2403,25 @@ void FleetUpdateHandle::add_robot(
           fleet->_pimpl->activation.task,
           fleet->_pimpl->task_parameters,
           fleet->_pimpl->node,
-          fleet->_pimpl->worker,
+          robot_worker,
           fleet->_pimpl->default_maximum_delay,
           state,
           fleet->_pimpl->task_planner
         }
       );
+      context->lane_index(fleet->_pimpl->lane_index);
+      context->level_portals(fleet->_pimpl->level_portals);
+      context->pullover_candidates(
+        fleet->_pimpl->travel_time_table,
+        fleet->_pimpl->parking_waypoints,
+        fleet->_pimpl->pullover_candidates);
+      context->pullover_coordinator(fleet->_pimpl->pullover_coordinator);
+      context->lift_session_sharing(fleet->_pimpl->lift_session_sharing);
+      context->charger_scheduler(fleet->_pimpl->charger_scheduler);
+      context->battery_soc_filter(
+        fleet->_pimpl->battery_soc_change_threshold,
+        fleet->_pimpl->battery_soc_hysteresis);
+      context->idle_wait_horizon(fleet->_pimpl->idle_wait_horizon);
 
       // We schedule the following operations on the worker to make sure we do not
       // have a multiple read/write race condition on the FleetUpdateHandle.
@@ -1300,6 +2516,8 @@ void FleetUpdateHandle::add_robot(
           if (fleet->_pimpl->broadcast_client)
             broadcast_client = fleet->_pimpl->broadcast_client;
 
+          context->travel_estimator(fleet->_pimpl->travel_estimator);
+          context->energy_table(fleet->_pimpl->energy_table);
           fleet->_pimpl->task_managers.insert({context,
             TaskManager::make(
               context,
@@ -1309,6 +2527,86 @@ void FleetUpdateHandle::add_robot(
     });
 }
 
+//==============================================================================
+void FleetUpdateHandle::add_robots(
+  std::vector<NewRobot> robots,
+  std::function<void(std::vector<std::shared_ptr<RobotUpdateHandle>>)>
+  handles_cb)
+{
+  for (const auto& robot : robots)
+  {
+    if (robot.start.empty())
+    {
+      // *INDENT-OFF*
+      throw std::runtime_error(
+        "[FleetUpdateHandle::add_robots] StartSet of robot [" + robot.name
+        + "] is empty. Adding a robot to a fleet requires at least one "
+        "rmf_traffic::agv::Plan::Start to be specified.");
+      // *INDENT-ON*
+    }
+  }
+
+  struct Batch
+  {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<RobotUpdateHandle>> handles;
+    std::size_t remaining;
+    std::chrono::steady_clock::time_point start_time;
+  };
+
+  auto batch = std::make_shared<Batch>();
+  batch->handles.resize(robots.size());
+  batch->remaining = robots.size();
+  batch->start_time = std::chrono::steady_clock::now();
+
+  const auto finish =
+    [w = weak_from_this(), batch, handles_cb = std::move(handles_cb)]()
+    {
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      const auto elapsed = std::chrono::steady_clock::now() - batch->start_time;
+      RCLCPP_INFO(
+        self->_pimpl->node->get_logger(),
+        "Added a batch of %lu robots to fleet [%s] in %.3f seconds",
+        batch->handles.size(),
+        self->_pimpl->name.c_str(),
+        rmf_traffic::time::to_seconds(elapsed));
+
+      if (handles_cb)
+        handles_cb(std::move(batch->handles));
+    };
+
+  if (robots.empty())
+  {
+    finish();
+    return;
+  }
+
+  // Every registration is requested right away. Each handle callback runs in
+  // the middle of the setup job of its robot on the fleet worker, so the batch
+  // callback is scheduled after that job to make sure that the TaskManager of
+  // the last robot is in place.
+  for (std::size_t i = 0; i < robots.size(); ++i)
+  {
+    auto& robot = robots[i];
+    add_robot(
+      std::move(robot.command),
+      robot.name,
+      robot.profile,
+      std::move(robot.start),
+      [worker = _pimpl->worker, batch, finish, i](
+        std::shared_ptr<RobotUpdateHandle> handle)
+      {
+        std::lock_guard<std::mutex> lock(batch->mutex);
+        batch->handles[i] = std::move(handle);
+        if (--batch->remaining == 0)
+          worker.schedule([finish](const auto&) { finish(); });
+      });
+  }
+}
+
 //==============================================================================
 class FleetUpdateHandle::Confirmation::Implementation
 {
@@ -1370,6 +2668,7 @@ FleetUpdateHandle& FleetUpdateHandle::consider_delivery_requests(
 {
   *_pimpl->deserialization.consider_pickup = std::move(consider_pickup);
   *_pimpl->deserialization.consider_dropoff = std::move(consider_dropoff);
+  _pimpl->advertise_bid_capabilities();
   return *this;
 }
 
@@ -1378,6 +2677,7 @@ FleetUpdateHandle& FleetUpdateHandle::consider_cleaning_requests(
   ConsiderRequest consider)
 {
   *_pimpl->deserialization.consider_clean = std::move(consider);
+  _pimpl->advertise_bid_capabilities();
   return *this;
 }
 
@@ -1386,6 +2686,7 @@ FleetUpdateHandle& FleetUpdateHandle::consider_bookshelf_requests(
   ConsiderRequest consider)
 {
   *_pimpl->deserialization.consider_bookshelf = std::move(consider);
+  _pimpl->advertise_bid_capabilities();
   return *this;
 }
 
@@ -1394,6 +2695,7 @@ FleetUpdateHandle& FleetUpdateHandle::consider_patrol_requests(
   ConsiderRequest consider)
 {
   *_pimpl->deserialization.consider_patrol = std::move(consider);
+  _pimpl->advertise_bid_capabilities();
   return *this;
 }
 
@@ -1402,91 +2704,216 @@ FleetUpdateHandle& FleetUpdateHandle::consider_composed_requests(
   ConsiderRequest consider)
 {
   *_pimpl->deserialization.consider_composed = std::move(consider);
+  _pimpl->advertise_bid_capabilities();
   return *this;
 }
 
 //==============================================================================
 void FleetUpdateHandle::close_lanes(std::vector<std::size_t> lane_indices)
+{
+  change_lanes({}, std::move(lane_indices));
+}
+
+//==============================================================================
+void FleetUpdateHandle::change_lanes(
+  std::vector<std::size_t> open_lanes,
+  std::vector<std::size_t> close_lanes)
 {
   _pimpl->worker.schedule(
-    [w = weak_from_this(), lane_indices = std::move(lane_indices)](const auto&)
+    [w = weak_from_this(),
+    open_lanes = std::move(open_lanes),
+    close_lanes = std::move(close_lanes)](const auto&) mutable
     {
       const auto self = w.lock();
       if (!self)
         return;
 
-      const auto& current_lane_closures =
-      (*self->_pimpl->planner)->get_configuration().lane_closures();
-
-      bool any_changes = false;
-      for (const auto& lane : lane_indices)
-      {
-        if (current_lane_closures.is_open(lane))
+      // Lanes outside of the graph never show up as closed
+      const auto& config = (*self->_pimpl->planner)->get_configuration();
+      const auto num_lanes = config.graph().num_lanes();
+      const auto prepare = [num_lanes](std::vector<std::size_t>& lanes)
         {
-          any_changes = true;
-          break;
-        }
-      }
-
-      if (!any_changes)
+          lanes.erase(
+            std::remove_if(
+              lanes.begin(), lanes.end(),
+              [num_lanes](std::size_t lane) { return lane >= num_lanes; }),
+            lanes.end());
+          std::sort(lanes.begin(), lanes.end());
+          lanes.erase(std::unique(lanes.begin(), lanes.end()), lanes.end());
+        };
+      prepare(open_lanes);
+      prepare(close_lanes);
+
+      // Lanes that are being closed take precedence over lanes being opened
+      const auto& current_closed = self->_pimpl->current_closed_lanes();
+      std::vector<std::size_t> still_closed;
+      std::set_difference(
+        current_closed.begin(), current_closed.end(),
+        open_lanes.begin(), open_lanes.end(),
+        std::back_inserter(still_closed));
+
+      std::vector<std::size_t> closed;
+      std::set_union(
+        still_closed.begin(), still_closed.end(),
+        close_lanes.begin(), close_lanes.end(),
+        std::back_inserter(closed));
+
+      if (closed == current_closed)
       {
         // No changes are needed to the planner
         return;
       }
 
-      auto new_config = (*self->_pimpl->planner)->get_configuration();
-      auto& new_lane_closures = new_config.lane_closures();
-      for (const auto& lane : lane_indices)
-        new_lane_closures.close(lane);
+      auto new_lane_closures = config.lane_closures();
+      for (const auto& lane : open_lanes)
+        new_lane_closures.open(lane);
 
-      *self->_pimpl->planner =
-      std::make_shared<const rmf_traffic::agv::Planner>(
-        new_config, rmf_traffic::agv::Planner::Options(nullptr));
+      for (const auto& lane : close_lanes)
+        new_lane_closures.close(lane);
 
-      self->_pimpl->task_parameters->planner(*self->_pimpl->planner);
+      self->_pimpl->set_lane_closures(
+        std::move(new_lane_closures), std::move(closed));
     });
 }
 
 //==============================================================================
-void FleetUpdateHandle::open_lanes(std::vector<std::size_t> lane_indices)
+auto FleetUpdateHandle::RobotPosition::on_waypoint(
+  std::shared_ptr<RobotUpdateHandle> robot,
+  const std::size_t waypoint,
+  const double orientation) -> RobotPosition
 {
-  _pimpl->worker.schedule(
-    [w = weak_from_this(), lane_indices = std::move(lane_indices)](const auto&)
+  return RobotPosition{
+    std::move(robot), Type::OnWaypoint,
+    Eigen::Vector3d(0.0, 0.0, orientation), waypoint, {}, {}
+  };
+}
+
+//==============================================================================
+auto FleetUpdateHandle::RobotPosition::on_lanes(
+  std::shared_ptr<RobotUpdateHandle> robot,
+  Eigen::Vector3d position,
+  std::vector<std::size_t> lanes) -> RobotPosition
+{
+  return RobotPosition{
+    std::move(robot), Type::OnLanes, position, 0, std::move(lanes), {}
+  };
+}
+
+//==============================================================================
+auto FleetUpdateHandle::RobotPosition::off_grid(
+  std::shared_ptr<RobotUpdateHandle> robot,
+  Eigen::Vector3d position,
+  const std::size_t target_waypoint) -> RobotPosition
+{
+  return RobotPosition{
+    std::move(robot), Type::OffGrid, position, target_waypoint, {}, {}
+  };
+}
+
+//==============================================================================
+auto FleetUpdateHandle::RobotPosition::lost(
+  std::shared_ptr<RobotUpdateHandle> robot,
+  std::string map_name,
+  Eigen::Vector3d position) -> RobotPosition
+{
+  return RobotPosition{
+    std::move(robot), Type::Lost, position, 0, {}, std::move(map_name)
+  };
+}
+
+//==============================================================================
+void FleetUpdateHandle::update_positions(
+  const std::vector<RobotPosition>& positions)
+{
+  for (const auto& p : positions)
+  {
+    if (p.type == RobotPosition::Type::OnLanes && p.lanes.empty())
     {
-      const auto self = w.lock();
-      if (!self)
-        return;
+      // *INDENT-OFF*
+      throw std::runtime_error(
+        "[FleetUpdateHandle::update_positions] No lanes specified for a "
+        "position of type OnLanes, which requires at least one lane.");
+      // *INDENT-ON*
+    }
+  }
 
-      const auto& current_lane_closures =
-      (*self->_pimpl->planner)->get_configuration().lane_closures();
+  const auto now = rmf_traffic_ros2::convert(_pimpl->node->now());
 
-      bool any_changes = false;
-      for (const auto& lane : lane_indices)
+  // Only the last position of each robot matters, since each one replaces the
+  // location that came before it.
+  std::unordered_map<
+    RobotContext*,
+    std::pair<std::shared_ptr<RobotContext>, rmf_traffic::agv::Plan::StartSet>
+  > updates;
+
+  for (const auto& p : positions)
+  {
+    if (!p.robot)
+      continue;
+
+    auto context = RobotUpdateHandle::Implementation::get(*p.robot)
+      .get_context();
+    if (!context)
+      continue;
+
+    const Eigen::Vector2d location = p.position.block<2, 1>(0, 0);
+    const double yaw = p.position[2];
+    rmf_traffic::agv::Plan::StartSet starts;
+    switch (p.type)
+    {
+      case RobotPosition::Type::OnWaypoint:
+        starts.push_back({now, p.waypoint, yaw});
+        break;
+      case RobotPosition::Type::OnLanes:
       {
-        if (current_lane_closures.is_closed(lane))
+        const auto& graph = context->navigation_graph();
+        for (const auto l : p.lanes)
         {
-          any_changes = true;
-          break;
+          const auto wp = graph.get_lane(l).exit().waypoint_index();
+          starts.push_back({now, wp, yaw, location, l});
         }
+        break;
       }
-
-      if (!any_changes)
+      case RobotPosition::Type::OffGrid:
+        starts.push_back({now, p.waypoint, yaw, location});
+        break;
+      case RobotPosition::Type::Lost:
       {
-        // No changes are needed to the planner
-        return;
+        starts = context->compute_plan_starts(p.map_name, p.position, now);
+
+        if (starts.empty())
+        {
+          RCLCPP_ERROR(
+            _pimpl->node->get_logger(),
+            "[FleetUpdateHandle::update_positions] The robot [%s] has "
+            "diverged from its navigation graph, currently located at "
+            "<%f, %f, %f> on map [%s]", context->requester_id().c_str(),
+            p.position[0], p.position[1], p.position[2], p.map_name.c_str());
+          continue;
+        }
+        break;
       }
+    }
 
-      auto new_config = (*self->_pimpl->planner)->get_configuration();
-      auto& new_lane_closures = new_config.lane_closures();
-      for (const auto& lane : lane_indices)
-        new_lane_closures.open(lane);
+    auto* const key = context.get();
+    updates[key] = {std::move(context), std::move(starts)};
+  }
 
-      *self->_pimpl->planner =
-      std::make_shared<const rmf_traffic::agv::Planner>(
-        new_config, rmf_traffic::agv::Planner::Options(nullptr));
+  for (auto& [_, update] : updates)
+  {
+    auto& context = update.first;
+    context->worker().schedule(
+      [context, starts = std::move(update.second)](const auto&)
+      {
+        context->_set_location(std::move(starts));
+      });
+  }
+}
 
-      self->_pimpl->task_parameters->planner(*self->_pimpl->planner);
-    });
+//==============================================================================
+void FleetUpdateHandle::open_lanes(std::vector<std::size_t> lane_indices)
+{
+  change_lanes(std::move(lane_indices), {});
 }
 
 //==============================================================================
@@ -1782,7 +3209,8 @@ bool FleetUpdateHandle::set_task_planner_params(
       finishing_request};
 
     _pimpl->worker.schedule(
-      [w = weak_from_this(), task_config, options](const auto&)
+      [w = weak_from_this(), task_config, options,
+      motion_sink, ambient_sink](const auto&)
       {
         const auto self = w.lock();
         if (!self)
@@ -1797,6 +3225,9 @@ bool FleetUpdateHandle::set_task_planner_params(
 
         for (const auto& t : self->_pimpl->task_managers)
           t.first->task_planner(self->_pimpl->task_planner);
+
+        self->_pimpl->update_travel_estimator();
+        self->_pimpl->update_energy_table(motion_sink, ambient_sink);
       });
 
     return true;
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_fleet_adapter/agv/GraphEventIndex.hpp>
+
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+class GraphEventIndex::Implementation
+{
+public:
+
+  using Lanes = std::vector<std::size_t>;
+  using Index = std::unordered_map<std::string, Lanes>;
+
+  Index docks;
+  Index doors;
+  Index lifts;
+
+  const Lanes& find(const Index& index, const std::string& name) const
+  {
+    static const Lanes empty;
+    const auto it = index.find(name);
+    if (it == index.end())
+      return empty;
+
+    return it->second;
+  }
+};
+
+namespace {
+//==============================================================================
+class EventIndexer : public rmf_traffic::agv::Graph::Lane::Executor
+{
+public:
+
+  EventIndexer(GraphEventIndex::Implementation& index)
+  : _index(index)
+  {
+    // Do nothing
+  }
+
+  void lane(std::size_t lane_index)
+  {
+    _lane = lane_index;
+  }
+
+  void execute(const Dock& dock) final
+  {
+    add(_index.docks, dock.dock_name());
+  }
+
+  void execute(const DoorOpen& open) final
+  {
+    add(_index.doors, open.name());
+  }
+
+  void execute(const DoorClose& close) final
+  {
+    add(_index.doors, close.name());
+  }
+
+  void execute(const LiftSessionBegin& begin) final
+  {
+    add(_index.lifts, begin.lift_name());
+  }
+
+  void execute(const LiftMove& move) final
+  {
+    add(_index.lifts, move.lift_name());
+  }
+
+  void execute(const LiftDoorOpen& open) final
+  {
+    add(_index.lifts, open.lift_name());
+  }
+
+  void execute(const LiftSessionEnd& end) final
+  {
+    add(_index.lifts, end.lift_name());
+  }
+
+  void execute(const Wait&) final {}
+
+private:
+
+  void add(GraphEventIndex::Implementation::Index& index,
+    const std::string& name)
+  {
+    // A lane can have the same name on both of its events, e.g. a door that
+    // opens on entry and closes on exit, but it only needs to be listed once.
+    auto& lanes = index[name];
+    if (lanes.empty() || lanes.back() != _lane)
+      lanes.push_back(_lane);
+  }
+
+  GraphEventIndex::Implementation& _index;
+  std::size_t _lane = 0;
+};
+} // anonymous namespace
+
+//==============================================================================
+GraphEventIndex::GraphEventIndex(const rmf_traffic::agv::Graph& graph)
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  EventIndexer indexer(*_pimpl);
+  for (std::size_t i = 0; i < graph.num_lanes(); ++i)
+  {
+    const auto& lane = graph.get_lane(i);
+    indexer.lane(i);
+    if (const auto* event = lane.entry().event())
+      event->execute(indexer);
+
+    if (const auto* event = lane.exit().event())
+      event->execute(indexer);
+  }
+}
+
+//==============================================================================
+const std::vector<std::size_t>& GraphEventIndex::dock_lanes(
+  const std::string& dock_name) const
+{
+  return _pimpl->find(_pimpl->docks, dock_name);
+}
+
+//==============================================================================
+const std::vector<std::size_t>& GraphEventIndex::door_lanes(
+  const std::string& door_name) const
+{
+  return _pimpl->find(_pimpl->doors, door_name);
+}
+
+//==============================================================================
+const std::vector<std::size_t>& GraphEventIndex::lift_lanes(
+  const std::string& lift_name) const
+{
+  return _pimpl->find(_pimpl->lifts, lift_name);
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
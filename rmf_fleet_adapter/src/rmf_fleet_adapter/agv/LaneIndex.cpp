@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_LaneIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+LaneIndex::LaneIndex(
+  const rmf_traffic::agv::Graph& graph,
+  const double cell_size)
+: _cell_size(cell_size > 0.0 ? cell_size : 5.0)
+{
+  const auto grow = [](Map& map, const CellKey& key, const bool first)
+    {
+      if (first)
+      {
+        map.min_x = map.max_x = key.x;
+        map.min_y = map.max_y = key.y;
+        return;
+      }
+
+      map.min_x = std::min(map.min_x, key.x);
+      map.min_y = std::min(map.min_y, key.y);
+      map.max_x = std::max(map.max_x, key.x);
+      map.max_y = std::max(map.max_y, key.y);
+    };
+
+  _waypoints.reserve(graph.num_waypoints());
+  for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+  {
+    const auto& wp = graph.get_waypoint(i);
+    const Eigen::Vector2d p = wp.get_location();
+    _waypoints.push_back(p);
+
+    const auto inserted = _maps.insert({wp.get_map_name(), Map()});
+    auto& map = inserted.first->second;
+    const auto key = _key(p);
+    grow(map, key, inserted.second);
+    map.cells[key].waypoints.push_back(i);
+  }
+
+  _lanes.reserve(graph.num_lanes());
+  for (std::size_t i = 0; i < graph.num_lanes(); ++i)
+  {
+    const auto& lane = graph.get_lane(i);
+    const auto& entry = graph.get_waypoint(lane.entry().waypoint_index());
+    const auto& exit = graph.get_waypoint(lane.exit().waypoint_index());
+    _lanes.push_back({entry.get_location(), exit.get_location(), exit.index()});
+
+    // A robot cannot be partway down a lane that moves it to a different map,
+    // such as a lift lane, so those lanes are left out.
+    if (entry.get_map_name() != exit.get_map_name())
+      continue;
+
+    auto& map = _maps.at(entry.get_map_name());
+    const auto k0 = _key(entry.get_location());
+    const auto k1 = _key(exit.get_location());
+    for (int64_t x = std::min(k0.x, k1.x); x <= std::max(k0.x, k1.x); ++x)
+    {
+      for (int64_t y = std::min(k0.y, k1.y); y <= std::max(k0.y, k1.y); ++y)
+        map.cells[CellKey{x, y}].lanes.push_back(i);
+    }
+  }
+}
+
+//==============================================================================
+auto LaneIndex::_key(const Eigen::Vector2d& p) const -> CellKey
+{
+  return CellKey{
+    static_cast<int64_t>(std::floor(p.x() / _cell_size)),
+    static_cast<int64_t>(std::floor(p.y() / _cell_size))
+  };
+}
+
+//==============================================================================
+template<typename F>
+void LaneIndex::_for_each_cell(
+  const Map& map,
+  const Eigen::Vector2d& p,
+  const double radius,
+  F&& f) const
+{
+  const auto k0 = _key(p - Eigen::Vector2d(radius, radius));
+  const auto k1 = _key(p + Eigen::Vector2d(radius, radius));
+  for (int64_t x = k0.x; x <= k1.x; ++x)
+  {
+    for (int64_t y = k0.y; y <= k1.y; ++y)
+    {
+      const auto it = map.cells.find(CellKey{x, y});
+      if (it != map.cells.end())
+        f(it->second);
+    }
+  }
+}
+
+//==============================================================================
+std::vector<rmf_traffic::agv::Plan::Start> LaneIndex::compute_plan_starts(
+  const std::string& map_name,
+  const Eigen::Vector3d& pose,
+  const rmf_traffic::Time start_time,
+  const double max_merge_waypoint_distance,
+  const double max_merge_lane_distance,
+  const double min_lane_length) const
+{
+  const auto map_it = _maps.find(map_name);
+  if (map_it == _maps.end())
+    return {};
+
+  const auto& map = map_it->second;
+  const Eigen::Vector2d p_location = pose.block<2, 1>(0, 0);
+  const double start_yaw = pose[2];
+
+  // The graph would be scanned in order of waypoint index, so the lowest index
+  // that is close enough is the one that gets used.
+  std::optional<std::size_t> merge_wp;
+  _for_each_cell(
+    map, p_location, max_merge_waypoint_distance, [&](const Cell& cell)
+    {
+      for (const auto i : cell.waypoints)
+      {
+        if (merge_wp.has_value() && *merge_wp < i)
+          continue;
+
+        if ((p_location - _waypoints[i]).norm() < max_merge_waypoint_distance)
+          merge_wp = i;
+      }
+    });
+
+  if (merge_wp.has_value())
+    return {rmf_traffic::agv::Plan::Start(start_time, *merge_wp, start_yaw)};
+
+  std::vector<std::size_t> candidates;
+  _for_each_cell(
+    map, p_location, max_merge_lane_distance, [&](const Cell& cell)
+    {
+      candidates.insert(candidates.end(), cell.lanes.begin(), cell.lanes.end());
+    });
+
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(
+    std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  std::vector<rmf_traffic::agv::Plan::Start> starts;
+  for (const auto i : candidates)
+  {
+    const auto& lane = _lanes[i];
+    const Eigen::Vector2d& p0 = lane.entry;
+    const Eigen::Vector2d& p1 = lane.exit;
+    const double lane_length = (p1 - p0).norm();
+    if (lane_length < min_lane_length)
+      continue;
+
+    const Eigen::Vector2d pn = (p1 - p0) / lane_length;
+    const Eigen::Vector2d p_l = p_location - p0;
+    const double p_l_projection = p_l.dot(pn);
+    const double lane_dist = (p_l - p_l_projection*pn).norm();
+
+    if (0.0 <= p_l_projection && p_l_projection <= lane_length
+      && lane_dist <= max_merge_lane_distance)
+    {
+      starts.emplace_back(
+        start_time, lane.exit_waypoint, start_yaw, p_location, i);
+    }
+  }
+
+  return starts;
+}
+
+//==============================================================================
+auto LaneIndex::nearest_waypoint(
+  const std::string& map_name,
+  const Eigen::Vector2d& location) const -> std::optional<Nearest>
+{
+  const auto map_it = _maps.find(map_name);
+  if (map_it == _maps.end())
+    return std::nullopt;
+
+  const auto& map = map_it->second;
+  const auto center = _key(location);
+  std::optional<Nearest> nearest;
+
+  // Search rings of cells around the location, moving outwards until no
+  // waypoint in the next ring could be closer than the nearest one so far.
+  const int64_t max_ring = std::max({
+      std::abs(center.x - map.min_x), std::abs(center.x - map.max_x),
+      std::abs(center.y - map.min_y), std::abs(center.y - map.max_y)});
+
+  for (int64_t ring = 0; ring <= max_ring; ++ring)
+  {
+    if (nearest.has_value()
+      && nearest->distance < static_cast<double>(ring - 1) * _cell_size)
+    {
+      break;
+    }
+
+    // Cells outside of the range that contains waypoints can be skipped
+    const int64_t x0 = std::max(center.x - ring, map.min_x);
+    const int64_t x1 = std::min(center.x + ring, map.max_x);
+    const int64_t y0 = std::max(center.y - ring, map.min_y);
+    const int64_t y1 = std::min(center.y + ring, map.max_y);
+    for (int64_t x = x0; x <= x1; ++x)
+    {
+      for (int64_t y = y0; y <= y1; ++y)
+      {
+        if (std::abs(x - center.x) != ring && std::abs(y - center.y) != ring)
+          continue;
+
+        const auto it = map.cells.find(CellKey{x, y});
+        if (it == map.cells.end())
+          continue;
+
+        for (const auto i : it->second.waypoints)
+        {
+          const double distance = (location - _waypoints[i]).norm();
+          if (!nearest.has_value() || distance < nearest->distance)
+            nearest = Nearest{i, distance};
+        }
+      }
+    }
+  }
+
+  return nearest;
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_LevelPortals.hpp"
+
+#include <algorithm>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+class LiftExitFinder : public rmf_traffic::agv::Graph::Lane::Executor
+{
+public:
+
+  bool found = false;
+
+  void execute(const Dock&) final {}
+  void execute(const DoorOpen&) final {}
+  void execute(const DoorClose&) final {}
+  void execute(const LiftSessionBegin&) final {}
+  void execute(const LiftMove&) final {}
+  void execute(const LiftDoorOpen&) final {}
+  void execute(const Wait&) final {}
+
+  void execute(const LiftSessionEnd&) final
+  {
+    found = true;
+  }
+};
+} // anonymous namespace
+
+//==============================================================================
+LevelPortals::LevelPortals(
+  const rmf_traffic::agv::Graph& graph,
+  std::shared_ptr<const TravelTimeTable> travel_times)
+: _graph(graph),
+  _travel_times(std::move(travel_times)),
+  _is_portal(graph.num_waypoints(), false)
+{
+  for (std::size_t i = 0; i < _graph.num_lanes(); ++i)
+  {
+    const auto& lane = _graph.get_lane(i);
+    LiftExitFinder finder;
+    if (const auto* event = lane.entry().event())
+      event->execute(finder);
+
+    if (const auto* event = lane.exit().event())
+      event->execute(finder);
+
+    if (finder.found)
+      _is_portal[lane.exit().waypoint_index()] = true;
+  }
+
+  for (std::size_t wp = 0; wp < _is_portal.size(); ++wp)
+  {
+    if (_is_portal[wp])
+      _portals.push_back(wp);
+  }
+}
+
+//==============================================================================
+const std::vector<std::size_t>& LevelPortals::portals() const
+{
+  return _portals;
+}
+
+//==============================================================================
+std::optional<double> LevelPortals::cost(
+  const std::size_t from_portal,
+  const std::size_t to_portal) const
+{
+  return _travel_times->travel_time(from_portal, to_portal);
+}
+
+//==============================================================================
+std::optional<std::size_t> LevelPortals::next_portal(
+  const rmf_traffic::agv::Planner::Start& start,
+  const std::size_t goal) const
+{
+  if (_portals.empty())
+    return std::nullopt;
+
+  const auto& start_map = _graph.get_waypoint(start.waypoint()).get_map_name();
+  if (_graph.get_waypoint(goal).get_map_name() == start_map)
+    return std::nullopt;
+
+  // Trace the shortest path back from the goal
+  const auto arrival = _travel_times->arrival_lanes(start.waypoint());
+  std::vector<std::size_t> path;
+  for (std::size_t wp = goal; wp != start.waypoint(); )
+  {
+    const auto lane = arrival[wp];
+    if (lane == TravelTimeTable::NoLane)
+      return std::nullopt;
+
+    path.push_back(wp);
+    wp = _graph.get_lane(lane).entry().waypoint_index();
+  }
+
+  for (auto it = path.rbegin(); it != path.rend(); ++it)
+  {
+    const auto wp = *it;
+    if (!_is_portal[wp])
+      continue;
+
+    if (_graph.get_waypoint(wp).get_map_name() == start_map)
+      continue;
+
+    if (wp == goal)
+      return std::nullopt;
+
+    return wp;
+  }
+
+  return std::nullopt;
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_LiftSessionSharing.hpp"
+
+#include <algorithm>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+double LiftSessionSharing::Ride::area() const
+{
+  double total = 0.0;
+  for (const auto& [_, member] : members)
+    total += member.area;
+
+  return total;
+}
+
+//==============================================================================
+LiftSessionSharing::LiftSessionSharing(std::string fleet_name, Config config)
+: _fleet_name(std::move(fleet_name)),
+  _config(config)
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto LiftSessionSharing::config() const -> const Config&
+{
+  return _config;
+}
+
+//==============================================================================
+std::string LiftSessionSharing::join(
+  const std::string& lift,
+  const std::string& from_floor,
+  const std::string& to_floor,
+  const std::string& requester_id,
+  const double footprint_area,
+  const rmf_traffic::Time now)
+{
+  if (_config.capacity <= 1)
+    return requester_id;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const MemberKey key{lift, requester_id};
+  const auto existing = _session_of.find(key);
+  if (existing != _session_of.end())
+    return existing->second;
+
+  const auto fits = [&](const Ride& ride)
+    {
+      if (ride.departed || ride.lift != lift || ride.from_floor != from_floor
+        || ride.to_floor != to_floor)
+        return false;
+
+      if (ride.members.size() >= _config.capacity || now >= _closes(ride))
+        return false;
+
+      return _config.cabin_area <= 0.0
+        || ride.area() + footprint_area <= _config.cabin_area;
+    };
+
+  auto it = std::find_if(
+    _rides.begin(), _rides.end(),
+    [&](const auto& entry) { return fits(entry.second); });
+
+  if (it == _rides.end())
+  {
+    // A robot that does not fit in the cabin with anyone else still gets a
+    // ride of its own, so the others get a ride without it.
+    const std::string session =
+      _fleet_name + "/" + lift + "/ride_" + std::to_string(_next_ride++);
+
+    Ride ride;
+    ride.lift = lift;
+    ride.from_floor = from_floor;
+    ride.to_floor = to_floor;
+    ride.opened = now;
+    it = _rides.insert({session, std::move(ride)}).first;
+  }
+
+  auto& ride = it->second;
+  ride.members[requester_id] = Member{footprint_area};
+  const bool full = ride.members.size() >= _config.capacity
+    || (_config.cabin_area > 0.0 && ride.area() >= _config.cabin_area);
+  if (full && !ride.filled.has_value())
+    ride.filled = now;
+
+  _session_of[key] = it->first;
+  return it->first;
+}
+
+//==============================================================================
+void LiftSessionSharing::board(
+  const std::string& lift,
+  const std::string& requester_id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (auto* ride = _ride_of({lift, requester_id}))
+    ride->members.at(requester_id).boarded = true;
+}
+
+//==============================================================================
+std::optional<std::string> LiftSessionSharing::hold_at(
+  const std::string& lift,
+  const std::string& requester_id,
+  const rmf_traffic::Time now)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto* ride = _ride_of({lift, requester_id});
+  if (!ride || ride->departed)
+    return std::nullopt;
+
+  const auto closes = _closes(*ride);
+  if (now < closes)
+    return ride->from_floor;
+
+  const bool all_boarded = std::all_of(
+    ride->members.begin(), ride->members.end(),
+    [](const auto& entry) { return entry.second.boarded; });
+
+  if (!all_boarded)
+  {
+    if (now < closes + _config.boarding_grace)
+      return ride->from_floor;
+
+    // Leave without the robots that are still not in the cabin. They will
+    // use a session of their own from now on.
+    for (auto it = ride->members.begin(); it != ride->members.end(); )
+    {
+      if (it->second.boarded)
+      {
+        ++it;
+        continue;
+      }
+
+      _session_of.erase({lift, it->first});
+      it = ride->members.erase(it);
+    }
+  }
+
+  ride->departed = true;
+  return std::nullopt;
+}
+
+//==============================================================================
+std::string LiftSessionSharing::session(
+  const std::string& lift,
+  const std::string& requester_id) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _session_of.find({lift, requester_id});
+  if (it == _session_of.end())
+    return requester_id;
+
+  return it->second;
+}
+
+//==============================================================================
+bool LiftSessionSharing::leave(
+  const std::string& lift,
+  const std::string& requester_id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _session_of.find({lift, requester_id});
+  if (it == _session_of.end())
+    return true;
+
+  const auto ride_it = _rides.find(it->second);
+  _session_of.erase(it);
+  if (ride_it == _rides.end())
+    return true;
+
+  auto& ride = ride_it->second;
+  ride.members.erase(requester_id);
+  if (!ride.members.empty())
+    return false;
+
+  _rides.erase(ride_it);
+  return true;
+}
+
+//==============================================================================
+auto LiftSessionSharing::_ride_of(const MemberKey& key) -> Ride*
+{
+  const auto it = _session_of.find(key);
+  if (it == _session_of.end())
+    return nullptr;
+
+  const auto ride_it = _rides.find(it->second);
+  if (ride_it == _rides.end())
+    return nullptr;
+
+  return &ride_it->second;
+}
+
+//==============================================================================
+rmf_traffic::Time LiftSessionSharing::_closes(const Ride& ride) const
+{
+  const auto window_closes = ride.opened + _config.boarding_window;
+  if (ride.filled.has_value())
+    return std::min(*ride.filled, window_closes);
+
+  return window_closes;
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_MemoryReport.hpp"
+#include "internal_FleetUpdateHandle.hpp"
+
+#include <rmf_fleet_adapter/StandardNames.hpp>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+diagnostic_msgs::msg::KeyValue key_value(std::string key, std::size_t value)
+{
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = std::move(key);
+  kv.value = std::to_string(value);
+  return kv;
+}
+
+//==============================================================================
+diagnostic_msgs::msg::DiagnosticStatus make_status(
+  const std::string& node_name,
+  const std::string& name,
+  const MemoryUsage& usage)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = node_name + "/memory/" + name;
+  status.hardware_id = node_name;
+  status.message = "Approximate bytes held by each component";
+  for (const auto& [component, bytes] : usage)
+    status.values.push_back(key_value(component, bytes));
+
+  status.values.push_back(key_value("total", total(usage)));
+  return status;
+}
+
+//==============================================================================
+MemoryUsage mirror_usage(const rmf_traffic::schedule::Snappable& mirror)
+{
+  const auto snapshot = mirror.snapshot();
+  std::size_t routes = 0;
+  for (const auto id : snapshot->participant_ids())
+  {
+    const auto itinerary = snapshot->get_itinerary(id);
+    if (!itinerary.has_value())
+      continue;
+
+    for (const auto& route : *itinerary)
+    {
+      if (route)
+        routes += approximate_bytes(*route);
+    }
+  }
+
+  MemoryUsage usage;
+  usage["routes"] = routes;
+  return usage;
+}
+} // anonymous namespace
+
+//==============================================================================
+const std::chrono::milliseconds MemoryReportService::RobotTimeout =
+  std::chrono::milliseconds(1000);
+
+//==============================================================================
+MemoryReportService::MemoryReportService(
+  rclcpp::Node& node,
+  Fleets fleets,
+  ConstSnappablePtr mirror)
+: _node_name(node.get_name()),
+  _fleets(std::move(fleets)),
+  _mirror(std::move(mirror))
+{
+  _service = node.create_service<SelfTest>(
+    MemoryReportServiceName,
+    [this](
+      const SelfTest::Request::SharedPtr,
+      SelfTest::Response::SharedPtr response)
+    {
+      *response = make_report();
+    });
+}
+
+//==============================================================================
+auto MemoryReportService::make_report() const -> SelfTest::Response
+{
+  SelfTest::Response response;
+  response.id = _node_name;
+  response.passed = true;
+
+  if (_mirror)
+  {
+    response.status.push_back(
+      make_status(_node_name, "schedule_mirror", mirror_usage(*_mirror)));
+  }
+
+  // Ask every robot to measure itself before waiting on any of them, so the
+  // robots that have their own workers get measured in parallel.
+  using RobotUsage =
+    std::vector<std::pair<std::string, std::future<MemoryUsage>>>;
+  std::vector<std::pair<std::string, RobotUsage>> robots;
+  std::vector<std::pair<std::string, MemoryUsage>> fleets;
+  for (const auto& fleet : _fleets())
+  {
+    const auto& fleet_impl = FleetUpdateHandle::Implementation::get(*fleet);
+    robots.emplace_back(fleet_impl.name, fleet_impl.robot_memory_usage());
+    fleets.emplace_back(fleet_impl.name, fleet_impl.memory_usage());
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + RobotTimeout;
+  for (std::size_t i = 0; i < fleets.size(); ++i)
+  {
+    const auto& fleet_name = fleets[i].first;
+    std::vector<diagnostic_msgs::msg::DiagnosticStatus> robot_statuses;
+    std::size_t robots_total = 0;
+    std::size_t measured = 0;
+    for (auto& [robot_name, future] : robots[i].second)
+    {
+      const auto name = fleet_name + "/" + robot_name;
+      if (future.wait_until(deadline) != std::future_status::ready)
+      {
+        diagnostic_msgs::msg::DiagnosticStatus status;
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+        status.name = _node_name + "/memory/" + name;
+        status.hardware_id = _node_name;
+        status.message = "The worker of this robot did not measure it in time";
+        robot_statuses.push_back(std::move(status));
+        response.passed = false;
+        continue;
+      }
+
+      const auto usage = future.get();
+      robots_total += total(usage);
+      ++measured;
+      robot_statuses.push_back(make_status(_node_name, name, usage));
+    }
+
+    auto fleet_status = make_status(_node_name, fleet_name, fleets[i].second);
+    fleet_status.values.push_back(key_value("robots", measured));
+    fleet_status.values.push_back(key_value("robots_total", robots_total));
+    fleet_status.values.push_back(
+      key_value("per_robot", measured > 0 ? robots_total / measured : 0));
+
+    response.status.push_back(std::move(fleet_status));
+    for (auto& status : robot_statuses)
+      response.status.push_back(std::move(status));
+  }
+
+  return response;
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
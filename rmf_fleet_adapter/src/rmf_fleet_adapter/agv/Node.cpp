@@ -22,9 +22,55 @@
 
 #include <rmf_traffic_ros2/Time.hpp>
 
+#include <rclcpp/exceptions.hpp>
+
+#include <algorithm>
+
 namespace rmf_fleet_adapter {
 namespace agv {
 
+namespace {
+//==============================================================================
+struct TopicQoS
+{
+  int64_t depth;
+  bool reliable;
+  bool transient_local;
+};
+
+//==============================================================================
+/// Get the QoS for one of the topics of the node. Each part of the default can
+/// be overridden with the qos.<topic>.depth, qos.<topic>.reliable and
+/// qos.<topic>.transient_local parameters.
+rclcpp::QoS topic_qos(
+  rclcpp::Node& node,
+  const std::string& topic,
+  const TopicQoS& defaults)
+{
+  const std::string prefix = "qos." + topic + ".";
+  const auto depth = node.declare_parameter<int64_t>(
+    prefix + "depth", defaults.depth);
+  const auto reliable = node.declare_parameter<bool>(
+    prefix + "reliable", defaults.reliable);
+  const auto transient_local = node.declare_parameter<bool>(
+    prefix + "transient_local", defaults.transient_local);
+
+  auto qos = rclcpp::SystemDefaultsQoS();
+  qos.keep_last(static_cast<std::size_t>(std::max<int64_t>(depth, 1)));
+  if (reliable)
+    qos.reliable();
+  else
+    qos.best_effort();
+
+  if (transient_local)
+    qos.transient_local();
+  else
+    qos.durability_volatile();
+
+  return qos;
+}
+} // anonymous namespace
+
 //==============================================================================
 std::shared_ptr<Node> Node::make(
   rxcpp::schedulers::worker worker,
@@ -34,69 +80,120 @@ std::shared_ptr<Node> Node::make(
   auto node = std::shared_ptr<Node>(
     new Node(std::move(worker), node_name, options));
 
-  auto default_qos = rclcpp::SystemDefaultsQoS();
-  default_qos.keep_last(100);
-
+  // The state topics are shared by every device of a kind, so their history
+  // still needs room for a burst from many devices. Only the most recent state
+  // of each device matters though, so there is no need to keep a long history
+  // of stale states for every subscriber. Results and requests are events that
+  // must not be lost. Durability stays volatile by default because a
+  // transient local subscription cannot connect to a volatile publisher, and
+  // a late joining supervisor should not act on stale requests.
+  const TopicQoS state_qos{10, true, false};
+  const TopicQoS latest_qos{1, true, false};
+  const TopicQoS event_qos{100, true, false};
+  const TopicQoS request_qos{10, true, false};
+
+  auto& n = *node;
   node->_door_state_obs =
     node->create_observable<DoorState>(
-    DoorStateTopicName, default_qos);
+    DoorStateTopicName, topic_qos(n, "door_states", state_qos));
 
   node->_door_supervisor_obs =
     node->create_observable<DoorSupervisorState>(
-    DoorSupervisorHeartbeatTopicName, default_qos);
+    DoorSupervisorHeartbeatTopicName,
+    topic_qos(n, "door_supervisor_heartbeat", latest_qos));
 
   node->_door_request_pub =
     node->create_publisher<DoorRequest>(
-    AdapterDoorRequestTopicName, default_qos);
+    AdapterDoorRequestTopicName,
+    topic_qos(n, "adapter_door_requests", request_qos));
+
+  node->_upcoming_door_sessions_pub =
+    node->create_publisher<UpcomingDoorSessions>(
+    UpcomingDoorSessionsTopicName,
+    topic_qos(n, "adapter_upcoming_door_sessions", request_qos));
 
   node->_lift_state_obs =
     node->create_observable<LiftState>(
-    LiftStateTopicName, default_qos);
+    LiftStateTopicName, topic_qos(n, "lift_states", state_qos));
 
   node->_lift_request_pub =
     node->create_publisher<LiftRequest>(
-    AdapterLiftRequestTopicName, default_qos);
+    AdapterLiftRequestTopicName,
+    topic_qos(n, "adapter_lift_requests", request_qos));
 
   node->_task_summary_pub =
     node->create_publisher<TaskSummary>(
-    TaskSummaryTopicName, default_qos);
+    TaskSummaryTopicName, topic_qos(n, "task_summaries", event_qos));
 
   node->_dispenser_request_pub =
     node->create_publisher<DispenserRequest>(
-    DispenserRequestTopicName, default_qos);
+    DispenserRequestTopicName,
+    topic_qos(n, "dispenser_requests", request_qos));
 
   node->_dispenser_result_obs =
     node->create_observable<DispenserResult>(
-    DispenserResultTopicName, default_qos);
+    DispenserResultTopicName, topic_qos(n, "dispenser_results", event_qos));
 
   node->_dispenser_state_obs =
     node->create_observable<DispenserState>(
-    DispenserStateTopicName, default_qos);
+    DispenserStateTopicName, topic_qos(n, "dispenser_states", state_qos));
 
   node->_emergency_notice_obs =
     node->create_observable<EmergencyNotice>(
-    rmf_traffic_ros2::EmergencyTopicName, default_qos);
+    rmf_traffic_ros2::EmergencyTopicName,
+    topic_qos(n, "emergency_notice", latest_qos));
 
   node->_ingestor_request_pub =
     node->create_publisher<IngestorRequest>(
-    IngestorRequestTopicName, default_qos);
+    IngestorRequestTopicName,
+    topic_qos(n, "ingestor_requests", request_qos));
 
   node->_ingestor_result_obs =
     node->create_observable<IngestorResult>(
-    IngestorResultTopicName, default_qos);
+    IngestorResultTopicName, topic_qos(n, "ingestor_results", event_qos));
 
   node->_ingestor_state_obs =
     node->create_observable<IngestorState>(
-    IngestorStateTopicName, default_qos);
+    IngestorStateTopicName, topic_qos(n, "ingestor_states", state_qos));
 
   node->_fleet_state_pub =
     node->create_publisher<FleetState>(
-    FleetStateTopicName, default_qos);
+    FleetStateTopicName, topic_qos(n, "fleet_states", state_qos));
 
   node->_task_api_request_obs =
     node->create_observable<ApiRequest>(
     TaskApiRequests, rclcpp::SystemDefaultsQoS().reliable().transient_local());
 
+  node->_door_state_demux = KeyedDemultiplexer<DoorState>::make(
+    node->door_state(),
+    [](const DoorState& msg) -> const std::string& { return msg.door_name; });
+
+  node->_lift_state_demux = KeyedDemultiplexer<LiftState>::make(
+    node->lift_state(),
+    [](const LiftState& msg) -> const std::string& { return msg.lift_name; });
+
+  node->_dispenser_result_demux = KeyedDemultiplexer<DispenserResult>::make(
+    node->dispenser_result(),
+    [](const DispenserResult& msg) -> const std::string&
+    {
+      return msg.request_guid;
+    });
+
+  node->_dispenser_state_demux = KeyedDemultiplexer<DispenserState>::make(
+    node->dispenser_state(),
+    [](const DispenserState& msg) -> const std::string& { return msg.guid; });
+
+  node->_ingestor_result_demux = KeyedDemultiplexer<IngestorResult>::make(
+    node->ingestor_result(),
+    [](const IngestorResult& msg) -> const std::string&
+    {
+      return msg.request_guid;
+    });
+
+  node->_ingestor_state_demux = KeyedDemultiplexer<IngestorState>::make(
+    node->ingestor_state(),
+    [](const IngestorState& msg) -> const std::string& { return msg.guid; });
+
   node->_task_api_response_pub =
     node->create_publisher<ApiResponse>(
     TaskApiResponses, rclcpp::SystemDefaultsQoS().reliable().transient_local());
@@ -129,6 +226,12 @@ auto Node::door_state() const -> const DoorStateObs&
   return _door_state_obs->observe();
 }
 
+//==============================================================================
+auto Node::door_state(const std::string& door_name) const -> DoorStateObs
+{
+  return _door_state_demux->observe(door_name);
+}
+
 //==============================================================================
 auto Node::door_supervisor() const -> const DoorSupervisorObs&
 {
@@ -141,12 +244,24 @@ auto Node::door_request() const -> const DoorRequestPub&
   return _door_request_pub;
 }
 
+//==============================================================================
+auto Node::upcoming_door_sessions() const -> const UpcomingDoorSessionsPub&
+{
+  return _upcoming_door_sessions_pub;
+}
+
 //==============================================================================
 auto Node::lift_state() const -> const LiftStateObs&
 {
   return _lift_state_obs->observe();
 }
 
+//==============================================================================
+auto Node::lift_state(const std::string& lift_name) const -> LiftStateObs
+{
+  return _lift_state_demux->observe(lift_name);
+}
+
 //==============================================================================
 auto Node::lift_request() const -> const LiftRequestPub&
 {
@@ -171,12 +286,26 @@ auto Node::dispenser_result() const -> const DispenserResultObs&
   return _dispenser_result_obs->observe();
 }
 
+//==============================================================================
+auto Node::dispenser_result(const std::string& request_guid) const
+-> DispenserResultObs
+{
+  return _dispenser_result_demux->observe(request_guid);
+}
+
 //==============================================================================
 auto Node::dispenser_state() const -> const DispenserStateObs&
 {
   return _dispenser_state_obs->observe();
 }
 
+//==============================================================================
+auto Node::dispenser_state(const std::string& dispenser) const
+-> DispenserStateObs
+{
+  return _dispenser_state_demux->observe(dispenser);
+}
+
 //==============================================================================
 auto Node::emergency_notice() const -> const EmergencyNoticeObs&
 {
@@ -194,12 +323,26 @@ auto Node::ingestor_result() const -> const IngestorResultObs&
   return _ingestor_result_obs->observe();
 }
 
+//==============================================================================
+auto Node::ingestor_result(const std::string& request_guid) const
+-> IngestorResultObs
+{
+  return _ingestor_result_demux->observe(request_guid);
+}
+
 //==============================================================================
 auto Node::ingestor_state() const -> const IngestorStateObs&
 {
   return _ingestor_state_obs->observe();
 }
 
+//==============================================================================
+auto Node::ingestor_state(const std::string& ingestor) const
+-> IngestorStateObs
+{
+  return _ingestor_state_demux->observe(ingestor);
+}
+
 //==============================================================================
 auto Node::fleet_state() const -> const FleetStatePub&
 {
@@ -218,5 +361,91 @@ auto Node::task_api_response() const -> const ApiResponsePub&
   return _task_api_response_pub;
 }
 
+//==============================================================================
+std::shared_ptr<FleetStateAggregator> Node::traffic_light_fleet_states()
+{
+  std::lock_guard<std::mutex> lock(_fleet_state_aggregator_mutex);
+  if (!_fleet_state_aggregator)
+  {
+    // The aggregator is owned by this node, so it is safe for its timers to
+    // refer back to the node.
+    _fleet_state_aggregator = FleetStateAggregator::make(
+      _fleet_state_pub,
+      [this](std::chrono::nanoseconds period, std::function<void()> callback)
+      {
+        return try_create_wheel_timer(period, std::move(callback));
+      });
+  }
+
+  return _fleet_state_aggregator;
+}
+
+//==============================================================================
+std::shared_ptr<RequestCoalescer> Node::request_coalescer()
+{
+  std::lock_guard<std::mutex> lock(_request_coalescer_mutex);
+  if (!_request_coalescer)
+  {
+    // The coalescer is owned by this node, so it is safe for its timer to
+    // refer back to the node.
+    _request_coalescer = RequestCoalescer::make(
+      _door_request_pub,
+      _lift_request_pub,
+      [this](std::chrono::nanoseconds period, std::function<void()> callback)
+      {
+        return try_create_wheel_timer(period, std::move(callback));
+      });
+
+    const auto w = std::weak_ptr<RequestCoalescer>(_request_coalescer);
+    _coalescer_door_supervisor_sub = door_supervisor()
+      .subscribe([w](const DoorSupervisorState::SharedPtr& heartbeat)
+        {
+          if (const auto coalescer = w.lock())
+            coalescer->update_door_supervisor(heartbeat);
+        });
+
+    _coalescer_lift_state_sub = lift_state()
+      .subscribe([w](const LiftState::SharedPtr& state)
+        {
+          if (const auto coalescer = w.lock())
+            coalescer->update_lift_state(state);
+        });
+  }
+
+  return _request_coalescer;
+}
+
+//==============================================================================
+TimerWheel::TimerPtr Node::try_create_wheel_timer(
+  std::chrono::nanoseconds period,
+  std::function<void()> callback)
+{
+  std::shared_ptr<TimerWheel> wheel;
+  {
+    std::lock_guard<std::mutex> lock(_timer_wheel_mutex);
+    if (!_timer_wheel)
+    {
+      // The wheel is created lazily so that nodes which never need it do not
+      // get woken up by its ticks. See try_create_wall_timer for why we catch
+      // RCL_RET_NOT_INIT.
+      try
+      {
+        _timer_wheel = TimerWheel::make(*this);
+      }
+      catch (const rclcpp::exceptions::RCLError& e)
+      {
+        if (e.ret == RCL_RET_NOT_INIT)
+          return nullptr;
+
+        throw e;
+      }
+    }
+
+    wheel = _timer_wheel;
+  }
+
+  return wheel->create_timer(period, std::move(callback));
+}
+
 } // namespace agv
 } // namespace rmf_fleet_adapter
@@ -18,6 +18,12 @@
 #ifndef SRC__RMF_FLEET_ADAPTER__AGV__NODE_HPP
 #define SRC__RMF_FLEET_ADAPTER__AGV__NODE_HPP
 
+#include "internal_FleetStateAggregator.hpp"
+#include "internal_KeyedDemultiplexer.hpp"
+#include "internal_RequestCoalescer.hpp"
+#include "internal_TimerWheel.hpp"
+
+#include <rmf_rxcpp/RxJobs.hpp>
 #include <rmf_rxcpp/Transport.hpp>
 
 #include <rmf_dispenser_msgs/msg/dispenser_request.hpp>
@@ -60,6 +66,9 @@ public:
   using DoorStateObs = rxcpp::observable<DoorState::SharedPtr>;
   const DoorStateObs& door_state() const;
 
+  /// Get only the states of one door
+  DoorStateObs door_state(const std::string& door_name) const;
+
   using DoorSupervisorState = rmf_door_msgs::msg::SupervisorHeartbeat;
   using DoorSupervisorObs = rxcpp::observable<DoorSupervisorState::SharedPtr>;
   const DoorSupervisorObs& door_supervisor() const;
@@ -68,10 +77,20 @@ public:
   using DoorRequestPub = rclcpp::Publisher<DoorRequest>::SharedPtr;
   const DoorRequestPub& door_request() const;
 
+  /// The door sessions that robots expect to begin soon, given as a heartbeat
+  /// whose sessions have the times that the robots expect to reach each door
+  using UpcomingDoorSessions = rmf_door_msgs::msg::SupervisorHeartbeat;
+  using UpcomingDoorSessionsPub =
+    rclcpp::Publisher<UpcomingDoorSessions>::SharedPtr;
+  const UpcomingDoorSessionsPub& upcoming_door_sessions() const;
+
   using LiftState = rmf_lift_msgs::msg::LiftState;
   using LiftStateObs = rxcpp::observable<LiftState::SharedPtr>;
   const LiftStateObs& lift_state() const;
 
+  /// Get only the states of one lift
+  LiftStateObs lift_state(const std::string& lift_name) const;
+
   using LiftRequest = rmf_lift_msgs::msg::LiftRequest;
   using LiftRequestPub = rclcpp::Publisher<LiftRequest>::SharedPtr;
   const LiftRequestPub& lift_request() const;
@@ -88,10 +107,16 @@ public:
   using DispenserResultObs = rxcpp::observable<DispenserResult::SharedPtr>;
   const DispenserResultObs& dispenser_result() const;
 
+  /// Get only the results for one dispenser request
+  DispenserResultObs dispenser_result(const std::string& request_guid) const;
+
   using DispenserState = rmf_dispenser_msgs::msg::DispenserState;
   using DispenserStateObs = rxcpp::observable<DispenserState::SharedPtr>;
   const DispenserStateObs& dispenser_state() const;
 
+  /// Get only the states of one dispenser
+  DispenserStateObs dispenser_state(const std::string& dispenser) const;
+
   using EmergencyNotice = std_msgs::msg::Bool;
   using EmergencyNoticeObs = rxcpp::observable<EmergencyNotice::SharedPtr>;
   const EmergencyNoticeObs& emergency_notice() const;
@@ -104,14 +129,29 @@ public:
   using IngestorResultObs = rxcpp::observable<IngestorResult::SharedPtr>;
   const IngestorResultObs& ingestor_result() const;
 
+  /// Get only the results for one ingestor request
+  IngestorResultObs ingestor_result(const std::string& request_guid) const;
+
   using IngestorState = rmf_ingestor_msgs::msg::IngestorState;
   using IngestorStateObs = rxcpp::observable<IngestorState::SharedPtr>;
   const IngestorStateObs& ingestor_state() const;
 
+  /// Get only the states of one ingestor
+  IngestorStateObs ingestor_state(const std::string& ingestor) const;
+
   using FleetState = rmf_fleet_msgs::msg::FleetState;
   using FleetStatePub = rclcpp::Publisher<FleetState>::SharedPtr;
   const FleetStatePub& fleet_state() const;
 
+  /// Get the aggregator that combines the fleet states of the traffic light
+  /// robots on this node, so that each fleet is published in one message.
+  std::shared_ptr<FleetStateAggregator> traffic_light_fleet_states();
+
+  /// Get the coalescer that resends the door and lift requests of all the
+  /// robots on this node. Phases should send their door and lift requests
+  /// through this instead of publishing them on a timer of their own.
+  std::shared_ptr<RequestCoalescer> request_coalescer();
+
   using ApiRequest = rmf_task_msgs::msg::ApiRequest;
   using ApiRequestObs = rxcpp::observable<ApiRequest::SharedPtr>;
   const ApiRequestObs& task_api_request() const;
@@ -154,6 +194,16 @@ public:
     }
   }
 
+  /// Create a coarse periodic timer on the timer wheel that this node shares
+  /// between all of its participants. Use this instead of
+  /// try_create_wall_timer for timers that get created once per robot and do
+  /// not need better than 50ms precision, so that large fleets do not load the
+  /// executor with hundreds of timers. Returns a nullptr if the node's context
+  /// has already been shut down.
+  TimerWheel::TimerPtr try_create_wheel_timer(
+    std::chrono::nanoseconds period,
+    std::function<void()> callback);
+
 private:
 
   Node(
@@ -164,6 +214,7 @@ private:
   Bridge<DoorState> _door_state_obs;
   Bridge<DoorSupervisorState> _door_supervisor_obs;
   DoorRequestPub _door_request_pub;
+  UpcomingDoorSessionsPub _upcoming_door_sessions_pub;
   Bridge<LiftState> _lift_state_obs;
   LiftRequestPub _lift_request_pub;
   TaskSummaryPub _task_summary_pub;
@@ -172,10 +223,27 @@ private:
   Bridge<DispenserState> _dispenser_state_obs;
   Bridge<EmergencyNotice> _emergency_notice_obs;
   IngestorRequestPub _ingestor_request_pub;
+  std::mutex _timer_wheel_mutex;
+  std::shared_ptr<TimerWheel> _timer_wheel;
   Bridge<IngestorResult> _ingestor_result_obs;
   Bridge<IngestorState> _ingestor_state_obs;
   FleetStatePub _fleet_state_pub;
+  std::mutex _fleet_state_aggregator_mutex;
+  std::shared_ptr<FleetStateAggregator> _fleet_state_aggregator;
+  std::mutex _request_coalescer_mutex;
+  std::shared_ptr<RequestCoalescer> _request_coalescer;
+  rmf_rxcpp::subscription_guard _coalescer_door_supervisor_sub;
+  rmf_rxcpp::subscription_guard _coalescer_lift_state_sub;
   Bridge<ApiRequest> _task_api_request_obs;
+
+  // Keyed views of the device streams, so each phase only receives the
+  // messages of the device or request that it is waiting on
+  std::shared_ptr<KeyedDemultiplexer<DoorState>> _door_state_demux;
+  std::shared_ptr<KeyedDemultiplexer<LiftState>> _lift_state_demux;
+  std::shared_ptr<KeyedDemultiplexer<DispenserResult>> _dispenser_result_demux;
+  std::shared_ptr<KeyedDemultiplexer<DispenserState>> _dispenser_state_demux;
+  std::shared_ptr<KeyedDemultiplexer<IngestorResult>> _ingestor_result_demux;
+  std::shared_ptr<KeyedDemultiplexer<IngestorState>> _ingestor_state_demux;
   ApiResponsePub _task_api_response_pub;
 };
 
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_PlanCache.hpp"
+#include "../MemoryUsage.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+int64_t round_orientation(const double yaw)
+{
+  // Buckets of about 6 degrees
+  return static_cast<int64_t>(std::lround(yaw * 10.0));
+}
+} // anonymous namespace
+
+//==============================================================================
+std::optional<double> PlanCache::find(
+  const std::shared_ptr<const Planner>& planner,
+  const Planner::StartSet& starts,
+  const Planner::Goal& goal) const
+{
+  const auto key = _key(starts, goal);
+  if (!key.has_value())
+    return std::nullopt;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (planner.get() != _planner)
+    return std::nullopt;
+
+  const auto it = _costs.find(*key);
+  if (it == _costs.end())
+    return std::nullopt;
+
+  return it->second;
+}
+
+//==============================================================================
+void PlanCache::insert(
+  const std::shared_ptr<const Planner>& planner,
+  const Planner::StartSet& starts,
+  const Planner::Goal& goal,
+  const double cost)
+{
+  const auto key = _key(starts, goal);
+  if (!key.has_value())
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (planner.get() != _planner || _costs.size() >= MaxLegs)
+  {
+    _costs.clear();
+    _planner = planner.get();
+  }
+
+  _costs[*key] = cost;
+}
+
+//==============================================================================
+std::vector<std::pair<std::size_t, std::size_t>> PlanCache::legs() const
+{
+  std::vector<std::pair<std::size_t, std::size_t>> output;
+  std::lock_guard<std::mutex> lock(_mutex);
+  output.reserve(_costs.size());
+  for (const auto& [key, _] : _costs)
+  {
+    const std::pair<std::size_t, std::size_t> leg{
+      std::get<0>(key), std::get<2>(key)};
+    if (output.empty() || output.back() != leg)
+      output.push_back(leg);
+  }
+
+  return output;
+}
+
+//==============================================================================
+std::size_t PlanCache::approximate_bytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _costs.size() * (ContainerNodeBytes + sizeof(Key) + sizeof(double));
+}
+
+//==============================================================================
+auto PlanCache::_key(
+  const Planner::StartSet& starts,
+  const Planner::Goal& goal) -> std::optional<Key>
+{
+  // A robot that is between waypoints does not start a leg that repeats
+  if (starts.empty() || starts.front().lane().has_value()
+    || starts.front().location().has_value())
+    return std::nullopt;
+
+  const auto& start = starts.front();
+  const auto* goal_orientation = goal.orientation();
+  return Key{
+    start.waypoint(),
+    round_orientation(start.orientation()),
+    goal.waypoint(),
+    goal_orientation ?
+    round_orientation(*goal_orientation) :
+    std::numeric_limits<int64_t>::max()
+  };
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
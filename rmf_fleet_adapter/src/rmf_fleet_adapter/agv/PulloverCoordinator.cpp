@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_PulloverCoordinator.hpp"
+
+#include <algorithm>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+std::shared_ptr<PulloverCoordinator> PulloverCoordinator::make(
+  const std::size_t max_planning)
+{
+  return std::shared_ptr<PulloverCoordinator>(
+    new PulloverCoordinator(max_planning));
+}
+
+//==============================================================================
+PulloverCoordinator::PulloverCoordinator(const std::size_t max_planning)
+: _max_planning(max_planning)
+{
+  // Do nothing
+}
+
+//==============================================================================
+PulloverCoordinator::Ticket::Ticket(
+  std::weak_ptr<PulloverCoordinator> coordinator,
+  const uint64_t id)
+: _coordinator(std::move(coordinator)),
+  _id(id)
+{
+  // Do nothing
+}
+
+//==============================================================================
+void PulloverCoordinator::Ticket::planning_finished(
+  std::optional<std::size_t> parking_spot)
+{
+  if (const auto coordinator = _coordinator.lock())
+    coordinator->_finish(_id, parking_spot);
+}
+
+//==============================================================================
+PulloverCoordinator::Ticket::~Ticket()
+{
+  if (const auto coordinator = _coordinator.lock())
+    coordinator->_release(_id);
+}
+
+//==============================================================================
+auto PulloverCoordinator::request(
+  const double urgency,
+  std::vector<std::size_t> candidates,
+  Begin begin) -> std::shared_ptr<Ticket>
+{
+  std::vector<std::function<void()>> callbacks;
+  std::shared_ptr<Ticket> ticket;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto id = _next_id++;
+    ticket = std::shared_ptr<Ticket>(new Ticket(weak_from_this(), id));
+
+    // Keep the most urgent robots at the front, and the earliest requests
+    // first among robots that are equally urgent.
+    const auto it = std::find_if(
+      _pending.begin(), _pending.end(),
+      [urgency](const Pending& p) { return p.urgency < urgency; });
+
+    _pending.insert(
+      it, Pending{id, urgency, std::move(candidates), std::move(begin)});
+
+    callbacks = _admit();
+  }
+
+  _run(callbacks);
+  return ticket;
+}
+
+//==============================================================================
+std::vector<std::function<void()>> PulloverCoordinator::_admit()
+{
+  std::vector<std::function<void()>> callbacks;
+  while (!_pending.empty()
+    && (_max_planning == 0 || _planning.size() < _max_planning))
+  {
+    auto next = std::move(_pending.front());
+    _pending.erase(_pending.begin());
+
+    std::vector<std::size_t> parking_spots;
+    for (const auto spot : next.candidates)
+    {
+      if (_claimed.insert({spot, next.id}).second)
+        parking_spots.push_back(spot);
+    }
+
+    // When every candidate has been claimed already, the robot falls back to
+    // trying every parking spot rather than waiting for one to free up.
+    _planning.push_back(next.id);
+    callbacks.push_back(
+      [begin = std::move(next.begin), spots = std::move(parking_spots)]()
+      {
+        begin(spots);
+      });
+  }
+
+  return callbacks;
+}
+
+//==============================================================================
+void PulloverCoordinator::_finish(
+  const uint64_t id,
+  const std::optional<std::size_t> parking_spot)
+{
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = std::find(_planning.begin(), _planning.end(), id);
+    if (it == _planning.end())
+      return;
+
+    _planning.erase(it);
+    _unclaim(id);
+    if (parking_spot.has_value())
+      _claimed.insert({*parking_spot, id});
+
+    callbacks = _admit();
+  }
+
+  _run(callbacks);
+}
+
+//==============================================================================
+void PulloverCoordinator::_release(const uint64_t id)
+{
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending.erase(
+      std::remove_if(
+        _pending.begin(), _pending.end(),
+        [id](const Pending& p) { return p.id == id; }),
+      _pending.end());
+
+    _planning.erase(
+      std::remove(_planning.begin(), _planning.end(), id),
+      _planning.end());
+
+    _unclaim(id);
+    callbacks = _admit();
+  }
+
+  _run(callbacks);
+}
+
+//==============================================================================
+void PulloverCoordinator::_unclaim(const uint64_t id)
+{
+  for (auto it = _claimed.begin(); it != _claimed.end(); )
+  {
+    if (it->second == id)
+      it = _claimed.erase(it);
+    else
+      ++it;
+  }
+}
+
+//==============================================================================
+void PulloverCoordinator::_run(
+  const std::vector<std::function<void()>>& callbacks)
+{
+  for (const auto& callback : callbacks)
+    callback();
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
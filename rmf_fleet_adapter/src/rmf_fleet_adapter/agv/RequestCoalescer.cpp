@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_RequestCoalescer.hpp"
+
+#include "../phases/SupervisorHasSession.hpp"
+
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+// Acknowledged requests are resent once every this many periods
+const uint64_t AcknowledgedResendTicks = 5;
+} // anonymous namespace
+
+//==============================================================================
+std::shared_ptr<RequestCoalescer> RequestCoalescer::make(
+  DoorRequestPub door_request_pub,
+  LiftRequestPub lift_request_pub,
+  MakeTimer make_timer,
+  const std::chrono::nanoseconds period)
+{
+  auto coalescer = std::shared_ptr<RequestCoalescer>(
+    new RequestCoalescer(
+      std::move(door_request_pub), std::move(lift_request_pub)));
+
+  coalescer->_timer = make_timer(
+    period,
+    [w = coalescer->weak_from_this()]()
+    {
+      if (const auto self = w.lock())
+        self->_resend();
+    });
+
+  return coalescer;
+}
+
+//==============================================================================
+auto RequestCoalescer::request_door(DoorRequest request) -> RegistrationPtr
+{
+  _door_request_pub->publish(request);
+
+  Key key{request.door_name, request.requester_id};
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto id = _next_id++;
+  _doors.insert_or_assign(key, Entry<DoorRequest>{std::move(request), id});
+
+  return RegistrationPtr(new Registration(
+      [w = weak_from_this(), key = std::move(key), id]()
+      {
+        if (const auto self = w.lock())
+          self->_remove_door(key, id);
+      }));
+}
+
+//==============================================================================
+auto RequestCoalescer::request_lift(LiftRequest request) -> RegistrationPtr
+{
+  _lift_request_pub->publish(request);
+
+  Key key{request.lift_name, request.session_id};
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto id = _next_id++;
+  _lifts.insert_or_assign(key, Entry<LiftRequest>{std::move(request), id});
+
+  return RegistrationPtr(new Registration(
+      [w = weak_from_this(), key = std::move(key), id]()
+      {
+        if (const auto self = w.lock())
+          self->_remove_lift(key, id);
+      }));
+}
+
+//==============================================================================
+void RequestCoalescer::update_door_supervisor(
+  std::shared_ptr<const DoorSupervisorState> heartbeat)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _door_supervisor = std::move(heartbeat);
+}
+
+//==============================================================================
+void RequestCoalescer::update_lift_state(std::shared_ptr<const LiftState> state)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& latest = _lift_states[state->lift_name];
+  latest = std::move(state);
+}
+
+//==============================================================================
+RequestCoalescer::RequestCoalescer(
+  DoorRequestPub door_request_pub,
+  LiftRequestPub lift_request_pub)
+: _door_request_pub(std::move(door_request_pub)),
+  _lift_request_pub(std::move(lift_request_pub))
+{
+  // Do nothing
+}
+
+//==============================================================================
+void RequestCoalescer::_remove_door(const Key& key, const uint64_t id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _doors.find(key);
+  if (it != _doors.end() && it->second.id == id)
+    _doors.erase(it);
+}
+
+//==============================================================================
+void RequestCoalescer::_remove_lift(const Key& key, const uint64_t id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _lifts.find(key);
+  if (it != _lifts.end() && it->second.id == id)
+    _lifts.erase(it);
+}
+
+//==============================================================================
+void RequestCoalescer::_resend()
+{
+  std::vector<DoorRequest> door_requests;
+  std::vector<LiftRequest> lift_requests;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const bool resend_all = (++_tick % AcknowledgedResendTicks) == 0;
+    for (const auto& [_, entry] : _doors)
+    {
+      if (resend_all || !_is_acknowledged(entry.request))
+        door_requests.push_back(entry.request);
+    }
+
+    for (const auto& [_, entry] : _lifts)
+    {
+      if (resend_all || !_is_acknowledged(entry.request))
+        lift_requests.push_back(entry.request);
+    }
+  }
+
+  // The request times are left as they were first sent, so the supervisors
+  // can tell that these are repeats.
+  for (const auto& request : door_requests)
+    _door_request_pub->publish(request);
+
+  for (const auto& request : lift_requests)
+    _lift_request_pub->publish(request);
+}
+
+//==============================================================================
+bool RequestCoalescer::_is_acknowledged(const DoorRequest& request) const
+{
+  if (!_door_supervisor)
+    return false;
+
+  const bool has_session = phases::supervisor_has_session(
+    *_door_supervisor, request.requester_id, request.door_name);
+
+  if (request.requested_mode.value == rmf_door_msgs::msg::DoorMode::MODE_OPEN)
+    return has_session;
+
+  return !has_session;
+}
+
+//==============================================================================
+bool RequestCoalescer::_is_acknowledged(const LiftRequest& request) const
+{
+  const auto it = _lift_states.find(request.lift_name);
+  if (it == _lift_states.end())
+    return false;
+
+  const auto& state = *it->second;
+  if (request.request_type == LiftRequest::REQUEST_END_SESSION)
+    return state.session_id != request.session_id;
+
+  return state.session_id == request.session_id
+    && state.destination_floor == request.destination_floor;
+}
+
+//==============================================================================
+RequestCoalescer::Registration::~Registration()
+{
+  _remove();
+}
+
+//==============================================================================
+RequestCoalescer::Registration::Registration(std::function<void()> remove)
+: _remove(std::move(remove))
+{
+  // Do nothing
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
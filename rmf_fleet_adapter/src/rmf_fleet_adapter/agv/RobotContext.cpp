@@ -23,6 +23,9 @@
 
 #include <rmf_fleet_msgs/msg/robot_mode.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace rmf_fleet_adapter {
 namespace agv {
 
@@ -41,6 +44,7 @@ std::shared_ptr<RobotUpdateHandle> RobotContext::make_updater()
 //==============================================================================
 Eigen::Vector3d RobotContext::position() const
 {
+  std::lock_guard<std::mutex> lock(_location_mutex);
   assert(!_location.empty());
   const auto& l = _location.front();
   if (l.location().has_value())
@@ -57,6 +61,7 @@ Eigen::Vector3d RobotContext::position() const
 //==============================================================================
 const std::string& RobotContext::map() const
 {
+  std::lock_guard<std::mutex> lock(_location_mutex);
   assert(!_location.empty());
   return navigation_graph()
     .get_waypoint(_location.front().waypoint()).get_map_name();
@@ -75,11 +80,20 @@ std::function<rmf_traffic::Time()> RobotContext::clock() const
 }
 
 //==============================================================================
-const std::vector<rmf_traffic::agv::Plan::Start>& RobotContext::location() const
+std::vector<rmf_traffic::agv::Plan::Start> RobotContext::location() const
 {
+  std::lock_guard<std::mutex> lock(_location_mutex);
   return _location;
 }
 
+//==============================================================================
+void RobotContext::_set_location(
+  std::vector<rmf_traffic::agv::Plan::Start> location)
+{
+  std::lock_guard<std::mutex> lock(_location_mutex);
+  _location = std::move(location);
+}
+
 //==============================================================================
 rmf_traffic::schedule::Participant& RobotContext::itinerary()
 {
@@ -272,7 +286,7 @@ std::function<rmf_task::State()> RobotContext::make_get_state()
     {
       rmf_task::State state;
       state.load_basic(
-        self->_location.front(),
+        self->location().front(),
         self->_charger_wp,
         self->_current_battery_soc);
 
@@ -307,6 +321,26 @@ double RobotContext::current_battery_soc() const
 RobotContext& RobotContext::current_battery_soc(const double battery_soc)
 {
   _current_battery_soc = battery_soc;
+
+  if (_notified_battery_soc.has_value())
+  {
+    const double change = battery_soc - *_notified_battery_soc;
+    double required = _battery_soc_change_threshold;
+    if (change * _battery_soc_direction < 0.0)
+      required += _battery_soc_hysteresis;
+
+    const bool limit = battery_soc <= 0.0 || 1.0 <= battery_soc;
+    if (std::abs(change) < required && !(limit && change != 0.0))
+    {
+      ++_suppressed_battery_soc_updates;
+      return *this;
+    }
+
+    if (change != 0.0)
+      _battery_soc_direction = change < 0.0 ? -1.0 : 1.0;
+  }
+
+  _notified_battery_soc = battery_soc;
   _battery_soc_publisher.get_subscriber().on_next(battery_soc);
 
   return *this;
@@ -318,12 +352,58 @@ std::size_t RobotContext::dedicated_charger_wp() const
   return _charger_wp;
 }
 
+//==============================================================================
+RobotContext& RobotContext::dedicated_charger_wp(const std::size_t charger_wp)
+{
+  _charger_wp = charger_wp;
+  _current_task_end_state.dedicated_charging_waypoint(charger_wp);
+  return *this;
+}
+
+//==============================================================================
+const std::shared_ptr<ChargerScheduler>&
+RobotContext::charger_scheduler() const
+{
+  return _charger_scheduler;
+}
+
+//==============================================================================
+RobotContext& RobotContext::charger_scheduler(
+  std::shared_ptr<ChargerScheduler> scheduler)
+{
+  _charger_scheduler = std::move(scheduler);
+  return *this;
+}
+
+//==============================================================================
+const std::shared_ptr<const TravelTimeTable>&
+RobotContext::travel_time_table() const
+{
+  return _travel_time_table;
+}
+
 //==============================================================================
 const rxcpp::observable<double>& RobotContext::observe_battery_soc() const
 {
   return _battery_soc_obs;
 }
 
+//==============================================================================
+RobotContext& RobotContext::battery_soc_filter(
+  const double change_threshold,
+  const double hysteresis)
+{
+  _battery_soc_change_threshold = std::max(0.0, change_threshold);
+  _battery_soc_hysteresis = std::max(0.0, hysteresis);
+  return *this;
+}
+
+//==============================================================================
+std::size_t RobotContext::suppressed_battery_soc_updates() const
+{
+  return _suppressed_battery_soc_updates;
+}
+
 //==============================================================================
 const std::shared_ptr<const rmf_task::TaskPlanner>&
 RobotContext::task_planner() const
@@ -340,6 +420,208 @@ auto RobotContext::task_planner(
   return *this;
 }
 
+//==============================================================================
+const std::shared_ptr<const LaneIndex>& RobotContext::lane_index() const
+{
+  return _lane_index;
+}
+
+//==============================================================================
+RobotContext& RobotContext::lane_index(std::shared_ptr<const LaneIndex> index)
+{
+  _lane_index = std::move(index);
+  return *this;
+}
+
+//==============================================================================
+const std::shared_ptr<const LevelPortals>& RobotContext::level_portals() const
+{
+  return _level_portals;
+}
+
+//==============================================================================
+RobotContext& RobotContext::level_portals(
+  std::shared_ptr<const LevelPortals> portals)
+{
+  _level_portals = std::move(portals);
+  return *this;
+}
+
+//==============================================================================
+std::vector<std::size_t> RobotContext::pullover_candidates(
+  const rmf_traffic::agv::Plan::StartSet& starts) const
+{
+  if (!_travel_time_table || _pullover_candidate_count == 0)
+    return {};
+
+  if (_parking_spots.size() <= _pullover_candidate_count)
+    return {};
+
+  std::vector<TravelTimeTable::Nearest> nearest;
+  for (const auto& start : starts)
+  {
+    const auto n = _travel_time_table->nearest(
+      start, _parking_spots, _pullover_candidate_count);
+    nearest.insert(nearest.end(), n.begin(), n.end());
+  }
+
+  std::sort(nearest.begin(), nearest.end(),
+    [](const auto& a, const auto& b) { return a.time < b.time; });
+
+  std::vector<std::size_t> candidates;
+  for (const auto& n : nearest)
+  {
+    if (std::find(candidates.begin(), candidates.end(), n.waypoint)
+      == candidates.end())
+    {
+      candidates.push_back(n.waypoint);
+    }
+  }
+
+  return candidates;
+}
+
+//==============================================================================
+RobotContext& RobotContext::pullover_candidates(
+  std::shared_ptr<const TravelTimeTable> table,
+  std::vector<std::size_t> parking_spots,
+  const std::size_t count)
+{
+  _travel_time_table = std::move(table);
+  _parking_spots = std::move(parking_spots);
+  _pullover_candidate_count = count;
+  return *this;
+}
+
+//==============================================================================
+PlanCache& RobotContext::plan_cache() const
+{
+  return _plan_cache;
+}
+
+//==============================================================================
+MemoryUsage RobotContext::memory_usage() const
+{
+  MemoryUsage usage;
+  std::size_t itinerary = 0;
+  for (const auto& route : _itinerary.itinerary())
+    itinerary += approximate_bytes(route);
+
+  usage["itinerary"] = itinerary;
+  {
+    std::lock_guard<std::mutex> lock(_location_mutex);
+    usage["location"] = approximate_bytes(_location);
+  }
+
+  usage["plan_cache"] = _plan_cache.approximate_bytes();
+  usage["parking_spots"] = approximate_bytes(_parking_spots);
+  return usage;
+}
+
+//==============================================================================
+const std::shared_ptr<PulloverCoordinator>&
+RobotContext::pullover_coordinator() const
+{
+  return _pullover_coordinator;
+}
+
+//==============================================================================
+RobotContext& RobotContext::pullover_coordinator(
+  std::shared_ptr<PulloverCoordinator> coordinator)
+{
+  _pullover_coordinator = std::move(coordinator);
+  return *this;
+}
+
+//==============================================================================
+const std::shared_ptr<LiftSessionSharing>&
+RobotContext::lift_session_sharing() const
+{
+  return _lift_session_sharing;
+}
+
+//==============================================================================
+RobotContext& RobotContext::lift_session_sharing(
+  std::shared_ptr<LiftSessionSharing> sharing)
+{
+  _lift_session_sharing = std::move(sharing);
+  return *this;
+}
+
+//==============================================================================
+std::string RobotContext::lift_session(const std::string& lift_name) const
+{
+  if (!_lift_session_sharing)
+    return _requester_id;
+
+  return _lift_session_sharing->session(lift_name, _requester_id);
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration> RobotContext::idle_wait_horizon() const
+{
+  return _idle_wait_horizon;
+}
+
+//==============================================================================
+RobotContext& RobotContext::idle_wait_horizon(
+  std::optional<rmf_traffic::Duration> horizon)
+{
+  _idle_wait_horizon = horizon;
+  return *this;
+}
+
+//==============================================================================
+std::vector<rmf_traffic::agv::Plan::Start> RobotContext::compute_plan_starts(
+  const std::string& map_name,
+  const Eigen::Vector3d& position,
+  const rmf_traffic::Time start_time,
+  const double max_merge_waypoint_distance,
+  const double max_merge_lane_distance,
+  const double min_lane_length) const
+{
+  if (_lane_index)
+  {
+    return _lane_index->compute_plan_starts(
+      map_name, position, start_time, max_merge_waypoint_distance,
+      max_merge_lane_distance, min_lane_length);
+  }
+
+  return rmf_traffic::agv::compute_plan_starts(
+    navigation_graph(), map_name, position, start_time,
+    max_merge_waypoint_distance, max_merge_lane_distance, min_lane_length);
+}
+
+//==============================================================================
+std::shared_ptr<rmf_task::TravelEstimator>
+RobotContext::travel_estimator() const
+{
+  return _travel_estimator;
+}
+
+//==============================================================================
+auto RobotContext::travel_estimator(
+  std::shared_ptr<rmf_task::TravelEstimator> estimator)
+-> RobotContext&
+{
+  _travel_estimator = std::move(estimator);
+  return *this;
+}
+
+//==============================================================================
+std::shared_ptr<const EnergyTable> RobotContext::energy_table() const
+{
+  return _energy_table;
+}
+
+//==============================================================================
+RobotContext& RobotContext::energy_table(
+  std::shared_ptr<const EnergyTable> table)
+{
+  _energy_table = std::move(table);
+  return *this;
+}
+
 //==============================================================================
 void RobotContext::set_lift_entry_watchdog(
   RobotUpdateHandle::Unstable::Watchdog watchdog,
@@ -366,6 +648,29 @@ rmf_traffic::Duration RobotContext::get_lift_rewait_duration() const
 void RobotContext::respond(
   const TableViewerPtr& table_viewer,
   const ResponderPtr& responder)
+{
+  // Negotiations may be handled on a different worker than this robot. The
+  // negotiator and the phase that it belongs to may only be touched from the
+  // worker of this robot, so the response is made over there.
+  _worker.schedule(
+    [w = weak_from_this(), table_viewer, responder](const auto&)
+    {
+      const auto self = w.lock();
+      if (!self)
+      {
+        // Make sure that the negotiation does not hang on a robot that is gone
+        responder->forfeit({});
+        return;
+      }
+
+      self->_respond(table_viewer, responder);
+    });
+}
+
+//==============================================================================
+void RobotContext::_respond(
+  const TableViewerPtr& table_viewer,
+  const ResponderPtr& responder)
 {
   if (_negotiator)
     return _negotiator->respond(table_viewer, responder);
@@ -21,7 +21,18 @@
 
 #include <rxcpp/rx-observable.hpp>
 
+#include <mutex>
+
 #include "Node.hpp"
+#include "internal_ChargerScheduler.hpp"
+#include "internal_EnergyTable.hpp"
+#include "internal_LaneIndex.hpp"
+#include "internal_LevelPortals.hpp"
+#include "internal_LiftSessionSharing.hpp"
+#include "internal_PlanCache.hpp"
+#include "internal_PulloverCoordinator.hpp"
+#include "internal_TravelTimeTable.hpp"
+#include "../MemoryUsage.hpp"
 
 namespace rmf_fleet_adapter {
 namespace agv {
@@ -54,8 +65,9 @@ public:
   std::function<rmf_traffic::Time()> clock() const;
 
   /// This is the current "location" of the robot, which can be used to initiate
-  /// a planning job
-  const std::vector<rmf_traffic::agv::Plan::Start>& location() const;
+  /// a planning job. This is a copy because the location may be updated by the
+  /// worker of this robot while the fleet is reading it.
+  std::vector<rmf_traffic::agv::Plan::Start> location() const;
 
   /// Get a mutable reference to the schedule of this robot
   rmf_traffic::schedule::Participant& itinerary();
@@ -162,9 +174,33 @@ public:
 
   std::size_t dedicated_charger_wp() const;
 
+  /// Change the dedicated charger of the robot. The charger of the current
+  /// task end state is changed too, so later task planning uses it.
+  RobotContext& dedicated_charger_wp(std::size_t charger_wp);
+
+  /// Get the scheduler for the chargers of the fleet
+  const std::shared_ptr<ChargerScheduler>& charger_scheduler() const;
+
+  /// Set the scheduler for the chargers of the fleet
+  RobotContext& charger_scheduler(std::shared_ptr<ChargerScheduler> scheduler);
+
+  /// Get the travel time table of the fleet, if it has one
+  const std::shared_ptr<const TravelTimeTable>& travel_time_table() const;
+
   // Get a reference to the battery soc observer of this robot.
   const rxcpp::observable<double>& observe_battery_soc() const;
 
+  /// Only notify the battery soc observers once the battery level has changed
+  /// by at least change_threshold since they were last notified. When the
+  /// level turns around, e.g. because the robot begins charging, it needs to
+  /// change by the hysteresis on top of that. Readings that reach an empty or
+  /// full battery are always passed along. The current_battery_soc() getter
+  /// always gives the latest reading.
+  RobotContext& battery_soc_filter(double change_threshold, double hysteresis);
+
+  /// How many battery soc readings were held back from the observers
+  std::size_t suppressed_battery_soc_updates() const;
+
   /// Get a mutable reference to the task planner for this robot
   const std::shared_ptr<const rmf_task::TaskPlanner>& task_planner() const;
 
@@ -172,6 +208,93 @@ public:
   RobotContext& task_planner(
     const std::shared_ptr<const rmf_task::TaskPlanner> task_planner);
 
+  /// Get the spatial index of the navigation graph, if the fleet has one
+  const std::shared_ptr<const LaneIndex>& lane_index() const;
+
+  /// Set the spatial index of the navigation graph for this robot
+  RobotContext& lane_index(std::shared_ptr<const LaneIndex> index);
+
+  /// Get the portals of each level, if trips between levels should be
+  /// planned one level at a time
+  const std::shared_ptr<const LevelPortals>& level_portals() const;
+
+  /// Set the portals of each level for this robot
+  RobotContext& level_portals(std::shared_ptr<const LevelPortals> portals);
+
+  /// Get the parking spots that an emergency pullover should be planned
+  /// towards, nearest first. This is empty when the search is not limited, in
+  /// which case every parking spot should be tried.
+  std::vector<std::size_t> pullover_candidates(
+    const rmf_traffic::agv::Plan::StartSet& starts) const;
+
+  /// Set how pullover_candidates finds the parking spots nearest to the robot
+  RobotContext& pullover_candidates(
+    std::shared_ptr<const TravelTimeTable> table,
+    std::vector<std::size_t> parking_spots,
+    std::size_t count);
+
+  /// Get the costs of the legs that this robot has already found plans for
+  PlanCache& plan_cache() const;
+
+  /// Approximate how much memory this robot is holding on to for its
+  /// itinerary, location and plan cache. This must be called on the worker of
+  /// this robot.
+  MemoryUsage memory_usage() const;
+
+  /// Get the coordinator that this robot shares with the rest of its fleet
+  /// for planning emergency pullovers, if there is one
+  const std::shared_ptr<PulloverCoordinator>& pullover_coordinator() const;
+
+  /// Set the coordinator for planning emergency pullovers
+  RobotContext& pullover_coordinator(
+    std::shared_ptr<PulloverCoordinator> coordinator);
+
+  /// Get the sharing of lift rides among the robots of this fleet, if robots
+  /// may share a ride
+  const std::shared_ptr<LiftSessionSharing>& lift_session_sharing() const;
+
+  /// Set the sharing of lift rides for this robot
+  RobotContext& lift_session_sharing(
+    std::shared_ptr<LiftSessionSharing> sharing);
+
+  /// Get the session that this robot uses with a lift. This is the requester
+  /// ID unless the robot shares a ride with other robots.
+  std::string lift_session(const std::string& lift_name) const;
+
+  /// Get how far ahead an idle robot should schedule itself to stay where it
+  /// is. When this is nullopt, an idle robot keeps re-planning its wait.
+  std::optional<rmf_traffic::Duration> idle_wait_horizon() const;
+
+  /// Set how far ahead an idle robot should schedule itself to stay
+  RobotContext& idle_wait_horizon(
+    std::optional<rmf_traffic::Duration> horizon);
+
+  /// Find where this robot could start planning from when it is at the given
+  /// position. The lane index is used when it is available, otherwise this
+  /// falls back to rmf_traffic::agv::compute_plan_starts.
+  std::vector<rmf_traffic::agv::Plan::Start> compute_plan_starts(
+    const std::string& map_name,
+    const Eigen::Vector3d& position,
+    rmf_traffic::Time start_time,
+    double max_merge_waypoint_distance = 0.1,
+    double max_merge_lane_distance = 1.0,
+    double min_lane_length = 1e-8) const;
+
+  /// Get the travel estimator that this robot shares with the rest of its
+  /// fleet. This will be a nullptr until the fleet has task planner params.
+  std::shared_ptr<rmf_task::TravelEstimator> travel_estimator() const;
+
+  /// Set the travel estimator for this robot
+  RobotContext& travel_estimator(
+    std::shared_ptr<rmf_task::TravelEstimator> estimator);
+
+  /// Get the battery drain table that this robot shares with the rest of its
+  /// fleet. This will be a nullptr until the fleet has task planner params.
+  std::shared_ptr<const EnergyTable> energy_table() const;
+
+  /// Set the battery drain table for this robot
+  RobotContext& energy_table(std::shared_ptr<const EnergyTable> table);
+
   void set_lift_entry_watchdog(
     RobotUpdateHandle::Unstable::Watchdog watchdog,
     rmf_traffic::Duration wait_duration);
@@ -213,8 +336,18 @@ private:
     rmf_task::State state,
     std::shared_ptr<const rmf_task::TaskPlanner> task_planner);
 
+  /// Replace the current location of the robot
+  void _set_location(std::vector<rmf_traffic::agv::Plan::Start> location);
+
+  /// Respond to a negotiation. This must be called on the worker of this
+  /// robot.
+  void _respond(
+    const TableViewerPtr& table_viewer,
+    const ResponderPtr& responder);
+
   std::weak_ptr<RobotCommandHandle> _command_handle;
   std::vector<rmf_traffic::agv::Plan::Start> _location;
+  mutable std::mutex _location_mutex;
   rmf_traffic::schedule::Participant _itinerary;
   std::shared_ptr<const Snappable> _schedule;
   std::shared_ptr<std::shared_ptr<const rmf_traffic::agv::Planner>> _planner;
@@ -240,9 +373,26 @@ private:
   std::size_t _charger_wp;
   rxcpp::subjects::subject<double> _battery_soc_publisher;
   rxcpp::observable<double> _battery_soc_obs;
+  double _battery_soc_change_threshold = 0.0;
+  double _battery_soc_hysteresis = 0.0;
+  std::optional<double> _notified_battery_soc;
+  double _battery_soc_direction = 0.0;
+  std::size_t _suppressed_battery_soc_updates = 0;
   rmf_task::State _current_task_end_state;
   std::optional<std::string> _current_task_id;
   std::shared_ptr<const rmf_task::TaskPlanner> _task_planner;
+  std::shared_ptr<const LaneIndex> _lane_index;
+  std::shared_ptr<const LevelPortals> _level_portals;
+  std::shared_ptr<const TravelTimeTable> _travel_time_table;
+  std::vector<std::size_t> _parking_spots;
+  std::size_t _pullover_candidate_count = 0;
+  std::shared_ptr<PulloverCoordinator> _pullover_coordinator;
+  std::shared_ptr<LiftSessionSharing> _lift_session_sharing;
+  std::shared_ptr<ChargerScheduler> _charger_scheduler;
+  mutable PlanCache _plan_cache;
+  std::optional<rmf_traffic::Duration> _idle_wait_horizon;
+  std::shared_ptr<rmf_task::TravelEstimator> _travel_estimator;
+  std::shared_ptr<const EnergyTable> _energy_table;
 
   RobotUpdateHandle::Unstable::Watchdog _lift_watchdog;
   rmf_traffic::Duration _lift_rewait_duration = std::chrono::seconds(0);
@@ -67,11 +67,11 @@ void RobotUpdateHandle::update_position(
     context->worker().schedule(
       [context, waypoint, orientation](const auto&)
       {
-        context->_location = {
+        context->_set_location({
           rmf_traffic::agv::Plan::Start(
             rmf_traffic_ros2::convert(context->node()->now()),
             waypoint, orientation)
-        };
+        });
       });
   }
 }
@@ -107,7 +107,7 @@ void RobotUpdateHandle::update_position(
     context->worker().schedule(
       [context, starts = std::move(starts)](const auto&)
       {
-        context->_location = std::move(starts);
+        context->_set_location(std::move(starts));
       });
   }
 }
@@ -122,11 +122,11 @@ void RobotUpdateHandle::update_position(
     context->worker().schedule(
       [context, position, waypoint](const auto&)
       {
-        context->_location = {
+        context->_set_location({
           rmf_traffic::agv::Plan::Start(
             rmf_traffic_ros2::convert(context->node()->now()),
             waypoint, position[2], Eigen::Vector2d(position.block<2, 1>(0, 0)))
-        };
+        });
       });
   }
 }
@@ -142,8 +142,8 @@ void RobotUpdateHandle::update_position(
   if (const auto context = _pimpl->get_context())
   {
     const auto now = rmf_traffic_ros2::convert(context->node()->now());
-    auto starts = rmf_traffic::agv::compute_plan_starts(
-      context->navigation_graph(), map_name, position, now,
+    auto starts = context->compute_plan_starts(
+      map_name, position, now,
       max_merge_waypoint_distance, max_merge_lane_distance,
       min_lane_length);
 
@@ -161,7 +161,7 @@ void RobotUpdateHandle::update_position(
     context->worker().schedule(
       [context, starts = std::move(starts)](const auto&)
       {
-        context->_location = std::move(starts);
+        context->_set_location(std::move(starts));
       });
   }
 }
@@ -172,9 +172,10 @@ RobotUpdateHandle& RobotUpdateHandle::set_charger_waypoint(
 {
   if (const auto context = _pimpl->get_context())
   {
-    auto end_state = context->current_task_end_state();
-    end_state.dedicated_charging_waypoint(charger_wp);
-    context->current_task_end_state(end_state);
+    context->dedicated_charger_wp(charger_wp);
+    if (const auto& scheduler = context->charger_scheduler())
+      scheduler->assign(context->name(), charger_wp);
+
     RCLCPP_INFO(
       context->node()->get_logger(),
       "Charger waypoint for robot [%s] set to index [%ld]",
@@ -201,6 +202,23 @@ void RobotUpdateHandle::update_battery_soc(const double battery_soc)
   }
 }
 
+//==============================================================================
+RobotUpdateHandle& RobotUpdateHandle::set_battery_soc_filter(
+  const double change_threshold,
+  const double hysteresis)
+{
+  if (const auto context = _pimpl->get_context())
+  {
+    context->worker().schedule(
+      [context, change_threshold, hysteresis](const auto&)
+      {
+        context->battery_soc_filter(change_threshold, hysteresis);
+      });
+  }
+
+  return *this;
+}
+
 //==============================================================================
 void RobotUpdateHandle::set_action_executor(
   RobotUpdateHandle::ActionExecutor action_executor)
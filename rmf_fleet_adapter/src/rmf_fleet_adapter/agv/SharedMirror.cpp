@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_SharedMirror.hpp"
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+std::mutex shared_mirror_mutex;
+std::weak_ptr<SharedMirror> shared_mirror;
+} // anonymous namespace
+
+//==============================================================================
+std::shared_ptr<SharedMirror> SharedMirror::get(
+  rclcpp::Context::SharedPtr context)
+{
+  std::lock_guard<std::mutex> lock(shared_mirror_mutex);
+  if (auto mirror = shared_mirror.lock())
+    return mirror;
+
+  auto mirror = std::shared_ptr<SharedMirror>(
+    new SharedMirror(std::move(context)));
+  shared_mirror = mirror;
+  return mirror;
+}
+
+//==============================================================================
+bool SharedMirror::ready()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_manager.has_value())
+    return true;
+
+  using namespace std::chrono_literals;
+  if (_future->wait_for(0s) != std::future_status::ready)
+    return false;
+
+  _manager.emplace(_future->get());
+  _future.reset();
+  return true;
+}
+
+//==============================================================================
+auto SharedMirror::manager()
+-> std::shared_ptr<rmf_traffic_ros2::schedule::MirrorManager>
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_manager.has_value())
+  {
+    // *INDENT-OFF*
+    throw std::runtime_error(
+      "[rmf_fleet_adapter::agv::SharedMirror::manager] The shared mirror is "
+      "not ready yet. This is a critical bug in rmf_fleet_adapter. Please "
+      "report it to the maintainers.");
+    // *INDENT-ON*
+  }
+
+  return std::shared_ptr<rmf_traffic_ros2::schedule::MirrorManager>(
+    shared_from_this(), &*_manager);
+}
+
+//==============================================================================
+SharedMirror::~SharedMirror()
+{
+  _executor->cancel();
+  if (_spin_thread.joinable())
+    _spin_thread.join();
+}
+
+//==============================================================================
+SharedMirror::SharedMirror(rclcpp::Context::SharedPtr context)
+{
+  _node = std::make_shared<rclcpp::Node>(
+    "rmf_shared_schedule_mirror",
+    rclcpp::NodeOptions().context(context).start_parameter_services(false));
+
+  // Planning jobs take snapshots of the mirror far more often than the
+  // schedule changes, so let them grab prebuilt snapshots instead of
+  // competing with the mirror updates.
+  _future = rmf_traffic_ros2::schedule::make_mirror(
+    _node, rmf_traffic::schedule::query_all(),
+    rmf_traffic_ros2::schedule::MirrorManager::Options()
+    .prebuilt_snapshots(true));
+
+  rclcpp::ExecutorOptions options;
+  options.context = context;
+  _executor =
+    std::make_unique<rclcpp::executors::SingleThreadedExecutor>(options);
+  _executor->add_node(_node);
+  _spin_thread = std::thread([executor = _executor.get()]()
+      {
+        executor->spin();
+      });
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_TimerWheel.hpp"
+
+#include <algorithm>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+auto TimerWheel::make(
+  rclcpp::Node& node,
+  const std::chrono::nanoseconds tick_period) -> std::shared_ptr<TimerWheel>
+{
+  auto wheel = std::shared_ptr<TimerWheel>(new TimerWheel(tick_period));
+  wheel->_driver = node.create_wall_timer(
+    tick_period,
+    [w = wheel->weak_from_this()]()
+    {
+      if (const auto self = w.lock())
+        self->_tick();
+    });
+
+  return wheel;
+}
+
+//==============================================================================
+auto TimerWheel::create_timer(
+  const std::chrono::nanoseconds period,
+  std::function<void()> callback) -> TimerPtr
+{
+  auto entry = std::make_shared<Entry>();
+  entry->period_ticks = std::max<uint64_t>(
+    1, static_cast<uint64_t>(
+      (period + _tick_period/2) / _tick_period));
+  entry->callback = std::move(callback);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    entry->due_tick = _current_tick + entry->period_ticks;
+    _insert(entry);
+    ++_size;
+  }
+
+  return TimerPtr(new Timer(weak_from_this(), std::move(entry)));
+}
+
+//==============================================================================
+std::size_t TimerWheel::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _size;
+}
+
+//==============================================================================
+TimerWheel::TimerWheel(const std::chrono::nanoseconds tick_period)
+: _tick_period(tick_period)
+{
+  // Do nothing
+}
+
+//==============================================================================
+void TimerWheel::_tick()
+{
+  std::vector<EntryPtr> triggered;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_current_tick;
+
+    // Whenever a level wraps around, the next slot of the level above it gets
+    // spread out across the levels below.
+    for (std::size_t level = 1; level < NumLevels; ++level)
+    {
+      const uint64_t mask = (uint64_t(1) << (SlotBits*level)) - 1;
+      if ((_current_tick & mask) != 0)
+        break;
+
+      _cascade(level);
+    }
+
+    auto& slot = _levels[0][_current_tick & (NumSlots - 1)];
+    std::vector<EntryPtr> entries;
+    entries.swap(slot);
+    for (auto& entry : entries)
+    {
+      if (entry->cancelled)
+      {
+        --_size;
+        continue;
+      }
+
+      if (entry->due_tick > _current_tick)
+      {
+        _insert(std::move(entry));
+        continue;
+      }
+
+      triggered.push_back(std::move(entry));
+    }
+  }
+
+  for (const auto& entry : triggered)
+  {
+    if (!entry->cancelled)
+      entry->callback();
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& entry : triggered)
+  {
+    if (entry->cancelled)
+    {
+      --_size;
+      continue;
+    }
+
+    entry->due_tick = _current_tick + entry->period_ticks;
+    _insert(std::move(entry));
+  }
+}
+
+//==============================================================================
+void TimerWheel::_insert(EntryPtr entry)
+{
+  const uint64_t delta = entry->due_tick > _current_tick ?
+    entry->due_tick - _current_tick : 0;
+
+  for (std::size_t level = 0; level < NumLevels; ++level)
+  {
+    if (delta < (uint64_t(1) << (SlotBits*(level+1))))
+    {
+      const auto index =
+        (entry->due_tick >> (SlotBits*level)) & (NumSlots - 1);
+      _levels[level][index].push_back(std::move(entry));
+      return;
+    }
+  }
+
+  _overflow.push_back(std::move(entry));
+}
+
+//==============================================================================
+void TimerWheel::_cascade(const std::size_t level)
+{
+  std::vector<EntryPtr> entries;
+  if (level + 1 == NumLevels
+    && (_current_tick & ((uint64_t(1) << (SlotBits*NumLevels)) - 1)) == 0)
+  {
+    // The top level has wrapped around, so the overflow gets another chance
+    // to be placed on the wheel.
+    entries.swap(_overflow);
+  }
+
+  auto& slot =
+    _levels[level][(_current_tick >> (SlotBits*level)) & (NumSlots - 1)];
+  entries.insert(entries.end(), slot.begin(), slot.end());
+  slot.clear();
+
+  for (auto& entry : entries)
+  {
+    if (entry->cancelled)
+    {
+      --_size;
+      continue;
+    }
+
+    _insert(std::move(entry));
+  }
+}
+
+//==============================================================================
+void TimerWheel::Timer::cancel()
+{
+  _entry->cancelled = true;
+}
+
+//==============================================================================
+TimerWheel::Timer::~Timer()
+{
+  cancel();
+}
+
+//==============================================================================
+TimerWheel::Timer::Timer(std::weak_ptr<TimerWheel> wheel, EntryPtr entry)
+: _wheel(std::move(wheel)),
+  _entry(std::move(entry))
+{
+  // Do nothing
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
@@ -19,6 +19,7 @@
 
 #include "../services/FindPath.hpp"
 #include "../services/Negotiate.hpp"
+#include "../route_shape.hpp"
 
 #include <rmf_utils/Modular.hpp>
 #include <rmf_utils/math.hpp>
@@ -38,6 +39,26 @@
 namespace rmf_fleet_adapter {
 namespace agv {
 
+namespace {
+//==============================================================================
+/// Robots usually report their location many times while they move along the
+/// same few segments of their plan, so we remember the segment that matched
+/// last time and search forward from there.
+struct InterpolationCursor
+{
+  std::shared_ptr<const std::vector<rmf_traffic::agv::Plan::Waypoint>>
+  waypoints;
+
+  /// The index of the waypoint at the end of the segment that matched last
+  std::size_t segment = 1;
+
+  /// How many segments past the last match we will look before falling back
+  /// to a search of the whole plan
+  static constexpr std::size_t Window = 4;
+};
+
+} // anonymous namespace
+
 //==============================================================================
 class TrafficLight::UpdateHandle::Implementation::Data
   : public std::enable_shared_from_this<Data>
@@ -80,6 +101,24 @@ public:
   std::vector<rmf_traffic::Route> plan_itinerary;
   std::vector<rmf_traffic::agv::Plan::Waypoint> pending_waypoints;
 
+  /// The plan waypoints that are passed along to the departure callbacks of
+  /// the checkpoints. These get shared by every checkpoint of a segment.
+  using SharedWaypoints =
+    std::shared_ptr<const std::vector<rmf_traffic::agv::Plan::Waypoint>>;
+
+  InterpolationCursor interpolation_cursor;
+
+  /// The cumulative delay of the participant at the time that the itinerary
+  /// was last submitted. Anything beyond this is delay that has accrued on
+  /// top of the current plan.
+  rmf_traffic::Duration submitted_delay = rmf_traffic::Duration(0);
+
+  /// How far behind the current plan the participant is running
+  rmf_traffic::Duration plan_delay() const
+  {
+    return itinerary.delay() - submitted_delay;
+  }
+
   struct Location
   {
     std::string map;
@@ -107,20 +146,20 @@ public:
 
   /// A timer that periodically checks if the next checkpoint is ready, when
   /// we're sitting and waiting for the departure time of our current checkpoint
-  rclcpp::TimerBase::SharedPtr ready_check_timer;
+  TimerWheel::TimerPtr ready_check_timer;
 
   /// A timer that periodically checks if we need to delay our scheduled
   /// trajectory while we wait for the blockade manager to give us permission
   /// to depart from a checkpoint
-  rclcpp::TimerBase::SharedPtr waiting_timer;
+  TimerWheel::TimerPtr waiting_timer;
 
-  rclcpp::Publisher<rmf_fleet_msgs::msg::FleetState>::SharedPtr fleet_state_pub;
-  rclcpp::TimerBase::SharedPtr fleet_state_timer;
+  /// Keeps this robot in the fleet state that the node publishes for its fleet
+  FleetStateAggregator::RegistrationPtr fleet_state_registration;
 
   struct NegotiateManagers
   {
     rmf_rxcpp::subscription_guard subscription;
-    rclcpp::TimerBase::SharedPtr timer;
+    TimerWheel::TimerPtr timer;
   };
   using NegotiatePtr = std::shared_ptr<services::Negotiate>;
   using NegotiateServiceMap =
@@ -153,7 +192,7 @@ public:
   void update_location(
     std::size_t path_version,
     std::size_t plan_version,
-    const std::vector<rmf_traffic::agv::Plan::Waypoint>& waypoints,
+    const SharedWaypoints& waypoints,
     Eigen::Vector3d location,
     std::size_t checkpoint_index);
 
@@ -204,7 +243,9 @@ public:
     return itinerary.description().name();
   }
 
-  void publish_fleet_state() const;
+  std::optional<rmf_fleet_msgs::msg::RobotState> fleet_robot_state() const;
+
+  void include_in_fleet_state();
 
   Data(
     std::shared_ptr<CommandHandle> command_,
@@ -243,6 +284,7 @@ void TrafficLight::UpdateHandle::Implementation::Data::update_path(
   plan_itinerary.clear();
   pending_waypoints.clear();
   itinerary.clear();
+  submitted_delay = itinerary.delay();
   ready_check_timer = nullptr;
   waiting_timer = nullptr;
   last_departed_waypoint.reset();
@@ -535,142 +577,274 @@ rmf_traffic::Time interpolate_time(
 }
 
 //==============================================================================
-rmf_utils::optional<rmf_traffic::Time> interpolate_time(
+struct SegmentTiming
+{
+  /// True if the location was matched against this segment, even if no time
+  /// could be estimated from it
+  bool matched = false;
+
+  std::optional<rmf_traffic::Time> time;
+};
+
+//==============================================================================
+/// Estimate when the plan expected the robot to be at this location, assuming
+/// the robot is on the segment from wp0 to wp1. If strict is true then a lane
+/// only matches when the robot is actually somewhere along it, instead of
+/// projecting the lane to meet the robot.
+SegmentTiming estimate_segment_time(
   const rmf_traffic::Time now,
   const rmf_traffic::agv::VehicleTraits& traits,
-  const std::vector<rmf_traffic::agv::Plan::Waypoint>& waypoints,
-  const Eigen::Vector3d& location)
+  const rmf_traffic::agv::Plan::Waypoint& wp0,
+  const rmf_traffic::agv::Plan::Waypoint& wp1,
+  const Eigen::Vector3d& location,
+  const bool strict)
 {
   const Eigen::Vector2d p = location.block<2, 1>(0, 0);
+  const auto gi_0 = wp0.graph_index();
+  const auto gi_1 = wp1.graph_index();
 
-  assert(waypoints.size() > 1);
+  if (gi_1.has_value() && (!gi_0.has_value() || (*gi_0 != *gi_1)))
+  {
+    // Check if the robot is traversing a lane
+    const Eigen::Vector2d p0 = wp0.position().block<2, 1>(0, 0);
+    const Eigen::Vector2d p1 = wp1.position().block<2, 1>(0, 0);
+    const Eigen::Vector2d n = p1 - p0;
+    const double length = n.norm();
+    const Eigen::Vector2d dir = n/length;
+
+    const Eigen::Vector2d r = p - p0;
+    const double traversal = r.dot(dir);
+    const double deviation = (r - traversal*dir).norm();
+
+    // TODO(MXG): Make this threshold configurable
+    const double deviation_threshold = 1.0;
+
+    if (strict
+      && (deviation > deviation_threshold
+      || traversal < 0.0 || length < traversal))
+      return {};
+
+    // If the vehicle has deviated significantly from the path, then we should
+    // recompute the timing information.
+    if (deviation > deviation_threshold)
+      return {true, std::nullopt};
+
+    if (traversal < 0.0)
+    {
+      // If the vehicle is behind the lane then we should project the lane
+      // backwards to meet it
+      const double s = traversal/traits.linear().get_nominal_velocity();
+      return {true, wp0.time() + rmf_traffic::time::from_seconds(s)};
+    }
 
-  const std::size_t N = waypoints.size();
-  for (std::size_t i = 1; i < waypoints.size(); ++i)
+    try
+    {
+      return {
+        true,
+        interpolate_time(traits, wp0, wp1, location.block<2, 1>(0, 0))
+      };
+    }
+    catch (const std::exception&)
+    {
+      // TODO(MXG): This is kind of suspicious. Should we escalate the issue
+      // at this point?
+      return {true, std::nullopt};
+    }
+  }
+
+  // Check if the robot is on the target waypoint
+  const Eigen::Vector2d p0 = wp0.position().block<2, 1>(0, 0);
+
+  // TODO(MXG): Make this threshold configurable
+  const double distance_threshold = 0.5;
+  if ((p - p0).norm() > distance_threshold)
+    return {};
+
+  const double yaw = location[2];
+  const auto yaw0 = wp0.position()[2];
+  const auto yaw1 = wp1.position()[2];
+  const double dyaw = rmf_utils::wrap_to_pi(yaw1 - yaw0);
+
+  const auto t_min = wp0.time();
+  const auto t_max = wp1.time();
+
+  // TODO(MXG): Make this threshold configurable
+  const double waiting_threshold = 1.0*M_PI/180.0;
+  if (std::abs(dyaw) < waiting_threshold)
   {
-    const auto index = N - i;
-    const auto& wp0 = waypoints.at(index-1);
-    const auto& wp1 = waypoints.at(index);
+    // This is a waiting segment
 
-    const auto gi_0 = wp0.graph_index();
-    const auto gi_1 = wp1.graph_index();
+    // TODO(MXG): Make this threshold configurable
+    const double yaw_threshold = 20.0*M_PI/180.0;
 
-    if (gi_1.has_value() && (!gi_0.has_value() || (*gi_0 != *gi_1)))
+    if (std::abs(yaw - yaw0) < yaw_threshold)
     {
-      // Check if the robot is traversing a lane
-      const Eigen::Vector2d p0 = wp0.position().block<2, 1>(0, 0);
-      const Eigen::Vector2d p1 = wp1.position().block<2, 1>(0, 0);
-      const Eigen::Vector2d n = p1 - p0;
-      const double length = n.norm();
-      const Eigen::Vector2d dir = n/length;
-
-      const Eigen::Vector2d r = p - p0;
-      const double traversal = r.dot(dir);
-      const double deviation = (r - traversal*dir).norm();
-
-      // TODO(MXG): Make this threshold configurable
-      const double deviation_threshold = 1.0;
-
-      // If the vehicle has deviated significantly from the path, then we should
-      // recompute the timing information.
-      if (deviation > deviation_threshold)
-        return rmf_utils::nullopt;
-
-      if (traversal < 0.0)
-      {
-        // If the vehicle is behind the lane then we should project the lane
-        // backwards to meet it
-        const double s = traversal/traits.linear().get_nominal_velocity();
-        return wp0.time() + rmf_traffic::time::from_seconds(s);
-      }
+      // We are waiting
 
-      try
-      {
-        return interpolate_time(traits, wp0, wp1, location.block<2, 1>(0, 0));
-      }
-      catch (const std::exception&)
-      {
-        // TODO(MXG): This is kind of suspicious. Should we escalate the issue
-        // at this point?
-        return rmf_utils::nullopt;
-      }
+      // If the current time has not yet reached the end of the waiting time
+      // then we just return the current time to imply that the robot is
+      // on-time. This may leave a false shadow of an itinerary on the
+      // schedule, but that should usually be okay.
+      if (now <= t_max)
+        return {true, now};
+
+      return {true, t_max};
     }
-    else
-    {
-      // Check if the robot is on the target waypoint
-      const Eigen::Vector2d p0 = wp0.position().block<2, 1>(0, 0);
 
-      // TODO(MXG): Make this threshold configurable
-      const double distance_threshold = 0.5;
-      if ((p - p0).norm() > distance_threshold)
-        continue;
+    return {};
+  }
 
-      const double yaw = location[2];
-      const auto yaw0 = wp0.position()[2];
-      const auto yaw1 = wp1.position()[2];
-      const double dyaw = rmf_utils::wrap_to_pi(yaw1 - yaw0);
+  // This is a turning segment
 
-      const auto t_min = wp0.time();
-      const auto t_max = wp1.time();
+  // NOTE: For now we'll just approximate turns as constant-velocities
+  // while estimating. We could make this estimation more accurate in
+  // the future if this turns out to not be good enough.
+  const double s = rmf_utils::wrap_to_pi(yaw - yaw0)/dyaw;
+  const double dt = rmf_traffic::time::to_seconds(t_max - t_min);
+  const auto t = t_min + rmf_traffic::time::from_seconds(s*dt);
+  if (now <= t)
+    return {true, now};
 
-      // TODO(MXG): Make this threshold configurable
-      const double waiting_threshold = 1.0*M_PI/180.0;
-      if (std::abs(dyaw) < waiting_threshold)
-      {
-        // This is a waiting segment
+  return {true, t};
+}
 
-        // TODO(MXG): Make this threshold configurable
-        const double yaw_threshold = 20.0*M_PI/180.0;
+//==============================================================================
+rmf_utils::optional<rmf_traffic::Time> interpolate_time(
+  const rmf_traffic::Time now,
+  const rmf_traffic::agv::VehicleTraits& traits,
+  const std::shared_ptr<const std::vector<rmf_traffic::agv::Plan::Waypoint>>&
+  waypoints_ptr,
+  const Eigen::Vector3d& location,
+  InterpolationCursor& cursor)
+{
+  const auto& waypoints = *waypoints_ptr;
+  assert(waypoints.size() > 1);
 
-        if (std::abs(yaw - yaw0) < yaw_threshold)
-        {
-          // We are waiting
+  if (cursor.waypoints != waypoints_ptr)
+  {
+    cursor.waypoints = waypoints_ptr;
+    cursor.segment = 1;
+  }
 
-          // If the current time has not yet reached the end of the waiting time
-          // then we just return the current time to imply that the robot is
-          // on-time. This may leave a false shadow of an itinerary on the
-          // schedule, but that should usually be okay.
-          if (now <= t_max)
-            return now;
+  const std::size_t N = waypoints.size();
+  const std::size_t end = std::min(N, cursor.segment + cursor.Window);
+  for (std::size_t i = cursor.segment; i < end; ++i)
+  {
+    const auto estimate = estimate_segment_time(
+      now, traits, waypoints[i-1], waypoints[i], location, true);
 
-          return t_max;
-        }
-      }
-      else
-      {
-        // This is a turning segment
-
-        // NOTE: For now we'll just approximate turns as constant-velocities
-        // while estimating. We could make this estimation more accurate in
-        // the future if this turns out to not be good enough.
-        const double s = rmf_utils::wrap_to_pi(yaw - yaw0)/dyaw;
-        const double dt = rmf_traffic::time::to_seconds(t_max - t_min);
-        const auto t = t_min + rmf_traffic::time::from_seconds(s*dt);
-        if (now <= t)
-          return now;
-
-        return t;
-      }
+    if (estimate.matched)
+    {
+      cursor.segment = i;
+      return estimate.time;
     }
   }
 
+  // The robot is not where we expected it to be, so we will search the whole
+  // plan, starting from the end.
+  for (std::size_t i = 1; i < N; ++i)
+  {
+    const auto index = N - i;
+    const auto estimate = estimate_segment_time(
+      now, traits, waypoints[index-1], waypoints[index], location, false);
+
+    if (estimate.matched)
+      return estimate.time;
+  }
+
   return rmf_utils::nullopt;
 }
 
+//==============================================================================
+/// Bring the schedule up to date with the new itinerary using the smallest
+/// change that we can find. Most updates of a traffic light only move the
+/// timing of the routes or replace the routes that come after the ones that
+/// have already been stashed, so we can usually send a delay or an erase and
+/// extend instead of the whole itinerary.
+void submit_itinerary(
+  rmf_traffic::schedule::Participant& scheduled_itinerary,
+  std::vector<rmf_traffic::Route> full_itinerary)
+{
+  const auto& current = scheduled_itinerary.itinerary();
+  if (current.empty() || full_itinerary.empty())
+  {
+    scheduled_itinerary.set(std::move(full_itinerary));
+    return;
+  }
+
+  // Check whether the whole itinerary has simply been shifted in time
+  if (current.size() == full_itinerary.size())
+  {
+    std::optional<rmf_traffic::Duration> shift;
+    bool uniform = true;
+    for (std::size_t i = 0; i < current.size() && uniform; ++i)
+    {
+      const auto s = route_time_shift(*current[i].route, full_itinerary[i]);
+      uniform = s.has_value() && (!shift.has_value() || *shift == *s);
+      shift = s;
+    }
+
+    if (uniform)
+    {
+      if (*shift != rmf_traffic::Duration(0))
+        scheduled_itinerary.delay(*shift);
+
+      return;
+    }
+  }
+
+  // Find how many leading routes are still exactly the same
+  std::size_t common = 0;
+  while (common < current.size() && common < full_itinerary.size())
+  {
+    const auto s =
+      route_time_shift(*current[common].route, full_itinerary[common]);
+    if (!s.has_value() || *s != rmf_traffic::Duration(0))
+      break;
+
+    ++common;
+  }
+
+  if (common == 0)
+  {
+    scheduled_itinerary.set(std::move(full_itinerary));
+    return;
+  }
+
+  if (common < current.size())
+  {
+    std::vector<rmf_traffic::RouteId> stale;
+    stale.reserve(current.size() - common);
+    for (std::size_t i = common; i < current.size(); ++i)
+      stale.push_back(current[i].id);
+
+    scheduled_itinerary.erase(stale);
+  }
+
+  if (common < full_itinerary.size())
+  {
+    scheduled_itinerary.extend(
+      std::vector<rmf_traffic::Route>(
+        std::make_move_iterator(full_itinerary.begin() + common),
+        std::make_move_iterator(full_itinerary.end())));
+  }
+}
+
 //==============================================================================
 void update_itineraries(
   rmf_traffic::schedule::Participant& scheduled_itinerary,
+  rmf_traffic::Duration& submitted_delay,
   std::vector<rmf_traffic::Route>& stashed_itinerary,
   std::vector<rmf_traffic::Route>& active_itinerary,
   const std::vector<rmf_traffic::Route>& plan_itinerary)
 {
-  // TODO(MXG): Revisit the way we keep the schedule up to date, since we can
-  // probably do better.
   for (const auto& r : active_itinerary)
     stashed_itinerary.push_back(r);
   active_itinerary.clear();
 
-  const auto cumulative_delay = scheduled_itinerary.delay();
+  // Only the delay that has accrued since the last submission still needs to
+  // be baked into the stashed routes.
+  const auto cumulative_delay = scheduled_itinerary.delay() - submitted_delay;
   for (auto& r : stashed_itinerary)
   {
     assert(!r.trajectory().empty());
@@ -691,7 +865,8 @@ void update_itineraries(
     plan_itinerary.begin(),
     plan_itinerary.end());
 
-  scheduled_itinerary.set(std::move(full_itinerary));
+  submit_itinerary(scheduled_itinerary, std::move(full_itinerary));
+  submitted_delay = scheduled_itinerary.delay();
 }
 
 //==============================================================================
@@ -903,7 +1078,9 @@ TrafficLight::UpdateHandle::Implementation::Data::update_timing(
         path_version = current_path_version,
         plan_version = current_plan_version,
         checkpoint_index = resume_target-1,
-        waypoints = std::move(resume_waypoints)](
+        waypoints = std::make_shared<
+          const std::vector<rmf_traffic::agv::Plan::Waypoint>>(
+          std::move(resume_waypoints))](
       Eigen::Vector3d location)
       {
         if (const auto data = w.lock())
@@ -935,7 +1112,8 @@ TrafficLight::UpdateHandle::Implementation::Data::update_timing(
     last_immediate_stop.reset();
 
   update_itineraries(
-    itinerary, stashed_itinerary, active_itinerary, plan_itinerary);
+    itinerary, submitted_delay,
+    stashed_itinerary, active_itinerary, plan_itinerary);
 
   if (resend_checkpoints)
   {
@@ -1013,19 +1191,20 @@ bool TrafficLight::UpdateHandle::Implementation::Data::valid_plan(
 void TrafficLight::UpdateHandle::Implementation::Data::update_location(
   const std::size_t path_version,
   const std::size_t,
-  const std::vector<rmf_traffic::agv::Plan::Waypoint>& waypoints,
+  const SharedWaypoints& waypoints,
   const Eigen::Vector3d location,
   const std::size_t checkpoint_index)
 {
   const auto now = rmf_traffic_ros2::convert(node->now());
 
-  worker.schedule(
+  BatchUpdates::schedule(
+    worker, node.get(),
     [w = weak_from_this(),
     path_version,
     waypoints,
     location,
     now,
-    checkpoint_index](const auto&)
+    checkpoint_index]()
     {
       const auto data = w.lock();
       if (!data)
@@ -1071,12 +1250,12 @@ void TrafficLight::UpdateHandle::Implementation::Data::update_location(
       assert(checkpoint_index < data->arrival_timing.size());
 
       const auto expected_time = interpolate_time(
-        now, data->traits, waypoints, location);
+        now, data->traits, waypoints, location, data->interpolation_cursor);
 
       if (expected_time)
       {
         const auto new_delay = now - *expected_time;
-        const auto time_shift = new_delay - data->itinerary.delay();
+        const auto time_shift = new_delay - data->plan_delay();
         const auto threshold = std::chrono::seconds(1);
         if (time_shift < -threshold || threshold < time_shift)
         {
@@ -1109,14 +1288,14 @@ void TrafficLight::UpdateHandle::Implementation::Data::update_stopped_location(
 {
   const auto now = rmf_traffic_ros2::convert(node->now());
 
-  worker.schedule(
+  BatchUpdates::schedule(
+    worker, node.get(),
     [w = weak_from_this(),
     version,
     target_checkpoint,
     location,
     expected_location,
-    now](
-      const auto&)
+    now]()
     {
       const auto data = w.lock();
       if (!data)
@@ -1290,15 +1469,16 @@ void TrafficLight::UpdateHandle::Implementation::Data::send_checkpoints(
       }
     }
 
-    std::vector<rmf_traffic::agv::Plan::Waypoint> departed_waypoints(
+    const auto departed_waypoints = std::make_shared<
+      const std::vector<rmf_traffic::agv::Plan::Waypoint>>(
       pending_waypoints.begin() + next,
       pending_waypoints.begin() + end_plan_segment_index);
 
-    assert(!departed_waypoints.empty());
+    assert(!departed_waypoints->empty());
 
     const std::size_t last_checkpoint_index =
       std::min(
-      departed_waypoints.back().graph_index().value(),
+      departed_waypoints->back().graph_index().value(),
       current_range.end);
 
     for (std::size_t c = current_checkpoint_index;
@@ -1441,7 +1621,7 @@ void TrafficLight::UpdateHandle::Implementation::Data::watch_for_ready(
   if (check_if_finished(checkpoint_id))
     return;
 
-  waiting_timer = node->try_create_wall_timer(
+  waiting_timer = node->try_create_wheel_timer(
     std::chrono::seconds(1),
     [w = weak_from_this(), path_version, checkpoint_id]()
     {
@@ -1452,7 +1632,7 @@ void TrafficLight::UpdateHandle::Implementation::Data::watch_for_ready(
   if (check_if_ready(path_version, checkpoint_id))
     return;
 
-  ready_check_timer = node->try_create_wall_timer(
+  ready_check_timer = node->try_create_wheel_timer(
     std::chrono::milliseconds(100),
     [w = weak_from_this(), path_version, checkpoint_id]()
     {
@@ -1499,7 +1679,7 @@ bool TrafficLight::UpdateHandle::Implementation::Data::check_if_ready(
   }
 
   const auto ready_time = depart_it->second;
-  const auto now = node->now() - itinerary.delay();
+  const auto now = node->now() - plan_delay();
 
   if (now + ready_timing_threshold <= ready_time)
     return false;
@@ -1528,7 +1708,7 @@ void TrafficLight::UpdateHandle::Implementation::Data::check_waiting_delay(
 
   const auto now = node->now();
   const auto new_delay = now - depart_it->second;
-  const auto time_shift = (new_delay - itinerary.delay())
+  const auto time_shift = (new_delay - plan_delay())
     .to_chrono<std::chrono::nanoseconds>();
 
   // We add some extra margin in here, because we don't know exactly when
@@ -1549,6 +1729,7 @@ bool TrafficLight::UpdateHandle::Implementation::Data::check_if_finished(
     waiting_timer = nullptr;
     ready_check_timer = nullptr;
     itinerary.clear();
+    submitted_delay = itinerary.delay();
     return true;
   }
 
@@ -1662,11 +1843,11 @@ TrafficLight::UpdateHandle::Implementation::Data::current_location() const
 }
 
 //==============================================================================
-void
-TrafficLight::UpdateHandle::Implementation::Data::publish_fleet_state() const
+std::optional<rmf_fleet_msgs::msg::RobotState>
+TrafficLight::UpdateHandle::Implementation::Data::fleet_robot_state() const
 {
   if (!last_known_location.has_value())
-    return;
+    return std::nullopt;
 
   auto robot_mode = [&]()
     {
@@ -1699,7 +1880,7 @@ TrafficLight::UpdateHandle::Implementation::Data::publish_fleet_state() const
     .index(0);
 
   const auto& fleet_name = itinerary.description().owner();
-  auto robot_state = rmf_fleet_msgs::build<rmf_fleet_msgs::msg::RobotState>()
+  return rmf_fleet_msgs::build<rmf_fleet_msgs::msg::RobotState>()
     .name(name())
     .model(fleet_name)
     // TODO(MXG): Have a way to fill this in
@@ -1713,11 +1894,23 @@ TrafficLight::UpdateHandle::Implementation::Data::publish_fleet_state() const
     .battery_percent(current_battery_soc*100.0)
     .location(std::move(location))
     .path({});
+}
+
+//==============================================================================
+void TrafficLight::UpdateHandle::Implementation::Data::include_in_fleet_state()
+{
+  if (fleet_state_registration)
+    return;
 
-  fleet_state_pub->publish(
-    rmf_fleet_msgs::build<rmf_fleet_msgs::msg::FleetState>()
-    .name(fleet_name)
-    .robots({std::move(robot_state)}));
+  fleet_state_registration = node->traffic_light_fleet_states()->add(
+    itinerary.description().owner(),
+    [me = weak_from_this()]() -> std::optional<rmf_fleet_msgs::msg::RobotState>
+    {
+      if (const auto self = me.lock())
+        return self->fleet_robot_state();
+
+      return std::nullopt;
+    });
 }
 
 //==============================================================================
@@ -1737,6 +1930,11 @@ public:
     const ResponderPtr& responder) final;
 
 private:
+  static void _respond(
+    const std::shared_ptr<Data>& data,
+    const TableViewerPtr& table_viewer,
+    const ResponderPtr& responder);
+
   std::weak_ptr<Data> _data;
 };
 
@@ -1746,7 +1944,30 @@ void TrafficLight::UpdateHandle::Implementation::Negotiator::respond(
   const ResponderPtr& responder)
 {
   const auto data = _data.lock();
-  if (!data || !data->planner || data->pending_waypoints.empty())
+  if (!data)
+    return responder->forfeit({});
+
+  // Negotiations may be handled on a different worker than this traffic
+  // light. Its data may only be touched from its own worker, so the response
+  // is made over there.
+  data->worker.schedule(
+    [w = _data, table_viewer, responder](const auto&)
+    {
+      const auto data = w.lock();
+      if (!data)
+        return responder->forfeit({});
+
+      _respond(data, table_viewer, responder);
+    });
+}
+
+//==============================================================================
+void TrafficLight::UpdateHandle::Implementation::Negotiator::_respond(
+  const std::shared_ptr<Data>& data,
+  const TableViewerPtr& table_viewer,
+  const ResponderPtr& responder)
+{
+  if (!data->planner || data->pending_waypoints.empty())
   {
     // If we no longer have access to the traffic light data or there is no
     // plan being followed, then we simply forfeit the negotiation.
@@ -1823,7 +2044,7 @@ void TrafficLight::UpdateHandle::Implementation::Negotiator::respond(
   using namespace std::chrono_literals;
   const auto wait_duration = 2s + table_viewer->sequence().back().version * 10s;
 
-  auto negotiate_timer = data-> node->try_create_wall_timer(
+  auto negotiate_timer = data->node->try_create_wheel_timer(
     wait_duration,
     [s = negotiate->weak_from_this()]()
     {
@@ -1860,6 +2081,54 @@ rmf_traffic::blockade::Participant make_blockade(
     itinerary.id(), radius, std::move(new_range_cb));
 }
 
+//==============================================================================
+namespace {
+thread_local TrafficLight::UpdateHandle::Implementation::BatchUpdates*
+current_batch = nullptr;
+} // anonymous namespace
+
+//==============================================================================
+TrafficLight::UpdateHandle::Implementation::BatchUpdates::BatchUpdates()
+: _active(current_batch == nullptr)
+{
+  if (_active)
+    current_batch = this;
+}
+
+//==============================================================================
+TrafficLight::UpdateHandle::Implementation::BatchUpdates::~BatchUpdates()
+{
+  if (!_active)
+    return;
+
+  current_batch = nullptr;
+  for (auto& entry : _jobs)
+  {
+    entry.second.worker.schedule(
+      [jobs = std::move(entry.second.jobs)](const auto&)
+      {
+        for (const auto& job : jobs)
+          job();
+      });
+  }
+}
+
+//==============================================================================
+void TrafficLight::UpdateHandle::Implementation::BatchUpdates::schedule(
+  const rxcpp::schedulers::worker& worker,
+  const Node* node,
+  std::function<void()> job)
+{
+  if (!current_batch)
+  {
+    worker.schedule([job = std::move(job)](const auto&) { job(); });
+    return;
+  }
+
+  auto insertion = current_batch->_jobs.insert({node, Jobs{worker, {}}});
+  insertion.first->second.jobs.push_back(std::move(job));
+}
+
 //==============================================================================
 TrafficLight::UpdateHandle::Implementation::Implementation(
   std::shared_ptr<CommandHandle> command_,
@@ -1878,14 +2147,7 @@ TrafficLight::UpdateHandle::Implementation::Implementation(
       std::move(node_)))
 {
   data->blockade = make_blockade(*blockade_writer, data->itinerary, this);
-  data->fleet_state_pub = data->node->fleet_state();
-  data->fleet_state_timer = data-> node->try_create_wall_timer(
-    std::chrono::seconds(1),
-    [me = data->weak_from_this()]()
-    {
-      if (const auto self = me.lock())
-        self->publish_fleet_state();
-    });
+  data->include_in_fleet_state();
 }
 
 //==============================================================================
@@ -1948,8 +2210,9 @@ auto TrafficLight::UpdateHandle::update_idle_location(
   Eigen::Vector3d position) -> UpdateHandle&
 {
   const std::size_t version = ++_pimpl->received_version;
-  _pimpl->data->worker.schedule(
-    [version, map = std::move(map), position, data = _pimpl->data](const auto&)
+  Implementation::BatchUpdates::schedule(
+    _pimpl->data->worker, _pimpl->data->node.get(),
+    [version, map = std::move(map), position, data = _pimpl->data]()
     {
       if (rmf_utils::modular(version).less_than(data->processing_version))
         return;
@@ -1984,20 +2247,17 @@ auto TrafficLight::UpdateHandle::update_battery_soc(double battery_soc)
 auto TrafficLight::UpdateHandle::fleet_state_publish_period(
   std::optional<rmf_traffic::Duration> value) -> UpdateHandle&
 {
+  // The robots of a fleet share one fleet state message, so the period
+  // applies to every traffic light robot of this fleet on the same node.
   if (value.has_value())
   {
-    _pimpl->data->fleet_state_timer =
-      _pimpl->data-> node->try_create_wall_timer(
-      value.value(),
-      [me = _pimpl->data->weak_from_this()]()
-      {
-        if (const auto self = me.lock())
-          self->publish_fleet_state();
-      });
+    _pimpl->data->node->traffic_light_fleet_states()->set_period(
+      _pimpl->data->itinerary.description().owner(), *value);
+    _pimpl->data->include_in_fleet_state();
   }
   else
   {
-    _pimpl->data->fleet_state_timer = nullptr;
+    _pimpl->data->fleet_state_registration = nullptr;
   }
 
   return *this;
@@ -0,0 +1,562 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_TravelTimeTable.hpp"
+#include "../MemoryUsage.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <queue>
+#include <tuple>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+namespace {
+//==============================================================================
+const double Unreachable = std::numeric_limits<double>::infinity();
+
+//==============================================================================
+double event_time(const rmf_traffic::agv::Graph::Lane::Node& node)
+{
+  const auto* event = node.event();
+  if (!event)
+    return 0.0;
+
+  return rmf_traffic::time::to_seconds(event->duration());
+}
+} // anonymous namespace
+
+//==============================================================================
+TravelTimeTable::TravelTimeTable(
+  const rmf_traffic::agv::Planner::Configuration& config)
+: _graph(config.graph()),
+  _nominal_velocity(
+    config.vehicle_traits().linear().get_nominal_velocity())
+{
+  const std::size_t num_lanes = _graph.num_lanes();
+  _lane_time.reserve(num_lanes);
+  _lane_ends.reserve(num_lanes);
+  _lanes_from.resize(_graph.num_waypoints());
+  _lanes_into.resize(_graph.num_waypoints());
+
+  for (std::size_t i = 0; i < num_lanes; ++i)
+  {
+    const auto& lane = _graph.get_lane(i);
+    const auto entry = lane.entry().waypoint_index();
+    const auto exit = lane.exit().waypoint_index();
+    const auto& entry_wp = _graph.get_waypoint(entry);
+    const auto& exit_wp = _graph.get_waypoint(exit);
+
+    double time = event_time(lane.entry()) + event_time(lane.exit());
+    if (entry_wp.get_map_name() == exit_wp.get_map_name())
+    {
+      const double distance =
+        (exit_wp.get_location() - entry_wp.get_location()).norm();
+      time += distance / _nominal_velocity;
+    }
+
+    _lane_time.push_back(time);
+    _lane_ends.push_back({entry, exit});
+    _lanes_from[entry].push_back(i);
+    _lanes_into[exit].push_back(i);
+  }
+
+  _lane_closed.resize(num_lanes, false);
+  update_lane_closures(config.lane_closures());
+}
+
+//==============================================================================
+std::optional<double> TravelTimeTable::travel_time(
+  const std::size_t from,
+  const std::size_t to) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const double time = _row(from).time.at(to);
+  if (time == Unreachable)
+    return std::nullopt;
+
+  return time;
+}
+
+//==============================================================================
+std::optional<double> TravelTimeTable::travel_time(
+  const rmf_traffic::agv::Planner::Start& start,
+  const std::size_t to) const
+{
+  auto time = travel_time(start.waypoint(), to);
+  if (!time.has_value())
+    return std::nullopt;
+
+  if (start.location().has_value())
+  {
+    const auto& wp = _graph.get_waypoint(start.waypoint());
+    const double distance = (wp.get_location() - *start.location()).norm();
+    *time += distance / _nominal_velocity;
+  }
+
+  return time;
+}
+
+//==============================================================================
+auto TravelTimeTable::nearest(
+  const rmf_traffic::agv::Planner::Start& start,
+  const std::vector<std::size_t>& destinations) const
+-> std::optional<Nearest>
+{
+  auto key = destinations;
+  std::sort(key.begin(), key.end());
+  key.erase(std::unique(key.begin(), key.end()), key.end());
+
+  Nearest result;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _nearest.find(key);
+    if (it == _nearest.end())
+    {
+      auto index = _search_nearest(key);
+      it = _nearest.insert({std::move(key), std::move(index)}).first;
+    }
+
+    const auto& index = it->second;
+    result.time = index.time.at(start.waypoint());
+    if (result.time == Unreachable)
+      return std::nullopt;
+
+    result.waypoint = index.destination[start.waypoint()];
+  }
+
+  if (start.location().has_value())
+  {
+    const auto& wp = _graph.get_waypoint(start.waypoint());
+    const double distance = (wp.get_location() - *start.location()).norm();
+    result.time += distance / _nominal_velocity;
+  }
+
+  return result;
+}
+
+//==============================================================================
+auto TravelTimeTable::nearest(
+  const rmf_traffic::agv::Planner::Start& start,
+  const std::vector<std::size_t>& destinations,
+  const std::size_t k) const -> std::vector<Nearest>
+{
+  if (k == 0)
+    return {};
+
+  std::vector<Nearest> result;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    result = _k_nearest_index(destinations, k).at(start.waypoint());
+  }
+
+  if (start.location().has_value())
+  {
+    const auto& wp = _graph.get_waypoint(start.waypoint());
+    const double distance = (wp.get_location() - *start.location()).norm();
+    for (auto& r : result)
+      r.time += distance / _nominal_velocity;
+  }
+
+  return result;
+}
+
+//==============================================================================
+void TravelTimeTable::precompute() const
+{
+  for (std::size_t i = 0; i < _graph.num_waypoints(); ++i)
+  {
+    // The lock is taken for one row at a time so that lookups do not need to
+    // wait for the whole table.
+    std::lock_guard<std::mutex> lock(_mutex);
+    _row(i);
+  }
+}
+
+//==============================================================================
+void TravelTimeTable::precompute_nearest(
+  const std::vector<std::size_t>& destinations,
+  const std::size_t k) const
+{
+  if (k == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _k_nearest_index(destinations, k);
+}
+
+//==============================================================================
+std::vector<std::size_t> TravelTimeTable::arrival_lanes(
+  const std::size_t from) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _row(from).arrival_lane;
+}
+
+//==============================================================================
+void TravelTimeTable::update_lane_closures(
+  const rmf_traffic::agv::LaneClosure& closures)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (std::size_t lane = 0; lane < _lane_closed.size(); ++lane)
+  {
+    const bool closed = closures.is_closed(lane);
+    if (closed == _lane_closed[lane])
+      continue;
+
+    // Each nearest index takes only one search to rebuild, so they are
+    // simply thrown away.
+    _nearest.clear();
+    _k_nearest.clear();
+
+    _lane_closed[lane] = closed;
+    if (closed)
+      ++_closed_lanes;
+    else
+      --_closed_lanes;
+
+    const auto [entry, exit] = _lane_ends[lane];
+    for (auto it = _rows.begin(); it != _rows.end(); )
+    {
+      const auto& row = it->second;
+      bool affected = false;
+      if (closed)
+      {
+        // Only rows whose shortest paths used this lane can get worse
+        affected = row.arrival_lane[exit] == lane;
+      }
+      else
+      {
+        // Only rows where this lane offers a shortcut can get better
+        affected = row.time[entry] + _lane_time[lane] < row.time[exit];
+      }
+
+      if (affected)
+        it = _rows.erase(it);
+      else
+        ++it;
+    }
+  }
+}
+
+//==============================================================================
+std::size_t TravelTimeTable::approximate_bytes() const
+{
+  using rmf_fleet_adapter::approximate_bytes;
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t bytes = 0;
+  for (const auto& [_, row] : _rows)
+  {
+    bytes += ContainerNodeBytes + sizeof(std::size_t) + sizeof(row)
+      + approximate_bytes(row.time) + approximate_bytes(row.arrival_lane);
+  }
+
+  for (const auto& [destinations, index] : _nearest)
+  {
+    bytes += ContainerNodeBytes + sizeof(destinations) + sizeof(index)
+      + approximate_bytes(destinations) + approximate_bytes(index.time)
+      + approximate_bytes(index.destination);
+  }
+
+  for (const auto& [key, index] : _k_nearest)
+  {
+    bytes += ContainerNodeBytes + sizeof(key) + sizeof(index)
+      + approximate_bytes(key.second) + approximate_bytes(index);
+    for (const auto& nearest : index)
+      bytes += approximate_bytes(nearest);
+  }
+
+  return bytes;
+}
+
+//==============================================================================
+uint64_t TravelTimeTable::fingerprint() const
+{
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](const auto& value)
+    {
+      unsigned char bytes[sizeof(value)];
+      std::memcpy(bytes, &value, sizeof(value));
+      for (const auto b : bytes)
+      {
+        hash ^= b;
+        hash *= 1099511628211ull;
+      }
+    };
+
+  mix(static_cast<uint64_t>(_graph.num_waypoints()));
+  mix(static_cast<uint64_t>(_lane_ends.size()));
+  for (std::size_t i = 0; i < _lane_ends.size(); ++i)
+  {
+    mix(static_cast<uint64_t>(_lane_ends[i].first));
+    mix(static_cast<uint64_t>(_lane_ends[i].second));
+    mix(_lane_time[i]);
+  }
+
+  return hash;
+}
+
+//==============================================================================
+void TravelTimeTable::save(std::ostream& out) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const uint64_t rows = _closed_lanes == 0 ? _rows.size() : 0;
+  const uint64_t waypoints = _graph.num_waypoints();
+  out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+  out.write(reinterpret_cast<const char*>(&waypoints), sizeof(waypoints));
+  if (rows == 0)
+    return;
+
+  for (const auto& [from, row] : _rows)
+  {
+    const uint64_t index = from;
+    out.write(reinterpret_cast<const char*>(&index), sizeof(index));
+    out.write(
+      reinterpret_cast<const char*>(row.time.data()),
+      sizeof(double) * row.time.size());
+
+    for (const auto lane : row.arrival_lane)
+    {
+      const uint64_t value = lane;
+      out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+  }
+}
+
+//==============================================================================
+bool TravelTimeTable::load(std::istream& in)
+{
+  uint64_t rows = 0;
+  uint64_t waypoints = 0;
+  in.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+  in.read(reinterpret_cast<char*>(&waypoints), sizeof(waypoints));
+  if (!in || waypoints != _graph.num_waypoints() || rows > waypoints)
+    return false;
+
+  std::unordered_map<std::size_t, Row> loaded;
+  for (uint64_t i = 0; i < rows; ++i)
+  {
+    uint64_t from = 0;
+    in.read(reinterpret_cast<char*>(&from), sizeof(from));
+
+    Row row;
+    row.time.resize(waypoints);
+    in.read(
+      reinterpret_cast<char*>(row.time.data()), sizeof(double) * waypoints);
+
+    row.arrival_lane.reserve(waypoints);
+    for (uint64_t wp = 0; wp < waypoints; ++wp)
+    {
+      uint64_t lane = 0;
+      in.read(reinterpret_cast<char*>(&lane), sizeof(lane));
+      if (lane != NoLane && lane >= _lane_ends.size())
+        return false;
+
+      row.arrival_lane.push_back(static_cast<std::size_t>(lane));
+    }
+
+    if (!in || from >= waypoints)
+      return false;
+
+    loaded[from] = std::move(row);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  // Rows that match the open graph can only be used while it is still open
+  if (_closed_lanes > 0)
+    return true;
+
+  for (auto& [from, row] : loaded)
+    _rows.insert({from, std::move(row)});
+
+  return true;
+}
+
+//==============================================================================
+auto TravelTimeTable::_row(const std::size_t from) const -> const Row&
+{
+  const auto it = _rows.find(from);
+  if (it != _rows.end())
+    return it->second;
+
+  return _rows.insert({from, _search(from)}).first->second;
+}
+
+//==============================================================================
+auto TravelTimeTable::_search(const std::size_t from) const -> Row
+{
+  const std::size_t N = _graph.num_waypoints();
+  Row row;
+  row.time.resize(N, Unreachable);
+  row.arrival_lane.resize(N, NoLane);
+
+  using Entry = std::pair<double, std::size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  row.time.at(from) = 0.0;
+  queue.push({0.0, from});
+
+  while (!queue.empty())
+  {
+    const auto [time, wp] = queue.top();
+    queue.pop();
+    if (time > row.time[wp])
+      continue;
+
+    for (const auto lane : _lanes_from[wp])
+    {
+      if (_lane_closed[lane])
+        continue;
+
+      const auto next = _lane_ends[lane].second;
+      const double next_time = time + _lane_time[lane];
+      if (next_time < row.time[next])
+      {
+        row.time[next] = next_time;
+        row.arrival_lane[next] = lane;
+        queue.push({next_time, next});
+      }
+    }
+  }
+
+  return row;
+}
+
+//==============================================================================
+auto TravelTimeTable::_search_nearest(
+  const std::vector<std::size_t>& destinations) const -> NearestIndex
+{
+  // Search backwards along the lanes, starting from every destination at
+  // once, so that one search finds the nearest destination of each waypoint.
+  const std::size_t N = _graph.num_waypoints();
+  NearestIndex index;
+  index.time.resize(N, Unreachable);
+  index.destination.resize(N, 0);
+
+  using Entry = std::pair<double, std::size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  for (const auto wp : destinations)
+  {
+    index.time.at(wp) = 0.0;
+    index.destination[wp] = wp;
+    queue.push({0.0, wp});
+  }
+
+  while (!queue.empty())
+  {
+    const auto [time, wp] = queue.top();
+    queue.pop();
+    if (time > index.time[wp])
+      continue;
+
+    for (const auto lane : _lanes_into[wp])
+    {
+      if (_lane_closed[lane])
+        continue;
+
+      const auto previous = _lane_ends[lane].first;
+      const double previous_time = time + _lane_time[lane];
+      if (previous_time < index.time[previous])
+      {
+        index.time[previous] = previous_time;
+        index.destination[previous] = index.destination[wp];
+        queue.push({previous_time, previous});
+      }
+    }
+  }
+
+  return index;
+}
+
+//==============================================================================
+auto TravelTimeTable::_search_k_nearest(
+  const std::vector<std::size_t>& destinations,
+  const std::size_t k) const -> KNearestIndex
+{
+  // This is the same backwards search as _search_nearest, except that each
+  // waypoint gets settled once for every one of its k nearest destinations.
+  const std::size_t N = _graph.num_waypoints();
+  KNearestIndex index(N);
+
+  using Entry = std::tuple<double, std::size_t, std::size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  for (const auto wp : destinations)
+    queue.push({0.0, wp, wp});
+
+  while (!queue.empty())
+  {
+    const auto [time, wp, destination] = queue.top();
+    queue.pop();
+
+    auto& settled = index.at(wp);
+    if (settled.size() >= k)
+      continue;
+
+    const bool repeated = std::any_of(
+      settled.begin(), settled.end(),
+      [destination = destination](const Nearest& n)
+      {
+        return n.waypoint == destination;
+      });
+
+    if (repeated)
+      continue;
+
+    settled.push_back({destination, time});
+    for (const auto lane : _lanes_into[wp])
+    {
+      if (_lane_closed[lane])
+        continue;
+
+      const auto previous = _lane_ends[lane].first;
+      if (index[previous].size() >= k)
+        continue;
+
+      queue.push({time + _lane_time[lane], previous, destination});
+    }
+  }
+
+  return index;
+}
+
+//==============================================================================
+auto TravelTimeTable::_k_nearest_index(
+  std::vector<std::size_t> destinations,
+  const std::size_t k) const -> const KNearestIndex&
+{
+  std::sort(destinations.begin(), destinations.end());
+  destinations.erase(
+    std::unique(destinations.begin(), destinations.end()),
+    destinations.end());
+
+  auto key = std::make_pair(k, std::move(destinations));
+  auto it = _k_nearest.find(key);
+  if (it == _k_nearest.end())
+  {
+    auto index = _search_k_nearest(key.second, k);
+    it = _k_nearest.insert({std::move(key), std::move(index)}).first;
+  }
+
+  return it->second;
+}
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
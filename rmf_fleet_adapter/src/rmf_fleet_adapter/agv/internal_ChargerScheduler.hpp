@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_CHARGERSCHEDULER_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_CHARGERSCHEDULER_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Shares the chargers of a fleet among its robots. Each robot is given a
+/// dedicated charger when it is added to the fleet, which is the charger that
+/// the task planner plans its charging tasks for. Robots are spread across the
+/// chargers instead of all being given the nearest one, as long as the extra
+/// travel is worth it.
+///
+/// When a robot needs to retreat to a charger it reserves a window of time at
+/// the charger where it can begin charging soonest. That may move the robot to
+/// a different charger than its dedicated one, if its dedicated charger is
+/// booked by another robot.
+///
+/// All of the functions of this class are thread-safe.
+class ChargerScheduler
+{
+public:
+
+  struct Config
+  {
+    /// How many seconds of extra travel a robot should accept to avoid each
+    /// robot that is already dedicated to a charger. Zero gives every robot
+    /// its nearest charger.
+    double share_penalty = 0.0;
+  };
+
+  /// A charger that a robot could use, and how many seconds it takes the
+  /// robot to reach it
+  struct Option
+  {
+    std::size_t charger;
+    double travel_time;
+  };
+
+  /// A window of time when a robot is expected to be using a charger
+  struct Window
+  {
+    std::string robot;
+    rmf_traffic::Time begin;
+    rmf_traffic::Time end;
+  };
+
+  struct Reservation
+  {
+    std::size_t charger;
+    Window window;
+  };
+
+  ChargerScheduler(std::vector<std::size_t> chargers, Config config);
+
+  /// Get the chargers of the fleet
+  const std::vector<std::size_t>& chargers() const;
+
+  /// Choose a dedicated charger for a robot from the options. Each charger
+  /// costs its travel time plus the share penalty for every robot that is
+  /// already dedicated to it. The robot replaces any charger it had before.
+  std::optional<std::size_t> assign(
+    const std::string& robot,
+    const std::vector<Option>& options);
+
+  /// Dedicate a robot to a specific charger
+  void assign(const std::string& robot, std::size_t charger);
+
+  /// Get the dedicated charger of a robot
+  std::optional<std::size_t> charger_of(const std::string& robot) const;
+
+  /// Reserve a window to charge for the given duration. The charger where the
+  /// robot can begin charging soonest is chosen. Ties are given to the
+  /// dedicated charger of the robot, and the robot becomes dedicated to the
+  /// charger that is chosen. Any earlier reservation of the robot is replaced.
+  std::optional<Reservation> reserve(
+    const std::string& robot,
+    const std::vector<Option>& options,
+    rmf_traffic::Duration duration,
+    rmf_traffic::Time now);
+
+  /// Drop the reservation of a robot, e.g. because it finished charging
+  void release(const std::string& robot);
+
+  /// Forget a robot entirely
+  void remove(const std::string& robot);
+
+  /// Get the windows that are reserved at a charger, ordered by when they
+  /// begin
+  std::vector<Window> windows(std::size_t charger) const;
+
+private:
+
+  // The earliest time at or after the given time when a charger has nothing
+  // booked for the given duration. Windows of the robot itself are ignored.
+  // Must be called while the mutex is locked.
+  rmf_traffic::Time _earliest_free(
+    std::size_t charger,
+    const std::string& robot,
+    rmf_traffic::Time time,
+    rmf_traffic::Duration duration) const;
+
+  // Must be called while the mutex is locked
+  void _release(const std::string& robot);
+
+  mutable std::mutex _mutex;
+  std::vector<std::size_t> _chargers;
+  Config _config;
+  std::unordered_map<std::string, std::size_t> _charger_of;
+  std::unordered_map<std::size_t, std::size_t> _dedicated_count;
+  std::unordered_map<std::size_t, std::vector<Window>> _windows;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_CHARGERSCHEDULER_HPP
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_ENERGYTABLE_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_ENERGYTABLE_HPP
+
+#include <rmf_battery/DevicePowerSink.hpp>
+#include <rmf_battery/MotionPowerSink.hpp>
+
+#include "internal_TravelTimeTable.hpp"
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// A table of how much battery charge a robot uses to travel between each
+/// pair of waypoints of a navigation graph. It follows the shortest paths of a
+/// TravelTimeTable. The motion sink is integrated once per lane, over a
+/// straight interpolation of the lane, and the ambient sink is applied to the
+/// travel time. Stops and turns are not accounted for, so like the travel
+/// times the values are optimistic. They can be used to rule out legs that
+/// are nowhere near the battery limits before running a full estimate.
+///
+/// Each row of the table is found the first time that it is needed, or ahead
+/// of time by precompute(). All of the functions of this class are
+/// thread-safe.
+class EnergyTable
+{
+public:
+
+  EnergyTable(
+    std::shared_ptr<const TravelTimeTable> travel_times,
+    const rmf_traffic::agv::Planner::Configuration& config,
+    std::shared_ptr<rmf_battery::MotionPowerSink> motion_sink,
+    std::shared_ptr<rmf_battery::DevicePowerSink> ambient_sink);
+
+  /// Get the fraction of the battery that is used to travel from one waypoint
+  /// to another, or a nullopt if the second waypoint cannot be reached from
+  /// the first.
+  std::optional<double> change_in_charge(
+    std::size_t from,
+    std::size_t to) const;
+
+  /// Get the fraction of the battery that is used to travel from a planner
+  /// start to a waypoint. Only the ambient drain is counted for reaching the
+  /// start waypoint from the location of the start.
+  std::optional<double> change_in_charge(
+    const rmf_traffic::agv::Planner::Start& start,
+    std::size_t to) const;
+
+  /// Find every row of the table that is not known yet
+  void precompute() const;
+
+  /// Throw away the rows of the table after the lane closures of the travel
+  /// time table have changed
+  void update_lane_closures();
+
+  /// Approximately how many bytes the rows that have been found so far are
+  /// holding
+  std::size_t approximate_bytes() const;
+
+private:
+
+  // The motion drain along the shortest path to each waypoint
+  const std::vector<double>& _row(std::size_t from) const;
+
+  std::vector<double> _search(std::size_t from) const;
+
+  std::shared_ptr<const TravelTimeTable> _travel_times;
+  std::shared_ptr<rmf_battery::DevicePowerSink> _ambient_sink;
+  std::size_t _num_waypoints;
+
+  // The motion drain of each lane and the waypoint that it starts from
+  std::vector<double> _lane_charge;
+  std::vector<std::size_t> _lane_entry;
+
+  mutable std::mutex _mutex;
+  mutable std::unordered_map<std::size_t, std::vector<double>> _rows;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_ENERGYTABLE_HPP
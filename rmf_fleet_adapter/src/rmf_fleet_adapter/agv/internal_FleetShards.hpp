@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_FLEETSHARDS_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_FLEETSHARDS_HPP
+
+#include <rmf_task_ros2/bidding/AsyncBidder.hpp>
+#include <rmf_task_ros2/bidding/Response.hpp>
+
+#include <rmf_task_msgs/msg/dispatch_command.hpp>
+
+#include <rmf_traffic/Time.hpp>
+
+#include <rclcpp/node.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Lets the robots of one fleet be spread across several adapter processes.
+/// Each process is a shard of the fleet that owns some of its robots. Only the
+/// coordinator shard takes part in the auctions of the dispatcher. It passes
+/// each bid notice on to every shard, including itself, and each shard plans
+/// the task for its own robots. The coordinator bids with the best of their
+/// proposals, and passes the dispatch commands for the task on to the shard
+/// that made it.
+class FleetShards : public std::enable_shared_from_this<FleetShards>
+{
+public:
+
+  using BidNoticeMsg = rmf_task_ros2::bidding::BidNoticeMsg;
+  using BidResponseMsg = rmf_task_ros2::bidding::BidResponseMsg;
+  using DispatchCmdMsg = rmf_task_msgs::msg::DispatchCommand;
+  using Respond = rmf_task_ros2::bidding::AsyncBidder::Respond;
+
+  struct Config
+  {
+    /// The name of the fleet that is being sharded
+    std::string fleet;
+
+    /// The name of this shard
+    std::string shard;
+
+    /// True if this shard is the coordinator
+    bool coordinator = false;
+
+    /// The names of every shard of the fleet. Only the coordinator uses this.
+    std::vector<std::string> shards;
+
+    /// How long the coordinator waits for the proposals of the shards
+    rmf_traffic::Duration bid_timeout = std::chrono::seconds(2);
+  };
+
+  using Deadline = rmf_task_ros2::bidding::AsyncBidder::Deadline;
+
+  /// Called when a bid notice reaches this shard. The deadline is when the
+  /// coordinator stops waiting for proposals.
+  using ReceiveNotice =
+    std::function<void(const BidNoticeMsg&, Deadline, Respond)>;
+
+  /// Called when a dispatch command reaches this shard. The fleet name of the
+  /// command will match the fleet if this shard should act on it.
+  using ReceiveDispatch = std::function<void(DispatchCmdMsg::SharedPtr)>;
+
+  static std::shared_ptr<FleetShards> make(
+    const std::shared_ptr<rclcpp::Node>& node,
+    Config config,
+    ReceiveNotice receive_notice,
+    ReceiveDispatch receive_dispatch);
+
+  const Config& config() const;
+
+  /// Run an auction among the shards for a notice that came from the
+  /// dispatcher. This must only be used by the coordinator.
+  void auction(const BidNoticeMsg& notice, Respond respond);
+
+  /// Pass a dispatch command from the dispatcher on to the shards. This must
+  /// only be used by the coordinator.
+  void forward(const DispatchCmdMsg& command);
+
+private:
+
+  FleetShards(Config config);
+
+  struct Auction
+  {
+    Respond respond;
+    std::vector<std::string> waiting_for;
+    std::optional<rmf_task_ros2::bidding::Response::Proposal> best;
+    std::string best_shard;
+    std::vector<std::string> errors;
+    rclcpp::TimerBase::SharedPtr timeout;
+  };
+
+  void _receive_response(const BidResponseMsg& msg);
+
+  void _conclude(const std::string& task_id);
+
+  std::weak_ptr<rclcpp::Node> _node;
+  Config _config;
+  ReceiveNotice _receive_notice;
+  ReceiveDispatch _receive_dispatch;
+
+  rclcpp::Publisher<BidNoticeMsg>::SharedPtr _notice_pub;
+  rclcpp::Publisher<BidResponseMsg>::SharedPtr _response_pub;
+  rclcpp::Publisher<DispatchCmdMsg>::SharedPtr _dispatch_pub;
+  rclcpp::Subscription<BidNoticeMsg>::SharedPtr _notice_sub;
+  rclcpp::Subscription<BidResponseMsg>::SharedPtr _response_sub;
+  rclcpp::Subscription<DispatchCmdMsg>::SharedPtr _dispatch_sub;
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, Auction> _auctions;
+
+  // The shard that won each task, so later commands for it only go there
+  std::unordered_map<std::string, std::string> _owners;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_FLEETSHARDS_HPP
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_FLEETSTATEAGGREGATOR_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_FLEETSTATEAGGREGATOR_HPP
+
+#include "internal_TimerWheel.hpp"
+
+#include <rmf_fleet_msgs/msg/fleet_state.hpp>
+#include <rmf_fleet_msgs/msg/robot_state.hpp>
+
+#include <rclcpp/publisher.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Collects the states of robots that each report themselves separately, such
+/// as traffic light robots, and publishes one FleetState message per fleet per
+/// period instead of one message per robot.
+class FleetStateAggregator
+  : public std::enable_shared_from_this<FleetStateAggregator>
+{
+public:
+
+  using FleetState = rmf_fleet_msgs::msg::FleetState;
+  using FleetStatePub = rclcpp::Publisher<FleetState>::SharedPtr;
+  using RobotState = rmf_fleet_msgs::msg::RobotState;
+
+  /// Return the current state of a robot, or std::nullopt if the robot has
+  /// nothing to report right now.
+  using Report = std::function<std::optional<RobotState>()>;
+
+  /// Create a periodic timer, or return a nullptr if that is not possible
+  using MakeTimer = std::function<TimerWheel::TimerPtr(
+      std::chrono::nanoseconds period,
+      std::function<void()> callback)>;
+
+  static std::shared_ptr<FleetStateAggregator> make(
+    FleetStatePub publisher,
+    MakeTimer make_timer);
+
+  /// A handle for a robot that is included in the fleet state of its fleet.
+  /// The robot is removed once the handle is destroyed.
+  class Registration;
+  using RegistrationPtr = std::shared_ptr<Registration>;
+
+  /// Include a robot in the fleet state of the named fleet
+  RegistrationPtr add(const std::string& fleet_name, Report report);
+
+  /// Set how often the fleet state of the named fleet is published. This is
+  /// shared by every robot of the fleet, so the last period that is set wins.
+  /// The default is 1s.
+  void set_period(
+    const std::string& fleet_name,
+    std::chrono::nanoseconds period);
+
+private:
+
+  FleetStateAggregator(FleetStatePub publisher, MakeTimer make_timer);
+
+  struct Fleet
+  {
+    std::chrono::nanoseconds period = std::chrono::seconds(1);
+    TimerWheel::TimerPtr timer;
+    std::unordered_map<uint64_t, Report> robots;
+  };
+
+  TimerWheel::TimerPtr _make_timer(
+    const std::string& fleet_name,
+    std::chrono::nanoseconds period);
+
+  void _remove(const std::string& fleet_name, uint64_t id);
+
+  void _publish(const std::string& fleet_name);
+
+  FleetStatePub _publisher;
+  MakeTimer _timer_factory;
+
+  std::mutex _mutex;
+  uint64_t _next_id = 0;
+  std::unordered_map<std::string, Fleet> _fleets;
+};
+
+//==============================================================================
+class FleetStateAggregator::Registration
+{
+public:
+
+  ~Registration();
+
+private:
+  friend class FleetStateAggregator;
+  Registration(
+    std::weak_ptr<FleetStateAggregator> aggregator,
+    std::string fleet_name,
+    uint64_t id);
+
+  std::weak_ptr<FleetStateAggregator> _aggregator;
+  std::string _fleet_name;
+  uint64_t _id;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_FLEETSTATEAGGREGATOR_HPP
@@ -43,9 +43,19 @@
 
 #include "Node.hpp"
 #include "RobotContext.hpp"
+#include "internal_ChargerScheduler.hpp"
+#include "internal_EnergyTable.hpp"
+#include "internal_FleetShards.hpp"
+#include "internal_LaneIndex.hpp"
+#include "internal_LevelPortals.hpp"
+#include "internal_LiftSessionSharing.hpp"
+#include "internal_PulloverCoordinator.hpp"
+#include "internal_TravelTimeTable.hpp"
 #include "../TaskManager.hpp"
 #include "../BroadcastClient.hpp"
 #include "../DeserializeJSON.hpp"
+#include "../MemoryUsage.hpp"
+#include "../ValidatorCache.hpp"
 
 #include <rmf_traffic/schedule/Snapshot.hpp>
 #include <rmf_traffic/agv/Interpolate.hpp>
@@ -56,6 +66,8 @@
 #include <rmf_traffic_ros2/schedule/Negotiation.hpp>
 #include <rmf_traffic_ros2/Time.hpp>
 
+#include <rmf_rxcpp/RxJobs.hpp>
+
 #include <nlohmann/json.hpp>
 #include <nlohmann/json-schema.hpp>
 #include <rmf_api_msgs/schemas/fleet_state_update.hpp>
@@ -65,9 +77,15 @@
 
 #include <rmf_fleet_adapter/schemas/event_description__perform_action.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <list>
 #include <unordered_set>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <optional>
+#include <string_view>
 
 namespace rmf_fleet_adapter {
 namespace agv {
@@ -157,6 +175,36 @@ private:
   std::function<void(const nlohmann::json_uri&, nlohmann::json&)> _loader;
 };
 
+//==============================================================================
+/// Task descriptions that recently passed schema validation, from the most to
+/// the least recently seen. Requests that are generated from the same template
+/// often repeat exactly, and validating a nested compose description costs far
+/// more than serializing it to look it up here. Only the validation is reused,
+/// because deserializing a description also asks the ConsiderRequest callbacks
+/// of the fleet, which need to see every request.
+class ValidatedDescriptions
+{
+public:
+
+  ValidatedDescriptions(std::size_t capacity);
+
+  /// Check whether this description of the category passed validation before
+  bool contains(const std::string& category, const nlohmann::json& description);
+
+  /// Remember that this description of the category passed validation
+  void insert(const std::string& category, const nlohmann::json& description);
+
+private:
+  static std::string _key(
+    const std::string& category,
+    const nlohmann::json& description);
+
+  std::size_t _capacity;
+  std::mutex _mutex;
+  std::list<std::string> _order;
+  std::unordered_map<std::string_view, std::list<std::string>::iterator> _index;
+};
+
 //==============================================================================
 /// This abstract interface class allows us to use the same implementation of
 /// FleetUpdateHandle whether we are running it in a distributed system or in a
@@ -237,6 +285,11 @@ public:
   std::shared_ptr<std::shared_ptr<const rmf_traffic::agv::Planner>> planner;
   std::shared_ptr<Node> node;
   rxcpp::schedulers::worker worker;
+  // When this is not empty, each robot is given one of these workers instead
+  // of sharing the fleet's worker. Everything for one robot still happens in
+  // order on its own worker, but different robots can run in parallel.
+  std::vector<rxcpp::schedulers::worker> robot_workers;
+  std::size_t next_robot_worker = 0;
   std::shared_ptr<ParticipantFactory> writer;
   std::shared_ptr<rmf_traffic::schedule::Snappable> snappable;
   std::shared_ptr<rmf_traffic_ros2::schedule::Negotiation> negotiation;
@@ -244,12 +297,64 @@ public:
 
   TaskActivation activation = TaskActivation();
   TaskDeserialization deserialization = TaskDeserialization();
+  mutable ValidatedDescriptions validated_descriptions =
+    ValidatedDescriptions(256);
 
   // LegacyTask planner params
   std::shared_ptr<rmf_task::CostCalculator> cost_calculator =
     rmf_task::BinaryPriorityScheme::make_cost_calculator();
   std::shared_ptr<rmf_task::Parameters> task_parameters = nullptr;
   std::shared_ptr<rmf_task::TaskPlanner> task_planner = nullptr;
+  // Travel estimates are cached per planner, so every robot of the fleet
+  // shares this one and it gets replaced whenever the planner changes.
+  std::shared_ptr<rmf_task::TravelEstimator> travel_estimator = nullptr;
+
+  // Planners that were built for recently used sets of closed lanes, from the
+  // most to the least recently used. Opening and closing the same lanes again
+  // picks up a planner whose heuristics are already warm, along with the
+  // travel estimator that was made for it.
+  struct CachedPlanner
+  {
+    std::vector<std::size_t> closed_lanes;
+    std::shared_ptr<const rmf_traffic::agv::Planner> planner;
+    std::shared_ptr<rmf_task::TravelEstimator> travel_estimator;
+  };
+  std::list<CachedPlanner> planner_cache = {};
+  std::size_t planner_cache_capacity = 8;
+
+  // The sorted lanes that are closed for the current planner. This is found by
+  // scanning the graph the first time it is needed, and kept up to date as
+  // lanes get opened and closed after that.
+  std::optional<std::vector<std::size_t>> closed_lanes = std::nullopt;
+
+  // Shortest travel times through the navigation graph under the current lane
+  // closures. This is used to rank destinations without running the planner.
+  std::shared_ptr<TravelTimeTable> travel_time_table = nullptr;
+
+  // Battery drain along the paths of the travel time table. This is made once
+  // the fleet is given the power sinks in its task planner params.
+  std::shared_ptr<EnergyTable> energy_table = nullptr;
+
+  // Spatial index of the navigation graph for localizing robots that report a
+  // map position instead of a waypoint or lane
+  std::shared_ptr<const LaneIndex> lane_index = nullptr;
+
+  // The portals of each level, when trips between levels are planned one
+  // level at a time
+  std::shared_ptr<const LevelPortals> level_portals = nullptr;
+
+  // Groups robots that ride a lift in the same direction into one session,
+  // when the lift cabins can take more than one robot
+  std::shared_ptr<LiftSessionSharing> lift_session_sharing = nullptr;
+
+  // Spreads the robots across the chargers of the fleet, and books the time
+  // that each robot spends charging
+  std::shared_ptr<ChargerScheduler> charger_scheduler = nullptr;
+
+  // How much the battery level of a robot needs to change before anything
+  // that observes it gets notified, unless the robot is given its own filter
+  double battery_soc_change_threshold = 0.0;
+  double battery_soc_hysteresis = 0.0;
 
   rmf_utils::optional<rmf_traffic::Duration> default_maximum_delay =
     std::chrono::nanoseconds(std::chrono::seconds(10));
@@ -259,16 +364,36 @@ public:
     std::shared_ptr<TaskManager>> task_managers = {};
 
   std::shared_ptr<BroadcastClient> broadcast_client = nullptr;
-  // Map uri to schema for validator loader function
-  std::unordered_map<std::string, nlohmann::json> schema_dictionary = {};
+  std::shared_ptr<ValidatorCache> validators = nullptr;
 
   rclcpp::Publisher<rmf_fleet_msgs::msg::FleetState>::SharedPtr
     fleet_state_pub = nullptr;
   rclcpp::TimerBase::SharedPtr fleet_state_topic_publish_timer = nullptr;
   rclcpp::TimerBase::SharedPtr fleet_state_update_timer = nullptr;
 
+  // The state of a robot as it was last put together for the fleet state
+  // topic and the API server
+  struct RobotStateSnapshot
+  {
+    rmf_fleet_msgs::msg::RobotState msg;
+    std::string status;
+
+    // This is only encoded when the API server needs it, and kept for as long
+    // as the state of the robot stays the same
+    std::optional<nlohmann::json> json;
+  };
+
+  // The fleet state topic and the API server updates share one snapshot of
+  // the robot states when their timers fire together
+  mutable std::mutex robot_state_snapshots_mutex;
+  mutable std::unordered_map<const RobotContext*, RobotStateSnapshot>
+  robot_state_snapshots;
+  mutable std::optional<std::chrono::steady_clock::time_point>
+  robot_state_snapshots_time;
+
   // Map task id to pair of <RequestPtr, Assignments>
   using Assignments = rmf_task::TaskPlanner::Assignments;
+  using Assignment = rmf_task::TaskPlanner::Assignment;
 
   using DockParamMap =
     std::unordered_map<
@@ -285,12 +410,87 @@ public:
   // TODO Support for various charging configurations
   std::unordered_set<std::size_t> charging_waypoints = {};
 
+  std::vector<std::size_t> parking_waypoints = {};
+  // How many of the nearest parking spots an emergency pullover gets planned
+  // towards. Zero means that every parking spot is tried.
+  std::size_t pullover_candidates = 5;
+
+  // Staggers the pullover planning of the robots when an emergency notice
+  // arrives, and keeps them from choosing the same parking spots
+  std::shared_ptr<PulloverCoordinator> pullover_coordinator = nullptr;
+
+  // How far ahead an idle robot schedules itself to stay at its waiting point
+  // instead of re-planning its wait periodically
+  std::optional<rmf_traffic::Duration> idle_wait_horizon =
+    std::chrono::minutes(10);
+
   std::shared_ptr<rmf_task_ros2::bidding::AsyncBidder> bidder = nullptr;
+  // Whether the bidder tells the dispatcher which tasks this fleet can do, so
+  // that it only gets the bid notices for those
+  bool advertise_capabilities = false;
+
+  // Only used when the robots of this fleet are spread across several adapter
+  // processes
+  std::shared_ptr<FleetShards> shards = nullptr;
 
   double current_assignment_cost = 0.0;
+  // The average cost per task of the last full allocation. Incremental
+  // allocations are measured against this to decide when the whole fleet needs
+  // to be planned again.
+  std::optional<double> allocation_cost_per_task = std::nullopt;
+  // How far above that average an incremental allocation may go, as a fraction
+  // of it. A negative value turns incremental allocation off.
+  double incremental_allocation_threshold = 0.1;
   // Map to store task id with assignments for BidNotice
   std::unordered_map<std::string, Assignments> bid_notice_assignments = {};
 
+  // The task planning for each bid notice that is still being worked on.
+  // Auctions may overlap, so each one gets its own job. Erasing an entry will
+  // cancel its planning if it has not finished yet.
+  struct BidAllocation;
+  struct BidJob
+  {
+    std::shared_ptr<BidAllocation> allocation;
+    rmf_rxcpp::subscription_guard subscription;
+  };
+  std::unordered_map<std::string, BidJob> bid_allocations = {};
+  // A running average of how long the planning for a bid takes. A notice
+  // whose auction closes sooner than this gets declined right away.
+  std::optional<rmf_traffic::Duration> bid_evaluation_estimate = std::nullopt;
+
+  // Decides how much planning a bid notice gets from how busy the adapter
+  // already is. The load is the number of bids that are still being planned
+  // plus the planning slices that are waiting for a thread of the pool.
+  struct BidAdmission
+  {
+    enum class Decision
+    {
+      /// Plan the bid as usual
+      Full,
+
+      /// Only try to insert the task into the current queues
+      Approximate,
+
+      /// Decline the bid without planning it
+      Decline
+    };
+
+    /// The load at which bids become approximate. Zero means never.
+    std::size_t approximate_load = 0;
+
+    /// The load at which bids get declined. Zero means never.
+    std::size_t decline_load = 0;
+
+    /// How many bid notices got each decision, for tuning the thresholds
+    std::size_t full = 0;
+    std::size_t approximate = 0;
+    std::size_t declined = 0;
+
+    /// The decision that was made for the latest bid notice
+    Decision last = Decision::Full;
+  };
+  BidAdmission bid_admission;
+
   using BidNoticeMsg = rmf_task_msgs::msg::BidNotice;
 
   using DispatchCmdMsg = rmf_task_msgs::msg::DispatchCommand;
@@ -305,6 +505,14 @@ public:
   using DockSummarySub = rclcpp::Subscription<DockSummary>::SharedPtr;
   DockSummarySub dock_summary_sub = nullptr;
 
+  // Task API requests are parsed once here and then handed only to the task
+  // managers that they concern
+  rmf_rxcpp::subscription_guard task_api_request_sub;
+
+  // The task manager that was last found to hold each task that an API
+  // request has referred to
+  std::unordered_map<std::string, std::weak_ptr<TaskManager>> task_owners = {};
+
   template<typename... Args>
   static std::shared_ptr<FleetUpdateHandle> make(Args&& ... args)
   {
@@ -314,6 +522,12 @@ public:
 
     handle->_pimpl->add_standard_tasks();
 
+    handle->_pimpl->travel_time_table = std::make_shared<TravelTimeTable>(
+      (*handle->_pimpl->planner)->get_configuration());
+
+    handle->_pimpl->lane_index = std::make_shared<LaneIndex>(
+      (*handle->_pimpl->planner)->get_configuration().graph());
+
     // TODO(MXG): This is a very crude implementation. We create a dummy set of
     // task planner parameters to stand in until the user sets the task planner
     // parameters. We'll distribute this shared_ptr to the robot contexts and
@@ -343,8 +557,28 @@ public:
       reliable_transient_qos,
       [w = handle->weak_from_this()](const DispatchCmdMsg::SharedPtr msg)
       {
-        if (const auto self = w.lock())
-          self->_pimpl->dispatch_command_cb(msg);
+        const auto self = w.lock();
+        if (!self)
+          return;
+
+        // The commands of a sharded fleet reach the shards through the
+        // coordinator, which knows which shard owns each task.
+        if (const auto& shards = self->_pimpl->shards)
+        {
+          if (shards->config().coordinator)
+            shards->forward(*msg);
+
+          return;
+        }
+
+        // Bid results are saved on the worker, so dispatch commands need to
+        // be handled there too.
+        self->_pimpl->worker.schedule(
+          [w, msg](const auto&)
+          {
+            if (const auto self = w.lock())
+              self->_pimpl->dispatch_command_cb(msg);
+          });
       });
 
     // Publish DispatchAck
@@ -352,16 +586,6 @@ public:
       handle->_pimpl->node->create_publisher<DispatchAck>(
       DispatchAckTopicName, reliable_transient_qos);
 
-    // Make a dispatch bidder
-    handle->_pimpl->bidder = rmf_task_ros2::bidding::AsyncBidder::make(
-      handle->_pimpl->node,
-      [w = handle->weak_from_this()](
-        const auto& msg, auto respond)
-      {
-        if (const auto self = w.lock())
-          self->_pimpl->bid_notice_cb(msg, std::move(respond));
-      });
-
     // Subscribe DockSummary
     handle->_pimpl->dock_summary_sub =
       handle->_pimpl->node->create_subscription<DockSummary>(
@@ -373,34 +597,293 @@ public:
           self->_pimpl->dock_summary_cb(msg);
       });
 
+    // Subscribe to task API requests
+    handle->_pimpl->task_api_request_sub =
+      handle->_pimpl->node->task_api_request()
+      .observe_on(rxcpp::identity_same_worker(handle->_pimpl->worker))
+      .subscribe(
+      [w = handle->weak_from_this()](
+        const rmf_task_msgs::msg::ApiRequest::SharedPtr& request)
+      {
+        if (const auto self = w.lock())
+          self->_pimpl->route_api_request(*request);
+      });
+
     // Populate charging waypoints
     const auto& graph = (*handle->_pimpl->planner)->get_configuration().graph();
     for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
     {
       if (graph.get_waypoint(i).is_charger())
         handle->_pimpl->charging_waypoints.insert(i);
+
+      if (graph.get_waypoint(i).is_parking_spot())
+        handle->_pimpl->parking_waypoints.push_back(i);
     }
 
-    // Initialize schema dictionary
-    auto schema = rmf_api_msgs::schemas::fleet_state_update;
-    nlohmann::json_uri json_uri = nlohmann::json_uri{schema["$id"]};
-    handle->_pimpl->schema_dictionary.insert({json_uri.url(), schema});
-    schema = rmf_api_msgs::schemas::fleet_state;
-    json_uri = nlohmann::json_uri{schema["$id"]};
-    handle->_pimpl->schema_dictionary.insert({json_uri.url(), schema});
-    schema = rmf_api_msgs::schemas::robot_state;
-    json_uri = nlohmann::json_uri{schema["$id"]};
-    handle->_pimpl->schema_dictionary.insert({json_uri.url(), schema});
-    schema = rmf_api_msgs::schemas::location_2D;
-    json_uri = nlohmann::json_uri{schema["$id"]};
-    handle->_pimpl->schema_dictionary.insert({json_uri.url(), schema});
+    // The schemas themselves come from the process-wide SchemaRegistry
+    handle->_pimpl->validators = std::make_shared<ValidatorCache>(
+      ValidatorCache::get_settings(*handle->_pimpl->node));
+
+    // Several fleets may share one node, so the parameter only gets declared
+    // once.
+    {
+      auto& node = *handle->_pimpl->node;
+      const std::string threshold_param = "incremental_allocation_threshold";
+      if (!node.has_parameter(threshold_param))
+        node.declare_parameter<double>(threshold_param, 0.1);
+
+      handle->_pimpl->incremental_allocation_threshold =
+        node.get_parameter(threshold_param).as_double();
+
+      const std::string approximate_param = "bid_approximate_load";
+      if (!node.has_parameter(approximate_param))
+        node.declare_parameter<int64_t>(approximate_param, 0);
+
+      handle->_pimpl->bid_admission.approximate_load =
+        static_cast<std::size_t>(std::max<int64_t>(
+          0, node.get_parameter(approximate_param).as_int()));
+
+      const std::string decline_param = "bid_decline_load";
+      if (!node.has_parameter(decline_param))
+        node.declare_parameter<int64_t>(decline_param, 0);
+
+      handle->_pimpl->bid_admission.decline_load =
+        static_cast<std::size_t>(std::max<int64_t>(
+          0, node.get_parameter(decline_param).as_int()));
+
+      const std::string pullover_param = "emergency_pullover_candidates";
+      if (!node.has_parameter(pullover_param))
+        node.declare_parameter<int64_t>(pullover_param, 5);
+
+      handle->_pimpl->pullover_candidates = static_cast<std::size_t>(
+        std::max<int64_t>(0, node.get_parameter(pullover_param).as_int()));
+
+      const std::string concurrency_param = "emergency_pullover_concurrency";
+      if (!node.has_parameter(concurrency_param))
+        node.declare_parameter<int64_t>(concurrency_param, 4);
+
+      // A capacity of one keeps each robot in a lift session of its own
+      const std::string lift_capacity_param = "lift_share_capacity";
+      if (!node.has_parameter(lift_capacity_param))
+        node.declare_parameter<int64_t>(lift_capacity_param, 1);
+
+      const std::string lift_area_param = "lift_share_cabin_area";
+      if (!node.has_parameter(lift_area_param))
+        node.declare_parameter<double>(lift_area_param, 0.0);
+
+      const std::string lift_window_param = "lift_share_boarding_window";
+      if (!node.has_parameter(lift_window_param))
+        node.declare_parameter<double>(lift_window_param, 10.0);
+
+      const std::string lift_grace_param = "lift_share_boarding_grace";
+      if (!node.has_parameter(lift_grace_param))
+        node.declare_parameter<double>(lift_grace_param, 30.0);
+
+      LiftSessionSharing::Config lift_sharing;
+      lift_sharing.capacity = static_cast<std::size_t>(std::max<int64_t>(
+        0, node.get_parameter(lift_capacity_param).as_int()));
+      lift_sharing.cabin_area = node.get_parameter(lift_area_param).as_double();
+      lift_sharing.boarding_window = rmf_traffic::time::from_seconds(
+        node.get_parameter(lift_window_param).as_double());
+      lift_sharing.boarding_grace = rmf_traffic::time::from_seconds(
+        node.get_parameter(lift_grace_param).as_double());
+      if (lift_sharing.capacity > 1)
+      {
+        handle->_pimpl->lift_session_sharing =
+          std::make_shared<LiftSessionSharing>(
+          handle->_pimpl->name, lift_sharing);
+      }
+
+      // A share penalty of zero gives every robot its nearest charger
+      const std::string charger_penalty_param = "charger_share_penalty";
+      if (!node.has_parameter(charger_penalty_param))
+        node.declare_parameter<double>(charger_penalty_param, 0.0);
+
+      ChargerScheduler::Config charger_config;
+      charger_config.share_penalty = std::max(
+        0.0, node.get_parameter(charger_penalty_param).as_double());
+      handle->_pimpl->charger_scheduler = std::make_shared<ChargerScheduler>(
+        std::vector<std::size_t>(
+          handle->_pimpl->charging_waypoints.begin(),
+          handle->_pimpl->charging_waypoints.end()),
+        charger_config);
+
+      // Battery drivers often report noisy readings many times per second, so
+      // small changes in the battery level can be held back from observers.
+      const std::string soc_threshold_param = "battery_soc_change_threshold";
+      if (!node.has_parameter(soc_threshold_param))
+        node.declare_parameter<double>(soc_threshold_param, 0.0);
+
+      const std::string soc_hysteresis_param = "battery_soc_hysteresis";
+      if (!node.has_parameter(soc_hysteresis_param))
+        node.declare_parameter<double>(soc_hysteresis_param, 0.0);
+
+      handle->_pimpl->battery_soc_change_threshold = std::max(
+        0.0, node.get_parameter(soc_threshold_param).as_double());
+      handle->_pimpl->battery_soc_hysteresis = std::max(
+        0.0, node.get_parameter(soc_hysteresis_param).as_double());
+
+      // Planning one level at a time makes robots stop briefly after each
+      // lift ride, so it is only done when asked for.
+      const std::string levels_param = "plan_levels_separately";
+      if (!node.has_parameter(levels_param))
+        node.declare_parameter<bool>(levels_param, false);
+
+      if (node.get_parameter(levels_param).as_bool())
+      {
+        auto portals = std::make_shared<LevelPortals>(
+          (*handle->_pimpl->planner)->get_configuration().graph(),
+          handle->_pimpl->travel_time_table);
+
+        if (!portals->portals().empty())
+          handle->_pimpl->level_portals = std::move(portals);
+      }
+
+      handle->_pimpl->pullover_coordinator = PulloverCoordinator::make(
+        static_cast<std::size_t>(std::max<int64_t>(
+          0, node.get_parameter(concurrency_param).as_int())));
+
+      // A horizon of zero restores the periodic re-planning of idle robots
+      const std::string idle_param = "idle_wait_horizon";
+      if (!node.has_parameter(idle_param))
+        node.declare_parameter<double>(idle_param, 600.0);
+
+      const double idle_horizon = node.get_parameter(idle_param).as_double();
+      if (idle_horizon > 0.0)
+      {
+        handle->_pimpl->idle_wait_horizon =
+          rmf_traffic::time::from_seconds(idle_horizon);
+      }
+      else
+      {
+        handle->_pimpl->idle_wait_horizon = std::nullopt;
+      }
+
+      // A fleet whose robots are spread across several adapter processes
+      // gives each process the name of its own shard
+      const std::string shard_param = "fleet_shard";
+      if (!node.has_parameter(shard_param))
+        node.declare_parameter<std::string>(shard_param, "");
+
+      const std::string coordinator_param = "fleet_shard_coordinator";
+      if (!node.has_parameter(coordinator_param))
+        node.declare_parameter<bool>(coordinator_param, false);
+
+      const std::string all_shards_param = "fleet_shards";
+      if (!node.has_parameter(all_shards_param))
+      {
+        node.declare_parameter<std::vector<std::string>>(
+          all_shards_param, std::vector<std::string>());
+      }
+
+      // Only a dispatcher that knows about capabilities will send notices to
+      // a fleet that advertises them, so this is off by default.
+      const std::string capabilities_param = "advertise_bid_capabilities";
+      if (!node.has_parameter(capabilities_param))
+        node.declare_parameter<bool>(capabilities_param, false);
+
+      handle->_pimpl->advertise_capabilities =
+        node.get_parameter(capabilities_param).as_bool();
+
+      const std::string shard_timeout_param = "fleet_shard_bid_timeout";
+      if (!node.has_parameter(shard_timeout_param))
+        node.declare_parameter<double>(shard_timeout_param, 2.0);
+
+      const auto shard = node.get_parameter(shard_param).as_string();
+      if (!shard.empty())
+      {
+        FleetShards::Config config;
+        config.fleet = handle->_pimpl->name;
+        config.shard = shard;
+        config.coordinator = node.get_parameter(coordinator_param).as_bool();
+        config.shards = node.get_parameter(all_shards_param).as_string_array();
+        config.bid_timeout = rmf_traffic::time::from_seconds(
+          node.get_parameter(shard_timeout_param).as_double());
+
+        handle->_pimpl->shards = FleetShards::make(
+          handle->_pimpl->node,
+          std::move(config),
+          [w = handle->weak_from_this()](
+            const auto& msg, auto deadline, auto respond)
+          {
+            const auto self = w.lock();
+            if (!self)
+              return;
+
+            self->_pimpl->worker.schedule(
+              [w, msg, deadline, respond = std::move(respond)](const auto&)
+              {
+                if (const auto self = w.lock())
+                  self->_pimpl->bid_notice_cb(msg, deadline, respond);
+              });
+          },
+          [w = handle->weak_from_this()](const DispatchCmdMsg::SharedPtr msg)
+          {
+            const auto self = w.lock();
+            if (!self)
+              return;
+
+            self->_pimpl->worker.schedule(
+              [w, msg](const auto&)
+              {
+                if (const auto self = w.lock())
+                  self->_pimpl->dispatch_command_cb(msg);
+              });
+          });
+      }
+    }
+
+    // Make a dispatch bidder. Only the coordinator of a sharded fleet bids,
+    // using the best proposal from all of the shards. The other shards must
+    // not subscribe to the bid notices, or the auctioneer would keep waiting
+    // for bids that never come.
+    const auto& fleet_shards = handle->_pimpl->shards;
+    if (!fleet_shards || fleet_shards->config().coordinator)
+    {
+      handle->_pimpl->bidder = rmf_task_ros2::bidding::AsyncBidder::make(
+        handle->_pimpl->node,
+        [w = handle->weak_from_this()](
+          const auto& msg, auto deadline, auto respond)
+        {
+          const auto self = w.lock();
+          if (!self)
+            return;
+
+          if (const auto& shards = self->_pimpl->shards)
+          {
+            shards->auction(msg, std::move(respond));
+            return;
+          }
+
+          self->_pimpl->worker.schedule(
+            [w, msg, deadline, respond = std::move(respond)](const auto&)
+            {
+              if (const auto self = w.lock())
+                self->_pimpl->bid_notice_cb(msg, deadline, respond);
+            });
+        });
+    }
 
     // Start the BroadcastClient
     if (handle->_pimpl->server_uri.has_value())
     {
+      // Let the server choose a compact encoding and batched frames for the
+      // messages that get broadcast to it. Several fleets may share one node,
+      // so the parameters only get declared once.
+      auto& node = *handle->_pimpl->node;
+      const std::string compact_param = "server_compact_encoding";
+      if (!node.has_parameter(compact_param))
+        node.declare_parameter<bool>(compact_param, false);
+
+      const std::string batch_param = "server_batch_messages";
+      if (!node.has_parameter(batch_param))
+        node.declare_parameter<bool>(batch_param, false);
+
       handle->_pimpl->broadcast_client = BroadcastClient::make(
         handle->_pimpl->server_uri.value(),
-        handle->weak_from_this());
+        handle->weak_from_this(),
+        node.get_parameter(compact_param).as_bool(),
+        node.get_parameter(batch_param).as_bool());
     }
 
     // Add PerformAction event to deserialization
@@ -480,6 +963,8 @@ public:
     handle->_pimpl->deserialization.event->add(
       "perform_action", validator, deserializer);
 
+    handle->_pimpl->advertise_bid_capabilities();
+
     return handle;
   }
 
@@ -487,17 +972,50 @@ public:
 
   void bid_notice_cb(
     const BidNoticeMsg& msg,
+    rmf_task_ros2::bidding::AsyncBidder::Deadline deadline,
     rmf_task_ros2::bidding::AsyncBidder::Respond respond);
 
+  /// Tell the dispatcher which task categories and actions this fleet will
+  /// consider, if that is enabled. This needs to be called again whenever
+  /// they change.
+  void advertise_bid_capabilities();
+
+  /// Decide how much planning the next bid notice should get
+  BidAdmission::Decision admit_bid(const std::string& task_id);
+
+  /// Submit a proposal for a bid notice once its allocation is finished
+  void respond_to_bid(
+    const std::string& task_id,
+    const std::vector<std::string>& robot_names,
+    std::optional<Assignments> allocation,
+    std::vector<std::string> errors,
+    const rmf_task_ros2::bidding::AsyncBidder::Respond& respond);
+
   void dispatch_command_cb(const DispatchCmdMsg::SharedPtr msg);
 
+  /// Parse a task API request and pass it to the task managers of the robots
+  /// that it concerns
+  void route_api_request(const rmf_task_msgs::msg::ApiRequest& request);
+
+  /// Find the task manager that holds a task, or nullptr if none of them do
+  std::shared_ptr<TaskManager> find_task_owner(const std::string& task_id);
+
   std::optional<std::size_t> get_nearest_charger(
     const rmf_traffic::agv::Planner::Start& start);
 
+  /// Choose the dedicated charger of a new robot. The charger scheduler may
+  /// pick a charger that is further away than the nearest one so that robots
+  /// are spread across the chargers.
+  std::optional<std::size_t> assign_charger(
+    const std::string& robot,
+    const rmf_traffic::agv::Planner::Start& start);
+
   struct Expectations
   {
     std::vector<rmf_task::State> states;
     std::vector<rmf_task::ConstRequestPtr> pending_requests;
+    // The current queue of each robot, including automatic tasks, in order
+    std::vector<std::vector<rmf_task::ConstRequestPtr>> queues;
   };
 
   Expectations aggregate_expectations() const;
@@ -510,8 +1028,122 @@ public:
     std::vector<std::string>* errors = nullptr,
     std::optional<Expectations> expectations = std::nullopt) const;
 
+  /// The planning step of allocate_tasks(~). This does not touch any fleet
+  /// state, so it can be run away from the worker.
+  static std::optional<Assignments> plan_assignments(
+    const std::shared_ptr<const rmf_task::TaskPlanner>& planner,
+    const std::shared_ptr<Node>& node,
+    const Expectations& expect,
+    const std::string& id,
+    std::vector<std::string>* errors);
+
+  /// Estimate a queue of requests for one robot, one after another, starting
+  /// from the given state. Returns std::nullopt if any of them is infeasible,
+  /// e.g. because the robot would need to charge first.
+  static std::optional<std::vector<Assignment>> estimate_queue(
+    const rmf_task::TaskPlanner& planner,
+    rmf_task::State start,
+    const std::vector<rmf_task::ConstRequestPtr>& requests,
+    rmf_task::TravelEstimator& estimator);
+
+  /// Find the cheapest place in the current queues to insert a new request,
+  /// without changing the order of anything that is already queued.
+  static std::optional<Assignments> insert_request(
+    const rmf_task::TaskPlanner& planner,
+    const Expectations& expect,
+    const rmf_task::ConstRequestPtr& request);
+
+  /// Check whether a set of assignments that was not made by a full
+  /// allocation is still close enough to the cost of one.
+  static bool within_cost_threshold(
+    const rmf_task::TaskPlanner& planner,
+    const Assignments& assignments,
+    std::optional<double> cost_per_task,
+    double threshold);
+
+  /// Re-estimate the queue of one robot after a task was removed from it,
+  /// leaving the queues of the other robots alone. Returns std::nullopt if
+  /// the whole fleet should be planned again instead.
+  std::optional<Assignments> repair_assignments(std::size_t robot_index) const;
+
+  /// Remember the cost of a full allocation for within_cost_threshold(~)
+  void record_full_allocation(const Assignments& assignments);
+
+  /// Allocates a bid notice as an rxcpp job. An insertion into the current
+  /// queues is tried first, and plan_assignments(~) is used when that fails
+  /// or costs too much. An approximate allocation only tries the insertion.
+  struct BidAllocation
+  {
+    struct Result
+    {
+      std::optional<Assignments> assignments;
+      std::vector<std::string> errors;
+      bool incremental = false;
+    };
+
+    std::shared_ptr<const rmf_task::TaskPlanner> planner;
+    std::shared_ptr<Node> node;
+    Expectations expectations;
+    rmf_task::ConstRequestPtr request;
+    std::optional<double> cost_per_task;
+    double threshold;
+    bool approximate = false;
+
+    template<typename Subscriber>
+    void operator()(const Subscriber& s)
+    {
+      Result result;
+      if (approximate)
+      {
+        result.assignments = insert_request(*planner, expectations, request);
+        result.incremental = true;
+        if (!result.assignments.has_value())
+        {
+          result.errors.push_back(
+            make_error_str(
+              12, "Busy",
+              "The fleet is too busy to plan the task in full, and it does "
+              "not fit into the current queues"));
+        }
+
+        s.on_next(std::move(result));
+        s.on_completed();
+        return;
+      }
+
+      if (cost_per_task.has_value() && threshold >= 0.0)
+      {
+        auto inserted = insert_request(*planner, expectations, request);
+        if (inserted.has_value() && within_cost_threshold(
+            *planner, *inserted, cost_per_task, threshold))
+        {
+          result.assignments = std::move(inserted);
+          result.incremental = true;
+          s.on_next(std::move(result));
+          s.on_completed();
+          return;
+        }
+      }
+
+      auto expect = expectations;
+      expect.pending_requests.push_back(request);
+      RCLCPP_INFO(
+        node->get_logger(),
+        "Planning for [%ld] robot(s) and [%ld] request(s)",
+        expect.states.size(),
+        expect.pending_requests.size());
+
+      result.assignments = plan_assignments(
+        planner, node, expect, request->booking()->id(), &result.errors);
+
+      s.on_next(std::move(result));
+      s.on_completed();
+    }
+  };
+
   /// Helper function to check if assignments are valid. An assignment set is
-  /// invalid if one of the assignments has already begun execution.
+  /// invalid if one of the assignments has already begun execution, or if it
+  /// is missing a request that has been queued since it was planned.
   bool is_valid_assignments(Assignments& assignments) const;
 
   static Implementation& get(FleetUpdateHandle& fleet)
@@ -524,14 +1156,73 @@ public:
     return *fleet._pimpl;
   }
 
+  /// Get the robot states, taking a new snapshot of them unless the last one
+  /// was just taken. robot_state_snapshots_mutex must be locked.
+  std::unordered_map<const RobotContext*, RobotStateSnapshot>&
+  refresh_robot_state_snapshots() const;
+
   void publish_fleet_state_topic() const;
 
   void update_fleet_state() const;
 
   void add_standard_tasks();
 
-  std::string make_error_str(
-    uint64_t code, std::string category, std::string detail) const;
+  /// Make a new travel estimator for the current planner, hand it to each
+  /// robot, and prewarm it with the journey of each robot to its charger.
+  void update_travel_estimator(bool prewarm = true);
+
+  /// Get the sorted lanes that are closed for the current planner
+  const std::vector<std::size_t>& current_closed_lanes();
+
+  /// Switch to a planner for the given lane closures, reusing a cached one if
+  /// the same set of lanes has been closed recently. The closed lanes must be
+  /// the sorted lanes that are closed in the closures.
+  void set_lane_closures(
+    rmf_traffic::agv::LaneClosure closures,
+    std::vector<std::size_t> closed);
+
+  /// Warm up the heuristics of a newly built planner with the journey of each
+  /// robot to its charger, using the background priority of the planning
+  /// pool. Returns false if there is no planning pool to do this on.
+  bool warm_up_planner(
+    const std::shared_ptr<const rmf_traffic::agv::Planner>& new_planner) const;
+
+  /// Fill in the whole travel time table and the nearest parking spots of
+  /// every waypoint ahead of time, using the background priority of the
+  /// planning pool if there is one, or the fleet worker if there is not.
+  void precompute_travel_times() const;
+
+  /// Write what this fleet has learned about planning on its graph to a file,
+  /// so that a restarted adapter does not begin with a cold planner: the rows
+  /// of the travel time table, and the legs that the robots have planned for.
+  void save_planning_cache(const std::string& file) const;
+
+  /// Read a file that was written by save_planning_cache(~). The travel time
+  /// rows are put into the table, and each leg is planned once in the
+  /// background to fill in the caches of the planner. Nothing is used if the
+  /// file was written for a different graph or vehicle.
+  void load_planning_cache(const std::string& file);
+
+  /// Approximate how much memory this fleet is holding on to for the tables,
+  /// queues and snapshots that its robots share
+  MemoryUsage memory_usage() const;
+
+  /// Approximate how much memory each robot of this fleet is holding on to,
+  /// keyed by the name of the robot. This must be called on the worker of the
+  /// fleet. The robots that share that worker get measured right away, and
+  /// the robots that have workers of their own get measured on them, so their
+  /// usage arrives later through the future.
+  std::vector<std::pair<std::string, std::future<MemoryUsage>>>
+  robot_memory_usage() const;
+
+  /// Make a new energy table for the given power sinks, hand it to each
+  /// robot, and fill it in ahead of time like precompute_travel_times().
+  void update_energy_table(
+    std::shared_ptr<rmf_battery::MotionPowerSink> motion_sink,
+    std::shared_ptr<rmf_battery::DevicePowerSink> ambient_sink);
+
+  static std::string make_error_str(
+    uint64_t code, std::string category, std::string detail);
 
   std::shared_ptr<rmf_task::Request> convert(
     const std::string& task_id,
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_KEYEDDEMULTIPLEXER_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_KEYEDDEMULTIPLEXER_HPP
+
+#include <rmf_rxcpp/RxJobs.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Splits one stream of messages into a separate stream for each key, such as
+/// the name of a door or lift. Each message is looked up once in a hash map
+/// and only passed to the observers of its own key, so phases that wait on a
+/// single device do not get woken up by the states of every other device.
+template<typename Message>
+class KeyedDemultiplexer
+{
+public:
+
+  using MessagePtr = typename Message::SharedPtr;
+  using Observable = rxcpp::observable<MessagePtr>;
+  using GetKey = std::function<const std::string&(const Message&)>;
+
+  static std::shared_ptr<KeyedDemultiplexer> make(
+    const Observable& source,
+    GetKey get_key)
+  {
+    auto demux = std::shared_ptr<KeyedDemultiplexer>(
+      new KeyedDemultiplexer(std::move(get_key)));
+
+    demux->_subscription = source.subscribe(
+      [w = std::weak_ptr<KeyedDemultiplexer>(demux)](const MessagePtr& msg)
+      {
+        if (const auto self = w.lock())
+          self->_deliver(msg);
+      });
+
+    return demux;
+  }
+
+  /// Get the stream of messages whose key matches
+  Observable observe(const std::string& key)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _subjects[key].get_observable();
+  }
+
+private:
+
+  KeyedDemultiplexer(GetKey get_key)
+  : _get_key(std::move(get_key))
+  {
+    // Do nothing
+  }
+
+  void _deliver(const MessagePtr& msg)
+  {
+    if (!msg)
+      return;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    const auto it = _subjects.find(_get_key(*msg));
+    if (it == _subjects.end())
+      return;
+
+    auto subscriber = it->second.get_subscriber();
+    lock.unlock();
+
+    subscriber.on_next(msg);
+  }
+
+  GetKey _get_key;
+  std::mutex _mutex;
+  std::unordered_map<std::string, rxcpp::subjects::subject<MessagePtr>>
+  _subjects;
+  rmf_rxcpp::subscription_guard _subscription;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_KEYEDDEMULTIPLEXER_HPP
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LANEINDEX_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LANEINDEX_HPP
+
+#include <rmf_traffic/agv/Planner.hpp>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// A spatial index of the waypoints and lanes of a navigation graph. Each map
+/// gets a uniform grid, and every waypoint and lane is put in the cells that it
+/// overlaps, so finding what is near a location only looks at a few cells
+/// instead of scanning the whole graph.
+///
+/// The index only depends on where the waypoints are, so it can be built once
+/// when the graph is loaded and kept as lanes get opened and closed. All of the
+/// functions of this class are const, so it can be shared between threads.
+class LaneIndex
+{
+public:
+
+  LaneIndex(const rmf_traffic::agv::Graph& graph, double cell_size = 5.0);
+
+  /// Find where a robot could start planning from, using the same rules as
+  /// rmf_traffic::agv::compute_plan_starts: The first waypoint closer than
+  /// max_merge_waypoint_distance is used if there is one. Otherwise there is
+  /// a start for every lane that the robot lies along, within
+  /// max_merge_lane_distance of it.
+  std::vector<rmf_traffic::agv::Plan::Start> compute_plan_starts(
+    const std::string& map_name,
+    const Eigen::Vector3d& pose,
+    rmf_traffic::Time start_time,
+    double max_merge_waypoint_distance = 0.1,
+    double max_merge_lane_distance = 1.0,
+    double min_lane_length = 1e-8) const;
+
+  struct Nearest
+  {
+    std::size_t waypoint;
+    double distance;
+  };
+
+  /// Find the waypoint on a map that is nearest to a location
+  std::optional<Nearest> nearest_waypoint(
+    const std::string& map_name,
+    const Eigen::Vector2d& location) const;
+
+private:
+
+  struct CellKey
+  {
+    int64_t x;
+    int64_t y;
+
+    bool operator==(const CellKey& other) const
+    {
+      return x == other.x && y == other.y;
+    }
+  };
+
+  struct CellHash
+  {
+    std::size_t operator()(const CellKey& key) const
+    {
+      return std::hash<int64_t>()(key.x) ^ (std::hash<int64_t>()(key.y) << 1);
+    }
+  };
+
+  struct Cell
+  {
+    std::vector<std::size_t> waypoints;
+    std::vector<std::size_t> lanes;
+  };
+
+  struct Map
+  {
+    std::unordered_map<CellKey, Cell, CellHash> cells;
+
+    // The range of cells that contain any waypoints
+    int64_t min_x = 0;
+    int64_t min_y = 0;
+    int64_t max_x = 0;
+    int64_t max_y = 0;
+  };
+
+  struct Lane
+  {
+    Eigen::Vector2d entry;
+    Eigen::Vector2d exit;
+    std::size_t exit_waypoint;
+  };
+
+  CellKey _key(const Eigen::Vector2d& p) const;
+
+  template<typename F>
+  void _for_each_cell(
+    const Map& map,
+    const Eigen::Vector2d& p,
+    double radius,
+    F&& f) const;
+
+  double _cell_size;
+  std::vector<Eigen::Vector2d> _waypoints;
+  std::vector<Lane> _lanes;
+  std::unordered_map<std::string, Map> _maps;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LANEINDEX_HPP
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LEVELPORTALS_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LEVELPORTALS_HPP
+
+#include "internal_TravelTimeTable.hpp"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// An abstract layer over a navigation graph with several levels. Its nodes
+/// are the portals of each level, which are the waypoints where a robot ends
+/// up after it leaves a lift, and the cost between two portals is their travel
+/// time. The travel time table holds the shortest path over the whole graph,
+/// so the route between levels is read from it instead of being planned.
+///
+/// A trip that changes levels can then be planned one level at a time: first
+/// to the portal where the route leaves the lift on the next level, and from
+/// there onwards. Each of those searches only needs to cover one level and
+/// one lift ride, instead of every level that the route might pass through.
+class LevelPortals
+{
+public:
+
+  LevelPortals(
+    const rmf_traffic::agv::Graph& graph,
+    std::shared_ptr<const TravelTimeTable> travel_times);
+
+  /// Get the waypoints that are portals, in increasing order
+  const std::vector<std::size_t>& portals() const;
+
+  /// Get the travel time, in seconds, between two portals
+  std::optional<double> cost(std::size_t from_portal, std::size_t to_portal)
+  const;
+
+  /// Get the first portal that the route from the start to the goal passes
+  /// through on a level other than the level of the start. This is a nullopt
+  /// if the route does not change levels, or if that portal is the goal.
+  std::optional<std::size_t> next_portal(
+    const rmf_traffic::agv::Planner::Start& start,
+    std::size_t goal) const;
+
+private:
+  rmf_traffic::agv::Graph _graph;
+  std::shared_ptr<const TravelTimeTable> _travel_times;
+  std::vector<std::size_t> _portals;
+  std::vector<bool> _is_portal;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LEVELPORTALS_HPP
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LIFTSESSIONSHARING_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LIFTSESSIONSHARING_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Lets the robots of a fleet share a ride in a lift. Robots that call the
+/// same lift to the same floor, and that will ride it to the same floor, are
+/// put into one ride as long as they fit in the cabin. Every robot of a ride
+/// uses the same session with the lift, so the lift carries them all at once
+/// instead of serving them one session at a time.
+///
+/// A ride takes on more robots for a boarding window after the first robot
+/// joins it, or until it is full. Once it stops taking on robots it leaves as
+/// soon as every robot of the ride is in the cabin. A robot that takes too
+/// long to board gets dropped from the ride and uses a session of its own.
+/// The session is ended once the last robot of the ride is done with it.
+///
+/// All of the functions of this class are thread-safe.
+class LiftSessionSharing
+{
+public:
+
+  struct Config
+  {
+    /// How many robots may share one ride. A value of one or less means that
+    /// robots never share a ride.
+    std::size_t capacity = 1;
+
+    /// The floor area of the lift cabin in square meters. The footprints of
+    /// the robots of a ride need to fit in it. Zero means no limit.
+    double cabin_area = 0.0;
+
+    /// How long a ride takes on more robots after its first robot joins
+    rmf_traffic::Duration boarding_window = std::chrono::seconds(10);
+
+    /// How long a ride that has stopped taking on robots waits for the robots
+    /// that joined it to board
+    rmf_traffic::Duration boarding_grace = std::chrono::seconds(30);
+  };
+
+  LiftSessionSharing(std::string fleet_name, Config config);
+
+  /// Get the configuration of this sharing
+  const Config& config() const;
+
+  /// Join a ride before calling the lift. The session that the robot should
+  /// use with the lift is returned. If the robot already has a ride with this
+  /// lift then the session of that ride is returned.
+  ///
+  /// \param[in] footprint_area
+  ///   The area that the robot takes up in the cabin, in square meters
+  std::string join(
+    const std::string& lift,
+    const std::string& from_floor,
+    const std::string& to_floor,
+    const std::string& requester_id,
+    double footprint_area,
+    rmf_traffic::Time now);
+
+  /// Tell the sharing that the robot is inside the cabin
+  void board(const std::string& lift, const std::string& requester_id);
+
+  /// Check whether the ride of a robot needs to stay where it is boarding.
+  /// This gives the floor that the lift should be held at, or a nullopt once
+  /// the ride may leave for its destination. A robot that does not share a
+  /// ride never needs to be held.
+  std::optional<std::string> hold_at(
+    const std::string& lift,
+    const std::string& requester_id,
+    rmf_traffic::Time now);
+
+  /// Get the session that a robot uses with a lift. This is the requester ID
+  /// of the robot when it does not share a ride.
+  std::string session(
+    const std::string& lift,
+    const std::string& requester_id) const;
+
+  /// Tell the sharing that the robot is done with the lift. This returns true
+  /// if the session of the robot should be ended, which is when no other robot
+  /// still shares it.
+  bool leave(const std::string& lift, const std::string& requester_id);
+
+private:
+
+  struct Member
+  {
+    double area;
+    bool boarded = false;
+  };
+
+  struct Ride
+  {
+    std::string lift;
+    std::string from_floor;
+    std::string to_floor;
+    rmf_traffic::Time opened;
+    std::optional<rmf_traffic::Time> filled;
+    bool departed = false;
+    std::map<std::string, Member> members;
+
+    double area() const;
+  };
+
+  using MemberKey = std::pair<std::string, std::string>;
+
+  // Get the ride of a robot, or a nullptr if it does not share a ride
+  Ride* _ride_of(const MemberKey& key);
+
+  // When the ride stops taking on more robots
+  rmf_traffic::Time _closes(const Ride& ride) const;
+
+  mutable std::mutex _mutex;
+  std::string _fleet_name;
+  Config _config;
+  uint64_t _next_ride = 0;
+
+  // Indexed by session
+  std::unordered_map<std::string, Ride> _rides;
+
+  // The session of each lift and requester that shares a ride
+  std::map<MemberKey, std::string> _session_of;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_LIFTSESSIONSHARING_HPP
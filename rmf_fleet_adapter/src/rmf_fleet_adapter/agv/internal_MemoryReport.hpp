@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_MEMORYREPORT_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_MEMORYREPORT_HPP
+
+#include <rmf_fleet_adapter/agv/FleetUpdateHandle.hpp>
+
+#include <rmf_traffic/schedule/Snapshot.hpp>
+
+#include <diagnostic_msgs/srv/self_test.hpp>
+
+#include <rclcpp/node.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Answers the MemoryReportServiceName service of an adapter with how many
+/// bytes each component of the adapter, its fleets and their robots are
+/// approximately holding on to. The response has one status for the schedule
+/// mirror, one for each fleet and one for each robot, and each of them has one
+/// value per component plus a total. Every value is a number of bytes.
+///
+/// The service is answered on the worker of the adapter, which is also the
+/// worker of its fleets. The robots that share that worker get measured right
+/// away. The robots that run on a pool of robot workers get measured on their
+/// own worker, and a robot whose worker does not get to it within RobotTimeout
+/// is reported with a WARN level and no values, and the response is not marked
+/// as passed.
+class MemoryReportService
+{
+public:
+
+  using SelfTest = diagnostic_msgs::srv::SelfTest;
+  using Fleets =
+    std::function<std::vector<std::shared_ptr<FleetUpdateHandle>>()>;
+  using ConstSnappablePtr =
+    std::shared_ptr<const rmf_traffic::schedule::Snappable>;
+
+  /// \param[in] node
+  ///   The node that offers the service
+  ///
+  /// \param[in] fleets
+  ///   Get the fleets of the adapter. This is called from the executor of the
+  ///   node.
+  ///
+  /// \param[in] mirror
+  ///   The view of the schedule that the fleets plan against
+  MemoryReportService(
+    rclcpp::Node& node,
+    Fleets fleets,
+    ConstSnappablePtr mirror);
+
+  MemoryReportService(const MemoryReportService&) = delete;
+  MemoryReportService& operator=(const MemoryReportService&) = delete;
+
+  /// Put together the report that the service responds with
+  SelfTest::Response make_report() const;
+
+  /// How long to wait for the workers of the robots to measure them
+  static const std::chrono::milliseconds RobotTimeout;
+
+private:
+  std::string _node_name;
+  Fleets _fleets;
+  ConstSnappablePtr _mirror;
+  rclcpp::Service<SelfTest>::SharedPtr _service;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_MEMORYREPORT_HPP
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_PLANCACHE_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_PLANCACHE_HPP
+
+#include <rmf_traffic/agv/Planner.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Remembers the cost of the last plan that a robot found for each leg that it
+/// has moved along, keyed by the start waypoint and orientation, the goal
+/// waypoint and orientation, and the planner that was used. The planner gets
+/// replaced whenever the navigation graph or its lanes change, which clears
+/// the cache.
+///
+/// A plan holds absolute times, so it cannot be used again for a later trip
+/// along the same leg. What does carry over is how much the leg costs, which
+/// is all that the search that ignores the schedule is needed for when the
+/// search that complies with the schedule succeeds.
+///
+/// All of the functions of this class are thread-safe.
+class PlanCache
+{
+public:
+
+  using Planner = rmf_traffic::agv::Planner;
+
+  /// Look up the cost of the last plan from the first of the starts to the
+  /// goal.
+  std::optional<double> find(
+    const std::shared_ptr<const Planner>& planner,
+    const Planner::StartSet& starts,
+    const Planner::Goal& goal) const;
+
+  /// Remember the cost of a plan that was found
+  void insert(
+    const std::shared_ptr<const Planner>& planner,
+    const Planner::StartSet& starts,
+    const Planner::Goal& goal,
+    double cost);
+
+  /// Get the start and goal waypoint of every leg that is remembered
+  std::vector<std::pair<std::size_t, std::size_t>> legs() const;
+
+  /// Approximately how many bytes the remembered legs are holding
+  std::size_t approximate_bytes() const;
+
+  /// How many legs may be remembered before the oldest knowledge is dropped
+  static constexpr std::size_t MaxLegs = 256;
+
+private:
+
+  // Start waypoint, start orientation, goal waypoint, goal orientation. The
+  // orientations are rounded so that small differences in where the robot
+  // stopped do not make a new leg.
+  using Key = std::tuple<std::size_t, int64_t, std::size_t, int64_t>;
+
+  static std::optional<Key> _key(
+    const Planner::StartSet& starts,
+    const Planner::Goal& goal);
+
+  mutable std::mutex _mutex;
+  const Planner* _planner = nullptr;
+  std::map<Key, double> _costs;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_PLANCACHE_HPP
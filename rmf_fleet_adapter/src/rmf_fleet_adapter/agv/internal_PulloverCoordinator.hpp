@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_PULLOVERCOORDINATOR_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_PULLOVERCOORDINATOR_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Coordinates the emergency pullovers of the robots in a fleet. When an
+/// emergency notice arrives every robot wants to plan a pullover at once, so
+/// the coordinator lets only a few of them plan at a time, starting with the
+/// most urgent ones, and it hands each robot the parking spots that no other
+/// robot has claimed yet, so they do not end up negotiating over one spot.
+///
+/// All of the functions of this class are thread-safe.
+class PulloverCoordinator
+  : public std::enable_shared_from_this<PulloverCoordinator>
+{
+public:
+
+  /// \param[in] max_planning
+  ///   How many robots may plan a pullover at the same time. Zero means there
+  ///   is no limit.
+  static std::shared_ptr<PulloverCoordinator> make(std::size_t max_planning);
+
+  /// Called when a robot may begin planning, with the parking spots that it
+  /// should plan towards. Every parking spot should be tried if it is empty.
+  /// This is called from whichever thread freed up the planning slot, so it
+  /// should schedule the planning on the worker of the robot.
+  using Begin = std::function<void(std::vector<std::size_t> parking_spots)>;
+
+  /// A place in line for planning a pullover. Destroying the ticket gives up
+  /// its place, its planning slot and its parking spot.
+  class Ticket
+  {
+  public:
+
+    /// Tell the coordinator that planning has finished, which lets the next
+    /// robot begin. The parking spot that the plan ends at, if any, stays
+    /// claimed by this robot until the ticket is destroyed.
+    void planning_finished(std::optional<std::size_t> parking_spot);
+
+    ~Ticket();
+
+  private:
+    friend class PulloverCoordinator;
+    Ticket(std::weak_ptr<PulloverCoordinator> coordinator, uint64_t id);
+    std::weak_ptr<PulloverCoordinator> _coordinator;
+    uint64_t _id;
+  };
+
+  /// Get in line to plan a pullover.
+  ///
+  /// \param[in] urgency
+  ///   Robots with a higher urgency get to plan first. Robots with the same
+  ///   urgency plan in the order that they asked.
+  ///
+  /// \param[in] candidates
+  ///   The parking spots that the robot would like to plan towards, nearest
+  ///   first. The spots that other robots have claimed get left out.
+  ///
+  /// \param[in] begin
+  ///   Called once the robot may begin planning. This may be called before
+  ///   this function returns.
+  std::shared_ptr<Ticket> request(
+    double urgency,
+    std::vector<std::size_t> candidates,
+    Begin begin);
+
+private:
+
+  PulloverCoordinator(std::size_t max_planning);
+
+  struct Pending
+  {
+    uint64_t id;
+    double urgency;
+    std::vector<std::size_t> candidates;
+    Begin begin;
+  };
+
+  // Start planning for as many pending robots as there are free slots. The
+  // callbacks that need to be run after the lock is released are returned.
+  std::vector<std::function<void()>> _admit();
+
+  void _finish(uint64_t id, std::optional<std::size_t> parking_spot);
+
+  void _release(uint64_t id);
+
+  // Give back every parking spot that a ticket has claimed
+  void _unclaim(uint64_t id);
+
+  static void _run(const std::vector<std::function<void()>>& callbacks);
+
+  std::mutex _mutex;
+  std::size_t _max_planning;
+  uint64_t _next_id = 0;
+  std::vector<Pending> _pending;
+
+  // The tickets that are planning right now
+  std::vector<uint64_t> _planning;
+
+  // Which ticket each claimed parking spot belongs to. A robot claims all of
+  // the spots that it was given while it is planning, and only the spot that
+  // its plan ends at once it is done.
+  std::unordered_map<std::size_t, uint64_t> _claimed;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_PULLOVERCOORDINATOR_HPP
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_REQUESTCOALESCER_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_REQUESTCOALESCER_HPP
+
+#include "internal_TimerWheel.hpp"
+
+#include <rmf_door_msgs/msg/door_request.hpp>
+#include <rmf_door_msgs/msg/supervisor_heartbeat.hpp>
+#include <rmf_lift_msgs/msg/lift_request.hpp>
+#include <rmf_lift_msgs/msg/lift_state.hpp>
+
+#include <rclcpp/publisher.hpp>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// Keeps resending the door and lift requests of every robot on a node from
+/// one shared timer, instead of each phase running a timer of its own.
+///
+/// There is one standing request per door and requester, and per lift and
+/// session. A newer request for the same pair replaces the older one. Each
+/// period, the standing requests that the supervisors have not acknowledged
+/// yet get sent again:
+/// * A door open request is acknowledged once the door supervisor heartbeat
+///   has its session, and a door close request once the heartbeat does not.
+/// * A lift request is acknowledged once the lift reports the session with the
+///   requested destination, and an end of session request once the lift
+///   reports any other session.
+///
+/// Acknowledged requests are still resent every few periods in case the
+/// supervisor has restarted since then.
+class RequestCoalescer : public std::enable_shared_from_this<RequestCoalescer>
+{
+public:
+
+  using DoorRequest = rmf_door_msgs::msg::DoorRequest;
+  using DoorRequestPub = rclcpp::Publisher<DoorRequest>::SharedPtr;
+  using DoorSupervisorState = rmf_door_msgs::msg::SupervisorHeartbeat;
+  using LiftRequest = rmf_lift_msgs::msg::LiftRequest;
+  using LiftRequestPub = rclcpp::Publisher<LiftRequest>::SharedPtr;
+  using LiftState = rmf_lift_msgs::msg::LiftState;
+
+  /// Create a periodic timer, or return a nullptr if that is not possible
+  using MakeTimer = std::function<TimerWheel::TimerPtr(
+      std::chrono::nanoseconds period,
+      std::function<void()> callback)>;
+
+  static std::shared_ptr<RequestCoalescer> make(
+    DoorRequestPub door_request_pub,
+    LiftRequestPub lift_request_pub,
+    MakeTimer make_timer,
+    std::chrono::nanoseconds period = std::chrono::seconds(1));
+
+  /// A handle for a standing request. The request stops being resent once the
+  /// handle is destroyed or a newer request replaces it.
+  class Registration;
+  using RegistrationPtr = std::shared_ptr<Registration>;
+
+  /// Send a door request right away and keep resending it
+  RegistrationPtr request_door(DoorRequest request);
+
+  /// Send a lift request right away and keep resending it
+  RegistrationPtr request_lift(LiftRequest request);
+
+  /// Give the latest heartbeat of the door supervisor
+  void update_door_supervisor(
+    std::shared_ptr<const DoorSupervisorState> heartbeat);
+
+  /// Give the latest state of a lift
+  void update_lift_state(std::shared_ptr<const LiftState> state);
+
+private:
+
+  RequestCoalescer(
+    DoorRequestPub door_request_pub,
+    LiftRequestPub lift_request_pub);
+
+  using Key = std::pair<std::string, std::string>;
+
+  template<typename Message>
+  struct Entry
+  {
+    Message request;
+    uint64_t id;
+  };
+
+  void _remove_door(const Key& key, uint64_t id);
+  void _remove_lift(const Key& key, uint64_t id);
+
+  void _resend();
+
+  bool _is_acknowledged(const DoorRequest& request) const;
+  bool _is_acknowledged(const LiftRequest& request) const;
+
+  DoorRequestPub _door_request_pub;
+  LiftRequestPub _lift_request_pub;
+  TimerWheel::TimerPtr _timer;
+
+  std::mutex _mutex;
+  uint64_t _next_id = 0;
+  uint64_t _tick = 0;
+  std::map<Key, Entry<DoorRequest>> _doors;
+  std::map<Key, Entry<LiftRequest>> _lifts;
+  std::shared_ptr<const DoorSupervisorState> _door_supervisor;
+  std::unordered_map<std::string, std::shared_ptr<const LiftState>>
+  _lift_states;
+};
+
+//==============================================================================
+class RequestCoalescer::Registration
+{
+public:
+
+  ~Registration();
+
+private:
+  friend class RequestCoalescer;
+  Registration(std::function<void()> remove);
+
+  std::function<void()> _remove;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_REQUESTCOALESCER_HPP
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_SHAREDMIRROR_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_SHAREDMIRROR_HPP
+
+#include <rmf_traffic_ros2/schedule/MirrorManager.hpp>
+
+#include <rclcpp/executors/single_threaded_executor.hpp>
+#include <rclcpp/node.hpp>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// A mirror of the whole traffic schedule that is shared by every Adapter of
+/// a process that asks for it, so running several fleets in one process does
+/// not keep one copy of the schedule per fleet. The mirror has its own node,
+/// which is spun on its own thread, so it keeps updating no matter which of
+/// the adapters are still running. It is destroyed once the last adapter that
+/// uses it lets go of it.
+class SharedMirror : public std::enable_shared_from_this<SharedMirror>
+{
+public:
+
+  /// Get the shared mirror of this process, or begin making it if no adapter
+  /// is using it right now.
+  static std::shared_ptr<SharedMirror> get(rclcpp::Context::SharedPtr context);
+
+  /// Check whether the mirror has finished initializing. This does not block.
+  bool ready();
+
+  /// Get the manager of the mirror. This must only be called after ready()
+  /// has returned true. The manager keeps the shared mirror alive.
+  std::shared_ptr<rmf_traffic_ros2::schedule::MirrorManager> manager();
+
+  ~SharedMirror();
+
+private:
+
+  SharedMirror(rclcpp::Context::SharedPtr context);
+
+  std::shared_ptr<rclcpp::Node> _node;
+  std::unique_ptr<rclcpp::executors::SingleThreadedExecutor> _executor;
+  std::thread _spin_thread;
+
+  std::mutex _mutex;
+  std::optional<rmf_traffic_ros2::schedule::MirrorManagerFuture> _future;
+  std::optional<rmf_traffic_ros2::schedule::MirrorManager> _manager;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_SHAREDMIRROR_HPP
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_TIMERWHEEL_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_TIMERWHEEL_HPP
+
+#include <rclcpp/node.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// A hierarchical timer wheel that lets many periodic callbacks share one
+/// rclcpp timer. Each callback is rounded to the tick period of the wheel, so
+/// this is meant for the many coarse timers of fleets with a lot of robots,
+/// not for anything that needs precise timing.
+///
+/// The callbacks are triggered from the executor thread of the rclcpp timer
+/// that drives the wheel, just like the callbacks of an rclcpp timer would
+/// be.
+class TimerWheel : public std::enable_shared_from_this<TimerWheel>
+{
+public:
+
+  /// A handle for a timer on the wheel. The timer is cancelled once the
+  /// handle is destroyed, so it can be managed much like an
+  /// rclcpp::TimerBase::SharedPtr.
+  class Timer;
+  using TimerPtr = std::shared_ptr<Timer>;
+
+  static std::shared_ptr<TimerWheel> make(
+    rclcpp::Node& node,
+    std::chrono::nanoseconds tick_period = std::chrono::milliseconds(50));
+
+  /// Create a timer that triggers the callback once every period. The first
+  /// trigger happens one period from now.
+  TimerPtr create_timer(
+    std::chrono::nanoseconds period,
+    std::function<void()> callback);
+
+  /// How many timers are currently on the wheel
+  std::size_t size() const;
+
+private:
+
+  struct Entry
+  {
+    uint64_t period_ticks;
+    uint64_t due_tick;
+    std::function<void()> callback;
+    std::atomic_bool cancelled{false};
+  };
+  using EntryPtr = std::shared_ptr<Entry>;
+
+  TimerWheel(std::chrono::nanoseconds tick_period);
+
+  void _tick();
+
+  void _insert(EntryPtr entry);
+
+  void _cascade(std::size_t level);
+
+  static constexpr std::size_t SlotBits = 6;
+  static constexpr std::size_t NumSlots = 1 << SlotBits;
+  static constexpr std::size_t NumLevels = 3;
+
+  using Slots = std::array<std::vector<EntryPtr>, NumSlots>;
+
+  std::chrono::nanoseconds _tick_period;
+  rclcpp::TimerBase::SharedPtr _driver;
+
+  mutable std::mutex _mutex;
+  uint64_t _current_tick = 0;
+  std::array<Slots, NumLevels> _levels;
+  std::vector<EntryPtr> _overflow;
+  std::size_t _size = 0;
+};
+
+//==============================================================================
+class TimerWheel::Timer
+{
+public:
+
+  /// Cancel the timer. Its callback will not be triggered again, although a
+  /// trigger that is already under way will still finish.
+  void cancel();
+
+  ~Timer();
+
+private:
+  friend class TimerWheel;
+  Timer(std::weak_ptr<TimerWheel> wheel, EntryPtr entry);
+
+  std::weak_ptr<TimerWheel> _wheel;
+  EntryPtr _entry;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_TIMERWHEEL_HPP
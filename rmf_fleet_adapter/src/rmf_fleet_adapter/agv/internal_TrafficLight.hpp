@@ -32,6 +32,8 @@
 
 #include "Node.hpp"
 
+#include <unordered_map>
+
 namespace rmf_fleet_adapter {
 namespace agv {
 
@@ -43,6 +45,40 @@ public:
   class Data;
   class Negotiator;
 
+  /// While an instance of this class is alive, the state updates that traffic
+  /// lights receive on the current thread are held back instead of being
+  /// scheduled one at a time. When the instance is destroyed, all the updates
+  /// that belong to the same node get scheduled on its worker as one job.
+  /// Nested instances are folded into the outermost one.
+  class BatchUpdates
+  {
+  public:
+
+    BatchUpdates();
+    ~BatchUpdates();
+
+    BatchUpdates(const BatchUpdates&) = delete;
+    BatchUpdates& operator=(const BatchUpdates&) = delete;
+
+    /// Schedule a job on the worker, or hold it back if a batch is active on
+    /// the current thread.
+    static void schedule(
+      const rxcpp::schedulers::worker& worker,
+      const Node* node,
+      std::function<void()> job);
+
+  private:
+
+    struct Jobs
+    {
+      rxcpp::schedulers::worker worker;
+      std::vector<std::function<void()>> jobs;
+    };
+
+    bool _active;
+    std::unordered_map<const Node*, Jobs> _jobs;
+  };
+
   std::size_t received_version = 0;
 
   std::shared_ptr<Data> data;
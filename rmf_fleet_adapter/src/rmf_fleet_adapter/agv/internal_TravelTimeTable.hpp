@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_TRAVELTIMETABLE_HPP
+#define SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_TRAVELTIMETABLE_HPP
+
+#include <rmf_traffic/agv/Planner.hpp>
+
+#include <iosfwd>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace agv {
+
+//==============================================================================
+/// A table of the shortest travel time between each pair of waypoints in a
+/// navigation graph, found by running Dijkstra over the open lanes. The travel
+/// time of a lane is its length divided by the nominal linear velocity of the
+/// vehicle, plus the duration of any events on it. Turning in place and the
+/// traffic schedule are not accounted for, so the values are optimistic
+/// estimates that can be used to rank destinations without running a planner.
+///
+/// Each row of the table is found the first time that it is needed, or ahead
+/// of time by precompute(). When lanes are opened or closed only the rows that
+/// could be affected by the change are thrown away.
+///
+/// All of the functions of this class are thread-safe.
+class TravelTimeTable
+{
+public:
+
+  TravelTimeTable(const rmf_traffic::agv::Planner::Configuration& config);
+
+  /// Get the shortest travel time, in seconds, from one waypoint to another,
+  /// or a nullopt if the second waypoint cannot be reached from the first.
+  std::optional<double> travel_time(std::size_t from, std::size_t to) const;
+
+  /// Get the shortest travel time, in seconds, from a planner start to a
+  /// waypoint. The time to reach the start waypoint from the location of the
+  /// start is included.
+  std::optional<double> travel_time(
+    const rmf_traffic::agv::Planner::Start& start,
+    std::size_t to) const;
+
+  struct Nearest
+  {
+    std::size_t waypoint;
+    double time;
+  };
+
+  /// Find which of a set of destination waypoints can be reached soonest from
+  /// a planner start. The nearest destination of every waypoint is found with
+  /// one search the first time a set of destinations is asked for, so later
+  /// lookups for the same set are a table read.
+  std::optional<Nearest> nearest(
+    const rmf_traffic::agv::Planner::Start& start,
+    const std::vector<std::size_t>& destinations) const;
+
+  /// Find up to k of a set of destination waypoints that can be reached
+  /// soonest from a planner start, ordered from the nearest. The k nearest
+  /// destinations of every waypoint are found with one search the first time
+  /// a set of destinations is asked for, so later lookups for the same set
+  /// are a table read.
+  std::vector<Nearest> nearest(
+    const rmf_traffic::agv::Planner::Start& start,
+    const std::vector<std::size_t>& destinations,
+    std::size_t k) const;
+
+  /// Find every row of the table that is not known yet
+  void precompute() const;
+
+  /// Find the k nearest destinations of every waypoint ahead of time
+  void precompute_nearest(
+    const std::vector<std::size_t>& destinations,
+    std::size_t k) const;
+
+  /// Update the table to match a new set of lane closures
+  void update_lane_closures(const rmf_traffic::agv::LaneClosure& closures);
+
+  /// The value of arrival_lanes(~) for waypoints that have no arrival lane
+  static constexpr std::size_t NoLane = std::numeric_limits<std::size_t>::max();
+
+  /// Get the lane that the shortest path from a waypoint uses to arrive at
+  /// each waypoint. This is NoLane for the start waypoint itself and for any
+  /// waypoint that cannot be reached from it.
+  std::vector<std::size_t> arrival_lanes(std::size_t from) const;
+
+  /// Get a fingerprint of the lanes and lane travel times of the graph, so
+  /// that rows which were saved for another graph or vehicle do not get used.
+  uint64_t fingerprint() const;
+
+  /// Approximately how many bytes the rows and nearest destination indexes
+  /// that have been found so far are holding
+  std::size_t approximate_bytes() const;
+
+  /// Write every row that is known so far. Rows that were found while any
+  /// lane was closed are not written, since they do not match the graph that
+  /// a restarted adapter begins with.
+  void save(std::ostream& out) const;
+
+  /// Add the rows that were written by save(). This returns false if the data
+  /// is malformed or was saved for a table with another fingerprint, in which
+  /// case nothing gets added.
+  bool load(std::istream& in);
+
+private:
+
+  struct Row
+  {
+    std::vector<double> time;
+
+    // The lane that the shortest path uses to arrive at each waypoint
+    std::vector<std::size_t> arrival_lane;
+  };
+
+  const Row& _row(std::size_t from) const;
+
+  Row _search(std::size_t from) const;
+
+  // The time from each waypoint to its nearest destination, and which
+  // destination that is
+  struct NearestIndex
+  {
+    std::vector<double> time;
+    std::vector<std::size_t> destination;
+  };
+
+  NearestIndex _search_nearest(
+    const std::vector<std::size_t>& destinations) const;
+
+  // The k nearest destinations of each waypoint, ordered from the nearest
+  using KNearestIndex = std::vector<std::vector<Nearest>>;
+
+  KNearestIndex _search_k_nearest(
+    const std::vector<std::size_t>& destinations,
+    std::size_t k) const;
+
+  const KNearestIndex& _k_nearest_index(
+    std::vector<std::size_t> destinations,
+    std::size_t k) const;
+
+  rmf_traffic::agv::Graph _graph;
+  double _nominal_velocity;
+  std::vector<double> _lane_time;
+  std::vector<bool> _lane_closed;
+  std::size_t _closed_lanes = 0;
+
+  // Waypoint indices of the entry and exit of each lane
+  std::vector<std::pair<std::size_t, std::size_t>> _lane_ends;
+  std::vector<std::vector<std::size_t>> _lanes_from;
+  std::vector<std::vector<std::size_t>> _lanes_into;
+
+  mutable std::mutex _mutex;
+  mutable std::unordered_map<std::size_t, Row> _rows;
+
+  // Indexed by the sorted list of destinations
+  mutable std::map<std::vector<std::size_t>, NearestIndex> _nearest;
+
+  // Indexed by k and the sorted list of destinations
+  mutable std::map<
+    std::pair<std::size_t, std::vector<std::size_t>>, KNearestIndex>
+  _k_nearest;
+};
+
+} // namespace agv
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__AGV__INTERNAL_TRAVELTIMETABLE_HPP
@@ -16,18 +16,81 @@
 */
 
 #include <rmf_fleet_adapter/agv/parse_graph.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
 #include <unordered_map>
 #include <yaml-cpp/yaml.h>
 
 namespace rmf_fleet_adapter {
 namespace agv {
 
+namespace {
 //==============================================================================
-rmf_traffic::agv::Graph parse_graph(
-  const std::string& graph_file,
-  const rmf_traffic::agv::VehicleTraits& vehicle_traits)
+// Everything that the graph needs from the yaml file, in a form that can be
+// compiled into a cache file. This does not depend on the vehicle traits, so
+// one cache file serves every fleet that uses the same graph.
+struct GraphDescription
+{
+  struct Waypoint
+  {
+    std::string map_name;
+    double x = 0.0;
+    double y = 0.0;
+    std::string name;
+    bool is_parking_spot = false;
+    bool is_holding_point = false;
+    bool is_passthrough_point = false;
+    bool is_charger = false;
+    std::string lift;
+  };
+
+  struct Lane
+  {
+    std::string map_name;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    std::optional<std::string> orientation_constraint;
+    std::optional<std::string> mock_floor_name;
+    std::optional<std::string> mock_lift_name;
+    std::optional<std::string> door_name;
+    std::optional<std::string> dock_name;
+    double speed_limit = 0.0;
+  };
+
+  std::vector<Waypoint> waypoints;
+  std::vector<Lane> lanes;
+};
+
+//==============================================================================
+std::optional<std::string> get_string(
+  const YAML::Node& options,
+  const std::string& key)
+{
+  if (const YAML::Node option = options[key])
+    return option.as<std::string>();
+
+  return std::nullopt;
+}
+
+//==============================================================================
+bool get_flag(const YAML::Node& options, const std::string& key)
+{
+  if (const YAML::Node option = options[key])
+    return option.as<bool>();
+
+  return false;
+}
+
+//==============================================================================
+GraphDescription describe_graph(
+  const YAML::Node& graph_config,
+  const std::string& graph_file)
 {
-  const YAML::Node graph_config = YAML::LoadFile(graph_file);
   if (!graph_config)
   {
     throw std::runtime_error("Failed to load graph file [" + graph_file + "]");
@@ -51,14 +114,7 @@ rmf_traffic::agv::Graph parse_graph(
     // *INDENT-ON*
   }
 
-  using Constraint = rmf_traffic::agv::Graph::OrientationConstraint;
-  using ConstraintPtr = rmf_utils::clone_ptr<Constraint>;
-  using Lane = rmf_traffic::agv::Graph::Lane;
-  using Event = Lane::Event;
-
-  rmf_traffic::agv::Graph graph;
-  std::unordered_map<std::string, std::vector<std::size_t>> wps_of_lift;
-  std::unordered_map<std::size_t, std::string> lift_of_wp;
+  GraphDescription description;
   std::size_t vnum = 0;  // To increment lane endpoint ids
 
   for (const auto& level : levels)
@@ -69,236 +125,249 @@ rmf_traffic::agv::Graph parse_graph(
     const YAML::Node& vertices = level.second["vertices"];
     for (const auto& vertex : vertices)
     {
-      const Eigen::Vector2d location{
-        vertex[0].as<double>(), vertex[1].as<double>()};
-
-      auto& wp = graph.add_waypoint(map_name, location);
+      GraphDescription::Waypoint wp;
+      wp.map_name = map_name;
+      wp.x = vertex[0].as<double>();
+      wp.y = vertex[1].as<double>();
 
       const YAML::Node& options = vertex[2];
-      const YAML::Node& name_option = options["name"];
-      if (name_option)
-      {
-        const std::string& name = name_option.as<std::string>();
-        if (!name.empty())
-        {
-          if (!graph.add_key(name, wp.index()))
-          {
-            // *INDENT-OFF*
-            throw std::runtime_error(
-              "Duplicated waypoint name [" + name + "] in graph ["
-              + graph_file + "]");
-            // *INDENT-ON*
-          }
-        }
-      }
+      wp.name = get_string(options, "name").value_or("");
+      wp.is_parking_spot = get_flag(options, "is_parking_spot");
+      wp.is_holding_point = get_flag(options, "is_holding_point");
+      wp.is_passthrough_point = get_flag(options, "is_passthrough_point");
+      wp.is_charger = get_flag(options, "is_charger");
+      wp.lift = get_string(options, "lift").value_or("");
+
+      description.waypoints.emplace_back(std::move(wp));
       vnum_temp ++;
+    }
 
-      const YAML::Node& parking_spot_option = options["is_parking_spot"];
-      if (parking_spot_option)
-      {
-        const bool is_parking_spot = parking_spot_option.as<bool>();
-        if (is_parking_spot)
-          wp.set_parking_spot(true);
-      }
+    const YAML::Node& lanes = level.second["lanes"];
+    for (const auto& lane : lanes)
+    {
+      GraphDescription::Lane l;
+      l.map_name = map_name;
+      l.begin = lane[0].as<std::size_t>() + vnum;
+      l.end = lane[1].as<std::size_t>() + vnum;
+
+      const YAML::Node& options = lane[2];
+      l.orientation_constraint = get_string(options, "orientation_constraint");
+      l.mock_floor_name = get_string(options, "demo_mock_floor_name");
+      l.mock_lift_name = get_string(options, "demo_mock_lift_name");
+      l.door_name = get_string(options, "door_name");
+      l.dock_name = get_string(options, "dock_name");
+      if (const YAML::Node speed_limit_option = options["speed_limit"])
+        l.speed_limit = speed_limit_option.as<double>();
+
+      description.lanes.emplace_back(std::move(l));
+    }
+    vnum += vnum_temp;
+  }
+
+  return description;
+}
 
-      const YAML::Node& holding_point_option = options["is_holding_point"];
-      if (holding_point_option)
+//==============================================================================
+rmf_traffic::agv::Graph build_graph(
+  const GraphDescription& description,
+  const rmf_traffic::agv::VehicleTraits& vehicle_traits,
+  const std::string& graph_file)
+{
+  using Constraint = rmf_traffic::agv::Graph::OrientationConstraint;
+  using ConstraintPtr = rmf_utils::clone_ptr<Constraint>;
+  using Lane = rmf_traffic::agv::Graph::Lane;
+  using Event = Lane::Event;
+
+  rmf_traffic::agv::Graph graph;
+  std::unordered_map<std::string, std::vector<std::size_t>> wps_of_lift;
+  std::unordered_map<std::size_t, std::string> lift_of_wp;
+
+  for (const auto& vertex : description.waypoints)
+  {
+    const Eigen::Vector2d location{vertex.x, vertex.y};
+    auto& wp = graph.add_waypoint(vertex.map_name, location);
+
+    if (!vertex.name.empty())
+    {
+      if (!graph.add_key(vertex.name, wp.index()))
       {
-        const bool is_holding_point = holding_point_option.as<bool>();
-        if (is_holding_point)
-          wp.set_holding_point(true);
+        // *INDENT-OFF*
+        throw std::runtime_error(
+          "Duplicated waypoint name [" + vertex.name + "] in graph ["
+          + graph_file + "]");
+        // *INDENT-ON*
       }
+    }
 
-      const YAML::Node& passthrough_option = options["is_passthrough_point"];
-      if (passthrough_option)
+    if (vertex.is_parking_spot)
+      wp.set_parking_spot(true);
+
+    if (vertex.is_holding_point)
+      wp.set_holding_point(true);
+
+    if (vertex.is_passthrough_point)
+      wp.set_passthrough_point(true);
+
+    if (vertex.is_charger)
+      wp.set_charger(true);
+
+    if (!vertex.lift.empty())
+    {
+      wps_of_lift[vertex.lift].push_back(wp.index());
+      lift_of_wp[wp.index()] = vertex.lift;
+    }
+  }
+
+  for (const auto& lane : description.lanes)
+  {
+    const std::string& map_name = lane.map_name;
+    const std::size_t begin = lane.begin;
+    const std::size_t end = lane.end;
+
+    ConstraintPtr constraint = nullptr;
+    if (lane.orientation_constraint.has_value())
+    {
+      const std::string& constraint_label = *lane.orientation_constraint;
+      if (constraint_label == "forward")
       {
-        const bool is_passthrough_point = passthrough_option.as<bool>();
-        if (is_passthrough_point)
-          wp.set_passthrough_point(true);
+        constraint = Constraint::make(
+          Constraint::Direction::Forward,
+          vehicle_traits.get_differential()->get_forward());
       }
-
-      const YAML::Node& charger_option = options["is_charger"];
-      if (charger_option)
+      else if (constraint_label == "backward")
       {
-        const bool is_charger = charger_option.as<bool>();
-        if (is_charger)
-          wp.set_charger(true);
+        constraint = Constraint::make(
+          Constraint::Direction::Backward,
+          vehicle_traits.get_differential()->get_forward());
       }
-
-      const YAML::Node& lift_option = options["lift"];
-      if (lift_option)
+      else
       {
-        const std::string lift_name = lift_option.as<std::string>();
-        if (lift_name != "")
-        {
-          wps_of_lift[lift_name].push_back(wp.index());
-          lift_of_wp[wp.index()] = lift_name;
-        }
+        // *INDENT-OFF*
+        throw std::runtime_error(
+          "Unrecognized orientation constraint label given to lane ["
+          + std::to_string(begin) + ", "
+          + std::to_string(end) + "]: ["
+          + constraint_label + "] in graph ["
+          + graph_file + "]");
+        // *INDENT-ON*
       }
     }
 
-    const YAML::Node& lanes = level.second["lanes"];
-    for (const auto& lane : lanes)
-    {
+    rmf_utils::clone_ptr<Event> entry_event;
+    rmf_utils::clone_ptr<Event> exit_event;
 
-      ConstraintPtr constraint = nullptr;
+    const auto lift_of_begin = lift_of_wp.find(begin);
+    const auto lift_of_end = lift_of_wp.find(end);
 
-      const YAML::Node& options = lane[2];
-      const YAML::Node& orientation_constraint_option =
-        options["orientation_constraint"];
-      if (orientation_constraint_option)
+    const bool begin_in_lift = lift_of_begin != lift_of_wp.end();
+    const bool end_in_lift = lift_of_end != lift_of_wp.end();
+
+    const bool is_lift = begin_in_lift || end_in_lift;
+    if (is_lift)
+    {
+      const rmf_traffic::Duration duration = std::chrono::seconds(4);
+      if (!begin_in_lift && end_in_lift)
       {
-        const std::string& constraint_label =
-          orientation_constraint_option.as<std::string>();
-        if (constraint_label == "forward")
-        {
-          constraint = Constraint::make(
-            Constraint::Direction::Forward,
-            vehicle_traits.get_differential()->get_forward());
-        }
-        else if (constraint_label == "backward")
-        {
-          constraint = Constraint::make(
-            Constraint::Direction::Backward,
-            vehicle_traits.get_differential()->get_forward());
-        }
-        else
+        // Entering lift
+        const std::string& lift_name = lift_of_end->second;
+        entry_event = Event::make(
+          Lane::LiftSessionBegin(lift_name, map_name, duration));
+      }
+      else if (begin_in_lift && end_in_lift)
+      {
+        if (lift_of_begin->second != lift_of_end->second)
         {
+          // If these are two lift waypoints on the same floor, then they
+          // should be inside the same lift
           // *INDENT-OFF*
           throw std::runtime_error(
-            "Unrecognized orientation constraint label given to lane ["
-            + std::to_string(lane[0].as<std::size_t>() + vnum) + ", "
-            + std::to_string(lane[1].as<std::size_t>() + vnum) + "]: ["
-            + constraint_label + "] in graph ["
-            + graph_file + "]");
+            "Inconsistency in building map. Map [" + map_name + "] has two "
+            "connected waypoints [" + std::to_string(
+              begin) + " -> "
+            + std::to_string(end) + "] that are in different lifts ["
+            + lift_of_begin->second + " -> " + lift_of_end->second
+            + "]. This is not supported!");
           // *INDENT-ON*
         }
-      }
-
-      rmf_utils::clone_ptr<Event> entry_event;
-      rmf_utils::clone_ptr<Event> exit_event;
-      std::size_t begin = lane[0].as<std::size_t>() + vnum;
-      std::size_t end = lane[1].as<std::size_t>() + vnum;
 
-      const auto lift_of_begin = lift_of_wp.find(begin);
-      const auto lift_of_end = lift_of_wp.find(end);
-
-      const bool begin_in_lift = lift_of_begin != lift_of_wp.end();
-      const bool end_in_lift = lift_of_end != lift_of_wp.end();
-
-      const bool is_lift = begin_in_lift || end_in_lift;
-      if (is_lift)
-      {
-        const rmf_traffic::Duration duration = std::chrono::seconds(4);
-        if (!begin_in_lift && end_in_lift)
-        {
-          // Entering lift
-          const std::string& lift_name = lift_of_end->second;
-          entry_event = Event::make(
-            Lane::LiftSessionBegin(lift_name, map_name, duration));
-        }
-        else if (begin_in_lift && end_in_lift)
-        {
-          if (lift_of_begin->second != lift_of_end->second)
-          {
-            // If these are two lift waypoints on the same floor, then they
-            // should be inside the same lift
-            // *INDENT-OFF*
-            throw std::runtime_error(
-              "Inconsistency in building map. Map [" + map_name + "] has two "
-              "connected waypoints [" + std::to_string(
-                begin) + " -> "
-              + std::to_string(end) + "] that are in different lifts ["
-              + lift_of_begin->second + " -> " + lift_of_end->second
-              + "]. This is not supported!");
-            // *INDENT-ON*
-          }
-
-          // If we make it here, then both waypoints are inside the same lift,
-          // so we don't need any event for the robots to move between these
-          // waypoints.
-        }
-        else if (begin_in_lift && !end_in_lift)
-        {
-          // Exiting lift
-          const std::string& lift_name = lift_of_begin->second;
-          entry_event = Event::make(
-            Lane::LiftDoorOpen(lift_name, map_name, duration));
-          exit_event = Event::make(
-            Lane::LiftSessionEnd(lift_name, map_name,
-            rmf_traffic::Duration(0)));
-        }
+        // If we make it here, then both waypoints are inside the same lift,
+        // so we don't need any event for the robots to move between these
+        // waypoints.
       }
-      else
+      else if (begin_in_lift && !end_in_lift)
       {
-        if (const YAML::Node mock_lift_option = options["demo_mock_floor_name"])
-        {
-          // NOTE: This is specifically for cases where users want to have a
-          // mock lift in the map. It should not be used for real lifts.
-          const std::string floor_name = mock_lift_option.as<std::string>();
-          const YAML::Node lift_name_option = options["demo_mock_lift_name"];
-
-          if (!lift_name_option)
-          {
-            // *INDENT-OFF*
-            throw std::runtime_error(
-              "Missing [demo_mock_lift_name] parameter which is required for "
-              "mock lifts");
-            // *INDENT-ON*
-          }
-
-          // TODO(MXG): This implementation is not air tight. After a robot has
-          // entered the lift, a second robot could start a new lift session,
-          // which would cause problems for the robot that's in the lift.
-          //
-          // We will need to rework this implementation if we ever need to do
-          // a demo where multiple robots negotiate the use of a mock lift.
-          const std::string lift_name = lift_name_option.as<std::string>();
-          const rmf_traffic::Duration duration = std::chrono::seconds(4);
-          entry_event = Event::make(
-            Lane::LiftSessionBegin(lift_name, floor_name, duration));
-          exit_event = Event::make(
-            Lane::LiftSessionEnd(lift_name, floor_name,
-            rmf_traffic::Duration(0)));
-        }
-        else if (const YAML::Node door_name_option = options["door_name"])
-        {
-          const std::string name = door_name_option.as<std::string>();
-          const rmf_traffic::Duration duration = std::chrono::seconds(4);
-          entry_event = Event::make(Lane::DoorOpen(name, duration));
-          exit_event = Event::make(Lane::DoorClose(name, duration));
-        }
+        // Exiting lift
+        const std::string& lift_name = lift_of_begin->second;
+        entry_event = Event::make(
+          Lane::LiftDoorOpen(lift_name, map_name, duration));
+        exit_event = Event::make(
+          Lane::LiftSessionEnd(lift_name, map_name,
+          rmf_traffic::Duration(0)));
       }
-
-      if (const YAML::Node docking_option = options["dock_name"])
+    }
+    else
+    {
+      if (lane.mock_floor_name.has_value())
       {
-        // TODO(MXG): Add support for this
-        if (entry_event || exit_event)
+        // NOTE: This is specifically for cases where users want to have a
+        // mock lift in the map. It should not be used for real lifts.
+        const std::string& floor_name = *lane.mock_floor_name;
+
+        if (!lane.mock_lift_name.has_value())
         {
           // *INDENT-OFF*
           throw std::runtime_error(
-            "We do not currently support a dock_name option when any other "
-            "lane options are also specified");
+            "Missing [demo_mock_lift_name] parameter which is required for "
+            "mock lifts");
           // *INDENT-ON*
         }
 
-        const std::string dock_name = docking_option.as<std::string>();
-        const rmf_traffic::Duration duration = std::chrono::seconds(5);
-        entry_event = Event::make(Lane::Dock(dock_name, duration));
+        // TODO(MXG): This implementation is not air tight. After a robot has
+        // entered the lift, a second robot could start a new lift session,
+        // which would cause problems for the robot that's in the lift.
+        //
+        // We will need to rework this implementation if we ever need to do
+        // a demo where multiple robots negotiate the use of a mock lift.
+        const std::string& lift_name = *lane.mock_lift_name;
+        const rmf_traffic::Duration duration = std::chrono::seconds(4);
+        entry_event = Event::make(
+          Lane::LiftSessionBegin(lift_name, floor_name, duration));
+        exit_event = Event::make(
+          Lane::LiftSessionEnd(lift_name, floor_name,
+          rmf_traffic::Duration(0)));
       }
+      else if (lane.door_name.has_value())
+      {
+        const std::string& name = *lane.door_name;
+        const rmf_traffic::Duration duration = std::chrono::seconds(4);
+        entry_event = Event::make(Lane::DoorOpen(name, duration));
+        exit_event = Event::make(Lane::DoorClose(name, duration));
+      }
+    }
 
-      auto& graph_lane = graph.add_lane(
-        {begin, entry_event},
-        {end, exit_event, std::move(constraint)});
-
-      if (const YAML::Node speed_limit_option = options["speed_limit"])
+    if (lane.dock_name.has_value())
+    {
+      // TODO(MXG): Add support for this
+      if (entry_event || exit_event)
       {
-        const double speed_limit = speed_limit_option.as<double>();
-        if (speed_limit > 0.0)
-          graph_lane.properties().speed_limit(speed_limit);
+        // *INDENT-OFF*
+        throw std::runtime_error(
+          "We do not currently support a dock_name option when any other "
+          "lane options are also specified");
+        // *INDENT-ON*
       }
+
+      const std::string& dock_name = *lane.dock_name;
+      const rmf_traffic::Duration duration = std::chrono::seconds(5);
+      entry_event = Event::make(Lane::Dock(dock_name, duration));
     }
-    vnum += vnum_temp;
+
+    auto& graph_lane = graph.add_lane(
+      {begin, entry_event},
+      {end, exit_event, std::move(constraint)});
+
+    if (lane.speed_limit > 0.0)
+      graph_lane.properties().speed_limit(lane.speed_limit);
   }
 
   for (const auto& lift : wps_of_lift)
@@ -327,5 +396,320 @@ rmf_traffic::agv::Graph parse_graph(
   return graph;
 }
 
+//==============================================================================
+// Bump this whenever the layout of the cache file changes
+const char CacheMagic[8] = {'R', 'M', 'F', 'G', 'R', 'P', 'H', '1'};
+
+//==============================================================================
+uint64_t hash_content(const std::string& content)
+{
+  // 64-bit FNV-1a
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const unsigned char c : content)
+  {
+    hash ^= c;
+    hash *= 0x100000001b3;
+  }
+
+  return hash;
+}
+
+//==============================================================================
+class CacheWriter
+{
+public:
+
+  void write(const void* data, std::size_t size)
+  {
+    _buffer.append(static_cast<const char*>(data), size);
+  }
+
+  void u64(uint64_t value)
+  {
+    write(&value, sizeof(value));
+  }
+
+  void f64(double value)
+  {
+    write(&value, sizeof(value));
+  }
+
+  void flag(bool value)
+  {
+    const char c = value;
+    write(&c, 1);
+  }
+
+  void str(const std::string& value)
+  {
+    u64(value.size());
+    write(value.data(), value.size());
+  }
+
+  void opt(const std::optional<std::string>& value)
+  {
+    flag(value.has_value());
+    if (value.has_value())
+      str(*value);
+  }
+
+  const std::string& buffer() const
+  {
+    return _buffer;
+  }
+
+private:
+  std::string _buffer;
+};
+
+//==============================================================================
+class CacheReader
+{
+public:
+
+  CacheReader(const std::string& buffer)
+  : _buffer(buffer)
+  {
+    // Do nothing
+  }
+
+  void read(void* data, std::size_t size)
+  {
+    if (_buffer.size() - _pos < size)
+      throw std::runtime_error("Truncated graph cache");
+
+    std::memcpy(data, _buffer.data() + _pos, size);
+    _pos += size;
+  }
+
+  uint64_t u64()
+  {
+    uint64_t v;
+    read(&v, sizeof(v));
+    return v;
+  }
+
+  double f64()
+  {
+    double v;
+    read(&v, sizeof(v));
+    return v;
+  }
+
+  bool flag()
+  {
+    char c;
+    read(&c, 1);
+    return c != 0;
+  }
+
+  std::string str()
+  {
+    const auto size = u64();
+    if (_buffer.size() - _pos < size)
+      throw std::runtime_error("Truncated graph cache");
+
+    std::string value = _buffer.substr(_pos, size);
+    _pos += size;
+    return value;
+  }
+
+  std::optional<std::string> opt()
+  {
+    if (flag())
+      return str();
+
+    return std::nullopt;
+  }
+
+  bool finished() const
+  {
+    return _pos == _buffer.size();
+  }
+
+private:
+  const std::string& _buffer;
+  std::size_t _pos = 0;
+};
+
+//==============================================================================
+std::string compile_description(
+  const GraphDescription& description,
+  const uint64_t content_hash)
+{
+  CacheWriter w;
+  w.write(CacheMagic, sizeof(CacheMagic));
+  w.u64(content_hash);
+
+  w.u64(description.waypoints.size());
+  for (const auto& wp : description.waypoints)
+  {
+    w.str(wp.map_name);
+    w.f64(wp.x);
+    w.f64(wp.y);
+    w.str(wp.name);
+    w.flag(wp.is_parking_spot);
+    w.flag(wp.is_holding_point);
+    w.flag(wp.is_passthrough_point);
+    w.flag(wp.is_charger);
+    w.str(wp.lift);
+  }
+
+  w.u64(description.lanes.size());
+  for (const auto& lane : description.lanes)
+  {
+    w.str(lane.map_name);
+    w.u64(lane.begin);
+    w.u64(lane.end);
+    w.opt(lane.orientation_constraint);
+    w.opt(lane.mock_floor_name);
+    w.opt(lane.mock_lift_name);
+    w.opt(lane.door_name);
+    w.opt(lane.dock_name);
+    w.f64(lane.speed_limit);
+  }
+
+  return w.buffer();
+}
+
+//==============================================================================
+std::optional<GraphDescription> load_description(
+  const std::string& cache_file,
+  const uint64_t content_hash)
+{
+  std::ifstream file(cache_file, std::ios::binary);
+  if (!file)
+    return std::nullopt;
+
+  std::stringstream ss;
+  ss << file.rdbuf();
+  const std::string buffer = ss.str();
+
+  try
+  {
+    CacheReader r(buffer);
+    char magic[sizeof(CacheMagic)];
+    r.read(magic, sizeof(magic));
+    if (std::memcmp(magic, CacheMagic, sizeof(CacheMagic)) != 0)
+      return std::nullopt;
+
+    if (r.u64() != content_hash)
+      return std::nullopt;
+
+    GraphDescription description;
+    const auto num_waypoints = r.u64();
+    for (uint64_t i = 0; i < num_waypoints; ++i)
+    {
+      GraphDescription::Waypoint wp;
+      wp.map_name = r.str();
+      wp.x = r.f64();
+      wp.y = r.f64();
+      wp.name = r.str();
+      wp.is_parking_spot = r.flag();
+      wp.is_holding_point = r.flag();
+      wp.is_passthrough_point = r.flag();
+      wp.is_charger = r.flag();
+      wp.lift = r.str();
+      description.waypoints.emplace_back(std::move(wp));
+    }
+
+    const auto num_lanes = r.u64();
+    for (uint64_t i = 0; i < num_lanes; ++i)
+    {
+      GraphDescription::Lane lane;
+      lane.map_name = r.str();
+      lane.begin = r.u64();
+      lane.end = r.u64();
+      lane.orientation_constraint = r.opt();
+      lane.mock_floor_name = r.opt();
+      lane.mock_lift_name = r.opt();
+      lane.door_name = r.opt();
+      lane.dock_name = r.opt();
+      lane.speed_limit = r.f64();
+      description.lanes.emplace_back(std::move(lane));
+    }
+
+    if (!r.finished())
+      return std::nullopt;
+
+    return description;
+  }
+  catch (const std::runtime_error&)
+  {
+    // A damaged cache file is treated the same as a missing one
+    return std::nullopt;
+  }
+}
+
+//==============================================================================
+void save_description(const std::string& cache_file, const std::string& data)
+{
+  // Write to a temporary file first so that another adapter which is starting
+  // up at the same time never sees a partially written cache.
+  const std::string tmp_file = cache_file + ".tmp";
+  {
+    std::ofstream file(tmp_file, std::ios::binary | std::ios::trunc);
+    if (!file)
+      return;
+
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file)
+      return;
+  }
+
+  if (std::rename(tmp_file.c_str(), cache_file.c_str()) != 0)
+    std::remove(tmp_file.c_str());
+}
+
+} // anonymous namespace
+
+//==============================================================================
+rmf_traffic::agv::Graph parse_graph(
+  const std::string& graph_file,
+  const rmf_traffic::agv::VehicleTraits& vehicle_traits)
+{
+  const YAML::Node graph_config = YAML::LoadFile(graph_file);
+  return build_graph(
+    describe_graph(graph_config, graph_file), vehicle_traits, graph_file);
+}
+
+//==============================================================================
+rmf_traffic::agv::Graph parse_graph(
+  const std::string& graph_file,
+  const rmf_traffic::agv::VehicleTraits& vehicle_traits,
+  const std::string& cache_directory)
+{
+  if (cache_directory.empty())
+    return parse_graph(graph_file, vehicle_traits);
+
+  std::ifstream file(graph_file, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error("Failed to load graph file [" + graph_file + "]");
+  }
+
+  std::stringstream ss;
+  ss << file.rdbuf();
+  const std::string content = ss.str();
+  const uint64_t content_hash = hash_content(content);
+
+  std::stringstream name;
+  name << cache_directory << "/nav_graph_" << std::hex << std::setw(16)
+       << std::setfill('0') << content_hash << ".bin";
+  const std::string cache_file = name.str();
+
+  if (const auto description = load_description(cache_file, content_hash))
+    return build_graph(*description, vehicle_traits, graph_file);
+
+  const auto description =
+    describe_graph(YAML::Load(content), graph_file);
+
+  // Build the graph before saving the cache so that a graph with errors in it
+  // never gets cached.
+  auto graph = build_graph(description, vehicle_traits, graph_file);
+  save_description(cache_file, compile_description(description, content_hash));
+  return graph;
+}
+
 } // namespace agv
 } // namespace rmf_fleet_adapter
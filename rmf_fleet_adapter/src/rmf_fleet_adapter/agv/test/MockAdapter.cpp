@@ -19,6 +19,7 @@
 
 #include "../internal_FleetUpdateHandle.hpp"
 #include "../internal_TrafficLight.hpp"
+#include "../internal_MemoryReport.hpp"
 
 #include <rmf_traffic/schedule/Database.hpp>
 #include <rmf_traffic/schedule/Mirror.hpp>
@@ -207,10 +208,19 @@ public:
     schedule{std::make_shared<MockScheduleNode>(worker)},
     blockade_writer{rmf_traffic_ros2::blockade::Writer::make(*node)}
   {
-    // Do nothing
+    memory_report = std::make_unique<MemoryReportService>(
+      *node,
+      [this]()
+      {
+        std::lock_guard<std::mutex> lock(fleets_mutex);
+        return fleets;
+      },
+      schedule->snappable());
   }
 
+  std::mutex fleets_mutex;
   std::vector<std::shared_ptr<FleetUpdateHandle>> fleets = {};
+  std::unique_ptr<MemoryReportService> memory_report;
 
 };
 
@@ -243,6 +253,7 @@ std::shared_ptr<FleetUpdateHandle> MockAdapter::add_fleet(
     std::make_shared<SimpleParticipantFactory>(_pimpl->schedule),
     _pimpl->schedule->snappable(), nullptr, server_uri);
 
+  std::lock_guard<std::mutex> lock(_pimpl->fleets_mutex);
   _pimpl->fleets.push_back(fleet);
   return fleet;
 }
@@ -309,13 +320,15 @@ void MockAdapter::stop()
 //==============================================================================
 void MockAdapter::dispatch_task(
   std::string task_id,
-  const nlohmann::json& request)
+  const nlohmann::json& request,
+  std::function<void(std::optional<std::string> robot)> on_bid)
 {
   _pimpl->worker.schedule(
     [
       request,
       task_id = std::move(task_id),
-      fleets = _pimpl->fleets
+      fleets = _pimpl->fleets,
+      on_bid = std::move(on_bid)
     ](const auto&)
     {
       for (auto& fleet : fleets)
@@ -324,39 +337,58 @@ void MockAdapter::dispatch_task(
 
         // NOTE: although the current adapter supports multiple fleets. The test
         // here assumses using a single fleet for each adapter
-        bool accepted = false;
         auto bid = rmf_task_msgs::build<rmf_task_msgs::msg::BidNotice>()
         .request(request.dump())
         .task_id(task_id)
         .time_window(rclcpp::Duration(2, 0));
 
+        // The fleet may take a while to plan its bid, so the task is awarded
+        // from inside the response instead of after bid_notice_cb returns.
         fimpl.bid_notice_cb(
           bid,
-          [&accepted](const rmf_task_ros2::bidding::Response& response)
+          [fleet, task_id, on_bid](
+            const rmf_task_ros2::bidding::Response& response)
           {
-            accepted = response.proposal.has_value();
+            auto& fimpl = FleetUpdateHandle::Implementation::get(*fleet);
+            if (response.proposal.has_value())
+            {
+              rmf_task_msgs::msg::DispatchCommand req;
+              req.task_id = task_id;
+              req.fleet_name = fimpl.name;
+              req.type = req.TYPE_AWARD;
+              fimpl.dispatch_command_cb(
+                std::make_shared<rmf_task_msgs::msg::DispatchCommand>(req));
+              std::cout << "Fleet [" << fimpl.name
+                        << "] accepted the task request" << std::endl;
+            }
+            else
+            {
+              std::cout << "Fleet [" << fimpl.name
+                        << "] rejected the task request" << std::endl;
+            }
+
+            if (on_bid)
+            {
+              if (response.proposal.has_value())
+                on_bid(response.proposal->expected_robot_name);
+              else
+                on_bid(std::nullopt);
+            }
           });
-
-        if (accepted)
-        {
-          rmf_task_msgs::msg::DispatchCommand req;
-          req.task_id = task_id;
-          req.fleet_name = fimpl.name;
-          req.type = req.TYPE_AWARD;
-          fimpl.dispatch_command_cb(
-            std::make_shared<rmf_task_msgs::msg::DispatchCommand>(req));
-          std::cout << "Fleet [" << fimpl.name << "] accepted the task request"
-                    << std::endl;
-        }
-        else
-        {
-          std::cout << "Fleet [" << fimpl.name << "] rejected the task request"
-                    << std::endl;
-        }
       }
     });
 }
 
+//==============================================================================
+void MockAdapter::schedule(std::function<void()> job)
+{
+  _pimpl->worker.schedule(
+    [job = std::move(job)](const auto&)
+    {
+      job();
+    });
+}
+
 //==============================================================================
 MockAdapter::~MockAdapter()
 {
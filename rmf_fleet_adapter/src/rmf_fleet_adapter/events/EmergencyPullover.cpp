@@ -19,9 +19,32 @@
 
 #include <rmf_traffic/schedule/StubbornNegotiator.hpp>
 
+#include <algorithm>
+
 namespace rmf_fleet_adapter {
 namespace events {
 
+namespace {
+//==============================================================================
+/// Robots that are partway along a lane are the most likely to be in the way
+/// of other traffic, so they get to plan their pullover first, followed by
+/// robots that are stopped on a waypoint that is not a parking spot.
+double pullover_urgency(const agv::RobotContext& context)
+{
+  const auto& graph = context.planner()->get_configuration().graph();
+  double urgency = 0.0;
+  for (const auto& start : context.location())
+  {
+    if (start.lane().has_value() || start.location().has_value())
+      urgency = std::max(urgency, 2.0);
+    else if (!graph.get_waypoint(start.waypoint()).is_parking_spot())
+      urgency = std::max(urgency, 1.0);
+  }
+
+  return urgency;
+}
+} // anonymous namespace
+
 //==============================================================================
 auto EmergencyPullover::Standby::make(
   const AssignIDPtr& id,
@@ -161,6 +184,7 @@ auto EmergencyPullover::Active::interrupt(
 void EmergencyPullover::Active::cancel()
 {
   _execution = std::nullopt;
+  _pullover_ticket = nullptr;
   _state->update_status(Status::Canceled);
   _state->update_log().info("Received signal to cancel");
   _finished();
@@ -170,6 +194,7 @@ void EmergencyPullover::Active::cancel()
 void EmergencyPullover::Active::kill()
 {
   _execution = std::nullopt;
+  _pullover_ticket = nullptr;
   _state->update_status(Status::Killed);
   _state->update_log().info("Received signal to kill");
   _finished();
@@ -182,11 +207,46 @@ void EmergencyPullover::Active::_find_plan()
     return;
 
   _state->update_status(Status::Underway);
+  auto candidates = _context->pullover_candidates(_context->location());
+  const auto& coordinator = _context->pullover_coordinator();
+  if (!coordinator)
+    return _plan_pullover(std::move(candidates));
+
+  _state->update_log().info("Waiting for a turn to plan an emergency pullover");
+  _pullover_ticket = coordinator->request(
+    pullover_urgency(*_context),
+    std::move(candidates),
+    [w = weak_from_this()](std::vector<std::size_t> parking_spots)
+    {
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      self->_context->worker().schedule(
+        [w, parking_spots = std::move(parking_spots)](const auto&)
+        {
+          if (const auto self = w.lock())
+            self->_plan_pullover(parking_spots);
+        });
+    });
+}
+
+//==============================================================================
+void EmergencyPullover::Active::_plan_pullover(
+  std::vector<std::size_t> parking_spots)
+{
+  if (_is_interrupted)
+  {
+    // Let the other robots plan while this one waits to be resumed
+    _pullover_ticket = nullptr;
+    return;
+  }
+
   _state->update_log().info("Searching for an emergency pullover");
 
   _find_pullover_service = std::make_shared<services::FindEmergencyPullover>(
     _context->planner(), _context->location(), _context->schedule()->snapshot(),
-    _context->itinerary().id(), _context->profile());
+    _context->itinerary().id(), _context->profile(), std::move(parking_spots));
 
   _pullover_subscription =
     rmf_rxcpp::make_job<services::FindEmergencyPullover::Result>(
@@ -200,6 +260,15 @@ void EmergencyPullover::Active::_find_plan()
       if (!self)
         return;
 
+      if (self->_pullover_ticket)
+      {
+        std::optional<std::size_t> parking_spot;
+        if (result && !result->get_waypoints().empty())
+          parking_spot = result->get_waypoints().back().graph_index();
+
+        self->_pullover_ticket->planning_finished(parking_spot);
+      }
+
       if (!result)
       {
         // The planner could not find any pullover
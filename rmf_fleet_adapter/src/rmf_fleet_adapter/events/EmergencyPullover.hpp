@@ -94,6 +94,8 @@ public:
 
     void _find_plan();
 
+    void _plan_pullover(std::vector<std::size_t> parking_spots);
+
     void _execute_plan(rmf_traffic::agv::Plan plan);
 
     Negotiator::NegotiatePtr _respond(
@@ -109,6 +111,7 @@ public:
     std::optional<ExecutePlan> _execution;
     std::shared_ptr<services::FindEmergencyPullover> _find_pullover_service;
     rmf_rxcpp::subscription_guard _pullover_subscription;
+    std::shared_ptr<agv::PulloverCoordinator::Ticket> _pullover_ticket;
     rclcpp::TimerBase::SharedPtr _find_pullover_timeout;
     rclcpp::TimerBase::SharedPtr _retry_timer;
 
@@ -26,6 +26,8 @@
 
 #include <rmf_task_sequence/events/Bundle.hpp>
 
+#include <rmf_traffic_ros2/Time.hpp>
+
 namespace rmf_fleet_adapter {
 namespace events {
 
@@ -34,7 +36,6 @@ namespace {
 using StandbyPtr = rmf_task_sequence::Event::StandbyPtr;
 using UpdateFn = std::function<void()>;
 using MakeStandby = std::function<StandbyPtr(UpdateFn)>;
-using LegacyPhases = std::vector<std::shared_ptr<LegacyTask::PendingPhase>>;
 
 using DockRobot = phases::DockRobot::PendingPhase;
 using DoorOpen = phases::DoorOpen::PendingPhase;
@@ -43,6 +44,51 @@ using RequestLift = phases::RequestLift::PendingPhase;
 using EndLift = phases::EndLiftSession::Pending;
 using Move = phases::MoveRobot::PendingPhase;
 
+//==============================================================================
+// A legacy phase of the plan, tagged with the kind of event that it performs
+// when it is made, so that event groups can be found without casting each
+// phase to every type that could start or end a group.
+struct TaggedPhase
+{
+  enum class Kind : uint8_t
+  {
+    Move,
+    Dock,
+    DoorOpen,
+    DoorClose,
+    RequestLift,
+    EndLift
+  };
+
+  Kind kind;
+  std::shared_ptr<LegacyTask::PendingPhase> phase;
+
+  // The name of the door or lift that the phase uses, if any
+  std::string name;
+
+  // Only call this for the kind of phase that it casts to
+  template<typename T>
+  const T& as() const
+  {
+    return static_cast<const T&>(*phase);
+  }
+};
+
+using LegacyPhases = std::vector<TaggedPhase>;
+
+//==============================================================================
+MakeStandby make_legacy_standby(
+  std::shared_ptr<LegacyTask::PendingPhase> legacy,
+  const agv::RobotContextPtr& context,
+  const rmf_task::Event::AssignIDPtr& id)
+{
+  return [legacy = std::move(legacy), context, id](UpdateFn update)
+    {
+      return LegacyPhaseShim::Standby::make(
+        legacy, context->worker(), context->clock(), id, update);
+    };
+}
+
 //==============================================================================
 class EventPhaseFactory : public rmf_traffic::agv::Graph::Lane::Executor
 {
@@ -67,21 +113,28 @@ public:
   {
     assert(!_moving_lift);
     _phases.push_back(
-      std::make_shared<phases::DockRobot::PendingPhase>(
-        _context, dock.dock_name()));
+      {
+        TaggedPhase::Kind::Dock,
+        std::make_shared<phases::DockRobot::PendingPhase>(
+          _context, dock.dock_name()),
+        dock.dock_name()
+      });
     _continuous = false;
   }
 
   void execute(const DoorOpen& open) final
   {
     assert(!_moving_lift);
-    const auto node = _context->node();
     _phases.push_back(
-      std::make_shared<phases::DoorOpen::PendingPhase>(
-        _context,
-        open.name(),
-        _context->requester_id(),
-        _event_start_time + open.duration()));
+      {
+        TaggedPhase::Kind::DoorOpen,
+        std::make_shared<phases::DoorOpen::PendingPhase>(
+          _context,
+          open.name(),
+          _context->requester_id(),
+          _event_start_time + open.duration()),
+        open.name()
+      });
     _continuous = true;
   }
 
@@ -90,26 +143,32 @@ public:
     assert(!_moving_lift);
 
     // TODO(MXG): Account for event duration in this phase
-    const auto node = _context->node();
     _phases.push_back(
-      std::make_shared<phases::DoorClose::PendingPhase>(
-        _context,
-        close.name(),
-        _context->requester_id()));
+      {
+        TaggedPhase::Kind::DoorClose,
+        std::make_shared<phases::DoorClose::PendingPhase>(
+          _context,
+          close.name(),
+          _context->requester_id()),
+        close.name()
+      });
     _continuous = true;
   }
 
   void execute(const LiftSessionBegin& open) final
   {
     assert(!_moving_lift);
-    const auto node = _context->node();
     _phases.push_back(
-      std::make_shared<phases::RequestLift::PendingPhase>(
-        _context,
-        open.lift_name(),
-        open.floor_name(),
-        _event_start_time,
-        phases::RequestLift::Located::Outside));
+      {
+        TaggedPhase::Kind::RequestLift,
+        std::make_shared<phases::RequestLift::PendingPhase>(
+          _context,
+          open.lift_name(),
+          open.floor_name(),
+          _event_start_time,
+          phases::RequestLift::Located::Outside),
+        open.lift_name()
+      });
 
     _continuous = true;
   }
@@ -126,16 +185,18 @@ public:
 
   void execute(const LiftDoorOpen& open) final
   {
-    const auto node = _context->node();
-
     // TODO(MXG): The time calculation here should be considered more carefully.
     _phases.push_back(
-      std::make_shared<phases::RequestLift::PendingPhase>(
-        _context,
-        open.lift_name(),
-        open.floor_name(),
-        _event_start_time + open.duration() + _lifting_duration,
-        phases::RequestLift::Located::Inside));
+      {
+        TaggedPhase::Kind::RequestLift,
+        std::make_shared<phases::RequestLift::PendingPhase>(
+          _context,
+          open.lift_name(),
+          open.floor_name(),
+          _event_start_time + open.duration() + _lifting_duration,
+          phases::RequestLift::Located::Inside),
+        open.lift_name()
+      });
     _moving_lift = false;
 
     _continuous = true;
@@ -144,12 +205,15 @@ public:
   void execute(const LiftSessionEnd& close) final
   {
     assert(!_moving_lift);
-    const auto node = _context->node();
     _phases.push_back(
-      std::make_shared<phases::EndLiftSession::Pending>(
-        _context,
-        close.lift_name(),
-        close.floor_name()));
+      {
+        TaggedPhase::Kind::EndLift,
+        std::make_shared<phases::EndLiftSession::Pending>(
+          _context,
+          close.lift_name(),
+          close.floor_name()),
+        close.lift_name()
+      });
 
     _continuous = true;
   }
@@ -166,7 +230,7 @@ public:
 
 private:
   agv::RobotContextPtr _context;
-  std::vector<std::shared_ptr<LegacyTask::PendingPhase>>& _phases;
+  LegacyPhases& _phases;
   rmf_traffic::Time _event_start_time;
   bool& _continuous;
   bool _moving_lift = false;
@@ -188,22 +252,20 @@ std::optional<EventGroupInfo> search_for_door_group(
   const agv::RobotContextPtr& context,
   const rmf_task::Event::AssignIDPtr& id)
 {
-  const auto* door_open = dynamic_cast<const phases::DoorOpen::PendingPhase*>(
-    head->get());
-
-  if (!door_open)
+  if (head->kind != TaggedPhase::Kind::DoorOpen)
     return std::nullopt;
 
+  const auto& door_name = head->name;
+
   // Look for a door close event for this same door
   auto tail = head;
   ++tail;
   auto moving_duration = rmf_traffic::Duration(0);
   while (tail != end)
   {
-    const auto* tail_event = tail->get();
-    if (const auto* door_close = dynamic_cast<const DoorClose*>(tail_event))
+    if (tail->kind == TaggedPhase::Kind::DoorClose)
     {
-      if (door_open->door_name() != door_close->door_name())
+      if (door_name != tail->name)
       {
         // A different door is being closed, so we should not lump this all
         // together
@@ -214,20 +276,14 @@ std::optional<EventGroupInfo> search_for_door_group(
       // Let's lump these events together.
 
       auto group_state = rmf_task::events::SimpleEventState::make(
-        id->assign(), "Pass through [door:" + door_open->door_name() + "]",
+        id->assign(), "Pass through [door:" + door_name + "]",
         "", rmf_task::Event::Status::Standby, {}, context->clock());
 
       std::vector<MakeStandby> door_group;
       ++tail;
+      door_group.reserve(tail - head);
       for (auto it = head; it != tail; ++it)
-      {
-        door_group.push_back(
-          [legacy = *it, context, id](UpdateFn update)
-          {
-            return LegacyPhaseShim::Standby::make(
-              legacy, context->worker(), context->clock(), id, update);
-          });
-      }
+        door_group.push_back(make_legacy_standby(it->phase, context, id));
 
       return EventGroupInfo{
         [
@@ -242,9 +298,9 @@ std::optional<EventGroupInfo> search_for_door_group(
         tail
       };
     }
-    else if (const auto* move = dynamic_cast<const Move*>(tail_event))
+    else if (tail->kind == TaggedPhase::Kind::Move)
     {
-      moving_duration += move->estimate_phase_duration();
+      moving_duration += tail->as<Move>().estimate_phase_duration();
       if (std::chrono::minutes(1) < moving_duration)
       {
         // There is a lot of moving happening here, so we should not lump
@@ -273,39 +329,36 @@ std::optional<EventGroupInfo> search_for_lift_group(
   const rmf_task::Event::AssignIDPtr& id,
   const rmf_task::events::SimpleEventStatePtr& state)
 {
-  const auto lift_begin = dynamic_cast<const RequestLift*>(head->get());
-
-  if (!lift_begin)
+  if (head->kind != TaggedPhase::Kind::RequestLift)
     return std::nullopt;
 
-  const auto& lift_name = lift_begin->lift_name();
+  const auto& lift_name = head->name;
   auto tail = head;
   ++tail;
   while (tail != end)
   {
-    const auto* tail_event = tail->get();
-    if (const auto* lift_request = dynamic_cast<const RequestLift*>(tail_event))
+    if (tail->kind == TaggedPhase::Kind::RequestLift)
     {
-      if (lift_request->lift_name() != lift_name)
+      if (tail->name != lift_name)
       {
         // A different lift is being interacted with before the current lift
         // interaction has finished. This is weird, so let's report it.
         state->update_log().warn(
-          "Plan involves using [lift:" + lift_request->lift_name()
+          "Plan involves using [lift:" + tail->name
           + "] while the robot is already in a session with [lift:"
           + lift_name + "]. This may indicate a broken navigation graph. "
           "Please report this to the system integrator.");
         return std::nullopt;
       }
     }
-    else if (const auto* lift_end = dynamic_cast<const EndLift*>(tail_event))
+    else if (tail->kind == TaggedPhase::Kind::EndLift)
     {
-      if (lift_end->lift_name() != lift_name)
+      if (tail->name != lift_name)
       {
         // A different lift session is being ended before this one. This is
         // weird, so let's report it.
         state->update_log().warn(
-          "Plan involves ending a session with [lift:" + lift_end->lift_name()
+          "Plan involves ending a session with [lift:" + tail->name
           + "] while [lift:" + lift_name + "] is in use. This may indicate "
           "a broken navigation graph. Please report this to the system "
           "integrator.");
@@ -313,7 +366,7 @@ std::optional<EventGroupInfo> search_for_lift_group(
       }
 
       auto category = "Take [lift:" + lift_name
-        + "] to [floor:" + lift_end->destination() + "]";
+        + "] to [floor:" + tail->as<EndLift>().destination() + "]";
 
       auto group_state = rmf_task::events::SimpleEventState::make(
         id->assign(), std::move(category),
@@ -321,15 +374,9 @@ std::optional<EventGroupInfo> search_for_lift_group(
 
       std::vector<MakeStandby> lift_group;
       ++tail;
+      lift_group.reserve(tail - head);
       for (auto it = head; it != tail; ++it)
-      {
-        lift_group.push_back(
-          [legacy = *it, context, id](UpdateFn update)
-          {
-            return LegacyPhaseShim::Standby::make(
-              legacy, context->worker(), context->clock(), id, update);
-          });
-      }
+        lift_group.push_back(make_legacy_standby(it->phase, context, id));
 
       return EventGroupInfo{
         [
@@ -405,8 +452,11 @@ std::optional<ExecutePlan> ExecutePlan::make(
         if (move_through.size() > 1)
         {
           legacy_phases.push_back(
-            std::make_shared<phases::MoveRobot::PendingPhase>(
-              context, move_through, tail_period));
+            {
+              TaggedPhase::Kind::Move,
+              std::make_shared<Move>(context, move_through, tail_period),
+              {}
+            });
         }
 
         move_through.clear();
@@ -457,8 +507,11 @@ std::optional<ExecutePlan> ExecutePlan::make(
       // If we have more than one waypoint to move through, then create a
       // moving phase.
       legacy_phases.push_back(
-        std::make_shared<phases::MoveRobot::PendingPhase>(
-          context, move_through, tail_period));
+        {
+          TaggedPhase::Kind::Move,
+          std::make_shared<Move>(context, move_through, tail_period),
+          {}
+        });
     }
 
     if (!event_occurred)
@@ -469,6 +522,49 @@ std::optional<ExecutePlan> ExecutePlan::make(
     }
   }
 
+  // Tell each request for a lift from outside of it which floor the robot
+  // will ride to, so robots going the same way can share a ride.
+  using Located = phases::RequestLift::Located;
+  for (auto it = legacy_phases.begin(); it != legacy_phases.end(); ++it)
+  {
+    if (it->kind != TaggedPhase::Kind::RequestLift
+      || it->as<RequestLift>().located() != Located::Outside)
+      continue;
+
+    for (auto next = it + 1; next != legacy_phases.end(); ++next)
+    {
+      if (next->kind != TaggedPhase::Kind::RequestLift
+        || next->name != it->name)
+        continue;
+
+      static_cast<RequestLift&>(*it->phase).ride_to(
+        next->as<RequestLift>().destination());
+      break;
+    }
+  }
+
+  // Let the door supervisor know when this robot expects to reach each door,
+  // so it can keep a door open for a robot that closely follows another.
+  rmf_door_msgs::msg::SupervisorHeartbeat upcoming_doors;
+  for (const auto& phase : legacy_phases)
+  {
+    if (phase.kind != TaggedPhase::Kind::DoorOpen)
+      continue;
+
+    rmf_door_msgs::msg::Session session;
+    session.requester_id = context->requester_id();
+    session.request_time = rmf_traffic_ros2::convert(
+      phase.as<DoorOpen>().expected_finish());
+
+    rmf_door_msgs::msg::DoorSessions door;
+    door.door_name = phase.name;
+    door.sessions.push_back(std::move(session));
+    upcoming_doors.all_sessions.push_back(std::move(door));
+  }
+
+  if (!upcoming_doors.all_sessions.empty())
+    context->node()->upcoming_door_sessions()->publish(upcoming_doors);
+
   // Convert the legacy phases into task events.
 
   // We take the extra step of lumping related events into groups when we can
@@ -492,13 +588,7 @@ std::optional<ExecutePlan> ExecutePlan::make(
     }
     else
     {
-      standbys.push_back(
-        [legacy = *head, context, id](UpdateFn update)
-        {
-          return LegacyPhaseShim::Standby::make(
-            legacy, context->worker(), context->clock(), id, update);
-        });
-
+      standbys.push_back(make_legacy_standby(head->phase, context, id));
       ++head;
     }
   }
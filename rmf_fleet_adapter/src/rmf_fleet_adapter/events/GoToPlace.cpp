@@ -16,12 +16,28 @@
 */
 
 #include "GoToPlace.hpp"
+#include "../tracing.hpp"
 
 #include <rmf_traffic/schedule/StubbornNegotiator.hpp>
 
+#include <algorithm>
+
 namespace rmf_fleet_adapter {
 namespace events {
 
+namespace {
+//==============================================================================
+/// The ID that the current task of the robot is traced under
+std::string task_trace_id(const agv::RobotContext& context)
+{
+  if (!tracing::enabled())
+    return "";
+
+  const auto* id = context.current_task_id();
+  return id ? *id : "";
+}
+} // anonymous namespace
+
 //==============================================================================
 void GoToPlace::add(rmf_task_sequence::Event::Initializer& initializer)
 {
@@ -270,29 +286,61 @@ std::string wp_name(const agv::RobotContext& context)
 }
 
 //==============================================================================
-void GoToPlace::Active::_find_plan()
+void GoToPlace::Active::_find_plan(const bool is_retry)
 {
   if (_is_interrupted)
     return;
 
+  const auto planner = _context->planner();
+  const auto starts = _context->location();
+
+  // A trip between levels gets planned one level at a time
+  _leg_goal = _goal;
+  const auto& portals = _context->level_portals();
+  if (portals && !starts.empty())
+  {
+    const auto portal = portals->next_portal(starts.front(), _goal.waypoint());
+    if (portal.has_value())
+      _leg_goal = rmf_traffic::agv::Plan::Goal(*portal);
+  }
+
+  const auto goal = _leg_goal;
   _state->update_status(Status::Underway);
   const auto start_name = wp_name(*_context);
-  const auto goal_name = wp_name(*_context, _goal);
+  const auto goal_name = wp_name(*_context, goal);
   _state->update_log().info(
     "Generating plan to move from [" + start_name + "] to [" + goal_name + "]");
 
+  // A retry can pick up the search of the attempt before it, as long as the
+  // robot, its goal, and the traffic have not changed in the meantime.
+  const auto previous = is_retry ? _find_path_service : nullptr;
+  // Loops and patrols keep moving along the same legs, so the cost of the
+  // last plan for this leg tells the search what to expect.
+  const auto known_cost = _context->plan_cache().find(planner, starts, goal);
   _find_path_service = std::make_shared<services::FindPath>(
-    _context->planner(), _context->location(), _goal,
+    planner, starts, goal,
     _context->schedule()->snapshot(), _context->itinerary().id(),
-    _context->profile());
+    _context->profile(), previous, known_cost);
+
+  if (is_retry)
+  {
+    // Retries happen on a timer while the robot waits, so they should never
+    // hold up planning that something is actively waiting on.
+    jobs::Planning::Policy policy;
+    policy.priority = jobs::Planning::Priority::Background;
+    policy.slice_budget = std::chrono::milliseconds(50);
+    _find_path_service->policy(policy);
+  }
 
   _plan_subscription = rmf_rxcpp::make_job<services::FindPath::Result>(
     _find_path_service)
     .observe_on(rxcpp::identity_same_worker(_context->worker()))
     .subscribe(
-    [w = weak_from_this(), start_name, goal_name](
+    [w = weak_from_this(), start_name, goal_name, planner, starts, goal,
+    trace_start = tracing::start(), trace_id = task_trace_id(*_context)](
       const services::FindPath::Result& result)
     {
+      tracing::record("find_plan", trace_id, trace_start);
       const auto self = w.lock();
       if (!self)
         return;
@@ -314,6 +362,9 @@ void GoToPlace::Active::_find_plan()
         return;
       }
 
+      self->_context->plan_cache().insert(
+        planner, starts, goal, result->get_cost());
+
       self->_state->update_status(Status::Underway);
       self->_state->update_log().info(
         "Found a plan to move from ["
@@ -322,10 +373,11 @@ void GoToPlace::Active::_find_plan()
       self->_execute_plan(*std::move(result));
       self->_find_path_service = nullptr;
       self->_retry_timer = nullptr;
+      self->_find_path_timeout_duration = InitialFindPathTimeout;
     });
 
   _find_path_timeout = _context->node()->try_create_wall_timer(
-    std::chrono::seconds(10),
+    _find_path_timeout_duration,
     [
       weak_service = _find_path_service->weak_from_this(),
       weak_self = weak_from_this()
@@ -335,7 +387,14 @@ void GoToPlace::Active::_find_plan()
         service->interrupt();
 
       if (const auto self = weak_self.lock())
+      {
         self->_find_path_timeout = nullptr;
+
+        // Long routes may need more time than the initial timeout allows, so
+        // each attempt that times out gives the next one more time.
+        self->_find_path_timeout_duration = std::min(
+          2*self->_find_path_timeout_duration, MaximumFindPathTimeout);
+      }
     });
 
   _update();
@@ -343,7 +402,8 @@ void GoToPlace::Active::_find_plan()
 
 //==============================================================================
 GoToPlace::Active::Active(rmf_traffic::agv::Plan::Goal goal)
-: _goal(std::move(goal))
+: _goal(goal),
+  _leg_goal(std::move(goal))
 {
   // Do nothing
 }
@@ -367,7 +427,7 @@ void GoToPlace::Active::_schedule_retry()
       if (self->_execution.has_value())
         return;
 
-      self->_find_plan();
+      self->_find_plan(true);
     });
 }
 
@@ -379,13 +439,14 @@ void GoToPlace::Active::_execute_plan(rmf_traffic::agv::Plan plan)
 
   if (plan.get_itinerary().empty())
   {
-    _finished();
+    _leg_finished()();
     return;
   }
 
+  tracing::instant("execute_plan", task_trace_id(*_context));
   _execution = ExecutePlan::make(
     _context, std::move(plan), _assign_id, _state,
-    _update, _finished, _tail_period);
+    _update, _leg_finished(), _tail_period);
 
   if (!_execution.has_value())
   {
@@ -397,6 +458,32 @@ void GoToPlace::Active::_execute_plan(rmf_traffic::agv::Plan plan)
   }
 }
 
+//==============================================================================
+std::function<void()> GoToPlace::Active::_leg_finished()
+{
+  if (_leg_goal.waypoint() == _goal.waypoint())
+    return _finished;
+
+  // The robot has reached the portal of another level, so the rest of the
+  // trip gets planned from there.
+  return [w = weak_from_this()]()
+    {
+      const auto self = w.lock();
+      if (!self)
+        return;
+
+      self->_context->worker().schedule(
+        [w](const auto&)
+        {
+          if (const auto self = w.lock())
+          {
+            self->_execution = std::nullopt;
+            self->_find_plan();
+          }
+        });
+    };
+}
+
 //==============================================================================
 Negotiator::NegotiatePtr GoToPlace::Active::_respond(
   const Negotiator::TableViewerPtr& table_view,
@@ -409,12 +496,16 @@ Negotiator::NegotiatePtr GoToPlace::Active::_respond(
     return nullptr;
   }
 
-  auto approval_cb = [w = weak_from_this()](
+  auto approval_cb = [w = weak_from_this(),
+      trace_start = tracing::start(), trace_id = task_trace_id(*_context)](
     const rmf_traffic::agv::Plan& plan)
     -> std::optional<rmf_traffic::schedule::ItineraryVersion>
     {
+      tracing::record("negotiation", trace_id, trace_start);
       if (auto self = w.lock())
       {
+        // Negotiations plan all the way to the goal
+        self->_leg_goal = self->_goal;
         self->_execute_plan(plan);
         return self->_context->itinerary().version();
       }
@@ -108,15 +108,23 @@ public:
 
     void _schedule_retry();
 
-    void _find_plan();
+    void _find_plan(bool is_retry = false);
 
     void _execute_plan(rmf_traffic::agv::Plan plan);
 
+    // What to do when the plan towards the current leg goal is finished
+    std::function<void()> _leg_finished();
+
     Negotiator::NegotiatePtr _respond(
       const Negotiator::TableViewerPtr& table_view,
       const Negotiator::ResponderPtr& responder);
 
     rmf_traffic::agv::Plan::Goal _goal;
+
+    // The goal of the plan that is being found or executed. This is a portal
+    // of another level when a trip between levels is planned one level at a
+    // time, and the goal itself otherwise.
+    rmf_traffic::agv::Plan::Goal _leg_goal;
     AssignIDPtr _assign_id;
     agv::RobotContextPtr _context;
     std::optional<rmf_traffic::Duration> _tail_period;
@@ -130,6 +138,10 @@ public:
     rclcpp::TimerBase::SharedPtr _find_path_timeout;
     rclcpp::TimerBase::SharedPtr _retry_timer;
 
+    static constexpr std::chrono::seconds InitialFindPathTimeout{10};
+    static constexpr std::chrono::seconds MaximumFindPathTimeout{80};
+    std::chrono::seconds _find_path_timeout_duration = InitialFindPathTimeout;
+
     bool _is_interrupted = false;
   };
 };
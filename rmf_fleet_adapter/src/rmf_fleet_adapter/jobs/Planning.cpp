@@ -29,6 +29,7 @@ Planning::Planning(
 : _current_result(planner->setup(starts, std::move(goal), std::move(options)))
 {
   _current_result->options().saturation_limit(10000);
+  _install_interrupter();
 }
 
 //==============================================================================
@@ -36,6 +37,28 @@ Planning::Planning(rmf_traffic::agv::Planner::Result _setup)
 : _current_result(std::move(_setup))
 {
   _current_result->options().saturation_limit(10000);
+  _install_interrupter();
+}
+
+//==============================================================================
+void Planning::_install_interrupter()
+{
+  auto& options = _current_result->options();
+  options.interrupter(
+    [original = options.interrupter(), slice = _slice]() -> bool
+    {
+      if (original && original())
+        return true;
+
+      const auto now = std::chrono::steady_clock::now();
+      if (*slice->preempt || now.time_since_epoch().count() >= slice->end)
+      {
+        slice->yielded = true;
+        return true;
+      }
+
+      return false;
+    });
 }
 
 //==============================================================================
@@ -69,5 +92,35 @@ const rmf_traffic::agv::Planner::Result& Planning::progress() const
   return *_current_result;
 }
 
+//==============================================================================
+Planning& Planning::policy(Policy value)
+{
+  std::lock_guard<std::mutex> lock(_policy_mutex);
+  _policy = std::move(value);
+  return *this;
+}
+
+//==============================================================================
+auto Planning::policy() const -> Policy
+{
+  std::lock_guard<std::mutex> lock(_policy_mutex);
+  return _policy;
+}
+
+//==============================================================================
+Planning& Planning::priority(Priority value)
+{
+  std::lock_guard<std::mutex> lock(_policy_mutex);
+  _policy.priority = value;
+  return *this;
+}
+
+//==============================================================================
+auto Planning::priority() const -> Priority
+{
+  std::lock_guard<std::mutex> lock(_policy_mutex);
+  return _policy.priority;
+}
+
 } // namespace jobs
 } // namespace rmf_fleet_adapter
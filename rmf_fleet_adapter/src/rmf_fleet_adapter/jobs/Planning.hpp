@@ -18,11 +18,16 @@
 #ifndef SRC__RMF_FLEET_ADAPTER__JOBS__PLANNINGJOB_HPP
 #define SRC__RMF_FLEET_ADAPTER__JOBS__PLANNINGJOB_HPP
 
+#include "PlanningPool.hpp"
+
 #include <rmf_rxcpp/RxJobs.hpp>
 #include <rmf_traffic/agv/Planner.hpp>
 #include <rmf_traffic/agv/RouteValidator.hpp>
 #include <rmf_traffic/schedule/Snapshot.hpp>
 
+#include <mutex>
+#include <optional>
+
 namespace rmf_fleet_adapter {
 namespace jobs {
 
@@ -57,8 +62,59 @@ public:
 
   const rmf_traffic::agv::Planner::Result& progress() const;
 
+  using Priority = PlanningPool::Priority;
+
+  /// How this job should share the threads that planning runs on
+  struct Policy
+  {
+    /// The priority that the job has in the PlanningPool
+    Priority priority = Priority::Replan;
+
+    /// If this is set, each slice of planning will yield after this much time
+    /// and then get queued again, so that other jobs can take their turn. The
+    /// job never loses its progress when it yields.
+    std::optional<rmf_traffic::Duration> slice_budget = std::nullopt;
+
+    /// If this is set, jobs of the same priority with an earlier deadline go
+    /// first in the PlanningPool.
+    std::optional<rmf_traffic::Time> deadline = std::nullopt;
+  };
+
+  /// Set the policy of this job. This takes effect the next time the job is
+  /// resumed.
+  Planning& policy(Policy value);
+
+  /// Get the policy of this job
+  Policy policy() const;
+
+  /// Set only the priority of the policy of this job
+  Planning& priority(Priority value);
+
+  /// Get the priority of the policy of this job
+  Priority priority() const;
+
 private:
+
+  // The state that the interrupter of the planner checks to decide whether the
+  // current slice should yield
+  struct Slice
+  {
+    std::shared_ptr<std::atomic_bool> preempt =
+      std::make_shared<std::atomic_bool>(false);
+    std::atomic<rmf_traffic::Time::rep> end{
+      rmf_traffic::Time::max().time_since_epoch().count()};
+    std::atomic_bool yielded{false};
+  };
+
+  void _install_interrupter();
+
+  template<typename Subscriber>
+  void _step(const Subscriber& s);
+
   std::function<void()> _resume;
+  mutable std::mutex _policy_mutex;
+  Policy _policy;
+  std::shared_ptr<Slice> _slice = std::make_shared<Slice>();
   rmf_utils::optional<rmf_traffic::agv::Planner::Result> _current_result;
 };
 
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "PlanningPool.hpp"
+
+#include <algorithm>
+
+namespace rmf_fleet_adapter {
+namespace jobs {
+
+namespace {
+//==============================================================================
+std::mutex pool_mutex;
+
+// The pool is intentionally leaked. Slices hold on to the pool while they run
+// on its threads, so letting go of it could destroy it from one of its own
+// threads, and destroying it at exit could race with the slices that are
+// still running.
+std::shared_ptr<PlanningPool>& pool()
+{
+  static auto* const instance = new std::shared_ptr<PlanningPool>();
+  return *instance;
+}
+
+//==============================================================================
+// A limit of zero admits as many slices as there are threads
+std::size_t effective_limit(
+  const std::size_t threads,
+  const std::size_t admission_limit)
+{
+  return admission_limit == 0 ? threads : std::min(admission_limit, threads);
+}
+} // anonymous namespace
+
+//==============================================================================
+void PlanningPool::configure(
+  const std::size_t threads,
+  const std::size_t admission_limit)
+{
+  if (threads == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  auto& instance = pool();
+  if (!instance)
+  {
+    instance = std::shared_ptr<PlanningPool>(
+      new PlanningPool(threads, admission_limit));
+    return;
+  }
+
+  instance->_grow(threads, admission_limit);
+}
+
+//==============================================================================
+std::shared_ptr<PlanningPool> PlanningPool::get()
+{
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  return pool();
+}
+
+//==============================================================================
+void PlanningPool::schedule(
+  const Priority priority,
+  std::function<void()> slice,
+  const std::optional<Clock::time_point> deadline,
+  std::shared_ptr<std::atomic_bool> preempt)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto p = static_cast<std::size_t>(priority);
+    auto& queue = _queues[p];
+
+    // Slices with a deadline go ahead of every slice with a later deadline or
+    // without any deadline.
+    auto it = queue.end();
+    if (deadline.has_value())
+    {
+      it = std::find_if(queue.begin(), queue.end(), [&](const Slice& other)
+          {
+            return !other.deadline.has_value() || *deadline < *other.deadline;
+          });
+    }
+
+    queue.insert(
+      it, Slice{std::move(slice), deadline, std::move(preempt)});
+
+    _preempt_for(p);
+  }
+
+  _cv.notify_one();
+}
+
+//==============================================================================
+auto PlanningPool::load() -> Load
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  Load load;
+  for (const auto& queue : _queues)
+    load.queued += queue.size();
+
+  load.threads = _running.size();
+  for (const auto& running : _running)
+  {
+    if (running.has_value())
+      ++load.running;
+  }
+
+  return load;
+}
+
+//==============================================================================
+void PlanningPool::_preempt_for(const std::size_t priority)
+{
+  const auto negotiation = static_cast<std::size_t>(Priority::Negotiation);
+  const bool admission_full = priority != negotiation
+    && _admission_limit > 0 && _admitted >= _admission_limit;
+
+  if (_idle > 0 && !admission_full)
+    return;
+
+  // Ask the running slice with the lowest priority to yield, as long as its
+  // priority is below the new one and it has not already been asked.
+  Running* lowest = nullptr;
+  for (auto& running : _running)
+  {
+    if (!running.has_value() || !running->preempt || *running->preempt)
+      continue;
+
+    if (running->priority <= priority)
+      continue;
+
+    if (!lowest || lowest->priority < running->priority)
+      lowest = &running.value();
+  }
+
+  if (lowest)
+    *lowest->preempt = true;
+}
+
+//==============================================================================
+PlanningPool::PlanningPool(
+  const std::size_t threads,
+  const std::size_t admission_limit)
+: _admission_limit(admission_limit)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _running.resize(threads);
+  _threads.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i)
+    _threads.emplace_back([this, i]() { _run(i); });
+}
+
+//==============================================================================
+void PlanningPool::_grow(
+  const std::size_t threads,
+  const std::size_t admission_limit)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto current = _threads.size();
+    const auto total = std::max(current, threads);
+    const auto limit = std::max(
+      effective_limit(current, _admission_limit),
+      effective_limit(threads, admission_limit));
+    _admission_limit = limit >= total ? 0 : limit;
+
+    _running.resize(total);
+    for (std::size_t i = current; i < total; ++i)
+      _threads.emplace_back([this, i]() { _run(i); });
+  }
+
+  // A looser limit may let queued slices be admitted
+  _cv.notify_all();
+}
+
+//==============================================================================
+void PlanningPool::_run(const std::size_t thread_index)
+{
+  const auto negotiation =
+    static_cast<std::size_t>(Priority::Negotiation);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true)
+  {
+    std::optional<Slice> slice;
+    std::size_t priority = 0;
+    bool admitted = false;
+    ++_idle;
+    _cv.wait(lock, [&]()
+      {
+        for (std::size_t p = 0; p < NumPriorities; ++p)
+        {
+          auto& queue = _queues[p];
+          if (queue.empty())
+            continue;
+
+          if (p != negotiation && _admission_limit > 0
+          && _admitted >= _admission_limit)
+          {
+            // Lower priorities cannot be admitted either, so only a
+            // negotiation slice could be run right now.
+            return false;
+          }
+
+          slice = std::move(queue.front());
+          queue.pop_front();
+          priority = p;
+          admitted = (p != negotiation);
+          return true;
+        }
+
+        return false;
+      });
+
+    --_idle;
+    if (admitted)
+      ++_admitted;
+
+    if (slice->preempt)
+      *slice->preempt = false;
+
+    _running[thread_index] = Running{priority, slice->preempt};
+
+    lock.unlock();
+    slice->work();
+    slice = std::nullopt;
+    lock.lock();
+
+    _running[thread_index] = std::nullopt;
+
+    if (admitted)
+    {
+      --_admitted;
+      _cv.notify_one();
+    }
+  }
+}
+
+} // namespace jobs
+} // namespace rmf_fleet_adapter
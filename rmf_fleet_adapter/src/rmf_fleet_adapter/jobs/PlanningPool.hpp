@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__JOBS__PLANNINGPOOL_HPP
+#define SRC__RMF_FLEET_ADAPTER__JOBS__PLANNINGPOOL_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace jobs {
+
+//==============================================================================
+/// A pool of threads that is dedicated to advancing planning jobs, so that
+/// large planning efforts do not compete with the workers that react to the
+/// rest of the system. Each slice of planning work is queued by its priority.
+/// Slices of the same priority are handled by the earliest deadline first, and
+/// then in the order they arrive.
+///
+/// When a slice arrives and there is no thread that it may run on, the pool
+/// asks the running slice with the lowest priority below it to yield. Planning
+/// jobs yield without losing their progress and get queued again.
+class PlanningPool
+{
+public:
+
+  enum class Priority : std::size_t
+  {
+    /// Planning that a negotiation is waiting on
+    Negotiation = 0,
+
+    /// Planning for a robot that needs a new path, such as a replan
+    Replan = 1,
+
+    /// Planning that nothing urgent is waiting on
+    Background = 2
+  };
+
+  /// Start the pool that planning jobs will use. If this is never called with
+  /// more than zero threads, then planning jobs keep running on the workers of
+  /// their observables.
+  ///
+  /// The pool is shared by every adapter of the process and is never torn
+  /// down, so later calls can only grow it: the pool keeps the largest number
+  /// of threads and the loosest admission limit that it has been asked for,
+  /// and the slices that are already queued carry on as before.
+  ///
+  /// \param[in] threads
+  ///   How many threads should run planning jobs
+  ///
+  /// \param[in] admission_limit
+  ///   How many threads may be used by slices that are not for a negotiation
+  ///   at the same time. Keeping this below the number of threads makes sure
+  ///   that negotiations never have to wait for other planning to yield. A
+  ///   value of zero means there is no limit.
+  static void configure(std::size_t threads, std::size_t admission_limit);
+
+  /// Get the pool that planning jobs should use, or a nullptr if they should
+  /// not use a pool.
+  static std::shared_ptr<PlanningPool> get();
+
+  using Clock = std::chrono::steady_clock;
+
+  /// Queue a slice of planning work
+  ///
+  /// \param[in] priority
+  ///   The priority of the slice
+  ///
+  /// \param[in] slice
+  ///   The work to do
+  ///
+  /// \param[in] deadline
+  ///   When the work should be finished by, if there is such a time
+  ///
+  /// \param[in] preempt
+  ///   If this is provided, the pool will set it to true when the slice should
+  ///   yield its thread to a slice of a higher priority.
+  void schedule(
+    Priority priority,
+    std::function<void()> slice,
+    std::optional<Clock::time_point> deadline = std::nullopt,
+    std::shared_ptr<std::atomic_bool> preempt = nullptr);
+
+  /// How busy the pool is at the moment it gets asked
+  struct Load
+  {
+    /// Slices that are waiting for a thread
+    std::size_t queued = 0;
+
+    /// Slices that are running right now
+    std::size_t running = 0;
+
+    /// Threads in the pool
+    std::size_t threads = 0;
+  };
+
+  Load load();
+
+private:
+
+  PlanningPool(std::size_t threads, std::size_t admission_limit);
+
+  // Add threads and loosen the admission limit up to what is asked for
+  void _grow(std::size_t threads, std::size_t admission_limit);
+
+  struct Slice
+  {
+    std::function<void()> work;
+    std::optional<Clock::time_point> deadline;
+    std::shared_ptr<std::atomic_bool> preempt;
+  };
+
+  struct Running
+  {
+    std::size_t priority;
+    std::shared_ptr<std::atomic_bool> preempt;
+  };
+
+  void _run(std::size_t thread_index);
+
+  void _preempt_for(std::size_t priority);
+
+  static constexpr std::size_t NumPriorities = 3;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::array<std::deque<Slice>, NumPriorities> _queues;
+  std::vector<std::optional<Running>> _running;
+  std::size_t _idle = 0;
+  std::size_t _admission_limit;
+  std::size_t _admitted = 0;
+  std::vector<std::thread> _threads;
+};
+
+} // namespace jobs
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__JOBS__PLANNINGPOOL_HPP
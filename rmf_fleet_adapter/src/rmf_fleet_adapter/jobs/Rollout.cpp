@@ -17,6 +17,8 @@
 
 #include "Rollout.hpp"
 
+#include <algorithm>
+
 namespace rmf_fleet_adapter {
 namespace jobs {
 
@@ -26,12 +28,64 @@ Rollout::Rollout(
   rmf_traffic::schedule::ParticipantId blocker,
   rmf_traffic::Duration span,
   rmf_utils::optional<std::size_t> max_rollouts)
-: _rollout(std::move(result)),
-  _blocker(blocker),
+: _blocker(blocker),
+  _span(span),
+  _max_rollouts(max_rollouts)
+{
+  _rollouts.emplace_back(std::move(result));
+}
+
+//==============================================================================
+Rollout::Rollout(
+  std::vector<rmf_traffic::agv::Planner::Result> results,
+  rmf_traffic::schedule::ParticipantId blocker,
+  rmf_traffic::Duration span,
+  rmf_utils::optional<std::size_t> max_rollouts)
+: _blocker(blocker),
   _span(span),
   _max_rollouts(max_rollouts)
 {
-  // Do nothing
+  _rollouts.reserve(results.size());
+  for (auto& result : results)
+    _rollouts.emplace_back(std::move(result));
+}
+
+//==============================================================================
+auto Rollout::_expand(const std::size_t index) const -> Alternatives
+{
+  return _rollouts.at(index).expand(_blocker, _span, _max_rollouts);
+}
+
+//==============================================================================
+auto Rollout::_merge(Alternatives alternatives) const -> Alternatives
+{
+  if (_rollouts.size() < 2)
+    return alternatives;
+
+  const auto finish_time = [](const rmf_traffic::schedule::Itinerary& it)
+    {
+      auto finish = rmf_traffic::Time::min();
+      for (const auto& route : it)
+      {
+        const auto t = route.trajectory().finish_time();
+        if (t && finish < *t)
+          finish = *t;
+      }
+
+      return finish;
+    };
+
+  std::stable_sort(
+    alternatives.begin(), alternatives.end(),
+    [&finish_time](const auto& a, const auto& b)
+    {
+      return finish_time(a) < finish_time(b);
+    });
+
+  if (_max_rollouts.has_value() && alternatives.size() > *_max_rollouts)
+    alternatives.resize(*_max_rollouts);
+
+  return alternatives;
 }
 
 } // namespace jobs
@@ -20,11 +20,21 @@
 
 #include <rmf_traffic/agv/Rollout.hpp>
 
+#include "PlanningPool.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace rmf_fleet_adapter {
 namespace jobs {
 
 //==============================================================================
-class Rollout
+/// Expands the alternatives that are available to one or more planner results
+/// that were blocked by the same participant. When a planning pool is
+/// available, each result gets expanded on the pool at the same time, and the
+/// alternatives that finish soonest are kept.
+class Rollout : public std::enable_shared_from_this<Rollout>
 {
 public:
 
@@ -39,11 +49,29 @@ public:
     rmf_traffic::Duration span,
     rmf_utils::optional<std::size_t> max_rollouts = rmf_utils::nullopt);
 
+  /// Expand the alternatives of several results
+  ///
+  /// \param[in] max_rollouts
+  ///   The most alternatives that will be produced in total
+  Rollout(
+    std::vector<rmf_traffic::agv::Planner::Result> results,
+    rmf_traffic::schedule::ParticipantId blocker,
+    rmf_traffic::Duration span,
+    rmf_utils::optional<std::size_t> max_rollouts = rmf_utils::nullopt);
+
   template<typename Subscriber, typename Worker>
   void operator()(const Subscriber& s, const Worker& w);
 
 private:
-  rmf_traffic::agv::Rollout _rollout;
+
+  using Alternatives = std::vector<rmf_traffic::schedule::Itinerary>;
+
+  Alternatives _expand(std::size_t index) const;
+
+  /// Keep the alternatives that finish soonest, up to the max_rollouts
+  Alternatives _merge(Alternatives alternatives) const;
+
+  std::vector<rmf_traffic::agv::Rollout> _rollouts;
   rmf_traffic::schedule::ParticipantId _blocker;
   rmf_traffic::Duration _span;
   rmf_utils::optional<std::size_t> _max_rollouts;
@@ -17,6 +17,8 @@
 
 #include "SearchForPath.hpp"
 
+#include <algorithm>
+
 namespace rmf_fleet_adapter {
 namespace jobs {
 
@@ -27,7 +29,9 @@ SearchForPath::SearchForPath(
   rmf_traffic::agv::Plan::Goal goal,
   std::shared_ptr<const rmf_traffic::schedule::Snapshot> schedule,
   rmf_traffic::schedule::ParticipantId participant_id,
-  const std::shared_ptr<const rmf_traffic::Profile>& profile)
+  const std::shared_ptr<const rmf_traffic::Profile>& profile,
+  std::shared_ptr<const SearchForPath> previous,
+  std::optional<double> known_cost)
 : _planner(std::move(planner)),
   _starts(std::move(starts)),
   _goal(std::move(goal)),
@@ -35,6 +39,27 @@ SearchForPath::SearchForPath(
   _participant_id(participant_id),
   _worker(rxcpp::schedulers::make_event_loop().create_worker())
 {
+  if (previous && previous->_greedy_job && _same_request(*previous))
+  {
+    // The greedy job ignores the schedule, so its search is still valid.
+    _greedy_job = previous->_greedy_job;
+    _base_cost = previous->_base_cost;
+
+    // If the schedule has not changed at all, then the compliant job can also
+    // pick up wherever it left off.
+    const auto& compliant = previous->_compliant_job;
+    if (compliant->active()
+      && previous->_schedule->latest_version() == _schedule->latest_version())
+    {
+      _compliant_job = compliant;
+      _compliant_job->progress().options().interrupt_flag(_interrupt_flag);
+      return;
+    }
+
+    _make_compliant_job(*profile);
+    return;
+  }
+
   auto greedy_options = _planner->get_default_options();
   greedy_options.validator(nullptr);
 
@@ -65,18 +90,70 @@ SearchForPath::SearchForPath(
     return;
   }
 
-  const double base_cost = *greedy_setup.cost_estimate();
-  greedy_setup.options().maximum_cost_estimate(_greedy_leeway*base_cost);
+  _base_cost = *greedy_setup.cost_estimate();
+  greedy_setup.options().maximum_cost_estimate(_greedy_leeway*_base_cost);
+
+  _greedy_job = std::make_shared<Planning>(std::move(greedy_setup));
+  _make_compliant_job(*profile);
+
+  if (known_cost.has_value())
+  {
+    // An earlier trip along this path found a plan with this cost, so the
+    // compliant job can be held to that instead of a greedy result. The
+    // schedule still validates the compliant plan, and the greedy job starts
+    // if that fails.
+    _defer_greedy = true;
+    _compliant_job->progress().options().maximum_cost_estimate(
+      _compliant_leeway*std::max(_base_cost, *known_cost));
+  }
+}
+
+//==============================================================================
+bool SearchForPath::_same_request(const SearchForPath& other) const
+{
+  if (_planner != other._planner || _participant_id != other._participant_id)
+    return false;
+
+  if (_goal.waypoint() != other._goal.waypoint())
+    return false;
+
+  const auto* orientation = _goal.orientation();
+  const auto* other_orientation = other._goal.orientation();
+  if (static_cast<bool>(orientation) != static_cast<bool>(other_orientation))
+    return false;
+
+  if (orientation && *orientation != *other_orientation)
+    return false;
+
+  if (_starts.size() != other._starts.size())
+    return false;
+
+  for (std::size_t i = 0; i < _starts.size(); ++i)
+  {
+    const auto& a = _starts[i];
+    const auto& b = other._starts[i];
+    if (a.time() != b.time() || a.waypoint() != b.waypoint()
+      || a.orientation() != b.orientation() || a.lane() != b.lane()
+      || a.location() != b.location())
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
 
+//==============================================================================
+void SearchForPath::_make_compliant_job(const rmf_traffic::Profile& profile)
+{
   auto compliant_options = _planner->get_default_options();
   compliant_options.validator(
     rmf_traffic::agv::ScheduleRouteValidator::make(
-      _schedule, _participant_id, *profile));
-  compliant_options.maximum_cost_estimate(_compliant_leeway*base_cost);
+      _schedule, _participant_id, profile));
+  compliant_options.maximum_cost_estimate(_compliant_leeway*_base_cost);
   compliant_options.interrupt_flag(_interrupt_flag);
   auto compliant_setup = _planner->setup(_starts, _goal, compliant_options);
 
-  _greedy_job = std::make_shared<Planning>(std::move(greedy_setup));
   _compliant_job = std::make_shared<Planning>(std::move(compliant_setup));
 }
 
@@ -116,5 +193,15 @@ void SearchForPath::set_cost_limit(double cost)
   _explicit_cost_limit = cost;
 }
 
+//==============================================================================
+void SearchForPath::set_policy(const Planning::Policy& policy)
+{
+  if (!_greedy_job)
+    return;
+
+  _greedy_job->policy(policy);
+  _compliant_job->policy(policy);
+}
+
 } // namespace jobs
 } // namespace rmf_fleet_adapter
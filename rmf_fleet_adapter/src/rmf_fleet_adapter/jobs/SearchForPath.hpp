@@ -40,7 +40,9 @@ public:
     rmf_traffic::agv::Plan::Goal goal,
     std::shared_ptr<const rmf_traffic::schedule::Snapshot> schedule,
     rmf_traffic::schedule::ParticipantId participant_id,
-    const std::shared_ptr<const rmf_traffic::Profile>& profile);
+    const std::shared_ptr<const rmf_traffic::Profile>& profile,
+    std::shared_ptr<const SearchForPath> previous = nullptr,
+    std::optional<double> known_cost = std::nullopt);
 
   enum class Type
   {
@@ -64,6 +66,9 @@ public:
 
   void set_cost_limit(double cost);
 
+  // Set the scheduling policy of both planning jobs
+  void set_policy(const Planning::Policy& policy);
+
   Planning& greedy();
   const Planning& greedy() const;
 
@@ -71,11 +76,22 @@ public:
   const Planning& compliant() const;
 
 private:
+
+  // Check whether a search is looking for the same path as this one. The
+  // previous search is only given if it has finished.
+  bool _same_request(const SearchForPath& other) const;
+
+  void _make_compliant_job(const rmf_traffic::Profile& profile);
+
+  template<typename Subscriber>
+  void _start_greedy(const Subscriber& s);
+
   std::shared_ptr<const rmf_traffic::agv::Planner> _planner;
   rmf_traffic::agv::Plan::StartSet _starts;
   rmf_traffic::agv::Plan::Goal _goal;
   std::shared_ptr<const rmf_traffic::schedule::Snapshot> _schedule;
   rmf_traffic::schedule::ParticipantId _participant_id;
+  double _base_cost = 0.0;
   std::shared_ptr<std::atomic_bool> _interrupt_flag =
     std::make_shared<std::atomic_bool>(false);
 
@@ -87,6 +103,10 @@ private:
   rmf_rxcpp::subscription_guard _greedy_sub;
   bool _greedy_finished = false;
 
+  // When the cost of this path is already known from an earlier trip, the
+  // greedy job is only started if the compliant job fails.
+  bool _defer_greedy = false;
+
   // The compliant job makes the plan which is optimal without conflicting with
   // any other traffic currently on the schedule. In some cases, it might not
   // be feasible to find an acceptable compliant job, either because
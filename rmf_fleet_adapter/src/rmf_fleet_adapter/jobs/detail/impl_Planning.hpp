@@ -27,20 +27,75 @@ namespace jobs {
 template<typename Subscriber, typename Worker>
 void Planning::operator()(const Subscriber& s, const Worker& w)
 {
-  _resume = [a = weak_from_this(), s, w]()
+  // When a planning pool is available, every slice of planning is run on it
+  // instead of on the worker of this job. The results still reach their
+  // subscribers through the workers that those subscribers observe on.
+  const auto pool = PlanningPool::get();
+  _resume = [a = weak_from_this(), s, w, pool]()
     {
-      w.schedule([a, s, w](const auto&)
+      const auto action = a.lock();
+      if (!action)
+        return;
+
+      if (pool)
+      {
+        const auto policy = action->policy();
+        pool->schedule(
+          policy.priority,
+          [a, s]()
+          {
+            if (const auto action = a.lock())
+              action->_step(s);
+          },
+          policy.deadline,
+          action->_slice->preempt);
+        return;
+      }
+
+      w.schedule([a, s](const auto&)
         {
           if (const auto action = a.lock())
-            (*action)(s, w);
+            action->_step(s);
         });
     };
 
+  if (pool)
+    _resume();
+  else
+    _step(s);
+}
+
+//==============================================================================
+template<typename Subscriber>
+void Planning::_step(const Subscriber& s)
+{
   if (!_current_result)
     return;
 
+  const auto budget = policy().slice_budget;
+  _slice->yielded = false;
+  _slice->end = budget.has_value() ?
+    (std::chrono::steady_clock::now() + *budget).time_since_epoch().count() :
+    rmf_traffic::Time::max().time_since_epoch().count();
+
+  // A job that is resumed by a new search may have already finished
+  if (_current_result->success() || !_current_result->cost_estimate())
+  {
+    s.on_next(Result{shared_from_this()});
+    s.on_completed();
+    return;
+  }
+
   _current_result->resume();
 
+  if (_slice->yielded && !_current_result->success())
+  {
+    // The slice ran out of time or was preempted. Nothing has been decided,
+    // so we queue up the next slice without telling the subscriber anything.
+    _resume();
+    return;
+  }
+
   const bool completed =
     _current_result->success() || !_current_result->cost_estimate();
 
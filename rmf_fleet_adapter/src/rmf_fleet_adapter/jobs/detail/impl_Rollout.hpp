@@ -27,8 +27,52 @@ namespace jobs {
 template<typename Subscriber, typename Worker>
 void Rollout::operator()(const Subscriber& s, const Worker&)
 {
-  s.on_next(Result{_rollout.expand(_blocker, _span, _max_rollouts)});
-  s.on_completed();
+  const auto pool = PlanningPool::get();
+  if (!pool || _rollouts.size() < 2)
+  {
+    Alternatives alternatives;
+    for (std::size_t i = 0; i < _rollouts.size(); ++i)
+    {
+      for (auto& alternative : _expand(i))
+        alternatives.emplace_back(std::move(alternative));
+    }
+
+    s.on_next(Result{_merge(std::move(alternatives))});
+    s.on_completed();
+    return;
+  }
+
+  struct Merge
+  {
+    std::mutex mutex;
+    Alternatives alternatives;
+    std::size_t remaining;
+  };
+
+  auto merge = std::make_shared<Merge>();
+  merge->remaining = _rollouts.size();
+  for (std::size_t i = 0; i < _rollouts.size(); ++i)
+  {
+    pool->schedule(
+      PlanningPool::Priority::Negotiation,
+      [self = shared_from_this(), s, merge, i]()
+      {
+        auto alternatives = self->_expand(i);
+
+        std::unique_lock<std::mutex> lock(merge->mutex);
+        for (auto& alternative : alternatives)
+          merge->alternatives.emplace_back(std::move(alternative));
+
+        if (--merge->remaining > 0)
+          return;
+
+        auto merged = std::move(merge->alternatives);
+        lock.unlock();
+
+        s.on_next(Result{self->_merge(std::move(merged))});
+        s.on_completed();
+      });
+  }
 }
 
 } // namespace jobs
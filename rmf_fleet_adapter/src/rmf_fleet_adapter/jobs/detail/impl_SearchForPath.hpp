@@ -55,6 +55,116 @@ void SearchForPath::operator()(const Subscriber& s, const Worker&)
       _explicit_cost_limit);
   }
 
+  _defer_greedy = _defer_greedy && !_explicit_cost_limit;
+  if (!_defer_greedy)
+    _start_greedy(s);
+
+  _compliant_sub = rmf_rxcpp::make_job<Planning::Result>(_compliant_job)
+    .observe_on(rxcpp::identity_same_worker(_worker))
+    .subscribe(
+    [weak = weak_from_this(), s](const Planning::Result& result)
+    {
+      const auto search = weak.lock();
+      if (!search)
+        return;
+
+      auto show_greedy = search->_greedy_finished ?
+      search->_greedy_job : std::shared_ptr<Planning>(nullptr);
+
+      Result next{show_greedy, search->_compliant_job, Type::compliant};
+
+      auto& r = result.job->progress();
+      if (search->_defer_greedy)
+      {
+        search->_compliant_finished = true;
+        if (r.success())
+        {
+          // The plan complies with the schedule and costs about as much as the
+          // last plan for this path, so there is no need for a greedy plan.
+          s.on_next(next);
+          s.on_completed();
+          return;
+        }
+
+        // Fall back to the full search
+        search->_defer_greedy = false;
+        search->_start_greedy(s);
+        return;
+      }
+
+      if (r.success())
+      {
+        // Return the successful schedule-compliant plan
+        if (search->_greedy_finished || search->_explicit_cost_limit)
+        {
+          s.on_next(next);
+        }
+        search->_compliant_finished = true;
+
+        if (search->_greedy_finished)
+          s.on_completed();
+
+        return;
+      }
+
+      if (*search->_interrupt_flag || r.saturated() || !r.cost_estimate())
+      {
+        if (search->_greedy_finished)
+        {
+          s.on_next(next);
+          s.on_completed();
+        }
+        else if (search->_explicit_cost_limit)
+        {
+          s.on_next(next);
+        }
+
+        search->_compliant_finished = true;
+        return;
+      }
+
+      if (search->_explicit_cost_limit)
+      {
+        // An explicit cost limit means this is part of a Job, so we should
+        // report an update whenever we get an update.
+        s.on_next(next);
+        // We do not automatically resume, because that should be the choice of
+        // whoever we are reporting to.
+        return;
+      }
+
+      if (search->_greedy_finished)
+      {
+        // We don't have an explicit cost limit, so we'll just check if the
+        // greedy job search has granted us any more leeway.
+        const double new_maximum =
+        search->_compliant_leeway * search->_greedy_job->progress()->get_cost();
+
+        if (*r.options().maximum_cost_estimate() < new_maximum)
+        {
+          // Push the maximum out a bit more and let the job try again.
+          r.options().maximum_cost_estimate(new_maximum);
+          result.job->resume();
+          return;
+        }
+
+        // We shouldn't keep trying, because we have exceeded the cost limit, even
+        // when accounting for the greedy plan cost.
+        s.on_next(next);
+        s.on_completed();
+        return;
+      }
+
+      // Discard the job because it can no longer produce an acceptable result.
+      // The SearchForPath will continue looking for a greedy plan.
+      search->_compliant_finished = true;
+    });
+}
+
+//==============================================================================
+template<typename Subscriber>
+void SearchForPath::_start_greedy(const Subscriber& s)
+{
   _greedy_sub = rmf_rxcpp::make_job<Planning::Result>(_greedy_job)
     .observe_on(rxcpp::identity_same_worker(_worker))
     .subscribe(
@@ -156,89 +266,6 @@ void SearchForPath::operator()(const Subscriber& s, const Worker&)
       // We do not automatically resume, because that should be the choice of
       // whoever we are reporting to
     });
-
-  _compliant_sub = rmf_rxcpp::make_job<Planning::Result>(_compliant_job)
-    .observe_on(rxcpp::identity_same_worker(_worker))
-    .subscribe(
-    [weak = weak_from_this(), s](const Planning::Result& result)
-    {
-      const auto search = weak.lock();
-      if (!search)
-        return;
-
-      auto show_greedy = search->_greedy_finished ?
-      search->_greedy_job : std::shared_ptr<Planning>(nullptr);
-
-      Result next{show_greedy, search->_compliant_job, Type::compliant};
-
-      auto& r = result.job->progress();
-      if (r.success())
-      {
-        // Return the successful schedule-compliant plan
-        if (search->_greedy_finished || search->_explicit_cost_limit)
-        {
-          s.on_next(next);
-        }
-        search->_compliant_finished = true;
-
-        if (search->_greedy_finished)
-          s.on_completed();
-
-        return;
-      }
-
-      if (*search->_interrupt_flag || r.saturated() || !r.cost_estimate())
-      {
-        if (search->_greedy_finished)
-        {
-          s.on_next(next);
-          s.on_completed();
-        }
-        else if (search->_explicit_cost_limit)
-        {
-          s.on_next(next);
-        }
-
-        search->_compliant_finished = true;
-        return;
-      }
-
-      if (search->_explicit_cost_limit)
-      {
-        // An explicit cost limit means this is part of a Job, so we should
-        // report an update whenever we get an update.
-        s.on_next(next);
-        // We do not automatically resume, because that should be the choice of
-        // whoever we are reporting to.
-        return;
-      }
-
-      if (search->_greedy_finished)
-      {
-        // We don't have an explicit cost limit, so we'll just check if the
-        // greedy job search has granted us any more leeway.
-        const double new_maximum =
-        search->_compliant_leeway * search->_greedy_job->progress()->get_cost();
-
-        if (*r.options().maximum_cost_estimate() < new_maximum)
-        {
-          // Push the maximum out a bit more and let the job try again.
-          r.options().maximum_cost_estimate(new_maximum);
-          result.job->resume();
-          return;
-        }
-
-        // We shouldn't keep trying, because we have exceeded the cost limit, even
-        // when accounting for the greedy plan cost.
-        s.on_next(next);
-        s.on_completed();
-        return;
-      }
-
-      // Discard the job because it can no longer produce an acceptable result.
-      // The SearchForPath will continue looking for a greedy plan.
-      search->_compliant_finished = true;
-    });
 }
 
 } // namespace jobs
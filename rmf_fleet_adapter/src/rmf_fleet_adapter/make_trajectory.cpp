@@ -21,6 +21,7 @@
 #include <rmf_traffic/agv/Interpolate.hpp>
 
 #include <iostream>
+#include <optional>
 
 //==============================================================================
 rmf_traffic::Trajectory make_trajectory(
@@ -120,6 +121,130 @@ rmf_traffic::Trajectory make_timed_trajectory(
   return output;
 }
 
+//==============================================================================
+namespace {
+bool same_point(const Eigen::Vector3d& a, const Eigen::Vector3d& b)
+{
+  return (a - b).norm() <= 1e-8;
+}
+
+//==============================================================================
+void append_shifted(
+  rmf_traffic::Trajectory& output,
+  const rmf_traffic::Trajectory& segment)
+{
+  if (segment.size() == 0)
+    return;
+
+  const auto offset = *output.finish_time() - *segment.start_time();
+  for (const auto& wp : segment)
+    output.insert(wp.time() + offset, wp.position(), wp.velocity());
+}
+} // anonymous namespace
+
+//==============================================================================
+rmf_traffic::Trajectory TrajectoryBuilder::build(
+  const rmf_fleet_msgs::msg::RobotState& state,
+  const rmf_traffic::agv::VehicleTraits& traits,
+  bool& is_sitting)
+{
+  std::vector<Eigen::Vector3d> path;
+  path.reserve(state.path.size());
+  for (const auto& location : state.path)
+    path.push_back({location.x, location.y, location.yaw});
+
+  // Find how many points were dropped from the front of the last path, such
+  // that what remains of it is the beginning of the new path.
+  std::optional<std::size_t> dropped;
+  if (!path.empty())
+  {
+    for (std::size_t k = 0;
+      k < _path.size() && _path.size() - k <= path.size(); ++k)
+    {
+      bool match = true;
+      for (std::size_t i = 0; k + i < _path.size() && match; ++i)
+        match = same_point(_path[k + i], path[i]);
+
+      if (match)
+      {
+        dropped = k;
+        break;
+      }
+    }
+  }
+
+  if (dropped.has_value())
+  {
+    for (std::size_t k = 0; k < *dropped; ++k)
+    {
+      _path.pop_front();
+      _segments.pop_front();
+    }
+  }
+  else
+  {
+    reset();
+  }
+
+  const rmf_traffic::Time epoch = rmf_traffic::Time(rmf_traffic::Duration(0));
+  for (std::size_t i = _path.size(); i < path.size(); ++i)
+  {
+    if (i > 0)
+    {
+      _segments.push_back(
+        rmf_traffic::agv::Interpolate::positions(
+          traits, epoch, {path[i-1], path[i]}));
+    }
+
+    _path.push_back(path[i]);
+  }
+
+  const auto start_time = rmf_traffic_ros2::convert(state.location.t);
+  const Eigen::Vector3d p{state.location.x, state.location.y,
+    state.location.yaw};
+
+  rmf_traffic::Trajectory trajectory;
+  if (path.empty())
+  {
+    trajectory.insert(start_time, p, Eigen::Vector3d::Zero());
+  }
+  else
+  {
+    trajectory = rmf_traffic::agv::Interpolate::positions(
+      traits, start_time, {p, path.front()});
+
+    if (trajectory.size() == 0)
+      trajectory.insert(start_time, p, Eigen::Vector3d::Zero());
+
+    for (const auto& segment : _segments)
+      append_shifted(trajectory, segment);
+  }
+
+  if (trajectory.size() < 2)
+  {
+    // If a robot state results in a single-point trajectory, then we should
+    // make a temporary sitting trajectory.
+    rmf_traffic::Trajectory sitting;
+    sitting.insert(start_time, p, Eigen::Vector3d::Zero());
+
+    const auto finish_time = start_time + std::chrono::seconds(10);
+    sitting.insert(finish_time, p, Eigen::Vector3d::Zero());
+
+    is_sitting = true;
+    return sitting;
+  }
+
+  is_sitting = false;
+  return trajectory;
+}
+
+//==============================================================================
+void TrajectoryBuilder::reset()
+{
+  _segments.clear();
+  _path.clear();
+}
+
 //==============================================================================
 rmf_traffic::Route make_route(
   const rmf_fleet_msgs::msg::RobotState& state,
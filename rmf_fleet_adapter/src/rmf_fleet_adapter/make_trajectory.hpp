@@ -24,6 +24,8 @@
 
 #include <rmf_fleet_msgs/msg/robot_state.hpp>
 
+#include <deque>
+
 //==============================================================================
 rmf_traffic::Trajectory make_trajectory(
   const rmf_fleet_msgs::msg::RobotState& state,
@@ -41,6 +43,36 @@ rmf_traffic::Trajectory make_timed_trajectory(
   const std::vector<rmf_fleet_msgs::msg::Location>& path,
   const rmf_traffic::agv::VehicleTraits& traits);
 
+//==============================================================================
+/// Builds the trajectory of a robot state like make_trajectory(), but keeps
+/// the interpolated segments between the points of the last path that it was
+/// given. When the next path only dropped points from its front or added
+/// points to its back, which is how the path of a robot usually changes while
+/// it makes progress, only the segment from the robot to its next point and
+/// any new segments get interpolated.
+///
+/// Each point of the path is treated as a stop, so a path whose consecutive
+/// segments are collinear may get a slightly longer trajectory than
+/// make_trajectory() would produce.
+class TrajectoryBuilder
+{
+public:
+
+  rmf_traffic::Trajectory build(
+    const rmf_fleet_msgs::msg::RobotState& state,
+    const rmf_traffic::agv::VehicleTraits& traits,
+    bool& is_sitting);
+
+  /// Forget the segments of the last path
+  void reset();
+
+private:
+
+  // The segment from _path[i] to _path[i+1], starting from the epoch
+  std::deque<rmf_traffic::Trajectory> _segments;
+  std::deque<Eigen::Vector3d> _path;
+};
+
 //==============================================================================
 rmf_traffic::Route make_route(
   const rmf_fleet_msgs::msg::RobotState& state,
@@ -108,11 +108,11 @@ void DispenseItem::ActivePhase::_init_obs()
       DispenserState::SharedPtr>;
 
   const auto& node = _context->node();
-  _obs = node->dispenser_result()
+  _obs = node->dispenser_result(_request_guid)
     .start_with(std::shared_ptr<DispenserResult>(nullptr))
     .combine_latest(
     rxcpp::observe_on_event_loop(),
-    node->dispenser_state().start_with(
+    node->dispenser_state(_target).start_with(
       std::shared_ptr<DispenserState>(nullptr)))
     .lift<CombinedType>(on_subscribe([weak = weak_from_this(), &node]()
       {
@@ -86,16 +86,6 @@ void DoorClose::ActivePhase::_init_obs()
 
         me->_status.state = LegacyTask::StatusMsg::STATE_ACTIVE;
         me->_publish_close_door();
-        me->_timer = me->_context->node()->try_create_wall_timer(
-          std::chrono::milliseconds(1000),
-          [weak]()
-          {
-            auto me = weak.lock();
-            if (!me)
-              return;
-
-            me->_publish_close_door();
-          });
       }))
     .map([weak = weak_from_this()](const auto& heartbeat)
       {
@@ -113,7 +103,7 @@ void DoorClose::ActivePhase::_init_obs()
         if (!me)
           return;
 
-        me->_timer.reset();
+        me->_door_request.reset();
       });
 }
 
@@ -125,7 +115,8 @@ void DoorClose::ActivePhase::_publish_close_door()
   msg.request_time = _context->node()->now();
   msg.requested_mode.value = rmf_door_msgs::msg::DoorMode::MODE_CLOSED;
   msg.requester_id = _request_id;
-  _context->node()->door_request()->publish(msg);
+  _door_request = _context->node()->request_coalescer()->request_door(
+    std::move(msg));
 }
 
 //==============================================================================
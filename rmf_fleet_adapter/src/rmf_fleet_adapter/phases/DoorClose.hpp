@@ -34,7 +34,7 @@ struct DoorClose
   /**
    * The phase should do the following
    * 1. Send out a MODE_CLOSED door request
-   * 2. Periodically resend the close request while the supervisor state contains the requester_id
+   * 2. The node's request coalescer resends the close request while the supervisor state contains the requester_id
    * 3. It is completed when the supervisor state does NOT contains the requester_id, regardless of the door state
    * 4. Cancellation requests are ignored
    */
@@ -65,7 +65,7 @@ struct DoorClose
     std::string _request_id;
     rxcpp::observable<LegacyTask::StatusMsg> _obs;
     std::string _description;
-    rclcpp::TimerBase::SharedPtr _timer;
+    agv::RequestCoalescer::RegistrationPtr _door_request;
     LegacyTask::StatusMsg _status;
 
     ActivePhase(
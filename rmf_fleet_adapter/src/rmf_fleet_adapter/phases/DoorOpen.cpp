@@ -99,7 +99,7 @@ void DoorOpen::ActivePhase::_init_obs()
   using rmf_door_msgs::msg::SupervisorHeartbeat;
   using CombinedType = std::tuple<DoorState::SharedPtr,
       SupervisorHeartbeat::SharedPtr>;
-  _obs = transport->door_state().combine_latest(
+  _obs = transport->door_state(_door_name).combine_latest(
     rxcpp::observe_on_event_loop(),
     transport->door_supervisor())
     .lift<CombinedType>(on_subscribe([weak = weak_from_this(), transport]()
@@ -118,10 +118,6 @@ void DoorOpen::ActivePhase::_init_obs()
           if (!me)
             return;
 
-          // TODO(MXG): We can stop publishing the door request once the
-          // supervisor sees our request.
-          me->_publish_open_door();
-
           const auto current_expected_finish =
           me->_expected_finish + me->_context->itinerary().delay();
 
@@ -153,6 +149,7 @@ void DoorOpen::ActivePhase::_init_obs()
           return;
 
         me->_timer.reset();
+        me->_door_request.reset();
       })
     // When the phase is cancelled, queue a door close phase to make sure that there is no hanging
     // open doors
@@ -188,7 +185,8 @@ void DoorOpen::ActivePhase::_publish_open_door()
   msg.request_time = _context->node()->now();
   msg.requested_mode.value = rmf_door_msgs::msg::DoorMode::MODE_OPEN;
   msg.requester_id = _request_id;
-  _context->node()->door_request()->publish(msg);
+  _door_request = _context->node()->request_coalescer()->request_door(
+    std::move(msg));
 }
 
 //==============================================================================
@@ -35,7 +35,7 @@ struct DoorOpen
   /**
    * The phase should do the following
    * 1. Send out a MODE_OPEN door request
-   * 3. Periodically resend the open request while the supervisor state does not contain the requester_id
+   * 3. The node's request coalescer resends the open request while the supervisor state does not contain the requester_id
    * 2. It is completed when the supervisor state contains the requester_id and the door has an OPEN mode
    * 4. If cancelled, should start a door close phase
    */
@@ -71,6 +71,7 @@ struct DoorOpen
     rxcpp::observable<LegacyTask::StatusMsg> _obs;
     std::string _description;
     rclcpp::TimerBase::SharedPtr _timer;
+    agv::RequestCoalescer::RegistrationPtr _door_request;
     LegacyTask::StatusMsg _status;
     std::shared_ptr<DoorClose::ActivePhase> _door_close_phase;
 
@@ -110,6 +111,11 @@ struct DoorOpen
       return _door_name;
     }
 
+    rmf_traffic::Time expected_finish() const
+    {
+      return _expected_finish;
+    }
+
   private:
 
     agv::RobotContextPtr _context;
@@ -85,7 +85,22 @@ void EndLiftSession::Active::_init_obs()
 {
   using rmf_lift_msgs::msg::LiftRequest;
   using rmf_lift_msgs::msg::LiftState;
-  _obs = _context->node()->lift_state()
+  _session = _context->lift_session(_lift_name);
+  if (const auto& sharing = _context->lift_session_sharing())
+  {
+    if (!sharing->leave(_lift_name, _context->requester_id()))
+    {
+      // Other robots are still riding in this session, so the last of them
+      // will end it.
+      LegacyTask::StatusMsg msg;
+      msg.status = "success";
+      msg.state = LegacyTask::StatusMsg::STATE_COMPLETED;
+      _obs = rxcpp::observable<>::just(msg);
+      return;
+    }
+  }
+
+  _obs = _context->node()->lift_state(_lift_name)
     .lift<LiftState::SharedPtr>(on_subscribe([weak = weak_from_this()]()
       {
         const auto me = weak.lock();
@@ -93,16 +108,6 @@ void EndLiftSession::Active::_init_obs()
           return;
 
         me->_publish_session_end();
-        me->_timer = me->_context->node()->try_create_wall_timer(
-          std::chrono::milliseconds(1000),
-          [weak]()
-          {
-            const auto me = weak.lock();
-            if (!me)
-              return;
-
-            me->_publish_session_end();
-          });
       }))
     .map([weak = weak_from_this()](const LiftState::SharedPtr& state)
       {
@@ -116,7 +121,7 @@ void EndLiftSession::Active::_init_obs()
         if (state->lift_name != me->_lift_name)
           return msg;
 
-        if (state->session_id != me->_context->requester_id())
+        if (state->session_id != me->_session)
         {
           msg.status = "success";
           msg.state = LegacyTask::StatusMsg::STATE_COMPLETED;
@@ -131,7 +136,7 @@ void EndLiftSession::Active::_init_obs()
         if (!me)
           return;
 
-        me->_timer.reset();
+        me->_lift_request.reset();
       });
 }
 
@@ -142,9 +147,10 @@ void EndLiftSession::Active::_publish_session_end()
   msg.lift_name = _lift_name;
   msg.destination_floor = _destination;
   msg.request_type = rmf_lift_msgs::msg::LiftRequest::REQUEST_END_SESSION;
-  msg.session_id = _context->requester_id();
+  msg.session_id = _session;
 
-  _context->node()->lift_request()->publish(msg);
+  _lift_request = _context->node()->request_coalescer()->request_lift(
+    std::move(msg));
 }
 
 //==============================================================================
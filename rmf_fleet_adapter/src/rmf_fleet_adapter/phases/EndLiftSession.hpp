@@ -59,7 +59,10 @@ struct EndLiftSession
     std::string _destination;
     std::string _description;
     rxcpp::observable<LegacyTask::StatusMsg> _obs;
-    rclcpp::TimerBase::SharedPtr _timer;
+    agv::RequestCoalescer::RegistrationPtr _lift_request;
+
+    // The session that gets ended
+    std::string _session;
 
     void _init_obs();
     void _publish_session_end();
@@ -137,6 +137,13 @@ void GoToPlace::Active::respond(
       responder, std::move(approval_cb), evaluator);
   }
 
+  using namespace std::chrono_literals;
+  const auto wait_duration = 2s + table_viewer->sequence().back().version * 10s;
+
+  // Offer the best plan found so far before the negotiation timer runs out,
+  // and keep improving on it until then.
+  negotiate->anytime(wait_duration / 2);
+
   auto negotiate_sub =
     rmf_rxcpp::make_job<services::Negotiate::Result>(negotiate)
     .observe_on(rxcpp::identity_same_worker(_context->worker()))
@@ -146,7 +153,8 @@ void GoToPlace::Active::respond(
       if (auto phase = w.lock())
       {
         result.respond();
-        phase->_negotiate_services.erase(result.service);
+        if (!result.interim)
+          phase->_negotiate_services.erase(result.service);
       }
       else
       {
@@ -159,8 +167,6 @@ void GoToPlace::Active::respond(
       }
     });
 
-  using namespace std::chrono_literals;
-  const auto wait_duration = 2s + table_viewer->sequence().back().version * 10s;
   auto negotiate_timer = _context->node()->try_create_wall_timer(
     wait_duration,
     [s = negotiate->weak_from_this()]
@@ -282,7 +288,7 @@ void GoToPlace::Active::find_emergency_plan()
   _pullover_service = std::make_shared<services::FindEmergencyPullover>(
     _context->planner(), _context->location(),
     _context->schedule()->snapshot(), _context->itinerary().id(),
-    _context->profile());
+    _context->profile(), _context->pullover_candidates(_context->location()));
 
   _plan_subscription = rmf_rxcpp::make_job<
     services::FindEmergencyPullover::Result>(_pullover_service)
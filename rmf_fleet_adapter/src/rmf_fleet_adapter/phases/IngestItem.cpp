@@ -108,11 +108,12 @@ void IngestItem::ActivePhase::_init_obs()
       IngestorState::SharedPtr>;
 
   const auto& node = _context->node();
-  _obs = node->ingestor_result()
+  _obs = node->ingestor_result(_request_guid)
     .start_with(std::shared_ptr<IngestorResult>(nullptr))
     .combine_latest(
     rxcpp::observe_on_event_loop(),
-    node->ingestor_state().start_with(std::shared_ptr<IngestorState>(nullptr)))
+    node->ingestor_state(_target).start_with(
+      std::shared_ptr<IngestorState>(nullptr)))
     .lift<CombinedType>(on_subscribe([weak = weak_from_this(), &node]()
       {
         auto me = weak.lock();
@@ -19,6 +19,8 @@
 #include "EndLiftSession.hpp"
 #include "RxOperators.hpp"
 
+#include <cmath>
+
 namespace rmf_fleet_adapter {
 namespace phases {
 
@@ -28,7 +30,8 @@ std::shared_ptr<RequestLift::ActivePhase> RequestLift::ActivePhase::make(
   std::string lift_name,
   std::string destination,
   rmf_traffic::Time expected_finish,
-  const Located located)
+  const Located located,
+  std::optional<std::string> ride_to)
 {
   auto inst = std::shared_ptr<ActivePhase>(
     new ActivePhase(
@@ -36,7 +39,8 @@ std::shared_ptr<RequestLift::ActivePhase> RequestLift::ActivePhase::make(
       std::move(lift_name),
       std::move(destination),
       std::move(expected_finish),
-      located
+      located,
+      std::move(ride_to)
   ));
   inst->_init_obs();
   return inst;
@@ -80,13 +84,17 @@ RequestLift::ActivePhase::ActivePhase(
   std::string lift_name,
   std::string destination,
   rmf_traffic::Time expected_finish,
-  Located located)
+  Located located,
+  std::optional<std::string> ride_to)
 : _context(std::move(context)),
   _lift_name(std::move(lift_name)),
   _destination(std::move(destination)),
   _expected_finish(std::move(expected_finish)),
-  _located(located)
+  _located(located),
+  _ride_to(std::move(ride_to))
 {
+  _session = _context->lift_session(_lift_name);
+
   std::ostringstream oss;
   oss << "Requesting lift [" << lift_name << "] to [" << destination << "]";
 
@@ -98,7 +106,7 @@ void RequestLift::ActivePhase::_init_obs()
 {
   using rmf_lift_msgs::msg::LiftState;
 
-  _obs = _context->node()->lift_state()
+  _obs = _context->node()->lift_state(_lift_name)
     .lift<LiftState::SharedPtr>(
     on_subscribe(
       [weak = weak_from_this()]()
@@ -116,9 +124,15 @@ void RequestLift::ActivePhase::_init_obs()
             if (!me)
               return;
 
-            // TODO(MXG): We can stop publishing the door request once the
-            // supervisor sees our request.
-            me->_do_publish();
+            // Send the robot's real destination once the rest of its shared
+            // ride has boarded
+            const auto& sharing = me->_context->lift_session_sharing();
+            if (me->_held && sharing && !sharing->hold_at(
+                me->_lift_name, me->_context->requester_id(),
+                me->_context->now()))
+            {
+              me->_do_publish();
+            }
 
             const auto current_expected_finish =
             me->_expected_finish + me->_context->itinerary().delay();
@@ -154,6 +168,7 @@ void RequestLift::ActivePhase::_init_obs()
           status.state == LegacyTask::StatusMsg::STATE_FAILED)
         {
           me->_timer.reset();
+          me->_lift_request.reset();
           return false;
         }
         return true;
@@ -196,7 +211,7 @@ LegacyTask::StatusMsg RequestLift::ActivePhase::_get_status(
     lift_state->lift_name == _lift_name &&
     lift_state->current_floor == _destination &&
     lift_state->door_state == LiftState::DOOR_OPEN &&
-    lift_state->session_id == _context->requester_id())
+    lift_state->session_id == _session)
   {
     bool completed = false;
     const auto& watchdog = _context->get_lift_watchdog();
@@ -245,6 +260,7 @@ LegacyTask::StatusMsg RequestLift::ActivePhase::_get_status(
                   me->_rewait_timer.reset();
                   me->_reset_session_subscription =
                   rmf_rxcpp::subscription_guard();
+                  me->_do_publish();
                 }
               });
             break;
@@ -276,6 +292,7 @@ LegacyTask::StatusMsg RequestLift::ActivePhase::_get_status(
       status.state = LegacyTask::StatusMsg::STATE_COMPLETED;
       status.status = "success";
       _timer.reset();
+      _lift_request.reset();
     }
   }
   else if (_rewaiting)
@@ -291,7 +308,7 @@ LegacyTask::StatusMsg RequestLift::ActivePhase::_get_status(
       + lift_state->current_floor + " vs " + _destination + " | "
       + std::to_string(static_cast<int>(lift_state->door_state))
       + " vs " + std::to_string(static_cast<int>(LiftState::DOOR_OPEN))
-      + " | " + lift_state->session_id + " vs " + _context->requester_id();
+      + " | " + lift_state->session_id + " vs " + _session;
   }
 
   return status;
@@ -303,15 +320,45 @@ void RequestLift::ActivePhase::_do_publish()
   if (_rewaiting)
     return;
 
+  std::string destination = _destination;
+  _held = false;
+  if (const auto& sharing = _context->lift_session_sharing())
+  {
+    const auto& requester_id = _context->requester_id();
+    if (_located == Located::Outside && _ride_to.has_value())
+    {
+      const double radius =
+        _context->profile()->footprint()->get_characteristic_length();
+      sharing->join(
+        _lift_name, _destination, *_ride_to, requester_id,
+        M_PI * radius * radius, _context->now());
+    }
+    else if (_located == Located::Inside)
+    {
+      sharing->board(_lift_name, requester_id);
+      const auto hold = sharing->hold_at(
+        _lift_name, requester_id, _context->now());
+      if (hold.has_value())
+      {
+        // Keep the lift where it is until the rest of the ride has boarded
+        destination = *hold;
+        _held = true;
+      }
+    }
+  }
+
+  _session = _context->lift_session(_lift_name);
+
   rmf_lift_msgs::msg::LiftRequest msg{};
   msg.lift_name = _lift_name;
-  msg.destination_floor = _destination;
-  msg.session_id = _context->requester_id();
+  msg.destination_floor = destination;
+  msg.session_id = _session;
   msg.request_time = _context->node()->now();
   msg.request_type = rmf_lift_msgs::msg::LiftRequest::REQUEST_AGV_MODE;
   msg.door_state = rmf_lift_msgs::msg::LiftRequest::DOOR_OPEN;
 
-  _context->node()->lift_request()->publish(msg);
+  _lift_request = _context->node()->request_coalescer()->request_lift(
+    std::move(msg));
 }
 
 //==============================================================================
@@ -341,7 +388,15 @@ std::shared_ptr<LegacyTask::ActivePhase> RequestLift::PendingPhase::begin()
     _lift_name,
     _destination,
     _expected_finish,
-    _located);
+    _located,
+    _ride_to);
+}
+
+//==============================================================================
+auto RequestLift::PendingPhase::ride_to(std::string floor) -> PendingPhase&
+{
+  _ride_to = std::move(floor);
+  return *this;
 }
 
 //==============================================================================
@@ -44,7 +44,8 @@ struct RequestLift
       std::string lift_name,
       std::string destination,
       rmf_traffic::Time expected_finish,
-      Located located);
+      Located located,
+      std::optional<std::string> ride_to = std::nullopt);
 
     const rxcpp::observable<LegacyTask::StatusMsg>& observe() const override;
 
@@ -67,10 +68,21 @@ struct RequestLift
     std::string _description;
     rxcpp::observable<LegacyTask::StatusMsg> _obs;
     rclcpp::TimerBase::SharedPtr _timer;
+    agv::RequestCoalescer::RegistrationPtr _lift_request;
     std::shared_ptr<EndLiftSession::Active> _lift_end_phase;
     Located _located;
     rmf_rxcpp::subscription_guard _reset_session_subscription;
 
+    // The floor that the robot will ride the lift to once it is inside, which
+    // lets it share the ride with other robots going the same way
+    std::optional<std::string> _ride_to;
+
+    // The session that the latest request was made with
+    std::string _session;
+
+    // True while the lift is being held for the rest of a shared ride
+    bool _held = false;
+
     struct WatchdogInfo
     {
       std::mutex mutex;
@@ -86,7 +98,8 @@ struct RequestLift
       std::string lift_name,
       std::string destination,
       rmf_traffic::Time expected_finish,
-      Located located);
+      Located located,
+      std::optional<std::string> ride_to);
 
     void _init_obs();
 
@@ -118,12 +131,27 @@ struct RequestLift
       return _lift_name;
     }
 
+    const std::string& destination() const
+    {
+      return _destination;
+    }
+
+    Located located() const
+    {
+      return _located;
+    }
+
+    /// Set the floor that the robot will ride the lift to after it boards.
+    /// This only matters for a request from outside of the lift.
+    PendingPhase& ride_to(std::string floor);
+
   private:
     agv::RobotContextPtr _context;
     std::string _lift_name;
     std::string _destination;
     rmf_traffic::Time _expected_finish;
     Located _located;
+    std::optional<std::string> _ride_to;
     std::string _description;
   };
 };
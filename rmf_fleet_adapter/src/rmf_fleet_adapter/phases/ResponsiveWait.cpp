@@ -19,6 +19,8 @@
 
 #include <rmf_traffic_ros2/Time.hpp>
 
+#include <rmf_traffic/Trajectory.hpp>
+
 namespace rmf_fleet_adapter {
 namespace phases {
 
@@ -46,6 +48,14 @@ rmf_traffic::Duration ResponsiveWait::Active::estimate_remaining_time() const
 //==============================================================================
 void ResponsiveWait::Active::emergency_alarm(bool on)
 {
+  if (_idle)
+  {
+    if (!on)
+      return;
+
+    _wake();
+  }
+
   if (!_movement)
   {
     // *INDENT-OFF*
@@ -66,6 +76,16 @@ void ResponsiveWait::Active::cancel()
   // issues that it is finished.
   _info.period.reset();
 
+  if (_idle)
+  {
+    // There is no movement to wait for while idling
+    _idle = false;
+    _idle_negotiator = nullptr;
+    _idle_refresh_timer = nullptr;
+    _status_publisher.get_subscriber().on_completed();
+    return;
+  }
+
   // Now we cancel the movement and wait for the underlying GoToPlace phase to
   // report that it is finished.
   _movement->cancel();
@@ -144,8 +164,13 @@ void ResponsiveWait::Active::_begin_movement()
       if (me->_info.period.has_value())
       {
         // If this is an uncanceled indefinite wait, then we will begin the
-        // movement again.
-        me->_begin_movement();
+        // movement again, unless we can hold still until someone needs us to
+        // move.
+        if (me->_info.idle_horizon.has_value())
+          me->_begin_idle();
+        else
+          me->_begin_movement();
+
         return;
       }
 
@@ -153,6 +178,100 @@ void ResponsiveWait::Active::_begin_movement()
     });
 }
 
+//==============================================================================
+void ResponsiveWait::Active::_begin_idle()
+{
+  _idle = true;
+  _movement_subscription = rmf_rxcpp::subscription_guard();
+  _movement = nullptr;
+
+  _publish_idle_itinerary();
+
+  if (!_idle_negotiator)
+  {
+    _idle_negotiator = Negotiator::make(
+      _info.context,
+      [w = weak_from_this()](
+        const auto& table_viewer,
+        const auto& responder) -> Negotiator::NegotiatePtr
+      {
+        const auto me = w.lock();
+        if (!me)
+        {
+          responder->forfeit({});
+          return nullptr;
+        }
+
+        me->_wake();
+        const auto movement =
+          std::dynamic_pointer_cast<rmf_traffic::schedule::Negotiator>(
+          me->_movement);
+        if (movement)
+          movement->respond(table_viewer, responder);
+        else
+          responder->forfeit({});
+
+        return nullptr;
+      });
+  }
+  else
+  {
+    _idle_negotiator->claim_license();
+  }
+
+  _idle_refresh_timer = _info.context->node()->try_create_wheel_timer(
+    *_info.idle_horizon / 2,
+    [w = weak_from_this()]()
+    {
+      if (const auto me = w.lock())
+      {
+        if (me->_idle)
+          me->_publish_idle_itinerary();
+      }
+    });
+}
+
+//==============================================================================
+void ResponsiveWait::Active::_wake()
+{
+  if (!_idle)
+    return;
+
+  _idle = false;
+  _idle_refresh_timer = nullptr;
+
+  // The negotiator may be the one that is calling us, so we only give up its
+  // license here instead of destroying it. The movement claims a new one.
+  if (_idle_negotiator)
+    _idle_negotiator->clear_license();
+
+  _begin_movement();
+}
+
+//==============================================================================
+void ResponsiveWait::Active::_publish_idle_itinerary()
+{
+  const auto& graph = _info.context->navigation_graph();
+  const auto& wp = graph.get_waypoint(_info.waiting_point);
+
+  double yaw = 0.0;
+  const auto location = _info.context->location();
+  if (!location.empty())
+    yaw = location.front().orientation();
+
+  const Eigen::Vector3d position{wp.get_location().x(), wp.get_location().y(),
+    yaw};
+
+  const auto now = _info.context->now();
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(now, position, Eigen::Vector3d::Zero());
+  trajectory.insert(
+    now + *_info.idle_horizon, position, Eigen::Vector3d::Zero());
+
+  _info.context->itinerary().set(
+    {rmf_traffic::Route(wp.get_map_name(), std::move(trajectory))});
+}
+
 //==============================================================================
 std::shared_ptr<LegacyTask::ActivePhase> ResponsiveWait::Pending::begin()
 {
@@ -192,6 +311,7 @@ auto ResponsiveWait::make_until(
     waiting_point,
     finish_time,
     std::nullopt,
+    std::nullopt,
     ""
   };
 
@@ -205,13 +325,16 @@ auto ResponsiveWait::make_until(
 auto ResponsiveWait::make_indefinite(
   agv::RobotContextPtr context,
   std::size_t waiting_point,
-  rmf_traffic::Duration update_period) -> std::unique_ptr<Pending>
+  rmf_traffic::Duration update_period,
+  std::optional<rmf_traffic::Duration> idle_horizon)
+-> std::unique_ptr<Pending>
 {
   PhaseInfo info{
     std::move(context),
     waiting_point,
     std::nullopt,
     update_period,
+    idle_horizon,
     ""
   };
 
@@ -19,6 +19,7 @@
 #define SRC__RMF_FLEET_ADAPTER__PHASES__RESPONSIVEWAIT_HPP
 
 #include "GoToPlace.hpp"
+#include "../Negotiator.hpp"
 
 namespace rmf_fleet_adapter {
 namespace phases {
@@ -33,6 +34,7 @@ private:
     std::size_t waiting_point;
     std::optional<rmf_traffic::Time> finish_time;
     std::optional<rmf_traffic::Duration> period;
+    std::optional<rmf_traffic::Duration> idle_horizon;
     std::string description;
   };
 
@@ -68,11 +70,24 @@ public:
 
     void _begin_movement();
 
+    /// Hold the robot at its waiting point without planning until a
+    /// negotiation or an emergency asks it to move
+    void _begin_idle();
+
+    /// Stop idling and resume planning the wait
+    void _wake();
+
+    /// Schedule the robot to stay at its waiting point for the idle horizon
+    void _publish_idle_itinerary();
+
     PhaseInfo _info;
     rxcpp::observable<StatusMsg> _status_obs;
     rxcpp::subjects::subject<StatusMsg> _status_publisher;
     rmf_rxcpp::subscription_guard _movement_subscription;
     std::shared_ptr<LegacyTask::ActivePhase> _movement;
+    std::shared_ptr<Negotiator> _idle_negotiator;
+    agv::TimerWheel::TimerPtr _idle_refresh_timer;
+    bool _idle = false;
   };
 
   class Pending : public LegacyTask::PendingPhase
@@ -133,10 +148,18 @@ public:
   ///
   /// \param[in] update_period
   ///   The scheduling period for the waiting
+  ///
+  /// \param[in] idle_horizon
+  ///   If this is set, the phase stops re-planning every update_period once
+  ///   the robot has arrived at the waiting point. It schedules the robot to
+  ///   stay there for this long instead, renews that itinerary when half of
+  ///   it has passed, and only plans again when a negotiation or an emergency
+  ///   alarm needs the robot to respond.
   static std::unique_ptr<Pending> make_indefinite(
     agv::RobotContextPtr context,
     std::size_t waiting_point,
-    rmf_traffic::Duration update_period = std::chrono::seconds(30));
+    rmf_traffic::Duration update_period = std::chrono::seconds(30),
+    std::optional<rmf_traffic::Duration> idle_horizon = std::nullopt);
 };
 
 } // namespace phases
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "route_shape.hpp"
+
+#include <functional>
+
+namespace rmf_fleet_adapter {
+
+namespace {
+//==============================================================================
+void hash_combine(std::size_t& seed, const std::size_t value)
+{
+  seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+}
+
+//==============================================================================
+void hash_vector(std::size_t& seed, const Eigen::Vector3d& v)
+{
+  for (int i = 0; i < 3; ++i)
+    hash_combine(seed, std::hash<double>()(v[i]));
+}
+} // anonymous namespace
+
+//==============================================================================
+std::size_t route_shape_hash(const rmf_traffic::Route& route)
+{
+  std::size_t seed = std::hash<std::string>()(route.map());
+  const auto& trajectory = route.trajectory();
+  hash_combine(seed, trajectory.size());
+  if (trajectory.empty())
+    return seed;
+
+  const auto start = trajectory.front().time();
+  for (const auto& wp : trajectory)
+  {
+    hash_combine(seed, std::hash<rmf_traffic::Duration::rep>()(
+        (wp.time() - start).count()));
+    hash_vector(seed, wp.position());
+    hash_vector(seed, wp.velocity());
+  }
+
+  return seed;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration> route_time_shift(
+  const rmf_traffic::Route& from,
+  const rmf_traffic::Route& to)
+{
+  if (from.map() != to.map())
+    return std::nullopt;
+
+  const auto& t_from = from.trajectory();
+  const auto& t_to = to.trajectory();
+  if (t_from.size() != t_to.size() || t_from.empty())
+    return std::nullopt;
+
+  const auto shift = t_to.front().time() - t_from.front().time();
+  auto it_from = t_from.begin();
+  auto it_to = t_to.begin();
+  for (; it_from != t_from.end(); ++it_from, ++it_to)
+  {
+    if (it_to->time() - it_from->time() != shift)
+      return std::nullopt;
+
+    if (it_to->position() != it_from->position())
+      return std::nullopt;
+
+    if (it_to->velocity() != it_from->velocity())
+      return std::nullopt;
+  }
+
+  return shift;
+}
+
+} // namespace rmf_fleet_adapter
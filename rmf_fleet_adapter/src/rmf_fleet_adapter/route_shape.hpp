@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__ROUTE_SHAPE_HPP
+#define SRC__RMF_FLEET_ADAPTER__ROUTE_SHAPE_HPP
+
+#include <rmf_traffic/Route.hpp>
+
+#include <optional>
+
+namespace rmf_fleet_adapter {
+
+//==============================================================================
+/// Hash the motion of a route: its map, and the positions, velocities, and
+/// relative timing of its waypoints. The absolute start time is left out, so
+/// the hash of a route does not change when it gets delayed.
+std::size_t route_shape_hash(const rmf_traffic::Route& route);
+
+//==============================================================================
+/// If the two routes follow the same motion and differ only in their timing,
+/// get how far the second route is shifted from the first.
+std::optional<rmf_traffic::Duration> route_time_shift(
+  const rmf_traffic::Route& from,
+  const rmf_traffic::Route& to);
+
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__ROUTE_SHAPE_HPP
@@ -26,12 +26,14 @@ FindEmergencyPullover::FindEmergencyPullover(
   rmf_traffic::agv::Plan::StartSet starts,
   std::shared_ptr<const rmf_traffic::schedule::Snapshot> schedule,
   rmf_traffic::schedule::ParticipantId participant_id,
-  std::shared_ptr<const rmf_traffic::Profile> profile)
+  std::shared_ptr<const rmf_traffic::Profile> profile,
+  std::vector<std::size_t> candidates)
 : _planner(std::move(planner)),
   _starts(std::move(starts)),
   _schedule(std::move(schedule)),
   _participant_id(participant_id),
-  _profile(std::move(profile))
+  _profile(std::move(profile)),
+  _candidates(std::move(candidates))
 {
   // Do nothing
 }
@@ -42,6 +44,9 @@ void FindEmergencyPullover::interrupt()
   _interrupted = true;
   for (const auto& s : _search_jobs)
     s->interrupt();
+
+  if (_fallback)
+    _fallback->interrupt();
 }
 
 } // namespace services
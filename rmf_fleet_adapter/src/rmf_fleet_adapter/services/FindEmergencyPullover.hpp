@@ -30,12 +30,16 @@ class FindEmergencyPullover
 {
 public:
 
+  /// \param[in] candidates
+  ///   The parking spots to plan towards. When this is empty, or when none of
+  ///   these candidates can be reached, every parking spot is tried.
   FindEmergencyPullover(
     std::shared_ptr<const rmf_traffic::agv::Planner> planner,
     rmf_traffic::agv::Plan::StartSet starts,
     std::shared_ptr<const rmf_traffic::schedule::Snapshot> schedule,
     rmf_traffic::schedule::ParticipantId participant_id,
-    std::shared_ptr<const rmf_traffic::Profile> profile);
+    std::shared_ptr<const rmf_traffic::Profile> profile,
+    std::vector<std::size_t> candidates = {});
 
   using Result = rmf_traffic::agv::Plan::Result;
 
@@ -53,6 +57,13 @@ private:
   std::shared_ptr<const rmf_traffic::schedule::Snapshot> _schedule;
   rmf_traffic::schedule::ParticipantId _participant_id;
   std::shared_ptr<const rmf_traffic::Profile> _profile;
+  std::vector<std::size_t> _candidates;
+
+  template<typename Subscriber>
+  void _search_all_parking_spots(const Subscriber& s);
+
+  std::shared_ptr<FindEmergencyPullover> _fallback;
+  rmf_rxcpp::subscription_guard _fallback_sub;
 
   std::vector<std::shared_ptr<jobs::SearchForPath>> _search_jobs;
   rmf_rxcpp::subscription_guard _search_sub;
@@ -27,15 +27,21 @@ FindPath::FindPath(
   rmf_traffic::agv::Plan::Goal goal,
   std::shared_ptr<const rmf_traffic::schedule::Snapshot> schedule,
   rmf_traffic::schedule::ParticipantId participant_id,
-  const std::shared_ptr<const rmf_traffic::Profile>& profile)
+  const std::shared_ptr<const rmf_traffic::Profile>& profile,
+  std::shared_ptr<const FindPath> previous,
+  std::optional<double> known_cost)
 {
+  // If a previous attempt is given, its search gets picked back up wherever
+  // that is still valid. A known cost lets the search skip its greedy plan.
   _search_job = std::make_shared<jobs::SearchForPath>(
     std::move(planner),
     std::move(starts),
     std::move(goal),
     std::move(schedule),
     participant_id,
-    profile);
+    profile,
+    previous ? previous->_search_job : nullptr,
+    known_cost);
 }
 
 //==============================================================================
@@ -44,5 +50,12 @@ void FindPath::interrupt()
   _search_job->interrupt();
 }
 
+//==============================================================================
+FindPath& FindPath::policy(const jobs::Planning::Policy& policy)
+{
+  _search_job->set_policy(policy);
+  return *this;
+}
+
 } // namespace services
 } // namespace rmf_fleet_adapter
@@ -36,7 +36,9 @@ public:
     rmf_traffic::agv::Plan::Goal goal,
     std::shared_ptr<const rmf_traffic::schedule::Snapshot> schedule,
     rmf_traffic::schedule::ParticipantId participant_id,
-    const std::shared_ptr<const rmf_traffic::Profile>& profile);
+    const std::shared_ptr<const rmf_traffic::Profile>& profile,
+    std::shared_ptr<const FindPath> previous = nullptr,
+    std::optional<double> known_cost = std::nullopt);
 
   using Result = rmf_traffic::agv::Plan::Result;
 
@@ -45,6 +47,10 @@ public:
 
   void interrupt();
 
+  /// Set the scheduling policy of the planning that this service does. This
+  /// should be called before the service is started.
+  FindPath& policy(const jobs::Planning::Policy& policy);
+
 private:
   std::shared_ptr<jobs::SearchForPath> _search_job;
   rmf_rxcpp::subscription_guard _search_sub;
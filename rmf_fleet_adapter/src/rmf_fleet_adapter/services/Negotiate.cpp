@@ -95,6 +95,13 @@ std::shared_ptr<Negotiate> Negotiate::emergency_pullover(
     evaluator);
 }
 
+//==============================================================================
+Negotiate& Negotiate::anytime(std::optional<rmf_traffic::Duration> deadline)
+{
+  _anytime_deadline = deadline;
+  return *this;
+}
+
 //==============================================================================
 void Negotiate::interrupt()
 {
@@ -142,5 +149,56 @@ void Negotiate::_resume_next()
   top->resume();
 }
 
+//==============================================================================
+std::function<void()> Negotiate::_make_submission(
+  rmf_traffic::agv::Plan plan) const
+{
+  return [plan = std::move(plan),
+      initial_itinerary = _initial_itinerary,
+      approval = _approval,
+      responder = _responder]()
+    {
+      std::vector<rmf_traffic::Route> final_itinerary;
+      final_itinerary.reserve(
+        initial_itinerary.size() + plan.get_itinerary().size());
+
+      for (const auto& it : {initial_itinerary, plan.get_itinerary()})
+      {
+        for (const auto& route : it)
+        {
+          if (route.trajectory().size() > 1)
+            final_itinerary.push_back(route);
+        }
+      }
+
+      responder->submit(
+        std::move(final_itinerary),
+        [plan, approval]() -> UpdateVersion
+        {
+          if (approval)
+            return approval(plan);
+
+          return rmf_utils::nullopt;
+        });
+    };
+}
+
+//==============================================================================
+bool Negotiate::_ready_for_interim() const
+{
+  if (!_anytime_deadline.has_value() || _finished || _viewer->defunct())
+    return false;
+
+  const auto& best = _evaluator.best_result;
+  if (!best.progress || !best.progress->success())
+    return false;
+
+  if (_submitted_cost <= best.cost)
+    return false;
+
+  return *_anytime_deadline
+    <= std::chrono::steady_clock::now() - _search_start;
+}
+
 } // namespace services
 } // namespace rmf_fleet_adapter
@@ -21,8 +21,11 @@
 #include <rmf_traffic/schedule/Negotiator.hpp>
 #include "../jobs/Planning.hpp"
 #include "../jobs/Rollout.hpp"
+#include "PlanningMemory.hpp"
 #include "ProgressEvaluator.hpp"
 
+#include <optional>
+
 namespace rmf_fleet_adapter {
 namespace services {
 
@@ -68,8 +71,24 @@ public:
   {
     std::shared_ptr<Negotiate> service;
     std::function<void()> respond;
+
+    /// True if this is an early proposal from the anytime mode. The service
+    /// will keep searching after it, so it must be kept alive until a Result
+    /// arrives where this is false.
+    bool interim = false;
   };
 
+  /// Turn on the anytime mode. Once the deadline has passed since the search
+  /// began, the best feasible plan that has been found so far gets submitted
+  /// right away while the search continues. Any cheaper plan that is found
+  /// after that gets submitted as an improved proposal, as long as the table
+  /// is still open.
+  ///
+  /// \param[in] deadline
+  ///   How long to search before submitting the best plan so far. Pass in a
+  ///   std::nullopt to only respond once the search is finished.
+  Negotiate& anytime(std::optional<rmf_traffic::Duration> deadline);
+
   template<typename Subscriber>
   void operator()(const Subscriber& s);
 
@@ -87,6 +106,11 @@ private:
 
   void _resume_next();
 
+  std::function<void()> _make_submission(rmf_traffic::agv::Plan plan) const;
+
+  // Returns true if an interim Result should be sent for the current best plan
+  bool _ready_for_interim() const;
+
   std::shared_ptr<const rmf_traffic::agv::Planner> _planner;
   rmf_traffic::agv::Plan::StartSet _starts;
   std::vector<rmf_traffic::agv::Plan::Goal> _goals;
@@ -110,6 +134,9 @@ private:
     }
   };
 
+  // The goal that each job is searching for
+  std::unordered_map<JobPtr, std::size_t> _goal_of_job;
+
   std::unordered_set<JobPtr> _current_jobs;
   std::priority_queue<JobPtr, std::vector<JobPtr>, CompareJobs> _resume_jobs;
   std::vector<JobPtr> _queued_jobs; // Used to keep the jobs alive
@@ -120,6 +147,10 @@ private:
   bool _finished = false;
   bool _attempting_rollout = false;
 
+  std::optional<rmf_traffic::Duration> _anytime_deadline;
+  std::chrono::steady_clock::time_point _search_start;
+  double _submitted_cost = std::numeric_limits<double>::infinity();
+
   using Alternatives = std::vector<rmf_traffic::schedule::Itinerary>;
   rmf_utils::optional<Alternatives> _alternatives;
   std::unordered_set<rmf_traffic::schedule::ParticipantId> _blockers;
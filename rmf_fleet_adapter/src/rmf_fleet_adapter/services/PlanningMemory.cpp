@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "PlanningMemory.hpp"
+
+#include <cmath>
+
+namespace rmf_fleet_adapter {
+namespace services {
+
+namespace {
+//==============================================================================
+void combine(std::size_t& seed, const std::size_t value)
+{
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+//==============================================================================
+std::size_t hash_orientation(const double orientation)
+{
+  // Orientations that only differ by odometry noise belong to the same start
+  return std::hash<int64_t>{}(std::llround(orientation * 100.0));
+}
+} // anonymous namespace
+
+//==============================================================================
+PlanningMemory& PlanningMemory::shared()
+{
+  static PlanningMemory memory;
+  return memory;
+}
+
+//==============================================================================
+PlanningMemory::PlanningMemory(
+  const rmf_traffic::Duration lifetime,
+  const std::size_t capacity)
+: _lifetime(lifetime),
+  _capacity(capacity)
+{
+  // Do nothing
+}
+
+//==============================================================================
+void PlanningMemory::remember(
+  const rmf_traffic::agv::Planner* planner,
+  const ParticipantId participant,
+  const StartSet& starts,
+  const Goal& goal,
+  const double cost)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto k = key(planner, participant, starts, goal);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_entries.size() >= _capacity && _entries.count(k) == 0)
+  {
+    // Drop whatever has gone stale, or the oldest entry if nothing has
+    auto oldest = _entries.begin();
+    for (auto it = _entries.begin(); it != _entries.end(); )
+    {
+      if (_lifetime < now - it->second.time)
+      {
+        it = _entries.erase(it);
+        continue;
+      }
+
+      if (it->second.time < oldest->second.time)
+        oldest = it;
+
+      ++it;
+    }
+
+    if (_entries.size() >= _capacity)
+      _entries.erase(oldest);
+  }
+
+  _entries[k] = Entry{cost, now};
+}
+
+//==============================================================================
+std::optional<double> PlanningMemory::recall(
+  const rmf_traffic::agv::Planner* planner,
+  const ParticipantId participant,
+  const StartSet& starts,
+  const Goal& goal) const
+{
+  const auto k = key(planner, participant, starts, goal);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _entries.find(k);
+  if (it == _entries.end())
+    return std::nullopt;
+
+  if (_lifetime < std::chrono::steady_clock::now() - it->second.time)
+    return std::nullopt;
+
+  return it->second.cost;
+}
+
+//==============================================================================
+std::size_t PlanningMemory::key(
+  const rmf_traffic::agv::Planner* planner,
+  const ParticipantId participant,
+  const StartSet& starts,
+  const Goal& goal) const
+{
+  std::size_t seed = std::hash<const void*>{}(planner);
+  combine(seed, std::hash<ParticipantId>{}(participant));
+
+  for (const auto& start : starts)
+  {
+    combine(seed, start.waypoint());
+    combine(seed, hash_orientation(start.orientation()));
+    combine(seed, start.lane() ? *start.lane() + 1 : 0);
+  }
+
+  combine(seed, goal.waypoint());
+  if (const auto* orientation = goal.orientation())
+    combine(seed, hash_orientation(*orientation));
+
+  return seed;
+}
+
+} // namespace services
+} // namespace rmf_fleet_adapter
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__SERVICES__PLANNINGMEMORY_HPP
+#define SRC__RMF_FLEET_ADAPTER__SERVICES__PLANNINGMEMORY_HPP
+
+#include <rmf_traffic/agv/Planner.hpp>
+#include <rmf_traffic/schedule/Participant.hpp>
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace rmf_fleet_adapter {
+namespace services {
+
+//==============================================================================
+/// Remembers the cost of the plans that recent negotiation tables settled on
+/// for each participant, start set, and goal. The tables of one negotiation
+/// usually differ by only one or two blocking itineraries, so the next table
+/// can open its search with the cost threshold that the last one had to climb
+/// up to, instead of pausing and resuming its way there one leeway step at a
+/// time.
+///
+/// Start times are left out of the key because they move forward between
+/// tables while the robot stays in the same place.
+class PlanningMemory
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+  using StartSet = rmf_traffic::agv::Plan::StartSet;
+  using Goal = rmf_traffic::agv::Plan::Goal;
+
+  /// How long a remembered cost remains useful
+  static constexpr rmf_traffic::Duration DefaultLifetime =
+    std::chrono::seconds(60);
+
+  /// The greatest number of entries that will be remembered
+  static constexpr std::size_t DefaultCapacity = 256;
+
+  /// The memory that all the negotiations of this process share
+  static PlanningMemory& shared();
+
+  PlanningMemory(
+    rmf_traffic::Duration lifetime = DefaultLifetime,
+    std::size_t capacity = DefaultCapacity);
+
+  /// Remember the cost of the plan that was found
+  void remember(
+    const rmf_traffic::agv::Planner* planner,
+    ParticipantId participant,
+    const StartSet& starts,
+    const Goal& goal,
+    double cost);
+
+  /// Get the cost of the last plan that was found for this search, if it is
+  /// still fresh
+  std::optional<double> recall(
+    const rmf_traffic::agv::Planner* planner,
+    ParticipantId participant,
+    const StartSet& starts,
+    const Goal& goal) const;
+
+private:
+
+  // Entries are only identified by this hash. A collision would only cost us
+  // a poorly chosen starting threshold for one search.
+  std::size_t key(
+    const rmf_traffic::agv::Planner* planner,
+    ParticipantId participant,
+    const StartSet& starts,
+    const Goal& goal) const;
+
+  struct Entry
+  {
+    double cost;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  rmf_traffic::Duration _lifetime;
+  std::size_t _capacity;
+  mutable std::mutex _mutex;
+  std::unordered_map<std::size_t, Entry> _entries;
+};
+
+} // namespace services
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__SERVICES__PLANNINGMEMORY_HPP
@@ -28,9 +28,18 @@ template<typename Subscriber>
 void FindEmergencyPullover::operator()(const Subscriber& s)
 {
   const auto& graph = _planner->get_configuration().graph();
-  const std::size_t N = graph.num_waypoints();
-  _search_jobs.reserve(N);
-  for (std::size_t i = 0; i < N; ++i)
+  std::vector<std::size_t> destinations = _candidates;
+  if (destinations.empty())
+  {
+    for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+    {
+      if (graph.get_waypoint(i).is_parking_spot())
+        destinations.push_back(i);
+    }
+  }
+
+  _search_jobs.reserve(destinations.size());
+  for (const auto i : destinations)
   {
     const auto& wp = graph.get_waypoint(i);
     if (wp.is_parking_spot())
@@ -51,6 +60,9 @@ void FindEmergencyPullover::operator()(const Subscriber& s)
     }
   }
 
+  if (_search_jobs.empty() && !_candidates.empty())
+    return _search_all_parking_spots(s);
+
   const std::size_t N_jobs = _search_jobs.size();
   const double initial_max_cost =
     ProgressEvaluator::DefaultEstimateLeeway
@@ -119,6 +131,11 @@ void FindEmergencyPullover::operator()(const Subscriber& s)
           s.on_next(*f->_compliant_evaluator.best_result.progress);
         else if (f->_greedy_evaluator.best_result.progress)
           s.on_next(*f->_greedy_evaluator.best_result.progress);
+        else if (!f->_candidates.empty() && !f->_interrupted)
+        {
+          // The nearest parking spots might all be taken, so try the rest
+          return f->_search_all_parking_spots(s);
+        }
         else
         {
           s.on_error(std::make_exception_ptr(
@@ -138,6 +155,29 @@ void FindEmergencyPullover::operator()(const Subscriber& s)
     });
 }
 
+//==============================================================================
+template<typename Subscriber>
+void FindEmergencyPullover::_search_all_parking_spots(const Subscriber& s)
+{
+  _fallback = std::make_shared<FindEmergencyPullover>(
+    _planner, _starts, _schedule, _participant_id, _profile);
+
+  _fallback_sub = rmf_rxcpp::make_job<Result>(_fallback)
+    .subscribe(
+    [s](const Result& result)
+    {
+      s.on_next(result);
+    },
+    [s](std::exception_ptr e)
+    {
+      s.on_error(e);
+    },
+    [s]()
+    {
+      s.on_completed();
+    });
+}
+
 } // namespace services
 } // namespace rmf_fleet_adapter
 
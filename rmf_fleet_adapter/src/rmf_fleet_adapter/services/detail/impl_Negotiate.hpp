@@ -45,17 +45,19 @@ void Negotiate::operator()(const Subscriber& s)
       return *service_interrupted || viewer->defunct();
     };
 
-  for (const auto& goal : _goals)
+  for (std::size_t g = 0; g < _goals.size(); ++g)
   {
     for (const auto& validator : validators)
     {
       auto job = std::make_shared<jobs::Planning>(
-        _planner, _starts, goal,
+        _planner, _starts, _goals[g],
         rmf_traffic::agv::Plan::Options(validator)
         .interrupter(interrupter));
+      job->priority(jobs::Planning::Priority::Negotiation);
 
       _evaluator.initialize(job->progress());
 
+      _goal_of_job[job] = g;
       _queued_jobs.emplace_back(std::move(job));
     }
   }
@@ -63,10 +65,29 @@ void Negotiate::operator()(const Subscriber& s)
   const double initial_max_cost =
     _evaluator.best_estimate.cost * _evaluator.estimate_leeway;
 
+  _search_start = std::chrono::steady_clock::now();
+
   const std::size_t N_jobs = _queued_jobs.size();
 
+  // If an earlier table of this negotiation already had to search up to a
+  // higher cost for the same goal, then start there right away.
+  const auto participant = _viewer->sequence().back().participant;
+  auto& memory = PlanningMemory::shared();
+  std::vector<double> goal_max_cost(_goals.size(), initial_max_cost);
+  for (std::size_t g = 0; g < _goals.size(); ++g)
+  {
+    const auto remembered =
+      memory.recall(_planner.get(), participant, _starts, _goals[g]);
+
+    if (remembered.has_value())
+      goal_max_cost[g] = std::max(goal_max_cost[g], *remembered);
+  }
+
   for (const auto& job : _queued_jobs)
-    job->progress().options().maximum_cost_estimate(initial_max_cost);
+  {
+    job->progress().options().maximum_cost_estimate(
+      goal_max_cost[_goal_of_job.at(job)]);
+  }
 
   // It's technically okay for us to capture `this` by value here because this
   // lambda will only be used in the callback of _search_sub below, which will
@@ -84,39 +105,26 @@ void Negotiate::operator()(const Subscriber& s)
         {
           _finished = true;
           // This means we found a successful plan to submit to the negotiation.
-          s.on_next(
-            Result{
-              shared_from_this(),
-              [r = *_evaluator.best_result.progress,
-              initial_itinerary = std::move(_initial_itinerary),
-              approval = std::move(_approval),
-              responder = _responder]()
-              {
-                std::vector<rmf_traffic::Route> final_itinerary;
-                final_itinerary.reserve(
-                  initial_itinerary.size() + r->get_itinerary().size());
-
-                for (const auto& it : {initial_itinerary, r->get_itinerary()})
-                {
-                  for (const auto& route : it)
-                  {
-                    if (route.trajectory().size() > 1)
-                      final_itinerary.push_back(route);
-                  }
-                }
-
-                responder->submit(
-                  std::move(final_itinerary),
-                  [plan = *r, approval = std::move(approval)]()
-                  -> UpdateVersion
-                  {
-                    if (approval)
-                      return approval(plan);
-
-                    return rmf_utils::nullopt;
-                  });
-              }
-            });
+          // If the anytime mode already submitted this plan, there is nothing
+          // left to do.
+          const auto& best = _evaluator.best_result;
+          for (const auto& [job, goal] : _goal_of_job)
+          {
+            if (&job->progress() == best.progress)
+            {
+              PlanningMemory::shared().remember(
+                _planner.get(),
+                _viewer->sequence().back().participant,
+                _starts, _goals[goal], best.cost);
+              break;
+            }
+          }
+
+          std::function<void()> respond = [] {};
+          if (best.cost < _submitted_cost)
+            respond = _make_submission(**best.progress);
+
+          s.on_next(Result{shared_from_this(), std::move(respond)});
 
           s.on_completed();
           this->interrupt();
@@ -204,12 +212,31 @@ void Negotiate::operator()(const Subscriber& s)
           if (p == parent_id)
           {
             n->_attempting_rollout = true;
-            auto rollout_source = result.job->progress();
-            static_cast<rmf_traffic::agv::NegotiatingRouteValidator*>(
-              rollout_source.options().validator().get())->mask(parent_id);
+
+            // Roll out every goal that the parent is blocking, except for the
+            // ones whose jobs are in the middle of a slice, so the rollouts
+            // can be expanded in parallel.
+            std::vector<rmf_traffic::agv::Planner::Result> rollout_sources;
+            for (const auto& job : n->_queued_jobs)
+            {
+              if (job != result.job
+              && n->_current_jobs.find(job) != n->_current_jobs.end())
+                continue;
+
+              const auto& blockers = job->progress().blockers();
+              if (job != result.job
+              && std::find(blockers.begin(), blockers.end(), parent_id)
+              == blockers.end())
+                continue;
+
+              auto source = job->progress();
+              static_cast<rmf_traffic::agv::NegotiatingRouteValidator*>(
+                source.options().validator().get())->mask(parent_id);
+              rollout_sources.emplace_back(std::move(source));
+            }
 
             n->_rollout_job = std::make_shared<jobs::Rollout>(
-              std::move(rollout_source), parent_id,
+              std::move(rollout_sources), parent_id,
               std::chrono::seconds(15), 200);
 
             n->_rollout_sub =
@@ -226,6 +253,16 @@ void Negotiate::operator()(const Subscriber& s)
         }
       }
 
+      if (n->_ready_for_interim())
+      {
+        // The deadline of the anytime mode has passed, so offer the best plan
+        // that we have so far while the search keeps going.
+        const auto& best = n->_evaluator.best_result;
+        n->_submitted_cost = best.cost;
+        s.on_next(
+          Result{n, n->_make_submission(**best.progress), true});
+      }
+
       if (!check_if_finished())
       {
         const auto job = result.job;
@@ -253,6 +290,7 @@ void Negotiate::operator()(const Subscriber& s)
               n->_queued_jobs.begin(), n->_queued_jobs.end(), job);
             assert(job_it != n->_queued_jobs.end());
             n->_queued_jobs.erase(job_it);
+            n->_goal_of_job.erase(job);
           }
 
           n->_current_jobs.erase(job);
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "tracing.hpp"
+
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+namespace rmf_fleet_adapter {
+namespace tracing {
+
+namespace {
+//==============================================================================
+struct Buffer
+{
+  std::mutex mutex;
+  std::vector<Record> records;
+  std::size_t capacity = 0;
+  std::size_t next = 0;
+};
+
+//==============================================================================
+Buffer& buffer()
+{
+  static Buffer b;
+  return b;
+}
+
+//==============================================================================
+std::string escape(const std::string& s)
+{
+  std::string output;
+  output.reserve(s.size());
+  for (const char c : s)
+  {
+    if (c == '"' || c == '\\')
+      output.push_back('\\');
+
+    output.push_back(c);
+  }
+
+  return output;
+}
+} // anonymous namespace
+
+namespace detail {
+//==============================================================================
+std::atomic_bool enabled{false};
+
+//==============================================================================
+void push(Record record)
+{
+  auto& b = buffer();
+  std::lock_guard<std::mutex> lock(b.mutex);
+  if (b.capacity == 0)
+    return;
+
+  if (b.records.size() < b.capacity)
+  {
+    b.records.push_back(std::move(record));
+    return;
+  }
+
+  b.records[b.next] = std::move(record);
+  b.next = (b.next + 1) % b.capacity;
+}
+} // namespace detail
+
+//==============================================================================
+void enable(const std::size_t capacity)
+{
+  auto& b = buffer();
+  {
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.records.clear();
+    b.records.reserve(capacity);
+    b.capacity = capacity;
+    b.next = 0;
+  }
+
+  detail::enabled = capacity > 0;
+}
+
+//==============================================================================
+void disable()
+{
+  detail::enabled = false;
+}
+
+//==============================================================================
+std::vector<Record> records()
+{
+  auto& b = buffer();
+  std::lock_guard<std::mutex> lock(b.mutex);
+  std::vector<Record> output;
+  output.reserve(b.records.size());
+  output.insert(output.end(), b.records.begin() + b.next, b.records.end());
+  output.insert(output.end(), b.records.begin(), b.records.begin() + b.next);
+  return output;
+}
+
+//==============================================================================
+bool write_chrome_trace(const std::string& path)
+{
+  const auto all = records();
+  std::ofstream file(path);
+  if (!file.good())
+    return false;
+
+  const auto origin = all.empty() ? Clock::time_point() : all.front().start;
+  const auto us = [](const Clock::duration d)
+    {
+      return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    };
+
+  const auto tid = [](const std::string& task_id)
+    {
+      return static_cast<uint32_t>(std::hash<std::string>()(task_id));
+    };
+
+  // Name the row of each task after its ID
+  file << "[\n";
+  std::unordered_set<std::string> named;
+  for (const auto& r : all)
+  {
+    if (!named.insert(r.task_id).second)
+      continue;
+
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+         << tid(r.task_id) << ",\"args\":{\"name\":\"" << escape(r.task_id)
+         << "\"}},\n";
+  }
+
+  for (std::size_t i = 0; i < all.size(); ++i)
+  {
+    const auto& r = all[i];
+    const auto id = escape(r.task_id);
+    file << (i == 0 ? "" : ",\n")
+         << "{\"name\":\"" << r.name << "\",\"cat\":\"task\""
+         << ",\"pid\":1,\"tid\":" << tid(r.task_id)
+         << ",\"ts\":" << us(r.start - origin);
+
+    if (r.instant)
+      file << ",\"ph\":\"i\",\"s\":\"t\"";
+    else
+      file << ",\"ph\":\"X\",\"dur\":" << us(r.finish - r.start);
+
+    file << ",\"args\":{\"task_id\":\"" << id << "\"}}";
+  }
+  file << "\n]\n";
+
+  return file.good();
+}
+
+} // namespace tracing
+} // namespace rmf_fleet_adapter
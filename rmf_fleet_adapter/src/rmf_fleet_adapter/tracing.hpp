@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_FLEET_ADAPTER__TRACING_HPP
+#define SRC__RMF_FLEET_ADAPTER__TRACING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rmf_fleet_adapter {
+namespace tracing {
+
+//==============================================================================
+// A ring buffer of spans that follow each task from its bid through planning,
+// negotiation and execution. Every span is keyed by the ID of its task. While
+// tracing is disabled, each trace point costs one relaxed atomic load.
+
+using Clock = std::chrono::steady_clock;
+
+//==============================================================================
+struct Record
+{
+  /// The name of the trace point. This is always a string literal.
+  const char* name;
+
+  std::string task_id;
+  Clock::time_point start;
+  Clock::time_point finish;
+
+  /// True if this marks a moment instead of a span of time
+  bool instant;
+};
+
+namespace detail {
+extern std::atomic_bool enabled;
+void push(Record record);
+} // namespace detail
+
+//==============================================================================
+inline bool enabled()
+{
+  return detail::enabled.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+/// Begin keeping the most recent records, up to the capacity. Records that
+/// were kept before are cleared.
+void enable(std::size_t capacity);
+
+//==============================================================================
+void disable();
+
+//==============================================================================
+/// Get the start time for a span that will end in a different scope, or
+/// std::nullopt if tracing is disabled.
+inline std::optional<Clock::time_point> start()
+{
+  if (!enabled())
+    return std::nullopt;
+
+  return Clock::now();
+}
+
+//==============================================================================
+/// Record a span that began at a time given by start(). Nothing is recorded if
+/// start did not have a value.
+inline void record(
+  const char* name,
+  const std::string& task_id,
+  const std::optional<Clock::time_point>& start)
+{
+  if (start.has_value() && enabled())
+    detail::push({name, task_id, *start, Clock::now(), false});
+}
+
+//==============================================================================
+/// Record a moment in the life of a task
+inline void instant(const char* name, const std::string& task_id)
+{
+  if (!enabled())
+    return;
+
+  const auto now = Clock::now();
+  detail::push({name, task_id, now, now, true});
+}
+
+//==============================================================================
+/// Records a span for the scope that it is alive in
+class Span
+{
+public:
+
+  Span(const char* name, const std::string& task_id)
+  : _name(name),
+    _start(tracing::start())
+  {
+    if (_start.has_value())
+      _task_id = task_id;
+  }
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  ~Span()
+  {
+    record(_name, _task_id, _start);
+  }
+
+private:
+  const char* _name;
+  std::optional<Clock::time_point> _start;
+  std::string _task_id;
+};
+
+//==============================================================================
+/// Get the records that are being kept, from oldest to newest
+std::vector<Record> records();
+
+//==============================================================================
+/// Write the records that are being kept to a file in the Chrome trace event
+/// format, with one row for each task. Returns false if the file could not be
+/// written.
+bool write_chrome_trace(const std::string& path);
+
+} // namespace tracing
+} // namespace rmf_fleet_adapter
+
+#endif // SRC__RMF_FLEET_ADAPTER__TRACING_HPP
@@ -23,6 +23,8 @@
 
 #include <rmf_fleet_adapter/StandardNames.hpp>
 
+#include <unordered_set>
+
 #ifdef FAILOVER_MODE
 #include "stubborn_buddies_msgs/msg/status.hpp"
 #endif
@@ -43,8 +45,10 @@ public:
   : rclcpp::Node("robot_state_aggregator", options)
   {
     RCLCPP_DEBUG(get_logger(), "RobotStateAggregator called");
-    const auto default_qos = rclcpp::SystemDefaultsQoS();
-    const auto state_qos = rclcpp::SystemDefaultsQoS().keep_last(100);
+    // Intra-process communication only works with volatile durability
+    const auto default_qos = rclcpp::SystemDefaultsQoS().durability_volatile();
+    const auto state_qos =
+      rclcpp::SystemDefaultsQoS().keep_last(100).durability_volatile();
 
 #ifdef FAILOVER_MODE
     _active_node = this->declare_parameter("active_node", true);
@@ -112,6 +116,25 @@ public:
 
     this->_prefix = std::move(prefix);
     this->_fleet_name = std::move(fleet_name);
+
+    // Publish the fleet state at most once per this many milliseconds, with
+    // every robot update that arrived in between. Use 0 to publish on every
+    // robot update.
+    const auto publish_period =
+      this->declare_parameter("publish_period", 0);
+
+    // Only include the robots that were updated since the last publication
+    _updated_only = this->declare_parameter("publish_updated_only", false);
+
+    if (publish_period > 0)
+    {
+      _publish_timer = create_wall_timer(
+        std::chrono::milliseconds(publish_period),
+        [this]()
+        {
+          _publish();
+        });
+    }
   }
 
 private:
@@ -127,8 +150,11 @@ private:
 #endif
 
   std::unordered_map<std::string, std::unique_ptr<RobotState>> _latest_states;
+  std::unordered_set<std::string> _updated_robots;
+  bool _updated_only = false;
 
   rclcpp::Publisher<FleetState>::SharedPtr _fleet_state_pub;
+  rclcpp::TimerBase::SharedPtr _publish_timer;
   rclcpp::Subscription<RobotState>::SharedPtr _robot_state_sub;
 
 #ifdef FAILOVER_MODE
@@ -164,15 +190,38 @@ private:
 
     if (updated)
     {
-      FleetState fleet;
-      fleet.name = _fleet_name;
-      for (const auto& robot_state : _latest_states)
-        fleet.robots.emplace_back(*robot_state.second);
+      _updated_robots.insert(name);
 
-      _fleet_state_pub->publish(fleet);
+      // The timer will take care of publishing if there is a publish period
+      if (!_publish_timer)
+        _publish();
     }
   }
 
+  void _publish()
+  {
+    if (_updated_robots.empty())
+      return;
+
+    auto fleet = std::make_unique<FleetState>();
+    fleet->name = _fleet_name;
+    if (_updated_only)
+    {
+      fleet->robots.reserve(_updated_robots.size());
+      for (const auto& name : _updated_robots)
+        fleet->robots.emplace_back(*_latest_states.at(name));
+    }
+    else
+    {
+      fleet->robots.reserve(_latest_states.size());
+      for (const auto& robot_state : _latest_states)
+        fleet->robots.emplace_back(*robot_state.second);
+    }
+
+    _updated_robots.clear();
+    _fleet_state_pub->publish(std::move(fleet));
+  }
+
 };
 
 RCLCPP_COMPONENTS_REGISTER_NODE(RobotStateAggregator)
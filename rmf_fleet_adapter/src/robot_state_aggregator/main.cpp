@@ -74,7 +74,13 @@ int main(int argc, char* argv[])
       {
         auto node_factory =
           loader->createInstance<rclcpp_components::NodeFactory>(clazz);
-        auto wrapper = node_factory->create_node_instance(options);
+        // The aggregator publishes unique_ptr messages, so any node in this
+        // process that subscribes to them with a const shared_ptr never has to
+        // copy them.
+        const bool aggregator =
+          clazz.find("RobotStateAggregator") != std::string::npos;
+        auto wrapper = node_factory->create_node_instance(
+          rclcpp::NodeOptions(options).use_intra_process_comms(aggregator));
         auto node = wrapper.get_node_base_interface();
 
         node_wrappers.push_back(wrapper);
@@ -22,21 +22,42 @@
 
 #include <rmf_task_msgs/msg/tasks.hpp>
 #include <rmf_task_msgs/msg/task_summary.hpp>
+#include <rmf_task_msgs/srv/get_task_list.hpp>
 
+#include <deque>
+#include <mutex>
+#include <unordered_set>
 
 class TaskAggregator : public rclcpp::Node
 {
 
   using TaskSummary = rmf_task_msgs::msg::TaskSummary;
   using Tasks = rmf_task_msgs::msg::Tasks;
+  using GetTaskList = rmf_task_msgs::srv::GetTaskList;
 
 public:
+
+  struct Options
+  {
+    // How many finished tasks to remember
+    std::size_t max_finished_tasks = 100;
+
+    // How long to remember a finished task for
+    std::chrono::nanoseconds finished_task_lifetime = std::chrono::hours(1);
+
+    // Publish every task that is remembered on each tick instead of only the
+    // ones that changed since the last tick
+    bool publish_all = false;
+  };
+
   TaskAggregator(
     std::string node_name,
     std::string input_topic,
-    double rate)
+    double rate,
+    Options options)
   : Node(node_name),
-    _rate(rate)
+    _rate(rate),
+    _options(options)
   {
     // Create a wall timer to periodically publish Tasks msg
     const double period = 1.0/_rate;
@@ -65,6 +86,19 @@ public:
         std::placeholders::_1),
       sub_map_opt);
 
+    // The full list of remembered tasks is available on request, since the
+    // tasks topic only carries the summaries that have changed.
+    _get_tasks_srv = this->create_service<GetTaskList>(
+      "~/get_tasks",
+      [this](
+        const GetTaskList::Request::SharedPtr request,
+        GetTaskList::Response::SharedPtr response)
+      {
+        get_tasks_cb(*request, *response);
+      },
+      rmw_qos_profile_services_default,
+      _cb_group_task_summary);
+
     RCLCPP_INFO(
       get_logger(),
       "Listening for Task Summaries on topic /%s",
@@ -73,36 +107,134 @@ public:
 
 private:
 
+  static bool is_finished(const TaskSummary& summary)
+  {
+    return summary.state == TaskSummary::STATE_COMPLETED
+      || summary.state == TaskSummary::STATE_FAILED
+      || summary.state == TaskSummary::STATE_CANCELED;
+  }
+
   void timer_callback()
   {
     Tasks tasks;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      forget_finished_tasks();
+
+      if (_options.publish_all)
+      {
+        for (const auto& t : _db)
+          tasks.tasks.push_back(t.second);
+      }
+      else
+      {
+        for (const auto& task_id : _changed)
+        {
+          const auto it = _db.find(task_id);
+          if (it != _db.end())
+            tasks.tasks.push_back(it->second);
+        }
+      }
 
-    for (const auto& t : _db)
-      tasks.tasks.push_back(t.second);
+      _changed.clear();
+    }
+
+    if (tasks.tasks.empty() && !_options.publish_all)
+      return;
 
     _tasks_pub->publish(tasks);
   }
 
   void task_summary_cb(const TaskSummary::SharedPtr msg)
   {
-    if (_db.find(msg->task_id) != _db.end())
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto insertion = _db.insert(std::make_pair(msg->task_id, *msg));
+    const bool was_finished =
+      !insertion.second && is_finished(insertion.first->second);
+
+    if (!insertion.second)
+      insertion.first->second = *msg;
+
+    if (is_finished(*msg) && !was_finished)
+      _finished.push_back({msg->task_id, now()});
+
+    _changed.insert(msg->task_id);
+  }
+
+  void get_tasks_cb(
+    const GetTaskList::Request& request,
+    GetTaskList::Response& response)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto add = [&response](const TaskSummary& summary)
+      {
+        if (is_finished(summary))
+          response.terminated_tasks.push_back(summary);
+        else
+          response.active_tasks.push_back(summary);
+      };
+
+    if (request.task_id.empty())
     {
-      _db[msg->task_id] = *msg;
+      for (const auto& t : _db)
+        add(t.second);
     }
     else
     {
-      _db.insert(std::make_pair(msg->task_id, *msg));
+      for (const auto& task_id : request.task_id)
+      {
+        const auto it = _db.find(task_id);
+        if (it != _db.end())
+          add(it->second);
+      }
+    }
+
+    response.success = true;
+  }
+
+  // Only the most recently finished tasks are remembered. Tasks that are
+  // still active are never forgotten.
+  void forget_finished_tasks()
+  {
+    const auto current_time = now();
+    const auto lifetime = rclcpp::Duration(_options.finished_task_lifetime);
+
+    while (!_finished.empty())
+    {
+      const auto& oldest = _finished.front();
+      if (_finished.size() <= _options.max_finished_tasks
+        && current_time - oldest.second < lifetime)
+        break;
+
+      // The task may have been restarted since it finished
+      const auto it = _db.find(oldest.first);
+      if (it != _db.end() && is_finished(it->second))
+      {
+        _db.erase(it);
+        _changed.erase(oldest.first);
+      }
+
+      _finished.pop_front();
     }
   }
 
   double _rate;
+  Options _options;
 
+  std::mutex _mutex;
   std::unordered_map<std::string, TaskSummary> _db;
 
+  // The tasks that changed since the last tick
+  std::unordered_set<std::string> _changed;
+
+  // Finished tasks in the order that they finished
+  std::deque<std::pair<std::string, rclcpp::Time>> _finished;
+
   rclcpp::TimerBase::SharedPtr _timer;
   rclcpp::Publisher<Tasks>::SharedPtr _tasks_pub;
   rclcpp::Subscription<TaskSummary>::SharedPtr _task_summary_sub;
   rclcpp::CallbackGroup::SharedPtr _cb_group_task_summary;
+  rclcpp::Service<GetTaskList>::SharedPtr _get_tasks_srv;
 };
 
 bool get_arg(
@@ -148,10 +280,27 @@ int main(int argc, char* argv[])
   get_arg(args, "-r", rate_string, "rate", false);
   double rate = rate_string.empty() ? 1.0 : std::stod(rate_string);
 
+  TaskAggregator::Options options;
+  std::string max_finished_string;
+  if (get_arg(args, "-f", max_finished_string, "max finished tasks", false))
+    options.max_finished_tasks = std::stoul(max_finished_string);
+
+  std::string lifetime_string;
+  if (get_arg(args, "-l", lifetime_string, "finished task lifetime", false))
+  {
+    options.finished_task_lifetime =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(std::stod(lifetime_string)));
+  }
+
+  options.publish_all =
+    std::find(args.begin(), args.end(), "--publish-all") != args.end();
+
   auto task_aggregator_node = std::make_shared<TaskAggregator>(
     node_name,
     input_topic,
-    rate);
+    rate,
+    options);
 
   rclcpp::spin(task_aggregator_node);
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "../mock/MockRobotCommand.hpp"
+
+#include <rmf_fleet_adapter/agv/test/MockAdapter.hpp>
+#include <rmf_fleet_adapter/StandardNames.hpp>
+
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include <rmf_traffic_ros2/Time.hpp>
+
+#include <rmf_battery/agv/BatterySystem.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+
+#include <diagnostic_msgs/srv/self_test.hpp>
+
+#include <rclcpp/executors.hpp>
+
+#include <rmf_utils/catch.hpp>
+
+#include "../thread_cooldown.hpp"
+
+#include <algorithm>
+
+//==============================================================================
+SCENARIO("Memory report with the default worker settings")
+{
+  rmf_fleet_adapter_test::thread_cooldown = true;
+  using namespace std::chrono_literals;
+  using SelfTest = diagnostic_msgs::srv::SelfTest;
+
+  const std::string test_map_name = "test_map";
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint(test_map_name, {0.0, 0.0}).set_charger(true);
+  graph.add_waypoint(test_map_name, {10.0, 0.0});
+  graph.add_lane(0, 1);
+  graph.add_lane(1, 0);
+
+  const auto shape = rmf_traffic::geometry::make_final_convex<
+    rmf_traffic::geometry::Circle>(1.0);
+  const rmf_traffic::Profile profile{shape, shape};
+  const rmf_traffic::agv::VehicleTraits traits{
+    {0.7, 0.3},
+    {1.0, 0.45},
+    profile
+  };
+
+  auto rcl_context = std::make_shared<rclcpp::Context>();
+  rcl_context->init(0, nullptr);
+  rmf_fleet_adapter::agv::test::MockAdapter adapter(
+    "test_MemoryReport", rclcpp::NodeOptions().context(rcl_context));
+
+  const auto fleet = adapter.add_fleet("test_fleet", traits, graph);
+
+  using namespace rmf_battery::agv;
+  auto battery_system = std::make_shared<BatterySystem>(
+    *BatterySystem::make(24.0, 40.0, 8.8));
+  auto mechanical_system = MechanicalSystem::make(70.0, 40.0, 0.22);
+  auto motion_sink = std::make_shared<SimpleMotionPowerSink>(
+    *battery_system, *mechanical_system);
+  auto ambient_sink = std::make_shared<SimpleDevicePowerSink>(
+    *battery_system, *PowerSystem::make(20.0));
+  auto tool_sink = std::make_shared<SimpleDevicePowerSink>(
+    *battery_system, *PowerSystem::make(10.0));
+  fleet->set_task_planner_params(
+    battery_system, motion_sink, ambient_sink, tool_sink, 0.2, 1.0, false);
+
+  std::promise<void> robot_added_promise;
+  auto robot_added = robot_added_promise.get_future();
+  const auto now = rmf_traffic_ros2::convert(adapter.node()->now());
+  auto robot_cmd = std::make_shared<
+    rmf_fleet_adapter_test::MockRobotCommand>(adapter.node(), graph);
+  fleet->add_robot(
+    robot_cmd, "T0", profile, {{now, 0, 0.0}},
+    [&robot_cmd, &robot_added_promise](
+      rmf_fleet_adapter::agv::RobotUpdateHandlePtr updater)
+    {
+      updater->update_battery_soc(1.0);
+      robot_cmd->updater = std::move(updater);
+      robot_added_promise.set_value();
+    });
+
+  adapter.start();
+  REQUIRE(robot_added.wait_for(5s) == std::future_status::ready);
+
+  const auto client_node = std::make_shared<rclcpp::Node>(
+    "test_MemoryReport_client", rclcpp::NodeOptions().context(rcl_context));
+  const auto client = client_node->create_client<SelfTest>(
+    rmf_fleet_adapter::MemoryReportServiceName);
+  REQUIRE(client->wait_for_service(5s));
+
+  rclcpp::ExecutorOptions executor_options;
+  executor_options.context = rcl_context;
+  rclcpp::executors::SingleThreadedExecutor executor(executor_options);
+  executor.add_node(client_node);
+
+  auto future = client->async_send_request(
+    std::make_shared<SelfTest::Request>());
+  REQUIRE(executor.spin_until_future_complete(future, 10s) ==
+    rclcpp::FutureReturnCode::SUCCESS);
+
+  // The robot shares the worker that answers the service. If the report had
+  // waited on that worker to measure the robot, the robot would be reported
+  // as not measured in time and the report would not pass.
+  const auto response = future.get();
+  CHECK(response->passed);
+
+  bool found_robot = false;
+  bool found_fleet = false;
+  for (const auto& status : response->status)
+  {
+    const auto has_total = std::any_of(
+      status.values.begin(), status.values.end(),
+      [](const auto& kv) { return kv.key == "total"; });
+
+    if (status.name.find("/memory/test_fleet/T0") != std::string::npos)
+    {
+      found_robot = true;
+      CHECK(status.level == diagnostic_msgs::msg::DiagnosticStatus::OK);
+      CHECK(has_total);
+    }
+    else if (status.name.find("/memory/test_fleet") != std::string::npos)
+    {
+      found_fleet = true;
+      CHECK(has_total);
+    }
+  }
+
+  CHECK(found_robot);
+  CHECK(found_fleet);
+
+  adapter.stop();
+}
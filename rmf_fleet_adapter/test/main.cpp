@@ -22,9 +22,11 @@
 #include <thread>
 
 #include "thread_cooldown.hpp"
+#include "services/negotiation_hooks.hpp"
 
 namespace rmf_fleet_adapter_test {
 bool thread_cooldown;
+NegotiationHooks negotiation_hooks;
 } // namespace rmf_fleet_adapter_test
 
 int main(int argc, char* argv[])
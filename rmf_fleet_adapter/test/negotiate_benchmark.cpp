@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark replays the negotiation scenarios of
+/// services/test_Negotiate.cpp. Each scenario is run many times through the
+/// Catch session, and every negotiation that a scenario solves is timed from
+/// the moment the first responses are requested until the negotiation is
+/// solved or fails. That covers the plans, rollouts and ProgressEvaluator
+/// decisions of services::Negotiate from end to end, without the setup of the
+/// scenario. For each scenario it reports:
+///  - negotiations: how many negotiations were timed, and how many of them
+///    ended without a solution
+///  - latency: the median, 90th percentile and maximum of the negotiations
+///  - allocations: the mean heap allocations that a negotiation made
+///  - failed runs: runs of the scenario whose checks did not pass
+///
+/// Catch's own output is discarded, so run test_rmf_fleet_adapter on a
+/// scenario to see why its checks failed.
+///
+/// Usage:
+///   negotiate_benchmark [--runs 20] ["Scenario: <name>" ...]
+
+#define CATCH_CONFIG_RUNNER
+#include <rmf_utils/catch.hpp>
+
+#include "thread_cooldown.hpp"
+#include "services/negotiation_hooks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using SteadyClock = std::chrono::steady_clock;
+
+namespace rmf_fleet_adapter_test {
+bool thread_cooldown;
+NegotiationHooks negotiation_hooks;
+} // namespace rmf_fleet_adapter_test
+
+namespace {
+std::atomic_size_t allocations{0};
+} // anonymous namespace
+
+//==============================================================================
+// Count every heap allocation that the process makes
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+//==============================================================================
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+//==============================================================================
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace {
+//==============================================================================
+double percentile(std::vector<double> samples, const double q)
+{
+  if (samples.empty())
+    return 0.0;
+
+  std::sort(samples.begin(), samples.end());
+  const auto i = static_cast<std::size_t>(q * samples.size());
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+//==============================================================================
+/// The negotiations that have been timed for the current scenario. The
+/// finished hook is called from a worker thread, so this is locked.
+struct Samples
+{
+  std::mutex mutex;
+  SteadyClock::time_point start;
+  std::size_t start_allocations = 0;
+  std::vector<double> latency_ms;
+  std::vector<double> allocations;
+  std::size_t failed = 0;
+
+  void started()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    start_allocations = ::allocations.load(std::memory_order_relaxed);
+    start = SteadyClock::now();
+  }
+
+  void finished(const bool solved)
+  {
+    const auto finish = SteadyClock::now();
+    const auto finish_allocations =
+      ::allocations.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    latency_ms.push_back(
+      std::chrono::duration<double, std::milli>(finish - start).count());
+    allocations.push_back(
+      static_cast<double>(finish_allocations - start_allocations));
+
+    if (!solved)
+      ++failed;
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    latency_ms.clear();
+    allocations.clear();
+    failed = 0;
+  }
+};
+
+//==============================================================================
+double mean(const std::vector<double>& samples)
+{
+  if (samples.empty())
+    return 0.0;
+
+  double total = 0.0;
+  for (const auto s : samples)
+    total += s;
+
+  return total / static_cast<double>(samples.size());
+}
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rmf_fleet_adapter_test::thread_cooldown = false;
+
+  Samples samples;
+  rmf_fleet_adapter_test::negotiation_hooks.started = [&samples]()
+    {
+      samples.started();
+    };
+
+  rmf_fleet_adapter_test::negotiation_hooks.finished =
+    [&samples](const bool solved)
+    {
+      samples.finished(solved);
+    };
+
+  std::size_t runs = 20;
+  Catch::Session session;
+  session.cli(
+    session.cli()
+    | Catch::clara::Opt(runs, "runs")["--runs"](
+      "how many times to run each scenario"));
+
+  const int parse_result = session.applyCommandLine(argc, argv);
+  if (parse_result != 0)
+    return parse_result;
+
+  if (session.configData().showHelp)
+    return 0;
+
+  // Every scenario is hidden behind the [.high_cpu] tag, so when none are
+  // named we select all of them.
+  std::vector<std::string> scenarios;
+  {
+    const bool all = session.configData().testsOrTags.empty();
+    const auto& config = session.config();
+    for (const auto& test : Catch::getAllTestCasesSorted(config))
+    {
+      if (all || config.testSpec().matches(test))
+        scenarios.push_back(test.name);
+    }
+  }
+
+  std::printf(
+    "%-55s %7s %8s %9s %9s %9s %11s %7s\n",
+    "scenario", "negot.", "unsolved", "p50 [ms]", "p90 [ms]", "max [ms]",
+    "allocs", "failed");
+  std::printf("%-55s %7s %8s %9s %9s %9s %11s %7s\n",
+    "", "", "", "", "", "", "(mean)", "runs");
+
+  int result = 0;
+  for (const auto& scenario : scenarios)
+  {
+    samples.clear();
+    std::size_t failed_runs = 0;
+
+    auto config = session.configData();
+    config.testsOrTags = {scenario};
+    config.outputFilename = "/dev/null";
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      session.useConfigData(config);
+      if (session.run() != 0)
+        ++failed_runs;
+    }
+
+    if (failed_runs > 0)
+      result = 1;
+
+    std::lock_guard<std::mutex> lock(samples.mutex);
+    std::string name = scenario;
+    if (name.size() > 55)
+      name = name.substr(0, 52) + "...";
+
+    std::printf(
+      "%-55s %7zu %8zu %9.1f %9.1f %9.1f %11.0f %7zu\n",
+      name.c_str(), samples.latency_ms.size(), samples.failed,
+      percentile(samples.latency_ms, 0.5),
+      percentile(samples.latency_ms, 0.9),
+      percentile(samples.latency_ms, 1.0),
+      mean(samples.allocations), failed_runs);
+    std::fflush(stdout);
+  }
+
+  if (rmf_fleet_adapter_test::thread_cooldown)
+  {
+    using namespace std::chrono_literals;
+#ifdef NDEBUG
+    const auto cooldown_time = 100ms;
+#else
+    const auto cooldown_time = 2s;
+#endif
+
+    std::this_thread::sleep_for(cooldown_time);
+  }
+
+  return result;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef TEST__SERVICES__NEGOTIATION_HOOKS_HPP
+#define TEST__SERVICES__NEGOTIATION_HOOKS_HPP
+
+#include <functional>
+
+namespace rmf_fleet_adapter_test {
+
+// The negotiation scenarios call these when a negotiation begins and when it
+// finishes, which lets negotiate_benchmark measure the negotiations without
+// the setup of each scenario. The unit tests leave them empty. The finished
+// hook may be called from a worker thread.
+struct NegotiationHooks
+{
+  std::function<void()> started;
+  std::function<void(bool solved)> finished;
+};
+
+extern NegotiationHooks negotiation_hooks;
+} // namespace rmf_fleet_adapter_test
+
+#endif // TEST__SERVICES__NEGOTIATION_HOOKS_HPP
@@ -20,6 +20,8 @@
 #include <rmf_traffic/schedule/Database.hpp>
 #include <rmf_traffic/DetectConflict.hpp>
 
+#include <optional>
+
 #include <services/FindEmergencyPullover.hpp>
 
 #include <rmf_utils/catch.hpp>
@@ -296,4 +298,51 @@ SCENARIO("Emergency Pullover")
 
     CHECK(at_least_one_conflict);
   }
+
+  WHEN("Limiting the search to candidate parking spots")
+  {
+    const auto start = rmf_traffic::agv::Plan::Start(now, 4, 0.0);
+    const auto find_parking_spot =
+      [&](std::vector<std::size_t> candidates) -> std::optional<std::size_t>
+      {
+        auto pullover_service = std::make_shared<
+          rmf_fleet_adapter::services::FindEmergencyPullover>(
+          planner, rmf_traffic::agv::Plan::StartSet({start}),
+          database->snapshot(), p0.id(),
+          std::make_shared<rmf_traffic::Profile>(p0.description().profile()),
+          std::move(candidates));
+
+        std::promise<rmf_traffic::agv::Plan::Result> result_promise;
+        auto result_future = result_promise.get_future();
+        auto pullover_sub =
+          rmf_rxcpp::make_job<
+          rmf_fleet_adapter::services::FindEmergencyPullover::Result>(
+          pullover_service)
+          .observe_on(rxcpp::observe_on_event_loop())
+          .subscribe(
+          [&result_promise](const auto& result)
+          {
+            result_promise.set_value(result);
+          });
+
+        if (result_future.wait_for(10s) != std::future_status::ready)
+          return std::nullopt;
+
+        const auto result = result_future.get();
+        if (!result.success())
+          return std::nullopt;
+
+        return result->get_waypoints().back().graph_index();
+      };
+
+    THEN("Only the candidates are planned to")
+    {
+      CHECK(find_parking_spot({11}) == std::optional<std::size_t>(11));
+    }
+
+    THEN("Every parking spot is tried when no candidate can be used")
+    {
+      CHECK(find_parking_spot({3}) == std::optional<std::size_t>(7));
+    }
+  }
 }
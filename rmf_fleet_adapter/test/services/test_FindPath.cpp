@@ -284,6 +284,62 @@ SCENARIO("Find a path")
 
     CHECK(at_least_one_conflict);
   }
+
+  WHEN("The cost of a path is already known from an earlier trip")
+  {
+    const auto start = rmf_traffic::agv::Plan::Start(now, 3, 0.0);
+    const auto goal = rmf_traffic::agv::Plan::Goal(7);
+
+    const auto find = [&](std::optional<double> known_cost)
+      {
+        auto path_service =
+          std::make_shared<rmf_fleet_adapter::services::FindPath>(
+          planner, rmf_traffic::agv::Plan::StartSet({start}), goal,
+          database->snapshot(), p1.id(),
+          std::make_shared<rmf_traffic::Profile>(p1.description().profile()),
+          nullptr, known_cost);
+
+        std::promise<rmf_traffic::agv::Plan::Result> promise;
+        auto future = promise.get_future();
+        auto sub =
+          rmf_rxcpp::make_job<rmf_fleet_adapter::services::FindPath::Result>(
+          path_service)
+          .observe_on(rxcpp::observe_on_event_loop())
+          .subscribe(
+          [&promise](const auto& result)
+          {
+            promise.set_value(result);
+          });
+
+        const auto status = future.wait_for(60s);
+        REQUIRE(std::future_status::ready == status);
+        return future.get();
+      };
+
+    const auto first = find(std::nullopt);
+    REQUIRE(first.success());
+
+    THEN("The same path is found again while the way is clear")
+    {
+      const auto again = find(first->get_cost());
+      REQUIRE(again.success());
+      CHECK(again->get_cost() == Approx(first->get_cost()));
+    }
+
+    THEN("A path is still found once the way gets blocked")
+    {
+      const auto l0 = graph.get_waypoint(5).get_location();
+      rmf_traffic::Trajectory blocking_traj;
+      blocking_traj.insert(
+        now, {l0[0], l0[1], 0.0}, Eigen::Vector3d::Zero());
+      blocking_traj.insert(
+        now + 1h, {l0[0], l0[1], 0.0}, Eigen::Vector3d::Zero());
+      p0.set({{graph.get_waypoint(5).get_map_name(), blocking_traj}});
+
+      const auto blocked = find(first->get_cost());
+      CHECK(blocked.success());
+    }
+  }
 }
 
 //==============================================================================
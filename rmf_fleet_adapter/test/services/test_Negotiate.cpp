@@ -24,6 +24,7 @@
 #include <rmf_utils/catch.hpp>
 
 #include "../thread_cooldown.hpp"
+#include "negotiation_hooks.hpp"
 
 // Helper Definitions
 //==============================================================================
@@ -795,6 +796,9 @@ public:
                 << negotiation.get() << ")" <<std::endl;
     }
 
+    if (rmf_fleet_adapter_test::negotiation_hooks.started)
+      rmf_fleet_adapter_test::negotiation_hooks.started();
+
     for (const auto& n : negotiators)
     {
       const auto participant = n.first;
@@ -845,6 +849,7 @@ public:
       if (!_promise_fulfilled)
       {
         _promise_fulfilled = true;
+        notify_finished(true);
         _solution.set_value(winner->proposal());
       }
     }
@@ -856,6 +861,7 @@ public:
       if (!_promise_fulfilled)
       {
         _promise_fulfilled = true;
+        notify_finished(false);
         _solution.set_value(rmf_utils::nullopt);
       }
     }
@@ -864,6 +870,12 @@ public:
     return true;
   }
 
+  static void notify_finished(const bool solved)
+  {
+    if (rmf_fleet_adapter_test::negotiation_hooks.finished)
+      rmf_fleet_adapter_test::negotiation_hooks.finished(solved);
+  }
+
   std::unordered_map<ParticipantId, std::shared_ptr<Negotiator>> negotiators;
   std::shared_ptr<rmf_traffic::schedule::Negotiation> negotiation;
   rxcpp::schedulers::worker worker;
@@ -18,6 +18,7 @@
 #ifndef PYROBOTCOMMANDHANDLE_HPP
 #define PYROBOTCOMMANDHANDLE_HPP
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <memory>
@@ -25,8 +26,117 @@
 
 #include <rmf_fleet_adapter/agv/RobotCommandHandle.hpp>
 
+#include <pybind11/pybind11.h>
+
+// Wrap a C++ callback that gets handed to Python so that the GIL is released
+// while the callback runs. Python holds the GIL when it calls the callback,
+// but the C++ side does not need it, and holding it would block the other
+// Python threads and any adapter threads that are waiting on Python.
+template<typename... Args>
+std::function<void(Args...)> release_gil_while_running(
+  std::function<void(Args...)> callback)
+{
+  if (!callback)
+    return callback;
+
+  return [callback = std::move(callback)](Args... args)
+    {
+      pybind11::gil_scoped_release release;
+      callback(args...);
+    };
+}
+
+// Wrap a callback so that only its first call goes through. A command that
+// is a coroutine may finish the command itself, and the command is finished
+// again when the coroutine returns.
+inline std::function<void()> call_once(std::function<void()> callback)
+{
+  if (!callback)
+    return callback;
+
+  auto called = std::make_shared<std::atomic_bool>(false);
+  return [callback = std::move(callback), called]()
+    {
+      if (!called->exchange(true))
+        callback();
+    };
+}
+
+// The asyncio event loop that the commands which are coroutines get scheduled
+// on. This is never destroyed, because the interpreter may already be gone by
+// the time that static objects get destroyed.
+inline pybind11::object& command_event_loop()
+{
+  static auto* loop = new pybind11::object(pybind11::none());
+  return *loop;
+}
+
+// If the result of a command is a coroutine, schedule it on the event loop of
+// the commands and return the future of the coroutine. When the coroutine
+// returns, on_done is triggered with the GIL held. If it raises, the exception
+// is passed to the exception handler of the event loop instead. Returns None
+// when the result is not a coroutine. The GIL must be held.
+inline pybind11::object schedule_if_coroutine(
+  pybind11::object result,
+  std::function<void()> on_done)
+{
+  const auto asyncio = pybind11::module::import("asyncio");
+  if (!asyncio.attr("iscoroutine")(result).cast<bool>())
+    return pybind11::none();
+
+  const auto loop = command_event_loop();
+  if (loop.is_none())
+  {
+    result.attr("close")();
+    const int warned = PyErr_WarnEx(
+      PyExc_RuntimeWarning,
+      "A RobotCommandHandle command is a coroutine, but no event loop was "
+      "given to rmf_adapter.set_event_loop(), so it will not run",
+      1);
+
+    if (warned < 0)
+      throw pybind11::error_already_set();
+
+    return pybind11::none();
+  }
+
+  auto future = asyncio.attr("run_coroutine_threadsafe")(result, loop);
+  future.attr("add_done_callback")(
+    pybind11::cpp_function(
+      [on_done = std::move(on_done), loop](pybind11::object future)
+      {
+        if (future.attr("cancelled")().cast<bool>())
+          return;
+
+        const auto exception = future.attr("exception")();
+        if (!exception.is_none())
+        {
+          pybind11::dict context;
+          context["message"] = "A RobotCommandHandle command raised";
+          context["exception"] = exception;
+          context["future"] = future;
+          loop.attr("call_exception_handler")(context);
+          return;
+        }
+
+        if (on_done)
+          on_done();
+      }));
+
+  return future;
+}
+
 // Trampoline RobotCommandHandle wrapper class
-// to allow method overrides from Python
+// to allow method overrides from Python.
+//
+// Each command may be overridden by a plain function, which runs on the worker
+// of the fleet adapter, or by a coroutine function, whose coroutine gets
+// scheduled on the event loop that was given to rmf_adapter.set_event_loop().
+// The worker does not wait for a coroutine, so a slow robot API does not hold
+// up the fleet adapter. The path or docking of a coroutine is finished when
+// the coroutine returns, or earlier if it triggers the finished callback
+// itself. A new path, a new docking or a stop cancels the coroutine of the
+// command that it replaces.
 class PyRobotCommandHandle :
   public rmf_fleet_adapter::agv::RobotCommandHandle
 {
@@ -43,37 +153,81 @@ public:
     ArrivalEstimator next_arrival_estimator,
     std::function<void()> path_finished_callback) override
   {
-    PYBIND11_OVERLOAD_PURE(
-      void,
-      rmf_fleet_adapter::agv::RobotCommandHandle,
-      follow_new_path,
-      waypoints,
-      next_arrival_estimator,
-      path_finished_callback
-    );
+    auto finished = call_once(
+      release_gil_while_running(std::move(path_finished_callback)));
+
+    pybind11::gil_scoped_acquire gil;
+    cancel(_command);
+    _command = schedule_if_coroutine(
+      call_override(
+        "follow_new_path",
+        waypoints,
+        release_gil_while_running(std::move(next_arrival_estimator)),
+        finished),
+      finished);
   }
 
   void stop() override
   {
-    PYBIND11_OVERLOAD_PURE(
-      void,
-      rmf_fleet_adapter::agv::RobotCommandHandle,
-      stop,  // Trailing comma required
-    );
+    pybind11::gil_scoped_acquire gil;
+    cancel(_command);
+    schedule_if_coroutine(call_override("stop"), nullptr);
   }
 
   void dock(
     const std::string& dock_name,
     std::function<void()> docking_finished_callback) override
   {
-    PYBIND11_OVERLOAD_PURE(
-      void,
-      rmf_fleet_adapter::agv::RobotCommandHandle,
-      dock,
-      dock_name,
-      docking_finished_callback
-    );
+    auto finished = call_once(
+      release_gil_while_running(std::move(docking_finished_callback)));
+
+    pybind11::gil_scoped_acquire gil;
+    cancel(_command);
+    _command = schedule_if_coroutine(
+      call_override("dock", dock_name, finished),
+      finished);
+  }
+
+  ~PyRobotCommandHandle() override
+  {
+    if (!Py_IsInitialized())
+    {
+      // The interpreter is gone, so the future can only be leaked
+      _command.release();
+      return;
+    }
+
+    pybind11::gil_scoped_acquire gil;
+    _command.release().dec_ref();
+  }
+
+private:
+
+  template<typename... Args>
+  pybind11::object call_override(const char* name, Args&&... args)
+  {
+    const pybind11::function override = pybind11::get_overload(
+      static_cast<const rmf_fleet_adapter::agv::RobotCommandHandle*>(this),
+      name);
+
+    if (!override)
+    {
+      pybind11::pybind11_fail(
+        std::string("Tried to call pure virtual function "
+        "\"RobotCommandHandle::") + name + "\"");
+    }
+
+    return override(std::forward<Args>(args)...);
   }
+
+  static void cancel(const pybind11::object& future)
+  {
+    if (!future.is_none())
+      future.attr("cancel")();
+  }
+
+  // The future of the coroutine of the current command, or None
+  pybind11::object _command = pybind11::none();
 };
 
 #endif // PYROBOTCOMMANDHANDLE_HPP
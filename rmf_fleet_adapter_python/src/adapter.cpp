@@ -72,19 +72,38 @@ PYBIND11_MODULE(rmf_adapter, m) {
   .def("stop", &agv::RobotCommandHandle::stop)
   .def("dock", &agv::RobotCommandHandle::dock);
 
+  m.def("set_event_loop",
+    [](py::object loop)
+    {
+      command_event_loop() = std::move(loop);
+    },
+    py::arg("loop"),
+    "Set the asyncio event loop that RobotCommandHandle commands which are "
+    "coroutines get scheduled on. The loop must be run by the caller, usually "
+    "in its own thread. Pass None to stop scheduling coroutines.");
+
+  m.def("get_event_loop",
+    []()
+    {
+      return command_event_loop();
+    },
+    "Get the event loop that was given to set_event_loop, or None");
+
   // ROBOTUPDATE HANDLE ======================================================
   py::class_<agv::RobotUpdateHandle,
     std::shared_ptr<agv::RobotUpdateHandle>>(
     m, "RobotUpdateHandle")
   // Private constructor: Only to be constructed via FleetUpdateHandle!
-  .def("interrupted", &agv::RobotUpdateHandle::interrupted)
+  .def("interrupted", &agv::RobotUpdateHandle::interrupted,
+    py::call_guard<py::gil_scoped_release>())
   .def("update_current_waypoint",
     py::overload_cast<std::size_t, double>(
       &agv::RobotUpdateHandle::update_position),
     py::arg("waypoint"),
     py::arg("orientation"),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("update_current_lanes",
     py::overload_cast<const Eigen::Vector3d&,
     const std::vector<std::size_t>&>(
@@ -92,7 +111,8 @@ PYBIND11_MODULE(rmf_adapter, m) {
     py::arg("position"),
     py::arg("lanes"),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("update_off_grid_position",
     py::overload_cast<const Eigen::Vector3d&,
     std::size_t>(
@@ -100,7 +120,8 @@ PYBIND11_MODULE(rmf_adapter, m) {
     py::arg("position"),
     py::arg("target_waypoint"),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("update_lost_position",
     py::overload_cast<const std::string&,
     const Eigen::Vector3d&,
@@ -114,15 +135,25 @@ PYBIND11_MODULE(rmf_adapter, m) {
     py::arg("max_merge_lane_distance") = 1.0,
     py::arg("min_lane_length") = 1e-8,
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("set_charger_waypoint", &agv::RobotUpdateHandle::set_charger_waypoint,
     py::arg("charger_wp"),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("update_battery_soc", &agv::RobotUpdateHandle::update_battery_soc,
     py::arg("battery_soc"),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
+  .def("set_battery_soc_filter",
+    &agv::RobotUpdateHandle::set_battery_soc_filter,
+    py::arg("change_threshold"),
+    py::arg("hysteresis") = 0.0,
+    py::call_guard<py::scoped_ostream_redirect,
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def_property("maximum_delay",
     py::overload_cast<>(
       &agv::RobotUpdateHandle::maximum_delay, py::const_),
@@ -134,7 +165,8 @@ PYBIND11_MODULE(rmf_adapter, m) {
     [&](agv::RobotUpdateHandle& self)
     {
       self.maximum_delay(rmf_utils::nullopt);
-    })
+    },
+    py::call_guard<py::gil_scoped_release>())
   .def("set_maximum_delay",
     [&](agv::RobotUpdateHandle& self,
     double seconds)
@@ -142,7 +174,8 @@ PYBIND11_MODULE(rmf_adapter, m) {
       const auto duration = rmf_traffic::time::from_seconds(seconds);
       self.maximum_delay(duration);
     },
-    py::arg("seconds"))
+    py::arg("seconds"),
+    py::call_guard<py::gil_scoped_release>())
   .def("get_unstable_participant",
     [&](agv::RobotUpdateHandle& self)
     {
@@ -159,11 +192,14 @@ PYBIND11_MODULE(rmf_adapter, m) {
 
   py::class_<ActionExecution>(
     m_robot_update_handle, "ActionExecution")
-  .def("finished", &ActionExecution::finished)
-  .def("okay", &ActionExecution::okay)
+  .def("finished", &ActionExecution::finished,
+    py::call_guard<py::gil_scoped_release>())
+  .def("okay", &ActionExecution::okay,
+    py::call_guard<py::gil_scoped_release>())
   .def("update_remaining_time",
     &ActionExecution::update_remaining_time,
-    py::arg("remaining_time_estimate"));
+    py::arg("remaining_time_estimate"),
+    py::call_guard<py::gil_scoped_release>());
 
   // FLEETUPDATE HANDLE ======================================================
   py::class_<agv::FleetUpdateHandle,
@@ -190,10 +226,80 @@ PYBIND11_MODULE(rmf_adapter, m) {
     py::arg("handle_cb"))
   .def("close_lanes",
     &agv::FleetUpdateHandle::close_lanes,
-    py::arg("lane_indices"))
+    py::arg("lane_indices"),
+    py::call_guard<py::gil_scoped_release>())
   .def("open_lanes",
     &agv::FleetUpdateHandle::open_lanes,
-    py::arg("lane_indices"))
+    py::arg("lane_indices"),
+    py::call_guard<py::gil_scoped_release>())
+  .def("change_lanes",
+    &agv::FleetUpdateHandle::change_lanes,
+    py::arg("open_lanes"),
+    py::arg("close_lanes"),
+    py::call_guard<py::gil_scoped_release>())
+  .def("update_positions",
+    [](agv::FleetUpdateHandle& self,
+    const std::vector<std::shared_ptr<agv::RobotUpdateHandle>>& robots,
+    const Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>& positions,
+    const std::vector<int64_t>& waypoints,
+    const std::vector<std::vector<std::size_t>>& lanes,
+    const std::vector<std::string>& map_names)
+    {
+      const std::size_t n = robots.size();
+      const auto check_size = [n](std::size_t size, const char* name)
+      {
+        if (size != 0 && size != n)
+        {
+          throw std::invalid_argument(
+            std::string("update_positions: [") + name + "] has "
+            + std::to_string(size) + " entries but there are "
+            + std::to_string(n) + " robots");
+        }
+      };
+
+      check_size(static_cast<std::size_t>(positions.rows()), "positions");
+      check_size(waypoints.size(), "waypoints");
+      check_size(lanes.size(), "lanes");
+      check_size(map_names.size(), "map_names");
+      if (n > 0 && positions.rows() == 0)
+        throw std::invalid_argument("update_positions: [positions] is empty");
+
+      using RobotPosition = agv::FleetUpdateHandle::RobotPosition;
+      std::vector<RobotPosition> updates;
+      updates.reserve(n);
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        const Eigen::Vector3d p = positions.row(i).transpose();
+        if (!lanes.empty() && !lanes[i].empty())
+          updates.push_back(RobotPosition::on_lanes(robots[i], p, lanes[i]));
+        else if (!waypoints.empty() && waypoints[i] >= 0)
+        {
+          updates.push_back(
+            RobotPosition::off_grid(robots[i], p, waypoints[i]));
+        }
+        else if (!map_names.empty() && !map_names[i].empty())
+          updates.push_back(RobotPosition::lost(robots[i], map_names[i], p));
+        else
+        {
+          throw std::invalid_argument(
+            "update_positions: robot #" + std::to_string(i) + " needs "
+            "lanes, a waypoint, or a map name");
+        }
+      }
+
+      py::gil_scoped_release release;
+      self.update_positions(updates);
+    },
+    py::arg("robots"),
+    py::arg("positions"),
+    py::arg("waypoints") = std::vector<int64_t>(),
+    py::arg("lanes") = std::vector<std::vector<std::size_t>>(),
+    py::arg("map_names") = std::vector<std::string>(),
+    "Update the positions of many robots at once. positions is an (N, 3)\
+     array of x, y, yaw. For each robot, its lanes are used if it has any,\
+     otherwise its waypoint is used as in update_off_grid_position if it is\
+     not negative, otherwise its map name is used as in\
+     update_lost_position.")
   .def("set_task_planner_params",
     [&](agv::FleetUpdateHandle& self,
     battery::BatterySystem& b_sys,
@@ -425,27 +531,37 @@ PYBIND11_MODULE(rmf_adapter, m) {
       &agv::EasyTrafficLight::follow_new_path),
     py::arg("waypoint"),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("moving_from",
     py::overload_cast<std::size_t, Eigen::Vector3d>(
       &agv::EasyTrafficLight::moving_from),
     py::arg("checkpoint"),
-    py::arg("location"))
+    py::arg("location"),
+    py::call_guard<py::gil_scoped_release>())
   .def("waiting_at",
     py::overload_cast<std::size_t>(
       &agv::EasyTrafficLight::waiting_at),
-    py::arg("checkpoint"))
+    py::arg("checkpoint"),
+    py::call_guard<py::gil_scoped_release>())
   .def("waiting_after",
     py::overload_cast<std::size_t, Eigen::Vector3d>(
       &agv::EasyTrafficLight::waiting_after),
     py::arg("checkpoint"),
-    py::arg("location"))
-  .def("last_reached", &agv::EasyTrafficLight::last_reached)
+    py::arg("location"),
+    py::call_guard<py::gil_scoped_release>())
+  .def("last_reached", &agv::EasyTrafficLight::last_reached,
+    py::call_guard<py::gil_scoped_release>())
   .def("update_idle_location",
     py::overload_cast<std::string, Eigen::Vector3d>(
       &agv::EasyTrafficLight::update_idle_location),
     py::arg("map_name"),
-    py::arg("position"));
+    py::arg("position"),
+    py::call_guard<py::gil_scoped_release>())
+  .def_static("update_states",
+    &agv::EasyTrafficLight::update_states,
+    py::arg("states"),
+    py::call_guard<py::gil_scoped_release>());
 
   // prefix traffic light
   auto m_easy_traffic_light = m.def_submodule("easy_traffic_light");
@@ -470,6 +586,32 @@ PYBIND11_MODULE(rmf_adapter, m) {
   .value("Wait",
     agv::EasyTrafficLight::WaitingInstruction::Wait);
 
+  py::class_<agv::EasyTrafficLight::State>(m_easy_traffic_light, "State")
+  .def_static("moving_from",
+    &agv::EasyTrafficLight::State::moving_from,
+    py::arg("robot"),
+    py::arg("checkpoint"),
+    py::arg("location"))
+  .def_static("waiting_at",
+    &agv::EasyTrafficLight::State::waiting_at,
+    py::arg("robot"),
+    py::arg("checkpoint"))
+  .def_static("waiting_after",
+    &agv::EasyTrafficLight::State::waiting_after,
+    py::arg("robot"),
+    py::arg("checkpoint"),
+    py::arg("location"))
+  .def_static("idle",
+    &agv::EasyTrafficLight::State::idle,
+    py::arg("robot"),
+    py::arg("map_name"),
+    py::arg("location"));
+
+  py::class_<agv::EasyTrafficLight::Instruction>(
+    m_easy_traffic_light, "Instruction")
+  .def_readonly("moving", &agv::EasyTrafficLight::Instruction::moving)
+  .def_readonly("waiting", &agv::EasyTrafficLight::Instruction::waiting);
+
   // ADAPTER =================================================================
   // Light wrappers
   py::class_<rclcpp::NodeOptions>(m, "NodeOptions")
@@ -488,14 +630,18 @@ PYBIND11_MODULE(rmf_adapter, m) {
 
   // Python rclcpp init and spin call
   m.def("init_rclcpp", []() { rclcpp::init(0, nullptr); });
+  // Spinning runs callbacks that may call back into Python, so the GIL is
+  // released while spinning.
   m.def("spin_rclcpp", [](rclcpp::Node::SharedPtr node_pt)
     {
       rclcpp::spin(node_pt);
-    });
+    },
+    py::call_guard<py::gil_scoped_release>());
   m.def("spin_some_rclcpp", [](rclcpp::Node::SharedPtr node_pt)
     {
       rclcpp::spin_some(node_pt);
-    });
+    },
+    py::call_guard<py::gil_scoped_release>());
 
   py::class_<agv::Adapter, std::shared_ptr<agv::Adapter>>(m, "Adapter")
   // .def(py::init<>())  // Private constructor
@@ -505,7 +651,8 @@ PYBIND11_MODULE(rmf_adapter, m) {
     py::arg("wait_time") = rmf_utils::optional<rmf_traffic::Duration>(
       rmf_utils::nullopt),
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>())
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>())
   .def("add_fleet", &agv::Adapter::add_fleet,
     py::arg("fleet_name"),
     py::arg("traits"),
@@ -521,8 +668,10 @@ PYBIND11_MODULE(rmf_adapter, m) {
     py::arg("blocker_callback") = nullptr)
   .def_property_readonly("node",
     py::overload_cast<>(&agv::Adapter::node))
-  .def("start", &agv::Adapter::start)
-  .def("stop", &agv::Adapter::stop)
+  .def("start", &agv::Adapter::start,
+    py::call_guard<py::gil_scoped_release>())
+  .def("stop", &agv::Adapter::stop,
+    py::call_guard<py::gil_scoped_release>())
   .def("now", [](agv::Adapter& self)
     {
       return TimePoint(rmf_traffic_ros2::convert(self.node()->now())
@@ -550,8 +699,10 @@ PYBIND11_MODULE(rmf_adapter, m) {
     &agv::test::MockAdapter::dispatch_task,
     py::arg("task_id"),
     py::arg("request"))
-  .def("start", &agv::test::MockAdapter::start)
-  .def("stop", &agv::test::MockAdapter::stop)
+  .def("start", &agv::test::MockAdapter::start,
+    py::call_guard<py::gil_scoped_release>())
+  .def("stop", &agv::test::MockAdapter::stop,
+    py::call_guard<py::gil_scoped_release>())
   .def("now", [&](agv::test::MockAdapter& self)
     {
       return TimePoint(rmf_traffic_ros2::convert(self.node()->now())
@@ -194,5 +194,18 @@ void bind_graph(py::module& m)
 
   // PARSE GRAPH ==============================================================
   // Helper function to parse a graph from a yaml file
-  m_graph.def("parse_graph", &rmf_fleet_adapter::agv::parse_graph);
+  m_graph.def("parse_graph",
+    py::overload_cast<
+      const std::string&,
+      const rmf_traffic::agv::VehicleTraits&>(
+      &rmf_fleet_adapter::agv::parse_graph));
+  m_graph.def("parse_graph",
+    py::overload_cast<
+      const std::string&,
+      const rmf_traffic::agv::VehicleTraits&,
+      const std::string&>(
+      &rmf_fleet_adapter::agv::parse_graph),
+    py::arg("filename"),
+    py::arg("vehicle_traits"),
+    py::arg("cache_directory"));
 }
@@ -2,6 +2,7 @@
 #include <pybind11/iostream.h>
 #include <pybind11/chrono.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
 #include "rmf_traffic_ros2/Time.hpp"
@@ -48,6 +49,39 @@ Start make_start(TimePoint initial_time,
       initial_lane);
 }
 
+// Put the positions, times and graph indices of the waypoints of a plan into
+// NumPy arrays in one pass, so that Python code which only needs the numbers
+// does not have to create an object for every waypoint. Times are given as
+// nanoseconds since the epoch, and waypoints without a graph index get -1.
+py::dict waypoint_arrays(const std::vector<Plan::Waypoint>& waypoints)
+{
+  const auto n = static_cast<py::ssize_t>(waypoints.size());
+  py::array_t<double> positions({n, static_cast<py::ssize_t>(3)});
+  py::array_t<int64_t> times(n);
+  py::array_t<int64_t> graph_indices(n);
+
+  auto p = positions.mutable_unchecked<2>();
+  auto t = times.mutable_unchecked<1>();
+  auto g = graph_indices.mutable_unchecked<1>();
+  for (py::ssize_t i = 0; i < n; ++i)
+  {
+    const auto& wp = waypoints[i];
+    const Eigen::Vector3d& position = wp.position();
+    p(i, 0) = position[0];
+    p(i, 1) = position[1];
+    p(i, 2) = position[2];
+    t(i) = wp.time().time_since_epoch().count();
+    g(i) = wp.graph_index().has_value() ?
+      static_cast<int64_t>(*wp.graph_index()) : -1;
+  }
+
+  py::dict arrays;
+  arrays["positions"] = std::move(positions);
+  arrays["times"] = std::move(times);
+  arrays["graph_indices"] = std::move(graph_indices);
+  return arrays;
+}
+
 Planner make_planner(Configuration config)
 {
   const auto default_options = Options{nullptr};
@@ -118,7 +152,8 @@ void bind_plan(py::module& m)
     py::arg("max_merge_lane_distance") = 1.0,
     py::arg("min_lane_length") = 1e-8,
     py::call_guard<py::scoped_ostream_redirect,
-    py::scoped_estream_redirect>());
+    py::scoped_estream_redirect,
+    py::gil_scoped_release>());
 
   // PLAN ======================================================================
   py::class_<Plan>(m_plan, "Plan")
@@ -128,7 +163,14 @@ void bind_plan(py::module& m)
   .def_property_readonly("waypoints",
     &Plan::get_waypoints)
   .def_property_readonly("start",
-    &Plan::get_start);
+    &Plan::get_start)
+  .def("waypoint_arrays",
+    [](const Plan& self)
+    {
+      return waypoint_arrays(self.get_waypoints());
+    },
+    "Get a dict of NumPy arrays with the positions (N, 3), times (N) in\
+     nanoseconds and graph_indices (N, -1 for none) of the waypoints");
 
   // WAYPOINT ==================================================================
   py::class_<Plan::Waypoint>(m_plan, "Waypoint")
@@ -197,6 +239,25 @@ void bind_plan(py::module& m)
 
     },
     py::arg("start"), py::arg("goal"),
-    py::return_value_policy::reference_internal);
+    py::return_value_policy::reference_internal)
+  .def("get_plan_waypoint_arrays",
+    [](Planner& self,
+    Start start,
+    Goal goal) -> std::optional<py::dict>
+    {
+      std::optional<Planner::Result> result;
+      {
+        py::gil_scoped_release release;
+        result.emplace(self.plan(start, goal));
+      }
+
+      if (!result->success())
+        return std::nullopt;
+
+      return waypoint_arrays((*result)->get_waypoints());
+    },
+    py::arg("start"), py::arg("goal"),
+    "Plan from the start to the goal and return the waypoints in the same\
+     form as Plan.waypoint_arrays, or None if no plan was found");
 
 }
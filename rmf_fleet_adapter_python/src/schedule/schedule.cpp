@@ -1,6 +1,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/eigen.h>
 #include <pybind11/chrono.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
 #include <rmf_traffic/schedule/Participant.hpp>
@@ -36,10 +37,13 @@ void bind_schedule(py::module& m)
       &schedule::Participant::delay, py::const_),
     py::overload_cast<
       rmf_traffic::Duration>(&schedule::Participant::delay))
-  .def("erase", &schedule::Participant::erase, py::arg("routes"))
-  .def("clear", &schedule::Participant::clear)
+  .def("erase", &schedule::Participant::erase, py::arg("routes"),
+    py::call_guard<py::gil_scoped_release>())
+  .def("clear", &schedule::Participant::clear,
+    py::call_guard<py::gil_scoped_release>())
   .def("get_itinerary", &schedule::Participant::itinerary)
-  .def("set_itinerary", &schedule::Participant::set, py::arg("itinerary"));
+  .def("set_itinerary", &schedule::Participant::set, py::arg("itinerary"),
+    py::call_guard<py::gil_scoped_release>());
 
   /// Writer::Item =============================================================
   py::class_<schedule::Writer::Item>(m_schedule, "Item")
@@ -82,6 +86,57 @@ void bind_schedule(py::module& m)
     py::arg("input_positions"));
 
   // TRAJECTORY ================================================================
+  // The waypoint arrays are filled in one pass so that Python code which only
+  // needs the numbers does not create an object for every waypoint.
   py::class_<rmf_traffic::Trajectory,
-    std::shared_ptr<rmf_traffic::Trajectory>>(m_schedule, "Trajectory");
+    std::shared_ptr<rmf_traffic::Trajectory>>(m_schedule, "Trajectory")
+  .def("__len__", &rmf_traffic::Trajectory::size)
+  .def("positions",
+    [](const rmf_traffic::Trajectory& self)
+    {
+      py::array_t<double> output(
+        {static_cast<py::ssize_t>(self.size()), static_cast<py::ssize_t>(3)});
+      auto out = output.mutable_unchecked<2>();
+      py::ssize_t i = 0;
+      for (const auto& wp : self)
+      {
+        const Eigen::Vector3d p = wp.position();
+        out(i, 0) = p[0];
+        out(i, 1) = p[1];
+        out(i, 2) = p[2];
+        ++i;
+      }
+      return output;
+    },
+    "Get an (N, 3) NumPy array of the x, y, yaw of each waypoint")
+  .def("velocities",
+    [](const rmf_traffic::Trajectory& self)
+    {
+      py::array_t<double> output(
+        {static_cast<py::ssize_t>(self.size()), static_cast<py::ssize_t>(3)});
+      auto out = output.mutable_unchecked<2>();
+      py::ssize_t i = 0;
+      for (const auto& wp : self)
+      {
+        const Eigen::Vector3d v = wp.velocity();
+        out(i, 0) = v[0];
+        out(i, 1) = v[1];
+        out(i, 2) = v[2];
+        ++i;
+      }
+      return output;
+    },
+    "Get an (N, 3) NumPy array of the velocity of each waypoint")
+  .def("times",
+    [](const rmf_traffic::Trajectory& self)
+    {
+      py::array_t<int64_t> output(static_cast<py::ssize_t>(self.size()));
+      auto out = output.mutable_unchecked<1>();
+      py::ssize_t i = 0;
+      for (const auto& wp : self)
+        out(i++) = wp.time().time_since_epoch().count();
+
+      return output;
+    },
+    "Get a NumPy array of the time of each waypoint in nanoseconds");
 }
@@ -1,3 +1,6 @@
+import asyncio
+import threading
+
 import rmf_adapter as adpt
 from typing import Callable
 
@@ -83,3 +86,48 @@ def test_cpp_side_methods(capsys):
                          lambda: print("not overridden"))
     captured = capsys.readouterr()
     assert captured.out == "overridden\n", "Python method override failed"
+
+
+class AsyncTestHandle(adpt.RobotCommandHandle):
+    __test__ = False
+
+    def __init__(self):
+        adpt.RobotCommandHandle.__init__(self)
+        self.started = threading.Event()
+        self.release = None
+
+    async def dock(self,
+                   dock_name: str,
+                   docking_finished_callback: Callable) -> None:
+        self.started.set()
+        await self.release.wait()
+
+
+def test_coroutine_commands():
+    loop = asyncio.new_event_loop()
+    thread = threading.Thread(target=loop.run_forever, daemon=True)
+    thread.start()
+    adpt.set_event_loop(loop)
+    assert adpt.get_event_loop() is loop
+
+    try:
+        test_obj = AsyncTestHandle()
+        test_obj.release = asyncio.run_coroutine_threadsafe(
+            _make_event(), loop).result()
+
+        finished = threading.Event()
+        adpt.test_shared_ptr(test_obj, "dock_rawr", finished.set)
+        assert test_obj.started.wait(5), "Coroutine was not scheduled"
+        assert not finished.is_set(), "Docking finished too early"
+
+        loop.call_soon_threadsafe(test_obj.release.set)
+        assert finished.wait(5), "Docking was not finished by the coroutine"
+    finally:
+        adpt.set_event_loop(None)
+        loop.call_soon_threadsafe(loop.stop)
+        thread.join()
+        loop.close()
+
+
+async def _make_event():
+    return asyncio.Event()
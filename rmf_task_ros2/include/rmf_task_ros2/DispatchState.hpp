@@ -77,6 +77,10 @@ struct DispatchState
   /// Any errors that have occurred for this dispatching
   std::vector<nlohmann::json> errors;
 
+  /// How many times a dispatch command for this task had to be sent again
+  /// because the fleet adapter did not acknowledge it
+  std::size_t retransmissions = 0;
+
   DispatchState(std::string task_id, rmf_traffic::Time submission_time);
 };
 
@@ -105,11 +105,48 @@ public:
     const TaskID& task_id) const;
 
   /// Get a mutable ref of active tasks map list handled by dispatcher
+  ///
+  /// \warning The map may be modified by the dispatcher's callbacks, so only
+  /// use this while the dispatcher is not spinning. Use get_dispatch_state()
+  /// otherwise.
   const DispatchStates& active_dispatches() const;
 
   /// Get a mutable ref of terminated tasks map list
+  ///
+  /// \warning The same caveat as active_dispatches() applies.
   const DispatchStates& finished_dispatches() const;
 
+  /// Get the maximum number of finished dispatches that will be retained. The
+  /// ones with the oldest submission time are dropped first. This is set by
+  /// the terminated_tasks_max_size parameter.
+  std::size_t finished_dispatches_limit() const;
+
+  /// Get an estimate of how many bytes are used to retain the finished
+  /// dispatches. This takes time proportional to their number.
+  std::size_t finished_dispatches_memory() const;
+
+  /// Statistics about the responses to task API requests that are remembered
+  /// so that retried requests can be answered right away
+  struct ApiCacheStatistics
+  {
+    /// How many requests were answered from the cache
+    std::size_t hits = 0;
+
+    /// How many requests had no usable response in the cache
+    std::size_t misses = 0;
+
+    /// How many responses are in the cache right now
+    std::size_t entries = 0;
+
+    /// An estimate of how many bytes the cached responses use
+    std::size_t memory = 0;
+  };
+
+  /// Get statistics about the cache of API responses. Its limits are set by
+  /// the api_response_cache_size, api_response_cache_memory, and
+  /// api_response_cache_ttl parameters.
+  ApiCacheStatistics api_cache_statistics() const;
+
   using DispatchStateCallback =
     std::function<void(const DispatchState& status)>;
 
@@ -126,10 +163,20 @@ public:
   ///   evaluator used to select the best bid from fleets
   void evaluator(bidding::Auctioneer::ConstEvaluatorPtr evaluator);
 
+  /// Choose the winners of all the bids that are open at the same time
+  /// together, instead of each one on its own. This is most useful with a
+  /// concurrent_bid_limit above 1. Pass a nullptr to go back to the evaluator.
+  ///
+  /// \param [in] evaluator
+  ///   evaluator used to select the best bids from fleets, e.g.
+  ///   `AssignmentBatchEvaluator`
+  void batch_evaluator(bidding::Auctioneer::ConstBatchEvaluatorPtr evaluator);
+
   /// Get the rclcpp::Node that this dispatcher will be using for communication.
   std::shared_ptr<rclcpp::Node> node();
 
-  /// spin dispatcher node
+  /// spin dispatcher node on a multi-threaded executor, so that API requests
+  /// can be handled while the dispatch states are being broadcast
   void spin();
 
   class Implementation;
@@ -26,6 +26,12 @@ const std::string Prefix = "rmf_task/";
 const std::string BidNoticeTopicName = Prefix + "bid_notice";
 const std::string BidResponseTopicName = Prefix + "bid_response";
 
+// Bidders that advertise their capabilities on this topic only receive the bid
+// notices that they could bid on, on a topic of their own that starts with
+// this prefix.
+const std::string FleetCapabilitiesTopicName = Prefix + "fleet_capabilities";
+const std::string DirectedBidNoticeTopicPrefix = Prefix + "bid_notice_to_";
+
 const std::string SubmitTaskSrvName = "submit_task";
 const std::string CancelTaskSrvName = "cancel_task";
 const std::string GetDispatchStatesSrvName = "get_dispatches";
@@ -33,6 +39,11 @@ const std::string GetDispatchStatesSrvName = "get_dispatches";
 const std::string DispatchCommandTopicName = Prefix + "dispatch_request";
 const std::string DispatchAckTopicName = Prefix + "dispatch_ack";
 const std::string DispatchStatesTopicName = "dispatch_states";
+
+// Only the dispatch states that changed since the previous message. Gaps can
+// be detected with the publication sequence number of each message, and the
+// GetDispatchStatesSrvName service gives a full snapshot for late joiners.
+const std::string DispatchStateChangesTopicName = "dispatch_state_changes";
 const std::string TaskStatusTopicName = "task_summaries";
 
 } // namespace rmf_task_ros2
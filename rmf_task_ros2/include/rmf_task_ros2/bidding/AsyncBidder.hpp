@@ -18,11 +18,13 @@
 #ifndef RMF_TASK_ROS2__BIDDING__ASYNCBIDDER_HPP
 #define RMF_TASK_ROS2__BIDDING__ASYNCBIDDER_HPP
 
+#include <chrono>
 #include <unordered_set>
 
 #include <rclcpp/node.hpp>
 #include <rmf_utils/impl_ptr.hpp>
 
+#include <rmf_task_ros2/bidding/Capabilities.hpp>
 #include <rmf_task_ros2/bidding/Response.hpp>
 
 namespace rmf_task_ros2 {
@@ -35,7 +37,11 @@ public:
 
   using Respond = std::function<void(const Response&)>;
 
-  /// Callback function when a bid notice is received from the autioneer
+  /// Callback function when a bid notice is received from the autioneer. The
+  /// callback should respond to every notice, using a Response without a
+  /// proposal to decline. The auctioneer concludes an auction early once all
+  /// bidders have responded, so a bidder that stays silent makes it wait for
+  /// the whole time window.
   ///
   /// \param[in] notice
   ///   bid notice msg
@@ -45,6 +51,41 @@ public:
   using ReceiveNotice =
     std::function<void(const BidNoticeMsg& notice, Respond respond)>;
 
+  using Deadline = std::chrono::steady_clock::time_point;
+
+  /// The same as ReceiveNotice, but the callback is also told when the time
+  /// window of the auction closes. A response after the deadline would be
+  /// ignored by the auctioneer, so it will not be sent. A bidder that knows it
+  /// cannot finish its evaluation in time should decline right away, which
+  /// lets the auction conclude early.
+  ///
+  /// Several notices may be handed over before any of them is responded to,
+  /// so the callback may evaluate them concurrently.
+  using ReceiveNoticeWithDeadline =
+    std::function<void(
+        const BidNoticeMsg& notice,
+        Deadline deadline,
+        Respond respond)>;
+
+  /// How many of the notices received by this bidder were responded to in
+  /// time
+  struct Statistics
+  {
+    /// Notices that have been received
+    std::size_t notices = 0;
+
+    /// Responses, with or without a proposal, that were sent before the
+    /// deadline of their auction
+    std::size_t on_time = 0;
+
+    /// Responses that were dropped because their deadline had passed
+    std::size_t late = 0;
+
+    /// The fraction of responses that were on time, or 1.0 if there have not
+    /// been any responses yet
+    double on_time_ratio() const;
+  };
+
   /// Create a bidder to bid for incoming task requests from Task Dispatcher
   ///
   /// \param[in] node
@@ -62,6 +103,22 @@ public:
     const std::shared_ptr<rclcpp::Node>& node,
     ReceiveNotice notice_cb);
 
+  /// Create a bidder whose callback is told the deadline of each auction
+  static std::shared_ptr<AsyncBidder> make(
+    const std::shared_ptr<rclcpp::Node>& node,
+    ReceiveNoticeWithDeadline notice_cb);
+
+  /// Get the statistics of the responses of this bidder so far
+  Statistics statistics() const;
+
+  /// Tell the auctioneer what this bidder is able to do. From then on, the
+  /// bidder only receives the notices for tasks that it could bid on, instead
+  /// of every notice. Call this again whenever the capabilities change.
+  ///
+  /// \param[in] capabilities
+  ///   The capabilities of the fleet. The topic is filled in by the bidder.
+  void advertise(Capabilities capabilities);
+
   class Implementation;
 
 private:
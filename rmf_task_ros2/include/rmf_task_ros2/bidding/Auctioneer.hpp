@@ -18,6 +18,7 @@
 #ifndef RMF_TASK_ROS2__BIDDING__AUCTIONEER_HPP
 #define RMF_TASK_ROS2__BIDDING__AUCTIONEER_HPP
 
+#include <functional>
 #include <queue>
 #include <rclcpp/node.hpp>
 #include <rmf_utils/impl_ptr.hpp>
@@ -65,6 +66,25 @@ public:
 
   using ConstEvaluatorPtr = std::shared_ptr<const Evaluator>;
 
+  /// A pure abstract interface class for choosing the winners of several
+  /// auctions together. Choosing each winner in isolation tends to give every
+  /// task of a burst to the same fleet, because each of its bids assumed that
+  /// it would only be given that one task.
+  class BatchEvaluator
+  {
+  public:
+
+    /// Given the responses of each auction in a batch, choose the best
+    /// response of each auction. The result must have one entry per auction,
+    /// in the same order, with a nullopt for an auction that has no winner.
+    virtual std::vector<std::optional<std::size_t>> choose(
+      const std::vector<Responses>& batch) const = 0;
+
+    virtual ~BatchEvaluator() = default;
+  };
+
+  using ConstBatchEvaluatorPtr = std::shared_ptr<const BatchEvaluator>;
+
   /// Create an instance of the Auctioneer. This instance will handle all
   /// the task dispatching bidding mechanism. A default evaluator is used.
   ///
@@ -80,8 +100,11 @@ public:
     BiddingResultCallback result_callback,
     ConstEvaluatorPtr evaluator);
 
-  /// Start a bidding process by provide a bidding task. Note the each
-  /// bidding process is conducted sequentially
+  /// Start a bidding process by provide a bidding task. Up to
+  /// concurrent_bid_limit() bidding processes are conducted at once, and the
+  /// rest wait their turn in the order they were requested. A bidding process
+  /// concludes when its time window is over or when every bidder that is
+  /// subscribed to bid notices has responded, whichever comes first.
   ///
   /// \param[in] bid_notice
   ///   bidding task, task which will call for bid
@@ -90,12 +113,30 @@ public:
   /// Call this to tell the auctioneer that it may begin to perform the next bid
   void ready_for_next_bid();
 
+  /// Set how many bidding processes may be in progress at once. A bidding
+  /// process counts against this limit from the moment its notice is sent out
+  /// until ready_for_next_bid() is called for it. The default is 1, and
+  /// values lower than that are treated as 1.
+  void set_concurrent_bid_limit(std::size_t limit);
+
+  /// Get how many bidding processes may be in progress at once
+  std::size_t concurrent_bid_limit() const;
+
   /// Provide a custom evaluator which will be used to choose the best bid
   /// If no selection is given, Default is: LeastFleetDiffCostEvaluator
   ///
   /// \param[in] evaluator
   void set_evaluator(ConstEvaluatorPtr evaluator);
 
+  /// Provide an evaluator that chooses the winners of all the open bidding
+  /// processes together. While this is set, the bidding processes that are in
+  /// progress are only concluded once all of them are ready, and the evaluator
+  /// from set_evaluator() is not used. Pass a nullptr to go back to concluding
+  /// each bidding process on its own.
+  ///
+  /// \param[in] evaluator
+  void set_batch_evaluator(ConstBatchEvaluatorPtr evaluator);
+
   class Implementation;
 
 private:
@@ -124,6 +165,35 @@ public:
   std::optional<std::size_t> choose(const Responses& submissions) const final;
 };
 
+//==============================================================================
+/// Chooses the winners of a batch by solving an assignment problem with the
+/// Hungarian method. Each robot, identified by its fleet name and expected
+/// robot name, wins at most one task of the batch, and the total cost of the
+/// winning proposals is minimized. When there are more tasks than robots to
+/// go around, the tasks that are left over go to their cheapest proposal.
+///
+/// This takes O(n^3) time, where n is the number of tasks or the number of
+/// robots, whichever is larger.
+class AssignmentBatchEvaluator : public Auctioneer::BatchEvaluator
+{
+public:
+
+  using ProposalCost = std::function<double(const Response::Proposal&)>;
+
+  /// Constructor
+  ///
+  /// \param[in] cost
+  ///   The cost of awarding a task to a proposal. If this is a nullptr, the
+  ///   change in fleet cost is used, like LeastFleetDiffCostEvaluator.
+  AssignmentBatchEvaluator(ProposalCost cost = nullptr);
+
+  std::vector<std::optional<std::size_t>> choose(
+    const std::vector<Responses>& batch) const final;
+
+private:
+  ProposalCost _cost;
+};
+
 } // namespace bidding
 } // namespace rmf_task_ros2
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK_ROS2__BIDDING__CAPABILITIES_HPP
+#define RMF_TASK_ROS2__BIDDING__CAPABILITIES_HPP
+
+#include <rmf_task_msgs/msg/api_request.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+namespace rmf_task_ros2 {
+namespace bidding {
+
+//==============================================================================
+/// What a bidder is able to do. A bidder that advertises its capabilities
+/// only receives the bid notices for tasks that it could plausibly bid on.
+struct Capabilities
+{
+  /// The name of the fleet that is bidding
+  std::string fleet_name;
+
+  /// The task categories that the fleet will consider, e.g. "patrol" or
+  /// "compose"
+  std::unordered_set<std::string> categories;
+
+  /// The categories of perform_action activities that the fleet will consider
+  std::unordered_set<std::string> actions;
+
+  /// The topic that the bidder listens to for its bid notices. This is filled
+  /// in by the bidder.
+  std::string topic;
+
+  /// Check whether the fleet could plausibly bid on a task request. This only
+  /// looks at the category of the task and the actions that it asks for, so
+  /// the fleet may still decline.
+  bool could_bid(const nlohmann::json& task_request) const;
+};
+
+//==============================================================================
+using CapabilitiesMsg = rmf_task_msgs::msg::ApiRequest;
+
+//==============================================================================
+CapabilitiesMsg convert(const Capabilities& capabilities);
+
+//==============================================================================
+/// Returns std::nullopt if the message is malformed
+std::optional<Capabilities> convert(const CapabilitiesMsg& msg);
+
+//==============================================================================
+/// Get the topic that a fleet listens to for the bid notices that are only
+/// sent to it
+std::string directed_bid_notice_topic(const std::string& fleet_name);
+
+} // namespace bidding
+} // namespace rmf_task_ros2
+
+#endif // RMF_TASK_ROS2__BIDDING__CAPABILITIES_HPP
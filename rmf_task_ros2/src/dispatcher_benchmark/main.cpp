@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark runs a dispatcher against a set of mock bidders in a
+/// single process and reports how quickly tasks get awarded. It takes these
+/// ROS 2 parameters on the rmf_dispatcher_benchmark node:
+///  - bidders: How many mock fleets bid on each task
+///  - submission_rate: How many tasks are submitted per second
+///  - duration: How many seconds to keep submitting tasks for
+///  - min_response_delay, max_response_delay: The range of seconds that each
+///    mock fleet waits before responding to a bid notice
+///
+/// The dispatcher node takes its usual parameters, e.g. bidding_time_window
+/// and concurrent_bid_limit.
+
+#include <rmf_task_ros2/Dispatcher.hpp>
+#include <rmf_task_ros2/StandardNames.hpp>
+#include <rmf_task_ros2/bidding/AsyncBidder.hpp>
+
+#include <rmf_task_msgs/msg/api_request.hpp>
+#include <rmf_task_msgs/msg/api_response.hpp>
+#include <rmf_task_msgs/msg/dispatch_command.hpp>
+#include <rmf_task_msgs/msg/dispatch_ack.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rmf_traffic_ros2/Time.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace rmf_task_ros2;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+//==============================================================================
+/// A fleet that responds to every bid notice after a random delay and
+/// acknowledges every dispatch command that is directed at it
+class MockFleet
+{
+public:
+
+  using DispatchCommandMsg = rmf_task_msgs::msg::DispatchCommand;
+  using DispatchAckMsg = rmf_task_msgs::msg::DispatchAck;
+
+  MockFleet(
+    const rclcpp::NodeOptions& options,
+    std::string fleet_name,
+    double min_delay,
+    double max_delay,
+    unsigned int seed)
+  : _node(std::make_shared<rclcpp::Node>(fleet_name, options)),
+    _fleet_name(std::move(fleet_name)),
+    _random(seed),
+    _delay(min_delay, std::max(min_delay, max_delay))
+  {
+    _bidder = bidding::AsyncBidder::make(
+      _node,
+      [this](
+        const bidding::BidNoticeMsg& notice,
+        bidding::AsyncBidder::Respond respond)
+      {
+        this->receive_notice(notice, std::move(respond));
+      });
+
+    _ack_pub = _node->create_publisher<DispatchAckMsg>(
+      DispatchAckTopicName,
+      rclcpp::ServicesQoS().keep_last(20).reliable().transient_local());
+
+    _command_sub = _node->create_subscription<DispatchCommandMsg>(
+      DispatchCommandTopicName,
+      rclcpp::ServicesQoS().keep_last(20).reliable().transient_local(),
+      [this](const DispatchCommandMsg::UniquePtr msg)
+      {
+        if (msg->fleet_name != _fleet_name)
+          return;
+
+        DispatchAckMsg ack;
+        ack.dispatch_id = msg->dispatch_id;
+        ack.success = true;
+        _ack_pub->publish(ack);
+      });
+
+    _timer = _node->create_wall_timer(
+      std::chrono::milliseconds(5), [this]() { this->respond_when_due(); });
+  }
+
+  const std::shared_ptr<rclcpp::Node>& node() const
+  {
+    return _node;
+  }
+
+private:
+
+  struct PendingResponse
+  {
+    Clock::time_point due;
+    bidding::AsyncBidder::Respond respond;
+    rmf_traffic::Time finish_time;
+  };
+
+  void receive_notice(
+    const bidding::BidNoticeMsg&,
+    bidding::AsyncBidder::Respond respond)
+  {
+    const double delay = _delay(_random);
+    const auto now = Clock::now();
+    _pending.push_back(
+      PendingResponse{
+        now + rmf_traffic::time::from_seconds(delay),
+        std::move(respond),
+        rmf_traffic::time::apply_offset(now, 60.0 + 60.0*delay)
+      });
+  }
+
+  void respond_when_due()
+  {
+    const auto now = Clock::now();
+    for (auto it = _pending.begin(); it != _pending.end(); )
+    {
+      if (now < it->due)
+      {
+        ++it;
+        continue;
+      }
+
+      // The cost is varied by the delay so that the fleets rank differently
+      // for each task
+      const double cost = rmf_traffic::time::to_seconds(
+        it->finish_time - now);
+
+      it->respond(
+        bidding::Response{
+          bidding::Response::Proposal{
+            _fleet_name,
+            _fleet_name + "_robot",
+            0.0,
+            cost,
+            it->finish_time
+          },
+          {}
+        });
+
+      it = _pending.erase(it);
+    }
+  }
+
+  std::shared_ptr<rclcpp::Node> _node;
+  std::string _fleet_name;
+  std::mt19937 _random;
+  std::uniform_real_distribution<double> _delay;
+  std::shared_ptr<bidding::AsyncBidder> _bidder;
+  rclcpp::Publisher<DispatchAckMsg>::SharedPtr _ack_pub;
+  rclcpp::Subscription<DispatchCommandMsg>::SharedPtr _command_sub;
+  rclcpp::TimerBase::SharedPtr _timer;
+  std::vector<PendingResponse> _pending;
+};
+
+//==============================================================================
+std::size_t resident_memory()
+{
+  std::ifstream statm("/proc/self/statm");
+  std::size_t total = 0;
+  std::size_t resident = 0;
+  if (!(statm >> total >> resident))
+    return 0;
+
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+//==============================================================================
+double percentile(const std::vector<double>& sorted, const double p)
+{
+  if (sorted.empty())
+    return 0.0;
+
+  const auto index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+//==============================================================================
+/// Keeps track of when each task was submitted and when it was awarded
+class Tracker
+{
+public:
+
+  void submitted(const std::string& request_id)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _submit_time[request_id] = Clock::now();
+  }
+
+  void responded(const std::string& request_id, const std::string& task_id)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _submit_time.find(request_id);
+    if (it == _submit_time.end())
+      return;
+
+    const auto award_it = _award_time.find(task_id);
+    if (award_it != _award_time.end())
+    {
+      record(award_it->second - it->second);
+      _award_time.erase(award_it);
+    }
+    else
+    {
+      _task_submit_time[task_id] = it->second;
+    }
+
+    _submit_time.erase(it);
+  }
+
+  void awarded(const DispatchState& state)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (state.status == DispatchState::Status::FailedToAssign)
+      ++_failed;
+
+    const auto now = Clock::now();
+    const auto it = _task_submit_time.find(state.task_id);
+    if (it == _task_submit_time.end())
+    {
+      // The API response has not arrived yet
+      _award_time[state.task_id] = now;
+      return;
+    }
+
+    record(now - it->second);
+    _task_submit_time.erase(it);
+  }
+
+  void report(
+    const rclcpp::Logger& logger,
+    const double elapsed,
+    const std::size_t submitted,
+    const std::size_t dispatcher_memory)
+  {
+    std::vector<double> latencies;
+    std::size_t failed = 0;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      latencies = _latencies;
+      failed = _failed;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    RCLCPP_INFO(
+      logger,
+      "[%.1fs] submitted: %lu | awarded: %lu (%lu failed) | throughput: "
+      "%.2f/s | latency p50: %.3fs p90: %.3fs p99: %.3fs max: %.3fs | "
+      "finished states: %lu B | resident: %lu kB",
+      elapsed,
+      submitted,
+      latencies.size(),
+      failed,
+      elapsed > 0.0 ? latencies.size() / elapsed : 0.0,
+      percentile(latencies, 0.5),
+      percentile(latencies, 0.9),
+      percentile(latencies, 0.99),
+      latencies.empty() ? 0.0 : latencies.back(),
+      dispatcher_memory,
+      resident_memory() / 1024);
+  }
+
+private:
+
+  void record(const Clock::duration latency)
+  {
+    _latencies.push_back(rmf_traffic::time::to_seconds(latency));
+  }
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, Clock::time_point> _submit_time;
+  std::unordered_map<std::string, Clock::time_point> _task_submit_time;
+  std::unordered_map<std::string, Clock::time_point> _award_time;
+  std::vector<double> _latencies;
+  std::size_t _failed = 0;
+};
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  using ApiRequestMsg = rmf_task_msgs::msg::ApiRequest;
+  using ApiResponseMsg = rmf_task_msgs::msg::ApiResponse;
+
+  rclcpp::init(argc, argv);
+  const auto node = std::make_shared<rclcpp::Node>("rmf_dispatcher_benchmark");
+
+  const int bidders = node->declare_parameter<int>("bidders", 5);
+  const double submission_rate =
+    node->declare_parameter<double>("submission_rate", 10.0);
+  const double duration = node->declare_parameter<double>("duration", 30.0);
+  const double min_delay =
+    node->declare_parameter<double>("min_response_delay", 0.05);
+  const double max_delay =
+    node->declare_parameter<double>("max_response_delay", 0.5);
+
+  RCLCPP_INFO(
+    node->get_logger(),
+    "Benchmarking the dispatcher with %d bidders, %f tasks per second for %f "
+    "seconds, and response delays between %f and %f seconds",
+    bidders, submission_rate, duration, min_delay, max_delay);
+
+  const auto dispatcher = Dispatcher::make_node("rmf_dispatcher_node");
+
+  Tracker tracker;
+  dispatcher->on_change(
+    [&tracker](const DispatchState& state)
+    {
+      if (state.status == DispatchState::Status::Selected
+      || state.status == DispatchState::Status::FailedToAssign)
+      {
+        tracker.awarded(state);
+      }
+    });
+
+  std::vector<std::unique_ptr<MockFleet>> fleets;
+  for (int i = 0; i < bidders; ++i)
+  {
+    fleets.push_back(
+      std::make_unique<MockFleet>(
+        rclcpp::NodeOptions(),
+        "benchmark_fleet_" + std::to_string(i),
+        min_delay,
+        max_delay,
+        static_cast<unsigned int>(i)));
+  }
+
+  const auto api_request_pub = node->create_publisher<ApiRequestMsg>(
+    "task_api_requests",
+    rclcpp::SystemDefaultsQoS().reliable().transient_local());
+
+  const auto api_response_sub = node->create_subscription<ApiResponseMsg>(
+    "task_api_responses",
+    rclcpp::SystemDefaultsQoS().reliable().transient_local().keep_last(1000),
+    [&tracker](const ApiResponseMsg::UniquePtr msg)
+    {
+      try
+      {
+        const auto response = nlohmann::json::parse(msg->json_msg);
+        const auto& task_id = response.at("state").at("booking").at("id");
+        tracker.responded(msg->request_id, task_id.get<std::string>());
+      }
+      catch (const std::exception&)
+      {
+        // This is not a response to one of our dispatch requests
+      }
+    });
+
+  const auto start = Clock::now();
+  std::size_t submitted = 0;
+  const auto submit_timer = node->create_wall_timer(
+    std::chrono::milliseconds(10),
+    [&]()
+    {
+      const double elapsed =
+        rmf_traffic::time::to_seconds(Clock::now() - start);
+      if (elapsed > duration)
+        return;
+
+      const auto due = static_cast<std::size_t>(elapsed * submission_rate);
+      for (; submitted < due; ++submitted)
+      {
+        nlohmann::json request;
+        request["category"] = "patrol";
+        request["description"]["places"] = {"benchmark_waypoint"};
+        request["description"]["rounds"] = 1;
+
+        nlohmann::json msg;
+        msg["type"] = "dispatch_task_request";
+        msg["request"] = std::move(request);
+
+        const auto request_id = "benchmark_" + std::to_string(submitted);
+        tracker.submitted(request_id);
+        api_request_pub->publish(
+          rmf_task_msgs::build<ApiRequestMsg>()
+          .json_msg(msg.dump())
+          .request_id(request_id));
+      }
+    });
+
+  // Keep running after the last submission so the remaining bids can finish
+  const auto finish = start + rmf_traffic::time::from_seconds(duration + 10.0);
+  const auto report_timer = node->create_wall_timer(
+    std::chrono::seconds(1),
+    [&]()
+    {
+      const auto now = Clock::now();
+      if (finish < now)
+        RCLCPP_INFO(node->get_logger(), "Final results:");
+
+      tracker.report(
+        node->get_logger(),
+        rmf_traffic::time::to_seconds(now - start),
+        submitted,
+        dispatcher->finished_dispatches_memory());
+
+      if (finish < now)
+        rclcpp::shutdown();
+    });
+
+  std::thread dispatcher_thread([dispatcher]() { dispatcher->spin(); });
+
+  rclcpp::executors::MultiThreadedExecutor executor;
+  executor.add_node(node);
+  for (const auto& fleet : fleets)
+    executor.add_node(fleet->node());
+
+  executor.spin();
+  dispatcher_thread.join();
+}
@@ -0,0 +1,542 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_DispatchJournal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rmf_task_ros2 {
+
+namespace {
+//==============================================================================
+// The journal is only ever read back by the same machine that wrote it, so
+// integers are stored in native byte order.
+enum class RecordType : uint8_t
+{
+  State = 0,
+  Evicted = 1,
+  Command = 2,
+  CommandDone = 3
+};
+
+//==============================================================================
+std::string snapshot_path(const std::string& file_path)
+{
+  return file_path + ".snapshot";
+}
+
+//==============================================================================
+void append_u64(std::string& buffer, const uint64_t value)
+{
+  char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  buffer.append(bytes, sizeof(value));
+}
+
+//==============================================================================
+void append_block(std::string& buffer, const std::string& block)
+{
+  append_u64(buffer, block.size());
+  buffer.append(block);
+}
+
+//==============================================================================
+class Reader
+{
+public:
+
+  Reader(const std::string& data)
+  : _data(data)
+  {
+    // Do nothing
+  }
+
+  bool done() const
+  {
+    return _offset >= _data.size();
+  }
+
+  bool read_u8(uint8_t& output)
+  {
+    if (_data.size() - _offset < 1)
+      return false;
+
+    output = static_cast<uint8_t>(_data[_offset]);
+    ++_offset;
+    return true;
+  }
+
+  bool read_u64(uint64_t& output)
+  {
+    if (_data.size() - _offset < sizeof(output))
+      return false;
+
+    std::memcpy(&output, _data.data() + _offset, sizeof(output));
+    _offset += sizeof(output);
+    return true;
+  }
+
+  bool read_block(std::string& output)
+  {
+    uint64_t size = 0;
+    if (!read_u64(size) || _data.size() - _offset < size)
+      return false;
+
+    output = _data.substr(_offset, size);
+    _offset += size;
+    return true;
+  }
+
+private:
+  const std::string& _data;
+  std::size_t _offset = 0;
+};
+
+//==============================================================================
+// Submission times come from the steady clock, which starts over when the
+// machine reboots, so they are stored as wall clock times.
+uint64_t to_wall_nanos(const rmf_traffic::Time time)
+{
+  const auto age = std::chrono::steady_clock::now() - time;
+  const auto wall = std::chrono::system_clock::now() -
+    std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      wall.time_since_epoch()).count());
+}
+
+//==============================================================================
+rmf_traffic::Time from_wall_nanos(const uint64_t nanos)
+{
+  const auto wall = std::chrono::system_clock::time_point(
+    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+      std::chrono::nanoseconds(static_cast<int64_t>(nanos))));
+  const auto age = std::chrono::system_clock::now() - wall;
+  return std::chrono::steady_clock::now() -
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+}
+
+//==============================================================================
+std::string encode_state(
+  const DispatchState& state,
+  const std::vector<std::string>& labels,
+  const bool finished,
+  const uint64_t task_counter)
+{
+  std::string payload;
+  append_block(payload, state.task_id);
+  append_u64(payload, to_wall_nanos(state.submission_time));
+  payload.push_back(static_cast<char>(state.status));
+  payload.push_back(static_cast<char>(finished));
+  payload.push_back(static_cast<char>(state.assignment.has_value()));
+  append_block(payload, state.assignment ? state.assignment->fleet_name : "");
+  append_block(
+    payload, state.assignment ? state.assignment->expected_robot_name : "");
+
+  append_u64(payload, state.errors.size());
+  for (const auto& error : state.errors)
+    append_block(payload, error.dump());
+
+  append_u64(payload, labels.size());
+  for (const auto& label : labels)
+    append_block(payload, label);
+
+  append_u64(payload, state.retransmissions);
+  append_u64(payload, task_counter);
+  return payload;
+}
+
+//==============================================================================
+std::string encode_command(const rmf_task_msgs::msg::DispatchCommand& command)
+{
+  std::string payload;
+  append_block(payload, command.fleet_name);
+  append_block(payload, command.task_id);
+  append_u64(payload, command.dispatch_id);
+  append_u64(payload, static_cast<uint64_t>(command.timestamp.sec));
+  append_u64(payload, command.timestamp.nanosec);
+  payload.push_back(static_cast<char>(command.type));
+  return payload;
+}
+
+//==============================================================================
+bool apply_record(
+  const RecordType type,
+  const std::string& payload,
+  DispatchRecovery& recovery)
+{
+  Reader reader(payload);
+  switch (type)
+  {
+    case RecordType::State:
+    {
+      std::string task_id;
+      uint64_t submission = 0;
+      uint8_t status = 0;
+      uint8_t finished = 0;
+      uint8_t assigned = 0;
+      std::string fleet_name;
+      std::string robot_name;
+      uint64_t num_errors = 0;
+      if (!reader.read_block(task_id)
+        || !reader.read_u64(submission)
+        || !reader.read_u8(status)
+        || !reader.read_u8(finished)
+        || !reader.read_u8(assigned)
+        || !reader.read_block(fleet_name)
+        || !reader.read_block(robot_name)
+        || !reader.read_u64(num_errors))
+        return false;
+
+      DispatchRecovery::Task task{
+        DispatchState(task_id, from_wall_nanos(submission)),
+        {},
+        finished != 0
+      };
+      task.state.status = static_cast<DispatchState::Status>(status);
+      if (assigned)
+      {
+        task.state.assignment =
+          DispatchState::Assignment{fleet_name, robot_name};
+      }
+
+      for (uint64_t i = 0; i < num_errors; ++i)
+      {
+        std::string error;
+        if (!reader.read_block(error))
+          return false;
+
+        task.state.errors.push_back(nlohmann::json::parse(error));
+      }
+
+      uint64_t num_labels = 0;
+      if (!reader.read_u64(num_labels))
+        return false;
+
+      for (uint64_t i = 0; i < num_labels; ++i)
+      {
+        std::string label;
+        if (!reader.read_block(label))
+          return false;
+
+        task.labels.push_back(std::move(label));
+      }
+
+      uint64_t retransmissions = 0;
+      uint64_t task_counter = 0;
+      if (!reader.read_u64(retransmissions) || !reader.read_u64(task_counter))
+        return false;
+
+      task.state.retransmissions = retransmissions;
+      recovery.task_counter = std::max(recovery.task_counter, task_counter);
+      recovery.tasks.insert_or_assign(task_id, std::move(task));
+      return true;
+    }
+    case RecordType::Evicted:
+    {
+      std::string task_id;
+      if (!reader.read_block(task_id))
+        return false;
+
+      recovery.tasks.erase(task_id);
+      return true;
+    }
+    case RecordType::Command:
+    {
+      rmf_task_msgs::msg::DispatchCommand command;
+      uint64_t sec = 0;
+      uint64_t nanosec = 0;
+      uint8_t command_type = 0;
+      if (!reader.read_block(command.fleet_name)
+        || !reader.read_block(command.task_id)
+        || !reader.read_u64(command.dispatch_id)
+        || !reader.read_u64(sec)
+        || !reader.read_u64(nanosec)
+        || !reader.read_u8(command_type))
+        return false;
+
+      command.timestamp.sec = static_cast<int32_t>(sec);
+      command.timestamp.nanosec = static_cast<uint32_t>(nanosec);
+      command.type = command_type;
+      recovery.next_dispatch_command_id = std::max(
+        recovery.next_dispatch_command_id, command.dispatch_id + 1);
+      recovery.commands.insert_or_assign(command.dispatch_id, command);
+      return true;
+    }
+    case RecordType::CommandDone:
+    {
+      uint64_t dispatch_id = 0;
+      if (!reader.read_u64(dispatch_id))
+        return false;
+
+      recovery.next_dispatch_command_id = std::max(
+        recovery.next_dispatch_command_id, dispatch_id + 1);
+      recovery.commands.erase(dispatch_id);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//==============================================================================
+std::optional<std::string> read_file(const std::string& file_path)
+{
+  if (!std::filesystem::exists(file_path))
+    return std::nullopt;
+
+  std::ifstream file(file_path, std::ios::in | std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error(
+      "[DispatchJournal] Unable to open [" + file_path + "] for reading");
+  }
+
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+//==============================================================================
+void replay(const std::string& file_path, DispatchRecovery& recovery)
+{
+  const auto data = read_file(file_path);
+  if (!data.has_value())
+    return;
+
+  Reader reader(*data);
+  while (!reader.done())
+  {
+    uint8_t type = 0;
+    std::string payload;
+    if (!reader.read_u8(type) || !reader.read_block(payload))
+    {
+      // The final record was torn by an interrupted write
+      break;
+    }
+
+    bool applied = false;
+    try
+    {
+      applied = apply_record(static_cast<RecordType>(type), payload, recovery);
+    }
+    catch (const std::exception&)
+    {
+      applied = false;
+    }
+
+    if (!applied)
+    {
+      throw std::runtime_error(
+        "[DispatchJournal] [" + file_path + "] has a malformed record");
+    }
+  }
+}
+
+//==============================================================================
+void append_record(
+  std::string& buffer,
+  const RecordType type,
+  const std::string& payload)
+{
+  buffer.push_back(static_cast<char>(type));
+  append_block(buffer, payload);
+}
+
+//==============================================================================
+void sync_file(const std::string& file_path)
+{
+  const int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  ::fsync(fd);
+  ::close(fd);
+}
+} // anonymous namespace
+
+//==============================================================================
+DispatchJournal::DispatchJournal(std::string file_path)
+: _file_path(std::move(file_path))
+{
+  const auto parent = std::filesystem::absolute(_file_path).parent_path();
+  if (!std::filesystem::exists(parent))
+    std::filesystem::create_directories(parent);
+
+  _open();
+}
+
+//==============================================================================
+DispatchRecovery DispatchJournal::load(const std::string& file_path)
+{
+  DispatchRecovery recovery;
+  replay(snapshot_path(file_path), recovery);
+  replay(file_path, recovery);
+  return recovery;
+}
+
+//==============================================================================
+void DispatchJournal::record_state(
+  const DispatchState& state,
+  const std::vector<std::string>& labels,
+  const bool finished,
+  const uint64_t task_counter)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::State),
+    encode_state(state, labels, finished, task_counter));
+}
+
+//==============================================================================
+void DispatchJournal::record_evicted(const TaskID& task_id)
+{
+  std::string payload;
+  append_block(payload, task_id);
+  _append(static_cast<uint8_t>(RecordType::Evicted), payload);
+}
+
+//==============================================================================
+void DispatchJournal::record_command(const DispatchCommandMsg& command)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Command), encode_command(command));
+}
+
+//==============================================================================
+void DispatchJournal::record_command_done(const uint64_t dispatch_id)
+{
+  std::string payload;
+  append_u64(payload, dispatch_id);
+  _append(static_cast<uint8_t>(RecordType::CommandDone), payload);
+}
+
+//==============================================================================
+std::size_t DispatchJournal::records() const
+{
+  return _records;
+}
+
+//==============================================================================
+void DispatchJournal::snapshot(const DispatchRecovery& everything)
+{
+  std::string data;
+  for (const auto& [id, task] : everything.tasks)
+  {
+    append_record(
+      data, RecordType::State,
+      encode_state(
+        task.state, task.labels, task.finished, everything.task_counter));
+  }
+
+  // Remember the next command ID even if there are no lingering commands.
+  // This comes before the commands so that it cannot erase one of them.
+  if (everything.next_dispatch_command_id > 0)
+  {
+    std::string payload;
+    append_u64(payload, everything.next_dispatch_command_id - 1);
+    append_record(data, RecordType::CommandDone, payload);
+  }
+
+  for (const auto& [id, command] : everything.commands)
+    append_record(data, RecordType::Command, encode_command(command));
+
+  const auto path = snapshot_path(_file_path);
+  const auto temp_path = path + ".tmp";
+  {
+    std::ofstream file(
+      temp_path, std::ios::out | std::ios::trunc | std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file)
+    {
+      throw std::runtime_error(
+        "[DispatchJournal] Failed to write [" + temp_path + "]");
+    }
+  }
+
+  sync_file(temp_path);
+  std::filesystem::rename(temp_path, path);
+
+  // Every record in the journal is now part of the snapshot. If we crash
+  // before this, replaying them again does no harm.
+  ::close(_fd);
+  _fd = -1;
+  std::filesystem::remove(_file_path);
+  _open();
+  _records = 0;
+}
+
+//==============================================================================
+DispatchJournal::~DispatchJournal()
+{
+  if (_fd >= 0)
+    ::close(_fd);
+}
+
+//==============================================================================
+void DispatchJournal::_open()
+{
+  _fd = ::open(_file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (_fd < 0)
+  {
+    throw std::runtime_error(
+      "[DispatchJournal] Unable to open [" + _file_path + "]: "
+      + std::strerror(errno));
+  }
+}
+
+//==============================================================================
+void DispatchJournal::_append(const uint8_t type, const std::string& payload)
+{
+  std::string record;
+  append_record(record, static_cast<RecordType>(type), payload);
+
+  // A single write keeps each record whole unless the process dies partway
+  // through, which replay tolerates for the final record.
+  const char* data = record.data();
+  std::size_t remaining = record.size();
+  while (remaining > 0)
+  {
+    const auto written = ::write(_fd, data, remaining);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      throw std::runtime_error(
+        "[DispatchJournal] Failed to append to [" + _file_path + "]: "
+        + std::strerror(errno));
+    }
+
+    data += written;
+    remaining -= static_cast<std::size_t>(written);
+  }
+
+  ++_records;
+}
+
+} // namespace rmf_task_ros2
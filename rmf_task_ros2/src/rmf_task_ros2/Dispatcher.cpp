@@ -19,7 +19,7 @@
 #include <rmf_task_ros2/StandardNames.hpp>
 
 #include <rclcpp/node.hpp>
-#include <rclcpp/executors/single_threaded_executor.hpp>
+#include <rclcpp/executors/multi_threaded_executor.hpp>
 
 #include <rmf_task_msgs/msg/task_description.hpp>
 #include <rmf_task_msgs/msg/task_profile.hpp>
@@ -35,6 +35,8 @@
 
 #include <rmf_traffic_ros2/Time.hpp>
 
+#include "internal_DispatchJournal.hpp"
+
 #include <nlohmann/json.hpp>
 #include <nlohmann/json-schema.hpp>
 
@@ -44,6 +46,10 @@
 #include <rmf_api_msgs/schemas/task_state.hpp>
 #include <rmf_api_msgs/schemas/error.hpp>
 
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <unordered_set>
 
 namespace rmf_task_ros2 {
@@ -88,6 +94,93 @@ nlohmann::json_schema::json_validator make_validator(nlohmann::json schema)
   return nlohmann::json_schema::json_validator(
     std::move(schema), schema_loader);
 }
+
+//==============================================================================
+/// Finds the top-level "type" field of a JSON message without building the
+/// rest of it. Parsing stops as soon as the type has been found.
+class FindRequestType
+{
+public:
+
+  using json = nlohmann::json;
+
+  std::optional<std::string> type;
+  std::optional<std::string> error;
+
+  bool null() { return value(); }
+  bool boolean(bool) { return value(); }
+  bool number_integer(json::number_integer_t) { return value(); }
+  bool number_unsigned(json::number_unsigned_t) { return value(); }
+  bool number_float(json::number_float_t, const json::string_t&)
+  {
+    return value();
+  }
+  bool binary(json::binary_t&) { return value(); }
+
+  bool string(json::string_t& val)
+  {
+    if (_type_is_next)
+    {
+      type = std::move(val);
+      return false;
+    }
+
+    return value();
+  }
+
+  bool start_object(std::size_t)
+  {
+    _type_is_next = false;
+    ++_depth;
+    return true;
+  }
+
+  bool key(json::string_t& val)
+  {
+    _type_is_next = _depth == 1 && val == "type";
+    return true;
+  }
+
+  bool end_object()
+  {
+    --_depth;
+    return true;
+  }
+
+  bool start_array(std::size_t)
+  {
+    _type_is_next = false;
+    ++_depth;
+    return true;
+  }
+
+  bool end_array()
+  {
+    --_depth;
+    return true;
+  }
+
+  bool parse_error(
+    std::size_t,
+    const std::string&,
+    const nlohmann::detail::exception& e)
+  {
+    error = e.what();
+    return false;
+  }
+
+private:
+
+  bool value()
+  {
+    // A type that is not a string means this is not a request that we know
+    _type_is_next = false;
+    return true;
+  }
+
+  std::size_t _depth = 0;
+  bool _type_is_next = false;
+};
 } // anonymous namespace
 
 //==============================================================================
@@ -98,6 +191,16 @@ public:
   std::shared_ptr<rclcpp::Node> node;
   std::shared_ptr<bidding::Auctioneer> auctioneer;
 
+  // The dispatcher's callbacks are split into groups so that a multi-threaded
+  // executor can keep answering API requests while a large batch of states is
+  // being broadcast. Every callback locks this mutex while it touches the
+  // dispatch states. It is recursive so that the on_change callback may call
+  // back into the Dispatcher.
+  mutable std::recursive_mutex mutex;
+  rclcpp::CallbackGroup::SharedPtr api_callback_group;
+  rclcpp::CallbackGroup::SharedPtr dispatch_callback_group;
+  rclcpp::CallbackGroup::SharedPtr broadcast_callback_group;
+
   using SubmitTaskSrv = rmf_task_msgs::srv::SubmitTask;
   using CancelTaskSrv = rmf_task_msgs::srv::CancelTask;
   using GetDispatchStatesSrv = rmf_task_msgs::srv::GetDispatchStates;
@@ -116,46 +219,144 @@ public:
   rclcpp::Subscription<ApiRequestMsg>::SharedPtr api_request;
   rclcpp::Publisher<ApiResponseMsg>::SharedPtr api_response;
 
+  /// Remembers the responses to recent API requests so that a request which
+  /// gets retried can be answered again without being processed twice. The
+  /// least recently used responses are dropped first, and responses are never
+  /// reused once they are older than the time to live.
   class ApiMemory
   {
   public:
 
-    std::optional<ApiResponseMsg> lookup(const std::string& api_id) const
+    using Clock = std::chrono::steady_clock;
+
+    std::optional<ApiResponseMsg> lookup(const std::string& api_id)
     {
       const auto it = _cached_responses.find(api_id);
       if (it == _cached_responses.end())
+      {
+        ++_statistics.misses;
         return std::nullopt;
+      }
+
+      if (it->second.added + _ttl < Clock::now())
+      {
+        erase(it);
+        ++_statistics.misses;
+        return std::nullopt;
+      }
 
-      return it->second;
+      // Move this response to the most recently used end of the tracker
+      _tracker.splice(_tracker.end(), _tracker, it->second.position);
+      ++_statistics.hits;
+      return it->second.msg;
     }
 
     void add(ApiResponseMsg msg)
     {
-      if (_tracker.size() > _max_size)
+      const auto existing = _cached_responses.find(msg.request_id);
+      if (existing != _cached_responses.end())
+        erase(existing);
+
+      const std::size_t memory = sizeof(Entry) + 2*msg.request_id.size()
+        + msg.json_msg.size() + sizeof(std::string) + 4*sizeof(void*);
+
+      while (!_tracker.empty()
+        && (_tracker.size() >= _max_size
+        || _statistics.memory + memory > _max_memory))
       {
-        _cached_responses.erase(_tracker.front());
-        _tracker.pop_front();
+        erase(_cached_responses.find(_tracker.front()));
       }
 
-      _tracker.push_back(msg.request_id);
-      _cached_responses[msg.request_id] = std::move(msg);
+      if (_max_size == 0 || memory > _max_memory)
+        return;
+
+      const auto position = _tracker.insert(_tracker.end(), msg.request_id);
+      auto key = msg.request_id;
+      _cached_responses.insert(
+        {
+          std::move(key),
+          Entry{std::move(msg), Clock::now(), memory, position}
+        });
+      _statistics.memory += memory;
+      _statistics.entries = _cached_responses.size();
+    }
+
+    void set_limits(
+      const std::size_t max_size,
+      const std::size_t max_memory,
+      const Clock::duration ttl)
+    {
+      _max_size = max_size;
+      _max_memory = max_memory;
+      _ttl = ttl;
+    }
+
+    const Dispatcher::ApiCacheStatistics& statistics() const
+    {
+      return _statistics;
     }
 
   private:
 
-    std::unordered_map<std::string, ApiResponseMsg> _cached_responses;
+    struct Entry
+    {
+      ApiResponseMsg msg;
+      Clock::time_point added;
+      std::size_t memory;
+      std::list<std::string>::iterator position;
+    };
+
+    using Cache = std::unordered_map<std::string, Entry>;
+
+    void erase(const Cache::iterator it)
+    {
+      _statistics.memory -= it->second.memory;
+      _tracker.erase(it->second.position);
+      _cached_responses.erase(it);
+      _statistics.entries = _cached_responses.size();
+    }
+
+    Cache _cached_responses;
+    // Request IDs from least recently used to most recently used
     std::list<std::string> _tracker;
     std::size_t _max_size = 50;
+    std::size_t _max_memory = 1 << 20;
+    Clock::duration _ttl = std::chrono::minutes(5);
+    Dispatcher::ApiCacheStatistics _statistics;
   };
 
   ApiMemory api_memory;
 
   using DispatchStatesPub = rclcpp::Publisher<DispatchStatesMsg>;
   DispatchStatesPub::SharedPtr dispatch_states_pub;
+  DispatchStatesPub::SharedPtr dispatch_state_changes_pub;
+  // Tasks whose dispatch state changed since the last publish
+  std::unordered_set<TaskID> changed_dispatch_states;
+
+  // The last message that each dispatch state was converted into. A state
+  // that is in changed_dispatch_states needs to be converted again.
+  std::unordered_map<TaskID, DispatchStateMsg> converted_dispatch_states;
+  bool publish_full_dispatch_states;
   rclcpp::TimerBase::SharedPtr dispatch_states_pub_timer;
 
   uint64_t next_dispatch_command_id = 0;
-  std::unordered_map<uint64_t, DispatchCommandMsg> lingering_commands;
+
+  // A dispatch command that has not been acknowledged yet. Each time it gets
+  // sent again, we wait twice as long before the next attempt, up to a limit.
+  struct LingeringCommand
+  {
+    DispatchCommandMsg command;
+    rclcpp::Time next_publish;
+    rclcpp::Duration interval;
+  };
+
+  std::unordered_map<uint64_t, LingeringCommand> lingering_commands;
+  // The last time that each fleet acknowledged any dispatch command
+  std::unordered_map<std::string, rclcpp::Time> fleet_last_heard;
+  rclcpp::Duration dispatch_command_max_interval =
+    rclcpp::Duration(std::chrono::seconds(8));
+  rclcpp::Duration dispatch_command_timeout =
+    rclcpp::Duration(std::chrono::seconds(10));
   rclcpp::TimerBase::SharedPtr dispatch_command_timer;
   rclcpp::Publisher<DispatchCommandMsg>::SharedPtr dispatch_command_pub;
 
@@ -165,11 +366,21 @@ public:
 
   DispatchStates active_dispatch_states;
   DispatchStates finished_dispatch_states;
+  // The finished dispatch states in order of submission time, so the oldest
+  // one can be evicted without searching for it
+  std::set<std::pair<rmf_traffic::Time, TaskID>> finished_dispatch_order;
+  // The labels of every task that we know about, for canceling by label
+  std::unordered_map<TaskID, std::vector<std::string>> dispatch_labels;
   std::size_t task_counter = 0; // index for generating task_id
   builtin_interfaces::msg::Duration bidding_time_window;
   std::size_t terminated_tasks_max_size;
   int publish_active_tasks_period;
 
+  // Records every change to the dispatch states and lingering commands so
+  // they can be restored after a restart. This is null when disabled.
+  std::unique_ptr<DispatchJournal> journal;
+  std::size_t journal_snapshot_records = 10000;
+
   std::unordered_map<std::size_t, std::string> legacy_task_type_names =
   {
     {1, "patrol"},
@@ -204,11 +415,50 @@ public:
     RCLCPP_INFO(node->get_logger(),
       " Declared publish_active_tasks_period as: %d secs",
       publish_active_tasks_period);
+    publish_full_dispatch_states =
+      node->declare_parameter<bool>("publish_full_dispatch_states", true);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared publish_full_dispatch_states as: %s",
+      publish_full_dispatch_states ? "true" : "false");
+
+    const int api_response_cache_size =
+      node->declare_parameter<int>("api_response_cache_size", 50);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared api_response_cache_size as: %d", api_response_cache_size);
+    const int api_response_cache_memory =
+      node->declare_parameter<int>("api_response_cache_memory", 1 << 20);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared api_response_cache_memory as: %d bytes",
+      api_response_cache_memory);
+    const double api_response_cache_ttl =
+      node->declare_parameter<double>("api_response_cache_ttl", 300.0);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared api_response_cache_ttl as: %f secs", api_response_cache_ttl);
+    api_memory.set_limits(
+      static_cast<std::size_t>(std::max(api_response_cache_size, 0)),
+      static_cast<std::size_t>(std::max(api_response_cache_memory, 0)),
+      rmf_traffic::time::from_seconds(api_response_cache_ttl));
+
+    api_callback_group = node->create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive);
+    dispatch_callback_group = node->create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive);
+    broadcast_callback_group = node->create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive);
+
+    rclcpp::SubscriptionOptions api_options;
+    api_options.callback_group = api_callback_group;
+    rclcpp::SubscriptionOptions dispatch_options;
+    dispatch_options.callback_group = dispatch_callback_group;
 
     const auto qos = rclcpp::ServicesQoS().reliable();
     dispatch_states_pub = node->create_publisher<DispatchStatesMsg>(
       rmf_task_ros2::DispatchStatesTopicName, qos);
 
+    dispatch_state_changes_pub = node->create_publisher<DispatchStatesMsg>(
+      rmf_task_ros2::DispatchStateChangesTopicName,
+      rclcpp::SystemDefaultsQoS().reliable().keep_last(100));
+
     // TODO(MXG): Sync up with rmf_fleet_adapter/StandardNames on these topic
     // names
     api_request = node->create_subscription<ApiRequestMsg>(
@@ -216,8 +466,10 @@ public:
       rclcpp::SystemDefaultsQoS().reliable().transient_local(),
       [this](const ApiRequestMsg::UniquePtr msg)
       {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
         this->handle_api_request(*msg);
-      });
+      },
+      api_options);
 
     api_response = node->create_publisher<ApiResponseMsg>(
       "task_api_responses",
@@ -227,24 +479,50 @@ public:
     // doesn't seem great.
     dispatch_states_pub_timer = node->create_wall_timer(
       std::chrono::seconds(publish_active_tasks_period),
-      [this]() { this->publish_dispatch_states(); });
+      [this]() { this->publish_dispatch_states(); },
+      broadcast_callback_group);
 
     dispatch_command_pub = node->create_publisher<DispatchCommandMsg>(
       rmf_task_ros2::DispatchCommandTopicName,
       rclcpp::ServicesQoS().keep_last(20).reliable().transient_local());
 
-    // TODO(MXG): Make this publishing period configurable
+    const double dispatch_command_max_interval_param =
+      node->declare_parameter<double>("dispatch_command_max_interval", 8.0);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared dispatch_command_max_interval as: %f secs",
+      dispatch_command_max_interval_param);
+    dispatch_command_max_interval = rclcpp::Duration(
+      rmf_traffic::time::from_seconds(
+        std::max(dispatch_command_max_interval_param, 1.0)));
+
+    const double dispatch_command_timeout_param =
+      node->declare_parameter<double>("dispatch_command_timeout", 10.0);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared dispatch_command_timeout as: %f secs",
+      dispatch_command_timeout_param);
+    dispatch_command_timeout = rclcpp::Duration(
+      rmf_traffic::time::from_seconds(dispatch_command_timeout_param));
+
+    // Each lingering command keeps track of when it is next due, so this only
+    // sets the shortest possible interval between resending a command.
     dispatch_command_timer = node->create_wall_timer(
       std::chrono::seconds(1),
-      [this]() { this->publish_lingering_commands(); });
+      [this]()
+      {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
+        this->publish_lingering_commands();
+      },
+      dispatch_callback_group);
 
     dispatch_ack_sub = node->create_subscription<DispatchAckMsg>(
       rmf_task_ros2::DispatchAckTopicName,
       rclcpp::ServicesQoS().keep_last(20).transient_local(),
       [this](const DispatchAckMsg::UniquePtr msg)
       {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
         this->handle_dispatch_ack(*msg);
-      });
+      },
+      dispatch_options);
 
     auctioneer = bidding::Auctioneer::make(
       node,
@@ -253,10 +531,18 @@ public:
         const std::optional<bidding::Response::Proposal> winner,
         const std::vector<std::string>& errors)
       {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
         this->conclude_bid(task_id, std::move(winner), errors);
       },
       std::make_shared<bidding::LeastFleetDiffCostEvaluator>());
 
+    const int concurrent_bid_limit =
+      node->declare_parameter<int>("concurrent_bid_limit", 1);
+    RCLCPP_INFO(node->get_logger(),
+      " Declared concurrent_bid_limit as: %d", concurrent_bid_limit);
+    auctioneer->set_concurrent_bid_limit(
+      static_cast<std::size_t>(std::max(concurrent_bid_limit, 1)));
+
     // Setup up stream srv interfaces
     submit_task_srv = node->create_service<SubmitTaskSrv>(
       rmf_task_ros2::SubmitTaskSrvName,
@@ -264,6 +550,7 @@ public:
         const std::shared_ptr<SubmitTaskSrv::Request> request,
         std::shared_ptr<SubmitTaskSrv::Response> response)
       {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
         const auto id = this->submit_task(request->description);
         if (id == std::nullopt)
         {
@@ -274,8 +561,9 @@ public:
 
         response->task_id = *id;
         response->success = true;
-      }
-    );
+      },
+      rmw_qos_profile_services_default,
+      api_callback_group);
 
     cancel_task_srv = node->create_service<CancelTaskSrv>(
       rmf_task_ros2::CancelTaskSrvName,
@@ -283,10 +571,12 @@ public:
         const std::shared_ptr<CancelTaskSrv::Request> request,
         std::shared_ptr<CancelTaskSrv::Response> response)
       {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
         auto id = request->task_id;
         response->success = this->cancel_task(id);
-      }
-    );
+      },
+      rmw_qos_profile_services_default,
+      api_callback_group);
 
     get_dispatch_states_srv = node->create_service<GetDispatchStatesSrv>(
       rmf_task_ros2::GetDispatchStatesSrvName,
@@ -294,20 +584,20 @@ public:
         const std::shared_ptr<GetDispatchStatesSrv::Request> request,
         std::shared_ptr<GetDispatchStatesSrv::Response> response)
       {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
         std::unordered_set<std::string> relevant_tasks;
         relevant_tasks.insert(
           request->task_ids.begin(),
           request->task_ids.end());
 
         /* *INDENT-OFF* */
-        const auto fill_states = [&relevant_tasks](auto& into, const auto& from)
+        const auto fill_states =
+          [this, &relevant_tasks](auto& into, const auto& from)
           {
             for (const auto& [id, state] : from)
             {
-              if (relevant_tasks.empty())
-                into.push_back(convert(*state));
-              else if (relevant_tasks.count(id))
-                into.push_back(convert(*state));
+              if (relevant_tasks.empty() || relevant_tasks.count(id))
+                into.push_back(this->converted(id, *state));
             }
           };
         /* *INDENT-ON* */
@@ -388,6 +678,194 @@ public:
 
         return description;
       };
+
+    const auto journal_path =
+      node->declare_parameter<std::string>("dispatch_journal_path", "");
+    const int journal_snapshot_records_param =
+      node->declare_parameter<int>("dispatch_journal_snapshot_records", 10000);
+    journal_snapshot_records =
+      static_cast<std::size_t>(std::max(journal_snapshot_records_param, 1));
+    if (!journal_path.empty())
+    {
+      RCLCPP_INFO(node->get_logger(),
+        " Declared dispatch_journal_path as: %s", journal_path.c_str());
+      restore(journal_path);
+    }
+  }
+
+  /// Pick up the dispatch states and lingering commands that were journaled
+  /// by an earlier run of the dispatcher, and then keep journaling them
+  void restore(const std::string& journal_path)
+  {
+    DispatchRecovery recovery;
+    try
+    {
+      recovery = DispatchJournal::load(journal_path);
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Unable to restore the dispatcher from [%s]: %s. The dispatcher will "
+        "start without its previous state.",
+        journal_path.c_str(), e.what());
+      recovery = DispatchRecovery();
+    }
+
+    task_counter = std::max<std::size_t>(task_counter, recovery.task_counter);
+    next_dispatch_command_id = std::max(
+      next_dispatch_command_id, recovery.next_dispatch_command_id);
+
+    std::vector<TaskID> interrupted;
+    for (auto& [task_id, task] : recovery.tasks)
+    {
+      auto state = std::make_shared<DispatchState>(std::move(task.state));
+      if (!task.labels.empty())
+        dispatch_labels[task_id] = std::move(task.labels);
+
+      // Like move_to_finished, this leaves finished states among the active
+      // ones as well.
+      changed_dispatch_states.insert(task_id);
+      active_dispatch_states[task_id] = state;
+      if (task.finished)
+      {
+        finished_dispatch_states[task_id] = state;
+        finished_dispatch_order.insert({state->submission_time, task_id});
+        continue;
+      }
+
+      if (state->status == DispatchState::Status::Queued)
+        interrupted.push_back(task_id);
+    }
+
+    // The bid notices of auctions that were in progress are not kept, so
+    // those tasks cannot be auctioned again.
+    for (const auto& task_id : interrupted)
+    {
+      const auto& state = active_dispatch_states.at(task_id);
+      state->status = DispatchState::Status::FailedToAssign;
+      nlohmann::json error;
+      error["code"] = 11;
+      error["category"] = "interrupted";
+      error["detail"] =
+        "The dispatcher restarted while task [" + task_id + "] was being "
+        "auctioned";
+
+      state->errors.push_back(std::move(error));
+      move_to_finished(task_id);
+    }
+
+    const auto now = node->get_clock()->now();
+    const auto interval = rclcpp::Duration(std::chrono::seconds(1));
+    for (auto& [id, command] : recovery.commands)
+    {
+      // Give the fleet adapters a full timeout to respond again
+      command.timestamp = now;
+      lingering_commands.insert_or_assign(
+        id, LingeringCommand{std::move(command), now, interval});
+    }
+
+    RCLCPP_INFO(
+      node->get_logger(),
+      "Restored %lu active and %lu finished dispatch states and %lu lingering "
+      "dispatch commands from [%s]",
+      active_dispatch_states.size(),
+      finished_dispatch_states.size(),
+      lingering_commands.size(),
+      journal_path.c_str());
+
+    journal = std::make_unique<DispatchJournal>(journal_path);
+    snapshot_journal();
+  }
+
+  /// Compact everything that has been journaled into a new snapshot
+  void snapshot_journal()
+  {
+    DispatchRecovery everything;
+    everything.task_counter = task_counter;
+    everything.next_dispatch_command_id = next_dispatch_command_id;
+
+    const auto add_tasks = [&](const DispatchStates& states, bool finished)
+      {
+        for (const auto& [task_id, state] : states)
+        {
+          const auto labels_it = dispatch_labels.find(task_id);
+          everything.tasks.insert_or_assign(
+            task_id,
+            DispatchRecovery::Task{
+              *state,
+              labels_it == dispatch_labels.end() ?
+              std::vector<std::string>() : labels_it->second,
+              finished
+            });
+        }
+      };
+
+    add_tasks(active_dispatch_states, false);
+    add_tasks(finished_dispatch_states, true);
+
+    for (const auto& [id, lingering] : lingering_commands)
+      everything.commands.insert({id, lingering.command});
+
+    try
+    {
+      journal->snapshot(everything);
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Failed to write a snapshot of the dispatch journal: %s", e.what());
+    }
+  }
+
+  /// Journal the latest state of a task, if journaling is enabled
+  void journal_state(const TaskID& task_id)
+  {
+    if (!journal)
+      return;
+
+    const auto state = find_dispatch_state(task_id);
+    if (!state)
+      return;
+
+    const bool finished = finished_dispatch_states.count(task_id) > 0;
+    const auto labels_it = dispatch_labels.find(task_id);
+    journal_write(
+      [&]()
+      {
+        journal->record_state(
+          *state,
+          labels_it == dispatch_labels.end() ?
+          std::vector<std::string>() : labels_it->second,
+          finished,
+          task_counter);
+      });
+  }
+
+  /// Write to the journal, taking a snapshot once it has grown long enough.
+  /// Failing to journal must not stop the dispatcher, so errors are only
+  /// logged.
+  template<typename F>
+  void journal_write(const F& write)
+  {
+    if (!journal)
+      return;
+
+    try
+    {
+      write();
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Failed to write to the dispatch journal: %s", e.what());
+      return;
+    }
+
+    if (journal->records() >= journal_snapshot_records)
+      snapshot_journal();
   }
 
   void handle_api_request(const ApiRequestMsg& msg)
@@ -399,36 +877,56 @@ public:
       return;
     }
 
-    nlohmann::json msg_json;
-    try
-    {
-      msg_json = nlohmann::json::parse(msg.json_msg);
-    }
-    catch (const std::exception& e)
+    // Most requests on this topic are meant for the fleet adapters, so only
+    // the type is read before deciding whether the whole message needs to be
+    // parsed.
+    FindRequestType find_type;
+    nlohmann::json::sax_parse(msg.json_msg, &find_type);
+    if (find_type.error.has_value())
     {
       RCLCPP_ERROR(
         node->get_logger(),
         "Error parsing json_msg: %s",
-        e.what());
+        find_type.error->c_str());
       return;
     }
 
-    const auto type_it = msg_json.find("type");
-    if (type_it == msg_json.end())
+    if (!find_type.type.has_value())
     {
       // Whatever type of message this is, we don't support it
       return;
     }
 
-    if (!type_it.value().is_string())
+    const auto& type_str = *find_type.type;
+    if (type_str != "dispatch_task_request"
+      && type_str != "dispatch_tasks_request"
+      && type_str != "cancel_tasks_request")
     {
-      // We expect the type field to contain a string
       return;
     }
 
+    nlohmann::json msg_json;
     try
     {
-      const auto& type_str = type_it.value().get<std::string>();
+      msg_json = nlohmann::json::parse(msg.json_msg);
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Error parsing json_msg: %s",
+        e.what());
+      return;
+    }
+
+    try
+    {
+      if (type_str == "dispatch_tasks_request")
+        return handle_batch_dispatch_request(msg_json, msg.request_id);
+
+      if (type_str == "cancel_tasks_request")
+        return handle_bulk_cancel_request(msg_json, msg.request_id);
+
       if (type_str != "dispatch_task_request")
       {
         return;
@@ -463,28 +961,13 @@ public:
         return;
       }
 
-      const auto& task_request_json = msg_json["request"];
-      const std::string task_id =
-        task_request_json["category"].get<std::string>()
-        + ".dispatch-" + std::to_string(task_counter++);
-
-      const auto task_state = push_bid_notice(
-        rmf_task_msgs::build<bidding::BidNoticeMsg>()
-        .request(task_request_json.dump())
-        .task_id(task_id)
-        .time_window(bidding_time_window));
+      const auto task_state = dispatch_task(msg_json["request"]);
 
       nlohmann::json response_json;
       response_json["success"] = true;
       response_json["state"] = task_state;
 
-      auto response = rmf_task_msgs::build<ApiResponseMsg>()
-        .type(ApiResponseMsg::TYPE_RESPONDING)
-        .json_msg(response_json.dump())
-        .request_id(msg.request_id);
-
-      api_memory.add(response);
-      api_response->publish(response);
+      respond(msg.request_id, response_json);
 
       // TODO(MXG): Make some way to keep pushing task state updates to the
       // api-server as the bidding process progresses. We could do a websocket
@@ -498,6 +981,178 @@ public:
     }
   }
 
+  void respond(const std::string& request_id, const nlohmann::json& json)
+  {
+    auto response = rmf_task_msgs::build<ApiResponseMsg>()
+      .type(ApiResponseMsg::TYPE_RESPONDING)
+      .json_msg(json.dump())
+      .request_id(request_id);
+
+    api_memory.add(response);
+    api_response->publish(response);
+  }
+
+  static nlohmann::json make_error_response(
+    uint64_t code,
+    std::string category,
+    std::string detail)
+  {
+    nlohmann::json error;
+    error["code"] = code;
+    error["category"] = std::move(category);
+    error["detail"] = std::move(detail);
+
+    nlohmann::json response_json;
+    response_json["success"] = false;
+    response_json["errors"] = std::vector<nlohmann::json>({std::move(error)});
+    return response_json;
+  }
+
+  /// Give a new task request an ID and add it to the bidding queue. Returns
+  /// the initial state of the task.
+  nlohmann::json dispatch_task(const nlohmann::json& task_request_json)
+  {
+    const std::string task_id =
+      task_request_json["category"].get<std::string>()
+      + ".dispatch-" + std::to_string(task_counter++);
+
+    return push_bid_notice(
+      rmf_task_msgs::build<bidding::BidNoticeMsg>()
+      .request(task_request_json.dump())
+      .task_id(task_id)
+      .time_window(bidding_time_window));
+  }
+
+  /// A dispatch_tasks_request carries a "requests" array of task requests.
+  /// Each of them is validated and dispatched on its own, and the single
+  /// response holds a "responses" array with one dispatch_task_response for
+  /// each request, in the same order.
+  void handle_batch_dispatch_request(
+    const nlohmann::json& msg_json,
+    const std::string& request_id)
+  {
+    const auto requests_it = msg_json.find("requests");
+    if (requests_it == msg_json.end() || !requests_it->is_array())
+    {
+      return respond(
+        request_id,
+        make_error_response(
+          5, "Invalid request format",
+          "A dispatch_tasks_request needs a [requests] array"));
+    }
+
+    static const auto task_request_validator =
+      make_validator(rmf_api_msgs::schemas::task_request);
+
+    std::vector<nlohmann::json> responses;
+    responses.reserve(requests_it->size());
+    for (const auto& task_request_json : *requests_it)
+    {
+      try
+      {
+        task_request_validator.validate(task_request_json);
+      }
+      catch (const std::exception& e)
+      {
+        responses.push_back(
+          make_error_response(5, "Invalid request format", e.what()));
+        continue;
+      }
+
+      nlohmann::json response_json;
+      response_json["success"] = true;
+      response_json["state"] = dispatch_task(task_request_json);
+      responses.push_back(std::move(response_json));
+    }
+
+    RCLCPP_INFO(
+      node->get_logger(),
+      "Received a batch of %lu task requests",
+      responses.size());
+
+    nlohmann::json response_json;
+    response_json["success"] = true;
+    response_json["responses"] = std::move(responses);
+    respond(request_id, response_json);
+  }
+
+  /// A cancel_tasks_request carries a "labels" array. Every task that was
+  /// dispatched with any of those labels gets canceled, and the response
+  /// lists the IDs of those tasks in "task_ids".
+  void handle_bulk_cancel_request(
+    const nlohmann::json& msg_json,
+    const std::string& request_id)
+  {
+    std::unordered_set<std::string> labels;
+    const auto labels_it = msg_json.find("labels");
+    if (labels_it != msg_json.end() && labels_it->is_array())
+    {
+      for (const auto& label : *labels_it)
+      {
+        if (label.is_string())
+          labels.insert(label.get<std::string>());
+      }
+    }
+
+    if (labels.empty())
+    {
+      return respond(
+        request_id,
+        make_error_response(
+          5, "Invalid request format",
+          "A cancel_tasks_request needs a [labels] array of strings"));
+    }
+
+    std::vector<std::string> task_ids;
+    for (const auto& [task_id, task_labels] : dispatch_labels)
+    {
+      for (const auto& label : task_labels)
+      {
+        if (labels.count(label) > 0)
+        {
+          task_ids.push_back(task_id);
+          break;
+        }
+      }
+    }
+
+    std::vector<std::string> canceled;
+    for (const auto& task_id : task_ids)
+    {
+      if (cancel_task(task_id) || remove_dispatched_task(task_id))
+        canceled.push_back(task_id);
+    }
+
+    nlohmann::json response_json;
+    response_json["success"] = true;
+    response_json["task_ids"] = std::move(canceled);
+    respond(request_id, response_json);
+  }
+
+  /// Tell the fleet adapter that a task was dispatched to that it should
+  /// remove the task.
+  bool remove_dispatched_task(const TaskID& task_id)
+  {
+    const auto finished_it = finished_dispatch_states.find(task_id);
+    if (finished_it == finished_dispatch_states.end())
+      return false;
+
+    const auto& state = *finished_it->second;
+    if (state.status != DispatchState::Status::Dispatched
+      || !state.assignment.has_value())
+      return false;
+
+    auto cancel_command = rmf_task_msgs::build<DispatchCommandMsg>()
+      .fleet_name(state.assignment->fleet_name)
+      .task_id(task_id)
+      .dispatch_id(next_dispatch_command_id++)
+      .timestamp(node->get_clock()->now())
+      .type(DispatchCommandMsg::TYPE_REMOVE);
+
+    send_command(std::move(cancel_command));
+    return true;
+  }
+
   std::optional<TaskID> submit_task(const TaskDescription& submission)
   {
     const auto task_type_index = submission.task_type.type;
@@ -563,6 +1218,17 @@ public:
     state["category"] = request["category"];
     state["detail"] = request["description"];
 
+    const auto labels_it = request.find("labels");
+    if (labels_it != request.end() && labels_it->is_array())
+    {
+      auto& labels = dispatch_labels[bid_notice.task_id];
+      for (const auto& label : *labels_it)
+      {
+        if (label.is_string())
+          labels.push_back(label.get<std::string>());
+      }
+    }
+
     auto& dispatch = state["dispatch"];
     dispatch["status"] = "queued";
 
@@ -573,6 +1239,7 @@ public:
       bid_notice.task_id, std::chrono::steady_clock::now());
 
     active_dispatch_states[bid_notice.task_id] = new_dispatch_state;
+    changed_dispatch_states.insert(bid_notice.task_id);
 
     if (on_change_fn)
       on_change_fn(*new_dispatch_state);
@@ -661,8 +1328,7 @@ public:
           .timestamp(node->get_clock()->now())
           .type(DispatchCommandMsg::TYPE_REMOVE);
 
-        lingering_commands[cancel_command.dispatch_id] = cancel_command;
-        dispatch_command_pub->publish(cancel_command);
+        send_command(std::move(cancel_command));
       }
 
       move_to_finished(task_id);
@@ -701,6 +1367,7 @@ public:
     }
 
     auto& dispatch_state = it->second;
+    changed_dispatch_states.insert(task_id);
     for (const auto& error : errors)
     {
       try
@@ -778,46 +1445,138 @@ public:
       .timestamp(node->get_clock()->now())
       .type(DispatchCommandMsg::TYPE_AWARD);
 
-    lingering_commands[award_command.dispatch_id] = award_command;
-    dispatch_command_pub->publish(award_command);
+    send_command(std::move(award_command));
+  }
+
+  /// Publish a dispatch command and keep sending it until it gets
+  /// acknowledged or expires
+  void send_command(DispatchCommandMsg command)
+  {
+    const auto now = node->get_clock()->now();
+    const auto interval = rclcpp::Duration(std::chrono::seconds(1));
+    dispatch_command_pub->publish(command);
+
+    // The state of the task is journaled first so that the command is never
+    // restored without it.
+    journal_state(command.task_id);
+    journal_write([&]() { journal->record_command(command); });
+
+    const auto id = command.dispatch_id;
+    lingering_commands.insert_or_assign(
+      id, LingeringCommand{std::move(command), now + interval, interval});
+  }
+
+  DispatchStatePtr find_dispatch_state(const TaskID& task_id) const
+  {
+    const auto active_it = active_dispatch_states.find(task_id);
+    if (active_it != active_dispatch_states.end())
+      return active_it->second;
+
+    const auto finished_it = finished_dispatch_states.find(task_id);
+    if (finished_it != finished_dispatch_states.end())
+      return finished_it->second;
+
+    return nullptr;
   }
 
   void move_to_finished(const std::string& task_id)
   {
     const auto active_it = active_dispatch_states.find(task_id);
+    const auto& state = active_it->second;
+    changed_dispatch_states.insert(task_id);
 
-    // TODO(MXG): We can make this more efficient by having a queue of
-    // finished dispatch state IDs in chronological order
-    if (finished_dispatch_states.size() >= terminated_tasks_max_size)
+    if (finished_dispatch_states.count(task_id) == 0)
     {
-      auto check_it = finished_dispatch_states.begin();
-      auto oldest_it = check_it++;
-      for (; check_it != finished_dispatch_states.end(); ++check_it)
+      while (!finished_dispatch_order.empty()
+        && finished_dispatch_states.size() >= terminated_tasks_max_size)
       {
-        const auto& check = check_it->second->submission_time;
-        const auto& oldest = oldest_it->second->submission_time;
-        if (check < oldest)
-          oldest_it = check_it;
+        const auto oldest_it = finished_dispatch_order.begin();
+        journal_write(
+          [&]() { journal->record_evicted(oldest_it->second); });
+        dispatch_labels.erase(oldest_it->second);
+        converted_dispatch_states.erase(oldest_it->second);
+        finished_dispatch_states.erase(oldest_it->second);
+        finished_dispatch_order.erase(oldest_it);
       }
 
-      finished_dispatch_states.erase(oldest_it);
+      finished_dispatch_order.insert({state->submission_time, task_id});
     }
 
-    finished_dispatch_states[active_it->first] = active_it->second;
+    finished_dispatch_states[task_id] = state;
   }
 
-  void publish_dispatch_states()
+  std::size_t finished_dispatches_memory() const
   {
-    const auto fill_states = [](auto& into, const auto& from)
+    const auto string_memory = [](const std::string& s)
       {
-        for (const auto& [id, state] : from)
-          into.push_back(convert(*state));
+        return s.capacity() + 1;
       };
 
+    std::size_t memory = 0;
+    for (const auto& [id, state] : finished_dispatch_states)
+    {
+      // The map node, the ordered index node, and the state itself
+      memory += sizeof(DispatchStates::value_type) + 2*sizeof(void*);
+      memory += sizeof(decltype(finished_dispatch_order)::value_type)
+        + 3*sizeof(void*);
+      memory += sizeof(DispatchState);
+
+      // The task ID is stored in the map key, the index, and the state
+      memory += 3*string_memory(id);
+      if (state->assignment.has_value())
+      {
+        memory += string_memory(state->assignment->fleet_name);
+        memory += string_memory(state->assignment->expected_robot_name);
+      }
+
+      for (const auto& error : state->errors)
+        memory += sizeof(nlohmann::json) + error.dump().size();
+    }
+
+    return memory;
+  }
+
+  /// Get the message for a dispatch state, converting it only if it has
+  /// changed since it was last converted
+  const DispatchStateMsg& converted(
+    const TaskID& task_id,
+    const DispatchState& state)
+  {
+    if (changed_dispatch_states.count(task_id) == 0)
+    {
+      const auto it = converted_dispatch_states.find(task_id);
+      if (it != converted_dispatch_states.end())
+        return it->second;
+    }
+
+    return converted_dispatch_states[task_id] = convert(state);
+  }
+
+  void publish_dispatch_states()
+  {
+    // Only copy the messages while holding the lock. Publishing them can take
+    // a while when there are many of them. Once the changes have been
+    // published, every state has an up to date message in the cache, so
+    // nothing gets converted here.
     std::vector<DispatchStateMsg> active;
     std::vector<DispatchStateMsg> finished;
-    fill_states(active, active_dispatch_states);
-    fill_states(finished, finished_dispatch_states);
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex);
+      publish_dispatch_state_changes();
+
+      if (!publish_full_dispatch_states)
+        return;
+
+      const auto fill_states = [this](auto& into, const auto& from)
+        {
+          into.reserve(from.size());
+          for (const auto& [id, state] : from)
+            into.push_back(converted(id, *state));
+        };
+
+      fill_states(active, active_dispatch_states);
+      fill_states(finished, finished_dispatch_states);
+    }
 
     dispatch_states_pub->publish(
       rmf_task_msgs::build<DispatchStatesMsg>()
@@ -825,25 +1584,78 @@ public:
       .finished(std::move(finished)));
   }
 
+  void publish_dispatch_state_changes()
+  {
+    if (changed_dispatch_states.empty())
+      return;
+
+    std::vector<DispatchStateMsg> active;
+    std::vector<DispatchStateMsg> finished;
+    for (const auto& task_id : changed_dispatch_states)
+    {
+      journal_state(task_id);
+
+      const auto finished_it = finished_dispatch_states.find(task_id);
+      if (finished_it != finished_dispatch_states.end())
+      {
+        finished.push_back(
+          converted_dispatch_states[task_id] = convert(*finished_it->second));
+        continue;
+      }
+
+      const auto active_it = active_dispatch_states.find(task_id);
+      if (active_it != active_dispatch_states.end())
+      {
+        active.push_back(
+          converted_dispatch_states[task_id] = convert(*active_it->second));
+        continue;
+      }
+
+      // The state is gone, e.g. it was the oldest finished one
+      converted_dispatch_states.erase(task_id);
+    }
+    changed_dispatch_states.clear();
+
+    dispatch_state_changes_pub->publish(
+      rmf_task_msgs::build<DispatchStatesMsg>()
+      .active(std::move(active))
+      .finished(std::move(finished)));
+  }
+
   void publish_lingering_commands()
   {
     std::vector<uint64_t> expired_commands;
     const auto now = node->get_clock()->now();
 
-    // TODO(MXG): Make this timeout period configurable
-    const auto timeout = std::chrono::seconds(10);
-
-    for (const auto& [id, r] : lingering_commands)
+    for (auto& [id, lingering] : lingering_commands)
     {
-      const auto timestamp = rclcpp::Time(r.timestamp);
-      if (timestamp + timeout < now)
+      const auto& r = lingering.command;
+
+      // A command only expires once its fleet has gone quiet for the whole
+      // timeout. As long as the fleet keeps acknowledging other commands, it
+      // is still alive and may just be busy.
+      auto last_heard = rclcpp::Time(r.timestamp);
+      const auto heard_it = fleet_last_heard.find(r.fleet_name);
+      if (heard_it != fleet_last_heard.end() && last_heard < heard_it->second)
+        last_heard = heard_it->second;
+
+      if (last_heard + dispatch_command_timeout < now)
       {
         // This request has expired.
         expired_commands.push_back(id);
         continue;
       }
 
+      if (now < lingering.next_publish)
+        continue;
+
       dispatch_command_pub->publish(r);
+      if (const auto state = find_dispatch_state(r.task_id))
+        ++state->retransmissions;
+
+      lingering.interval = std::min(
+        lingering.interval + lingering.interval, dispatch_command_max_interval);
+      lingering.next_publish = now + lingering.interval;
     }
 
     for (const auto& id : expired_commands)
@@ -859,7 +1671,7 @@ public:
         continue;
       }
 
-      const auto& request = it->second;
+      const auto& request = it->second.command;
       RCLCPP_ERROR(
         node->get_logger(),
         "Dispatch command [%lu] type [%u] for task [%s] directed at fleet [%s] "
@@ -874,6 +1686,7 @@ public:
       if (request.type == request.TYPE_AWARD)
         auctioneer->ready_for_next_bid();
 
+      journal_write([&]() { journal->record_command_done(id); });
       lingering_commands.erase(it);
     }
   }
@@ -887,8 +1700,11 @@ public:
       return;
     }
 
-    const auto command = std::move(command_it->second);
+    const auto command = std::move(command_it->second.command);
     lingering_commands.erase(command_it);
+    journal_write([&]() { journal->record_command_done(ack.dispatch_id); });
+    fleet_last_heard.insert_or_assign(
+      command.fleet_name, node->get_clock()->now());
 
     if (command.type == DispatchCommandMsg::TYPE_AWARD)
     {
@@ -971,12 +1787,14 @@ std::shared_ptr<Dispatcher> Dispatcher::make(
 std::optional<TaskID> Dispatcher::submit_task(
   const rmf_task_msgs::msg::TaskDescription& task_description)
 {
+  std::lock_guard<std::recursive_mutex> lock(_pimpl->mutex);
   return _pimpl->submit_task(task_description);
 }
 
 //==============================================================================
 bool Dispatcher::cancel_task(const TaskID& task_id)
 {
+  std::lock_guard<std::recursive_mutex> lock(_pimpl->mutex);
   return _pimpl->cancel_task(task_id);
 }
 
@@ -984,6 +1802,7 @@ bool Dispatcher::cancel_task(const TaskID& task_id)
 std::optional<DispatchState> Dispatcher::get_dispatch_state(
   const TaskID& task_id) const
 {
+  std::lock_guard<std::recursive_mutex> lock(_pimpl->mutex);
   const auto active_it = _pimpl->active_dispatch_states.find(task_id);
   if (active_it != _pimpl->active_dispatch_states.end())
     return *active_it->second;
@@ -1007,9 +1826,30 @@ const Dispatcher::DispatchStates& Dispatcher::finished_dispatches() const
   return _pimpl->finished_dispatch_states;
 }
 
+//==============================================================================
+std::size_t Dispatcher::finished_dispatches_limit() const
+{
+  return _pimpl->terminated_tasks_max_size;
+}
+
+//==============================================================================
+std::size_t Dispatcher::finished_dispatches_memory() const
+{
+  std::lock_guard<std::recursive_mutex> lock(_pimpl->mutex);
+  return _pimpl->finished_dispatches_memory();
+}
+
+//==============================================================================
+auto Dispatcher::api_cache_statistics() const -> ApiCacheStatistics
+{
+  std::lock_guard<std::recursive_mutex> lock(_pimpl->mutex);
+  return _pimpl->api_memory.statistics();
+}
+
 //==============================================================================
 void Dispatcher::on_change(DispatchStateCallback on_change_fn)
 {
+  std::lock_guard<std::recursive_mutex> lock(_pimpl->mutex);
   _pimpl->on_change_fn = on_change_fn;
 }
 
@@ -1019,6 +1859,13 @@ void Dispatcher::evaluator(bidding::Auctioneer::ConstEvaluatorPtr evaluator)
   _pimpl->auctioneer->set_evaluator(std::move(evaluator));
 }
 
+//==============================================================================
+void Dispatcher::batch_evaluator(
+  bidding::Auctioneer::ConstBatchEvaluatorPtr evaluator)
+{
+  _pimpl->auctioneer->set_batch_evaluator(std::move(evaluator));
+}
+
 //==============================================================================
 std::shared_ptr<rclcpp::Node> Dispatcher::node()
 {
@@ -1030,7 +1877,7 @@ void Dispatcher::spin()
 {
   rclcpp::ExecutorOptions options;
   options.context = _pimpl->node->get_node_options().context();
-  rclcpp::executors::SingleThreadedExecutor executor(options);
+  rclcpp::executors::MultiThreadedExecutor executor(options);
   executor.add_node(_pimpl->node);
   executor.spin();
 }
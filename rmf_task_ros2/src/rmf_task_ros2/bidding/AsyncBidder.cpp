@@ -22,6 +22,8 @@
 #include <rmf_task_msgs/msg/bid_proposal.hpp>
 #include <rmf_task_ros2/StandardNames.hpp>
 
+#include <mutex>
+
 namespace rmf_task_ros2 {
 namespace bidding {
 
@@ -31,7 +33,15 @@ class AsyncBidder::Implementation
 public:
 
   std::weak_ptr<rclcpp::Node> w_node;
-  ReceiveNotice receive_notice;
+  ReceiveNoticeWithDeadline receive_notice;
+
+  // Shared with the responders, which may outlive this bidder
+  struct Stats
+  {
+    std::mutex mutex;
+    Statistics statistics;
+  };
+  std::shared_ptr<Stats> stats = std::make_shared<Stats>();
 
   using BidNoticeSub = rclcpp::Subscription<BidNoticeMsg>;
   BidNoticeSub::SharedPtr bid_notice_sub;
@@ -39,9 +49,12 @@ public:
   using BidResponsePub = rclcpp::Publisher<BidResponseMsg>;
   BidResponsePub::SharedPtr bid_response_pub;
 
+  using CapabilitiesPub = rclcpp::Publisher<CapabilitiesMsg>;
+  CapabilitiesPub::SharedPtr capabilities_pub;
+
   Implementation(
     std::shared_ptr<rclcpp::Node> node_,
-    ReceiveNotice receive_notice)
+    ReceiveNoticeWithDeadline receive_notice)
   : w_node{std::move(node_)},
     receive_notice{std::move(receive_notice)}
   {
@@ -59,6 +72,34 @@ public:
       rmf_task_ros2::BidResponseTopicName, bid_qos);
   }
 
+  void advertise(Capabilities capabilities)
+  {
+    const auto node = w_node.lock();
+    if (!node)
+      return;
+
+    capabilities.topic = directed_bid_notice_topic(capabilities.fleet_name);
+    if (!capabilities_pub)
+    {
+      // Listen on our own topic instead of the one that every notice is sent
+      // to. The auctioneer keeps sending the notices that we could bid on to
+      // our topic for as long as we listen to it.
+      const auto bid_qos = rclcpp::ServicesQoS().reliable();
+      bid_notice_sub = node->create_subscription<BidNoticeMsg>(
+        capabilities.topic, bid_qos,
+        [&](const BidNoticeMsg::UniquePtr msg)
+        {
+          this->handle_notice(*msg);
+        });
+
+      capabilities_pub = node->create_publisher<CapabilitiesMsg>(
+        rmf_task_ros2::FleetCapabilitiesTopicName,
+        rclcpp::SystemDefaultsQoS().reliable().transient_local().keep_last(1));
+    }
+
+    capabilities_pub->publish(convert(capabilities));
+  }
+
   // Callback fn when a dispatch notice is received
   void handle_notice(const BidNoticeMsg& msg)
   {
@@ -74,12 +115,50 @@ public:
     if (!receive_notice)
       return;
 
+    {
+      std::lock_guard<std::mutex> lock(stats->mutex);
+      ++stats->statistics.notices;
+    }
+
+    // The notice does not say when the auction began, so the window is
+    // counted from when the notice arrived. Transport delays make the real
+    // deadline a little earlier than this.
+    const auto deadline = std::chrono::steady_clock::now()
+      + std::chrono::nanoseconds(
+      rclcpp::Duration(msg.time_window).nanoseconds());
+
     // Send the notice
     receive_notice(
       msg,
-      [task_id = msg.task_id, pub = bid_response_pub](
-        const Response& response)
+      deadline,
+      [task_id = msg.task_id, pub = bid_response_pub, deadline,
+      stats = stats, w_node = w_node](const Response& response)
       {
+        Statistics current;
+        const bool late = std::chrono::steady_clock::now() > deadline;
+        {
+          std::lock_guard<std::mutex> lock(stats->mutex);
+          if (late)
+            ++stats->statistics.late;
+          else
+            ++stats->statistics.on_time;
+
+          current = stats->statistics;
+        }
+
+        if (late)
+        {
+          if (const auto node = w_node.lock())
+          {
+            RCLCPP_WARN(
+              node->get_logger(),
+              "[Bidder] Dropping the response for task_id [%s] because the "
+              "auction has closed. %lu of %lu responses were on time.",
+              task_id.c_str(), current.on_time, current.on_time + current.late);
+          }
+          return;
+        }
+
         pub->publish(convert(response, task_id));
       });
   }
@@ -89,6 +168,24 @@ public:
 std::shared_ptr<AsyncBidder> AsyncBidder::make(
   const std::shared_ptr<rclcpp::Node>& node,
   ReceiveNotice receive_notice)
+{
+  ReceiveNoticeWithDeadline receive;
+  if (receive_notice)
+  {
+    receive = [receive_notice = std::move(receive_notice)](
+      const BidNoticeMsg& notice, Deadline, Respond respond)
+      {
+        receive_notice(notice, std::move(respond));
+      };
+  }
+
+  return make(node, std::move(receive));
+}
+
+//==============================================================================
+std::shared_ptr<AsyncBidder> AsyncBidder::make(
+  const std::shared_ptr<rclcpp::Node>& node,
+  ReceiveNoticeWithDeadline receive_notice)
 {
   auto bidder = std::shared_ptr<AsyncBidder>(new AsyncBidder());
   bidder->_pimpl =
@@ -97,6 +194,29 @@ std::shared_ptr<AsyncBidder> AsyncBidder::make(
   return bidder;
 }
 
+//==============================================================================
+auto AsyncBidder::statistics() const -> Statistics
+{
+  std::lock_guard<std::mutex> lock(_pimpl->stats->mutex);
+  return _pimpl->stats->statistics;
+}
+
+//==============================================================================
+void AsyncBidder::advertise(Capabilities capabilities)
+{
+  _pimpl->advertise(std::move(capabilities));
+}
+
+//==============================================================================
+double AsyncBidder::Statistics::on_time_ratio() const
+{
+  const auto responses = on_time + late;
+  if (responses == 0)
+    return 1.0;
+
+  return static_cast<double>(on_time) / static_cast<double>(responses);
+}
+
 //==============================================================================
 AsyncBidder::AsyncBidder()
 {
@@ -39,6 +39,13 @@ Auctioneer::Implementation::Implementation(
   }
   const auto dispatch_qos = rclcpp::ServicesQoS().reliable();
 
+  // The responses and the timer are kept in their own group so that they are
+  // never handled at the same time as each other
+  callback_group = node->create_callback_group(
+    rclcpp::CallbackGroupType::MutuallyExclusive);
+  rclcpp::SubscriptionOptions options;
+  options.callback_group = callback_group;
+
   bid_notice_pub = node->create_publisher<BidNoticeMsg>(
     rmf_task_ros2::BidNoticeTopicName, dispatch_qos);
 
@@ -46,13 +53,32 @@ Auctioneer::Implementation::Implementation(
     rmf_task_ros2::BidResponseTopicName, dispatch_qos,
     [&](const BidResponseMsg::UniquePtr msg)
     {
-      this->receive_response(*msg);
-    });
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->receive_response(*msg);
+      }
+      this->report_results();
+    },
+    options);
+
+  capabilities_sub = node->create_subscription<CapabilitiesMsg>(
+    rmf_task_ros2::FleetCapabilitiesTopicName,
+    rclcpp::SystemDefaultsQoS().reliable().transient_local().keep_last(100),
+    [&](const CapabilitiesMsg::UniquePtr msg)
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->receive_capabilities(*msg);
+    },
+    options);
 
   timer = node->create_wall_timer(std::chrono::milliseconds(200), [&]()
       {
-        this->finish_bidding_process();
-      });
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->finish_bidding_process();
+        }
+        this->report_results();
+      }, callback_group);
 }
 
 //==============================================================================
@@ -87,34 +113,117 @@ void Auctioneer::Implementation::receive_response(const BidResponseMsg& msg)
 
   // check if bidding task is initiated by the auctioneer previously
   // add submited proposal to the current bidding tasks list
-  if (open_bid_queue.front().bid_notice.task_id == id)
-    open_bid_queue.front().responses.push_back(response);
+  const auto bid_it = open_bids.find(id);
+  if (bid_it == open_bids.end())
+    return;
+
+  bid_it->second.responses.push_back(response);
+
+  // Conclude right away instead of waiting for the timer once nobody else is
+  // expected to respond
+  if (all_bidders_responded(bid_it->second))
+    finish_bidding_process();
 }
 
 //==============================================================================
-// determine the winner within a bidding task instance
 void Auctioneer::Implementation::finish_bidding_process()
 {
-  if (open_bid_queue.size() == 0)
-    return;
-
-  // Executing the task at the front queue
-  auto front_task = open_bid_queue.front();
-
-  if (bidding_in_process)
+  if (batch_evaluator)
   {
-    if (determine_winner(front_task))
+    determine_batch_winners();
+  }
+  else
+  {
+    for (auto it = open_bids.begin(); it != open_bids.end(); )
     {
-      open_bid_queue.pop();
+      if (determine_winner(it->second))
+        it = open_bids.erase(it);
+      else
+        ++it;
     }
   }
-  else
+
+  while (!open_bid_queue.empty() && bids_in_process < concurrent_bid_limit)
   {
+    auto next_bid = std::move(open_bid_queue.front());
+    open_bid_queue.pop();
+
+    const auto task_id = next_bid.bid_notice.task_id;
     RCLCPP_INFO(node->get_logger(), " - Start new bidding task: %s",
-      front_task.bid_notice.task_id.c_str());
-    open_bid_queue.front().start_time = node->now();
-    bid_notice_pub->publish(front_task.bid_notice);
-    bidding_in_process = true;
+      task_id.c_str());
+    next_bid.start_time = node->now();
+    announce(next_bid);
+    open_bids.insert_or_assign(task_id, std::move(next_bid));
+    ++bids_in_process;
+  }
+}
+
+//==============================================================================
+void Auctioneer::Implementation::receive_capabilities(
+  const CapabilitiesMsg& msg)
+{
+  auto capabilities = convert(msg);
+  if (!capabilities.has_value()
+    || capabilities->topic.rfind(DirectedBidNoticeTopicPrefix, 0) != 0)
+  {
+    RCLCPP_WARN(
+      node->get_logger(),
+      "[Auctioneer] Ignoring malformed capabilities from [%s]",
+      msg.request_id.c_str());
+    return;
+  }
+
+  auto& fleet = capable_fleets[capabilities->fleet_name];
+  if (!fleet.publisher || fleet.capabilities.topic != capabilities->topic)
+  {
+    fleet.publisher = node->create_publisher<BidNoticeMsg>(
+      capabilities->topic, rclcpp::ServicesQoS().reliable());
+  }
+
+  RCLCPP_INFO(
+    node->get_logger(),
+    "[Auctioneer] Fleet [%s] advertised [%lu] task categories and [%lu] "
+    "actions",
+    capabilities->fleet_name.c_str(),
+    capabilities->categories.size(),
+    capabilities->actions.size());
+
+  fleet.capabilities = std::move(*capabilities);
+}
+
+//==============================================================================
+void Auctioneer::Implementation::announce(OpenBid& bid)
+{
+  // Fleets that never advertised their capabilities listen to the topic that
+  // everyone used to get every notice on
+  bid_notice_pub->publish(bid.bid_notice);
+
+  bid.directed_bidders = 0;
+  if (capable_fleets.empty())
+    return;
+
+  std::optional<nlohmann::json> request;
+  try
+  {
+    request = nlohmann::json::parse(bid.bid_notice.request);
+  }
+  catch (const std::exception&)
+  {
+    // Let every fleet see the malformed request so it can report the error
+  }
+
+  for (const auto& [name, fleet] : capable_fleets)
+  {
+    if (request.has_value() && !fleet.capabilities.could_bid(*request))
+      continue;
+
+    // A fleet that stopped listening would only make us wait for it
+    const auto listeners = fleet.publisher->get_subscription_count();
+    if (listeners == 0)
+      continue;
+
+    fleet.publisher->publish(bid.bid_notice);
+    bid.directed_bidders += listeners;
   }
 }
 
@@ -122,13 +231,75 @@ void Auctioneer::Implementation::finish_bidding_process()
 bool Auctioneer::Implementation::determine_winner(
   const OpenBid& bidding_task)
 {
-  const auto duration = node->now() - bidding_task.start_time;
-  if (duration < bidding_task.bid_notice.time_window)
+  if (!is_ready(bidding_task))
     return false;
 
   if (!bidding_result_callback)
     return true;
 
+  conclude(bidding_task, evaluate(bidding_task.responses));
+  return true;
+}
+
+//==============================================================================
+void Auctioneer::Implementation::determine_batch_winners()
+{
+  if (open_bids.empty())
+    return;
+
+  for (const auto& [_, bid] : open_bids)
+  {
+    if (!is_ready(bid))
+      return;
+  }
+
+  std::vector<OpenBid> batch;
+  batch.reserve(open_bids.size());
+  for (auto& [_, bid] : open_bids)
+    batch.push_back(std::move(bid));
+  open_bids.clear();
+
+  if (!bidding_result_callback)
+    return;
+
+  // Report the results in the order that the bids were started
+  std::sort(batch.begin(), batch.end(), [](const auto& a, const auto& b)
+    {
+      return rclcpp::Time(a.start_time) < rclcpp::Time(b.start_time);
+    });
+
+  std::vector<Responses> responses;
+  responses.reserve(batch.size());
+  for (const auto& bid : batch)
+    responses.push_back(bid.responses);
+
+  const auto choices = batch_evaluator->choose(responses);
+  for (std::size_t i = 0; i < batch.size(); ++i)
+  {
+    std::optional<Response::Proposal> winner;
+    if (i < choices.size() && choices[i].has_value()
+      && *choices[i] < responses[i].size())
+    {
+      winner = responses[i][*choices[i]].proposal;
+    }
+
+    conclude(batch[i], std::move(winner));
+  }
+}
+
+//==============================================================================
+bool Auctioneer::Implementation::is_ready(const OpenBid& bidding_task) const
+{
+  const auto duration = node->now() - bidding_task.start_time;
+  return duration >= bidding_task.bid_notice.time_window
+    || all_bidders_responded(bidding_task);
+}
+
+//==============================================================================
+void Auctioneer::Implementation::conclude(
+  const OpenBid& bidding_task,
+  std::optional<Response::Proposal> winner)
+{
   auto task_id = bidding_task.bid_notice.task_id;
   RCLCPP_DEBUG(
     node->get_logger(),
@@ -146,11 +317,10 @@ bool Auctioneer::Implementation::determine_winner(
     RCLCPP_INFO(node->get_logger(),
       "Task auction for [%s] did not received any bids", task_id.c_str());
 
-    bidding_result_callback(task_id, std::nullopt, errors);
-    return true;
+    concluded.push_back({std::move(task_id), std::nullopt, std::move(errors)});
+    return;
   }
 
-  auto winner = evaluate(bidding_task.responses);
   if (winner.has_value())
   {
     RCLCPP_INFO(
@@ -160,10 +330,38 @@ bool Auctioneer::Implementation::determine_winner(
       bidding_task.responses.size());
   }
 
+  concluded.push_back(
+    {std::move(task_id), std::move(winner), std::move(errors)});
+}
+
+//==============================================================================
+void Auctioneer::Implementation::report_results()
+{
+  std::vector<Result> results;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    results.swap(concluded);
+  }
+
   // Call the user defined callback function
-  bidding_result_callback(task_id, winner, errors);
+  for (auto& result : results)
+  {
+    bidding_result_callback(
+      result.task_id, std::move(result.winner), result.errors);
+  }
+}
 
-  return true;
+//==============================================================================
+bool Auctioneer::Implementation::all_bidders_responded(
+  const OpenBid& bidding_task) const
+{
+  // Each AsyncBidder subscribes to the bid notices, either on the shared topic
+  // or on its own, so the ROS graph tells us how many bidders are alive.
+  // Anything else that listens to the notices will only make us wait for the
+  // full time window, like before.
+  const auto bidders = bid_notice_pub->get_subscription_count()
+    + bidding_task.directed_bidders;
+  return bidders > 0 && bidding_task.responses.size() >= bidders;
 }
 
 //==============================================================================
@@ -205,21 +403,46 @@ std::shared_ptr<Auctioneer> Auctioneer::make(
 //==============================================================================
 void Auctioneer::request_bid(const BidNoticeMsg& bid_notice)
 {
+  std::lock_guard<std::mutex> lock(_pimpl->mutex);
   _pimpl->request_bid(bid_notice);
 }
 
 //==============================================================================
 void Auctioneer::ready_for_next_bid()
 {
-  _pimpl->bidding_in_process = false;
+  std::lock_guard<std::mutex> lock(_pimpl->mutex);
+  if (_pimpl->bids_in_process > 0)
+    --_pimpl->bids_in_process;
+}
+
+//==============================================================================
+void Auctioneer::set_concurrent_bid_limit(std::size_t limit)
+{
+  std::lock_guard<std::mutex> lock(_pimpl->mutex);
+  _pimpl->concurrent_bid_limit = std::max<std::size_t>(limit, 1);
+}
+
+//==============================================================================
+std::size_t Auctioneer::concurrent_bid_limit() const
+{
+  std::lock_guard<std::mutex> lock(_pimpl->mutex);
+  return _pimpl->concurrent_bid_limit;
 }
 
 //==============================================================================
 void Auctioneer::set_evaluator(ConstEvaluatorPtr evaluator)
 {
+  std::lock_guard<std::mutex> lock(_pimpl->mutex);
   _pimpl->evaluator = std::move(evaluator);
 }
 
+//==============================================================================
+void Auctioneer::set_batch_evaluator(ConstBatchEvaluatorPtr evaluator)
+{
+  std::lock_guard<std::mutex> lock(_pimpl->mutex);
+  _pimpl->batch_evaluator = std::move(evaluator);
+}
+
 //==============================================================================
 Auctioneer::Auctioneer()
 {
@@ -249,6 +472,87 @@ std::optional<std::size_t> select_best(
 
   return best_index;
 }
+
+//==============================================================================
+/// Solve a rectangular assignment problem with the Hungarian method. The cost
+/// matrix must have at least as many columns as rows. Returns the column that
+/// is assigned to each row.
+std::vector<std::size_t> solve_assignment(
+  const std::vector<std::vector<double>>& cost)
+{
+  const std::size_t n = cost.size();
+  const std::size_t m = n == 0 ? 0 : cost.front().size();
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // Rows and columns are 1-indexed here so that 0 can mean "unassigned"
+  std::vector<double> u(n+1, 0.0);
+  std::vector<double> v(m+1, 0.0);
+  std::vector<std::size_t> row_of_column(m+1, 0);
+  std::vector<std::size_t> way(m+1, 0);
+  for (std::size_t i = 1; i <= n; ++i)
+  {
+    row_of_column[0] = i;
+    std::size_t j0 = 0;
+    std::vector<double> min_v(m+1, inf);
+    std::vector<bool> used(m+1, false);
+    do
+    {
+      used[j0] = true;
+      const std::size_t i0 = row_of_column[j0];
+      double delta = inf;
+      std::size_t j1 = 0;
+      for (std::size_t j = 1; j <= m; ++j)
+      {
+        if (used[j])
+          continue;
+
+        const double reduced = cost[i0-1][j-1] - u[i0] - v[j];
+        if (reduced < min_v[j])
+        {
+          min_v[j] = reduced;
+          way[j] = j0;
+        }
+
+        if (min_v[j] < delta)
+        {
+          delta = min_v[j];
+          j1 = j;
+        }
+      }
+
+      for (std::size_t j = 0; j <= m; ++j)
+      {
+        if (used[j])
+        {
+          u[row_of_column[j]] += delta;
+          v[j] -= delta;
+        }
+        else
+        {
+          min_v[j] -= delta;
+        }
+      }
+
+      j0 = j1;
+    } while (row_of_column[j0] != 0);
+
+    do
+    {
+      const std::size_t j1 = way[j0];
+      row_of_column[j0] = row_of_column[j1];
+      j0 = j1;
+    } while (j0 != 0);
+  }
+
+  std::vector<std::size_t> column_of_row(n, 0);
+  for (std::size_t j = 1; j <= m; ++j)
+  {
+    if (row_of_column[j] != 0)
+      column_of_row[row_of_column[j]-1] = j-1;
+  }
+
+  return column_of_row;
+}
 } // anonymous namespace
 
 //==============================================================================
@@ -269,6 +573,98 @@ std::optional<std::size_t> LeastFleetCostEvaluator::choose(
     [](const auto& nominee) { return nominee.new_cost; });
 }
 
+//==============================================================================
+AssignmentBatchEvaluator::AssignmentBatchEvaluator(ProposalCost cost)
+: _cost(std::move(cost))
+{
+  if (!_cost)
+  {
+    _cost = [](const Response::Proposal& nominee)
+      {
+        return nominee.new_cost - nominee.prev_cost;
+      };
+  }
+}
+
+//==============================================================================
+std::vector<std::optional<std::size_t>> AssignmentBatchEvaluator::choose(
+  const std::vector<Responses>& batch) const
+{
+  // Every task starts out with its cheapest proposal, which is what it keeps
+  // if it does not get a robot of its own in the assignment.
+  std::vector<std::optional<std::size_t>> winners;
+  winners.reserve(batch.size());
+  for (const auto& responses : batch)
+    winners.push_back(select_best(responses, _cost));
+
+  // Find the cheapest proposal that each robot made for each task
+  std::unordered_map<std::string, std::size_t> robot_index;
+  std::vector<std::unordered_map<std::size_t, std::size_t>> robot_choice;
+  std::vector<std::size_t> tasks;
+  double lowest_cost = std::numeric_limits<double>::infinity();
+  double highest_cost = -std::numeric_limits<double>::infinity();
+  for (std::size_t t = 0; t < batch.size(); ++t)
+  {
+    if (!winners[t].has_value())
+      continue;
+
+    tasks.push_back(t);
+    auto& choice = robot_choice.emplace_back();
+    const auto& responses = batch[t];
+    for (std::size_t r = 0; r < responses.size(); ++r)
+    {
+      const auto& proposal = responses[r].proposal;
+      if (!proposal.has_value())
+        continue;
+
+      const auto key =
+        proposal->fleet_name + "/" + proposal->expected_robot_name;
+      const auto j =
+        robot_index.insert({key, robot_index.size()}).first->second;
+
+      const double cost = _cost(*proposal);
+      lowest_cost = std::min(lowest_cost, cost);
+      highest_cost = std::max(highest_cost, cost);
+
+      const auto it = choice.find(j);
+      if (it == choice.end() || cost < _cost(*responses[it->second].proposal))
+        choice[j] = r;
+    }
+  }
+
+  if (tasks.empty())
+    return winners;
+
+  // A task that is not given a robot of its own costs so much more than any
+  // real assignment that the solver always gives out as many robots as it can
+  const std::size_t n = tasks.size();
+  const std::size_t robots = robot_index.size();
+  const std::size_t m = std::max(n, robots);
+  const double penalty = (highest_cost - lowest_cost + 1.0) * (n + 1);
+
+  std::vector<std::vector<double>> cost_matrix(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const auto& responses = batch[tasks[i]];
+    const double unassigned =
+      _cost(*responses[*winners[tasks[i]]].proposal) + penalty;
+
+    cost_matrix[i].assign(m, unassigned);
+    for (const auto& [j, r] : robot_choice[i])
+      cost_matrix[i][j] = _cost(*responses[r].proposal);
+  }
+
+  const auto assignment = solve_assignment(cost_matrix);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const auto it = robot_choice[i].find(assignment[i]);
+    if (it != robot_choice[i].end())
+      winners[tasks[i]] = it->second;
+  }
+
+  return winners;
+}
+
 //==============================================================================
 std::optional<std::size_t> QuickestFinishEvaluator::choose(
   const Responses& responses) const
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task_ros2/bidding/Capabilities.hpp>
+#include <rmf_task_ros2/StandardNames.hpp>
+
+#include <cctype>
+
+namespace rmf_task_ros2 {
+namespace bidding {
+
+namespace {
+//==============================================================================
+/// Find the categories of every perform_action activity in a task description,
+/// however deeply it is nested inside of phases and sequences.
+void collect_actions(
+  const nlohmann::json& json,
+  std::unordered_set<std::string>& actions)
+{
+  if (json.is_object())
+  {
+    const auto category = json.find("category");
+    const auto description = json.find("description");
+    if (category != json.end() && description != json.end()
+      && category->is_string() && *category == "perform_action"
+      && description->is_object())
+    {
+      const auto action = description->find("category");
+      if (action != description->end() && action->is_string())
+        actions.insert(action->get<std::string>());
+    }
+
+    for (const auto& [_, value] : json.items())
+      collect_actions(value, actions);
+  }
+  else if (json.is_array())
+  {
+    for (const auto& value : json)
+      collect_actions(value, actions);
+  }
+}
+} // anonymous namespace
+
+//==============================================================================
+bool Capabilities::could_bid(const nlohmann::json& task_request) const
+{
+  const auto category_it = task_request.find("category");
+  if (category_it == task_request.end() || !category_it->is_string())
+  {
+    // Let the fleet decide what to do with a malformed request
+    return true;
+  }
+
+  if (categories.count(category_it->get<std::string>()) == 0)
+    return false;
+
+  const auto description_it = task_request.find("description");
+  if (description_it == task_request.end())
+    return true;
+
+  std::unordered_set<std::string> requested_actions;
+  collect_actions(*description_it, requested_actions);
+  for (const auto& action : requested_actions)
+  {
+    if (actions.count(action) == 0)
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+CapabilitiesMsg convert(const Capabilities& capabilities)
+{
+  nlohmann::json json;
+  json["fleet_name"] = capabilities.fleet_name;
+  json["categories"] = std::vector<std::string>(
+    capabilities.categories.begin(), capabilities.categories.end());
+  json["actions"] = std::vector<std::string>(
+    capabilities.actions.begin(), capabilities.actions.end());
+  json["topic"] = capabilities.topic;
+
+  CapabilitiesMsg msg;
+  msg.json_msg = json.dump();
+  msg.request_id = capabilities.fleet_name;
+  return msg;
+}
+
+//==============================================================================
+std::optional<Capabilities> convert(const CapabilitiesMsg& msg)
+{
+  try
+  {
+    const auto json = nlohmann::json::parse(msg.json_msg);
+    Capabilities capabilities;
+    capabilities.fleet_name = json.at("fleet_name").get<std::string>();
+    for (const auto& category : json.at("categories"))
+      capabilities.categories.insert(category.get<std::string>());
+
+    for (const auto& action : json.at("actions"))
+      capabilities.actions.insert(action.get<std::string>());
+
+    capabilities.topic = json.at("topic").get<std::string>();
+    return capabilities;
+  }
+  catch (const std::exception&)
+  {
+    return std::nullopt;
+  }
+}
+
+//==============================================================================
+std::string directed_bid_notice_topic(const std::string& fleet_name)
+{
+  // Fleet names may have characters that a topic name cannot
+  std::string topic = DirectedBidNoticeTopicPrefix;
+  for (const char c : fleet_name)
+  {
+    topic.push_back(
+      std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+  }
+
+  return topic;
+}
+
+} // namespace bidding
+} // namespace rmf_task_ros2
@@ -21,11 +21,18 @@
 
 #include <rmf_task_ros2/bidding/Response.hpp>
 #include <rmf_task_ros2/bidding/Auctioneer.hpp>
+#include <rmf_task_ros2/bidding/Capabilities.hpp>
 #include <rmf_task_msgs/msg/bid_proposal.hpp>
 
 #include <rmf_traffic_ros2/Time.hpp>
 #include <rmf_task_ros2/StandardNames.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+
 namespace rmf_task_ros2 {
 namespace bidding {
 
@@ -36,25 +43,65 @@ public:
 
   std::shared_ptr<rclcpp::Node> node;
   rclcpp::TimerBase::SharedPtr timer;
+  rclcpp::CallbackGroup::SharedPtr callback_group;
   BiddingResultCallback bidding_result_callback;
+
+  // Bid notices may be requested from a different thread than the one that
+  // collects the responses, so the auctions are guarded by this mutex. It is
+  // never held while the bidding result callback is triggered, because the
+  // callback will usually lock the owner of this auctioneer.
+  mutable std::mutex mutex;
+
+  struct Result
+  {
+    std::string task_id;
+    std::optional<Response::Proposal> winner;
+    std::vector<std::string> errors;
+  };
+
+  // Results that are waiting to be reported once the mutex is released
+  std::vector<Result> concluded;
   ConstEvaluatorPtr evaluator;
+  ConstBatchEvaluatorPtr batch_evaluator;
 
   struct OpenBid
   {
     BidNoticeMsg bid_notice;
     builtin_interfaces::msg::Time start_time;
     std::vector<bidding::Response> responses;
+    // How many of the fleets that advertised their capabilities were sent
+    // this notice on their own topics
+    std::size_t directed_bidders = 0;
   };
 
-  bool bidding_in_process = false;
+  // Bid notices that are waiting for an auction to open up for them
   std::queue<OpenBid> open_bid_queue;
 
+  // The auctions that have been announced and are collecting responses
+  std::unordered_map<std::string, OpenBid> open_bids;
+
+  // How many auctions have been announced without a ready_for_next_bid() yet
+  std::size_t bids_in_process = 0;
+  std::size_t concurrent_bid_limit = 1;
+
   using BidNoticePub = rclcpp::Publisher<BidNoticeMsg>;
   BidNoticePub::SharedPtr bid_notice_pub;
 
   using BidResponseSub = rclcpp::Subscription<BidResponseMsg>;
   BidResponseSub::SharedPtr bid_proposal_sub;
 
+  // The fleets that have told us what they can do, by name. Each one only
+  // gets the notices that it could bid on.
+  struct CapableFleet
+  {
+    Capabilities capabilities;
+    BidNoticePub::SharedPtr publisher;
+  };
+  std::unordered_map<std::string, CapableFleet> capable_fleets;
+
+  using CapabilitiesSub = rclcpp::Subscription<CapabilitiesMsg>;
+  CapabilitiesSub::SharedPtr capabilities_sub;
+
   Implementation(
     const std::shared_ptr<rclcpp::Node>& node_,
     BiddingResultCallback result_callback,
@@ -66,11 +113,35 @@ public:
   // Receive proposal and evaluate
   void receive_response(const BidResponseMsg& msg);
 
-  // determine the winner within a bidding task instance
+  // Conclude the auctions whose time is up and announce the next ones
   void finish_bidding_process();
 
+  // Remember what a fleet is able to do
+  void receive_capabilities(const CapabilitiesMsg& msg);
+
+  // Send a bid notice to every bidder that could plausibly bid on it
+  void announce(OpenBid& bid);
+
   bool determine_winner(const OpenBid& bidding_task);
 
+  // Conclude all the open bids together once every one of them is ready
+  void determine_batch_winners();
+
+  // Check whether a bid can be concluded
+  bool is_ready(const OpenBid& bidding_task) const;
+
+  // Report the winner of a bid that is being concluded
+  void conclude(
+    const OpenBid& bidding_task,
+    std::optional<Response::Proposal> winner);
+
+  // Trigger the bidding result callback for everything that was concluded.
+  // The mutex must not be locked when this is called.
+  void report_results();
+
+  // Check whether every bidder that is listening for bid notices has responded
+  bool all_bidders_responded(const OpenBid& bidding_task) const;
+
   std::optional<Response::Proposal> evaluate(const Responses& responses);
 
   static const Implementation& get(const Auctioneer& auctioneer)
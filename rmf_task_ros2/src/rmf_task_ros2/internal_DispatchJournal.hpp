@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK_ROS2__INTERNAL_DISPATCHJOURNAL_HPP
+#define SRC__RMF_TASK_ROS2__INTERNAL_DISPATCHJOURNAL_HPP
+
+#include <rmf_task_ros2/DispatchState.hpp>
+
+#include <rmf_task_msgs/msg/dispatch_command.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rmf_task_ros2 {
+
+//==============================================================================
+/// Everything that the dispatcher needs to pick up where it left off after a
+/// restart
+struct DispatchRecovery
+{
+  struct Task
+  {
+    DispatchState state;
+    std::vector<std::string> labels;
+
+    /// True if the state was among the finished dispatch states
+    bool finished = false;
+  };
+
+  /// The tasks by their IDs
+  std::map<TaskID, Task> tasks;
+
+  /// The dispatch commands that had not been acknowledged, by their IDs
+  std::map<uint64_t, rmf_task_msgs::msg::DispatchCommand> commands;
+
+  /// The next ID that may be given to a dispatch command
+  uint64_t next_dispatch_command_id = 0;
+
+  /// The next index for generating task IDs
+  uint64_t task_counter = 0;
+};
+
+//==============================================================================
+/// An append-only journal of the changes to the dispatch states and the
+/// lingering dispatch commands. Every record is idempotent, so replaying the
+/// records of the journal on top of a snapshot that already contains some of
+/// them gives the same result. Once the journal grows long, it gets compacted
+/// into a new snapshot.
+class DispatchJournal
+{
+public:
+
+  using DispatchCommandMsg = rmf_task_msgs::msg::DispatchCommand;
+
+  /// Open the journal at the given location for appending. The snapshot is
+  /// kept next to it.
+  ///
+  /// 	hrows std::runtime_error if the file cannot be opened.
+  DispatchJournal(std::string file_path);
+
+  /// Restore everything that was recorded at the given location, from its
+  /// snapshot and then its journal.
+  ///
+  /// 	hrows std::runtime_error if a record before the end of the journal is
+  /// malformed. A malformed final record is assumed to be the result of an
+  /// interrupted write and is ignored.
+  static DispatchRecovery load(const std::string& file_path);
+
+  /// Record the latest state of a task
+  void record_state(
+    const DispatchState& state,
+    const std::vector<std::string>& labels,
+    bool finished,
+    uint64_t task_counter);
+
+  /// Record that a task has been forgotten
+  void record_evicted(const TaskID& task_id);
+
+  /// Record a dispatch command that is waiting for its acknowledgment
+  void record_command(const DispatchCommandMsg& command);
+
+  /// Record that a dispatch command is no longer waiting
+  void record_command_done(uint64_t dispatch_id);
+
+  /// How many records have been appended since the last snapshot
+  std::size_t records() const;
+
+  /// Atomically replace the snapshot with everything that is given, and then
+  /// empty the journal.
+  ///
+  /// 	hrows std::runtime_error if the snapshot could not be written.
+  void snapshot(const DispatchRecovery& everything);
+
+  ~DispatchJournal();
+
+private:
+  void _open();
+  void _append(uint8_t type, const std::string& payload);
+
+  std::string _file_path;
+  int _fd = -1;
+  std::size_t _records = 0;
+};
+
+} // namespace rmf_task_ros2
+
+#endif // SRC__RMF_TASK_ROS2__INTERNAL_DISPATCHJOURNAL_HPP
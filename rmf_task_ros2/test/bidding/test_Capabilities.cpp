@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task_ros2/bidding/Capabilities.hpp>
+#include <rmf_task_ros2/StandardNames.hpp>
+
+#include <rmf_utils/catch.hpp>
+
+namespace rmf_task_ros2 {
+namespace bidding {
+
+//==============================================================================
+SCENARIO("Filter bid notices by the capabilities of a fleet")
+{
+  Capabilities capabilities;
+  capabilities.fleet_name = "fleet 1";
+  capabilities.categories = {"patrol", "compose"};
+  capabilities.actions = {"teleop"};
+
+  const auto compose_with = [](const std::string& action)
+    {
+      return nlohmann::json{
+        {"category", "compose"},
+        {"description", {
+            {"category", "bundle"},
+            {"phases", {{
+              {"activity", {
+                  {"category", "sequence"},
+                  {"description", {{
+                    {"category", "perform_action"},
+                    {"description", {{"category", action}}}
+                  }}}
+                }}
+            }}}
+          }}
+      };
+    };
+
+  CHECK(capabilities.could_bid({{"category", "patrol"}}));
+  CHECK_FALSE(capabilities.could_bid({{"category", "delivery"}}));
+  CHECK(capabilities.could_bid(compose_with("teleop")));
+  CHECK_FALSE(capabilities.could_bid(compose_with("clean_windows")));
+
+  // The fleet gets to report the error of a malformed request itself
+  CHECK(capabilities.could_bid(nlohmann::json::object()));
+
+  capabilities.topic = directed_bid_notice_topic(capabilities.fleet_name);
+  CHECK(capabilities.topic == DirectedBidNoticeTopicPrefix + "fleet_1");
+
+  const auto restored = convert(convert(capabilities));
+  REQUIRE(restored.has_value());
+  CHECK(restored->fleet_name == capabilities.fleet_name);
+  CHECK(restored->categories == capabilities.categories);
+  CHECK(restored->actions == capabilities.actions);
+  CHECK(restored->topic == capabilities.topic);
+
+  CHECK_FALSE(convert(CapabilitiesMsg()).has_value());
+}
+
+} // namespace bidding
+} // namespace rmf_task_ros2
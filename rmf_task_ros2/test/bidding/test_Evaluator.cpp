@@ -125,6 +125,54 @@ SCENARIO("Auctioneer Winner Evaluator", "[Evaluator]")
     }
   }
 
+  WHEN("Assignment Batch Evaluator")
+  {
+    const auto proposal = [](std::string robot, double cost)
+      {
+        return Response{
+          Response::Proposal{"fleet", std::move(robot), 0.0, cost, now}, {}};
+      };
+
+    AssignmentBatchEvaluator eval;
+
+    AND_WHEN("Two tasks prefer the same robot")
+    {
+      const std::vector<Responses> batch{
+        {proposal("A", 1.0), proposal("B", 2.0)},
+        {proposal("A", 1.0), proposal("B", 5.0)}};
+
+      const auto winners = eval.choose(batch);
+      REQUIRE(winners.size() == 2);
+      REQUIRE(winners[0].has_value());
+      REQUIRE(winners[1].has_value());
+      CHECK(*winners[0] == 1); // robot B
+      CHECK(*winners[1] == 0); // robot A
+    }
+
+    AND_WHEN("There are more tasks than robots")
+    {
+      const std::vector<Responses> batch{
+        {proposal("A", 1.0), proposal("B", 2.0)},
+        {proposal("A", 1.0), proposal("B", 5.0)},
+        {proposal("A", 3.0), proposal("B", 4.0)},
+        {}};
+
+      const auto winners = eval.choose(batch);
+      REQUIRE(winners.size() == 4);
+      CHECK_FALSE(winners[3].has_value());
+
+      // Both robots get used before any of them is given a second task
+      std::size_t given_to_b = 0;
+      for (std::size_t i = 0; i < 3; ++i)
+      {
+        REQUIRE(winners[i].has_value());
+        if (*winners[i] == 1)
+          ++given_to_b;
+      }
+      CHECK(given_to_b == 1);
+    }
+  }
+
   rclcpp::shutdown(rcl_context);
 }
 
@@ -147,6 +147,14 @@ SCENARIO("Auction with 2 Bids", "[TwoBids]")
     // Check if Auctioneer received Bid from bidder1
     REQUIRE(r_result_winner == "bidder1");
     REQUIRE(r_result_id == "bid1");
+
+    // Both bidders responded within the time window, even the one that
+    // declined
+    CHECK(bidder1->statistics().notices == 1);
+    CHECK(bidder1->statistics().on_time == 1);
+    CHECK(bidder2->statistics().on_time == 1);
+    CHECK(bidder2->statistics().late == 0);
+    CHECK(bidder2->statistics().on_time_ratio() == 1.0);
   }
 
   WHEN("Second 'delivery' Task bid")
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <filesystem>
+
+#include "../../src/rmf_task_ros2/internal_DispatchJournal.hpp"
+
+using namespace rmf_task_ros2;
+
+namespace {
+//==============================================================================
+void remove_files(const std::string& journal_file)
+{
+  for (const auto& suffix : {"", ".snapshot", ".snapshot.tmp"})
+    std::filesystem::remove(journal_file + suffix);
+}
+
+//==============================================================================
+rmf_task_msgs::msg::DispatchCommand make_command(
+  const std::string& task_id,
+  const uint64_t dispatch_id)
+{
+  rmf_task_msgs::msg::DispatchCommand command;
+  command.fleet_name = "fleet";
+  command.task_id = task_id;
+  command.dispatch_id = dispatch_id;
+  command.timestamp.sec = 10;
+  command.type = rmf_task_msgs::msg::DispatchCommand::TYPE_AWARD;
+  return command;
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Restoring dispatch states from a journal")
+{
+  const std::string journal_file = "test_dispatch_journal.bin";
+  remove_files(journal_file);
+
+  GIVEN("No journal")
+  {
+    const auto recovery = DispatchJournal::load(journal_file);
+    CHECK(recovery.tasks.empty());
+    CHECK(recovery.commands.empty());
+    CHECK(recovery.next_dispatch_command_id == 0);
+  }
+
+  GIVEN("A journal with some changes")
+  {
+    DispatchState selected("task.dispatch-0", std::chrono::steady_clock::now());
+    selected.status = DispatchState::Status::Selected;
+    selected.assignment = DispatchState::Assignment{"fleet", "robot"};
+    selected.errors.push_back(
+      nlohmann::json{{"code", 10}, {"detail", "late bid"}});
+
+    DispatchState evicted("task.dispatch-1", std::chrono::steady_clock::now());
+    evicted.status = DispatchState::Status::Dispatched;
+
+    {
+      DispatchJournal journal(journal_file);
+      journal.record_state(selected, {"urgent"}, false, 2);
+      journal.record_state(evicted, {}, true, 2);
+      journal.record_evicted(evicted.task_id);
+      journal.record_command(make_command(selected.task_id, 0));
+      journal.record_command(make_command(selected.task_id, 1));
+      journal.record_command_done(0);
+      CHECK(journal.records() == 6);
+    }
+
+    THEN("Replaying the journal gives back the remaining states")
+    {
+      const auto recovery = DispatchJournal::load(journal_file);
+      CHECK(recovery.task_counter == 2);
+      CHECK(recovery.next_dispatch_command_id == 2);
+      REQUIRE(recovery.tasks.size() == 1);
+      const auto& task = recovery.tasks.at(selected.task_id);
+      CHECK_FALSE(task.finished);
+      CHECK(task.labels == std::vector<std::string>{"urgent"});
+      CHECK(task.state.status == DispatchState::Status::Selected);
+      REQUIRE(task.state.assignment.has_value());
+      CHECK(task.state.assignment->expected_robot_name == "robot");
+      CHECK(task.state.errors == selected.errors);
+      CHECK(std::chrono::abs(
+          task.state.submission_time - selected.submission_time)
+        < std::chrono::seconds(1));
+
+      REQUIRE(recovery.commands.size() == 1);
+      CHECK(recovery.commands.count(1) == 1);
+    }
+
+    WHEN("The final record was torn")
+    {
+      const auto size = std::filesystem::file_size(journal_file);
+      std::filesystem::resize_file(journal_file, size - 3);
+
+      THEN("The torn record is ignored")
+      {
+        const auto recovery = DispatchJournal::load(journal_file);
+        CHECK(recovery.tasks.size() == 1);
+        CHECK(recovery.commands.size() == 2);
+      }
+    }
+
+    WHEN("A snapshot is taken")
+    {
+      {
+        DispatchJournal journal(journal_file);
+        journal.snapshot(DispatchJournal::load(journal_file));
+        CHECK(journal.records() == 0);
+
+        journal.record_command_done(1);
+      }
+
+      THEN("The snapshot and the new journal are both restored")
+      {
+        CHECK(std::filesystem::file_size(journal_file) > 0);
+        const auto recovery = DispatchJournal::load(journal_file);
+        CHECK(recovery.tasks.size() == 1);
+        CHECK(recovery.commands.empty());
+        CHECK(recovery.next_dispatch_command_id == 2);
+      }
+    }
+  }
+
+  remove_files(journal_file);
+}
@@ -166,4 +166,42 @@ SCENARIO("Dispatcher API Test", "[Dispatcher][.flaky]")
   dispatcher_spin_thread.join();
 }
 
+//==============================================================================
+SCENARIO("Finished dispatches are retained up to a limit", "[Dispatcher]")
+{
+  const auto rcl_context = std::make_shared<rclcpp::Context>();
+  rcl_context->init(0, nullptr);
+
+  const auto node = std::make_shared<rclcpp::Node>(
+    "test_dispatcher_retention_node",
+    rclcpp::NodeOptions()
+    .context(rcl_context)
+    .parameter_overrides({{"terminated_tasks_max_size", 2}}));
+
+  const auto dispatcher = Dispatcher::make(node);
+  CHECK(dispatcher->finished_dispatches_limit() == 2);
+  CHECK(dispatcher->finished_dispatches_memory() == 0);
+
+  rmf_task_msgs::msg::TaskDescription task_desc;
+  task_desc.task_type.type = rmf_task_msgs::msg::TaskType::TYPE_STATION;
+
+  std::vector<TaskID> ids;
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const auto id = dispatcher->submit_task(task_desc);
+    REQUIRE(id.has_value());
+    REQUIRE(dispatcher->cancel_task(*id));
+    ids.push_back(*id);
+  }
+
+  // The dispatch that was submitted first is the one that gets dropped
+  CHECK(dispatcher->finished_dispatches().size() == 2);
+  CHECK(dispatcher->finished_dispatches().count(ids[0]) == 0);
+  CHECK(dispatcher->finished_dispatches().count(ids[1]) == 1);
+  CHECK(dispatcher->finished_dispatches().count(ids[2]) == 1);
+  CHECK(dispatcher->finished_dispatches_memory() > 0);
+
+  rclcpp::shutdown(rcl_context);
+}
+
 } // namespace rmf_task_ros2
@@ -27,6 +27,13 @@ rmf_traffic::Route convert(const rmf_traffic_msgs::msg::Route& from);
 //==============================================================================
 rmf_traffic_msgs::msg::Route convert(const rmf_traffic::Route& from);
 
+//==============================================================================
+/// Convert a Route into an existing message, reusing whatever memory the
+/// message already holds.
+void convert(
+  const rmf_traffic::Route& from,
+  rmf_traffic_msgs::msg::Route& into);
+
 //==============================================================================
 std::vector<rmf_traffic::Route> convert(
   const std::vector<rmf_traffic_msgs::msg::Route>& from);
@@ -35,4 +42,11 @@ std::vector<rmf_traffic::Route> convert(
 std::vector<rmf_traffic_msgs::msg::Route> convert(
   const std::vector<rmf_traffic::Route>& from);
 
+//==============================================================================
+/// Convert a set of Routes into an existing vector of messages, reusing the
+/// messages that it already holds.
+void convert(
+  const std::vector<rmf_traffic::Route>& from,
+  std::vector<rmf_traffic_msgs::msg::Route>& into);
+
 } // namespace rmf_traffic_ros2
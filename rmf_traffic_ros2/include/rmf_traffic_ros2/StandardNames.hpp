@@ -39,6 +39,8 @@ const std::string UnregisterParticipantSrvName = Prefix +
 const std::string RegisterQueryServiceName = Prefix + "register_query";
 const std::string ParticipantsInfoTopicName = Prefix + "participants";
 const std::string QueryUpdateTopicNameBase = Prefix + "query_update_";
+const std::string QueryCompactUpdateTopicNameBase = Prefix +
+  "query_compact_update_";
 const std::string RequestChangesServiceName = Prefix + "request_changes";
 const std::string ScheduleInconsistencyTopicName = Prefix +
   "schedule_inconsistency";
@@ -58,11 +60,15 @@ const std::string NegotiationForfeitTopicName = Prefix +
   "negotiation_forfeit";
 const std::string NegotiationConclusionTopicName = Prefix +
   "negotiation_conclusion";
+const std::string NegotiationDiagnosticsTopicName = Prefix +
+  "negotiation_diagnostics";
 
 const std::string BlockadeCancelTopicName = Prefix +
   "blockade_cancel";
 const std::string BlockadeHeartbeatTopicName = Prefix +
   "blockade_heartbeat";
+const std::string BlockadeHeartbeatDeltaTopicName = Prefix +
+  "blockade_heartbeat_delta";
 const std::string BlockadeReachedTopicName = Prefix +
   "blockade_reached";
 const std::string BlockadeReadyTopicName = Prefix +
@@ -74,6 +80,15 @@ const std::string BlockadeSetTopicName = Prefix +
 
 const std::string EmergencyTopicName = "fire_alarm_trigger";
 
+const std::string DiagnosticsTopicName = "diagnostics";
+
+const std::string ScheduleNodeName = "rmf_traffic_schedule_node";
+
+// The schedule node declares <prefix><query_id>.max_rate,
+// <prefix><query_id>.background, <prefix><query_id>.history, and
+// <prefix><query_id>.compact parameters for each registered query
+const std::string QueryPreferencesParameterPrefix = "query_preferences.";
+
 } // namespace rmf_traffic_ros2
 
 #endif // RMF_TRAFFIC_ROS2__STANDARDNAMES_HPP
@@ -37,6 +37,14 @@ rmf_traffic::Trajectory convert(const rmf_traffic_msgs::msg::Trajectory& from);
 /// Convert from a Trajectory instance to a Trajectory message.
 rmf_traffic_msgs::msg::Trajectory convert(const rmf_traffic::Trajectory& from);
 
+//==============================================================================
+/// Convert from a Trajectory instance into an existing Trajectory message. The
+/// waypoints of the message are overwritten in place, so a message that gets
+/// reused for each conversion stops allocating once it has grown large enough.
+void convert(
+  const rmf_traffic::Trajectory& from,
+  rmf_traffic_msgs::msg::Trajectory& into);
+
 } // namespace rmf_traffic_ros2
 
 #endif // RMF_TRAFFIC_ROS2__TRAJECTORY_HPP
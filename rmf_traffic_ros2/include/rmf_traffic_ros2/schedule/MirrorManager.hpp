@@ -23,6 +23,8 @@
 
 #include <rclcpp/node.hpp>
 
+#include <optional>
+
 namespace rmf_traffic_ros2 {
 namespace schedule {
 
@@ -45,9 +47,14 @@ public:
     /// \brief update_on_wakeup
     ///   Specify if the mirror should perform an update whenever it gets woken
     ///   up by the schedule.
+    ///
+    /// \brief prebuilt_snapshots
+    ///   Specify if a new snapshot should be built after every update. See
+    ///   prebuilt_snapshots() for details.
     Options(
       std::mutex* update_mutex = nullptr,
-      bool update_on_wakeup = true);
+      bool update_on_wakeup = true,
+      bool prebuilt_snapshots = false);
 
     /// Get a reference to the mutex that will be used when performing an
     /// update.
@@ -64,6 +71,71 @@ public:
     /// Toggle the choice to wakeup on an update.
     Options& update_on_wakeup(bool choice);
 
+    /// True if the snapshot_handle() should hand out immutable snapshots that
+    /// are shared by every reader until the mirror changes again. A snapshot
+    /// is built when it is first asked for after a change, so it costs at most
+    /// one copy of the mirror per change, no matter how many planners take
+    /// snapshots of it, and nothing for changes that nobody reads.
+    ///
+    /// This is best for mirrors that get read by many planners at once.
+    bool prebuilt_snapshots() const;
+
+    /// Toggle the choice to build snapshots after each update. This should be
+    /// set before snapshot_handle() is called, because any handle that was
+    /// already given out will keep using the old choice.
+    Options& prebuilt_snapshots(bool choice);
+
+    /// How the schedule node should rank the updates of this mirror against
+    /// the updates of other mirrors
+    enum class Priority : uint8_t
+    {
+      /// Updated as soon as the schedule changes
+      Normal = 0,
+
+      /// Updated after every Normal mirror has been updated
+      Background
+    };
+
+    /// The highest rate, in Hz, at which the schedule node should send updates
+    /// to this mirror. Changes that arrive faster than this get batched into a
+    /// single update. std::nullopt means there is no limit.
+    ///
+    /// \note Mirrors that track the same query share one stream of updates,
+    /// so this preference applies to all of them.
+    std::optional<double> max_update_rate() const;
+
+    /// Set the highest rate at which this mirror should be updated.
+    Options& max_update_rate(std::optional<double> rate);
+
+    /// The priority of the updates for this mirror.
+    Priority update_priority() const;
+
+    /// Set the priority of the updates for this mirror.
+    Options& update_priority(Priority priority);
+
+    /// How long this mirror keeps a route after the route has finished. Routes
+    /// that finish before this window are pruned from the mirror, and the
+    /// schedule node stops sending them. std::nullopt keeps every route until
+    /// the schedule culls it.
+    std::optional<rmf_traffic::Duration> max_history() const;
+
+    /// Set how long this mirror keeps routes after they have finished.
+    Options& max_history(std::optional<rmf_traffic::Duration> history);
+
+    /// True if this mirror receives its updates as a compact stream instead
+    /// of as MirrorUpdate messages. Positions are rounded to the millimeter
+    /// and angles to a tenth of a milliradian, and routes that were sent
+    /// recently are referred to instead of being sent again. This saves
+    /// bandwidth on slow links, such as Wi-Fi bridges, at the cost of some
+    /// encoding work in the schedule node. It is turned off by default.
+    ///
+    /// \note This has no effect while the mirror receives its updates
+    /// directly from a schedule node in the same process.
+    bool compact_updates() const;
+
+    /// Toggle the choice to receive compact updates.
+    Options& compact_updates(bool choice);
+
     class Implementation;
   private:
     rmf_utils::impl_ptr<Implementation> _pimpl;
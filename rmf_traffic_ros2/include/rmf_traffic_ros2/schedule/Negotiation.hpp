@@ -44,6 +44,19 @@ public:
     /// this function is thread-safe.
     virtual void schedule(std::function<void()> job) = 0;
 
+    /// Tell the worker to add a callback that belongs to the negotiation of
+    /// conflict_version. Callbacks of the same negotiation must be run in the
+    /// order that they were scheduled, but callbacks of different negotiations
+    /// may be run concurrently. By default this will call schedule(job).
+    ///
+    /// The state of the negotiations is guarded inside of this class, but the
+    /// negotiators are run by these callbacks directly. A negotiator that is
+    /// not safe to use from several threads must move its work onto its own
+    /// worker before it touches anything that it shares.
+    virtual void schedule_negotiation(
+      uint64_t conflict_version,
+      std::function<void()> job);
+
     virtual ~Worker() = default;
   };
 
@@ -111,6 +124,80 @@ public:
   ///   The number of negotiations to retain
   void set_retained_history_count(uint count);
 
+  /// Set the greatest number of messages that each negotiation will hold on to
+  /// while it waits to learn about the tables that they refer to. When this is
+  /// exceeded, the messages that have been waiting the longest get dropped.
+  /// This only affects negotiations that begin after it is set.
+  ///
+  /// \param[in] limit
+  ///   The number of messages to cache for each negotiation
+  void set_cache_limit(std::size_t limit);
+
+  /// Choose whether to keep track of negotiations that none of the negotiators
+  /// of this manager are taking part in. Following them means that a
+  /// negotiator which gets added to a negotiation partway through already
+  /// knows the proposals that were made before it joined, and the status
+  /// callbacks and table_view() can observe every negotiation on the site.
+  ///
+  /// When this is turned off, the proposals, rejections, forfeits, and
+  /// conclusions of those negotiations are ignored as soon as they arrive
+  /// instead of being converted and applied. A negotiator that gets added
+  /// partway through will only see the proposals that are made after it
+  /// joins. This only affects negotiations that begin after it is set. It is
+  /// turned on by default.
+  Negotiation& follow_unrelated_negotiations(bool follow);
+
+  /// Check whether unrelated negotiations are being followed.
+  bool follow_unrelated_negotiations() const;
+
+  /// The order in which the tables of a negotiation get responded to when
+  /// several of them are waiting for a response at the same time.
+  enum class TablePriority : uint8_t
+  {
+    /// The table that was discovered most recently goes first. This is the
+    /// default.
+    MostRecent,
+
+    /// The deepest table goes first, since it is the closest to concluding the
+    /// negotiation.
+    Depth,
+
+    /// The table whose proposals to accommodate start the soonest goes first,
+    /// since those robots are the closest to reaching the conflict. Tables
+    /// that are equally urgent are ordered by depth.
+    Deadline
+  };
+
+  /// Set the order in which waiting tables are responded to.
+  Negotiation& table_priority(TablePriority priority);
+
+  /// Get the order in which waiting tables are responded to.
+  TablePriority table_priority() const;
+
+  /// Choose whether to resolve negotiations whose participants all have
+  /// negotiators in this manager without waiting for their conclusion.
+  ///
+  /// The proposals and rejections of such a negotiation never leave this
+  /// process, but normally the participants still wait for the schedule node
+  /// to collect the proposals and publish a conclusion before they follow the
+  /// plans that were agreed on. When this is turned on, the first table that
+  /// completes the negotiation is approved right away, so the participants
+  /// can start on their new itineraries immediately. The proposals are still
+  /// published.
+  ///
+  /// If the conclusion picks the table that was approved, it is acknowledged
+  /// without approving it again. If it picks a different table, only the
+  /// participants whose part of the concluded table differs from the early
+  /// one get approved again, so the rest never switch plans twice. If the
+  /// negotiation fails, the early approval cannot be undone, so the failure
+  /// callbacks of the participants are triggered to make them replan, just
+  /// like for any other failed negotiation. This is turned off by default.
+  Negotiation& resolve_local_negotiations(bool resolve);
+
+  /// Check whether local negotiations get resolved without waiting for their
+  /// conclusion.
+  bool resolve_local_negotiations() const;
+
   /// Register a negotiator with this Negotiation manager.
   ///
   /// \param[in] for_participant
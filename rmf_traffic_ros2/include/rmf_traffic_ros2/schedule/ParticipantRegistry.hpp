@@ -91,6 +91,59 @@ private:
   rmf_utils::unique_impl_ptr<Implementation> _pimpl;
 };
 
+//=============================================================================
+/// Journal logger class. Appends each operation to the end of a file as a
+/// single line of JSON, so the cost of recording an operation does not depend
+/// on how many participants have been registered before it. The journal is
+/// periodically compacted so that only the latest description of each
+/// participant is kept.
+class JournalLogger : public AbstractParticipantLogger
+{
+public:
+
+  struct Options
+  {
+    /// Flush the journal to disk with fsync after this many operations have
+    /// been written. A value of 1 flushes after every operation, and a value of
+    /// 0 leaves flushing to the operating system.
+    std::size_t fsync_interval = 1;
+
+    /// Compact the journal when it holds more than this many times as many
+    /// records as there are unique participants.
+    double compaction_ratio = 2.0;
+
+    /// Never compact a journal that has fewer records than this.
+    std::size_t min_compaction_size = 64;
+  };
+
+  /// Constructor
+  /// Loads and logs to the specified file.
+  ///
+  /// \throws std::runtime_error if the file cannot be opened or a line of the
+  /// journal is not valid JSON. An invalid final line is assumed to be the
+  /// result of an interrupted write and is discarded instead.
+  ///
+  /// \throws YAML::ParserException if a record does not describe a valid
+  /// operation.
+  ///
+  /// \throws std::filesystem_error if there is no permission to create the
+  /// directory.
+  JournalLogger(std::string filename, Options options);
+
+  /// Constructor with default options
+  JournalLogger(std::string filename);
+
+  /// See AbstractParticipantLogger
+  void write_operation(AtomicOperation operation) override;
+
+  /// See AbstractParticipantLogger
+  std::optional<AtomicOperation> read_next_record() override;
+
+  class Implementation;
+private:
+  rmf_utils::unique_impl_ptr<Implementation> _pimpl;
+};
+
 //=============================================================================
 /// Adds a persistance layer to the participant ids. This allows the scheduler
 /// to restart without the need to restart fleet adapters.
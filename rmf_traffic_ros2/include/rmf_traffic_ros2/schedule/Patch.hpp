@@ -28,6 +28,15 @@ namespace rmf_traffic_ros2 {
 rmf_traffic_msgs::msg::SchedulePatch convert(
   const rmf_traffic::schedule::Patch& from);
 
+//==============================================================================
+/// Convert a Patch into an existing message. The participants, changes, and
+/// routes that the message already holds are overwritten in place, so a
+/// message that gets reused for every patch stops allocating once it has grown
+/// to fit the patches that are being sent.
+void convert(
+  const rmf_traffic::schedule::Patch& from,
+  rmf_traffic_msgs::msg::SchedulePatch& into);
+
 //==============================================================================
 rmf_traffic::schedule::Patch convert(
   const rmf_traffic_msgs::msg::SchedulePatch& from);
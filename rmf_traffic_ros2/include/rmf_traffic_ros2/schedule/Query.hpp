@@ -32,6 +32,13 @@ rmf_traffic::schedule::Query::Spacetime convert(
 rmf_traffic_msgs::msg::ScheduleQuerySpacetime convert(
   const rmf_traffic::schedule::Query::Spacetime& from);
 
+//==============================================================================
+/// Convert a Spacetime into an existing message. The regions and spaces that
+/// the message already holds are overwritten instead of being reallocated.
+void convert(
+  const rmf_traffic::schedule::Query::Spacetime& from,
+  rmf_traffic_msgs::msg::ScheduleQuerySpacetime& into);
+
 //==============================================================================
 rmf_traffic::schedule::Query::Participants convert(
   const rmf_traffic_msgs::msg::ScheduleQueryParticipants& from);
@@ -40,6 +47,13 @@ rmf_traffic::schedule::Query::Participants convert(
 rmf_traffic_msgs::msg::ScheduleQueryParticipants convert(
   const rmf_traffic::schedule::Query::Participants& from);
 
+//==============================================================================
+/// Convert a set of Participants into an existing message, reusing the memory
+/// of its ID list.
+void convert(
+  const rmf_traffic::schedule::Query::Participants& from,
+  rmf_traffic_msgs::msg::ScheduleQueryParticipants& into);
+
 //==============================================================================
 rmf_traffic::schedule::Query convert(
   const rmf_traffic_msgs::msg::ScheduleQuery& from);
@@ -48,6 +62,13 @@ rmf_traffic::schedule::Query convert(
 rmf_traffic_msgs::msg::ScheduleQuery convert(
   const rmf_traffic::schedule::Query& from);
 
+//==============================================================================
+/// Convert a Query into an existing message, reusing the memory that the
+/// message already holds.
+void convert(
+  const rmf_traffic::schedule::Query& from,
+  rmf_traffic_msgs::msg::ScheduleQuery& into);
+
 } // namespace rmf_traffic_ros2
 
 #endif // RMF_TRAFFIC_ROS2__SCHEDULE__QUERY_HPP
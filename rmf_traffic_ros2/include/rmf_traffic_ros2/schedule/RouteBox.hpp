@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TRAFFIC_ROS2__SCHEDULE__ROUTEBOX_HPP
+#define RMF_TRAFFIC_ROS2__SCHEDULE__ROUTEBOX_HPP
+
+#include <rmf_traffic/Profile.hpp>
+#include <rmf_traffic/Trajectory.hpp>
+
+#include <optional>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// A conservative spatio-temporal bounding box around a route.
+struct RouteBox
+{
+  double min_x;
+  double min_y;
+  double max_x;
+  double max_y;
+  rmf_traffic::Time start;
+  rmf_traffic::Time finish;
+
+  /// Returns true if this box overlaps the other box in both space and time.
+  bool overlaps(const RouteBox& other) const;
+};
+
+//==============================================================================
+/// Compute a RouteBox for the trajectory of a route. The box is inflated by
+/// the characteristic length of the profile, as well as a bound on how far the
+/// spline of each segment might deviate from its waypoints, so that it can be
+/// used as a conservative broad phase for rmf_traffic::DetectConflict: two
+/// routes whose boxes do not overlap can never be in conflict.
+///
+/// Returns std::nullopt if the trajectory is empty.
+std::optional<RouteBox> compute_box(
+  const rmf_traffic::Trajectory& trajectory,
+  const rmf_traffic::Profile& profile);
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // RMF_TRAFFIC_ROS2__SCHEDULE__ROUTEBOX_HPP
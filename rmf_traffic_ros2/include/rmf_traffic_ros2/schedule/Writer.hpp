@@ -84,6 +84,30 @@ public:
     rmf_traffic::schedule::ParticipantDescription description,
     std::function<void(rmf_traffic::schedule::Participant)> ready_callback);
 
+  /// Asynchronously create several schedule participants at once, such as
+  /// every robot of a fleet. All of the registrations are sent to the schedule
+  /// before any response is waited on.
+  ///
+  /// \param[in] descriptions
+  ///   The descriptions of the participants.
+  ///
+  /// \param[in] ready_callback
+  ///   The callback that will be triggered when every participant is ready.
+  ///   The participants are given in the same order as their descriptions.
+  void async_make_participants(
+    std::vector<rmf_traffic::schedule::ParticipantDescription> descriptions,
+    std::function<void(std::vector<rmf_traffic::schedule::Participant>)>
+    ready_callback);
+
+  /// When the schedule reports that at least this many itinerary changes of
+  /// a participant are missing, the writer sends one itinerary set that
+  /// replaces them instead of retransmitting each change. Use 0 to always
+  /// retransmit every missing change. The default is 20.
+  Writer& rectification_set_threshold(std::size_t threshold);
+
+  /// Get the current rectification set threshold
+  std::size_t rectification_set_threshold() const;
+
   class Implementation;
 private:
   Writer();
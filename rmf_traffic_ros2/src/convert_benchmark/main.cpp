@@ -0,0 +1,433 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark measures the heap allocations and the time per call of
+/// the rmf_traffic_ros2::convert functions, the YAML serialization of
+/// participant descriptions, and the persistence of the ParticipantRegistry.
+/// Each conversion to a message is measured twice:
+///  - returned: a new message is returned by every call
+///  - reused: the same message is converted into by every call
+///
+/// With --csv the results are printed as comma separated values with a fixed
+/// set of columns, so that the output of different runs can be compared.
+///
+/// Usage:
+///   convert_benchmark [--csv] [routes] [waypoints] [iterations] [site_map]
+
+#include <rmf_traffic_ros2/Profile.hpp>
+#include <rmf_traffic_ros2/Route.hpp>
+#include <rmf_traffic_ros2/Time.hpp>
+#include <rmf_traffic_ros2/Trajectory.hpp>
+#include <rmf_traffic_ros2/agv/Graph.hpp>
+#include <rmf_traffic_ros2/schedule/Change.hpp>
+#include <rmf_traffic_ros2/schedule/Itinerary.hpp>
+#include <rmf_traffic_ros2/schedule/ParticipantRegistry.hpp>
+#include <rmf_traffic_ros2/schedule/Patch.hpp>
+#include <rmf_traffic_ros2/schedule/Query.hpp>
+
+#include <rmf_traffic/geometry/Box.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+#include <rmf_traffic/schedule/Database.hpp>
+
+#include "../rmf_traffic_ros2/schedule/internal_YamlSerialization.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace {
+std::atomic_size_t allocation_count = 0;
+} // anonymous namespace
+
+//==============================================================================
+void* operator new(std::size_t size)
+{
+  ++allocation_count;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+//==============================================================================
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+//==============================================================================
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace {
+using namespace std::chrono_literals;
+using rmf_traffic::schedule::ParticipantDescription;
+
+bool csv_output = false;
+
+//==============================================================================
+rmf_traffic::Route make_route(
+  const std::size_t index,
+  const std::size_t num_waypoints)
+{
+  rmf_traffic::Trajectory trajectory;
+  auto time = rmf_traffic::Time(0s);
+  for (std::size_t w = 0; w < num_waypoints; ++w)
+  {
+    trajectory.insert(
+      time, Eigen::Vector3d(double(w), double(index), 0.0),
+      Eigen::Vector3d::Zero());
+    time += 1s;
+  }
+
+  return rmf_traffic::Route("test_map", std::move(trajectory));
+}
+
+//==============================================================================
+rmf_traffic::schedule::Itinerary make_itinerary(
+  const std::size_t num_routes,
+  const std::size_t num_waypoints)
+{
+  rmf_traffic::schedule::Itinerary itinerary;
+  for (std::size_t r = 0; r < num_routes; ++r)
+  {
+    itinerary.push_back(
+      std::make_shared<rmf_traffic::Route>(make_route(r, num_waypoints)));
+  }
+
+  return itinerary;
+}
+
+//==============================================================================
+rmf_traffic::Profile make_profile()
+{
+  using namespace rmf_traffic::geometry;
+  return rmf_traffic::Profile{
+    make_final_convex<Box>(1.0, 0.6),
+    make_final_convex<Circle>(1.2)
+  };
+}
+
+//==============================================================================
+ParticipantDescription make_description(const std::size_t index)
+{
+  return ParticipantDescription(
+    "participant_" + std::to_string(index),
+    "convert_benchmark",
+    ParticipantDescription::Rx::Responsive,
+    make_profile());
+}
+
+//==============================================================================
+rmf_traffic::schedule::Query make_query(const std::size_t num_regions)
+{
+  const auto shape =
+    rmf_traffic::geometry::make_final_convex<rmf_traffic::geometry::Circle>(
+    1.0);
+
+  std::vector<rmf_traffic::Region> regions;
+  for (std::size_t r = 0; r < num_regions; ++r)
+  {
+    Eigen::Isometry2d pose = Eigen::Isometry2d::Identity();
+    pose.translation() = Eigen::Vector2d(double(r), 0.0);
+    rmf_traffic::Region region("test_map", {{shape, pose}});
+    region.set_lower_time_bound(rmf_traffic::Time(0s));
+    region.set_upper_time_bound(rmf_traffic::Time(1h));
+    regions.push_back(std::move(region));
+  }
+
+  auto query = rmf_traffic::schedule::query_all();
+  query.spacetime() = rmf_traffic::schedule::Query::Spacetime(regions);
+  return query;
+}
+
+//==============================================================================
+rmf_traffic::schedule::Patch make_patch(
+  const std::size_t num_routes,
+  const std::size_t num_waypoints)
+{
+  rmf_traffic::schedule::Database database;
+  for (std::size_t p = 0; p < 10; ++p)
+  {
+    const auto participant =
+      database.register_participant(make_description(p)).id();
+
+    std::vector<rmf_traffic::Route> itinerary;
+    for (std::size_t r = 0; r < num_routes; ++r)
+      itinerary.push_back(make_route(r, num_waypoints));
+
+    database.set(participant, itinerary, 1);
+  }
+
+  return database.changes(rmf_traffic::schedule::query_all(), std::nullopt);
+}
+
+//==============================================================================
+rmf_site_map_msgs::msg::SiteMap load_site_map(const std::string& path)
+{
+  std::ifstream file(path);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string contents = buffer.str();
+
+  rmf_site_map_msgs::msg::SiteMap msg;
+  msg.encoding = msg.MAP_DATA_GEOJSON;
+  msg.data = {contents.begin(), contents.end()};
+  return msg;
+}
+
+//==============================================================================
+template<typename Function>
+void measure(
+  const std::string& name,
+  const std::size_t iterations,
+  const Function& function)
+{
+  const auto start_count = allocation_count.load();
+  const auto start_time = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    function(i);
+
+  const auto finish_time = std::chrono::steady_clock::now();
+  const auto allocations = allocation_count.load() - start_count;
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    finish_time - start_time).count();
+
+  const double allocations_per_call =
+    double(allocations) / double(iterations);
+  const double ns_per_call = double(ns) / double(iterations);
+
+  if (csv_output)
+  {
+    std::cout << name << "," << iterations << "," << allocations_per_call
+              << "," << ns_per_call << std::endl;
+    return;
+  }
+
+  std::cout << name << ": " << allocations_per_call << " allocations and "
+            << ns_per_call << " ns per call" << std::endl;
+}
+
+//==============================================================================
+template<typename Logger>
+void measure_registry(
+  const std::string& name,
+  const std::size_t iterations)
+{
+  using rmf_traffic_ros2::schedule::ParticipantRegistry;
+
+  const auto file = (std::filesystem::temp_directory_path()
+    / ("convert_benchmark_" + name)).string();
+  std::filesystem::remove(file);
+
+  std::vector<ParticipantDescription> descriptions;
+  descriptions.reserve(iterations);
+  for (std::size_t i = 0; i < iterations; ++i)
+    descriptions.push_back(make_description(i));
+
+  {
+    ParticipantRegistry registry(
+      std::make_unique<Logger>(file),
+      std::make_shared<rmf_traffic::schedule::Database>());
+
+    measure(name + " register", iterations, [&](std::size_t i)
+      {
+        (void)registry.add_or_retrieve_participant(descriptions[i]);
+      });
+
+    measure(name + " retrieve", iterations, [&](std::size_t i)
+      {
+        (void)registry.add_or_retrieve_participant(descriptions[i]);
+      });
+  }
+
+  // Loading replays every record that was written above
+  measure(name + " load", 1, [&](std::size_t)
+    {
+      ParticipantRegistry registry(
+        std::make_unique<Logger>(file),
+        std::make_shared<rmf_traffic::schedule::Database>());
+    });
+
+  std::filesystem::remove(file);
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  using rmf_traffic_ros2::convert;
+
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::string(argv[i]) == "--csv")
+      csv_output = true;
+    else
+      args.push_back(argv[i]);
+  }
+
+  const std::size_t num_routes = args.size() > 0 ? std::stoul(args[0]) : 2;
+  const std::size_t num_waypoints = args.size() > 1 ? std::stoul(args[1]) : 50;
+  const std::size_t iterations = args.size() > 2 ? std::stoul(args[2]) : 1000;
+  const std::string site_map = args.size() > 3 ?
+    args[3] : BENCHMARK_RESOURCES_DIR "/office_map.geojson";
+
+  if (csv_output)
+  {
+    std::cout << "name,iterations,allocations_per_call,ns_per_call"
+              << std::endl;
+  }
+  else
+  {
+    std::cout << "Routes of " << num_waypoints << " waypoints, "
+              << num_routes << " per itinerary, " << iterations
+              << " calls each" << std::endl;
+  }
+
+  const auto time = rmf_traffic::Time(1h);
+  const auto time_msg = convert(time);
+  measure("Time to message", iterations,
+    [&](std::size_t) { (void)convert(time); });
+  measure("Time from message", iterations,
+    [&](std::size_t) { (void)convert(time_msg); });
+
+  const auto route = make_route(0, num_waypoints);
+  const auto trajectory_msg = convert(route.trajectory());
+  const auto route_msg = convert(route);
+
+  measure("Trajectory to message (returned)", iterations,
+    [&](std::size_t) { (void)convert(route.trajectory()); });
+
+  rmf_traffic_msgs::msg::Trajectory reused_trajectory;
+  measure("Trajectory to message (reused)", iterations,
+    [&](std::size_t) { convert(route.trajectory(), reused_trajectory); });
+
+  measure("Trajectory from message", iterations,
+    [&](std::size_t) { (void)convert(trajectory_msg); });
+
+  measure("Route to message (returned)", iterations,
+    [&](std::size_t) { (void)convert(route); });
+
+  rmf_traffic_msgs::msg::Route reused_route;
+  measure("Route to message (reused)", iterations,
+    [&](std::size_t) { convert(route, reused_route); });
+
+  measure("Route from message", iterations,
+    [&](std::size_t) { (void)convert(route_msg); });
+
+  std::vector<rmf_traffic::Route> routes;
+  for (std::size_t r = 0; r < num_routes; ++r)
+    routes.push_back(make_route(r, num_waypoints));
+
+  measure("Routes to message (returned)", iterations,
+    [&](std::size_t) { (void)convert(routes); });
+
+  std::vector<rmf_traffic_msgs::msg::Route> reused_routes;
+  measure("Routes to message (reused)", iterations,
+    [&](std::size_t) { convert(routes, reused_routes); });
+
+  const std::vector<rmf_traffic::schedule::Itinerary> itineraries(
+    10, make_itinerary(num_routes, num_waypoints));
+  const auto itineraries_msg = convert(itineraries);
+  measure("Itineraries to message", iterations,
+    [&](std::size_t) { (void)convert(itineraries); });
+  measure("Itineraries from message", iterations,
+    [&](std::size_t) { (void)convert(itineraries_msg); });
+
+  const rmf_traffic::schedule::Change::Add::Item add_item{
+    0, std::make_shared<rmf_traffic::Route>(route)};
+  const auto add_msg = convert(add_item);
+  measure("Change::Add to message", iterations,
+    [&](std::size_t) { (void)convert(add_item); });
+  measure("Change::Add from message", iterations,
+    [&](std::size_t) { (void)convert(add_msg); });
+
+  const rmf_traffic::schedule::Change::Delay delay{10s};
+  const auto delay_msg = convert(delay);
+  measure("Change::Delay to message", iterations,
+    [&](std::size_t) { (void)convert(delay); });
+  measure("Change::Delay from message", iterations,
+    [&](std::size_t) { (void)convert(delay_msg); });
+
+  const auto query = make_query(num_routes);
+  const auto query_msg = convert(query);
+  measure("Query to message (returned)", iterations,
+    [&](std::size_t) { (void)convert(query); });
+
+  rmf_traffic_msgs::msg::ScheduleQuery reused_query;
+  measure("Query to message (reused)", iterations,
+    [&](std::size_t) { convert(query, reused_query); });
+
+  measure("Query from message", iterations,
+    [&](std::size_t) { (void)convert(query_msg); });
+
+  const auto patch = make_patch(num_routes, num_waypoints);
+  const auto patch_msg = convert(patch);
+  measure("Patch to message (returned)", iterations,
+    [&](std::size_t) { (void)convert(patch); });
+
+  rmf_traffic_msgs::msg::SchedulePatch reused_patch;
+  measure("Patch to message (reused)", iterations,
+    [&](std::size_t) { convert(patch, reused_patch); });
+
+  measure("Patch from message", iterations,
+    [&](std::size_t) { (void)convert(patch_msg); });
+
+  const auto profile = make_profile();
+  const auto profile_msg = convert(profile);
+  measure("Profile to message", iterations,
+    [&](std::size_t) { (void)convert(profile); });
+  measure("Profile from message", iterations,
+    [&](std::size_t) { (void)convert(profile_msg); });
+
+  const auto site_map_msg = load_site_map(site_map);
+  measure("Graph from site map", std::max<std::size_t>(1, iterations / 100),
+    [&](std::size_t) { (void)convert(site_map_msg); });
+
+  const auto description = make_description(0);
+  const auto description_yaml =
+    rmf_traffic_ros2::schedule::serialize(description);
+  measure("ParticipantDescription to YAML", iterations,
+    [&](std::size_t)
+    {
+      (void)rmf_traffic_ros2::schedule::serialize(description);
+    });
+  measure("ParticipantDescription from YAML", iterations,
+    [&](std::size_t)
+    {
+      (void)rmf_traffic_ros2::schedule::participant_description(
+        description_yaml);
+    });
+
+  measure_registry<rmf_traffic_ros2::schedule::YamlLogger>(
+    "YamlLogger", iterations);
+  measure_registry<rmf_traffic_ros2::schedule::JournalLogger>(
+    "JournalLogger", iterations);
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark measures how much work it takes to turn an itinerary
+/// update into the message that the schedule Writer publishes. It reports the
+/// number of heap allocations and the time per update for:
+///  - direct: converting every route each time, as the plain convert()
+///    functions do
+///  - cached (new routes): passing new routes through a RouteMessageCache
+///  - cached (repeated routes): passing the same routes through the cache
+///    again, as happens when an itinerary is set to routes it already had
+///
+/// Usage: itinerary_benchmark [routes] [waypoints] [iterations]
+
+#include <rmf_traffic_ros2/schedule/Writer.hpp>
+
+#include <rmf_traffic_msgs/msg/itinerary_set.hpp>
+
+#include "../rmf_traffic_ros2/schedule/internal_RouteMessageCache.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+std::atomic_size_t allocation_count = 0;
+} // anonymous namespace
+
+//==============================================================================
+void* operator new(std::size_t size)
+{
+  ++allocation_count;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+//==============================================================================
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+//==============================================================================
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace {
+using Input = rmf_traffic::schedule::Writer::Input;
+using Set = rmf_traffic_msgs::msg::ItinerarySet;
+
+//==============================================================================
+Input make_input(
+  const std::size_t num_routes,
+  const std::size_t num_waypoints)
+{
+  using namespace std::chrono_literals;
+  Input input;
+  for (std::size_t r = 0; r < num_routes; ++r)
+  {
+    rmf_traffic::Trajectory trajectory;
+    auto time = rmf_traffic::Time(0s);
+    for (std::size_t w = 0; w < num_waypoints; ++w)
+    {
+      trajectory.insert(
+        time, Eigen::Vector3d(double(w), double(r), 0.0),
+        Eigen::Vector3d::Zero());
+      time += 1s;
+    }
+
+    input.push_back(
+      {r, std::make_shared<rmf_traffic::Route>(
+          "test_map", std::move(trajectory))});
+  }
+
+  return input;
+}
+
+//==============================================================================
+template<typename Build>
+void measure(
+  const std::string& name,
+  const std::size_t iterations,
+  const Build& build)
+{
+  const auto start_count = allocation_count.load();
+  const auto start_time = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+  {
+    Set msg = build(i);
+    (void)msg;
+  }
+
+  const auto finish_time = std::chrono::steady_clock::now();
+  const auto allocations = allocation_count.load() - start_count;
+  const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+    finish_time - start_time).count();
+
+  std::cout << name << ": "
+            << double(allocations) / double(iterations)
+            << " allocations and "
+            << double(us) / double(iterations)
+            << " us per update" << std::endl;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  const std::size_t num_routes = argc > 1 ? std::stoul(argv[1]) : 2;
+  const std::size_t num_waypoints = argc > 2 ? std::stoul(argv[2]) : 50;
+  const std::size_t iterations = argc > 3 ? std::stoul(argv[3]) : 1000;
+
+  std::cout << "Itineraries of " << num_routes << " routes with "
+            << num_waypoints << " waypoints each, " << iterations
+            << " updates" << std::endl;
+
+  const auto input = make_input(num_routes, num_waypoints);
+
+  measure(
+    "direct", iterations, [&](std::size_t)
+    {
+      Set msg;
+      msg.itinerary = rmf_traffic_ros2::convert(input);
+      return msg;
+    });
+
+  // Build the new inputs ahead of time so their construction is not counted
+  std::vector<Input> new_inputs;
+  new_inputs.reserve(iterations);
+  for (std::size_t i = 0; i < iterations; ++i)
+    new_inputs.push_back(make_input(num_routes, num_waypoints));
+
+  rmf_traffic_ros2::schedule::RouteMessageCache cache;
+  measure(
+    "cached (new routes)", iterations, [&](std::size_t i)
+    {
+      Set msg;
+      msg.itinerary = cache.convert(new_inputs[i]);
+      return msg;
+    });
+
+  measure(
+    "cached (repeated routes)", iterations, [&](std::size_t)
+    {
+      Set msg;
+      msg.itinerary = cache.convert(input);
+      return msg;
+    });
+
+  return 0;
+}
@@ -28,6 +28,9 @@
 #include <rmf_traffic_msgs/msg/blockade_set.hpp>
 #include <rmf_traffic_msgs/msg/blockade_status.hpp>
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace rmf_traffic_ros2 {
 namespace blockade {
 
@@ -94,11 +97,33 @@ public:
       BlockadeHeartbeatTopicName,
       rclcpp::SystemDefaultsQoS().reliable());
 
+    heartbeat_delta_pub = create_publisher<HeartbeatMsg>(
+      BlockadeHeartbeatDeltaTopicName,
+      rclcpp::SystemDefaultsQoS().reliable());
+
+    // Robots tend to reach their checkpoints in bursts, so changes to the
+    // assignments are published at most once per this many milliseconds. Use
+    // 0 to publish after every update.
+    declare_parameter<int>("status_publish_interval", 10);
+    status_publish_interval = std::chrono::milliseconds(
+      std::max<int64_t>(0, get_parameter("status_publish_interval").as_int()));
+
+    status_publish_timer = create_wall_timer(
+      std::max(status_publish_interval, std::chrono::milliseconds(1)),
+      [this]()
+      {
+        status_publish_timer->cancel();
+        this->publish_status(false);
+      });
+    status_publish_timer->cancel();
+
+    // The full heartbeat lets every writer resynchronize, in case it missed
+    // some of the deltas.
     heartbeat_timer = create_wall_timer(
       std::chrono::seconds(1),
       [this]()
       {
-        this->publish_status();
+        this->publish_status(true);
       });
   }
 
@@ -212,43 +237,111 @@ public:
       return;
 
     last_assignment_version = current_version;
-    publish_status();
+    if (status_publish_interval.count() == 0)
+    {
+      publish_status(false);
+      return;
+    }
+
+    // Every update that arrives before the timer fires gets published along
+    // with this one
+    if (status_publish_timer->is_canceled())
+      status_publish_timer->reset();
   }
 
+  std::chrono::milliseconds status_publish_interval =
+    std::chrono::milliseconds(10);
+  rclcpp::TimerBase::SharedPtr status_publish_timer;
+
   using HeartbeatMsg = rmf_traffic_msgs::msg::BlockadeHeartbeat;
   rclcpp::Publisher<HeartbeatMsg>::SharedPtr heartbeat_pub;
+  rclcpp::Publisher<HeartbeatMsg>::SharedPtr heartbeat_delta_pub;
   using StatusMsg = rmf_traffic_msgs::msg::BlockadeStatus;
-  void publish_status()
+
+  /// Publish the status of the participants. Unless full is true, only the
+  /// statuses that changed since the last publication get sent, over the
+  /// delta topic.
+  void publish_status(bool full)
   {
+    // Any pending delta is covered by this publication
+    status_publish_timer->cancel();
+
     const auto& ranges = moderator->assignments().ranges();
 
-    std::vector<StatusMsg> statuses;
+    std::unordered_map<std::size_t, StatusMsg> current;
+    current.reserve(moderator->statuses().size());
     for (const auto& s : moderator->statuses())
     {
       const std::size_t participant = s.first;
       const auto& range = ranges.at(participant);
       const auto& status = s.second;
 
-      statuses.emplace_back(
-        rmf_traffic_msgs::build<StatusMsg>()
-        .participant(participant)
-        .reservation(status.reservation)
-        .any_ready(status.last_ready.has_value())
-        .last_ready(status.last_ready.value_or(0))
-        .last_reached(status.last_reached)
-        .assignment_begin(range.begin)
-        .assignment_end(range.end));
+      current.insert(
+        {
+          participant,
+          rmf_traffic_msgs::build<StatusMsg>()
+          .participant(participant)
+          .reservation(status.reservation)
+          .any_ready(status.last_ready.has_value())
+          .last_ready(status.last_ready.value_or(0))
+          .last_reached(status.last_reached)
+          .assignment_begin(range.begin)
+          .assignment_end(range.end)
+        });
+    }
+
+    const bool has_gridlock = moderator->has_gridlock();
+    std::vector<StatusMsg> statuses;
+    if (!full)
+    {
+      // A delta can only describe participants that still have a status, so
+      // any removal has to be announced by a full heartbeat.
+      for (const auto& [participant, _] : last_published)
+      {
+        if (current.count(participant) == 0)
+        {
+          full = true;
+          break;
+        }
+      }
+    }
+
+    if (!full)
+    {
+      for (const auto& [participant, status] : current)
+      {
+        const auto it = last_published.find(participant);
+        if (it == last_published.end() || !(it->second == status))
+          statuses.push_back(status);
+      }
+
+      if (statuses.empty() && has_gridlock == last_gridlock)
+        return;
+    }
+    else
+    {
+      statuses.reserve(current.size());
+      for (const auto& [_, status] : current)
+        statuses.push_back(status);
     }
 
     auto msg = rmf_traffic_msgs::build<HeartbeatMsg>()
       .statuses(std::move(statuses))
-      .has_gridlock(moderator->has_gridlock());
+      .has_gridlock(has_gridlock);
+
+    if (full)
+      heartbeat_pub->publish(msg);
+    else
+      heartbeat_delta_pub->publish(msg);
 
-    heartbeat_pub->publish(msg);
+    last_published = std::move(current);
+    last_gridlock = has_gridlock;
   }
 
   std::shared_ptr<rmf_traffic::blockade::Moderator> moderator;
   std::size_t last_assignment_version = 0;
+  std::unordered_map<std::size_t, StatusMsg> last_published;
+  bool last_gridlock = false;
   rclcpp::TimerBase::SharedPtr heartbeat_timer;
 };
 
@@ -25,6 +25,7 @@
 #include <rmf_traffic_msgs/msg/blockade_release.hpp>
 #include <rmf_traffic_msgs/msg/blockade_set.hpp>
 
+#include <list>
 #include <unordered_set>
 
 namespace rmf_traffic_ros2 {
@@ -44,6 +45,16 @@ public:
 
   struct RectifierStub;
 
+  /// The stubs report here when they get destroyed, so we never need to sweep
+  /// through all of them to find out which participants have died. This has
+  /// its own mutex because a stub may be destroyed while the factory_mutex is
+  /// held.
+  struct Obituaries
+  {
+    std::mutex mutex;
+    std::vector<ParticipantId> participants;
+  };
+
   class Requester : public rmf_traffic::blockade::RectificationRequester
   {
   public:
@@ -52,13 +63,14 @@ public:
 
     Requester(
       rmf_traffic::blockade::Rectifier rectifier,
-      NewRangeCallback callback)
+      NewRangeCallback callback,
+      ParticipantId participant,
+      std::weak_ptr<Obituaries> obituaries)
     : stub(std::make_shared<RectifierStub>(
-          RectifierStub{
-            std::move(rectifier),
-            std::nullopt,
-            std::move(callback)
-          }))
+          std::move(rectifier),
+          std::move(callback),
+          participant,
+          std::move(obituaries)))
     {
       // Do nothing
     }
@@ -70,21 +82,61 @@ public:
     rmf_traffic::blockade::Rectifier rectifier;
     std::optional<ReservationId> last_reservation_id;
     NewRangeCallback range_cb;
+    ParticipantId participant;
+    std::weak_ptr<Obituaries> obituaries;
+
+    RectifierStub(
+      rmf_traffic::blockade::Rectifier rectifier_,
+      NewRangeCallback range_cb_,
+      ParticipantId participant_,
+      std::weak_ptr<Obituaries> obituaries_)
+    : rectifier(std::move(rectifier_)),
+      range_cb(std::move(range_cb_)),
+      participant(participant_),
+      obituaries(std::move(obituaries_))
+    {
+      // Do nothing
+    }
+
+    RectifierStub(const RectifierStub&) = delete;
+    RectifierStub& operator=(const RectifierStub&) = delete;
+
+    ~RectifierStub()
+    {
+      if (const auto o = obituaries.lock())
+      {
+        std::lock_guard<std::mutex> lock(o->mutex);
+        o->participants.push_back(participant);
+      }
+    }
   };
 
-  using StubMap = std::unordered_map<
-    rmf_traffic::blockade::ParticipantId,
-    std::weak_ptr<RectifierStub>
-  >;
+  /// The stubs are ordered by the last full heartbeat that mentioned them, with
+  /// the least recently mentioned at the front, so the stubs that a full
+  /// heartbeat left out can be found without looking at any of the others.
+  using SeenOrder = std::list<ParticipantId>;
+
+  struct StubEntry
+  {
+    std::weak_ptr<RectifierStub> stub;
+    uint64_t last_seen;
+    SeenOrder::iterator order;
+  };
+
+  using StubMap = std::unordered_map<ParticipantId, StubEntry>;
 
   std::weak_ptr<rmf_traffic::blockade::Writer> weak_writer;
   StubMap stub_map;
+  SeenOrder seen_order;
+  uint64_t full_heartbeat_count = 0;
+  std::shared_ptr<Obituaries> obituaries = std::make_shared<Obituaries>();
   std::unordered_set<ParticipantId> dead_set;
 
   std::unordered_map<ParticipantId, NewRangeCallback> pending_callbacks;
 
   using HeartbeatMsg = rmf_traffic_msgs::msg::BlockadeHeartbeat;
   rclcpp::Subscription<HeartbeatMsg>::SharedPtr heartbeat_sub;
+  rclcpp::Subscription<HeartbeatMsg>::SharedPtr heartbeat_delta_sub;
 
   // NOTE(MXG): Because of some awkwardness in the design of the rectification
   // factory, we can only allow one participant to be constructed at a time.
@@ -104,7 +156,15 @@ public:
       rclcpp::SystemDefaultsQoS().reliable(),
       [&](const HeartbeatMsg::UniquePtr msg)
       {
-        check_status(*msg);
+        check_status(*msg, true);
+      });
+
+    heartbeat_delta_sub = node.create_subscription<HeartbeatMsg>(
+      BlockadeHeartbeatDeltaTopicName,
+      rclcpp::SystemDefaultsQoS().reliable(),
+      [&](const HeartbeatMsg::UniquePtr msg)
+      {
+        check_status(*msg, false);
       });
   }
 
@@ -119,28 +179,54 @@ public:
     assert(pending_callbacks.empty());
 
     auto requester = std::make_unique<Requester>(
-      std::move(rectifier), std::move(callback));
+      std::move(rectifier), std::move(callback),
+      participant_id, obituaries);
 
-    stub_map.insert({participant_id, requester->stub});
+    const auto s_it = stub_map.find(participant_id);
+    if (s_it != stub_map.end())
+    {
+      s_it->second.stub = requester->stub;
+      s_it->second.last_seen = full_heartbeat_count;
+      seen_order.splice(seen_order.end(), seen_order, s_it->second.order);
+    }
+    else
+    {
+      stub_map.insert(
+        {
+          participant_id,
+          StubEntry{
+            requester->stub,
+            full_heartbeat_count,
+            seen_order.insert(seen_order.end(), participant_id)
+          }
+        });
+    }
 
     return requester;
   }
 
   void bring_out_your_dead()
   {
-    auto s_it = stub_map.begin();
-    while (s_it != stub_map.end())
+    std::vector<ParticipantId> deceased;
     {
-      const auto stub = s_it->second.lock();
-      if (stub)
-      {
-        ++s_it;
-      }
-      else
-      {
-        dead_set.insert(s_it->first);
-        stub_map.erase(s_it++);
-      }
+      std::lock_guard<std::mutex> lock(obituaries->mutex);
+      deceased.swap(obituaries->participants);
+    }
+
+    for (const auto participant : deceased)
+    {
+      const auto s_it = stub_map.find(participant);
+      if (s_it == stub_map.end())
+        continue;
+
+      // The participant may have been recreated since the obituary was
+      // written.
+      if (!s_it->second.stub.expired())
+        continue;
+
+      dead_set.insert(participant);
+      seen_order.erase(s_it->second.order);
+      stub_map.erase(s_it);
     }
   }
 
@@ -165,7 +251,11 @@ public:
     return range;
   }
 
-  void check_status(const HeartbeatMsg& heartbeat)
+  /// Check the statuses of a heartbeat. A full heartbeat describes every
+  /// participant, so any of our participants that it leaves out must not have
+  /// a reservation. A delta only describes the participants that have changed,
+  /// so it can be applied in proportion to the number of changes.
+  void check_status(const HeartbeatMsg& heartbeat, const bool full)
   {
     const auto writer = weak_writer.lock();
     if (!writer)
@@ -173,13 +263,18 @@ public:
 
     std::unique_lock<std::mutex> lock(factory_mutex);
 
-    bring_out_your_dead();
     std::unordered_set<rmf_traffic::blockade::ParticipantId> not_dead_yet;
+    if (full)
+    {
+      // Dead participants only get cleaned up by full heartbeats, so that the
+      // cancellation of their reservations is resent at a steady rate.
+      bring_out_your_dead();
+      ++full_heartbeat_count;
+    }
 
-    auto stub_map_copy = stub_map;
     for (const auto& status : heartbeat.statuses)
     {
-      const auto it = stub_map_copy.find(status.participant);
+      const auto it = stub_map.find(status.participant);
       if (it == stub_map.end())
       {
         const auto d_it = dead_set.find(status.participant);
@@ -192,7 +287,15 @@ public:
         continue;
       }
 
-      const auto stub = it->second.lock();
+      // Only a full heartbeat gets to decide which of the remaining stubs
+      // have no reservation.
+      if (full)
+      {
+        it->second.last_seen = full_heartbeat_count;
+        seen_order.splice(seen_order.end(), seen_order, it->second.order);
+      }
+
+      const auto stub = it->second.stub.lock();
       if (!stub)
       {
         // We hit a race condition where this stub died just moments after we
@@ -207,15 +310,20 @@ public:
       const auto range = get_range(status);
       stub->last_reservation_id = status.reservation;
       stub->range_cb(status.reservation, range);
-
-      stub_map_copy.erase(it);
     }
 
-    for (const auto& s : stub_map_copy)
+    if (!full)
+      return;
+
+    for (const auto participant : seen_order)
     {
+      const auto& entry = stub_map.at(participant);
+      if (entry.last_seen == full_heartbeat_count)
+        break;
+
       // Check on the remaining stubs to make sure they shouldn't have any
       // active reservations.
-      const auto stub = s.second.lock();
+      const auto stub = entry.stub.lock();
       if (!stub)
       {
         // We hit a race condition where this stub died just moments after we
@@ -127,6 +127,189 @@ rmf_traffic::agv::Graph convert(const rmf_site_map_msgs::msg::SiteMap& from,
   }
 }
 
+namespace {
+//==============================================================================
+// The parts of an rmf_vertex feature that the graph needs
+struct VertexFeature
+{
+  // GeoJSON always encodes coordinates as (lon, lat)
+  double lon;
+  double lat;
+  std::string name;
+  int level_idx;
+  std::optional<bool> is_holding_point;
+  std::optional<bool> is_passthrough_point;
+  std::optional<bool> is_parking_spot;
+  std::optional<bool> is_charger;
+};
+
+//==============================================================================
+// The parts of an rmf_lane feature that the graph needs
+struct LaneFeature
+{
+  double lon_0;
+  double lat_0;
+  double lon_1;
+  double lat_1;
+  int level_idx;
+  bool is_bidirectional;
+  std::optional<double> speed_limit;
+  std::optional<std::string> dock_name;
+};
+
+//==============================================================================
+std::optional<bool> optional_flag(
+  const nlohmann::json& properties,
+  const std::string& key)
+{
+  if (properties.contains(key))
+    return properties[key].get<bool>();
+
+  return std::nullopt;
+}
+
+//==============================================================================
+// Check the geometry of a feature and return its coordinates array if it has
+// the expected type and at least two coordinates
+const nlohmann::json* feature_coordinates(
+  const nlohmann::json& feature,
+  const std::string& expected_type)
+{
+  if (!feature.contains("geometry") || !feature["geometry"].is_object())
+    return nullptr;
+  const auto& geom = feature["geometry"];
+  if (!geom.contains("type") || !geom["type"].is_string())
+    return nullptr;
+  if (geom["type"] != expected_type)
+    return nullptr;
+  if (!geom.contains("coordinates") || !geom["coordinates"].is_array())
+    return nullptr;
+  if (geom["coordinates"].size() < 2)
+    return nullptr;
+
+  return &geom["coordinates"];
+}
+
+//==============================================================================
+// Collects the vertices and lanes of a GeoJSON site map while it is being
+// parsed. Each feature is boiled down to the few fields that the graph needs
+// and then discarded, so the document never has to be held in memory as a
+// whole, even for site maps with a lot of street-level detail.
+class FeatureCollector
+{
+public:
+
+  FeatureCollector(int graph_idx)
+  : _graph_idx(graph_idx)
+  {
+    // Do nothing
+  }
+
+  bool operator()(
+    const int depth,
+    const nlohmann::json::parse_event_t event,
+    nlohmann::json& parsed)
+  {
+    using Event = nlohmann::json::parse_event_t;
+    if (depth == 1 && event == Event::key)
+    {
+      _top_level_key = parsed.is_string() ? parsed.get<std::string>() : "";
+      return true;
+    }
+
+    if (depth == 2 && event == Event::object_end
+      && _top_level_key == "features")
+    {
+      collect(parsed);
+      // Returning false drops the feature from the document
+      return false;
+    }
+
+    return true;
+  }
+
+  std::vector<VertexFeature> vertices;
+  std::vector<LaneFeature> lanes;
+
+private:
+
+  void collect(const nlohmann::json& feature)
+  {
+    const std::string feature_type = feature.value("feature_type", "");
+    if (feature_type == "rmf_vertex")
+      collect_vertex(feature);
+    else if (feature_type == "rmf_lane")
+      collect_lane(feature);
+  }
+
+  void collect_vertex(const nlohmann::json& feature)
+  {
+    // sanity check the object structure
+    if (!feature.contains("properties") || !feature["properties"].is_object())
+      return;
+
+    const auto* coordinates = feature_coordinates(feature, "Point");
+    if (!coordinates)
+      return;
+
+    const auto& properties = feature["properties"];
+    vertices.push_back(
+      VertexFeature{
+        (*coordinates)[0].get<double>(),
+        (*coordinates)[1].get<double>(),
+        properties.value("name", ""),
+        properties.value("level_idx", 0),
+        optional_flag(properties, "is_holding_point"),
+        optional_flag(properties, "is_passthrough_point"),
+        optional_flag(properties, "is_parking_spot"),
+        optional_flag(properties, "is_charger")
+      });
+  }
+
+  void collect_lane(const nlohmann::json& feature)
+  {
+    if (!feature.contains("properties") || !feature["properties"].is_object())
+      return;
+
+    const auto* coordinates = feature_coordinates(feature, "LineString");
+    if (!coordinates)
+      return;
+
+    const auto& properties = feature["properties"];
+    if (properties.contains("graph_idx"))
+    {
+      const int lane_graph_idx = properties["graph_idx"];
+      if (lane_graph_idx != _graph_idx)
+        return;
+    }
+
+    std::optional<double> speed_limit;
+    if (properties.contains("speed_limit"))
+      speed_limit = properties["speed_limit"].get<double>();
+
+    std::optional<std::string> dock_name;
+    if (properties.contains("dock_name"))
+      dock_name = properties["dock_name"].get<std::string>();
+
+    lanes.push_back(
+      LaneFeature{
+        (*coordinates)[0][0].get<double>(),
+        (*coordinates)[0][1].get<double>(),
+        (*coordinates)[1][0].get<double>(),
+        (*coordinates)[1][1].get<double>(),
+        properties.value("level_idx", 0),
+        properties.value("bidirectional", false),
+        speed_limit,
+        std::move(dock_name)
+      });
+  }
+
+  int _graph_idx;
+  std::string _top_level_key;
+};
+} // anonymous namespace
+
+//==============================================================================
 rmf_traffic::agv::Graph json_to_graph(
   const std::vector<uint8_t>& json_doc,
   const int graph_idx,
@@ -134,8 +317,19 @@ rmf_traffic::agv::Graph json_to_graph(
 {
   rmf_traffic::agv::Graph graph;
   std::cout << "json_to_graph with doc length " << json_doc.size() << std::endl;
-  nlohmann::json j = nlohmann::json::parse(json_doc);
-  std::cout << "parsed " << j.size() << "entries in json" << std::endl;
+
+  // The features get collected and discarded while the document is parsed,
+  // so j only keeps the top-level fields and an empty features array.
+  FeatureCollector collector(graph_idx);
+  nlohmann::json j = nlohmann::json::parse(
+    json_doc.begin(), json_doc.end(),
+    [&collector](
+      int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed)
+    {
+      return collector(depth, event, parsed);
+    });
+  std::cout << "parsed " << collector.vertices.size() << " vertices and "
+            << collector.lanes.size() << " lanes in json" << std::endl;
 
   const auto preferred_crs_it = j.find("preferred_crs");
   if (preferred_crs_it == j.end() || !preferred_crs_it->is_string())
@@ -162,9 +356,6 @@ rmf_traffic::agv::Graph json_to_graph(
   }
   const std::string site_name = *site_name_it;
 
-  CoordsIdxHashMap idx_map;
-
-  // spin through features and find all vertices
   PJ_CONTEXT* proj_context = proj_context_create();
   PJ* projector = proj_create_crs_to_crs(
     proj_context,
@@ -174,136 +365,99 @@ rmf_traffic::agv::Graph json_to_graph(
   if (!projector)
   {
     std::cout << "unable to create coordinate projector!" << std::endl;
+    proj_context_destroy(proj_context);
     return graph;
   }
 
-  for (const auto& feature : j["features"])
+  // Project every coordinate in one batch. The vertices come first, followed
+  // by the two ends of each lane. EPSG:4326 takes its axes as (lat, lon).
+  const auto& vertices = collector.vertices;
+  const auto& lanes = collector.lanes;
+  const std::size_t num_coords = vertices.size() + 2*lanes.size();
+  std::vector<double> xs;
+  std::vector<double> ys;
+  xs.reserve(num_coords);
+  ys.reserve(num_coords);
+  for (const auto& v : vertices)
   {
-    const std::string feature_type = feature["feature_type"];
-    if (feature_type != "rmf_vertex")
-      continue;
-
-    // sanity check the object structure
-    if (!feature.contains("properties") || !feature["properties"].is_object())
-      continue;
-    if (!feature.contains("geometry") || !feature["geometry"].is_object())
-      continue;
-    const auto& geom = feature["geometry"];
-    if (!geom.contains("type") || !geom["type"].is_string())
-      continue;
-    if (geom["type"] != "Point")
-      continue;
-    if (!geom.contains("coordinates") || !geom["coordinates"].is_array())
-      continue;
-    if (geom["coordinates"].size() < 2)
-      continue;
-
-    // GeoJSON always encodes coordinates as (lon, lat)
-    const double lon = geom["coordinates"][0];
-    const double lat = geom["coordinates"][1];
-
-    std::string name = feature["properties"].value("name", "");
+    xs.push_back(v.lat);
+    ys.push_back(v.lon);
+  }
 
-    int level_idx = feature["properties"].value("level_idx", 0);
+  for (const auto& l : lanes)
+  {
+    xs.push_back(l.lat_0);
+    ys.push_back(l.lon_0);
+    xs.push_back(l.lat_1);
+    ys.push_back(l.lon_1);
+  }
 
-    // todo: parse other parameters here
+  if (num_coords > 0)
+  {
+    proj_trans_generic(
+      projector, PJ_FWD,
+      xs.data(), sizeof(double), num_coords,
+      ys.data(), sizeof(double), num_coords,
+      nullptr, 0, 0,
+      nullptr, 0, 0);
+  }
 
-    const PJ_COORD wgs84_coord = proj_coord(lat, lon, 0, 0);
-    const PJ_COORD p = proj_trans(projector, PJ_FWD, wgs84_coord);
+  proj_destroy(projector);
+  proj_context_destroy(proj_context);
 
-    // not sure why the coordinate-flip is required, but... it is.
-    const double easting = p.enu.n;
-    const double northing = p.enu.e;
+  // not sure why the coordinate-flip is required, but... it is.
+  // maybe can use proj_normalize_for_visualization someday?
+  const auto projected = [&xs, &ys](const std::size_t i)
+    {
+      return Eigen::Vector2d{ys[i], xs[i]};
+    };
 
-    const Eigen::Vector2d location{easting, northing};
+  // Usage map[level_idx][truncated_x][truncated_y] = id;
+  CoordsIdxHashMap idx_map;
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    const auto& v = vertices[i];
+    const Eigen::Vector2d location = projected(i);
 
     auto& wp = graph.add_waypoint(site_name, location);
 
-    if (name.size() > 0 && !graph.add_key(name, wp.index()))
+    if (v.name.size() > 0 && !graph.add_key(v.name, wp.index()))
     {
       throw std::runtime_error(
-              "Duplicated waypoint name [" + name + "]");
+              "Duplicated waypoint name [" + v.name + "]");
     }
 
-    double rounded_x = std::round(easting / wp_tolerance) * wp_tolerance;
-    double rounded_y = std::round(northing / wp_tolerance) * wp_tolerance;
-    idx_map[level_idx][rounded_x][rounded_y] = wp.index();
+    double rounded_x = std::round(location.x() / wp_tolerance) * wp_tolerance;
+    double rounded_y = std::round(location.y() / wp_tolerance) * wp_tolerance;
+    idx_map[v.level_idx][rounded_x][rounded_y] = wp.index();
 
     // Set waypoint properties
-    if (feature["properties"].contains("is_holding_point"))
-      wp.set_holding_point(feature["properties"]["is_holding_point"]);
-    if (feature["properties"].contains("is_passthrough_point"))
-      wp.set_passthrough_point(feature["properties"]["is_passthrough_point"]);
-    if (feature["properties"].contains("is_parking_spot"))
-      wp.set_parking_spot(feature["properties"]["is_parking_spot"]);
-    if (feature["properties"].contains("is_charger"))
-      wp.set_charger(feature["properties"]["is_charger"]);
+    if (v.is_holding_point.has_value())
+      wp.set_holding_point(*v.is_holding_point);
+    if (v.is_passthrough_point.has_value())
+      wp.set_passthrough_point(*v.is_passthrough_point);
+    if (v.is_parking_spot.has_value())
+      wp.set_parking_spot(*v.is_parking_spot);
+    if (v.is_charger.has_value())
+      wp.set_charger(*v.is_charger);
   }
 
-  // now spin through the features again, looking for lanes
-  for (const auto& feature : j["features"])
+  for (std::size_t i = 0; i < lanes.size(); ++i)
   {
-    const std::string feature_type = feature["feature_type"];
-    if (feature_type != "rmf_lane")
-      continue;
+    const auto& l = lanes[i];
+    const Eigen::Vector2d p0 = projected(vertices.size() + 2*i);
+    const Eigen::Vector2d p1 = projected(vertices.size() + 2*i + 1);
 
-    if (!feature.contains("geometry") || !feature["geometry"].is_object())
-      continue;
-    const auto& geom = feature["geometry"];
-    if (!geom.contains("type") || !geom["type"].is_string())
-      continue;
-    if (geom["type"] != "LineString")
-      continue;
-    if (!geom.contains("coordinates") || !geom["coordinates"].is_array())
-      continue;
-    if (geom["coordinates"].size() < 2)
-      continue;
-
-    if (feature["properties"].contains("graph_idx"))
-    {
-      const int lane_graph_idx = feature["properties"]["graph_idx"];
-      if (lane_graph_idx != graph_idx)
-        continue;
-    }
-
-    int level_idx = feature["properties"].value("level_idx", 0);
-    bool is_bidirectional = feature["properties"].value("bidirectional", false);
+    const double rounded_x0 = std::round(p0.x() / wp_tolerance) * wp_tolerance;
+    const double rounded_y0 = std::round(p0.y() / wp_tolerance) * wp_tolerance;
+    const double rounded_x1 = std::round(p1.x() / wp_tolerance) * wp_tolerance;
+    const double rounded_y1 = std::round(p1.y() / wp_tolerance) * wp_tolerance;
 
-    std::optional<double> speed_limit;
-    if (feature["properties"].contains("speed_limit"))
-      speed_limit = feature["properties"]["speed_limit"];
-
-    std::optional<std::string> dock_name;
-    if (feature["properties"].contains("dock_name"))
-      dock_name = feature["properties"]["dock_name"];
-
-    const double lon_0 = geom["coordinates"][0][0];
-    const double lat_0 = geom["coordinates"][0][1];
-    const double lon_1 = geom["coordinates"][1][0];
-    const double lat_1 = geom["coordinates"][1][1];
-
-    const PJ_COORD wgs84_coord_0 = proj_coord(lat_0, lon_0, 0, 0);
-    const PJ_COORD wgs84_coord_1 = proj_coord(lat_1, lon_1, 0, 0);
-    const PJ_COORD p0 = proj_trans(projector, PJ_FWD, wgs84_coord_0);
-    const PJ_COORD p1 = proj_trans(projector, PJ_FWD, wgs84_coord_1);
-
-    // not sure why the coordinate-flip is required, but... it is.
-    // maybe can use proj_normalize_for_visualization someday?
-    const double x0 = p0.enu.n;
-    const double y0 = p0.enu.e;
-    const double x1 = p1.enu.n;
-    const double y1 = p1.enu.e;
-
-    const double rounded_x0 = std::round(x0 / wp_tolerance) * wp_tolerance;
-    const double rounded_y0 = std::round(y0 / wp_tolerance) * wp_tolerance;
-    const double rounded_x1 = std::round(x1 / wp_tolerance) * wp_tolerance;
-    const double rounded_y1 = std::round(y1 / wp_tolerance) * wp_tolerance;
-
-    auto m0_iter = idx_map[level_idx][rounded_x0].find(rounded_y0);
-    if (m0_iter == idx_map[level_idx][rounded_x0].end())
+    auto m0_iter = idx_map[l.level_idx][rounded_x0].find(rounded_y0);
+    if (m0_iter == idx_map[l.level_idx][rounded_x0].end())
       continue;
-    auto m1_iter = idx_map[level_idx][rounded_x1].find(rounded_y1);
-    if (m1_iter == idx_map[level_idx][rounded_x1].end())
+    auto m1_iter = idx_map[l.level_idx][rounded_x1].find(rounded_y1);
+    if (m1_iter == idx_map[l.level_idx][rounded_x1].end())
       continue;
     // TODO waypoint offset
     // Waypoint offset is applied to ensure unique IDs when multiple levels
@@ -316,25 +470,23 @@ rmf_traffic::agv::Graph json_to_graph(
     // TODO(luca) Add lifts, doors, orientation constraints
     rmf_utils::clone_ptr<Event> entry_event;
     rmf_utils::clone_ptr<Event> exit_event;
-    if (is_bidirectional)
+    if (l.is_bidirectional)
     {
       // Lane in the opposite direction
       auto& lane = graph.add_lane({end_wp, entry_event},
           {start_wp, exit_event});
-      lane.properties().speed_limit(speed_limit);
+      lane.properties().speed_limit(l.speed_limit);
     }
 
     // dock_name is only applied to the lane going to the waypoint, not exiting
     const rmf_traffic::Duration duration = std::chrono::seconds(5);
-    if (dock_name.has_value())
-      entry_event = Event::make(Lane::Dock(dock_name.value(), duration));
+    if (l.dock_name.has_value())
+      entry_event = Event::make(Lane::Dock(l.dock_name.value(), duration));
     auto& lane = graph.add_lane({start_wp, entry_event},
         {end_wp, exit_event});
-    lane.properties().speed_limit(speed_limit);
+    lane.properties().speed_limit(l.speed_limit);
   }
 
-  proj_destroy(projector);
-  proj_context_destroy(proj_context);
   return graph;
 }
 
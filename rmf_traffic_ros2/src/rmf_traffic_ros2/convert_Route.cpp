@@ -30,16 +30,25 @@ rmf_traffic::Route convert(const rmf_traffic_msgs::msg::Route& from)
 rmf_traffic_msgs::msg::Route convert(const rmf_traffic::Route& from)
 {
   rmf_traffic_msgs::msg::Route output;
-  output.map = from.map();
-  output.trajectory = convert(from.trajectory());
+  convert(from, output);
   return output;
 }
 
+//==============================================================================
+void convert(
+  const rmf_traffic::Route& from,
+  rmf_traffic_msgs::msg::Route& into)
+{
+  into.map = from.map();
+  convert(from.trajectory(), into.trajectory);
+}
+
 //==============================================================================
 std::vector<rmf_traffic::Route> convert(
   const std::vector<rmf_traffic_msgs::msg::Route>& from)
 {
   std::vector<rmf_traffic::Route> output;
+  output.reserve(from.size());
   for (const auto& msg : from)
     output.emplace_back(convert(msg));
 
@@ -51,10 +60,18 @@ std::vector<rmf_traffic_msgs::msg::Route> convert(
   const std::vector<rmf_traffic::Route>& from)
 {
   std::vector<rmf_traffic_msgs::msg::Route> output;
-  for (const auto& msg : from)
-    output.emplace_back(convert(msg));
-
+  convert(from, output);
   return output;
 }
 
+//==============================================================================
+void convert(
+  const std::vector<rmf_traffic::Route>& from,
+  std::vector<rmf_traffic_msgs::msg::Route>& into)
+{
+  into.resize(from.size());
+  for (std::size_t i = 0; i < from.size(); ++i)
+    convert(from[i], into[i]);
+}
+
 } // namespace rmf_traffic_ros2
@@ -53,28 +53,28 @@ rmf_traffic::Trajectory convert(const rmf_traffic_msgs::msg::Trajectory& from)
   return output;
 }
 
-namespace {
 //==============================================================================
-rmf_traffic_msgs::msg::TrajectoryWaypoint convert_waypoint(
-  const rmf_traffic::Trajectory::Waypoint& from)
+rmf_traffic_msgs::msg::Trajectory convert(const rmf_traffic::Trajectory& from)
 {
-  rmf_traffic_msgs::msg::TrajectoryWaypoint output;
-  output.time = from.time().time_since_epoch().count();
-  output.position = from_eigen(from.position());
-  output.velocity = from_eigen(from.velocity());
+  rmf_traffic_msgs::msg::Trajectory output;
+  convert(from, output);
   return output;
 }
 
-} // anonymous namespace
-
 //==============================================================================
-rmf_traffic_msgs::msg::Trajectory convert(const rmf_traffic::Trajectory& from)
+void convert(
+  const rmf_traffic::Trajectory& from,
+  rmf_traffic_msgs::msg::Trajectory& into)
 {
-  rmf_traffic_msgs::msg::Trajectory output;
+  into.waypoints.resize(from.size());
+  auto output = into.waypoints.begin();
   for (const auto& waypoint : from)
-    output.waypoints.emplace_back(convert_waypoint(waypoint));
-
-  return output;
+  {
+    output->time = waypoint.time().time_since_epoch().count();
+    output->position = from_eigen(waypoint.position());
+    output->velocity = from_eigen(waypoint.velocity());
+    ++output;
+  }
 }
 
 } // namespace rmf_traffic_ros2
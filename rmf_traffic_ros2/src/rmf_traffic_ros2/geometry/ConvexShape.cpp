@@ -57,6 +57,11 @@ public:
   {
     return *parent._pimpl;
   }
+
+  static Implementation& get(ConvexShapeContext& parent)
+  {
+    return *parent._pimpl;
+  }
 };
 
 //==============================================================================
@@ -82,6 +87,14 @@ rmf_traffic::geometry::ConstFinalConvexShapePtr ConvexShapeContext::at(
 
 } // namespace geometry
 
+namespace {
+//==============================================================================
+// Every robot of a fleet has the same profile, so descriptions that get
+// converted many times would otherwise make many copies of the same shapes.
+geometry::internal::ShapeInterner<
+  rmf_traffic::geometry::FinalConvexShape, double> interned_circles;
+} // anonymous namespace
+
 //==============================================================================
 geometry::ConvexShapeContext convert(
   const rmf_traffic_msgs::msg::ConvexShapeContext& from)
@@ -89,11 +102,19 @@ geometry::ConvexShapeContext convert(
   using namespace rmf_traffic::geometry;
 
   geometry::ConvexShapeContext context;
+  auto& context_impl = geometry::ConvexShapeContext::Implementation::get(
+    context);
 //  for (const auto& box : from.boxes)
 //    context.insert(make_final_convex<Box>(convert(box)));
 
   for (const auto& circle : from.circles)
-    context.insert(make_final_convex<Circle>(convert(circle)));
+  {
+    context_impl.append(
+      rmf_traffic_msgs::msg::ConvexShape::CIRCLE,
+      interned_circles.get(
+        circle.radius,
+        [&]() { return make_final_convex<Circle>(convert(circle)); }));
+  }
 
   return context;
 }
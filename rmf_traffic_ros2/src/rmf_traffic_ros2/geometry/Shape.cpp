@@ -56,6 +56,11 @@ public:
   {
     return *parent._pimpl;
   }
+
+  static Implementation& get(ShapeContext& parent)
+  {
+    return *parent._pimpl;
+  }
 };
 
 //==============================================================================
@@ -81,6 +86,12 @@ rmf_traffic::geometry::ConstFinalShapePtr ShapeContext::at(
 
 } // namespace geometry
 
+namespace {
+//==============================================================================
+geometry::internal::ShapeInterner<
+  rmf_traffic::geometry::FinalShape, double> interned_circles;
+} // anonymous namespace
+
 //==============================================================================
 geometry::ShapeContext convert(
   const rmf_traffic_msgs::msg::ShapeContext& from)
@@ -88,11 +99,18 @@ geometry::ShapeContext convert(
   using namespace rmf_traffic::geometry;
 
   geometry::ShapeContext context;
+  auto& context_impl = geometry::ShapeContext::Implementation::get(context);
 //  for (const auto& box : from.convex_shapes.boxes)
 //    context.insert(make_final<Box>(convert(box)));
 
   for (const auto& circle : from.convex_shapes.circles)
-    context.insert(make_final<Circle>(convert(circle)));
+  {
+    context_impl.append(
+      rmf_traffic_msgs::msg::Shape::CIRCLE,
+      interned_circles.get(
+        circle.radius,
+        [&]() { return make_final<Circle>(convert(circle)); }));
+  }
 
   // TODO(MXG): Add SimplePolygon here once we're ready to support it
 
@@ -19,7 +19,9 @@
 #ifndef SRC__RMF_TRAFFIC_ROS2__GEOMETRY__SHAPEINTERNAL_HPP
 #define SRC__RMF_TRAFFIC_ROS2__GEOMETRY__SHAPEINTERNAL_HPP
 
+#include <algorithm>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -125,6 +127,18 @@ public:
     return shape_msg;
   }
 
+  /// Add a shape at the next index of its type, even if the same shape is
+  /// already in the context. Contexts that are converted from messages need
+  /// this to keep the indices of the message, because interning can give the
+  /// same shape to more than one of its entries.
+  void append(const std::size_t type, ShapeTypePtr shape)
+  {
+    std::vector<ShapeTypePtr>& derived_shapes = shapes.at(type);
+    entry_map.insert(
+      std::make_pair(shape, Entry{type, derived_shapes.size()}));
+    derived_shapes.push_back(std::move(shape));
+  }
+
   ShapeTypePtr at(const ShapeMsgType& shape) const
   {
     if (shape.type == ShapeMsgType::NONE)
@@ -153,6 +167,51 @@ template<class T, class M, class C>
 std::vector<typename ShapeContextImpl<T, M, C>::Caster>
 ShapeContextImpl<T, M, C>::casters;
 
+//==============================================================================
+/// Keeps one instance of each distinct shape that gets converted from a
+/// message, so that every profile which uses the same shape will share it.
+/// Only weak references are kept, so shapes are still freed once no profile
+/// uses them anymore.
+template<typename ShapeType, typename Key>
+class ShapeInterner
+{
+public:
+
+  using ShapeTypePtr = std::shared_ptr<const ShapeType>;
+
+  template<typename Make>
+  ShapeTypePtr get(const Key& key, const Make& make)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& weak = _shapes[key];
+    if (auto shape = weak.lock())
+      return shape;
+
+    ShapeTypePtr shape = make();
+    weak = shape;
+
+    if (_shapes.size() >= _prune_at)
+    {
+      for (auto it = _shapes.begin(); it != _shapes.end(); )
+      {
+        if (it->second.expired())
+          it = _shapes.erase(it);
+        else
+          ++it;
+      }
+
+      _prune_at = std::max<std::size_t>(64, 2*_shapes.size());
+    }
+
+    return shape;
+  }
+
+private:
+  std::mutex _mutex;
+  std::map<Key, std::weak_ptr<const ShapeType>> _shapes;
+  std::size_t _prune_at = 64;
+};
+
 } // namespace internal
 } // namespace geometry
 } // namespace rmf_traffic_ros2
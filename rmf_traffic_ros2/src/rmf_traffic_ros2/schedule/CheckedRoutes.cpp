@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_CheckedRoutes.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+bool same_waypoint(
+  const rmf_traffic::Trajectory::Waypoint& a,
+  const rmf_traffic::Trajectory::Waypoint& b)
+{
+  const double tolerance = 1e-6;
+  return a.time() == b.time()
+    && (a.position() - b.position()).norm() < tolerance
+    && (a.velocity() - b.velocity()).norm() < tolerance;
+}
+
+//==============================================================================
+/// Count how many waypoints at the start of the route also appear, in the
+/// same order, in a route that was checked before
+std::size_t matching_prefix(
+  const rmf_traffic::Route& route,
+  const rmf_traffic::Route& checked)
+{
+  if (route.map() != checked.map() || route.trajectory().size() == 0)
+    return 0;
+
+  const auto& trajectory = route.trajectory();
+  auto it = checked.trajectory().find(*trajectory.start_time());
+  if (it == checked.trajectory().end())
+    return 0;
+
+  std::size_t count = 0;
+  for (const auto& wp : trajectory)
+  {
+    if (it == checked.trajectory().end() || !same_waypoint(wp, *it))
+      break;
+
+    ++count;
+    ++it;
+  }
+
+  return count;
+}
+} // anonymous namespace
+
+//==============================================================================
+rmf_traffic::ConstRoutePtr CheckedRoutes::changed_part(
+  const ParticipantId participant,
+  const rmf_traffic::ConstRoutePtr& route) const
+{
+  const auto it = _routes.find(participant);
+  if (it == _routes.end())
+    return route;
+
+  std::size_t longest = 0;
+  for (const auto& checked : it->second)
+    longest = std::max(longest, matching_prefix(*route, *checked));
+
+  const auto& trajectory = route->trajectory();
+  if (longest >= trajectory.size())
+    return nullptr;
+
+  // Only a segment that touches a mismatched waypoint has changed. Each segment
+  // is defined entirely by its two waypoints, so starting the changed part
+  // from the last waypoint that matched leaves its motion the same.
+  if (longest < 2)
+    return route;
+
+  rmf_traffic::Trajectory changed;
+  auto wp = trajectory.begin();
+  std::advance(wp, longest - 1);
+  for (; wp != trajectory.end(); ++wp)
+    changed.insert(wp->time(), wp->position(), wp->velocity());
+
+  return std::make_shared<rmf_traffic::Route>(route->map(), std::move(changed));
+}
+
+//==============================================================================
+void CheckedRoutes::update(
+  const std::unordered_map<ParticipantId, rmf_traffic::schedule::Itinerary>&
+  checked,
+  const std::unordered_set<ParticipantId>& in_conflict)
+{
+  for (const auto& [participant, itinerary] : checked)
+  {
+    if (in_conflict.count(participant))
+      continue;
+
+    _routes[participant] = itinerary;
+  }
+
+  for (const auto participant : in_conflict)
+    _routes.erase(participant);
+}
+
+//==============================================================================
+void CheckedRoutes::clear()
+{
+  _routes.clear();
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_CircleConflict.hpp"
+
+#include <rmf_traffic/DetectConflict.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include <algorithm>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+std::optional<double> circle_radius(
+  const rmf_traffic::geometry::ConstFinalConvexShapePtr& shape)
+{
+  if (!shape)
+    return std::nullopt;
+
+  const auto* circle =
+    dynamic_cast<const rmf_traffic::geometry::Circle*>(&shape->source());
+  if (!circle)
+    return std::nullopt;
+
+  return circle->get_radius();
+}
+
+//==============================================================================
+double to_seconds(const rmf_traffic::Time time)
+{
+  return std::chrono::duration<double>(time.time_since_epoch()).count();
+}
+} // anonymous namespace
+
+//==============================================================================
+std::optional<CircleSegments> CircleSegments::make(
+  const rmf_traffic::Profile& profile,
+  const rmf_traffic::Trajectory& trajectory)
+{
+  const auto footprint = circle_radius(profile.footprint());
+  if (!footprint.has_value())
+    return std::nullopt;
+
+  // A profile without a vicinity uses its footprint for both
+  auto vicinity = footprint;
+  if (profile.vicinity())
+  {
+    vicinity = circle_radius(profile.vicinity());
+    if (!vicinity.has_value())
+      return std::nullopt;
+  }
+
+  if (trajectory.size() < 2)
+    return std::nullopt;
+
+  CircleSegments segments;
+  segments.radius = std::max(*footprint, *vicinity);
+
+  const std::size_t n = trajectory.size() - 1;
+  for (auto* v : {
+      &segments.start, &segments.finish,
+      &segments.min_x, &segments.max_x, &segments.min_y, &segments.max_y})
+  {
+    v->reserve(n);
+  }
+
+  auto it = trajectory.begin();
+  auto previous = it++;
+  for (; it != trajectory.end(); previous = it++)
+  {
+    const double t0 = to_seconds(previous->time());
+    const double t1 = to_seconds(it->time());
+    const double dt = t1 - t0;
+
+    // The Bezier control points of the cubic Hermite spline
+    const Eigen::Vector2d p0 = previous->position().block<2, 1>(0, 0);
+    const Eigen::Vector2d p3 = it->position().block<2, 1>(0, 0);
+    const Eigen::Vector2d p1 =
+      p0 + previous->velocity().block<2, 1>(0, 0) * dt / 3.0;
+    const Eigen::Vector2d p2 =
+      p3 - it->velocity().block<2, 1>(0, 0) * dt / 3.0;
+
+    segments.start.push_back(t0);
+    segments.finish.push_back(t1);
+    segments.min_x.push_back(std::min({p0.x(), p1.x(), p2.x(), p3.x()}));
+    segments.max_x.push_back(std::max({p0.x(), p1.x(), p2.x(), p3.x()}));
+    segments.min_y.push_back(std::min({p0.y(), p1.y(), p2.y(), p3.y()}));
+    segments.max_y.push_back(std::max({p0.y(), p1.y(), p2.y(), p3.y()}));
+  }
+
+  return segments;
+}
+
+//==============================================================================
+bool may_conflict(const CircleSegments& a, const CircleSegments& b)
+{
+  const double reach = a.radius + b.radius;
+  const double reach_squared = reach * reach;
+
+  // Both sets of segments are in time order, so the segments of b that
+  // overlap in time with a segment of a form a window that only ever moves
+  // forward.
+  std::size_t begin = 0;
+  std::size_t end = 0;
+  const std::size_t nb = b.start.size();
+  for (std::size_t i = 0; i < a.start.size(); ++i)
+  {
+    while (begin < nb && b.finish[begin] < a.start[i])
+      ++begin;
+
+    end = std::max(end, begin);
+    while (end < nb && b.start[end] <= a.finish[i])
+      ++end;
+
+    const double a_min_x = a.min_x[i];
+    const double a_max_x = a.max_x[i];
+    const double a_min_y = a.min_y[i];
+    const double a_max_y = a.max_y[i];
+
+    // This loop has no branches so that it can be vectorized
+    bool close = false;
+    for (std::size_t j = begin; j < end; ++j)
+    {
+      const double gap_x = std::max(
+        0.0, std::max(b.min_x[j] - a_max_x, a_min_x - b.max_x[j]));
+      const double gap_y = std::max(
+        0.0, std::max(b.min_y[j] - a_max_y, a_min_y - b.max_y[j]));
+      close |= gap_x * gap_x + gap_y * gap_y < reach_squared;
+    }
+
+    if (close)
+      return true;
+  }
+
+  return false;
+}
+
+//==============================================================================
+bool detect_conflict(
+  const rmf_traffic::Profile& profile_a,
+  const rmf_traffic::Trajectory& trajectory_a,
+  const rmf_traffic::Profile& profile_b,
+  const rmf_traffic::Trajectory& trajectory_b,
+  const CircleSegments* segments_a)
+{
+  std::optional<CircleSegments> made_a;
+  if (!segments_a)
+  {
+    made_a = CircleSegments::make(profile_a, trajectory_a);
+    if (made_a.has_value())
+      segments_a = &made_a.value();
+  }
+
+  if (segments_a)
+  {
+    const auto segments_b = CircleSegments::make(profile_b, trajectory_b);
+    if (segments_b.has_value() && !may_conflict(*segments_a, *segments_b))
+      return false;
+  }
+
+  return rmf_traffic::DetectConflict::between(
+    profile_a, trajectory_a, profile_b, trajectory_b).has_value();
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_CompactPatch.hpp"
+
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+const uint8_t FormatVersion = 1;
+
+enum : uint8_t
+{
+  HasBaseVersion = 1 << 0,
+  HasCull = 1 << 1
+};
+
+enum : uint8_t
+{
+  FullRoute = 0,
+  RouteReference = 1
+};
+
+//==============================================================================
+void put_varint(std::string& output, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+
+  output.push_back(static_cast<char>(value));
+}
+
+//==============================================================================
+void put_signed(std::string& output, const int64_t value)
+{
+  // Zigzag encoding keeps small negative numbers small
+  put_varint(
+    output,
+    (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+//==============================================================================
+void put_string(std::string& output, const std::string& value)
+{
+  put_varint(output, value.size());
+  output.append(value);
+}
+
+//==============================================================================
+int64_t quantize(const double value, const double resolution)
+{
+  return static_cast<int64_t>(std::llround(value / resolution));
+}
+
+//==============================================================================
+uint64_t to_nano(const double value)
+{
+  return static_cast<uint64_t>(std::llround(value * 1e9));
+}
+
+//==============================================================================
+class Reader
+{
+public:
+
+  Reader(const std::string& data)
+  : _data(data)
+  {
+    // Do nothing
+  }
+
+  uint8_t byte()
+  {
+    if (_offset >= _data.size())
+      fail();
+
+    return static_cast<uint8_t>(_data[_offset++]);
+  }
+
+  uint64_t varint()
+  {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+      const uint8_t b = byte();
+      value |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if ((b & 0x80) == 0)
+        return value;
+    }
+
+    fail();
+  }
+
+  int64_t signed_varint()
+  {
+    const uint64_t value = varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  std::string string()
+  {
+    const auto size = varint();
+    if (_data.size() - _offset < size)
+      fail();
+
+    auto output = _data.substr(_offset, size);
+    _offset += size;
+    return output;
+  }
+
+  bool done() const
+  {
+    return _offset == _data.size();
+  }
+
+  std::string rest() const
+  {
+    return _data.substr(_offset);
+  }
+
+  [[noreturn]] static void fail()
+  {
+    throw std::runtime_error("[CompactPatchDecoder] Malformed patch");
+  }
+
+private:
+  const std::string& _data;
+  std::size_t _offset = 0;
+};
+
+//==============================================================================
+/// Encode everything about a route except for its start time
+std::string encode_shape(
+  const rmf_traffic::Route& route,
+  const CompactPatchOptions& options)
+{
+  std::string output;
+  put_string(output, route.map());
+
+  const auto& trajectory = route.trajectory();
+  put_varint(output, trajectory.size());
+
+  const double res_p = options.position_resolution;
+  const double res_a = options.angle_resolution;
+  const double resolution[3] = {res_p, res_p, res_a};
+
+  std::optional<rmf_traffic::Time> previous_time;
+  int64_t previous_p[3] = {0, 0, 0};
+  int64_t previous_v[3] = {0, 0, 0};
+  for (const auto& waypoint : trajectory)
+  {
+    if (previous_time.has_value())
+      put_signed(output, (waypoint.time() - *previous_time).count());
+
+    previous_time = waypoint.time();
+
+    const Eigen::Vector3d p = waypoint.position();
+    const Eigen::Vector3d v = waypoint.velocity();
+    for (int i = 0; i < 3; ++i)
+    {
+      const int64_t q_p = quantize(p[i], resolution[i]);
+      const int64_t q_v = quantize(v[i], resolution[i]);
+      put_signed(output, q_p - previous_p[i]);
+      put_signed(output, q_v - previous_v[i]);
+      previous_p[i] = q_p;
+      previous_v[i] = q_v;
+    }
+  }
+
+  return output;
+}
+
+//==============================================================================
+CompactPatchDecoder::Shape decode_shape(
+  const std::string& data,
+  const double res_p,
+  const double res_a)
+{
+  Reader reader(data);
+  CompactPatchDecoder::Shape shape;
+  shape.map = reader.string();
+
+  const auto size = reader.varint();
+  if (size > data.size())
+    Reader::fail();
+
+  shape.waypoints.reserve(size);
+
+  const double resolution[3] = {res_p, res_p, res_a};
+  rmf_traffic::Duration offset(0);
+  int64_t q_p[3] = {0, 0, 0};
+  int64_t q_v[3] = {0, 0, 0};
+  for (uint64_t n = 0; n < size; ++n)
+  {
+    if (n > 0)
+      offset += rmf_traffic::Duration(reader.signed_varint());
+
+    CompactPatchDecoder::Waypoint waypoint;
+    waypoint.offset = offset;
+    for (int i = 0; i < 3; ++i)
+    {
+      q_p[i] += reader.signed_varint();
+      q_v[i] += reader.signed_varint();
+      waypoint.position[i] = static_cast<double>(q_p[i]) * resolution[i];
+      waypoint.velocity[i] = static_cast<double>(q_v[i]) * resolution[i];
+    }
+
+    shape.waypoints.push_back(waypoint);
+  }
+
+  if (!reader.done())
+    Reader::fail();
+
+  return shape;
+}
+
+//==============================================================================
+rmf_traffic::ConstRoutePtr make_route(
+  const CompactPatchDecoder::Shape& shape,
+  const rmf_traffic::Time start)
+{
+  rmf_traffic::Trajectory trajectory;
+  for (const auto& waypoint : shape.waypoints)
+  {
+    trajectory.insert(
+      start + waypoint.offset, waypoint.position, waypoint.velocity);
+  }
+
+  return std::make_shared<rmf_traffic::Route>(shape.map, std::move(trajectory));
+}
+
+//==============================================================================
+int64_t start_time(const rmf_traffic::Route& route)
+{
+  if (route.trajectory().size() == 0)
+    return 0;
+
+  return route.trajectory().begin()->time().time_since_epoch().count();
+}
+} // anonymous namespace
+
+//==============================================================================
+CompactPatchEncoder::CompactPatchEncoder(CompactPatchOptions options)
+: _options(options)
+{
+  if (_options.route_history == 0)
+    _options.route_history = 1;
+
+  _history.resize(_options.route_history);
+}
+
+//==============================================================================
+std::string CompactPatchEncoder::encode(
+  const rmf_traffic::schedule::Patch& patch)
+{
+  std::string output;
+  output.push_back(static_cast<char>(FormatVersion));
+  put_varint(output, to_nano(_options.position_resolution));
+  put_varint(output, to_nano(_options.angle_resolution));
+  put_varint(output, _options.route_history);
+  put_varint(output, _next_sequence);
+
+  uint8_t flags = 0;
+  if (patch.base_version().has_value())
+    flags |= HasBaseVersion;
+
+  const auto& cull = patch.cull();
+  if (cull)
+    flags |= HasCull;
+
+  output.push_back(static_cast<char>(flags));
+  if (patch.base_version().has_value())
+    put_varint(output, *patch.base_version());
+
+  put_varint(output, patch.latest_version());
+  if (cull)
+    put_signed(output, cull->time().time_since_epoch().count());
+
+  put_varint(output, patch.size());
+  for (const auto& p : patch)
+  {
+    put_varint(output, p.participant_id());
+    put_varint(output, p.itinerary_version());
+
+    const auto& erasures = p.erasures().ids();
+    put_varint(output, erasures.size());
+    for (const auto id : erasures)
+      put_varint(output, id);
+
+    put_varint(output, p.delays().size());
+    for (const auto& delay : p.delays())
+      put_signed(output, delay.duration().count());
+
+    const auto& additions = p.additions().items();
+    put_varint(output, additions.size());
+    for (const auto& item : additions)
+    {
+      put_varint(output, item.id);
+      auto shape = encode_shape(*item.route, _options);
+      const auto start = start_time(*item.route);
+
+      const auto it = _sequence_of_shape.find(shape);
+      if (it != _sequence_of_shape.end())
+      {
+        output.push_back(static_cast<char>(RouteReference));
+        put_varint(output, _next_sequence - 1 - it->second);
+        put_signed(output, start);
+        continue;
+      }
+
+      output.push_back(static_cast<char>(FullRoute));
+      put_signed(output, start);
+      put_string(output, shape);
+
+      // Remember this shape, forgetting whichever one it replaces
+      auto& slot = _history[_next_sequence % _history.size()];
+      if (!slot.empty())
+      {
+        const auto old = _sequence_of_shape.find(slot);
+        if (old != _sequence_of_shape.end()
+          && old->second + _history.size() <= _next_sequence)
+        {
+          _sequence_of_shape.erase(old);
+        }
+      }
+
+      _sequence_of_shape[shape] = _next_sequence;
+      slot = std::move(shape);
+      ++_next_sequence;
+    }
+  }
+
+  return output;
+}
+
+//==============================================================================
+void CompactPatchEncoder::reset()
+{
+  _next_sequence = 0;
+  _sequence_of_shape.clear();
+  _history.assign(_options.route_history, std::string());
+}
+
+//==============================================================================
+rmf_traffic::schedule::Patch CompactPatchDecoder::decode(
+  const std::string& data)
+{
+  using namespace rmf_traffic::schedule;
+
+  Reader reader(data);
+  if (reader.byte() != FormatVersion)
+    Reader::fail();
+
+  const double res_p = static_cast<double>(reader.varint()) * 1e-9;
+  const double res_a = static_cast<double>(reader.varint()) * 1e-9;
+  const auto route_history = reader.varint();
+  if (route_history == 0 || route_history > (1u << 20))
+    Reader::fail();
+
+  const auto sequence = reader.varint();
+  if (sequence == 0)
+  {
+    // The encoder has been reset, so nothing before this patch will be
+    // referred to again
+    reset();
+  }
+  else if (sequence != _next_sequence || _history.size() != route_history)
+  {
+    throw std::runtime_error(
+      "[CompactPatchDecoder] Patch does not follow the last decoded patch");
+  }
+
+  _history.resize(route_history);
+
+  const uint8_t flags = reader.byte();
+  std::optional<Version> base_version;
+  if (flags & HasBaseVersion)
+    base_version = reader.varint();
+
+  const Version latest_version = reader.varint();
+  std::optional<Change::Cull> cull;
+  if (flags & HasCull)
+  {
+    cull = Change::Cull(
+      rmf_traffic::Time(rmf_traffic::Duration(reader.signed_varint())));
+  }
+
+  const auto num_participants = reader.varint();
+  if (num_participants > data.size())
+    Reader::fail();
+
+  std::vector<Patch::Participant> participants;
+  participants.reserve(num_participants);
+  for (uint64_t i = 0; i < num_participants; ++i)
+  {
+    const ParticipantId participant = reader.varint();
+    const ItineraryVersion itinerary_version = reader.varint();
+
+    std::vector<rmf_traffic::RouteId> erasures(reader.varint());
+    for (auto& id : erasures)
+      id = reader.varint();
+
+    std::vector<Change::Delay> delays;
+    const auto num_delays = reader.varint();
+    for (uint64_t d = 0; d < num_delays; ++d)
+      delays.emplace_back(rmf_traffic::Duration(reader.signed_varint()));
+
+    std::vector<Change::Add::Item> additions;
+    const auto num_additions = reader.varint();
+    for (uint64_t a = 0; a < num_additions; ++a)
+    {
+      const rmf_traffic::RouteId route_id = reader.varint();
+      const uint8_t tag = reader.byte();
+      if (tag == RouteReference)
+      {
+        const auto distance = reader.varint();
+        if (_next_sequence <= distance || _history.size() <= distance)
+          Reader::fail();
+
+        const auto sequence = _next_sequence - 1 - distance;
+        const auto start =
+          rmf_traffic::Time(rmf_traffic::Duration(reader.signed_varint()));
+        additions.push_back(
+          {route_id,
+            make_route(_history[sequence % _history.size()], start)});
+      }
+      else if (tag == FullRoute)
+      {
+        const auto start =
+          rmf_traffic::Time(rmf_traffic::Duration(reader.signed_varint()));
+        auto shape = decode_shape(reader.string(), res_p, res_a);
+        additions.push_back({route_id, make_route(shape, start)});
+        _history[_next_sequence % _history.size()] = std::move(shape);
+        ++_next_sequence;
+      }
+      else
+      {
+        Reader::fail();
+      }
+    }
+
+    participants.emplace_back(
+      Patch::Participant{
+        participant,
+        itinerary_version,
+        Change::Erase{std::move(erasures)},
+        std::move(delays),
+        Change::Add{std::move(additions)}
+      });
+  }
+
+  if (!reader.done())
+    Reader::fail();
+
+  return Patch{
+    std::move(participants),
+    std::move(cull),
+    base_version,
+    latest_version
+  };
+}
+
+//==============================================================================
+void CompactPatchDecoder::reset()
+{
+  _next_sequence = 0;
+  _history.clear();
+}
+
+//==============================================================================
+std::vector<uint8_t> make_compact_update(
+  const CompactUpdateHeader& header,
+  const std::string& patch)
+{
+  std::string output;
+  output.reserve(patch.size() + 16);
+  put_varint(output, header.node_version);
+  put_varint(output, header.database_version);
+  output.push_back(static_cast<char>(header.is_remedial_update ? 1 : 0));
+  output.append(patch);
+  return std::vector<uint8_t>(output.begin(), output.end());
+}
+
+//==============================================================================
+CompactUpdateHeader read_compact_update(
+  const std::vector<uint8_t>& data,
+  std::string& patch)
+{
+  const std::string buffer(data.begin(), data.end());
+  Reader reader(buffer);
+
+  CompactUpdateHeader header;
+  header.node_version = reader.varint();
+  header.database_version = reader.varint();
+  const auto remedial = reader.byte();
+  if (remedial > 1)
+    Reader::fail();
+
+  header.is_remedial_update = remedial == 1;
+  patch = reader.rest();
+  return header;
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
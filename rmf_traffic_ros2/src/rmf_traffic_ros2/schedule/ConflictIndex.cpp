@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_ConflictIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+bool is_unresponsive(
+  const rmf_traffic::schedule::ParticipantDescription& description)
+{
+  return description.responsiveness()
+    == rmf_traffic::schedule::ParticipantDescription::Rx::Unresponsive;
+}
+} // anonymous namespace
+
+//==============================================================================
+ConflictIndex::ConflictIndex(const double cell_size)
+: _cell_size(cell_size > 0.0 ? cell_size : 5.0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template<typename F>
+void ConflictIndex::_for_each_cell(const RouteBox& box, F&& f) const
+{
+  const auto x0 = static_cast<int64_t>(std::floor(box.min_x / _cell_size));
+  const auto y0 = static_cast<int64_t>(std::floor(box.min_y / _cell_size));
+  const auto x1 = static_cast<int64_t>(std::floor(box.max_x / _cell_size));
+  const auto y1 = static_cast<int64_t>(std::floor(box.max_y / _cell_size));
+
+  for (int64_t x = x0; x <= x1; ++x)
+  {
+    for (int64_t y = y0; y <= y1; ++y)
+      f(CellKey{x, y});
+  }
+}
+
+//==============================================================================
+void ConflictIndex::update(
+  const ParticipantId participant,
+  const ParticipantDescription& description,
+  const rmf_traffic::schedule::Itinerary& itinerary)
+{
+  erase(participant);
+
+  auto& participant_entries = _participants.insert(
+    {participant, ParticipantEntries{description, {}}}).first->second;
+  const ParticipantDescription* const stored_description =
+    &participant_entries.description;
+  const bool unresponsive = is_unresponsive(description);
+
+  for (const auto& route : itinerary)
+  {
+    if (!route)
+      continue;
+
+    const auto box = compute_box(route->trajectory(), description.profile());
+    if (!box)
+      continue;
+
+    participant_entries.entries.emplace_back(
+      std::make_unique<Entry>(
+        Entry{participant, stored_description, route, *box}));
+
+    const Entry* const entry = participant_entries.entries.back().get();
+    auto& grid = _maps[route->map()].get(unresponsive);
+    _for_each_cell(
+      *box, [&](const CellKey& key)
+      {
+        grid[key].push_back(entry);
+      });
+  }
+}
+
+//==============================================================================
+void ConflictIndex::erase(const ParticipantId participant)
+{
+  const auto it = _participants.find(participant);
+  if (it == _participants.end())
+    return;
+
+  const bool unresponsive = is_unresponsive(it->second.description);
+  for (const auto& entry : it->second.entries)
+  {
+    const auto map_it = _maps.find(entry->route->map());
+    if (map_it == _maps.end())
+      continue;
+
+    auto& grid = map_it->second.get(unresponsive);
+    _for_each_cell(
+      entry->box, [&](const CellKey& key)
+      {
+        const auto cell_it = grid.find(key);
+        if (cell_it == grid.end())
+          return;
+
+        auto& cell = cell_it->second;
+        cell.erase(
+          std::remove(cell.begin(), cell.end(), entry.get()), cell.end());
+
+        if (cell.empty())
+          grid.erase(cell_it);
+      });
+
+    if (map_it->second.responsive.empty()
+      && map_it->second.unresponsive.empty())
+    {
+      _maps.erase(map_it);
+    }
+  }
+
+  _participants.erase(it);
+}
+
+//==============================================================================
+void ConflictIndex::retain(
+  const std::unordered_set<ParticipantId>& participants)
+{
+  std::vector<ParticipantId> remove;
+  for (const auto& p : _participants)
+  {
+    if (participants.count(p.first) == 0)
+      remove.push_back(p.first);
+  }
+
+  for (const auto p : remove)
+    erase(p);
+}
+
+//==============================================================================
+auto ConflictIndex::description(const ParticipantId participant) const
+-> const ParticipantDescription*
+{
+  const auto it = _participants.find(participant);
+  if (it == _participants.end())
+    return nullptr;
+
+  return &it->second.description;
+}
+
+//==============================================================================
+auto ConflictIndex::candidates(
+  const ParticipantId participant,
+  const rmf_traffic::Route& route,
+  const rmf_traffic::Profile& profile,
+  const bool include_unresponsive) const -> std::vector<Candidate>
+{
+  std::vector<Candidate> output;
+  const auto map_it = _maps.find(route.map());
+  if (map_it == _maps.end())
+    return output;
+
+  const auto box = compute_box(route.trajectory(), profile);
+  if (!box)
+    return output;
+
+  _find_candidates(map_it->second.responsive, participant, *box, output);
+  if (include_unresponsive)
+    _find_candidates(map_it->second.unresponsive, participant, *box, output);
+
+  return output;
+}
+
+//==============================================================================
+void ConflictIndex::_find_candidates(
+  const Grid& grid,
+  const ParticipantId participant,
+  const RouteBox& box,
+  std::vector<Candidate>& output) const
+{
+  if (grid.empty())
+    return;
+
+  std::unordered_set<const Entry*> visited;
+  _for_each_cell(
+    box, [&](const CellKey& key)
+    {
+      const auto cell_it = grid.find(key);
+      if (cell_it == grid.end())
+        return;
+
+      for (const Entry* entry : cell_it->second)
+      {
+        if (entry->participant == participant)
+          continue;
+
+        if (!visited.insert(entry).second)
+          continue;
+
+        if (!entry->box.overlaps(box))
+          continue;
+
+        output.push_back(
+          {entry->participant, entry->description, entry->route});
+      }
+    });
+}
+
+//==============================================================================
+std::size_t ConflictIndex::size() const
+{
+  return _participants.size();
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,602 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_DatabaseSnapshot.hpp"
+
+#include <rmf_traffic_ros2/Route.hpp>
+#include <rmf_traffic_ros2/schedule/Change.hpp>
+#include <rmf_traffic_ros2/schedule/ParticipantDescription.hpp>
+#include <rmf_traffic_ros2/schedule/Patch.hpp>
+
+#include <rmf_traffic/schedule/Mirror.hpp>
+
+#include <rmf_traffic_msgs/msg/participant_description.hpp>
+#include <rmf_traffic_msgs/msg/participants.hpp>
+#include <rmf_traffic_msgs/msg/schedule_patch.hpp>
+
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+// Snapshots and tail logs are only ever read back by the same machine that
+// wrote them, so integers are stored in native byte order.
+const std::string SnapshotMagic = "RMFSNAP1";
+
+//==============================================================================
+enum class RecordType : uint8_t
+{
+  Participant = 0,
+  Set = 1,
+  Extend = 2,
+  Delay = 3,
+  Erase = 4,
+  Clear = 5,
+  Cull = 6
+};
+
+//==============================================================================
+void append_u64(std::string& buffer, const uint64_t value)
+{
+  char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  buffer.append(bytes, sizeof(value));
+}
+
+//==============================================================================
+void append_block(std::string& buffer, const std::string& block)
+{
+  append_u64(buffer, block.size());
+  buffer.append(block);
+}
+
+//==============================================================================
+class Reader
+{
+public:
+
+  Reader(const std::string& data)
+  : _data(data)
+  {
+    // Do nothing
+  }
+
+  bool done() const
+  {
+    return _offset >= _data.size();
+  }
+
+  bool read_bytes(const std::size_t size, std::string& output)
+  {
+    if (_data.size() - _offset < size)
+      return false;
+
+    output = _data.substr(_offset, size);
+    _offset += size;
+    return true;
+  }
+
+  bool read_u8(uint8_t& output)
+  {
+    if (_data.size() - _offset < 1)
+      return false;
+
+    output = static_cast<uint8_t>(_data[_offset]);
+    ++_offset;
+    return true;
+  }
+
+  bool read_u64(uint64_t& output)
+  {
+    if (_data.size() - _offset < sizeof(output))
+      return false;
+
+    std::memcpy(&output, _data.data() + _offset, sizeof(output));
+    _offset += sizeof(output);
+    return true;
+  }
+
+  bool read_block(std::string& output)
+  {
+    uint64_t size = 0;
+    return read_u64(size) && read_bytes(size, output);
+  }
+
+private:
+  const std::string& _data;
+  std::size_t _offset = 0;
+};
+
+//==============================================================================
+template<typename Msg>
+std::string serialize_message(const Msg& msg)
+{
+  rclcpp::Serialization<Msg> serializer;
+  rclcpp::SerializedMessage serialized;
+  serializer.serialize_message(&msg, &serialized);
+
+  const auto& rcl_msg = serialized.get_rcl_serialized_message();
+  return std::string(
+    reinterpret_cast<const char*>(rcl_msg.buffer), rcl_msg.buffer_length);
+}
+
+//==============================================================================
+template<typename Msg>
+Msg deserialize_message(const std::string& data)
+{
+  rclcpp::SerializedMessage serialized(data.size());
+  auto& rcl_msg = serialized.get_rcl_serialized_message();
+  std::memcpy(rcl_msg.buffer, data.data(), data.size());
+  rcl_msg.buffer_length = data.size();
+
+  Msg msg;
+  rclcpp::Serialization<Msg> serializer;
+  serializer.deserialize_message(&serialized, &msg);
+  return msg;
+}
+
+//==============================================================================
+std::optional<std::string> read_file(const std::string& file_path)
+{
+  if (!std::filesystem::exists(file_path))
+    return std::nullopt;
+
+  std::ifstream file(file_path, std::ios::in | std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error(
+      "[DatabaseSnapshot] Unable to open [" + file_path + "] for reading");
+  }
+
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+//==============================================================================
+void sync_file(const std::string& file_path)
+{
+  const int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  ::fsync(fd);
+  ::close(fd);
+}
+
+//==============================================================================
+void apply_participant(
+  const rmf_traffic_msgs::msg::ParticipantDescription& msg,
+  Database& database)
+{
+  const auto description = rmf_traffic_ros2::convert(msg);
+  for (const auto id : database.participant_ids())
+  {
+    const auto existing = database.get_participant(id);
+    if (existing->name() == description.name()
+      && existing->owner() == description.owner())
+    {
+      database.update_description(id, description);
+      return;
+    }
+  }
+
+  database.register_participant(description);
+}
+
+//==============================================================================
+void apply_record(
+  const RecordType type,
+  const std::string& payload,
+  Database& database)
+{
+  switch (type)
+  {
+    case RecordType::Participant:
+    {
+      apply_participant(
+        deserialize_message<rmf_traffic_msgs::msg::ParticipantDescription>(
+          payload),
+        database);
+      return;
+    }
+    case RecordType::Set:
+    {
+      const auto set = deserialize_message<TailLog::ItinerarySet>(payload);
+      database.set(
+        set.participant,
+        rmf_traffic_ros2::convert(set.itinerary),
+        set.itinerary_version);
+      return;
+    }
+    case RecordType::Extend:
+    {
+      const auto extend =
+        deserialize_message<TailLog::ItineraryExtend>(payload);
+      database.extend(
+        extend.participant,
+        rmf_traffic_ros2::convert(extend.routes),
+        extend.itinerary_version);
+      return;
+    }
+    case RecordType::Delay:
+    {
+      const auto delay = deserialize_message<TailLog::ItineraryDelay>(payload);
+      database.delay(
+        delay.participant,
+        rmf_traffic::Duration(delay.delay),
+        delay.itinerary_version);
+      return;
+    }
+    case RecordType::Erase:
+    {
+      const auto erase = deserialize_message<TailLog::ItineraryErase>(payload);
+      database.erase(
+        erase.participant,
+        std::vector<rmf_traffic::RouteId>(
+          erase.routes.begin(), erase.routes.end()),
+        erase.itinerary_version);
+      return;
+    }
+    case RecordType::Clear:
+    {
+      const auto clear = deserialize_message<TailLog::ItineraryClear>(payload);
+      database.erase(clear.participant, clear.itinerary_version);
+      return;
+    }
+    case RecordType::Cull:
+    {
+      const auto cull =
+        deserialize_message<rmf_traffic_msgs::msg::ScheduleChangeCull>(payload);
+      database.cull(rmf_traffic_ros2::convert(cull).time());
+      return;
+    }
+  }
+
+  throw std::runtime_error(
+    "[TailLog] Unknown record type ["
+    + std::to_string(static_cast<uint32_t>(type)) + "]");
+}
+
+//==============================================================================
+std::string rotated_path(const std::string& file_path)
+{
+  return file_path + ".rotated";
+}
+} // anonymous namespace
+
+//==============================================================================
+std::string serialize_snapshot(const Database& database)
+{
+  rmf_traffic_msgs::msg::Participants participants;
+  for (const auto id : database.participant_ids())
+  {
+    rmf_traffic_msgs::msg::Participant participant;
+    participant.id = id;
+    participant.description =
+      rmf_traffic_ros2::convert(*database.get_participant(id));
+    participants.participants.push_back(std::move(participant));
+  }
+
+  const auto patch = rmf_traffic_ros2::convert(
+    database.changes(rmf_traffic::schedule::query_all(), std::nullopt));
+
+  std::string output = SnapshotMagic;
+  append_u64(output, database.latest_version());
+  append_block(output, serialize_message(participants));
+  append_block(output, serialize_message(patch));
+  return output;
+}
+
+//==============================================================================
+void save_snapshot(const std::string& file_path, const std::string& snapshot)
+{
+  const auto parent = std::filesystem::absolute(file_path).parent_path();
+  if (!std::filesystem::exists(parent))
+    std::filesystem::create_directories(parent);
+
+  // Write the snapshot next to the old one and then atomically swap it in, so
+  // a crash while saving can never leave us without a valid snapshot.
+  const std::string temp_path = file_path + ".tmp";
+  {
+    std::ofstream file(
+      temp_path, std::ios::out | std::ios::trunc | std::ios::binary);
+    file.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+    if (!file)
+    {
+      throw std::runtime_error(
+        "[DatabaseSnapshot] Failed to write [" + temp_path + "]");
+    }
+  }
+
+  sync_file(temp_path);
+  std::filesystem::rename(temp_path, file_path);
+}
+
+//==============================================================================
+std::optional<Database> load_snapshot(const std::string& file_path)
+{
+  const auto data = read_file(file_path);
+  if (!data.has_value())
+    return std::nullopt;
+
+  const auto malformed = [&]()
+    {
+      return std::runtime_error(
+        "[DatabaseSnapshot] [" + file_path + "] is not a valid snapshot");
+    };
+
+  Reader reader(*data);
+  std::string magic;
+  uint64_t version = 0;
+  std::string participants_data;
+  std::string patch_data;
+  if (!reader.read_bytes(SnapshotMagic.size(), magic)
+    || magic != SnapshotMagic
+    || !reader.read_u64(version)
+    || !reader.read_block(participants_data)
+    || !reader.read_block(patch_data))
+  {
+    throw malformed();
+  }
+
+  const auto participants =
+    deserialize_message<rmf_traffic_msgs::msg::Participants>(
+    participants_data);
+  const auto patch =
+    deserialize_message<rmf_traffic_msgs::msg::SchedulePatch>(patch_data);
+
+  rmf_traffic::schedule::Mirror mirror;
+  mirror.update_participants_info(rmf_traffic_ros2::convert(participants));
+  if (!mirror.update(rmf_traffic_ros2::convert(patch)))
+    throw malformed();
+
+  auto database = mirror.fork();
+  if (database.latest_version() != version)
+    throw malformed();
+
+  return database;
+}
+
+//==============================================================================
+TailLog::TailLog(std::string file_path)
+: _file_path(std::move(file_path))
+{
+  const auto parent = std::filesystem::absolute(_file_path).parent_path();
+  if (!std::filesystem::exists(parent))
+    std::filesystem::create_directories(parent);
+
+  _open();
+}
+
+//==============================================================================
+void TailLog::record(
+  const ParticipantDescription& description,
+  const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Participant), version,
+    serialize_message(rmf_traffic_ros2::convert(description)));
+}
+
+//==============================================================================
+void TailLog::record(const ItinerarySet& set, const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Set), version, serialize_message(set));
+}
+
+//==============================================================================
+void TailLog::record(const ItineraryExtend& extend, const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Extend), version,
+    serialize_message(extend));
+}
+
+//==============================================================================
+void TailLog::record(const ItineraryDelay& delay, const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Delay), version, serialize_message(delay));
+}
+
+//==============================================================================
+void TailLog::record(const ItineraryErase& erase, const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Erase), version, serialize_message(erase));
+}
+
+//==============================================================================
+void TailLog::record(const ItineraryClear& clear, const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Clear), version, serialize_message(clear));
+}
+
+//==============================================================================
+void TailLog::record(
+  const rmf_traffic::schedule::Change::Cull& cull,
+  const Version version)
+{
+  _append(
+    static_cast<uint8_t>(RecordType::Cull), version,
+    serialize_message(rmf_traffic_ros2::convert(cull)));
+}
+
+//==============================================================================
+void TailLog::rotate()
+{
+  ::fsync(_fd);
+  ::close(_fd);
+  _fd = -1;
+
+  const auto rotated = rotated_path(_file_path);
+  if (std::filesystem::exists(rotated))
+  {
+    // The last snapshot was never saved, so the records that were set aside
+    // for it are still needed. Keep them and add the new ones after them.
+    const auto current = read_file(_file_path);
+    if (current.has_value())
+    {
+      std::ofstream file(
+        rotated, std::ios::out | std::ios::app | std::ios::binary);
+      file.write(
+        current->data(), static_cast<std::streamsize>(current->size()));
+      if (!file)
+      {
+        throw std::runtime_error(
+          "[TailLog] Failed to write [" + rotated + "]");
+      }
+    }
+
+    sync_file(rotated);
+    std::filesystem::remove(_file_path);
+  }
+  else if (std::filesystem::exists(_file_path))
+  {
+    std::filesystem::rename(_file_path, rotated);
+  }
+
+  _open();
+}
+
+//==============================================================================
+void TailLog::discard_rotated()
+{
+  std::filesystem::remove(rotated_path(_file_path));
+}
+
+//==============================================================================
+std::size_t TailLog::replay(const std::string& file_path, Database& database)
+{
+  std::size_t applied = 0;
+  for (const auto& path : {rotated_path(file_path), file_path})
+  {
+    const auto data = read_file(path);
+    if (!data.has_value())
+      continue;
+
+    Reader reader(*data);
+    while (!reader.done())
+    {
+      uint8_t type = 0;
+      uint64_t version = 0;
+      std::string payload;
+      if (!reader.read_u8(type)
+        || !reader.read_u64(version)
+        || !reader.read_block(payload))
+      {
+        // The final record was torn by an interrupted write
+        break;
+      }
+
+      if (version <= database.latest_version())
+        continue;
+
+      try
+      {
+        apply_record(static_cast<RecordType>(type), payload, database);
+      }
+      catch (const std::exception&)
+      {
+        // The database rejected the change, so this log does not belong to
+        // the history of the database.
+        return applied;
+      }
+
+      if (database.latest_version() != version)
+        return applied;
+
+      ++applied;
+    }
+  }
+
+  return applied;
+}
+
+//==============================================================================
+TailLog::~TailLog()
+{
+  if (_fd >= 0)
+  {
+    ::fsync(_fd);
+    ::close(_fd);
+  }
+}
+
+//==============================================================================
+void TailLog::_open()
+{
+  _fd = ::open(_file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (_fd < 0)
+  {
+    throw std::runtime_error(
+      "[TailLog] Unable to open [" + _file_path + "] for writing: "
+      + std::strerror(errno));
+  }
+}
+
+//==============================================================================
+void TailLog::_append(
+  const uint8_t type,
+  const Version version,
+  const std::string& payload)
+{
+  std::string data;
+  data.reserve(1 + 2*sizeof(uint64_t) + payload.size());
+  data.push_back(static_cast<char>(type));
+  append_u64(data, version);
+  append_block(data, payload);
+
+  // The whole record is assembled before writing so that a crash can only
+  // ever tear the final record of the log.
+  std::size_t written = 0;
+  while (written < data.size())
+  {
+    const auto result =
+      ::write(_fd, data.data() + written, data.size() - written);
+
+    if (result < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      throw std::runtime_error(
+        "[TailLog] Failed to write to [" + _file_path + "]: "
+        + std::strerror(errno));
+    }
+
+    written += static_cast<std::size_t>(result);
+  }
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
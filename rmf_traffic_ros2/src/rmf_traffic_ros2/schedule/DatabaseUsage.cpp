@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_DatabaseUsage.hpp"
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+// Rough sizes of what the database keeps for each route and each waypoint,
+// including the bookkeeping of its timeline
+const std::size_t RouteSize = 128;
+const std::size_t WaypointSize = 96;
+} // anonymous namespace
+
+//==============================================================================
+void DatabaseUsage::Entry::add(const rmf_traffic::Route& route)
+{
+  const std::size_t size = route.trajectory().size();
+  ++routes;
+  waypoints += size;
+  bytes += RouteSize + route.map().size() + size * WaypointSize;
+}
+
+//==============================================================================
+DatabaseUsage measure_usage(const rmf_traffic::schedule::Database& database)
+{
+  DatabaseUsage usage;
+  for (const auto p : database.participant_ids())
+  {
+    const auto itinerary = database.get_itinerary(p);
+    if (!itinerary.has_value())
+      continue;
+
+    const auto* description = database.get_participant(p);
+    auto& participant = usage.participants[
+      description ? description->owner() + "/" + description->name() :
+      std::to_string(p)];
+
+    for (const auto& route : *itinerary)
+    {
+      usage.total.add(*route);
+      usage.maps[route->map()].add(*route);
+      participant.add(*route);
+    }
+  }
+
+  return usage;
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_Federation.hpp"
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+#include <rmf_traffic_ros2/schedule/ParticipantDescription.hpp>
+#include <rmf_traffic_ros2/schedule/Patch.hpp>
+#include <rmf_traffic_ros2/schedule/Query.hpp>
+
+#include <rmf_traffic/schedule/Query.hpp>
+
+#include <algorithm>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+std::string normalize_namespace(std::string ns)
+{
+  while (!ns.empty() && ns.back() == '/')
+    ns.pop_back();
+
+  if (ns.empty() || ns.front() != '/')
+    ns = "/" + ns;
+
+  return ns;
+}
+} // anonymous namespace
+
+//==============================================================================
+FederationLink::FederationLink(
+  rclcpp::Node& node,
+  std::string neighbour,
+  std::vector<std::string> boundary_maps,
+  Handler handler)
+: _node(node),
+  _neighbour(normalize_namespace(std::move(neighbour))),
+  _boundary_maps(std::move(boundary_maps)),
+  _handler(std::move(handler)),
+  _last_update(std::chrono::steady_clock::now())
+{
+  _register_query_client = _node.create_client<RegisterQuery>(
+    _name(RegisterQueryServiceName));
+  _request_changes_client = _node.create_client<RequestChanges>(
+    _name(RequestChangesServiceName));
+
+  _participants_sub = _node.create_subscription<Participants>(
+    _name(ParticipantsInfoTopicName),
+    rclcpp::SystemDefaultsQoS().reliable().keep_last(100).transient_local(),
+    [this](const Participants::SharedPtr msg)
+    {
+      _handle_participants(*msg);
+    });
+
+  _timer = _node.create_wall_timer(1s, [this]() { _check(); });
+}
+
+//==============================================================================
+const std::string& FederationLink::neighbour() const
+{
+  return _neighbour;
+}
+
+//==============================================================================
+std::string FederationLink::proxy_owner(const std::string& owner) const
+{
+  return FederationOwnerPrefix + _neighbour + "/" + owner;
+}
+
+//==============================================================================
+bool FederationLink::is_proxy(const ParticipantDescription& description)
+{
+  return description.owner().rfind(FederationOwnerPrefix, 0) == 0;
+}
+
+//==============================================================================
+std::string FederationLink::_name(const std::string& base) const
+{
+  if (_neighbour == "/")
+    return "/" + base;
+
+  return _neighbour + "/" + base;
+}
+
+//==============================================================================
+void FederationLink::_check()
+{
+  if (!_query_id.has_value())
+  {
+    if (!_registration_pending && _register_query_client->service_is_ready())
+      _register_query();
+
+    return;
+  }
+
+  // The neighbour only sends updates when its boundary maps change, so ask
+  // for anything that might have been missed once it has been quiet for a
+  // while. This also finds out if the neighbour has forgotten the query.
+  if (std::chrono::steady_clock::now() - _last_update > 5s)
+  {
+    _last_update = std::chrono::steady_clock::now();
+    _request_changes(false);
+  }
+}
+
+//==============================================================================
+void FederationLink::_register_query()
+{
+  auto query = rmf_traffic::schedule::query_all();
+  query.spacetime().query_timespan(_boundary_maps);
+
+  auto request = std::make_shared<RegisterQuery::Request>();
+  request->query = rmf_traffic_ros2::convert(query);
+
+  _registration_pending = true;
+  _register_query_client->async_send_request(
+    request,
+    [this](rclcpp::Client<RegisterQuery>::SharedFuture future)
+    {
+      _registration_pending = false;
+      const auto response = future.get();
+      _query_id = response->query_id;
+      _node_version = response->node_version;
+
+      RCLCPP_INFO(
+        _node.get_logger(),
+        "Mirroring the boundary maps of the schedule node in [%s] with query "
+        "[%lu]", _neighbour.c_str(), response->query_id);
+
+      _update_sub = _node.create_subscription<MirrorUpdate>(
+        _name(QueryUpdateTopicNameBase + std::to_string(*_query_id)),
+        rclcpp::SystemDefaultsQoS(),
+        [this](const MirrorUpdate::SharedPtr msg)
+        {
+          _handle_update(*msg);
+        });
+
+      _request_changes(true);
+    });
+}
+
+//==============================================================================
+void FederationLink::_request_changes(const bool full_update)
+{
+  if (!_query_id.has_value() || !_request_changes_client->service_is_ready())
+    return;
+
+  auto request = std::make_shared<RequestChanges::Request>();
+  request->query_id = *_query_id;
+  request->full_update = full_update;
+  request->version = full_update ? 0 : _mirror.latest_version();
+
+  _request_changes_client->async_send_request(
+    request,
+    [this](rclcpp::Client<RequestChanges>::SharedFuture future)
+    {
+      if (future.get()->result != RequestChanges::Response::UNKNOWN_QUERY_ID)
+        return;
+
+      // The neighbour was replaced by a node that does not know the query
+      RCLCPP_WARN(
+        _node.get_logger(),
+        "The schedule node in [%s] forgot the boundary query; registering "
+        "it again", _neighbour.c_str());
+      _update_sub.reset();
+      _query_id = std::nullopt;
+    });
+}
+
+//==============================================================================
+void FederationLink::_handle_update(const MirrorUpdate& msg)
+{
+  _last_update = std::chrono::steady_clock::now();
+  if (_node_version.has_value() && msg.node_version != *_node_version)
+  {
+    // A replacement node has taken over the neighbour. Its history continues
+    // from the one that was mirrored, so the patches can still be applied.
+    _node_version = msg.node_version;
+  }
+
+  std::vector<Change> changes;
+  try
+  {
+    const auto patch = rmf_traffic_ros2::convert(msg.patch);
+    if (!_mirror.update(patch))
+    {
+      if (!msg.is_remedial_update)
+        _request_changes(false);
+
+      return;
+    }
+
+    for (const auto& p : patch)
+      changes.push_back(_describe(p.participant_id()));
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_ERROR(
+      _node.get_logger(),
+      "Failed to mirror the boundary maps of [%s]: %s",
+      _neighbour.c_str(), e.what());
+    _request_changes(true);
+    return;
+  }
+
+  if (!changes.empty())
+    _handler(changes);
+}
+
+//==============================================================================
+void FederationLink::_handle_participants(const Participants& msg)
+{
+  std::vector<Change> changes;
+  try
+  {
+    const auto descriptions = rmf_traffic_ros2::convert(msg);
+    _mirror.update_participants_info(descriptions);
+
+    std::unordered_set<ParticipantId> known;
+    for (const auto& [id, _] : descriptions)
+      known.insert(id);
+
+    for (const auto id : _known)
+    {
+      if (known.count(id) == 0)
+        changes.push_back(Change{id, {}, std::nullopt});
+    }
+
+    _known = std::move(known);
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_ERROR(
+      _node.get_logger(),
+      "Failed to update the participants of [%s]: %s",
+      _neighbour.c_str(), e.what());
+    return;
+  }
+
+  if (!changes.empty())
+    _handler(changes);
+}
+
+//==============================================================================
+auto FederationLink::_describe(const ParticipantId participant) const
+-> Change
+{
+  Change change{participant, {}, std::nullopt};
+  const auto description = _mirror.get_participant(participant);
+  if (!description)
+    return change;
+
+  change.description = *description;
+  if (const auto itinerary = _mirror.get_itinerary(participant))
+  {
+    for (const auto& route : *itinerary)
+    {
+      if (!route)
+        continue;
+
+      const auto& map = route->map();
+      const bool on_boundary = std::find(
+        _boundary_maps.begin(), _boundary_maps.end(), map)
+        != _boundary_maps.end();
+
+      if (on_boundary)
+        change.routes.push_back(*route);
+    }
+  }
+
+  return change;
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_IngestionQueue.hpp"
+
+#include <algorithm>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+void IngestionQueue::push(Change change)
+{
+  // The count goes up before the change becomes visible, so a flush() that
+  // sees this change counted will wait until a batch containing it finishes.
+  _pushed.fetch_add(1);
+
+  Node* node = new Node{std::move(change), _head.load()};
+  while (!_head.compare_exchange_weak(node->next, node))
+  {
+    // Try again with the new head
+  }
+
+  if (_consumer_waiting.load())
+  {
+    // Taking the mutex makes sure the consumer is either still checking the
+    // queue, in which case it will see this change, or already asleep.
+    std::lock_guard<std::mutex> lock(_mutex);
+    _changes_cv.notify_one();
+  }
+}
+
+//==============================================================================
+std::vector<IngestionQueue::Change> IngestionQueue::take(
+  const std::chrono::milliseconds timeout)
+{
+  Node* node = _head.exchange(nullptr);
+  if (!node)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _consumer_waiting = true;
+    _changes_cv.wait_for(lock, timeout, [&]()
+      {
+        return _head.load() != nullptr || _stopped.load();
+      });
+    _consumer_waiting = false;
+    node = _head.exchange(nullptr);
+  }
+
+  std::vector<Change> changes;
+  while (node)
+  {
+    changes.emplace_back(std::move(node->change));
+    Node* const next = node->next;
+    delete node;
+    node = next;
+  }
+
+  // The stack hands out the newest change first
+  std::reverse(changes.begin(), changes.end());
+  return changes;
+}
+
+//==============================================================================
+void IngestionQueue::finish(const std::size_t count)
+{
+  if (count == 0)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _finished.fetch_add(count);
+  }
+  _finished_cv.notify_all();
+}
+
+//==============================================================================
+void IngestionQueue::flush()
+{
+  const uint64_t target = _pushed.load();
+  if (target <= _finished.load())
+    return;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _finished_cv.wait(lock, [&]()
+    {
+      return target <= _finished.load() || _stopped.load();
+    });
+}
+
+//==============================================================================
+void IngestionQueue::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+  }
+  _changes_cv.notify_all();
+  _finished_cv.notify_all();
+}
+
+//==============================================================================
+IngestionQueue::~IngestionQueue()
+{
+  Node* node = _head.exchange(nullptr);
+  while (node)
+  {
+    Node* const next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
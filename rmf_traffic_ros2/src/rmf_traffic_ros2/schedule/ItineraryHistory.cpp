@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_ItineraryHistory.hpp"
+
+#include <algorithm>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+ItineraryHistory::ItineraryHistory(std::size_t depth)
+: _depth(std::max<std::size_t>(1, depth))
+{
+  // Do nothing
+}
+
+//==============================================================================
+void ItineraryHistory::set(
+  const ParticipantId participant,
+  const Input& itinerary,
+  const ItineraryVersion version)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& snapshots = _snapshots[participant];
+  if (snapshots.size() >= _depth)
+    snapshots.pop_front();
+
+  Snapshot snapshot{version, {}};
+  snapshot.items.reserve(itinerary.size());
+  for (const auto& item : itinerary)
+    snapshot.items.push_back({item.id, item.route, rmf_traffic::Duration(0)});
+
+  snapshots.push_back(std::move(snapshot));
+}
+
+//==============================================================================
+void ItineraryHistory::extend(
+  const ParticipantId participant,
+  const Input& routes,
+  const ItineraryVersion version)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto snapshot = _next(participant, version);
+  if (!snapshot)
+    return;
+
+  for (const auto& item : routes)
+    snapshot->items.push_back({item.id, item.route, rmf_traffic::Duration(0)});
+}
+
+//==============================================================================
+void ItineraryHistory::delay(
+  const ParticipantId participant,
+  const rmf_traffic::Duration duration,
+  const ItineraryVersion version)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto snapshot = _next(participant, version);
+  if (!snapshot)
+    return;
+
+  for (auto& item : snapshot->items)
+    item.delay += duration;
+}
+
+//==============================================================================
+void ItineraryHistory::erase(
+  const ParticipantId participant,
+  const std::vector<rmf_traffic::RouteId>& routes,
+  const ItineraryVersion version)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto snapshot = _next(participant, version);
+  if (!snapshot)
+    return;
+
+  auto& items = snapshot->items;
+  items.erase(
+    std::remove_if(
+      items.begin(), items.end(),
+      [&routes](const Item& item)
+      {
+        return std::find(routes.begin(), routes.end(), item.id) != routes.end();
+      }),
+    items.end());
+}
+
+//==============================================================================
+void ItineraryHistory::clear(
+  const ParticipantId participant,
+  const ItineraryVersion version)
+{
+  set(participant, {}, version);
+}
+
+//==============================================================================
+void ItineraryHistory::forget(const ParticipantId participant)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _snapshots.erase(participant);
+}
+
+//==============================================================================
+auto ItineraryHistory::latest_version(const ParticipantId participant) const
+-> std::optional<ItineraryVersion>
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _snapshots.find(participant);
+  if (it == _snapshots.end() || it->second.empty())
+    return std::nullopt;
+
+  return it->second.back().version;
+}
+
+//==============================================================================
+auto ItineraryHistory::itinerary(
+  const ParticipantId participant,
+  const ItineraryVersion version) const -> std::optional<Input>
+{
+  std::vector<Item> items;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _snapshots.find(participant);
+    if (it == _snapshots.end())
+      return std::nullopt;
+
+    const auto s_it = std::find_if(
+      it->second.begin(), it->second.end(),
+      [version](const Snapshot& s) { return s.version == version; });
+
+    if (s_it == it->second.end())
+      return std::nullopt;
+
+    items = s_it->items;
+  }
+
+  Input itinerary;
+  itinerary.reserve(items.size());
+  for (const auto& item : items)
+  {
+    if (item.delay == rmf_traffic::Duration(0) || !item.route)
+    {
+      itinerary.push_back({item.id, item.route});
+      continue;
+    }
+
+    auto route = std::make_shared<rmf_traffic::Route>(*item.route);
+    if (route->trajectory().size() > 0)
+      route->trajectory().front().adjust_times(item.delay);
+
+    itinerary.push_back({item.id, std::move(route)});
+  }
+
+  return itinerary;
+}
+
+//==============================================================================
+auto ItineraryHistory::_next(
+  const ParticipantId participant,
+  const ItineraryVersion version) -> Snapshot*
+{
+  const auto it = _snapshots.find(participant);
+  if (it == _snapshots.end() || it->second.empty())
+    return nullptr;
+
+  auto& snapshots = it->second;
+  Snapshot snapshot{version, snapshots.back().items};
+  if (snapshots.size() >= _depth)
+    snapshots.pop_front();
+
+  snapshots.push_back(std::move(snapshot));
+  return &snapshots.back();
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic_ros2/schedule/ParticipantRegistry.hpp>
+#include "internal_YamlSerialization.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+// The YAML serialization of the registry is the source of truth for the
+// format of each record. These let us store those same records as compact
+// JSON lines, which are much cheaper to append and to parse than one large
+// YAML document.
+nlohmann::json to_json(const YAML::Node& node)
+{
+  if (node.IsMap())
+  {
+    nlohmann::json output = nlohmann::json::object();
+    for (const auto& item : node)
+      output[item.first.as<std::string>()] = to_json(item.second);
+
+    return output;
+  }
+
+  if (node.IsSequence())
+  {
+    nlohmann::json output = nlohmann::json::array();
+    for (const auto& item : node)
+      output.push_back(to_json(item));
+
+    return output;
+  }
+
+  if (node.IsScalar())
+    return node.Scalar();
+
+  return nullptr;
+}
+
+//==============================================================================
+YAML::Node to_yaml(const nlohmann::json& json)
+{
+  YAML::Node output;
+  if (json.is_object())
+  {
+    output = YAML::Node(YAML::NodeType::Map);
+    for (auto it = json.begin(); it != json.end(); ++it)
+      output[it.key()] = to_yaml(it.value());
+  }
+  else if (json.is_array())
+  {
+    output = YAML::Node(YAML::NodeType::Sequence);
+    for (const auto& value : json)
+      output.push_back(to_yaml(value));
+  }
+  else if (json.is_string())
+  {
+    output = json.get<std::string>();
+  }
+
+  return output;
+}
+
+//==============================================================================
+struct UniqueId
+{
+  std::string name;
+  std::string owner;
+
+  bool operator==(const UniqueId& other) const
+  {
+    return name == other.name && owner == other.owner;
+  }
+};
+
+//==============================================================================
+struct UniqueIdHasher
+{
+  std::size_t operator()(const UniqueId& id) const
+  {
+    return std::hash<std::string>{} (id.name + id.owner);
+  }
+};
+
+//==============================================================================
+UniqueId unique_key(const ParticipantDescription& description)
+{
+  return {description.name(), description.owner()};
+}
+} // anonymous namespace
+
+//==============================================================================
+class JournalLogger::Implementation
+{
+public:
+
+  //===========================================================================
+  Implementation(std::string file_path, Options options)
+  : _file_path(std::move(file_path)),
+    _options(options)
+  {
+    if (!std::filesystem::exists(_file_path))
+    {
+      std::filesystem::create_directories(
+        std::filesystem::absolute(_file_path).parent_path());
+    }
+    else
+    {
+      load();
+    }
+
+    _initial_size = _latest.size();
+
+    // If the journal was left with stale records or an interrupted write, we
+    // compact it before appending anything new to it. Otherwise a new record
+    // might get appended to the end of a torn line.
+    if (_torn_write || needs_compaction())
+      compact();
+    else
+      open();
+  }
+
+  //===========================================================================
+  ~Implementation()
+  {
+    if (_fd >= 0)
+    {
+      if (_unsynced > 0)
+        ::fsync(_fd);
+
+      ::close(_fd);
+    }
+  }
+
+  //===========================================================================
+  void write_operation(const AtomicOperation& operation)
+  {
+    const auto key = unique_key(operation.description);
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Only Add operations can be serialized. When the journal is replayed, an
+    // Add for a participant that was already seen replaces its description,
+    // which is exactly what an Update means.
+    const AtomicOperation record{
+      AtomicOperation::OpType::Add, operation.description};
+
+    const std::string line = to_json(serialize(record)).dump() + "\n";
+    append(line);
+    ++_num_records;
+
+    const auto it = _index.find(key);
+    if (it == _index.end())
+    {
+      _index[key] = _latest.size();
+      _latest.push_back({AtomicOperation::OpType::Add, operation.description});
+    }
+    else
+    {
+      _latest[it->second].description = operation.description;
+    }
+
+    if (needs_compaction())
+      compact();
+  }
+
+  //===========================================================================
+  std::optional<AtomicOperation> read_next_record()
+  {
+    if (_counter >= _initial_size)
+      return std::nullopt;
+
+    return _latest[_counter++];
+  }
+
+private:
+
+  //===========================================================================
+  void load()
+  {
+    std::ifstream file(_file_path);
+    if (!file)
+    {
+      throw std::runtime_error(
+        "[JournalLogger] Unable to open [" + _file_path + "] for reading");
+    }
+
+    std::string line;
+    std::size_t line_number = 0;
+    std::optional<std::string> parse_error;
+    while (std::getline(file, line))
+    {
+      ++line_number;
+      if (line.empty())
+        continue;
+
+      if (parse_error.has_value())
+      {
+        // A bad record was followed by more data, so it cannot be the result
+        // of an interrupted write.
+        throw std::runtime_error(*parse_error);
+      }
+
+      nlohmann::json record;
+      try
+      {
+        record = nlohmann::json::parse(line);
+      }
+      catch (const nlohmann::json::parse_error& e)
+      {
+        // This is only acceptable if it turns out to be the final line
+        parse_error = "[JournalLogger] Malformed record on line ["
+          + std::to_string(line_number) + "] of [" + _file_path + "]: "
+          + e.what();
+        continue;
+      }
+
+      auto operation = atomic_operation(to_yaml(record));
+      const auto key = unique_key(operation.description);
+      const auto it = _index.find(key);
+      if (it == _index.end())
+      {
+        // Registration order determines the IDs that the database assigns, so
+        // new participants must be replayed in the order they first appeared.
+        _index[key] = _latest.size();
+        _latest.push_back(
+          {AtomicOperation::OpType::Add, std::move(operation.description)});
+      }
+      else
+      {
+        _latest[it->second].description = std::move(operation.description);
+      }
+
+      ++_num_records;
+    }
+
+    _torn_write = parse_error.has_value();
+  }
+
+  //===========================================================================
+  bool needs_compaction() const
+  {
+    if (_num_records < _options.min_compaction_size)
+      return false;
+
+    return _options.compaction_ratio * static_cast<double>(_latest.size())
+      < static_cast<double>(_num_records);
+  }
+
+  //===========================================================================
+  void open()
+  {
+    _fd = ::open(_file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (_fd < 0)
+    {
+      throw std::runtime_error(
+        "[JournalLogger] Unable to open [" + _file_path + "] for writing: "
+        + std::strerror(errno));
+    }
+  }
+
+  //===========================================================================
+  void append(const std::string& data)
+  {
+    std::size_t written = 0;
+    while (written < data.size())
+    {
+      const auto result =
+        ::write(_fd, data.data() + written, data.size() - written);
+
+      if (result < 0)
+      {
+        if (errno == EINTR)
+          continue;
+
+        throw std::runtime_error(
+          "[JournalLogger] Failed to write to [" + _file_path + "]: "
+          + std::strerror(errno));
+      }
+
+      written += static_cast<std::size_t>(result);
+    }
+
+    ++_unsynced;
+    if (_options.fsync_interval > 0 && _options.fsync_interval <= _unsynced)
+    {
+      ::fsync(_fd);
+      _unsynced = 0;
+    }
+  }
+
+  //===========================================================================
+  void compact()
+  {
+    // Write the compacted journal next to the old one and then atomically
+    // swap it in, so a crash during compaction can never lose records.
+    const std::string temp_path = _file_path + ".compact";
+    {
+      std::ofstream file(temp_path, std::ios::out | std::ios::trunc);
+      for (const auto& operation : _latest)
+        file << to_json(serialize(operation)).dump() << "\n";
+
+      if (!file)
+      {
+        throw std::runtime_error(
+          "[JournalLogger] Failed to write compacted journal ["
+          + temp_path + "]");
+      }
+    }
+
+    const int temp_fd = ::open(temp_path.c_str(), O_RDONLY);
+    if (temp_fd >= 0)
+    {
+      ::fsync(temp_fd);
+      ::close(temp_fd);
+    }
+
+    if (_fd >= 0)
+    {
+      ::close(_fd);
+      _fd = -1;
+    }
+
+    std::filesystem::rename(temp_path, _file_path);
+    _num_records = _latest.size();
+    _unsynced = 0;
+    _torn_write = false;
+    open();
+  }
+
+  std::string _file_path;
+  Options _options;
+  int _fd = -1;
+  std::size_t _unsynced = 0;
+  std::size_t _num_records = 0;
+  bool _torn_write = false;
+
+  // The latest description of each participant, in the order that they first
+  // registered
+  std::vector<AtomicOperation> _latest;
+  std::unordered_map<UniqueId, std::size_t, UniqueIdHasher> _index;
+
+  std::size_t _initial_size = 0;
+  std::size_t _counter = 0;
+  std::mutex _mutex;
+};
+
+//=============================================================================
+JournalLogger::JournalLogger(std::string file_path, Options options)
+: _pimpl(rmf_utils::make_unique_impl<Implementation>(
+      std::move(file_path), options))
+{
+  // Do nothing
+}
+
+//=============================================================================
+JournalLogger::JournalLogger(std::string file_path)
+: JournalLogger(std::move(file_path), Options())
+{
+  // Do nothing
+}
+
+//=============================================================================
+void JournalLogger::write_operation(AtomicOperation operation)
+{
+  _pimpl->write_operation(operation);
+}
+
+//=============================================================================
+std::optional<AtomicOperation> JournalLogger::read_next_record()
+{
+  return _pimpl->read_next_record();
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_LocalMirrorUpdates.hpp"
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+
+#include <rclcpp/expand_topic_or_service_name.hpp>
+
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+LocalMirrorUpdates& LocalMirrorUpdates::get()
+{
+  static LocalMirrorUpdates instance;
+  return instance;
+}
+
+//==============================================================================
+std::string LocalMirrorUpdates::channel(const rclcpp::Node& node)
+{
+  return rclcpp::expand_topic_or_service_name(
+    QueryUpdateTopicNameBase, node.get_name(), node.get_namespace());
+}
+
+//==============================================================================
+std::shared_ptr<void> LocalMirrorUpdates::provide(
+  const std::string& channel,
+  const uint64_t node_version)
+{
+  uint64_t token;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    token = _next_token++;
+    auto& c = _channels[channel];
+    c.provider_token = token;
+    c.provider_version = node_version;
+  }
+
+  return std::make_shared<Handle>(
+    [channel, token]()
+    {
+      LocalMirrorUpdates::get()._withdraw(channel, token);
+    });
+}
+
+//==============================================================================
+std::optional<uint64_t> LocalMirrorUpdates::provider(
+  const std::string& channel) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _channels.find(channel);
+  if (it == _channels.end())
+    return std::nullopt;
+
+  return it->second.provider_version;
+}
+
+//==============================================================================
+std::shared_ptr<void> LocalMirrorUpdates::listen(
+  const std::string& channel,
+  const uint64_t query_id,
+  Listener listener)
+{
+  uint64_t token;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _channels.find(channel);
+    if (it == _channels.end() || !it->second.provider_version.has_value())
+      return nullptr;
+
+    token = _next_token++;
+    it->second.listeners[query_id][token] = std::move(listener);
+  }
+
+  return std::make_shared<Handle>(
+    [channel, query_id, token]()
+    {
+      LocalMirrorUpdates::get()._forget(channel, query_id, token);
+    });
+}
+
+//==============================================================================
+std::size_t LocalMirrorUpdates::deliver(
+  const std::string& channel,
+  const uint64_t query_id,
+  const Update& update) const
+{
+  // The lock is held while the listeners are called so that none of them can
+  // be called after its handle has been destroyed.
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto c = _channels.find(channel);
+  if (c == _channels.end())
+    return 0;
+
+  const auto it = c->second.listeners.find(query_id);
+  if (it == c->second.listeners.end())
+    return 0;
+
+  const std::optional<Update> value = update;
+  for (const auto& [_, listener] : it->second)
+    listener(value);
+
+  return it->second.size();
+}
+
+//==============================================================================
+void LocalMirrorUpdates::_withdraw(
+  const std::string& channel,
+  const uint64_t token)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _channels.find(channel);
+  if (it == _channels.end() || it->second.provider_token != token)
+    return;
+
+  // Every listener of this channel needs to go back to its update topic
+  for (const auto& query : it->second.listeners)
+  {
+    for (const auto& [_, listener] : query.second)
+      listener(std::nullopt);
+  }
+
+  _channels.erase(it);
+}
+
+//==============================================================================
+void LocalMirrorUpdates::_forget(
+  const std::string& channel,
+  const uint64_t query_id,
+  const uint64_t token)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto c = _channels.find(channel);
+  if (c == _channels.end())
+    return;
+
+  auto& listeners = c->second.listeners;
+  const auto it = listeners.find(query_id);
+  if (it == listeners.end())
+    return;
+
+  it->second.erase(token);
+  if (it->second.empty())
+    listeners.erase(it);
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -15,7 +15,12 @@
  *
 */
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <rclcpp/logger.hpp>
 #include <rclcpp/rclcpp.hpp>
@@ -23,6 +28,7 @@
 #include <rmf_utils/Modular.hpp>
 
 #include <rmf_traffic_ros2/StandardNames.hpp>
+#include <rmf_traffic_ros2/Time.hpp>
 #include <rmf_traffic_ros2/schedule/ParticipantDescription.hpp>
 #include <rmf_traffic_ros2/schedule/MirrorManager.hpp>
 #include <rmf_traffic_ros2/schedule/Patch.hpp>
@@ -39,6 +45,11 @@
 #include <rmf_traffic_msgs/srv/register_query.hpp>
 #include <rmf_traffic_msgs/srv/request_changes.hpp>
 
+#include <std_msgs/msg/u_int8_multi_array.hpp>
+
+#include "internal_CompactPatch.hpp"
+#include "internal_LocalMirrorUpdates.hpp"
+
 using namespace std::chrono_literals;
 
 namespace rmf_traffic_ros2 {
@@ -51,6 +62,9 @@ using ParticipantsInfoSub = rclcpp::Subscription<ParticipantsInfo>::SharedPtr;
 using MirrorUpdate = rmf_traffic_msgs::msg::MirrorUpdate;
 using MirrorUpdateSub = rclcpp::Subscription<MirrorUpdate>::SharedPtr;
 
+using CompactUpdate = std_msgs::msg::UInt8MultiArray;
+using CompactUpdateSub = rclcpp::Subscription<CompactUpdate>::SharedPtr;
+
 using RequestChanges = rmf_traffic_msgs::srv::RequestChanges;
 using RequestChangesFuture = rclcpp::Client<RequestChanges>::SharedFuture;
 using RequestChangesClient = rclcpp::Client<RequestChanges>::SharedPtr;
@@ -66,11 +80,83 @@ using FailOverEvent = rmf_traffic_msgs::msg::FailOverEvent;
 using FailOverEventSub = rclcpp::Subscription<FailOverEvent>::SharedPtr;
 
 namespace {
+// How long to wait for a remedial update before asking again for changes that
+// were already requested
+const auto remediation_request_interval = 1s;
+
+//==============================================================================
 bool is_new_version(const uint64_t expected_version, const uint64_t msg_version)
 {
   return rmf_utils::modular(expected_version).less_than(msg_version);
 }
-}
+
+//==============================================================================
+/// Hands out immutable snapshots of the mirror that are shared by every reader
+/// of the same generation of the mirror. A snapshot is only built when the
+/// first reader asks for it after the mirror has changed, so a burst of
+/// updates that nobody reads in between costs nothing, and a burst of
+/// planners that start after one change all share a single copy of the
+/// schedule. Readers only copy a shared_ptr while the mirror is unchanged, and
+/// a snapshot that a reader holds will never be changed underneath it.
+class PrebuiltSnapshots : public rmf_traffic::schedule::Snappable
+{
+public:
+
+  using ConstSnapshotPtr =
+    std::shared_ptr<const rmf_traffic::schedule::Snapshot>;
+
+  PrebuiltSnapshots(std::shared_ptr<const rmf_traffic::schedule::Mirror> mirror)
+  : _mirror(std::move(mirror))
+  {
+    // Do nothing
+  }
+
+  ConstSnapshotPtr snapshot() const final
+  {
+    const auto latest = std::atomic_load(&_latest);
+    if (latest && latest->generation == _generation.load())
+      return latest->snapshot;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto generation = _generation.load();
+    auto current = std::atomic_load(&_latest);
+    if (!current || current->generation != generation)
+    {
+      current = std::make_shared<const Built>(
+        Built{_mirror->snapshot(), generation});
+      std::atomic_store(&_latest, current);
+    }
+
+    return current->snapshot;
+  }
+
+  /// Lock this before changing the mirror, so that no snapshot gets built
+  /// from a mirror that is halfway through an update
+  std::unique_lock<std::mutex> lock() const
+  {
+    return std::unique_lock<std::mutex>(_mutex);
+  }
+
+  /// Call this after changing the mirror, while still holding the lock
+  void invalidate()
+  {
+    ++_generation;
+  }
+
+private:
+
+  struct Built
+  {
+    ConstSnapshotPtr snapshot;
+    uint64_t generation;
+  };
+
+  std::shared_ptr<const rmf_traffic::schedule::Mirror> _mirror;
+  mutable std::mutex _mutex;
+  std::atomic_uint64_t _generation{0};
+  mutable std::shared_ptr<const Built> _latest;
+};
+} // anonymous namespace
 
 //==============================================================================
 class MirrorManager::Implementation
@@ -91,18 +177,65 @@ public:
   FailOverEventSub fail_over_event_sub;
   MirrorUpdateSub mirror_update_sub;
   ParticipantsInfoSub participants_info_sub;
+
+  // Only used when Options::compact_updates() is turned on
+  CompactUpdateSub compact_update_sub;
+  CompactPatchDecoder compact_decoder;
   rclcpp::Subscription<ScheduleQueries>::SharedPtr queries_info_sub;
   RequestChangesClient request_changes_client;
   rclcpp::TimerBase::SharedPtr update_timer;
   rclcpp::TimerBase::SharedPtr redo_query_registration_timer;
   RegisterQueryClient register_query_client;
 
+  // Only created once this mirror asks for something other than the default
+  // update preferences
+  rclcpp::AsyncParametersClient::SharedPtr preferences_client;
+  rclcpp::TimerBase::SharedPtr preferences_timer;
+
+  // Only used when Options::max_history() is set
+  rclcpp::TimerBase::SharedPtr prune_timer;
+
   std::shared_ptr<rmf_traffic::schedule::Mirror> mirror;
 
+  // The participants from the last participants info message that was
+  // applied. Only participants that are new or have changed descriptions need
+  // to be converted again, and a message that changes nothing is skipped.
+  struct KnownParticipant
+  {
+    rmf_traffic_msgs::msg::ParticipantDescription msg;
+    rmf_traffic::schedule::ParticipantDescription description;
+  };
+  std::unordered_map<
+    rmf_traffic::schedule::ParticipantId, KnownParticipant> known_participants;
+
+  // This is only used when Options::prebuilt_snapshots() is turned on
+  std::shared_ptr<PrebuiltSnapshots> prebuilt_snapshots;
+
   bool initial_update = true;
 
   rmf_traffic::schedule::Version next_minimum_version = 0;
 
+  // The last request for changes that has not been answered by a remedial
+  // update yet. A std::nullopt minimum_version means a full update.
+  struct PendingRequest
+  {
+    std::optional<uint64_t> minimum_version;
+    std::chrono::steady_clock::time_point time;
+  };
+  std::optional<PendingRequest> pending_request;
+
+  // Updates that a schedule node in this process handed over directly. They
+  // are queued by the thread of the schedule node and applied by a one-shot
+  // timer on the thread of this mirror. A nullopt means that the schedule
+  // node has gone away.
+  std::mutex local_updates_mutex;
+  std::deque<std::optional<LocalMirrorUpdates::Update>> local_updates;
+  rclcpp::TimerBase::SharedPtr local_drain_timer;
+
+  // This must be declared after the queue so that the listener is removed
+  // before the queue is destroyed.
+  std::shared_ptr<void> local_listener;
+
   Implementation(
     const std::shared_ptr<rclcpp::Node>& node,
     rmf_traffic::schedule::Query _query,
@@ -114,8 +247,11 @@ public:
     options(std::move(_options)),
     mirror(std::make_shared<rmf_traffic::schedule::Mirror>())
   {
+    configure_snapshots();
+    configure_pruning();
     setup_update_topics();
     setup_queries_sub();
+    send_update_preferences();
 
     request_changes_client = node->create_client<RequestChanges>(
       rmf_traffic_ros2::RequestChangesServiceName);
@@ -219,6 +355,50 @@ public:
         handle_participants_info(msg);
       });
 
+    if (!listen_locally())
+      subscribe_to_update_topic();
+
+    // At this point we know we have the correct ID for our query
+    require_query_validation = false;
+    process_stashed_queries();
+
+    update_timer = node->create_wall_timer(
+      5s,
+      [this]() -> void
+      {
+        handle_update_timeout();
+      });
+  }
+
+  void subscribe_to_update_topic()
+  {
+    const auto node = weak_node.lock();
+    if (!node)
+      return;
+
+    local_listener.reset();
+    if (options.compact_updates())
+    {
+      const auto topic =
+        QueryCompactUpdateTopicNameBase + std::to_string(query_id);
+      RCLCPP_DEBUG(
+        node->get_logger(), "Registering to query topic %s", topic.c_str());
+
+      // The stream of the schedule node starts over with the remedial update
+      // that this mirror will ask for when it cannot follow the stream.
+      mirror_update_sub.reset();
+      compact_decoder.reset();
+      compact_update_sub = node->create_subscription<CompactUpdate>(
+        topic,
+        rclcpp::SystemDefaultsQoS(),
+        [this](const CompactUpdate::SharedPtr msg)
+        {
+          handle_compact_update(*msg);
+        });
+      return;
+    }
+
+    compact_update_sub.reset();
     RCLCPP_DEBUG(node->get_logger(), "Registering to query topic %s",
       (QueryUpdateTopicNameBase + std::to_string(query_id)).c_str());
     mirror_update_sub = node->create_subscription<MirrorUpdate>(
@@ -228,32 +408,291 @@ public:
       {
         handle_update(msg);
       });
-    // At this point we know we have the correct ID for our query
-    require_query_validation = false;
-    process_stashed_queries();
+  }
 
-    update_timer = node->create_wall_timer(
-      5s,
-      [this]() -> void
+  // If the schedule node that this mirror expects lives in the same process,
+  // receive its patches directly instead of subscribing to the update topic.
+  // Returns false if that is not possible.
+  bool listen_locally()
+  {
+    const auto node = weak_node.lock();
+    if (!node)
+      return false;
+
+    // Only the schedule node whose update topics this mirror would subscribe
+    // to may hand it patches, since other schedule nodes in this process have
+    // their own node versions and query IDs.
+    auto& local = LocalMirrorUpdates::get();
+    const auto channel = LocalMirrorUpdates::channel(*node);
+    if (local.provider(channel) != expected_node_version)
+      return false;
+
+    local_listener.reset();
+    local_listener = local.listen(
+      channel,
+      query_id,
+      [this](const std::optional<LocalMirrorUpdates::Update>& update)
       {
-        handle_update_timeout();
+        queue_local_update(update);
       });
+
+    if (!local_listener)
+      return false;
+
+    RCLCPP_DEBUG(
+      node->get_logger(),
+      "Receiving updates for query %d from the schedule node in this process",
+      query_id);
+    mirror_update_sub.reset();
+    compact_update_sub.reset();
+    return true;
+  }
+
+  void queue_local_update(
+    const std::optional<LocalMirrorUpdates::Update>& update)
+  {
+    // This is called from the thread of the schedule node
+    std::lock_guard<std::mutex> lock(local_updates_mutex);
+    local_updates.push_back(update);
+    if (local_drain_timer)
+      return;
+
+    const auto node = weak_node.lock();
+    if (!node)
+      return;
+
+    local_drain_timer = node->create_wall_timer(
+      0s, [this]() { drain_local_updates(); });
+  }
+
+  void drain_local_updates()
+  {
+    std::deque<std::optional<LocalMirrorUpdates::Update>> updates;
+    {
+      std::lock_guard<std::mutex> lock(local_updates_mutex);
+      if (local_drain_timer)
+        local_drain_timer->cancel();
+      local_drain_timer.reset();
+      updates.swap(local_updates);
+    }
+
+    for (const auto& update : updates)
+    {
+      if (!update.has_value())
+      {
+        // The schedule node of this process is gone, so go back to the update
+        // topic and catch up on anything that was missed.
+        subscribe_to_update_topic();
+        request_update(mirror->latest_version());
+        return;
+      }
+
+      handle_local_update(*update);
+    }
+  }
+
+  void handle_local_update(const LocalMirrorUpdates::Update& update)
+  {
+    if (!check_node_version(update.node_version))
+      return;
+
+    if (require_query_validation)
+    {
+      stash_patch(
+        update.node_version,
+        update.database_version,
+        *update.patch,
+        update.is_remedial_update);
+      return;
+    }
+
+    update_timer->reset();
+    apply_patch(*update.patch, update.is_remedial_update);
+  }
+
+  // The stash only holds messages, so a patch that did not arrive as a
+  // MirrorUpdate has to be converted. This only happens while the query is
+  // being validated after a fail over.
+  void stash_patch(
+    const uint64_t node_version,
+    const uint64_t database_version,
+    const rmf_traffic::schedule::Patch& patch,
+    const bool is_remedial_update)
+  {
+    auto msg = std::make_shared<MirrorUpdate>();
+    msg->node_version = node_version;
+    msg->database_version = database_version;
+    msg->patch = rmf_traffic_ros2::convert(patch);
+    msg->is_remedial_update = is_remedial_update;
+    stashed_query_updates.push_back(std::move(msg));
+  }
+
+  void handle_compact_update(const CompactUpdate& msg)
+  {
+    update_timer->reset();
+    const auto node = weak_node.lock();
+    if (!node)
+      return;
+
+    try
+    {
+      std::string data;
+      const auto header = read_compact_update(msg.data, data);
+      if (!check_node_version(header.node_version))
+        return;
+
+      const auto patch = compact_decoder.decode(data);
+      if (require_query_validation)
+      {
+        stash_patch(
+          header.node_version,
+          header.database_version,
+          patch,
+          header.is_remedial_update);
+        return;
+      }
+
+      apply_patch(patch, header.is_remedial_update);
+    }
+    catch (const std::exception& e)
+    {
+      // A missed update breaks the stream until the schedule node starts it
+      // over, which it does for the remedial update that gets requested here.
+      RCLCPP_WARN(
+        node->get_logger(),
+        "[rmf_traffic_ros2::MirrorManager] Failed to decode a compact update "
+        "for query [%ld]: %s. Requesting a remedial update.",
+        query_id,
+        e.what());
+      compact_decoder.reset();
+      request_update(mirror->latest_version());
+    }
+  }
+
+  void configure_snapshots()
+  {
+    if (!options.prebuilt_snapshots())
+    {
+      prebuilt_snapshots = nullptr;
+      return;
+    }
+
+    if (!prebuilt_snapshots)
+      prebuilt_snapshots = std::make_shared<PrebuiltSnapshots>(mirror);
+  }
+
+  /// Hold this lock while changing the mirror, and call refresh_snapshot()
+  /// before releasing it
+  std::unique_lock<std::mutex> lock_snapshots() const
+  {
+    if (prebuilt_snapshots)
+      return prebuilt_snapshots->lock();
+
+    return std::unique_lock<std::mutex>();
+  }
+
+  void refresh_snapshot()
+  {
+    if (prebuilt_snapshots)
+      prebuilt_snapshots->invalidate();
+  }
+
+  void configure_pruning()
+  {
+    const auto node = weak_node.lock();
+    if (!node || !options.max_history().has_value())
+    {
+      prune_timer.reset();
+      return;
+    }
+
+    if (!prune_timer)
+      prune_timer = node->create_wall_timer(1s, [this]() { prune(); });
+  }
+
+  void prune()
+  {
+    const auto node = weak_node.lock();
+    const auto history = options.max_history();
+    if (!node || !history.has_value())
+      return;
+
+    // Cull the mirror locally, without changing its version, so routes that
+    // finish while nothing else is changing still get evicted.
+    const auto version = mirror->latest_version();
+    const rmf_traffic::schedule::Patch cull(
+      {},
+      rmf_traffic::schedule::Change::Cull(
+        rmf_traffic_ros2::convert(node->now()) - *history),
+      version,
+      version);
+
+    const auto snapshot_lock = lock_snapshots();
+    std::mutex* update_mutex = options.update_mutex();
+    if (update_mutex)
+    {
+      std::lock_guard<std::mutex> lock(*update_mutex);
+      mirror->update(cull);
+    }
+    else
+    {
+      mirror->update(cull);
+    }
+
+    refresh_snapshot();
   }
 
   void handle_participants_info(const ParticipantsInfo::SharedPtr msg)
   {
     try
     {
+      bool changed = msg->participants.size() != known_participants.size();
+      std::unordered_map<rmf_traffic::schedule::ParticipantId, KnownParticipant>
+      next_known;
+      next_known.reserve(msg->participants.size());
+      rmf_traffic::schedule::ParticipantDescriptionsMap descriptions;
+      for (const auto& participant : msg->participants)
+      {
+        const auto it = known_participants.find(participant.id);
+        if (it != known_participants.end()
+          && it->second.msg == participant.description)
+        {
+          next_known.insert(*it);
+        }
+        else
+        {
+          changed = true;
+          next_known.insert(
+            {
+              participant.id,
+              KnownParticipant{
+                participant.description,
+                convert(participant.description)
+              }
+            });
+        }
+
+        descriptions.insert(
+          {participant.id, next_known.at(participant.id).description});
+      }
+
+      if (!changed)
+        return;
+
+      const auto snapshot_lock = lock_snapshots();
       std::mutex* update_mutex = options.update_mutex();
       if (update_mutex)
       {
         std::lock_guard<std::mutex> lock(*update_mutex);
-        mirror->update_participants_info(convert(*msg));
+        mirror->update_participants_info(descriptions);
       }
       else
       {
-        mirror->update_participants_info(convert(*msg));
+        mirror->update_participants_info(descriptions);
       }
+
+      known_participants = std::move(next_known);
+      refresh_snapshot();
     }
     catch (const std::exception& e)
     {
@@ -295,43 +734,55 @@ public:
     stashed_query_updates.clear();
   }
 
-  void handle_update(const MirrorUpdate::SharedPtr msg)
+  // Verify that the expected schedule node version sent an update. Returns
+  // false if the update should be ignored.
+  bool check_node_version(const uint64_t node_version)
   {
-    update_timer->reset();
     const auto node = weak_node.lock();
     if (!node)
-      return;
+      return false;
 
-    // Verify that the expected schedule node version sent the update
-
-    if (rmf_utils::modular(expected_node_version).less_than(msg->node_version))
+    if (rmf_utils::modular(expected_node_version).less_than(node_version))
     {
       RCLCPP_WARN(
         node->get_logger(),
         "Received query update from unexpected schedule node version %d (<%d);"
         " ignoring update",
-        msg->node_version,
+        node_version,
         expected_node_version);
-      return;
+      return false;
     }
-    else if (msg->node_version > expected_node_version)
+    else if (node_version > expected_node_version)
     {
       RCLCPP_WARN(
         node->get_logger(),
         "Received query update from unexpected schedule node version %d (>%d);"
         " validating query registration",
-        msg->node_version,
+        node_version,
         expected_node_version);
       require_query_validation = true;
-      expected_node_version = msg->node_version;
+      expected_node_version = node_version;
       stashed_query_updates.clear();
     }
-    else if (msg->node_version != expected_node_version)
+    else if (node_version != expected_node_version)
     {
       // Ignore this message because it's coming from an out-of-date version
-      return;
+      return false;
     }
 
+    return true;
+  }
+
+  void handle_update(const MirrorUpdate::SharedPtr msg)
+  {
+    update_timer->reset();
+    const auto node = weak_node.lock();
+    if (!node)
+      return;
+
+    if (!check_node_version(msg->node_version))
+      return;
+
     if (require_query_validation)
     {
       // Stash this query update until the query has been verified as correct
@@ -345,34 +796,7 @@ public:
 
     try
     {
-      const rmf_traffic::schedule::Patch patch = convert(msg->patch);
-
-      std::mutex* update_mutex = options.update_mutex();
-      if (update_mutex)
-      {
-        std::lock_guard<std::mutex> lock(*update_mutex);
-        if (!mirror->update(patch) && !msg->is_remedial_update)
-        {
-          RCLCPP_WARN(
-            node->get_logger(),
-            "Failed to update using patch for DB version %d; "
-            "requesting new update",
-            patch.latest_version());
-          request_update(mirror->latest_version());
-        }
-      }
-      else
-      {
-        if (!mirror->update(patch) && !msg->is_remedial_update)
-        {
-          RCLCPP_WARN(
-            node->get_logger(),
-            "Failed to update using patch for DB version %d; "
-            "requesting new update",
-            patch.latest_version());
-          request_update(mirror->latest_version());
-        }
-      }
+      apply_patch(convert(msg->patch), msg->is_remedial_update);
     }
     catch (const std::exception& e)
     {
@@ -386,6 +810,48 @@ public:
     }
   }
 
+  void apply_patch(
+    const rmf_traffic::schedule::Patch& patch,
+    const bool is_remedial_update)
+  {
+    const auto node = weak_node.lock();
+    if (!node)
+      return;
+
+    const auto snapshot_lock = lock_snapshots();
+    std::mutex* update_mutex = options.update_mutex();
+    if (update_mutex)
+    {
+      std::lock_guard<std::mutex> lock(*update_mutex);
+      if (!mirror->update(patch) && !is_remedial_update)
+      {
+        RCLCPP_WARN(
+          node->get_logger(),
+          "Failed to update using patch for DB version %d; "
+          "requesting new update",
+          patch.latest_version());
+        request_update(mirror->latest_version());
+      }
+    }
+    else
+    {
+      if (!mirror->update(patch) && !is_remedial_update)
+      {
+        RCLCPP_WARN(
+          node->get_logger(),
+          "Failed to update using patch for DB version %d; "
+          "requesting new update",
+          patch.latest_version());
+        request_update(mirror->latest_version());
+      }
+    }
+
+    if (is_remedial_update)
+      pending_request = std::nullopt;
+
+    refresh_snapshot();
+  }
+
   void handle_update_timeout()
   {
     const auto node = weak_node.lock();
@@ -402,6 +868,23 @@ public:
     if (!node)
       return;
 
+    // A dropped update makes every patch after it fail until the remedial
+    // update arrives, so only ask again if the request that is still pending
+    // would not cover this one, or if it has gone unanswered for too long.
+    const auto now = std::chrono::steady_clock::now();
+    if (pending_request.has_value()
+      && now - pending_request->time < remediation_request_interval)
+    {
+      const auto& pending_version = pending_request->minimum_version;
+      const bool covered = !pending_version.has_value()
+        || (minimum_version.has_value()
+        && !rmf_utils::modular(*minimum_version).less_than(*pending_version));
+
+      if (covered)
+        return;
+    }
+    pending_request = PendingRequest{minimum_version, now};
+
     RequestChanges::Request request;
     request.query_id = query_id;
     if (minimum_version.has_value())
@@ -451,6 +934,8 @@ public:
     // Make sure nothing is truly coming in on this topic and triggering a
     // callback while we are remaking it
     mirror_update_sub.reset();
+    compact_update_sub.reset();
+    local_listener.reset();
     // Also make sure we don't try to handle another update of queries,
     // or it might cause a particularly icky cycle of never-ending redos
     queries_info_sub.reset();
@@ -498,9 +983,11 @@ public:
             query_id);
           setup_update_topics();
           setup_queries_sub();
+          send_update_preferences();
           this->register_query_client.reset();
 
           // Finish by requesting an update on this newly subscribed query topic
+          this->pending_request = std::nullopt;
           request_update();
         });
 
@@ -514,6 +1001,77 @@ public:
     }
   }
 
+  void send_update_preferences()
+  {
+    const auto node = weak_node.lock();
+    if (!node)
+      return;
+
+    const auto rate = options.max_update_rate();
+    const bool background =
+      options.update_priority() == Options::Priority::Background;
+    const auto history = options.max_history();
+    const bool compact = options.compact_updates();
+
+    // The schedule node starts every query with the default preferences
+    if (!rate.has_value() && !background && !history.has_value() && !compact
+      && !preferences_client)
+    {
+      return;
+    }
+
+    if (!preferences_client)
+    {
+      preferences_client = std::make_shared<rclcpp::AsyncParametersClient>(
+        node, ScheduleNodeName);
+    }
+
+    if (!preferences_client->service_is_ready())
+    {
+      preferences_timer = node->create_wall_timer(
+        1s,
+        [this]()
+        {
+          preferences_timer.reset();
+          send_update_preferences();
+        });
+      return;
+    }
+
+    const auto prefix =
+      QueryPreferencesParameterPrefix + std::to_string(query_id) + ".";
+
+    preferences_client->set_parameters(
+      {
+        rclcpp::Parameter(prefix + "max_rate", rate.value_or(0.0)),
+        rclcpp::Parameter(prefix + "background", background),
+        rclcpp::Parameter(
+          prefix + "history",
+          history.has_value() ? rmf_traffic::time::to_seconds(*history) : -1.0),
+        rclcpp::Parameter(prefix + "compact", compact)
+      },
+      [weak_node = weak_node, query_id = query_id](
+        std::shared_future<
+          std::vector<rcl_interfaces::msg::SetParametersResult>> future)
+      {
+        const auto node = weak_node.lock();
+        if (!node)
+          return;
+
+        for (const auto& result : future.get())
+        {
+          if (result.successful)
+            continue;
+
+          RCLCPP_WARN(
+            node->get_logger(),
+            "Failed to set the update preferences of query [%ld]: %s",
+            query_id,
+            result.reason.c_str());
+        }
+      });
+  }
+
   void handle_fail_over_event(uint64_t new_schedule_node_version)
   {
     const auto node = weak_node.lock();
@@ -537,6 +1095,15 @@ public:
       require_query_validation = true;
       // The new schedule node will be one version higher
       expected_node_version = new_schedule_node_version;
+      // Anything that was requested from the old node will never be answered
+      pending_request = std::nullopt;
+      // The replacement node does not know the preferences of this mirror
+      send_update_preferences();
+
+      // The replacement node might not live in the same process as the node
+      // that this mirror was listening to.
+      if (!listen_locally() && local_listener)
+        subscribe_to_update_topic();
     }
   }
 
@@ -560,16 +1127,28 @@ public:
 
   bool update_on_wakeup;
 
+  bool prebuilt_snapshots;
+
+  std::optional<double> max_update_rate = std::nullopt;
+
+  Priority update_priority = Priority::Normal;
+
+  std::optional<rmf_traffic::Duration> max_history = std::nullopt;
+
+  bool compact_updates = false;
+
 };
 
 //==============================================================================
 MirrorManager::Options::Options(
   std::mutex* update_mutex,
-  bool update_on_wakeup)
+  bool update_on_wakeup,
+  bool prebuilt_snapshots)
 : _pimpl(rmf_utils::make_impl<Implementation>(
       Implementation{
         update_mutex,
-        update_on_wakeup
+        update_on_wakeup,
+        prebuilt_snapshots
       }))
 {
   // Do nothing
@@ -601,6 +1180,74 @@ auto MirrorManager::Options::update_on_wakeup(bool choice) -> Options&
   return *this;
 }
 
+//==============================================================================
+bool MirrorManager::Options::prebuilt_snapshots() const
+{
+  return _pimpl->prebuilt_snapshots;
+}
+
+//==============================================================================
+auto MirrorManager::Options::prebuilt_snapshots(bool choice) -> Options&
+{
+  _pimpl->prebuilt_snapshots = choice;
+  return *this;
+}
+
+//==============================================================================
+std::optional<double> MirrorManager::Options::max_update_rate() const
+{
+  return _pimpl->max_update_rate;
+}
+
+//==============================================================================
+auto MirrorManager::Options::max_update_rate(std::optional<double> rate)
+-> Options&
+{
+  _pimpl->max_update_rate = rate;
+  return *this;
+}
+
+//==============================================================================
+auto MirrorManager::Options::update_priority() const -> Priority
+{
+  return _pimpl->update_priority;
+}
+
+//==============================================================================
+auto MirrorManager::Options::update_priority(Priority priority) -> Options&
+{
+  _pimpl->update_priority = priority;
+  return *this;
+}
+
+//==============================================================================
+auto MirrorManager::Options::max_history() const
+-> std::optional<rmf_traffic::Duration>
+{
+  return _pimpl->max_history;
+}
+
+//==============================================================================
+auto MirrorManager::Options::max_history(
+  std::optional<rmf_traffic::Duration> history) -> Options&
+{
+  _pimpl->max_history = history;
+  return *this;
+}
+
+//==============================================================================
+bool MirrorManager::Options::compact_updates() const
+{
+  return _pimpl->compact_updates;
+}
+
+//==============================================================================
+auto MirrorManager::Options::compact_updates(bool choice) -> Options&
+{
+  _pimpl->compact_updates = choice;
+  return *this;
+}
+
 //==============================================================================
 const rmf_traffic::schedule::Viewer& MirrorManager::viewer() const
 {
@@ -611,6 +1258,9 @@ const rmf_traffic::schedule::Viewer& MirrorManager::viewer() const
 std::shared_ptr<rmf_traffic::schedule::Snappable>
 MirrorManager::snapshot_handle() const
 {
+  if (_pimpl->prebuilt_snapshots)
+    return _pimpl->prebuilt_snapshots;
+
   return _pimpl->mirror;
 }
 
@@ -629,7 +1279,20 @@ auto MirrorManager::get_options() const -> const Options&
 //==============================================================================
 MirrorManager& MirrorManager::set_options(Options options)
 {
+  const bool was_compact = _pimpl->options.compact_updates();
   _pimpl->options = std::move(options);
+  _pimpl->configure_snapshots();
+  _pimpl->configure_pruning();
+  _pimpl->send_update_preferences();
+
+  // Mirrors that receive their updates directly are not on either topic
+  if (was_compact != _pimpl->options.compact_updates()
+    && !_pimpl->local_listener)
+  {
+    _pimpl->subscribe_to_update_topic();
+    _pimpl->request_update(_pimpl->mirror->latest_version());
+  }
+
   return *this;
 }
 
@@ -102,8 +102,16 @@ void MonitorNode::start_heartbeat_listener()
         RCLCPP_ERROR(
           get_logger(),
           "Detected death of primary schedule node");
+        const auto start = std::chrono::steady_clock::now();
         on_fail_over_callback(create_new_schedule_node());
         announce_fail_over();
+        const auto finish = std::chrono::steady_clock::now();
+        RCLCPP_INFO(
+          get_logger(),
+          "Replacement schedule node took over at database version [%lu] in "
+          "[%.3f] ms",
+          mirror.value().viewer().latest_version(),
+          std::chrono::duration<double, std::milli>(finish - start).count());
       }
     };
   heartbeat_sub = create_subscription<Heartbeat>(
@@ -179,6 +187,10 @@ void MonitorNode::start_data_synchronisers()
 //==============================================================================
 std::shared_ptr<rclcpp::Node> MonitorNode::create_new_schedule_node()
 {
+  // The mirror receives the same stream of versioned patches as every other
+  // mirror, so this fork is already at the latest version that the primary
+  // managed to publish. The replacement node will only need to send the
+  // mirrors incremental updates from here.
   auto database = std::make_shared<Database>(mirror.value().fork());
   auto node = std::make_shared<rmf_traffic_ros2::schedule::ScheduleNode>(
     next_schedule_node_version,
@@ -16,6 +16,8 @@
 */
 
 #include "NegotiationRoom.hpp"
+#include "internal_NegotiationDiagnostics.hpp"
+#include "internal_RouteMessageCache.hpp"
 
 #include <rmf_traffic_ros2/Route.hpp>
 #include <rmf_traffic_ros2/schedule/Itinerary.hpp>
@@ -34,6 +36,11 @@
 
 #include <rclcpp/logging.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <optional>
+
 namespace rmf_traffic_ros2 {
 namespace schedule {
 
@@ -47,6 +54,28 @@ std::string table_to_string(
   return output;
 }
 
+//==============================================================================
+/// Leave out every alternative that is identical to one that comes before it.
+/// Planners often find the same itinerary from several starts, and each copy
+/// would otherwise be sent with every route and waypoint in full.
+void drop_duplicate_alternatives(
+  std::vector<rmf_traffic_msgs::msg::Itinerary>& alternatives)
+{
+  auto last = alternatives.begin();
+  for (auto it = alternatives.begin(); it != alternatives.end(); ++it)
+  {
+    if (std::find(alternatives.begin(), last, *it) != last)
+      continue;
+
+    if (last != it)
+      *last = std::move(*it);
+
+    ++last;
+  }
+
+  alternatives.erase(last, alternatives.end());
+}
+
 //==============================================================================
 template<typename T>
 std::string ptr_to_string(T* ptr)
@@ -68,13 +97,15 @@ public:
     Responder(
       Implementation* const impl_,
       const rmf_traffic::schedule::Version version_,
-      rmf_traffic::schedule::Negotiation::TablePtr table_)
+      rmf_traffic::schedule::Negotiation::TablePtr table_,
+      std::optional<std::size_t> local_participants_ = std::nullopt)
     : impl(impl_),
       conflict_version(version_),
       table(table_),
       table_version(table->version()),
       parent(table->parent()),
-      parent_version(parent ? OptVersion(parent->version()) : OptVersion())
+      parent_version(parent ? OptVersion(parent->version()) : OptVersion()),
+      local_participants(local_participants_)
     {
       // Do nothing
     }
@@ -103,12 +134,17 @@ public:
       std::vector<rmf_traffic::Route> itinerary,
       std::function<UpdateVersion()> approval_callback) const final
     {
-      responded = true;
+      std::lock_guard<std::recursive_mutex> lock(*impl->mutex);
+      record_response();
       if (table->defunct())
         return;
 
       if (table->submit(itinerary, table_version+1))
       {
+        // Keep track of the new version in case the negotiator follows up with
+        // an improved proposal
+        table_version = table->version();
+
         impl->approvals[conflict_version][table] = {
           table->sequence(),
           std::move(approval_callback)
@@ -116,6 +152,12 @@ public:
 
         impl->publish_proposal(conflict_version, *table);
 
+        if (local_participants.has_value()
+          && table->sequence().size() == *local_participants)
+        {
+          impl->approve_early(conflict_version, table);
+        }
+
         if (impl->worker)
         {
           for (const auto& c : table->children())
@@ -124,11 +166,18 @@ public:
             if (n_it == impl->negotiators->end())
               continue;
 
-            impl->worker->schedule(
+            // The negotiator is run without holding the lock, so negotiations
+            // on other workers can go on while it works out its response.
+            impl->worker->schedule_negotiation(
+              conflict_version,
               [viewer = c->viewer(),
-              negotiator = n_it->second.get(),
-              responder = make(impl, conflict_version, c)]()
+              negotiator = n_it->second,
+              responder = make(impl, conflict_version, c, local_participants),
+              diagnostics = impl->diagnostics,
+              queued = std::chrono::steady_clock::now()]()
               {
+                diagnostics->record_since("queue", queued);
+                responder->start();
                 negotiator->respond(viewer, responder);
               });
           }
@@ -138,7 +187,8 @@ public:
 
     void reject(const Alternatives& alternatives) const final
     {
-      responded = true;
+      std::lock_guard<std::recursive_mutex> lock(*impl->mutex);
+      record_response();
       if (parent && !parent->defunct())
       {
         // We will reject the parent to communicate that its proposal is not
@@ -171,7 +221,8 @@ public:
 
     void forfeit(const std::vector<ParticipantId>& /*blockers*/) const final
     {
-      responded = true;
+      std::lock_guard<std::recursive_mutex> lock(*impl->mutex);
+      record_response();
       if (!table->defunct())
       {
         // TODO(MXG): Consider using blockers to invite more participants into the
@@ -187,6 +238,13 @@ public:
         forfeit({});
     }
 
+    // Measure the response time from when the negotiator was asked to respond
+    // instead of from when the response was queued
+    void start()
+    {
+      started = std::chrono::steady_clock::now();
+    }
+
     ~Responder()
     {
       timeout();
@@ -198,21 +256,45 @@ public:
     const rmf_traffic::schedule::Version conflict_version;
 
     const rmf_traffic::schedule::Negotiation::TablePtr table;
-    rmf_traffic::schedule::Version table_version;
+    mutable rmf_traffic::schedule::Version table_version;
 
     using OptVersion = rmf_utils::optional<rmf_traffic::schedule::Version>;
     const rmf_traffic::schedule::Negotiation::TablePtr parent;
     OptVersion parent_version;
 
+    // The number of participants in the negotiation if all of them belong to
+    // this manager
+    const std::optional<std::size_t> local_participants;
+
     rclcpp::TimerBase::SharedPtr timer;
     mutable bool responded = false;
+    std::chrono::steady_clock::time_point started =
+      std::chrono::steady_clock::now();
+
+    void record_response() const
+    {
+      if (!responded)
+        impl->diagnostics->record_since("respond", started);
+
+      responded = true;
+    }
 
   };
 
   rclcpp::Node& node;
   std::shared_ptr<const rmf_traffic::schedule::Snappable> viewer;
   std::shared_ptr<Worker> worker;
+
+  // Guards the state of every negotiation. The subscriptions change it on the
+  // thread that spins the node, while responders may submit from the workers
+  // that negotiators are run on. It is recursive because negotiators that are
+  // run by respond_to_queue submit their responses right away. Handles of
+  // negotiators hold on to it weakly.
+  using MutexPtr = std::shared_ptr<std::recursive_mutex>;
+  MutexPtr mutex = std::make_shared<std::recursive_mutex>();
+
   rmf_traffic::Duration timeout = std::chrono::seconds(15);
+  std::shared_ptr<NegotiationDiagnostics> diagnostics;
 
   using Repeat = rmf_traffic_msgs::msg::NegotiationRepeat;
   using RepeatSub = rclcpp::Subscription<Repeat>;
@@ -236,6 +318,10 @@ public:
   ProposalSub::SharedPtr proposal_sub;
   ProposalPub::SharedPtr proposal_pub;
 
+  // Proposals get published again whenever another participant asks for a
+  // repeat, so we remember the messages of the routes that they contain.
+  RouteMessageCache route_cache;
+
   using Rejection = rmf_traffic_msgs::msg::NegotiationRejection;
   using RejectionSub = rclcpp::Subscription<Rejection>;
   using RejectionPub = rclcpp::Publisher<Rejection>;
@@ -292,6 +378,16 @@ public:
   using Approvals = std::unordered_map<Version, ApprovalCallbackMap>;
   Approvals approvals;
 
+  // Negotiations between local participants whose first complete table was
+  // approved without waiting for the conclusion, along with the sequence of
+  // that table and the acknowledgments that its approval produced
+  struct EarlyApproval
+  {
+    Negotiation::VersionedKeySequence sequence;
+    std::vector<ParticipantAck> acknowledgments;
+  };
+  std::unordered_map<Version, EarlyApproval> early_approvals;
+
   // Status update callbacks
   using TableViewPtr = rmf_traffic::schedule::Negotiation::Table::ViewerPtr;
   using StatusUpdateCallback =
@@ -303,6 +399,20 @@ public:
   StatusConclusionCallback conclusion_callback;
 
   uint retained_history_count = 0;
+  std::size_t cache_limit = NegotiationRoom::DefaultCacheLimit;
+
+  // Whether to keep track of negotiations that none of our negotiators are
+  // part of. When this is false, the messages of those negotiations are
+  // dropped before they get converted.
+  bool follow_unrelated = true;
+
+  // The order in which waiting tables get responded to
+  TablePriority table_priority = TablePriority::MostRecent;
+
+  // Whether negotiations between local participants get approved as soon as
+  // one of their tables is complete
+  bool resolve_locally = false;
+
   std::map<Version, rmf_traffic::schedule::Negotiation> history;
 
   Implementation(
@@ -312,6 +422,7 @@ public:
   : node(node_),
     viewer(std::move(viewer_)),
     worker(std::move(worker_)),
+    diagnostics(std::make_shared<NegotiationDiagnostics>(node_)),
     negotiators(std::make_shared<NegotiatorMap>()),
     failure_callbacks(std::make_shared<FailureMap>())
   {
@@ -322,6 +433,7 @@ public:
       NegotiationRepeatTopicName, qos,
       [&](const Repeat::UniquePtr msg)
       {
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
         this->receive_repeat_request(*msg);
       });
 
@@ -332,7 +444,10 @@ public:
       NegotiationNoticeTopicName, qos,
       [&](const Notice::UniquePtr msg)
       {
+        const auto start = std::chrono::steady_clock::now();
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
         this->receive_notice(*msg);
+        diagnostics->record_since("receive_notice", start);
       });
 
     notice_pub = node.create_publisher<Notice>(
@@ -345,7 +460,10 @@ public:
       NegotiationProposalTopicName, qos,
       [&](const Proposal::UniquePtr msg)
       {
+        const auto start = std::chrono::steady_clock::now();
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
         this->receive_proposal(*msg);
+        diagnostics->record_since("receive_proposal", start);
       });
 
     proposal_pub = node.create_publisher<Proposal>(
@@ -355,6 +473,7 @@ public:
       NegotiationRejectionTopicName, qos,
       [&](const Rejection::UniquePtr msg)
       {
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
         this->receive_rejection(*msg);
       });
 
@@ -365,6 +484,7 @@ public:
       NegotiationForfeitTopicName, qos,
       [&](const Forfeit::UniquePtr msg)
       {
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
         this->receive_forfeit(*msg);
       });
 
@@ -375,7 +495,10 @@ public:
       NegotiationConclusionTopicName, qos,
       [&](const Conclusion::UniquePtr msg)
       {
+        const auto start = std::chrono::steady_clock::now();
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
         this->receive_conclusion(*msg);
+        diagnostics->record_since("receive_conclusion", start);
       });
 
     ack_pub = node.create_publisher<Ack>(
@@ -424,14 +547,140 @@ public:
     publish_proposal(msg.conflict_version, *table);
   }
 
+  struct QueuedTable
+  {
+    TablePtr table;
+    std::optional<rmf_traffic::Time> deadline;
+  };
+
+  QueuedTable queue_entry(TablePtr table) const
+  {
+    std::optional<rmf_traffic::Time> deadline;
+    if (table_priority == TablePriority::Deadline)
+    {
+      for (const auto& proposal : table->viewer()->base_proposals())
+      {
+        for (const auto& route : proposal.itinerary)
+        {
+          const auto* start = route->trajectory().start_time();
+          if (start && (!deadline.has_value() || *start < *deadline))
+            deadline = *start;
+        }
+      }
+    }
+
+    return {std::move(table), deadline};
+  }
+
+  bool more_urgent(const QueuedTable& a, const QueuedTable& b) const
+  {
+    if (table_priority == TablePriority::Deadline
+      && a.deadline != b.deadline)
+    {
+      // Tables without any proposals to accommodate have no deadline
+      if (!a.deadline.has_value() || !b.deadline.has_value())
+        return a.deadline.has_value();
+
+      return *a.deadline < *b.deadline;
+    }
+
+    return a.table->sequence().size() > b.table->sequence().size();
+  }
+
+  TablePtr take_next(std::vector<QueuedTable>& queue) const
+  {
+    // The most recent table is at the back, and it wins any ties
+    auto next = std::prev(queue.end());
+    if (table_priority != TablePriority::MostRecent)
+    {
+      for (auto it = queue.begin(); it != next; ++it)
+      {
+        if (more_urgent(*it, *next))
+          next = it;
+      }
+    }
+
+    auto table = std::move(next->table);
+    queue.erase(next);
+    return table;
+  }
+
+  std::optional<std::size_t> local_participants(Version conflict_version) const
+  {
+    if (!resolve_locally)
+      return std::nullopt;
+
+    const auto it = negotiations.find(conflict_version);
+    if (it == negotiations.end())
+      return std::nullopt;
+
+    const auto& participants = it->second.room.negotiation.participants();
+    for (const auto p : participants)
+    {
+      if (negotiators->find(p) == negotiators->end())
+        return std::nullopt;
+    }
+
+    return participants.size();
+  }
+
+  void approve_early(Version conflict_version, const TablePtr& final_table)
+  {
+    if (early_approvals.count(conflict_version) > 0)
+      return;
+
+    const auto approval_it = approvals.find(conflict_version);
+    if (approval_it == approvals.end())
+      return;
+
+    // Every table from the root down to the final one needs to be approved,
+    // so we only go ahead if all of their callbacks are here.
+    std::vector<const CallbackEntry*> entries;
+    for (auto t = final_table; t; t = t->parent())
+    {
+      const auto entry_it = approval_it->second.find(t);
+      if (entry_it == approval_it->second.end())
+        return;
+
+      entries.push_back(&entry_it->second);
+    }
+
+    EarlyApproval early;
+    early.sequence = final_table->sequence();
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+      const auto& entry = **it;
+      ParticipantAck p_ack;
+      p_ack.participant = entry.sequence.back().participant;
+      p_ack.updating = false;
+      if (entry.callback)
+      {
+        if (const auto update_version = entry.callback())
+        {
+          p_ack.updating = true;
+          p_ack.itinerary_version = *update_version;
+        }
+      }
+
+      early.acknowledgments.emplace_back(std::move(p_ack));
+    }
+
+    early_approvals.insert({conflict_version, std::move(early)});
+  }
+
   void respond_to_queue(
-    std::vector<TablePtr> queue,
+    const std::vector<TablePtr>& tables,
     Version conflict_version)
   {
+    const auto local = local_participants(conflict_version);
+    std::vector<QueuedTable> queue;
+    queue.reserve(tables.size());
+    for (const auto& table : tables)
+      queue.push_back(queue_entry(table));
+
     while (!queue.empty())
     {
-      const auto top = queue.back();
-      queue.pop_back();
+      const auto top = take_next(queue);
 
       if (top->defunct())
         continue;
@@ -453,18 +702,18 @@ public:
 
         const auto& negotiator = n_it->second;
         negotiator->respond(
-          top->viewer(), Responder::make(this, conflict_version, top));
+          top->viewer(), Responder::make(this, conflict_version, top, local));
       }
 
       if (top->submission())
       {
         for (const auto& c : top->children())
-          queue.push_back(c);
+          queue.push_back(queue_entry(c));
       }
       else if (const auto& parent = top->parent())
       {
         if (parent->rejected())
-          queue.push_back(parent);
+          queue.push_back(queue_entry(parent));
       }
     }
   }
@@ -481,6 +730,13 @@ public:
       }
     }
 
+    if (!relevant && !follow_unrelated
+      && negotiations.find(msg.conflict_version) == negotiations.end())
+    {
+      // Without an entry for this negotiation, every other message about it
+      // will be ignored as soon as it arrives.
+      return;
+    }
 
     auto new_negotiation = Negotiation::make(
       viewer->snapshot(), msg.participants);
@@ -506,7 +762,13 @@ public:
     }
 
     const auto insertion = negotiations.insert(
-      {msg.conflict_version, Entry{relevant, *std::move(new_negotiation)}});
+      {
+        msg.conflict_version,
+        Entry{
+          relevant,
+          NegotiationRoom(*std::move(new_negotiation), cache_limit)
+        }
+      });
 
     const bool is_new = insertion.second;
     bool& participating = insertion.first->second.participating;
@@ -573,7 +835,7 @@ public:
       error += " " + std::to_string(msg.for_participant) + " ]";
 
       RCLCPP_WARN(node.get_logger(), error.c_str());
-      room.cached_proposals.push_back(msg);
+      room.cache(msg);
       return;
     }
 
@@ -639,7 +901,7 @@ public:
 
       RCLCPP_WARN(node.get_logger(), error.c_str());
 
-      room.cached_rejections.push_back(msg);
+      room.cache(msg);
       return;
     }
 
@@ -684,7 +946,7 @@ public:
     const auto table = search.table;
     if (!table)
     {
-      room.cached_forfeits.push_back(msg);
+      room.cache(msg);
       return;
     }
 
@@ -771,6 +1033,9 @@ public:
     auto& room = negotiate_it->second.room;
     Negotiation& negotiation = room.negotiation;
     const auto full_sequence = convert(msg.table);
+    diagnostics->record_since(
+      msg.resolved ? "negotiation_resolved" : "negotiation_failed",
+      room.opened);
 
     if (participating)
     {
@@ -782,12 +1047,38 @@ public:
         assert(approval_callback_it != approvals.end());
         const auto& approval_callbacks = approval_callback_it->second;
 
+        // The tables that were already approved early do not need to be
+        // approved again. If the schedule chose a different table, then only
+        // the participants below the point where the two tables diverge get
+        // approved, so nobody above it switches plans twice.
+        const auto early_it = early_approvals.find(msg.conflict_version);
+        const EarlyApproval* early = early_it == early_approvals.end() ?
+          nullptr : &early_it->second;
+
+        if (early && early->sequence != full_sequence)
+        {
+          RCLCPP_WARN(
+            node.get_logger(),
+            "Negotiation [%lu] concluded with a different table than the one "
+            "that was approved early. The participants whose proposals differ "
+            "will switch to the concluded table.",
+            msg.conflict_version);
+        }
+
         for (std::size_t i = 1; i <= msg.table.size(); ++i)
         {
           const auto sequence = Negotiation::VersionedKeySequence(
             full_sequence.begin(), full_sequence.begin()+i);
           const auto participant = sequence.back().participant;
 
+          if (early && i <= early->acknowledgments.size()
+            && std::equal(
+              sequence.begin(), sequence.end(), early->sequence.begin()))
+          {
+            acknowledgments.push_back(early->acknowledgments[i-1]);
+            continue;
+          }
+
           const auto search = negotiation.find(sequence);
           if (search.absent())
           {
@@ -867,6 +1158,18 @@ public:
       }
       else
       {
+        if (early_approvals.count(msg.conflict_version) > 0)
+        {
+          // The participants are already following the table that was approved
+          // early, but the schedule never accepted it. Approvals cannot be
+          // undone, so the failure callbacks below are what make them replan.
+          RCLCPP_WARN(
+            node.get_logger(),
+            "Negotiation [%lu] failed after one of its tables was approved "
+            "early. Its participants will be asked to replan.",
+            msg.conflict_version);
+        }
+
         for (const auto p : room.negotiation.participants())
         {
           // If we have a failure callback for one of the participants in this
@@ -910,6 +1213,8 @@ public:
 
       if (approval_callback_it != approvals.end())
         approvals.erase(approval_callback_it);
+
+      early_approvals.erase(msg.conflict_version);
     }
 
     if (conclusion_callback)
@@ -938,7 +1243,7 @@ public:
     msg.proposal_version = table.version();
 
     assert(table.submission());
-    msg.itinerary = convert(*table.submission());
+    msg.itinerary = route_cache.convert(*table.submission());
     msg.for_participant = table.participant();
     msg.to_accommodate = convert(table.sequence());
 
@@ -960,7 +1265,8 @@ public:
     msg.conflict_version = conflict_version;
     msg.table = convert(table.sequence());
     msg.rejected_by = rejected_by;
-    msg.alternatives = convert(alternatives);
+    msg.alternatives = route_cache.convert(alternatives);
+    drop_duplicate_alternatives(msg.alternatives);
 
     rejection_pub->publish(msg);
   }
@@ -981,10 +1287,12 @@ public:
     Handle(
       const ParticipantId for_participant_,
       NegotiatorMapPtr negotiators,
-      FailureMapPtr failure)
+      FailureMapPtr failure,
+      MutexPtr mutex)
     : for_participant(for_participant_),
       weak_negotiator_map(negotiators),
-      weak_failure_map(failure)
+      weak_failure_map(failure),
+      weak_mutex(mutex)
     {
       // Do nothing
     }
@@ -992,9 +1300,15 @@ public:
     ParticipantId for_participant;
     WeakNegotiatorMapPtr weak_negotiator_map;
     WeakFailureMapPtr weak_failure_map;
+    std::weak_ptr<std::recursive_mutex> weak_mutex;
 
     ~Handle()
     {
+      const auto mutex = weak_mutex.lock();
+      if (!mutex)
+        return;
+
+      std::lock_guard<std::recursive_mutex> lock(*mutex);
       if (const auto map = weak_negotiator_map.lock())
         map->erase(for_participant);
 
@@ -1008,6 +1322,7 @@ public:
     NegotiatorPtr negotiator,
     std::function<void()> failure_cb)
   {
+    std::lock_guard<std::recursive_mutex> lock(*mutex);
     const auto insertion = negotiators->insert(
       std::make_pair(for_participant, std::move(negotiator)));
 
@@ -1028,18 +1343,26 @@ public:
     }
 
     return std::make_shared<Handle>(
-      for_participant, negotiators, failure_callbacks);
+      for_participant, negotiators, failure_callbacks, mutex);
   }
 
   void set_retained_history_count(uint count)
   {
+    std::lock_guard<std::recursive_mutex> lock(*mutex);
     retained_history_count = count;
   }
 
+  void set_cache_limit(std::size_t limit)
+  {
+    std::lock_guard<std::recursive_mutex> lock(*mutex);
+    cache_limit = limit;
+  }
+
   TableViewPtr table_view(
     uint64_t conflict_version,
     const std::vector<ParticipantId>& sequence) const
   {
+    std::lock_guard<std::recursive_mutex> lock(*mutex);
     const auto negotiate_it = negotiations.find(conflict_version);
     rmf_traffic::schedule::Negotiation::ConstTablePtr table;
 
@@ -1076,15 +1399,25 @@ public:
 
   void on_status_update(StatusUpdateCallback cb)
   {
+    std::lock_guard<std::recursive_mutex> lock(*mutex);
     status_callback = cb;
   }
 
   void on_conclusion(StatusConclusionCallback cb)
   {
+    std::lock_guard<std::recursive_mutex> lock(*mutex);
     conclusion_callback = cb;
   }
 };
 
+//==============================================================================
+void Negotiation::Worker::schedule_negotiation(
+  uint64_t,
+  std::function<void()> job)
+{
+  schedule(std::move(job));
+}
+
 //==============================================================================
 Negotiation::Negotiation(
   rclcpp::Node& node,
@@ -1135,6 +1468,51 @@ void Negotiation::set_retained_history_count(uint count)
   return _pimpl->set_retained_history_count(count);
 }
 
+//==============================================================================
+void Negotiation::set_cache_limit(std::size_t limit)
+{
+  return _pimpl->set_cache_limit(limit);
+}
+
+//==============================================================================
+Negotiation& Negotiation::follow_unrelated_negotiations(bool follow)
+{
+  _pimpl->follow_unrelated = follow;
+  return *this;
+}
+
+//==============================================================================
+bool Negotiation::follow_unrelated_negotiations() const
+{
+  return _pimpl->follow_unrelated;
+}
+
+//==============================================================================
+Negotiation& Negotiation::table_priority(TablePriority priority)
+{
+  _pimpl->table_priority = priority;
+  return *this;
+}
+
+//==============================================================================
+auto Negotiation::table_priority() const -> TablePriority
+{
+  return _pimpl->table_priority;
+}
+
+//==============================================================================
+Negotiation& Negotiation::resolve_local_negotiations(bool resolve)
+{
+  _pimpl->resolve_locally = resolve;
+  return *this;
+}
+
+//==============================================================================
+bool Negotiation::resolve_local_negotiations() const
+{
+  return _pimpl->resolve_locally;
+}
+
 //==============================================================================
 std::shared_ptr<void> Negotiation::register_negotiator(
   rmf_traffic::schedule::ParticipantId for_participant,
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_NegotiationDiagnostics.hpp"
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+diagnostic_msgs::msg::KeyValue make_key_value(
+  std::string key,
+  std::string value)
+{
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = std::move(key);
+  kv.value = std::move(value);
+  return kv;
+}
+
+//==============================================================================
+std::string format_ms(const double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+  return buffer;
+}
+
+//==============================================================================
+std::string bound_to_string(const double bound)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%g", bound);
+  return buffer;
+}
+} // anonymous namespace
+
+//==============================================================================
+const std::vector<double>& NegotiationDiagnostics::Histogram::bounds()
+{
+  static const std::vector<double> bounds = {
+    1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 500.0,
+    1000.0, 2000.0, 5000.0, 10000.0
+  };
+
+  return bounds;
+}
+
+//==============================================================================
+void NegotiationDiagnostics::Histogram::record(const Duration duration)
+{
+  const double ms = rmf_traffic::time::to_seconds(duration) * 1e3;
+  const auto& b = bounds();
+  const auto bucket = std::lower_bound(b.begin(), b.end(), ms) - b.begin();
+  ++counts[bucket];
+  ++count;
+  total += duration;
+  max = std::max(max, duration);
+}
+
+//==============================================================================
+NegotiationDiagnostics::NegotiationDiagnostics(
+  rclcpp::Node& node,
+  const Duration publish_period)
+: _source(node.get_fully_qualified_name()),
+  _clock(node.get_clock())
+{
+  _publisher = node.create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+    NegotiationDiagnosticsTopicName,
+    rclcpp::SystemDefaultsQoS().reliable().keep_last(10));
+
+  _timer = node.create_wall_timer(publish_period, [this]() { publish(); });
+}
+
+//==============================================================================
+void NegotiationDiagnostics::record(
+  const std::string& phase,
+  const Duration duration)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _histograms[phase].record(duration);
+  _changed = true;
+}
+
+//==============================================================================
+void NegotiationDiagnostics::record_since(
+  const std::string& phase,
+  const std::chrono::steady_clock::time_point start)
+{
+  record(phase, std::chrono::steady_clock::now() - start);
+}
+
+//==============================================================================
+auto NegotiationDiagnostics::histograms() const
+-> std::map<std::string, Histogram>
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _histograms;
+}
+
+//==============================================================================
+void NegotiationDiagnostics::publish()
+{
+  std::map<std::string, Histogram> histograms;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_changed)
+      return;
+
+    _changed = false;
+    histograms = _histograms;
+  }
+
+  using rmf_traffic::time::to_seconds;
+  const auto& bounds = Histogram::bounds();
+  diagnostic_msgs::msg::DiagnosticArray msg;
+  msg.header.stamp = _clock->now();
+  for (const auto& [phase, histogram] : histograms)
+  {
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = _source + ": negotiation " + phase;
+    status.hardware_id = _source;
+    status.message = "Durations of the " + phase + " phase of negotiations";
+
+    status.values.push_back(
+      make_key_value("count", std::to_string(histogram.count)));
+    status.values.push_back(
+      make_key_value(
+        "mean_ms", format_ms(1e3 * to_seconds(histogram.total)
+        / histogram.count)));
+    status.values.push_back(
+      make_key_value("max_ms", format_ms(1e3 * to_seconds(histogram.max))));
+
+    // Each bucket counts the durations up to its bound, and the last bucket
+    // counts everything above the largest bound.
+    for (std::size_t i = 0; i < bounds.size(); ++i)
+    {
+      status.values.push_back(
+        make_key_value(
+          "bucket_le_" + bound_to_string(bounds[i]) + "_ms",
+          std::to_string(histogram.counts[i])));
+    }
+
+    status.values.push_back(
+      make_key_value(
+        "bucket_gt_" + bound_to_string(bounds.back()) + "_ms",
+        std::to_string(histogram.counts.back())));
+
+    msg.status.push_back(std::move(status));
+  }
+
+  _publisher->publish(msg);
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -56,12 +56,126 @@ std::vector<rmf_traffic_msgs::msg::NegotiationKey> convert(
 namespace schedule {
 
 //==============================================================================
-NegotiationRoom::NegotiationRoom(rmf_traffic::schedule::Negotiation negotiation_)
-: negotiation(std::move(negotiation_))
+std::size_t VersionedKeySequenceHash::operator()(
+  const rmf_traffic::schedule::Negotiation::VersionedKeySequence& s) const
+{
+  std::size_t seed = s.size();
+  for (const auto& key : s)
+  {
+    for (const std::size_t value : {key.participant, key.version})
+      seed ^= std::hash<std::size_t>{}(value)
+        + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+
+  return seed;
+}
+
+//==============================================================================
+bool VersionedKeySequenceEqual::operator()(
+  const rmf_traffic::schedule::Negotiation::VersionedKeySequence& a,
+  const rmf_traffic::schedule::Negotiation::VersionedKeySequence& b) const
+{
+  if (a.size() != b.size())
+    return false;
+
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    if (a[i].participant != b[i].participant || a[i].version != b[i].version)
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+NegotiationRoom::NegotiationRoom(
+  rmf_traffic::schedule::Negotiation negotiation_,
+  const std::size_t cache_limit_)
+: negotiation(std::move(negotiation_)),
+  _cache_limit(cache_limit_)
 {
   // Do nothing
 }
 
+//==============================================================================
+namespace {
+NegotiationRoom::VersionedKeySequence parent_of(
+  const std::vector<rmf_traffic_msgs::msg::NegotiationKey>& table)
+{
+  auto parent = convert(table);
+  if (!parent.empty())
+    parent.pop_back();
+
+  return parent;
+}
+} // anonymous namespace
+
+//==============================================================================
+void NegotiationRoom::cache(Proposal proposal)
+{
+  group(convert(proposal.to_accommodate)).proposals.push_back(
+    std::move(proposal));
+  ++_cached_count;
+  enforce_cache_limit();
+}
+
+//==============================================================================
+void NegotiationRoom::cache(Rejection rejection)
+{
+  group(parent_of(rejection.table)).rejections.push_back(std::move(rejection));
+  ++_cached_count;
+  enforce_cache_limit();
+}
+
+//==============================================================================
+void NegotiationRoom::cache(Forfeit forfeit)
+{
+  group(parent_of(forfeit.table)).forfeits.push_back(std::move(forfeit));
+  ++_cached_count;
+  enforce_cache_limit();
+}
+
+//==============================================================================
+std::size_t NegotiationRoom::cached_count() const
+{
+  return _cached_count;
+}
+
+//==============================================================================
+std::size_t NegotiationRoom::CachedMessages::size() const
+{
+  return proposals.size() + rejections.size() + forfeits.size();
+}
+
+//==============================================================================
+auto NegotiationRoom::group(VersionedKeySequence parent) -> CachedMessages&
+{
+  const auto insertion = _cache.insert({parent, CachedMessages()});
+  auto& entry = insertion.first->second;
+  if (insertion.second)
+  {
+    entry.order = _next_order++;
+    _cache_order.insert({entry.order, std::move(parent)});
+  }
+
+  return entry;
+}
+
+//==============================================================================
+auto NegotiationRoom::erase(Cache::iterator it) -> Cache::iterator
+{
+  _cached_count -= it->second.size();
+  _cache_order.erase(it->second.order);
+  return _cache.erase(it);
+}
+
+//==============================================================================
+void NegotiationRoom::enforce_cache_limit()
+{
+  while (_cached_count > _cache_limit && !_cache_order.empty())
+    erase(_cache.find(_cache_order.begin()->second));
+}
+
 //==============================================================================
 std::vector<rmf_traffic::schedule::Negotiation::TablePtr> NegotiationRoom::
 check_cache(const NegotiatorMap& negotiators)
@@ -73,79 +187,117 @@ check_cache(const NegotiatorMap& negotiators)
   {
     recheck = false;
 
-    for (auto it = cached_proposals.begin(); it != cached_proposals.end(); )
+    for (auto group_it = _cache.begin(); group_it != _cache.end(); )
     {
-      const auto& proposal = *it;
-      const auto search = negotiation.find(
-        proposal.for_participant, convert(proposal.to_accommodate));
-
-      if (search.deprecated())
-      {
-        cached_proposals.erase(it++);
-        continue;
-      }
-
-      const auto table = search.table;
-      if (table)
+      // Every message in a group refers to a child of the same parent table,
+      // and those children only exist once the parent has a proposal, so the
+      // whole group can be skipped until then.
+      const auto& parent = group_it->first;
+      if (!parent.empty())
       {
-        const bool updated = table->submit(
-          rmf_traffic_ros2::convert(
-            proposal.itinerary), proposal.proposal_version);
-        if (updated)
-          new_tables.push_back(table);
-
-        recheck = true;
-        cached_proposals.erase(it++);
+        const auto parent_search = negotiation.find(parent);
+        if (parent_search.deprecated())
+        {
+          group_it = erase(group_it);
+          continue;
+        }
+
+        if (!parent_search.table || !parent_search.table->submission())
+        {
+          ++group_it;
+          continue;
+        }
       }
-      else
-        ++it;
-    }
-
-    for (auto it = cached_rejections.begin(); it != cached_rejections.end(); )
-    {
-      const auto& rejection = *it;
-      const auto search = negotiation.find(convert(rejection.table));
 
-      if (search.deprecated())
+      auto& cached = group_it->second;
+      auto& cached_proposals = cached.proposals;
+      for (auto it = cached_proposals.begin(); it != cached_proposals.end(); )
       {
-        cached_rejections.erase(it++);
-        continue;
+        const auto& proposal = *it;
+        const auto search = negotiation.find(
+          proposal.for_participant, convert(proposal.to_accommodate));
+
+        if (search.deprecated())
+        {
+          cached_proposals.erase(it++);
+          --_cached_count;
+          continue;
+        }
+
+        const auto table = search.table;
+        if (table)
+        {
+          const bool updated = table->submit(
+            rmf_traffic_ros2::convert(
+              proposal.itinerary), proposal.proposal_version);
+          if (updated)
+            new_tables.push_back(table);
+
+          recheck = true;
+          cached_proposals.erase(it++);
+          --_cached_count;
+        }
+        else
+          ++it;
       }
 
-      const auto table = search.table;
-      if (table)
+      auto& cached_rejections = cached.rejections;
+      for (auto it = cached_rejections.begin(); it != cached_rejections.end(); )
       {
-        table->reject(
-          rejection.table.back().version,
-          rejection.rejected_by,
-          rmf_traffic_ros2::convert(rejection.alternatives));
-        recheck = true;
-        cached_rejections.erase(it++);
+        const auto& rejection = *it;
+        const auto search = negotiation.find(convert(rejection.table));
+
+        if (search.deprecated())
+        {
+          cached_rejections.erase(it++);
+          --_cached_count;
+          continue;
+        }
+
+        const auto table = search.table;
+        if (table)
+        {
+          table->reject(
+            rejection.table.back().version,
+            rejection.rejected_by,
+            rmf_traffic_ros2::convert(rejection.alternatives));
+          recheck = true;
+          cached_rejections.erase(it++);
+          --_cached_count;
+        }
+        else
+          ++it;
       }
-      else
-        ++it;
-    }
 
-    for (auto it = cached_forfeits.begin(); it != cached_forfeits.end(); )
-    {
-      const auto& forfeit = *it;
-      const auto search = negotiation.find(convert(forfeit.table));
-
-      if (search.deprecated())
+      auto& cached_forfeits = cached.forfeits;
+      for (auto it = cached_forfeits.begin(); it != cached_forfeits.end(); )
       {
-        cached_forfeits.erase(it++);
-        continue;
+        const auto& forfeit = *it;
+        const auto search = negotiation.find(convert(forfeit.table));
+
+        if (search.deprecated())
+        {
+          cached_forfeits.erase(it++);
+          --_cached_count;
+          continue;
+        }
+
+        const auto table = search.table;
+        if (table)
+        {
+          table->forfeit(forfeit.table.back().version);
+          recheck = true;
+          cached_forfeits.erase(it++);
+          --_cached_count;
+        }
+        else
+          ++it;
       }
 
-      const auto table = search.table;
-      if (table)
-      {
-        table->forfeit(forfeit.table.back().version);
-        recheck = true;
-        cached_forfeits.erase(it++);
-      }
+      if (cached.size() == 0)
+        group_it = erase(group_it);
       else
-        ++it;
+        ++group_it;
     }
 
   } while (recheck);
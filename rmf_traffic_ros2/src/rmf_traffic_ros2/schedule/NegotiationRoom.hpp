@@ -25,7 +25,10 @@
 #include <rmf_traffic_msgs/msg/negotiation_forfeit.hpp>
 #include <rmf_traffic_msgs/msg/negotiation_key.hpp>
 
+#include <chrono>
 #include <list>
+#include <map>
+#include <unordered_map>
 
 namespace rmf_traffic_ros2 {
 
@@ -40,22 +43,95 @@ std::vector<rmf_traffic_msgs::msg::NegotiationKey> convert(
 namespace schedule {
 
 using ParticipantId = rmf_traffic::schedule::ParticipantId;
-using NegotiatorPtr = std::unique_ptr<rmf_traffic::schedule::Negotiator>;
+
+// Shared so that a negotiator outlives the jobs that are still using it when
+// it gets unregistered
+using NegotiatorPtr = std::shared_ptr<rmf_traffic::schedule::Negotiator>;
 using NegotiatorMap = std::unordered_map<ParticipantId, NegotiatorPtr>;
 
+//==============================================================================
+struct VersionedKeySequenceHash
+{
+  std::size_t operator()(
+    const rmf_traffic::schedule::Negotiation::VersionedKeySequence& s) const;
+};
+
+//==============================================================================
+struct VersionedKeySequenceEqual
+{
+  bool operator()(
+    const rmf_traffic::schedule::Negotiation::VersionedKeySequence& a,
+    const rmf_traffic::schedule::Negotiation::VersionedKeySequence& b) const;
+};
+
 //==============================================================================
 // TODO(MXG): Refactor this class into something more broadly usable.
 struct NegotiationRoom
 {
-  NegotiationRoom(rmf_traffic::schedule::Negotiation negotiation_);
+  using Proposal = rmf_traffic_msgs::msg::NegotiationProposal;
+  using Rejection = rmf_traffic_msgs::msg::NegotiationRejection;
+  using Forfeit = rmf_traffic_msgs::msg::NegotiationForfeit;
+  using VersionedKeySequence =
+    rmf_traffic::schedule::Negotiation::VersionedKeySequence;
+
+  /// The default number of messages that a room will cache while it waits for
+  /// the tables that they refer to
+  static constexpr std::size_t DefaultCacheLimit = 1000;
+
+  NegotiationRoom(
+    rmf_traffic::schedule::Negotiation negotiation_,
+    std::size_t cache_limit_ = DefaultCacheLimit);
 
   rmf_traffic::schedule::Negotiation negotiation;
-  std::list<rmf_traffic_msgs::msg::NegotiationProposal> cached_proposals;
-  std::list<rmf_traffic_msgs::msg::NegotiationRejection> cached_rejections;
-  std::list<rmf_traffic_msgs::msg::NegotiationForfeit> cached_forfeits;
+
+  /// When this room was opened
+  std::chrono::steady_clock::time_point opened =
+    std::chrono::steady_clock::now();
+
+  /// Cache a message whose table is not known yet. When the cache is full, the
+  /// messages that have been waiting the longest get dropped.
+  void cache(Proposal proposal);
+  void cache(Rejection rejection);
+  void cache(Forfeit forfeit);
+
+  /// The number of messages that are currently cached
+  std::size_t cached_count() const;
 
   std::vector<rmf_traffic::schedule::Negotiation::TablePtr> check_cache(
     const NegotiatorMap& negotiators);
+
+private:
+
+  // Messages that are waiting for the same parent table to receive a proposal
+  struct CachedMessages
+  {
+    std::list<Proposal> proposals;
+    std::list<Rejection> rejections;
+    std::list<Forfeit> forfeits;
+
+    // When this group was created, as a key of _cache_order
+    uint64_t order;
+
+    std::size_t size() const;
+  };
+
+  using Cache = std::unordered_map<
+    VersionedKeySequence,
+    CachedMessages,
+    VersionedKeySequenceHash,
+    VersionedKeySequenceEqual>;
+
+  CachedMessages& group(VersionedKeySequence parent);
+  Cache::iterator erase(Cache::iterator it);
+  void enforce_cache_limit();
+
+  std::size_t _cache_limit;
+  std::size_t _cached_count = 0;
+  Cache _cache;
+
+  // The parents of the cache groups, in the order that the groups were created
+  uint64_t _next_order = 0;
+  std::map<uint64_t, VersionedKeySequence> _cache_order;
 };
 
 //==============================================================================
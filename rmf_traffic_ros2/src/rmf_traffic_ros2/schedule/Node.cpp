@@ -16,6 +16,11 @@
 */
 
 #include "internal_Node.hpp"
+#include "internal_CheckedRoutes.hpp"
+#include "internal_CircleConflict.hpp"
+#include "internal_ConflictIndex.hpp"
+#include "internal_LocalMirrorUpdates.hpp"
+#include "internal_WorkerPool.hpp"
 
 #include <cstring>
 
@@ -35,15 +40,110 @@
 
 #include <rmf_utils/optional.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string_view>
 #include <unordered_map>
 
 namespace rmf_traffic_ros2 {
 namespace schedule {
 
+//==============================================================================
+struct RouteChange
+{
+  rmf_traffic::schedule::ParticipantId participant;
+  const rmf_traffic::schedule::ParticipantDescription* description;
+  rmf_traffic::ConstRoutePtr route;
+};
+
+//==============================================================================
+/// Figure out which routes in the mirror were added or modified by a patch
+/// that has already been applied to it.
+std::vector<RouteChange> get_route_changes(
+  const rmf_traffic::schedule::Patch& patch,
+  const rmf_traffic::schedule::Mirror& mirror)
+{
+  std::vector<RouteChange> changes;
+  for (const auto& p : patch)
+  {
+    const auto participant = p.participant_id();
+    const auto description_ptr = mirror.get_participant(participant);
+    if (!description_ptr)
+      continue;
+
+    const auto* description = &(*description_ptr);
+
+    if (!p.delays().empty())
+    {
+      // A delay shifts every route of the participant
+      const auto itinerary = mirror.get_itinerary(participant);
+      if (!itinerary)
+        continue;
+
+      for (const auto& route : *itinerary)
+        changes.push_back({participant, description, route});
+
+      continue;
+    }
+
+    for (const auto& item : p.additions().items())
+    {
+      if (item.route)
+        changes.push_back({participant, description, item.route});
+    }
+  }
+
+  return changes;
+}
+
+//==============================================================================
+/// Narrow each changed route down to the part that has changed since it was
+/// last checked, and drop the routes that have not changed at all.
+void restrict_to_changed_parts(
+  std::vector<RouteChange>& changes,
+  const CheckedRoutes& checked_routes)
+{
+  std::vector<RouteChange> restricted;
+  restricted.reserve(changes.size());
+  for (auto& change : changes)
+  {
+    change.route = checked_routes.changed_part(change.participant, change.route);
+    if (change.route)
+      restricted.push_back(std::move(change));
+  }
+
+  changes = std::move(restricted);
+}
+
+//==============================================================================
+/// Find the request that asks for the most changes. A std::nullopt asks for a
+/// full update, which covers every other request.
+ScheduleNode::VersionOpt oldest_request(
+  const std::unordered_set<ScheduleNode::VersionOpt>& requests)
+{
+  ScheduleNode::VersionOpt oldest;
+  bool first = true;
+  for (const auto& request : requests)
+  {
+    if (!request.has_value())
+      return std::nullopt;
+
+    if (first || rmf_utils::modular(*request).less_than(*oldest))
+      oldest = request;
+
+    first = false;
+  }
+
+  return oldest;
+}
+
 //==============================================================================
 std::vector<ScheduleNode::ConflictSet> get_conflicts(
-  const rmf_traffic::schedule::Viewer::View& view_changes,
-  const rmf_traffic::schedule::ItineraryViewer& viewer)
+  const std::vector<RouteChange>& route_changes,
+  const ConflictIndex& index,
+  WorkerPool& workers,
+  std::size_t* pairs_examined = nullptr)
 {
   const auto is_unresponsive = [](
     const rmf_traffic::schedule::ParticipantDescription& desc) -> bool
@@ -52,51 +152,160 @@ std::vector<ScheduleNode::ConflictSet> get_conflicts(
         == rmf_traffic::schedule::ParticipantDescription::Rx::Unresponsive;
     };
 
-  std::vector<ScheduleNode::ConflictSet> conflicts;
-  const auto& participants = viewer.participant_ids();
-  for (const auto participant : participants)
+  struct Pair
   {
-    const auto itinerary = *viewer.get_itinerary(participant);
-    const auto description = viewer.get_participant(participant);
-    if (!description)
-      continue;
+    const RouteChange* change;
+    ConflictIndex::Candidate candidate;
+  };
 
-    for (auto vc = view_changes.begin(); vc != view_changes.end(); ++vc)
+  // Routes can only conflict with routes on the same map, and the index keeps
+  // a separate grid for each map, so the changes are split into one shard per
+  // map. Each shard only reads its own grid, which lets the broad phase of
+  // each map run on a different worker. The shards are ordered by map name so
+  // the order of the pairs does not depend on how the work was split.
+  std::map<std::string, std::vector<const RouteChange*>> changes_on_map;
+  for (const auto& change : route_changes)
+    changes_on_map[change.route->map()].push_back(&change);
+
+  std::vector<const std::vector<const RouteChange*>*> shards;
+  shards.reserve(changes_on_map.size());
+  for (const auto& shard : changes_on_map)
+    shards.push_back(&shard.second);
+
+  // Broad phase: The index will only give back routes of other participants
+  // whose bounding boxes overlap with a changed route in both space and time.
+  // If both participants self-identify as unresponsive, then there's no point
+  // raising a conflict between them, so the index does not even look at the
+  // unresponsive routes for a change from an unresponsive participant.
+  std::vector<std::vector<Pair>> shard_pairs(shards.size());
+  workers.run(
+    shards.size(), [&](const std::size_t s)
     {
-      if (vc->participant == participant)
+      auto& output = shard_pairs[s];
+      for (const auto* change : *shards[s])
       {
-        // There's no need to check a participant against itself
-        continue;
-      }
+        const auto candidates = index.candidates(
+          change->participant, *change->route, change->description->profile(),
+          !is_unresponsive(*change->description));
 
-      if (is_unresponsive(*description) && is_unresponsive(vc->description))
-      {
-        // If both participants self-identify as unresponsive, then there's no
-        // point raising a conflict between them.
-        continue;
+        for (auto& candidate : candidates)
+          output.push_back({change, std::move(candidate)});
       }
+    });
 
-      for (const auto& route : itinerary)
-      {
-        assert(route);
-        if (route->map() != vc->route.map())
-          continue;
+  std::vector<Pair> pairs;
+  for (auto& output : shard_pairs)
+    pairs.insert(pairs.end(), output.begin(), output.end());
 
-        if (rmf_traffic::DetectConflict::between(
-            vc->description.profile(),
-            vc->route.trajectory(),
-            description->profile(),
-            route->trajectory()))
-        {
-          conflicts.push_back({participant, vc->participant});
-        }
-      }
+  if (pairs_examined)
+    *pairs_examined = pairs.size();
+
+  // Most participants use circles, so the segments of each changed route are
+  // taken apart once for the batch kernel that rules out most circle pairs
+  // before the exact test.
+  std::unordered_map<const RouteChange*, std::size_t> segment_index;
+  for (const auto& pair : pairs)
+    segment_index.insert({pair.change, segment_index.size()});
+
+  std::vector<const RouteChange*> segment_changes(segment_index.size());
+  for (const auto& [change, s] : segment_index)
+    segment_changes[s] = change;
+
+  std::vector<std::optional<CircleSegments>> change_segments(
+    segment_changes.size());
+  workers.run(
+    segment_changes.size(), [&](const std::size_t s)
+    {
+      const auto* change = segment_changes[s];
+      change_segments[s] = CircleSegments::make(
+        change->description->profile(), change->route->trajectory());
+    });
+
+  // Narrow phase: The candidate pairs are independent of each other, so they
+  // can be spread across the workers. Each result is written to its own slot
+  // so the final set of conflicts does not depend on how the work was split.
+  std::vector<char> in_conflict(pairs.size(), false);
+  workers.run(
+    pairs.size(), [&](const std::size_t i)
+    {
+      const auto& pair = pairs[i];
+      const auto& segments = change_segments[segment_index.at(pair.change)];
+      in_conflict[i] = detect_conflict(
+        pair.change->description->profile(),
+        pair.change->route->trajectory(),
+        pair.candidate.description->profile(),
+        pair.candidate.route->trajectory(),
+        segments.has_value() ? &segments.value() : nullptr);
+    });
+
+  std::vector<ScheduleNode::ConflictSet> conflicts;
+  for (std::size_t i = 0; i < pairs.size(); ++i)
+  {
+    if (in_conflict[i])
+    {
+      conflicts.push_back(
+        {pairs[i].candidate.participant, pairs[i].change->participant});
     }
   }
 
   return conflicts;
 }
 
+//==============================================================================
+void update_conflict_index(
+  ConflictIndex& index,
+  const rmf_traffic::schedule::Mirror& mirror,
+  const std::vector<rmf_traffic::schedule::ParticipantId>& participants)
+{
+  for (const auto p : participants)
+  {
+    const auto description = mirror.get_participant(p);
+    const auto itinerary = mirror.get_itinerary(p);
+    if (!description || !itinerary)
+    {
+      index.erase(p);
+      continue;
+    }
+
+    index.update(p, *description, *itinerary);
+  }
+}
+
+//==============================================================================
+/// A hash of the routes in an itinerary, used to tell whether a participant is
+/// still following the itinerary that it adopted after a negotiation. Times
+/// are rounded to 0.1s and positions to 1cm so that resending the same
+/// itinerary gives the same fingerprint.
+template<typename ItineraryView>
+std::size_t itinerary_fingerprint(const ItineraryView& itinerary)
+{
+  const auto combine = [](std::size_t& seed, const std::size_t value)
+    {
+      seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+
+  // The routes are summed so that their order does not matter
+  std::size_t fingerprint = 0;
+  for (const auto& route : itinerary)
+  {
+    std::size_t seed = std::hash<std::string>{}(route->map());
+    for (const auto& wp : route->trajectory())
+    {
+      const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        wp.time().time_since_epoch()).count();
+      combine(seed, std::hash<int64_t>{}(time / 100));
+
+      const Eigen::Vector3d p = wp.position();
+      for (int i = 0; i < 3; ++i)
+        combine(seed, std::hash<int64_t>{}(std::llround(p[i] * 100.0)));
+    }
+
+    fingerprint += seed;
+  }
+
+  return fingerprint;
+}
+
 //==============================================================================
 // This constructor will _not_ automatically call the setup() method to finalise
 // construction of the ScheduleNode object. setup() must be called manually.
@@ -121,11 +330,186 @@ ScheduleNode::ScheduleNode(
   declare_parameter<std::string>(
     "log_file_location", ".rmf_schedule_node.yaml");
 
-  // TODO(MXG): Expose a parameter for the update period
-  // TODO(MXG): We can probably do something smarter to decide when to update
-  // than a simple wall timer
+  // Participant registry format. Use "yaml" for a YAML document that gets
+  // rewritten on every change, or "journal" for an append-only journal.
+  declare_parameter<std::string>("log_file_format", "yaml");
+
+  // When using the journal format, fsync the journal after this many records
+  // are written. Use 0 to leave flushing to the operating system.
+  declare_parameter<int>("log_file_fsync_interval", 1);
+
+  // Side length, in meters, of the grid cells that are used to find candidate
+  // pairs of routes for conflict detection
+  declare_parameter<double>("conflict_index_cell_size", 5.0);
+  conflict_index_cell_size =
+    get_parameter("conflict_index_cell_size").as_double();
+
+  // Queries for regions are evaluated only for the participants that a grid
+  // of routes finds inside of them. This gives the side length of its cells,
+  // in meters. Set region_query_index to false to evaluate every participant.
+  declare_parameter<bool>("region_query_index", true);
+  use_region_index = get_parameter("region_query_index").as_bool();
+  declare_parameter<double>("region_index_cell_size", 10.0);
+  region_index =
+    RegionIndex(get_parameter("region_index_cell_size").as_double());
+
+  // Number of threads that evaluate candidate pairs for conflicts. A value of
+  // 0 will use one thread per hardware core.
+  declare_parameter<int>("conflict_check_threads", 1);
+  const auto threads = get_parameter("conflict_check_threads").as_int();
+  conflict_check_threads = threads > 0 ?
+    static_cast<std::size_t>(threads) :
+    std::max(1u, std::thread::hardware_concurrency());
+
+  // When a participant sets an itinerary that starts the same way as the one
+  // that was last checked, only check the part that changed. The unchanged
+  // part keeps the result it had, unless it was in a conflict.
+  declare_parameter<bool>("conflict_check_changed_parts", true);
+  conflict_check_changed_parts =
+    get_parameter("conflict_check_changed_parts").as_bool();
+
+  // After participants resolve a negotiation, a conflict between them is not
+  // announced again for this many milliseconds as long as they are still
+  // following the itineraries that they adopted. Use 0 to disable this.
+  declare_parameter<int>("conflict_cooldown", 10000);
+  active_conflicts.cooldown = std::chrono::milliseconds(
+    std::max<int64_t>(0, get_parameter("conflict_cooldown").as_int()));
+
+  // Mirror updates are triggered by changes to the database. After a change
+  // we wait for this many milliseconds of quiet before publishing so that
+  // bursts of changes get coalesced into one update.
+  declare_parameter<int>("mirror_update_min_interval", 1);
+  mirror_update_min_interval = std::chrono::milliseconds(
+    std::max<int64_t>(1, get_parameter("mirror_update_min_interval").as_int()));
+
+  // A change will never wait longer than this many milliseconds before it gets
+  // published, even if more changes keep arriving.
+  declare_parameter<int>("mirror_update_max_latency", 10);
+  mirror_update_max_latency = std::chrono::milliseconds(
+    get_parameter("mirror_update_max_latency").as_int());
+
+  // Location of the database snapshot. The log of changes made since the last
+  // snapshot is kept next to it with a ".tail" suffix. Leave this empty to
+  // disable snapshots, in which case a restarted node begins with an empty
+  // schedule.
+  declare_parameter<std::string>("database_snapshot_location", "");
+  snapshot_file = get_parameter("database_snapshot_location").as_string();
+
+  // Period, in milliseconds, between database snapshots. Changes made between
+  // snapshots are still recovered from the tail log, so this only bounds how
+  // long that log can grow.
+  declare_parameter<int>("database_snapshot_period", 10000);
+  snapshot_period = std::chrono::milliseconds(
+    std::max<int64_t>(1, get_parameter("database_snapshot_period").as_int()));
+
+  // The namespaces of neighbouring schedule nodes in federation mode, and the
+  // maps that this node shares with them. Federation is off while either of
+  // these is empty.
+  declare_parameter<std::vector<std::string>>(
+    "federation_neighbours", std::vector<std::string>());
+  declare_parameter<std::vector<std::string>>(
+    "federation_boundary_maps", std::vector<std::string>());
+
+  // Identical inconsistency reports for a participant are published at most
+  // once per this many milliseconds. A report is always published right away
+  // when the inconsistency of the participant changes.
+  declare_parameter<int>("inconsistency_retry_interval", 1000);
+  inconsistency_retry_interval = std::chrono::milliseconds(
+    std::max<int64_t>(
+      0, get_parameter("inconsistency_retry_interval").as_int()));
+
+  // Changes to the participants are broadcast at most once per this many
+  // milliseconds. Use 0 to broadcast every change right away.
+  declare_parameter<int>("participants_broadcast_interval", 100);
+  participants_broadcast_interval = std::chrono::milliseconds(
+    std::max<int64_t>(
+      0, get_parameter("participants_broadcast_interval").as_int()));
+
+  // Period, in milliseconds, between culls of the routes that have finished.
+  // Use 0 to never cull the database.
+  declare_parameter<int>("cull_period", 60000);
+  cull_period = std::chrono::milliseconds(
+    std::max<int64_t>(0, get_parameter("cull_period").as_int()));
+
+  // Routes are culled once they have been finished for this many seconds
+  declare_parameter<int>("cull_retention", 600);
+  cull_retention = std::chrono::seconds(
+    std::max<int64_t>(0, get_parameter("cull_retention").as_int()));
+
+  // Estimated number of megabytes that the itineraries in the database may
+  // use before routes get culled sooner than cull_retention. Use 0 for no
+  // limit.
+  declare_parameter<int>("cull_memory_budget", 0);
+  cull_memory_budget = static_cast<std::size_t>(
+    std::max<int64_t>(0, get_parameter("cull_memory_budget").as_int()))
+    * 1024 * 1024;
+
+  // Period, in milliseconds, between publications of the performance
+  // counters on the diagnostics topic. Use 0 to turn the counters off.
+  declare_parameter<int>("performance_sample_period", 0);
+  const auto performance_sample_period = std::chrono::milliseconds(
+    std::max<int64_t>(0, get_parameter("performance_sample_period").as_int()));
+  performance_counters = std::make_unique<PerformanceCounters>(
+    *this, performance_sample_period);
+
+  // Mirrors that are loaded into the same process as this node, e.g. in the
+  // same component container, receive their patches directly instead of
+  // through the update topics. Each schedule node of a process provides them
+  // on the channel of its own update topics.
+  declare_parameter<bool>("local_mirror_updates", true);
+  if (get_parameter("local_mirror_updates").as_bool())
+  {
+    local_mirror_channel = LocalMirrorUpdates::channel(*this);
+    local_mirror_provider = LocalMirrorUpdates::get().provide(
+      local_mirror_channel, node_version);
+  }
+
   mirror_update_timer = create_wall_timer(
-    std::chrono::milliseconds(10), [this]() { this->update_mirrors(); });
+    mirror_update_min_interval, [this]() { this->update_mirrors(); });
+
+  // Stay idle until the database actually changes
+  mirror_update_timer->cancel();
+
+  // Send the latest database version to any query topic that has been quiet
+  // for a heartbeat period.
+  declare_parameter<bool>("mirror_version_summaries", true);
+  if (get_parameter("mirror_version_summaries").as_bool())
+  {
+    version_summary_timer = create_wall_timer(
+      heartbeat_period, [this]() { this->publish_version_summaries(); });
+  }
+
+  // Changes to the set of queries are broadcast at most once per this many
+  // milliseconds. Use 0 to broadcast every change right away.
+  declare_parameter<int>("queries_broadcast_interval", 100);
+  queries_broadcast_interval = std::chrono::milliseconds(
+    std::max<int64_t>(0, get_parameter("queries_broadcast_interval").as_int()));
+
+  queries_broadcast_timer = create_wall_timer(
+    std::max(queries_broadcast_interval, std::chrono::milliseconds(1)),
+    [this]()
+    {
+      queries_broadcast_timer->cancel();
+      broadcast_queries();
+    });
+  queries_broadcast_timer->cancel();
+
+  participants_broadcast_timer = create_wall_timer(
+    std::max(participants_broadcast_interval, std::chrono::milliseconds(1)),
+    [this]()
+    {
+      std::lock_guard<std::mutex> lock(database_mutex);
+      this->publish_participants();
+    });
+
+  // Stay idle until the participants actually change
+  participants_broadcast_timer->cancel();
+
+  query_preferences_handle = add_on_set_parameters_callback(
+    [this](const std::vector<rclcpp::Parameter>& parameters)
+    {
+      return set_query_preferences(parameters);
+    });
 }
 
 //==============================================================================
@@ -179,6 +563,11 @@ ScheduleNode::ScheduleNode(
 //==============================================================================
 ScheduleNode::~ScheduleNode()
 {
+  ingestion_quit = true;
+  ingestion_queue.stop();
+  if (ingestion_thread.joinable())
+    ingestion_thread.join();
+
   conflict_check_quit = true;
   if (conflict_check_thread.joinable())
     conflict_check_thread.join();
@@ -197,9 +586,38 @@ void ScheduleNode::setup(const QueryMap& queries)
   // Re-instantiate any query update topics based on received queries
   make_mirror_update_topics(queries);
 
+  std::string log_file_format;
+  get_parameter_or<std::string>("log_file_format", log_file_format, "yaml");
+
+  // The database needs to be restored before the participant registry replays
+  // its log, so that restored participants keep their IDs.
+  restore_snapshot();
+
   try
   {
-    auto participant_logger = std::make_unique<YamlLogger>(log_file_name);
+    std::unique_ptr<AbstractParticipantLogger> participant_logger;
+    if (log_file_format == "journal")
+    {
+      JournalLogger::Options journal_options;
+      journal_options.fsync_interval = static_cast<std::size_t>(
+        std::max<int64_t>(
+          0, get_parameter("log_file_fsync_interval").as_int()));
+
+      participant_logger =
+        std::make_unique<JournalLogger>(log_file_name, journal_options);
+    }
+    else
+    {
+      if (log_file_format != "yaml")
+      {
+        RCLCPP_WARN(
+          get_logger(),
+          "Unknown log_file_format [%s]. Falling back to [yaml].",
+          log_file_format.c_str());
+      }
+
+      participant_logger = std::make_unique<YamlLogger>(log_file_name);
+    }
 
     participant_registry =
       std::make_shared<ParticipantRegistry>(
@@ -222,9 +640,202 @@ void ScheduleNode::setup(const QueryMap& queries)
   setup_query_services();
   setup_participant_services();
   setup_changes_services();
+  start_ingestion_thread();
   setup_itinerary_topics();
   setup_incosistency_pub();
   setup_conflict_topics_and_thread();
+  setup_federation();
+
+  if (tail_log)
+  {
+    // Start the new history of the tail log from the state that this node
+    // actually began with.
+    take_snapshot();
+    snapshot_timer = create_wall_timer(
+      snapshot_period, [this]() { this->take_snapshot(); });
+  }
+
+  if (cull_period > std::chrono::milliseconds(0))
+  {
+    cull_timer = create_wall_timer(
+      cull_period, [this]() { this->cull_database(); });
+  }
+
+  // Deliver whatever was already in the database to the mirrors
+  schedule_mirror_update();
+}
+
+//==============================================================================
+void ScheduleNode::restore_snapshot()
+{
+  if (snapshot_file.empty())
+    return;
+
+  const std::string tail_file = snapshot_file + ".tail";
+
+  // A database that already has content was handed over by a monitor node
+  // during fail over, and it is more up to date than anything on disk.
+  if (database->latest_version() == 0 && database->participant_ids().empty())
+  {
+    try
+    {
+      if (auto restored = load_snapshot(snapshot_file))
+        *database = std::move(*restored);
+
+      const auto replayed = TailLog::replay(tail_file, *database);
+      if (database->latest_version() > 0)
+      {
+        RCLCPP_INFO(
+          get_logger(),
+          "Restored schedule database version [%lu] from [%s] after replaying "
+          "[%lu] changes",
+          database->latest_version(),
+          snapshot_file.c_str(),
+          replayed);
+      }
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        get_logger(),
+        "Failed to restore schedule database from [%s]. Starting with an "
+        "empty schedule instead: %s",
+        snapshot_file.c_str(),
+        e.what());
+
+      *database = rmf_traffic::schedule::Database();
+    }
+  }
+
+  tail_log = std::make_unique<TailLog>(tail_file);
+}
+
+//==============================================================================
+void ScheduleNode::take_snapshot()
+{
+  std::string snapshot;
+  {
+    std::unique_lock<std::mutex> lock(database_mutex);
+    const auto version = database->latest_version();
+    if (last_snapshot_version == version)
+      return;
+
+    snapshot = serialize_snapshot(*database);
+    tail_log->rotate();
+    last_snapshot_version = version;
+  }
+
+  try
+  {
+    save_snapshot(snapshot_file, snapshot);
+    tail_log->discard_rotated();
+  }
+  catch (const std::exception& e)
+  {
+    // The rotated changes are kept, so nothing is lost. They will be folded
+    // into the next attempt.
+    RCLCPP_ERROR(
+      get_logger(),
+      "Failed to save schedule database snapshot to [%s]: %s",
+      snapshot_file.c_str(),
+      e.what());
+    last_snapshot_version = std::nullopt;
+  }
+}
+
+//==============================================================================
+void ScheduleNode::cull_database()
+{
+  bool changed = false;
+  {
+    std::lock_guard<std::mutex> lock(database_mutex);
+    const auto now = rmf_traffic_ros2::convert(get_clock()->now());
+    const auto initial_version = database->latest_version();
+
+    const auto cull = [&](const rmf_traffic::Duration retention)
+      {
+        const auto previous_version = database->latest_version();
+        const rmf_traffic::schedule::Change::Cull change(now - retention);
+        database->cull(change.time());
+        log_change(change, previous_version);
+      };
+
+    auto retention = cull_retention;
+    cull(retention);
+    auto usage = measure_usage(*database);
+
+    // Routes that have not finished yet are never culled, so the budget might
+    // not be reachable.
+    while (0 < cull_memory_budget && cull_memory_budget < usage.total.bytes
+      && rmf_traffic::Duration(0) < retention)
+    {
+      retention = retention / 2 < 1s ? rmf_traffic::Duration(0) : retention / 2;
+      cull(retention);
+      usage = measure_usage(*database);
+    }
+
+    if (retention < cull_retention)
+    {
+      RCLCPP_WARN(
+        get_logger(),
+        "Schedule database exceeded its memory budget of %lu bytes. Culled "
+        "routes that finished more than %.1f s ago.",
+        cull_memory_budget,
+        rmf_traffic::time::to_seconds(retention));
+    }
+
+    RCLCPP_INFO(
+      get_logger(),
+      "Schedule database holds %lu routes with %lu waypoints, using about %lu "
+      "bytes",
+      usage.total.routes,
+      usage.total.waypoints,
+      usage.total.bytes);
+
+    for (const auto& [map, entry] : usage.maps)
+    {
+      RCLCPP_DEBUG(
+        get_logger(),
+        " -- Map [%s]: %lu routes, %lu waypoints, %lu bytes",
+        map.c_str(), entry.routes, entry.waypoints, entry.bytes);
+    }
+
+    for (const auto& [participant, entry] : usage.participants)
+    {
+      RCLCPP_DEBUG(
+        get_logger(),
+        " -- Participant [%s]: %lu routes, %lu waypoints, %lu bytes",
+        participant.c_str(), entry.routes, entry.waypoints, entry.bytes);
+    }
+
+    changed = database->latest_version() != initial_version;
+  }
+
+  // The cull reaches the mirrors through the next patch that they receive
+  if (changed)
+    schedule_mirror_update();
+}
+
+//==============================================================================
+template<typename Change>
+void ScheduleNode::log_change(
+  const Change& change,
+  const Version previous_version)
+{
+  if (!tail_log || database->latest_version() == previous_version)
+    return;
+
+  try
+  {
+    tail_log->record(change, database->latest_version());
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_ERROR(
+      get_logger(),
+      "Failed to record schedule change in tail log: %s",
+      e.what());
+  }
 }
 
 //==============================================================================
@@ -255,7 +866,10 @@ void ScheduleNode::setup_participant_services()
     [=](const request_id_ptr request_header,
     const RegisterParticipant::Request::SharedPtr request,
     const RegisterParticipant::Response::SharedPtr response)
-    { this->register_participant(request_header, request, response); });
+    {
+      this->register_participant(request_header, request, response);
+      this->schedule_mirror_update();
+    });
 
   unregister_participant_service =
     create_service<UnregisterParticipant>(
@@ -263,7 +877,10 @@ void ScheduleNode::setup_participant_services()
     [=](const request_id_ptr request_header,
     const UnregisterParticipant::Request::SharedPtr request,
     const UnregisterParticipant::Response::SharedPtr response)
-    { this->unregister_participant(request_header, request, response); });
+    {
+      this->unregister_participant(request_header, request, response);
+      this->schedule_mirror_update();
+    });
 }
 
 //==============================================================================
@@ -275,7 +892,10 @@ void ScheduleNode::setup_changes_services()
     [=](const request_id_ptr request_header,
     const RequestChanges::Request::SharedPtr request,
     const RequestChanges::Response::SharedPtr response)
-    { this->request_changes(request_header, request, response); });
+    {
+      this->request_changes(request_header, request, response);
+      this->schedule_mirror_update();
+    });
 }
 
 //==============================================================================
@@ -290,45 +910,60 @@ void ScheduleNode::setup_itinerary_topics()
     create_subscription<ItinerarySet>(
     rmf_traffic_ros2::ItinerarySetTopicName,
     itinerary_qos,
-    [=](const ItinerarySet::UniquePtr msg)
+    [=](ItinerarySet::UniquePtr msg)
     {
-      this->itinerary_set(*msg);
+      performance_counters->count("itinerary_set");
+      std::shared_ptr<const ItinerarySet> change = std::move(msg);
+      this->queue_itinerary_change(
+        [this, change]() { this->apply_itinerary_set(*change); });
     });
 
   itinerary_extend_sub =
     create_subscription<ItineraryExtend>(
     rmf_traffic_ros2::ItineraryExtendTopicName,
     itinerary_qos,
-    [=](const ItineraryExtend::UniquePtr msg)
+    [=](ItineraryExtend::UniquePtr msg)
     {
-      this->itinerary_extend(*msg);
+      performance_counters->count("itinerary_extend");
+      std::shared_ptr<const ItineraryExtend> change = std::move(msg);
+      this->queue_itinerary_change(
+        [this, change]() { this->apply_itinerary_extend(*change); });
     });
 
   itinerary_delay_sub =
     create_subscription<ItineraryDelay>(
     rmf_traffic_ros2::ItineraryDelayTopicName,
     itinerary_qos,
-    [=](const ItineraryDelay::UniquePtr msg)
+    [=](ItineraryDelay::UniquePtr msg)
     {
-      this->itinerary_delay(*msg);
+      performance_counters->count("itinerary_delay");
+      std::shared_ptr<const ItineraryDelay> change = std::move(msg);
+      this->queue_itinerary_change(
+        [this, change]() { this->apply_itinerary_delay(*change); });
     });
 
   itinerary_erase_sub =
     create_subscription<ItineraryErase>(
     rmf_traffic_ros2::ItineraryEraseTopicName,
     itinerary_qos,
-    [=](const ItineraryErase::UniquePtr msg)
+    [=](ItineraryErase::UniquePtr msg)
     {
-      this->itinerary_erase(*msg);
+      performance_counters->count("itinerary_erase");
+      std::shared_ptr<const ItineraryErase> change = std::move(msg);
+      this->queue_itinerary_change(
+        [this, change]() { this->apply_itinerary_erase(*change); });
     });
 
   itinerary_clear_sub =
     create_subscription<ItineraryClear>(
     rmf_traffic_ros2::ItineraryClearTopicName,
     itinerary_qos,
-    [=](const ItineraryClear::UniquePtr msg)
+    [=](ItineraryClear::UniquePtr msg)
     {
-      this->itinerary_clear(*msg);
+      performance_counters->count("itinerary_clear");
+      std::shared_ptr<const ItineraryClear> change = std::move(msg);
+      this->queue_itinerary_change(
+        [this, change]() { this->apply_itinerary_clear(*change); });
     });
 }
 
@@ -344,6 +979,8 @@ void ScheduleNode::setup_incosistency_pub()
 //==============================================================================
 void ScheduleNode::setup_conflict_topics_and_thread()
 {
+  negotiation_diagnostics = std::make_shared<NegotiationDiagnostics>(*this);
+
   const auto negotiation_qos = rclcpp::ServicesQoS().reliable();
   conflict_ack_sub = create_subscription<ConflictAck>(
     rmf_traffic_ros2::NegotiationAckTopicName, negotiation_qos,
@@ -366,7 +1003,9 @@ void ScheduleNode::setup_conflict_topics_and_thread()
     rmf_traffic_ros2::NegotiationProposalTopicName, negotiation_qos,
     [&](const ConflictProposal::UniquePtr msg)
     {
+      const auto start = std::chrono::steady_clock::now();
       this->receive_proposal(*msg);
+      negotiation_diagnostics->record_since("receive_proposal", start);
     });
 
   conflict_rejection_sub = create_subscription<ConflictRejection>(
@@ -391,15 +1030,21 @@ void ScheduleNode::setup_conflict_topics_and_thread()
     [&]()
     {
       rmf_traffic::schedule::Mirror mirror;
+      ConflictIndex index(conflict_index_cell_size);
+      WorkerPool workers(conflict_check_threads);
+      CheckedRoutes checked_routes;
       const auto query_all = rmf_traffic::schedule::query_all();
       Version last_checked_version = 0;
 
       while (rclcpp::ok(get_node_options().context()) && !conflict_check_quit)
       {
         rmf_utils::optional<rmf_traffic::schedule::Patch> next_patch;
-        rmf_traffic::schedule::Viewer::View view_changes;
+        std::optional<rmf_traffic::schedule::ParticipantDescriptionsMap>
+        participants;
 
-        // Use this scope to minimize how long we lock the database for
+        // Only hold the database lock long enough to grab the latest changes.
+        // Everything else is done on our own mirror so that itinerary updates
+        // do not have to wait for conflict analysis to finish.
         {
           std::unique_lock<std::mutex> lock(database_mutex);
           conflict_check_cv.wait_for(lock, std::chrono::milliseconds(100), [&]()
@@ -419,47 +1064,118 @@ void ScheduleNode::setup_conflict_topics_and_thread()
           if (last_known_participants_version != current_participants_version)
           {
             last_known_participants_version = current_participants_version;
-            rmf_traffic::schedule::ParticipantDescriptionsMap participants;
+            participants.emplace();
             for (const auto& id: database->participant_ids())
             {
-              participants.insert({id, *database->get_participant(id)});
-            }
-
-            try
-            {
-              mirror.update_participants_info(participants);
-            }
-            catch (const std::exception& e)
-            {
-              RCLCPP_ERROR(get_logger(), e.what());
+              participants->insert({id, *database->get_participant(id)});
             }
           }
 
           next_patch = database->changes(query_all, last_checked_version);
-          // TODO(MXG): Check whether the database really needs to remain locked
-          // during this update.
+        }
+
+        if (participants.has_value())
+        {
           try
           {
-            mirror.update(*next_patch);
-            view_changes = database->query(query_all, last_checked_version);
-            last_checked_version = next_patch->latest_version();
+            mirror.update_participants_info(*participants);
           }
           catch (const std::exception& e)
           {
             RCLCPP_ERROR(get_logger(), e.what());
-            continue;
           }
         }
 
-        const auto conflicts = get_conflicts(view_changes, mirror);
+        const auto iteration_start = performance_counters->now();
+        try
+        {
+          mirror.update(*next_patch);
+          last_checked_version = next_patch->latest_version();
+        }
+        catch (const std::exception& e)
+        {
+          RCLCPP_ERROR(get_logger(), e.what());
+          continue;
+        }
+
+        // Participant descriptions may have changed, so every participant
+        // needs to be reindexed.
+        const bool reindex_all = participants.has_value();
+
+        if (reindex_all || next_patch->cull())
+        {
+          const auto& ids = mirror.participant_ids();
+          index.retain(ids);
+          update_conflict_index(
+            index, mirror, std::vector<ParticipantId>(ids.begin(), ids.end()));
+        }
+        else
+        {
+          std::vector<ParticipantId> changed;
+          changed.reserve(next_patch->size());
+          for (const auto& p : *next_patch)
+            changed.push_back(p.participant_id());
+
+          update_conflict_index(index, mirror, changed);
+        }
+
+        if (reindex_all)
+          checked_routes.clear();
+
+        auto route_changes = get_route_changes(*next_patch, mirror);
+        if (conflict_check_changed_parts)
+        {
+          restrict_to_changed_parts(route_changes, checked_routes);
+          performance_counters->count(
+            "conflict_check.routes", route_changes.size());
+        }
+
+        std::size_t pairs_examined = 0;
+        const auto conflicts =
+          get_conflicts(route_changes, index, workers, &pairs_examined);
+        performance_counters->count("conflict_check.pairs", pairs_examined);
+
+        if (conflict_check_changed_parts)
+        {
+          std::unordered_map<ParticipantId, rmf_traffic::schedule::Itinerary>
+          checked;
+          for (const auto& p : *next_patch)
+          {
+            if (const auto itinerary = mirror.get_itinerary(p.participant_id()))
+              checked[p.participant_id()] = *itinerary;
+          }
+
+          std::unordered_set<ParticipantId> in_conflict;
+          for (const auto& conflict : conflicts)
+            in_conflict.insert(conflict.begin(), conflict.end());
+
+          checked_routes.update(checked, in_conflict);
+        }
+        const auto fingerprint_of = [&mirror](const ParticipantId p)
+          -> std::optional<std::size_t>
+          {
+            const auto itinerary = mirror.get_itinerary(p);
+            if (!itinerary)
+              return std::nullopt;
+
+            return itinerary_fingerprint(*itinerary);
+          };
+
         std::unordered_map<Version, const Negotiation*> new_negotiations;
-        for (const auto& conflict : conflicts)
         {
           std::unique_lock<std::mutex> lock(active_conflicts_mutex);
-          const auto new_negotiation = active_conflicts.insert(conflict);
+          for (const auto& conflict : conflicts)
+          {
+            if (active_conflicts.debounce(conflict, fingerprint_of))
+              continue;
 
-          if (new_negotiation)
-            new_negotiations[new_negotiation->first] = new_negotiation->second;
+            const auto new_negotiation = active_conflicts.insert(conflict);
+            if (new_negotiation)
+            {
+              new_negotiations[new_negotiation->first] =
+                new_negotiation->second;
+            }
+          }
         }
 
         for (const auto& n : new_negotiations)
@@ -473,16 +1189,136 @@ void ScheduleNode::setup_conflict_topics_and_thread()
 
           conflict_notice_pub->publish(msg);
         }
+
+        performance_counters->record_since(
+          "conflict_check.iteration", iteration_start);
       }
     });
 }
 
 //==============================================================================
-void ScheduleNode::setup_redundancy()
+void ScheduleNode::setup_federation()
 {
-  start_heartbeat();
+  const auto neighbours =
+    get_parameter("federation_neighbours").as_string_array();
+  const auto boundary_maps =
+    get_parameter("federation_boundary_maps").as_string_array();
 
-  participants_info_pub =
+  if (neighbours.empty() || boundary_maps.empty())
+    return;
+
+  for (const auto& neighbour : neighbours)
+  {
+    const std::size_t index = federation_links.size();
+    federation_links.push_back(
+      std::make_unique<FederationLink>(
+        *this, neighbour, boundary_maps,
+        [this, index](const std::vector<FederationLink::Change>& changes)
+        {
+          import_boundary(*federation_links[index], changes);
+        }));
+  }
+}
+
+//==============================================================================
+void ScheduleNode::import_boundary(
+  const FederationLink& link,
+  const std::vector<FederationLink::Change>& changes)
+{
+  for (const auto& change : changes)
+  {
+    const auto key =
+      link.neighbour() + "/" + std::to_string(change.participant);
+    auto proxy_it = federation_proxies.find(key);
+
+    if (change.description.has_value())
+    {
+      // Participants that the neighbour imported from somewhere else are left
+      // to the schedule node that they came from
+      if (FederationLink::is_proxy(*change.description))
+        continue;
+
+      if (proxy_it == federation_proxies.end())
+      {
+        if (change.routes.empty())
+          continue;
+
+        const auto& d = *change.description;
+        const rmf_traffic::schedule::ParticipantDescription description(
+          d.name(),
+          link.proxy_owner(d.owner()),
+          rmf_traffic::schedule::ParticipantDescription::Rx::Unresponsive,
+          d.profile());
+
+        std::unique_lock<std::mutex> lock(database_mutex);
+        try
+        {
+          const auto previous_version = database->latest_version();
+          const auto registration =
+            participant_registry->add_or_retrieve_participant(description);
+          log_change(description, previous_version);
+
+          proxy_it = federation_proxies.insert(
+            {
+              key,
+              FederationProxy{
+                registration.id(),
+                registration.last_itinerary_version()
+              }
+            }).first;
+
+          RCLCPP_INFO(
+            get_logger(),
+            "Imported participant [%s] of [%s] as [%ld]",
+            d.name().c_str(), link.neighbour().c_str(), registration.id());
+
+          broadcast_participants();
+        }
+        catch (const std::exception& e)
+        {
+          RCLCPP_ERROR(
+            get_logger(),
+            "Failed to import participant [%s] of [%s]: %s",
+            d.name().c_str(), link.neighbour().c_str(), e.what());
+          continue;
+        }
+      }
+    }
+    else if (proxy_it == federation_proxies.end())
+    {
+      continue;
+    }
+
+    auto& proxy = proxy_it->second;
+    const auto version = ++proxy.itinerary_version;
+    if (change.routes.empty())
+    {
+      ItineraryClear clear;
+      clear.participant = proxy.id;
+      clear.itinerary_version = version;
+      queue_itinerary_change(
+        [this, clear]() { apply_itinerary_clear(clear); });
+    }
+    else
+    {
+      ItinerarySet set;
+      set.participant = proxy.id;
+      set.itinerary = rmf_traffic_ros2::convert(change.routes);
+      set.itinerary_version = version;
+      queue_itinerary_change(
+        [this, set = std::move(set)]() { apply_itinerary_set(set); });
+    }
+
+    performance_counters->count("federation.imported_changes");
+  }
+}
+
+//==============================================================================
+void ScheduleNode::setup_redundancy()
+{
+  start_heartbeat();
+
+  participants_info_pub =
     create_publisher<ParticipantsInfo>(
     rmf_traffic_ros2::ParticipantsInfoTopicName,
     rclcpp::SystemDefaultsQoS().reliable().keep_last(1).transient_local());
@@ -521,14 +1357,54 @@ void ScheduleNode::make_mirror_update_topics(const QueryMap& queries)
 {
   // Delete any existing topics, just to be sure
   registered_queries.clear();
+  query_index.clear();
+
+  // When taking over from a failed schedule node, the database was forked from
+  // the monitor's mirror, which was being kept up to date by the same stream of
+  // patches as every other mirror. The mirrors of the inherited queries should
+  // therefore already be at this version, so we only send them incremental
+  // updates. Any mirror that fell behind will fail to apply the next patch and
+  // request a remedial update for just the changes that it missed.
+  if (!queries.empty() && database->latest_version() > 0)
+    inherited_version = database->latest_version();
 
   for (const auto& [query_id, query] : queries)
   {
-    register_query(query_id, query);
+    register_query(query_id, query, inherited_version);
     RCLCPP_INFO(get_logger(), "Registering query ID %ld", query_id);
   }
 }
 
+namespace {
+//==============================================================================
+/// Put a query message into a canonical form. Sets of IDs and maps do not have
+/// a guaranteed order when they are converted, so they get sorted.
+rmf_traffic_msgs::msg::ScheduleQuery canonical_query_msg(
+  const rmf_traffic::schedule::Query& query)
+{
+  auto msg = rmf_traffic_ros2::convert(query);
+  auto& ids = msg.participants.ids;
+  std::sort(ids.begin(), ids.end());
+  auto& maps = msg.spacetime.timespan.maps;
+  std::sort(maps.begin(), maps.end());
+  return msg;
+}
+
+//==============================================================================
+std::size_t hash_query_msg(const rmf_traffic_msgs::msg::ScheduleQuery& msg)
+{
+  static const rclcpp::Serialization<rmf_traffic_msgs::msg::ScheduleQuery>
+  serializer;
+
+  rclcpp::SerializedMessage serialized;
+  serializer.serialize_message(&msg, &serialized);
+  const auto& data = serialized.get_rcl_serialized_message();
+  return std::hash<std::string_view>()(
+    std::string_view(
+      reinterpret_cast<const char*>(data.buffer), data.buffer_length));
+}
+} // anonymous namespace
+
 //==============================================================================
 void ScheduleNode::register_query(
   const std::shared_ptr<rmw_request_id_t>& /*request_header*/,
@@ -540,9 +1416,14 @@ void ScheduleNode::register_query(
 
   response->node_version = node_version;
 
-  // Search for an existing query with the same search parameters
-  for (auto& [existing_query_id, existing_query] : registered_queries)
+  // Search for an existing query with the same search parameters. Only the
+  // queries with a matching hash need to be compared.
+  const auto hash = hash_query_msg(canonical_query_msg(new_query));
+  const auto range = query_index.equal_range(hash);
+  for (auto candidate = range.first; candidate != range.second; ++candidate)
   {
+    const auto existing_query_id = candidate->second;
+    auto& existing_query = registered_queries.at(existing_query_id);
     if (existing_query.query == new_query)
     {
       RCLCPP_INFO(
@@ -552,7 +1433,7 @@ void ScheduleNode::register_query(
 
       existing_query.last_registration_time = std::chrono::steady_clock::now();
       response->query_id = existing_query_id;
-      broadcast_queries();
+      request_queries_broadcast();
       return;
     }
   }
@@ -593,28 +1474,43 @@ void ScheduleNode::register_query(
   last_query_id = query_id;
   RCLCPP_INFO(get_logger(), "Registered new query [%ld]", query_id);
 
-  broadcast_queries();
+  request_queries_broadcast();
 }
 
 //==============================================================================
 void ScheduleNode::register_query(
   const uint64_t query_id,
-  const rmf_traffic::schedule::Query& query)
+  const rmf_traffic::schedule::Query& query,
+  const VersionOpt last_sent_version)
 {
   MirrorUpdateTopicPublisher update_publisher =
     create_publisher<MirrorUpdate>(
     rmf_traffic_ros2::QueryUpdateTopicNameBase + std::to_string(query_id),
     rclcpp::SystemDefaultsQoS());
 
-  registered_queries.emplace(
+  const auto inserted = registered_queries.emplace(
     query_id,
     QueryInfo{
       query,
       std::move(update_publisher),
-      std::nullopt,
+      last_sent_version,
       std::chrono::steady_clock::now(),
+      {},
       {}
     });
+
+  if (inserted.second)
+  {
+    auto& info = inserted.first->second;
+    info.msg = canonical_query_msg(query);
+    info.hash = hash_query_msg(info.msg);
+    query_index.insert({info.hash, query_id});
+  }
+
+  declare_query_preferences(query_id);
+
+  // Make sure the new topic gets its initial update
+  schedule_mirror_update();
 }
 
 //==============================================================================
@@ -633,6 +1529,8 @@ void ScheduleNode::cleanup_queries()
         // It's important that we use the post-increment operator here so that
         // we increment the iterator to its next value while erasing the element
         // that it used to point at.
+        erase_query_index(it);
+        undeclare_query_preferences(it->first);
         registered_queries.erase(it++);
         any_erased = true;
         continue;
@@ -643,7 +1541,205 @@ void ScheduleNode::cleanup_queries()
   }
 
   if (any_erased)
-    broadcast_queries();
+    request_queries_broadcast();
+}
+
+//==============================================================================
+void ScheduleNode::erase_query_index(const QueryInfoMap::const_iterator& it)
+{
+  const auto range = query_index.equal_range(it->second.hash);
+  for (auto entry = range.first; entry != range.second; ++entry)
+  {
+    if (entry->second == it->first)
+    {
+      query_index.erase(entry);
+      return;
+    }
+  }
+}
+
+namespace {
+//==============================================================================
+/// Split a query preferences parameter name into its query ID and field
+std::optional<std::pair<uint64_t, std::string>> parse_query_preference(
+  const std::string& name)
+{
+  const auto& prefix = rmf_traffic_ros2::QueryPreferencesParameterPrefix;
+  if (name.compare(0, prefix.size(), prefix) != 0)
+    return std::nullopt;
+
+  const auto dot = name.find('.', prefix.size());
+  if (dot == std::string::npos || dot == prefix.size())
+    return std::nullopt;
+
+  const auto id = name.substr(prefix.size(), dot - prefix.size());
+  if (id.find_first_not_of("0123456789") != std::string::npos)
+    return std::nullopt;
+
+  return std::make_pair(std::stoull(id), name.substr(dot + 1));
+}
+
+//==============================================================================
+/// Rates may be given as integers or as doubles
+double as_number(const rclcpp::Parameter& parameter)
+{
+  if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_INTEGER)
+    return static_cast<double>(parameter.as_int());
+
+  return parameter.as_double();
+}
+} // anonymous namespace
+
+//==============================================================================
+void ScheduleNode::declare_query_preferences(const uint64_t query_id)
+{
+  const auto prefix = rmf_traffic_ros2::QueryPreferencesParameterPrefix
+    + std::to_string(query_id) + ".";
+
+  // The highest rate, in Hz, at which updates for this query get published.
+  // Use 0 for no limit.
+  if (!has_parameter(prefix + "max_rate"))
+    declare_parameter<double>(prefix + "max_rate", 0.0);
+
+  // Background queries are updated after every other query
+  if (!has_parameter(prefix + "background"))
+    declare_parameter<bool>(prefix + "background", false);
+
+  // Routes that finished more than this many seconds ago are not sent to the
+  // mirrors of this query, and are evicted from them. Use a negative value to
+  // keep every route.
+  if (!has_parameter(prefix + "history"))
+    declare_parameter<double>(prefix + "history", -1.0);
+
+  // Mirrors that need to save bandwidth can ask for their updates to also be
+  // sent as a compact stream on a separate topic
+  if (!has_parameter(prefix + "compact"))
+    declare_parameter<bool>(prefix + "compact", false);
+
+  // The parameters may have been set for an earlier registration of this ID
+  set_query_preferences(
+    {
+      get_parameter(prefix + "max_rate"),
+      get_parameter(prefix + "background"),
+      get_parameter(prefix + "history"),
+      get_parameter(prefix + "compact")
+    });
+}
+
+//==============================================================================
+void ScheduleNode::undeclare_query_preferences(const uint64_t query_id)
+{
+  const auto prefix = rmf_traffic_ros2::QueryPreferencesParameterPrefix
+    + std::to_string(query_id) + ".";
+
+  for (const auto& field : {"max_rate", "background", "history", "compact"})
+  {
+    if (has_parameter(prefix + field))
+      undeclare_parameter(prefix + field);
+  }
+}
+
+//==============================================================================
+rcl_interfaces::msg::SetParametersResult ScheduleNode::set_query_preferences(
+  const std::vector<rclcpp::Parameter>& parameters)
+{
+  using ParameterType = rclcpp::ParameterType;
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+
+  // Check every parameter before applying any of them
+  for (const auto& parameter : parameters)
+  {
+    const auto preference = parse_query_preference(parameter.get_name());
+    if (!preference.has_value())
+      continue;
+
+    const auto type = parameter.get_type();
+    if (preference->second == "max_rate")
+    {
+      if (type != ParameterType::PARAMETER_DOUBLE
+        && type != ParameterType::PARAMETER_INTEGER)
+      {
+        result.successful = false;
+        result.reason = parameter.get_name() + " must be a number";
+      }
+      else if (as_number(parameter) < 0.0)
+      {
+        result.successful = false;
+        result.reason = parameter.get_name() + " must not be negative";
+      }
+    }
+    else if (preference->second == "history")
+    {
+      if (type != ParameterType::PARAMETER_DOUBLE
+        && type != ParameterType::PARAMETER_INTEGER)
+      {
+        result.successful = false;
+        result.reason = parameter.get_name() + " must be a number";
+      }
+    }
+    else if (preference->second == "background"
+      || preference->second == "compact")
+    {
+      if (type != ParameterType::PARAMETER_BOOL)
+      {
+        result.successful = false;
+        result.reason = parameter.get_name() + " must be a boolean";
+      }
+    }
+
+    if (!result.successful)
+      return result;
+  }
+
+  for (const auto& parameter : parameters)
+  {
+    const auto preference = parse_query_preference(parameter.get_name());
+    if (!preference.has_value())
+      continue;
+
+    const auto it = registered_queries.find(preference->first);
+    if (it == registered_queries.end())
+      continue;
+
+    auto& info = it->second;
+    if (preference->second == "max_rate")
+    {
+      const auto rate = as_number(parameter);
+      info.min_update_interval = rate > 0.0 ?
+        rmf_traffic::time::from_seconds(1.0 / rate) :
+        rmf_traffic::Duration(0);
+    }
+    else if (preference->second == "background")
+    {
+      info.background = parameter.as_bool();
+    }
+    else if (preference->second == "history")
+    {
+      const auto history = as_number(parameter);
+      info.history = history < 0.0 ?
+        std::nullopt :
+        std::make_optional(rmf_traffic::time::from_seconds(history));
+    }
+    else if (preference->second == "compact")
+    {
+      if (!parameter.as_bool())
+      {
+        info.compact_publisher.reset();
+        info.compact_encoder = std::nullopt;
+      }
+      else if (!info.compact_publisher)
+      {
+        info.compact_publisher = create_publisher<CompactUpdate>(
+          rmf_traffic_ros2::QueryCompactUpdateTopicNameBase
+          + std::to_string(preference->first),
+          rclcpp::SystemDefaultsQoS());
+        info.compact_encoder.emplace();
+      }
+    }
+  }
+
+  return result;
 }
 
 //==============================================================================
@@ -651,18 +1747,29 @@ void ScheduleNode::broadcast_queries()
 {
   ScheduleQueries msg;
   msg.node_version = node_version;
+  msg.ids.reserve(registered_queries.size());
+  msg.queries.reserve(registered_queries.size());
 
-  for (const auto& registered_query: registered_queries)
+  for (const auto& [query_id, info] : registered_queries)
   {
-    msg.ids.push_back(registered_query.first);
+    msg.ids.push_back(query_id);
+    msg.queries.push_back(info.msg);
+  }
 
-    const rmf_traffic::schedule::Query& original =
-      registered_queries.at(registered_query.first).query;
+  queries_info_pub->publish(msg);
+}
 
-    msg.queries.emplace_back(rmf_traffic_ros2::convert(original));
+//==============================================================================
+void ScheduleNode::request_queries_broadcast()
+{
+  if (queries_broadcast_interval.count() == 0)
+  {
+    broadcast_queries();
+    return;
   }
 
-  queries_info_pub->publish(msg);
+  if (queries_broadcast_timer->is_canceled())
+    queries_broadcast_timer->reset();
 }
 
 //==============================================================================
@@ -676,9 +1783,11 @@ void ScheduleNode::register_participant(
   // TODO(MXG): Use try on every database operation
   try
   {
+    const auto previous_version = database->latest_version();
+    const auto description = rmf_traffic_ros2::convert(request->description);
     const auto registration = participant_registry
-      ->add_or_retrieve_participant(
-      rmf_traffic_ros2::convert(request->description));
+      ->add_or_retrieve_participant(description);
+    log_change(description, previous_version);
 
     using Response = rmf_traffic_msgs::srv::RegisterParticipant::Response;
 
@@ -738,8 +1847,14 @@ void ScheduleNode::unregister_participant(
     const std::string name = p->name();
     const std::string owner = p->owner();
 
+    const auto previous_version = database->latest_version();
     auto version = database->itinerary_version(request->participant_id);
     database->erase(request->participant_id, version);
+
+    ItineraryClear clear;
+    clear.participant = request->participant_id;
+    clear.itinerary_version = version;
+    log_change(clear, previous_version);
     response->confirmation = true;
 
     RCLCPP_INFO(
@@ -767,16 +1882,52 @@ void ScheduleNode::unregister_participant(
 void ScheduleNode::broadcast_participants()
 {
   ++current_participants_version;
-  ParticipantsInfo msg;
+  if (participants_broadcast_interval.count() == 0)
+  {
+    participants_broadcast_pending = true;
+    publish_participants();
+    return;
+  }
 
+  if (participants_broadcast_pending)
+    return;
+
+  participants_broadcast_pending = true;
+  participants_broadcast_timer->reset();
+}
+
+//==============================================================================
+void ScheduleNode::publish_participants()
+{
+  participants_broadcast_timer->cancel();
+  if (!participants_broadcast_pending)
+    return;
+
+  participants_broadcast_pending = false;
+
+  ParticipantsInfo msg;
+  decltype(participant_info_cache) next_cache;
   for (const auto& id: database->participant_ids())
   {
+    const auto& description = *database->get_participant(id);
+    const auto it = participant_info_cache.find(id);
+    if (it != participant_info_cache.end()
+      && it->second.description == description)
+    {
+      msg.participants.push_back(it->second.msg);
+      next_cache.insert(*it);
+      continue;
+    }
+
     SingleParticipantInfo participant;
     participant.id = id;
-    participant.description = rmf_traffic_ros2::convert(
-      *database->get_participant(id));
+    participant.description = rmf_traffic_ros2::convert(description);
     msg.participants.push_back(participant);
+    next_cache.insert(
+      {id, ParticipantInfoCacheEntry{description, participant}});
   }
+
+  participant_info_cache = std::move(next_cache);
   participants_info_pub->publish(msg);
 }
 
@@ -807,6 +1958,17 @@ void ScheduleNode::request_changes(
     {
       mirror_update_topic_info.remediation_requests.insert(std::nullopt);
     }
+    else if (rmf_utils::modular(database->latest_version()).less_than(
+        request->version)
+      || (inherited_version.has_value()
+      && rmf_utils::modular(request->version).less_than(*inherited_version)))
+    {
+      // After taking over from a failed schedule node, a mirror might have
+      // received changes that never reached the monitor, or it might be
+      // missing changes from before this database was forked. Either way its
+      // history differs from ours, so only a full update can fix it.
+      mirror_update_topic_info.remediation_requests.insert(std::nullopt);
+    }
     else
     {
       if (mirror_update_topic_info.last_sent_version.has_value() &&
@@ -817,26 +1979,141 @@ void ScheduleNode::request_changes(
       }
     }
 
+    performance_counters->count("remediation.requests");
     response->result = RequestChanges::Response::REQUEST_ACCEPTED;
   }
 }
 
+//==============================================================================
+void ScheduleNode::queue_itinerary_change(std::function<void()> change)
+{
+  ingestion_queue.push(std::move(change));
+
+  // The mirror update will flush the ingestion queue before it looks at the
+  // database, so it is okay to schedule it before the change is applied.
+  schedule_mirror_update();
+}
+
+//==============================================================================
+void ScheduleNode::start_ingestion_thread()
+{
+  ingestion_quit = false;
+  ingestion_thread = std::thread(
+    [this]()
+    {
+      while (!ingestion_quit)
+      {
+        const auto batch = ingestion_queue.take(std::chrono::milliseconds(100));
+
+        // An empty batch is a casual wakeup to check if we're supposed to quit
+        if (!batch.empty())
+          apply_itinerary_batch(batch);
+      }
+    });
+}
+
+//==============================================================================
+void ScheduleNode::apply_itinerary_batch(
+  const std::vector<IngestionQueue::Change>& batch)
+{
+  // Everything that has arrived since the last batch is applied under a single
+  // acquisition of the locks, so a fleet that updates many participants at
+  // once only causes one lock cycle and one conflict check wakeup.
+  const auto start = performance_counters->now();
+  {
+    PerformanceCounters::Lock lock(
+      database_mutex, *performance_counters, "database_mutex");
+    std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
+    defer_inconsistencies = true;
+    for (const auto& change : batch)
+    {
+      try
+      {
+        change();
+      }
+      catch (const std::exception& e)
+      {
+        RCLCPP_ERROR(
+          get_logger(),
+          "[ScheduleNode::apply_itinerary_batch] Failed to apply an itinerary "
+          "change: %s", e.what());
+      }
+    }
+
+    defer_inconsistencies = false;
+    flush_inconsistencies();
+  }
+
+  ingestion_queue.finish(batch.size());
+  conflict_check_cv.notify_all();
+
+  performance_counters->count("ingestion.batches");
+  performance_counters->count("ingestion.changes", batch.size());
+  performance_counters->record_since("ingestion.apply", start);
+}
+
 //==============================================================================
 void ScheduleNode::itinerary_set(const ItinerarySet& set)
 {
-  std::unique_lock<std::mutex> lock(database_mutex);
+  PerformanceCounters::Lock lock(
+    database_mutex, *performance_counters, "database_mutex");
+  std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
+  apply_itinerary_set(set);
+}
+
+//==============================================================================
+void ScheduleNode::itinerary_extend(const ItineraryExtend& extend)
+{
+  PerformanceCounters::Lock lock(
+    database_mutex, *performance_counters, "database_mutex");
+  std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
+  apply_itinerary_extend(extend);
+}
+
+//==============================================================================
+void ScheduleNode::itinerary_delay(const ItineraryDelay& delay)
+{
+  PerformanceCounters::Lock lock(
+    database_mutex, *performance_counters, "database_mutex");
+  std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
+  apply_itinerary_delay(delay);
+}
+
+//==============================================================================
+void ScheduleNode::itinerary_erase(const ItineraryErase& erase)
+{
+  PerformanceCounters::Lock lock(
+    database_mutex, *performance_counters, "database_mutex");
+  std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
+  apply_itinerary_erase(erase);
+}
+
+//==============================================================================
+void ScheduleNode::itinerary_clear(const ItineraryClear& clear)
+{
+  PerformanceCounters::Lock lock(
+    database_mutex, *performance_counters, "database_mutex");
+  std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
+  apply_itinerary_clear(clear);
+}
+
+//==============================================================================
+void ScheduleNode::apply_itinerary_set(const ItinerarySet& set)
+{
   assert(!set.itinerary.empty());
   try
   {
+    const auto previous_version = database->latest_version();
     database->set(
       set.participant,
       rmf_traffic_ros2::convert(set.itinerary),
       set.itinerary_version);
 
+    log_change(set, previous_version);
+
     publish_inconsistencies(set.participant);
 
-    std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
-    active_conflicts.check(set.participant, set.itinerary_version);
+    check_conflict_wait(set.participant, set.itinerary_version);
   }
   catch (std::runtime_error& e)
   {
@@ -845,20 +2122,21 @@ void ScheduleNode::itinerary_set(const ItinerarySet& set)
 }
 
 //==============================================================================
-void ScheduleNode::itinerary_extend(const ItineraryExtend& extend)
+void ScheduleNode::apply_itinerary_extend(const ItineraryExtend& extend)
 {
-  std::unique_lock<std::mutex> lock(database_mutex);
   try
   {
+    const auto previous_version = database->latest_version();
     database->extend(
       extend.participant,
       rmf_traffic_ros2::convert(extend.routes),
       extend.itinerary_version);
 
+    log_change(extend, previous_version);
+
     publish_inconsistencies(extend.participant);
 
-    std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
-    active_conflicts.check(
+    check_conflict_wait(
       extend.participant, database->itinerary_version(extend.participant));
   }
   catch (std::runtime_error& e)
@@ -868,20 +2146,21 @@ void ScheduleNode::itinerary_extend(const ItineraryExtend& extend)
 }
 
 //==============================================================================
-void ScheduleNode::itinerary_delay(const ItineraryDelay& delay)
+void ScheduleNode::apply_itinerary_delay(const ItineraryDelay& delay)
 {
-  std::unique_lock<std::mutex> lock(database_mutex);
   try
   {
+    const auto previous_version = database->latest_version();
     database->delay(
       delay.participant,
       rmf_traffic::Duration(delay.delay),
       delay.itinerary_version);
 
+    log_change(delay, previous_version);
+
     publish_inconsistencies(delay.participant);
 
-    std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
-    active_conflicts.check(
+    check_conflict_wait(
       delay.participant, database->itinerary_version(delay.participant));
   }
   catch (std::runtime_error& e)
@@ -891,21 +2170,22 @@ void ScheduleNode::itinerary_delay(const ItineraryDelay& delay)
 }
 
 //==============================================================================
-void ScheduleNode::itinerary_erase(const ItineraryErase& erase)
+void ScheduleNode::apply_itinerary_erase(const ItineraryErase& erase)
 {
-  std::unique_lock<std::mutex> lock(database_mutex);
   try
   {
+    const auto previous_version = database->latest_version();
     database->erase(
       erase.participant,
       std::vector<rmf_traffic::RouteId>(
         erase.routes.begin(), erase.routes.end()),
       erase.itinerary_version);
 
+    log_change(erase, previous_version);
+
     publish_inconsistencies(erase.participant);
 
-    std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
-    active_conflicts.check(
+    check_conflict_wait(
       erase.participant, database->itinerary_version(erase.participant));
   }
   catch (std::runtime_error& e)
@@ -915,17 +2195,18 @@ void ScheduleNode::itinerary_erase(const ItineraryErase& erase)
 }
 
 //==============================================================================
-void ScheduleNode::itinerary_clear(const ItineraryClear& clear)
+void ScheduleNode::apply_itinerary_clear(const ItineraryClear& clear)
 {
-  std::unique_lock<std::mutex> lock(database_mutex);
   try
   {
+    const auto previous_version = database->latest_version();
     database->erase(clear.participant, clear.itinerary_version);
 
+    log_change(clear, previous_version);
+
     publish_inconsistencies(clear.participant);
 
-    std::lock_guard<std::mutex> lock2(active_conflicts_mutex);
-    active_conflicts.check(
+    check_conflict_wait(
       clear.participant, database->itinerary_version(clear.participant));
   }
   catch (std::runtime_error& e)
@@ -938,73 +2219,549 @@ void ScheduleNode::itinerary_clear(const ItineraryClear& clear)
 void ScheduleNode::publish_inconsistencies(
   rmf_traffic::schedule::ParticipantId id)
 {
-  // TODO(MXG): This approach is likely to send out a lot of redundant
-  // inconsistency reports. We should try to be smarter about how
-  // inconsistencies get reported.
-  const auto it = database->inconsistencies().find(id);
-  assert(it != database->inconsistencies().end());
-  if (it->ranges.size() == 0)
+  pending_inconsistencies.insert(id);
+  if (!defer_inconsistencies)
+    flush_inconsistencies();
+}
+
+//==============================================================================
+void ScheduleNode::flush_inconsistencies()
+{
+  const auto now = std::chrono::steady_clock::now();
+  for (const auto id : pending_inconsistencies)
+  {
+    const auto it = database->inconsistencies().find(id);
+    if (it == database->inconsistencies().end() || it->ranges.size() == 0)
+    {
+      reported_inconsistencies.erase(id);
+      continue;
+    }
+
+    auto msg = rmf_traffic_ros2::convert(*it);
+    const auto r_it = reported_inconsistencies.find(id);
+    if (r_it != reported_inconsistencies.end()
+      && r_it->second.msg == msg
+      && now - r_it->second.time < inconsistency_retry_interval)
+    {
+      performance_counters->count("inconsistency.suppressed");
+      continue;
+    }
+
+    inconsistency_pub->publish(msg);
+    performance_counters->count("inconsistency.published");
+    reported_inconsistencies[id] = ReportedInconsistency{std::move(msg), now};
+  }
+
+  pending_inconsistencies.clear();
+}
+
+//==============================================================================
+void ScheduleNode::schedule_mirror_update()
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (!first_pending_change.has_value())
+  {
+    first_pending_change = now;
+    mirror_update_timer->reset();
+    return;
+  }
+
+  if (mirror_update_max_latency <= now - *first_pending_change)
+  {
+    // Changes have been arriving in a steady stream, so publish right away
+    // instead of letting the mirrors fall further behind.
+    update_mirrors();
     return;
+  }
 
-  inconsistency_pub->publish(rmf_traffic_ros2::convert(*it));
+  // Restart the countdown so this change gets coalesced with any others that
+  // are about to arrive.
+  mirror_update_timer->reset();
 }
 
 //==============================================================================
 void ScheduleNode::update_mirrors()
 {
+  mirror_update_timer->cancel();
+  ingestion_queue.flush();
+  const auto update_start = performance_counters->now();
 
-  for (auto& [query_id, query_info] : registered_queries)
+  const auto now = std::chrono::steady_clock::now();
+  const auto pending_since = first_pending_change.value_or(now);
+  first_pending_change = std::nullopt;
+
+  // Routes are timed by the ROS clock
+  const auto schedule_now = rmf_traffic_ros2::convert(get_clock()->now());
+
+  // Many mirrors track identical queries, so each distinct patch only gets
+  // computed and converted once per update.
+  PatchCache patch_cache;
+
+  // Background queries are only updated once every other query has been
+  // taken care of
+  std::vector<QueryInfoMap::value_type*> ordered_queries;
+  ordered_queries.reserve(registered_queries.size());
+  for (auto& entry : registered_queries)
+    ordered_queries.push_back(&entry);
+
+  std::stable_partition(
+    ordered_queries.begin(), ordered_queries.end(),
+    [](const QueryInfoMap::value_type* entry)
+    {
+      return !entry->second.background;
+    });
+
+  for (auto* const query_entry : ordered_queries)
   {
-    for (const auto request : query_info.remediation_requests)
+    const auto query_id = query_entry->first;
+    auto& query_info = query_entry->second;
+    const auto query_start = performance_counters->now();
+    bool published = false;
+    auto published_since = pending_since;
+
+    std::optional<rmf_traffic::Time> cutoff;
+    if (query_info.history.has_value())
+      cutoff = schedule_now - *query_info.history;
+
+    if (!query_info.remediation_requests.empty())
     {
-      update_query(
+      // Several mirrors of this query may have asked for changes at once, so
+      // send them all one patch that is old enough to cover every request.
+      const auto* entry = update_query(
+        query_id,
         query_info.publisher,
         query_info.query,
-        request,
-        true);
+        query_info.hash,
+        oldest_request(query_info.remediation_requests),
+        true,
+        patch_cache,
+        cutoff);
+
+      published |= entry != nullptr;
+      query_info.remediation_requests.clear();
+      performance_counters->count("remediation.updates");
     }
-    query_info.remediation_requests.clear();
 
-    if (query_info.last_sent_version == database->latest_version())
+    const auto due = query_info.last_update_time.has_value() ?
+      *query_info.last_update_time + query_info.min_update_interval : now;
+
+    const bool has_changes =
+      query_info.last_sent_version != database->latest_version();
+
+    if (has_changes && now < due)
+    {
+      // This query has a limited update rate, so its changes are held back
+      // and sent as one patch once it is due.
+      if (!query_info.held_since.has_value())
+        query_info.held_since = pending_since;
+
+      schedule_throttled_update(due);
+    }
+    else if (has_changes)
+    {
+      const auto* patch_entry = update_query(
+        query_id,
+        query_info.publisher,
+        query_info.query,
+        query_info.hash,
+        query_info.last_sent_version,
+        false,
+        patch_cache,
+        cutoff);
+
+      published |= patch_entry != nullptr;
+
+      // Update the latest version sent to this topic
+      query_info.last_sent_version = database->latest_version();
+
+      if (patch_entry)
+        query_info.last_update_time = now;
+
+      published_since = query_info.held_since.value_or(pending_since);
+      query_info.held_since = std::nullopt;
+    }
+
+    if (!published)
       continue;
 
-    update_query(
-      query_info.publisher,
-      query_info.query,
-      query_info.last_sent_version,
-      false);
+    query_info.last_publish_time = now;
 
-    // Update the latest version sent to this topic
-    query_info.last_sent_version = database->latest_version();
+    if (performance_counters->enabled())
+    {
+      performance_counters->record_since(
+        "update_mirrors.query_" + std::to_string(query_id), query_start);
+    }
+
+    const auto latency = std::chrono::steady_clock::now() - published_since;
+    query_info.publish_latency.record(latency);
 
     RCLCPP_DEBUG(
       get_logger(),
-      "[ScheduleNode::update_mirrors] Updated query [%ld]",
-      query_id);
+      "[ScheduleNode::update_mirrors] Updated query [%ld] after %.3f ms "
+      "(max %.3f ms over %ld updates)",
+      query_id,
+      rmf_traffic::time::to_seconds(latency) * 1e3,
+      rmf_traffic::time::to_seconds(query_info.publish_latency.max) * 1e3,
+      query_info.publish_latency.count);
   }
 
+  performance_counters->record_since("update_mirrors", update_start);
   conflict_check_cv.notify_all();
 }
 
 //==============================================================================
-void ScheduleNode::update_query(
+void ScheduleNode::publish_version_summaries()
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto latest_version = database->latest_version();
+
+  for (auto& [query_id, query_info] : registered_queries)
+  {
+    // Topics with changes on the way will have their version summarized by
+    // those changes. Topics that have never been sent anything are brought up
+    // to date by the remedial update that their mirrors ask for.
+    if (!query_info.last_sent_version.has_value()
+      || *query_info.last_sent_version != latest_version
+      || query_info.held_since.has_value())
+      continue;
+
+    if (query_info.last_publish_time.has_value()
+      && now - *query_info.last_publish_time < heartbeat_period)
+      continue;
+
+    // The patch is empty, but its base version lets a mirror that missed the
+    // last patch see that it is behind and ask for a remedial update.
+    auto patch = std::make_shared<const rmf_traffic::schedule::Patch>(
+      database->changes(query_info.query, query_info.last_sent_version));
+
+    if (local_mirror_provider)
+    {
+      LocalMirrorUpdates::get().deliver(
+        local_mirror_channel,
+        query_id,
+        LocalMirrorUpdates::Update{node_version, latest_version, patch, false});
+    }
+
+    if (query_info.publisher->get_subscription_count() > 0)
+    {
+      MirrorUpdate msg;
+      msg.node_version = node_version;
+      msg.database_version = latest_version;
+      msg.patch = rmf_traffic_ros2::convert(*patch);
+      msg.is_remedial_update = false;
+      query_info.publisher->publish(msg);
+    }
+
+    publish_compact_patch(query_info, *patch, false);
+
+    query_info.last_publish_time = now;
+    performance_counters->count("version_summary.count");
+
+    RCLCPP_DEBUG(
+      get_logger(),
+      "[ScheduleNode::publish_version_summaries] Sent version [%lu] to "
+      "query [%ld]",
+      latest_version,
+      query_id);
+  }
+}
+
+//==============================================================================
+void ScheduleNode::schedule_throttled_update(
+  const std::chrono::steady_clock::time_point due)
+{
+  if (throttled_update_due.has_value() && *throttled_update_due <= due)
+    return;
+
+  throttled_update_due = due;
+  const auto delay = std::max(
+    std::chrono::steady_clock::duration(0),
+    due - std::chrono::steady_clock::now());
+
+  throttled_update_timer = create_wall_timer(
+    delay,
+    [this]()
+    {
+      throttled_update_timer->cancel();
+      throttled_update_due = std::nullopt;
+      update_mirrors();
+    });
+}
+
+namespace {
+//==============================================================================
+/// Leave out the routes of a patch that finish before the cutoff, and tell the
+/// mirrors to cull any that they already have.
+rmf_traffic::schedule::Patch drop_finished_routes(
+  const rmf_traffic::schedule::Patch& patch,
+  const rmf_traffic::Time cutoff)
+{
+  using rmf_traffic::schedule::Change;
+  using rmf_traffic::schedule::Patch;
+
+  std::vector<Patch::Participant> participants;
+  participants.reserve(patch.size());
+  for (const auto& participant : patch)
+  {
+    std::vector<Change::Add::Item> additions;
+    additions.reserve(participant.additions().items().size());
+    for (const auto& item : participant.additions().items())
+    {
+      const auto* finish = item.route->trajectory().finish_time();
+      if (finish && *finish < cutoff)
+        continue;
+
+      additions.push_back(item);
+    }
+
+    participants.emplace_back(
+      participant.participant_id(),
+      participant.itinerary_version(),
+      participant.erasures(),
+      participant.delays(),
+      Change::Add(std::move(additions)));
+  }
+
+  Change::Cull cull(cutoff);
+  if (patch.cull() && cutoff < patch.cull()->time())
+    cull = *patch.cull();
+
+  return Patch(
+    std::move(participants),
+    std::move(cull),
+    patch.base_version(),
+    patch.latest_version());
+}
+
+//==============================================================================
+std::size_t hash_patch_key(
+  const std::size_t query_hash,
+  const ScheduleNode::VersionOpt& from,
+  const bool is_remedial,
+  const std::optional<rmf_traffic::Time>& cutoff)
+{
+  const auto combine = [](std::size_t& seed, const std::size_t value)
+    {
+      seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+
+  std::size_t seed = query_hash;
+  combine(seed, std::hash<ScheduleNode::VersionOpt>{}(from));
+  combine(seed, std::hash<bool>{}(is_remedial));
+  if (cutoff.has_value())
+  {
+    combine(
+      seed, std::hash<rmf_traffic::Duration::rep>{}(
+        cutoff->time_since_epoch().count()));
+  }
+
+  return seed;
+}
+} // anonymous namespace
+
+//==============================================================================
+bool ScheduleNode::update_query(
+  const uint64_t query_id,
   const MirrorUpdateTopicPublisher& publisher,
   const rmf_traffic::schedule::Query& query,
   VersionOpt last_sent_version,
   bool is_remedial)
 {
+  // Nothing else gets looked up in this cache, so the hash of the query does
+  // not matter.
+  PatchCache cache;
+  return update_query(
+    query_id, publisher, query, 0, last_sent_version, is_remedial, cache)
+    != nullptr;
+}
 
-  const auto patch = database->changes(query, last_sent_version);
+//==============================================================================
+auto ScheduleNode::update_query(
+  const uint64_t query_id,
+  const MirrorUpdateTopicPublisher& publisher,
+  const rmf_traffic::schedule::Query& query,
+  const std::size_t query_hash,
+  VersionOpt last_sent_version,
+  bool is_remedial,
+  PatchCache& cache,
+  const std::optional<rmf_traffic::Time> cutoff) -> const PatchCacheEntry*
+{
+  const auto key =
+    hash_patch_key(query_hash, last_sent_version, is_remedial, cutoff);
+  const auto range = cache.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    auto& cached = it->second;
+    if (cached.from != last_sent_version
+      || cached.is_remedial != is_remedial
+      || cached.cutoff != cutoff
+      || !(*cached.query == query))
+    {
+      continue;
+    }
+
+    if (!cached.patch)
+      return nullptr;
+
+    publish_patch(query_id, publisher, cached);
+    return &cached;
+  }
+
+  auto& entry = cache.emplace(
+    key,
+    PatchCacheEntry{
+      &query, last_sent_version, is_remedial, cutoff,
+      std::nullopt, nullptr})->second;
+
+  const auto narrowed = narrow_region_query(query);
+  auto patch = database->changes(
+    narrowed.has_value() ? *narrowed : query, last_sent_version);
 
   if (!is_remedial && patch.size() == 0 && !patch.cull())
+    return nullptr;
+
+  if (narrowed.has_value())
+  {
+    for (const auto& p : patch)
+      region_participants.insert(p.participant_id());
+  }
+
+  if (cutoff.has_value())
+    patch = drop_finished_routes(patch, *cutoff);
+
+  performance_counters->count("patch.count");
+  entry.patch =
+    std::make_shared<const rmf_traffic::schedule::Patch>(std::move(patch));
+  publish_patch(query_id, publisher, entry);
+  return &entry;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::schedule::Query> ScheduleNode::narrow_region_query(
+  const rmf_traffic::schedule::Query& query)
+{
+  using Spacetime = rmf_traffic::schedule::Query::Spacetime;
+  using Participants = rmf_traffic::schedule::Query::Participants;
+
+  if (!use_region_index)
+    return std::nullopt;
+
+  const auto& spacetime = query.spacetime();
+  if (spacetime.get_mode() != Spacetime::Mode::Regions
+    || query.participants().get_mode() != Participants::Mode::All)
+    return std::nullopt;
+
+  region_index.refresh(*database);
+  auto candidates = region_index.participants_in(*spacetime.regions());
+
+  // Forget the participants that have left the schedule
+  if (region_participants.size() > region_index.size())
+  {
+    const auto ids = database->participant_ids();
+    for (auto it = region_participants.begin();
+      it != region_participants.end(); )
+    {
+      if (ids.count(*it) == 0)
+        it = region_participants.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  candidates.insert(region_participants.begin(), region_participants.end());
+  performance_counters->count("region_index.queries");
+  performance_counters->count("region_index.candidates", candidates.size());
+
+  auto narrowed = query;
+  narrowed.participants() = Participants::make_only(
+    std::vector<rmf_traffic::schedule::ParticipantId>(
+      candidates.begin(), candidates.end()));
+  return narrowed;
+}
+
+//==============================================================================
+void ScheduleNode::publish_patch(
+  const uint64_t query_id,
+  const MirrorUpdateTopicPublisher& publisher,
+  PatchCacheEntry& entry)
+{
+  std::size_t local = 0;
+  if (local_mirror_provider)
+  {
+    local = LocalMirrorUpdates::get().deliver(
+      local_mirror_channel,
+      query_id,
+      LocalMirrorUpdates::Update{
+        node_version,
+        database->latest_version(),
+        entry.patch,
+        entry.is_remedial
+      });
+  }
+
+  if (local > 0)
+    performance_counters->count("patch.local", local);
+
+  const auto query_it = registered_queries.find(query_id);
+  const bool compact = query_it != registered_queries.end()
+    && publish_compact_patch(query_it->second, *entry.patch, entry.is_remedial);
+
+  // Mirrors in this process do not subscribe to the topic, so there is no
+  // need to convert the patch when nobody else is listening. When the patch
+  // was only sent compactly, the message is still made while the counters are
+  // on, so the savings of the compact stream can be measured.
+  const bool full = publisher->get_subscription_count() > 0;
+  if (!full && !(compact && performance_counters->enabled()))
     return;
 
-  rmf_traffic_msgs::msg::MirrorUpdate msg;
-  msg.node_version = node_version;
-  msg.database_version = database->latest_version();
-  msg.patch = rmf_traffic_ros2::convert(patch);
-  msg.is_remedial_update = is_remedial;
-  publisher->publish(msg);
+  if (!entry.msg.has_value())
+  {
+    auto& msg = mirror_update_msg;
+    msg.node_version = node_version;
+    msg.database_version = database->latest_version();
+    rmf_traffic_ros2::convert(*entry.patch, msg.patch);
+    msg.is_remedial_update = entry.is_remedial;
+
+    // Serialize the message once so that every topic which needs this patch
+    // can publish the same buffer without converting or encoding it again.
+    static const rclcpp::Serialization<MirrorUpdate> serializer;
+    entry.msg = rclcpp::SerializedMessage();
+    serializer.serialize_message(&msg, &(*entry.msg));
+    performance_counters->count("patch.bytes", entry.msg->size());
+  }
+
+  if (compact)
+    performance_counters->count("patch.compact.full_bytes", entry.msg->size());
+
+  if (full)
+    publisher->publish(*entry.msg);
+}
+
+//==============================================================================
+bool ScheduleNode::publish_compact_patch(
+  QueryInfo& query_info,
+  const rmf_traffic::schedule::Patch& patch,
+  const bool is_remedial)
+{
+  if (!query_info.compact_publisher || !query_info.compact_encoder.has_value()
+    || query_info.compact_publisher->get_subscription_count() == 0)
+    return false;
+
+  // Mirrors ask for a remedial update when they cannot follow the compact
+  // stream, so the stream starts over with it.
+  auto& encoder = *query_info.compact_encoder;
+  if (is_remedial)
+    encoder.reset();
+
+  CompactUpdate msg;
+  msg.data = make_compact_update(
+    CompactUpdateHeader{node_version, database->latest_version(), is_remedial},
+    encoder.encode(patch));
+
+  performance_counters->count("patch.compact.count");
+  performance_counters->count("patch.compact.bytes", msg.data.size());
+  query_info.compact_publisher->publish(msg);
+  return true;
 }
 
 //==============================================================================
@@ -1047,10 +2804,31 @@ void print_conclusion(
   std::cout << "\n" << std::endl;
 }
 
+//==============================================================================
+void ScheduleNode::check_conflict_wait(
+  const ParticipantId participant,
+  const ItineraryVersion version)
+{
+  if (active_conflicts.check(participant, version))
+    record_adopted_itinerary(participant);
+}
+
+//==============================================================================
+void ScheduleNode::record_adopted_itinerary(const ParticipantId p)
+{
+  const auto itinerary = database->get_itinerary(p);
+  if (itinerary)
+    active_conflicts.adopt(p, itinerary_fingerprint(*itinerary));
+}
+
 //==============================================================================
 void ScheduleNode::receive_conclusion_ack(const ConflictAck& msg)
 {
-  std::unique_lock<std::mutex> lock(active_conflicts_mutex);
+  // The database is needed to look up the itinerary of a participant that
+  // keeps its current itinerary
+  PerformanceCounters::Lock lock(
+    database_mutex, *performance_counters, "database_mutex");
+  std::unique_lock<std::mutex> lock2(active_conflicts_mutex);
 
   for (const auto ack : msg.acknowledgments)
   {
@@ -1061,8 +2839,11 @@ void ScheduleNode::receive_conclusion_ack(const ConflictAck& msg)
     }
     else
     {
-      active_conflicts.acknowledge(
+      const bool done = active_conflicts.acknowledge(
         msg.conflict_version, ack.participant, rmf_utils::nullopt);
+
+      if (done)
+        record_adopted_itinerary(ack.participant);
     }
   }
 
@@ -1083,6 +2864,8 @@ void ScheduleNode::receive_refusal(const ConflictRefusal& msg)
     + std::to_string(msg.conflict_version) + "]";
   RCLCPP_INFO(get_logger(), output.c_str());
 
+  negotiation_diagnostics->record_since(
+    "negotiation_refused", negotiation_room->opened);
   active_conflicts.refuse(msg.conflict_version);
 
   ConflictConclusion conclusion;
@@ -1121,7 +2904,7 @@ void ScheduleNode::receive_proposal(const ConflictProposal& msg)
     error += "]";
 
     RCLCPP_WARN(get_logger(), error.c_str());
-    negotiation_room->cached_proposals.push_back(msg);
+    negotiation_room->cache(msg);
     return;
   }
 
@@ -1140,6 +2923,9 @@ void ScheduleNode::receive_proposal(const ConflictProposal& msg)
       negotiation.evaluate(rmf_traffic::schedule::QuickestFinishEvaluator());
     assert(choose);
 
+    negotiation_diagnostics->record_since(
+      "negotiation_resolved", negotiation_room->opened);
+    active_conflicts.agree(msg.conflict_version);
     active_conflicts.conclude(msg.conflict_version);
 
     ConflictConclusion conclusion;
@@ -1164,6 +2950,8 @@ void ScheduleNode::receive_proposal(const ConflictProposal& msg)
       + std::to_string(msg.conflict_version) + "]";
     RCLCPP_INFO(get_logger(), output.c_str());
 
+    negotiation_diagnostics->record_since(
+      "negotiation_failed", negotiation_room->opened);
     active_conflicts.conclude(msg.conflict_version);
 
     // This implies a complete failure
@@ -1202,7 +2990,7 @@ void ScheduleNode::receive_rejection(const ConflictRejection& msg)
     error += "]";
 
     RCLCPP_WARN(get_logger(), error.c_str());
-    negotiation_room->cached_rejections.push_back(msg);
+    negotiation_room->cache(msg);
     return;
   }
 
@@ -1245,7 +3033,7 @@ void ScheduleNode::receive_forfeit(const ConflictForfeit& msg)
     error += "]";
 
     RCLCPP_WARN(get_logger(), error.c_str());
-    negotiation_room->cached_forfeits.push_back(msg);
+    negotiation_room->cache(msg);
     return;
   }
 
@@ -1262,6 +3050,8 @@ void ScheduleNode::receive_forfeit(const ConflictForfeit& msg)
       + std::to_string(msg.conflict_version) + "]";
     RCLCPP_INFO(get_logger(), output.c_str());
 
+    negotiation_diagnostics->record_since(
+      "negotiation_failed", negotiation_room->opened);
     active_conflicts.conclude(msg.conflict_version);
 
     ConflictConclusion conclusion;
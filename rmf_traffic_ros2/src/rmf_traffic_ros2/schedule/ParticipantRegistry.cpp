@@ -57,6 +57,16 @@ public:
   : _database(db),
     _logger(std::move(logger))
   {
+    // The database might have been restored from a snapshot or forked from a
+    // mirror, in which case its participants must keep their current IDs
+    // instead of being registered a second time.
+    for (const auto id : _database->participant_ids())
+    {
+      const auto& description = *_database->get_participant(id);
+      _id_from_name[{description.name(), description.owner()}] = id;
+      _description.insert_or_assign(id, description);
+    }
+
     _reading_from_log = true;
     while (auto record = _logger->read_next_record())
     {
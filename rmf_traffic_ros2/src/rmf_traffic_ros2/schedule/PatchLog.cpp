@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_PatchLog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+// Every record starts with this header, and its payload is padded so that the
+// next header is aligned to 8 bytes.
+struct RecordHeader
+{
+  uint8_t type;
+  uint8_t reserved[3];
+  uint32_t size;
+  int64_t time;
+};
+static_assert(sizeof(RecordHeader) == 16, "Unexpected padding in RecordHeader");
+
+const char Magic[8] = {'R', 'M', 'F', 'P', 'L', 'O', 'G', '1'};
+
+// The file is grown by at least this much whenever it runs out of space
+const std::size_t ChunkSize = 16 * 1024 * 1024;
+
+//==============================================================================
+std::size_t padded(const std::size_t size)
+{
+  return (size + 7) & ~std::size_t(7);
+}
+
+//==============================================================================
+std::runtime_error error(const std::string& what, const std::string& path)
+{
+  return std::runtime_error(
+    "[PatchLog] " + what + " [" + path + "]: " + std::strerror(errno));
+}
+} // anonymous namespace
+
+//==============================================================================
+PatchLogWriter::PatchLogWriter(std::string file_path)
+: _file_path(std::move(file_path))
+{
+  _fd = ::open(_file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (_fd < 0)
+    throw error("Unable to create", _file_path);
+
+  _map(ChunkSize);
+  std::memcpy(_data, Magic, sizeof(Magic));
+  _end = sizeof(Magic);
+}
+
+//==============================================================================
+void PatchLogWriter::append(
+  const PatchLogRecordType type,
+  const rmf_traffic::Time time,
+  const rclcpp::SerializedMessage& message)
+{
+  const std::size_t size = message.size();
+  const std::size_t needed = sizeof(RecordHeader) + padded(size);
+  if (_end + needed > _capacity)
+    _map(std::max(2 * _capacity, _end + needed + ChunkSize));
+
+  RecordHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.type = static_cast<uint8_t>(type);
+  header.size = static_cast<uint32_t>(size);
+  header.time = time.time_since_epoch().count();
+
+  // The payload is written before the header so that a record which gets cut
+  // off by a crash still looks like the end of the log.
+  uint8_t* const record = _data + _end;
+  std::memcpy(
+    record + sizeof(RecordHeader),
+    message.get_rcl_serialized_message().buffer,
+    size);
+  std::memcpy(record, &header, sizeof(header));
+
+  _end += needed;
+  ++_records;
+}
+
+//==============================================================================
+std::size_t PatchLogWriter::records() const
+{
+  return _records;
+}
+
+//==============================================================================
+std::size_t PatchLogWriter::bytes() const
+{
+  return _end;
+}
+
+//==============================================================================
+PatchLogWriter::~PatchLogWriter()
+{
+  if (_data)
+    ::munmap(_data, _capacity);
+
+  if (_fd >= 0)
+  {
+    // If this fails, the unused space stays zeroed and the log can still be
+    // read.
+    const int truncated = ::ftruncate(_fd, static_cast<off_t>(_end));
+    (void)(truncated);
+
+    ::fsync(_fd);
+    ::close(_fd);
+  }
+}
+
+//==============================================================================
+void PatchLogWriter::_map(const std::size_t capacity)
+{
+  if (_data)
+  {
+    ::munmap(_data, _capacity);
+    _data = nullptr;
+  }
+
+  // The new space of the file reads as zeros until it gets written
+  if (::ftruncate(_fd, static_cast<off_t>(capacity)) != 0)
+    throw error("Unable to grow", _file_path);
+
+  void* const data = ::mmap(
+    nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (data == MAP_FAILED)
+    throw error("Unable to map", _file_path);
+
+  _data = static_cast<uint8_t*>(data);
+  _capacity = capacity;
+}
+
+//==============================================================================
+rclcpp::SerializedMessage PatchLogReader::Record::message() const
+{
+  rclcpp::SerializedMessage msg(size);
+  auto& raw = msg.get_rcl_serialized_message();
+  std::memcpy(raw.buffer, data, size);
+  raw.buffer_length = size;
+  return msg;
+}
+
+//==============================================================================
+PatchLogReader::PatchLogReader(const std::string& file_path)
+{
+  const int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw error("Unable to open", file_path);
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0)
+  {
+    const auto e = error("Unable to read", file_path);
+    ::close(fd);
+    throw e;
+  }
+
+  _size = static_cast<std::size_t>(info.st_size);
+  if (_size < sizeof(Magic))
+  {
+    ::close(fd);
+    throw std::runtime_error(
+      "[PatchLog] [" + file_path + "] is not a patch log");
+  }
+
+  void* const data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+    throw error("Unable to map", file_path);
+
+  _data = static_cast<const uint8_t*>(data);
+  if (std::memcmp(_data, Magic, sizeof(Magic)) != 0)
+  {
+    ::munmap(const_cast<uint8_t*>(_data), _size);
+    _data = nullptr;
+    throw std::runtime_error(
+      "[PatchLog] [" + file_path + "] is not a patch log");
+  }
+
+  std::size_t offset = sizeof(Magic);
+  while (offset + sizeof(RecordHeader) <= _size)
+  {
+    RecordHeader header;
+    std::memcpy(&header, _data + offset, sizeof(header));
+
+    // A zeroed header is the unused space of a log that was not closed
+    if (header.type == 0)
+      break;
+
+    const auto type = static_cast<PatchLogRecordType>(header.type);
+    if (type < PatchLogRecordType::ItinerarySet
+      || PatchLogRecordType::MirrorUpdate < type)
+    {
+      ::munmap(const_cast<uint8_t*>(_data), _size);
+      _data = nullptr;
+      throw std::runtime_error(
+        "[PatchLog] Unknown record type ["
+        + std::to_string(static_cast<uint32_t>(header.type)) + "] in ["
+        + file_path + "]");
+    }
+
+    const std::size_t begin = offset + sizeof(RecordHeader);
+    if (begin + header.size > _size)
+    {
+      // The final record was cut off while it was being written
+      break;
+    }
+
+    _records.push_back(
+      Record{
+        type,
+        rmf_traffic::Time(rmf_traffic::Duration(header.time)),
+        _data + begin,
+        header.size
+      });
+
+    offset = begin + padded(header.size);
+  }
+}
+
+//==============================================================================
+auto PatchLogReader::records() const -> const std::vector<Record>&
+{
+  return _records;
+}
+
+//==============================================================================
+PatchLogReader::~PatchLogReader()
+{
+  if (_data)
+    ::munmap(const_cast<uint8_t*>(_data), _size);
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_PerformanceCounters.hpp"
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+namespace {
+//==============================================================================
+template<typename Map>
+typename Map::mapped_type& entry(Map& map, const std::string_view name)
+{
+  const auto it = map.find(name);
+  if (it != map.end())
+    return it->second;
+
+  return map.emplace(std::string(name), typename Map::mapped_type()).first
+    ->second;
+}
+
+//==============================================================================
+diagnostic_msgs::msg::KeyValue make_key_value(
+  std::string key,
+  const double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = std::move(key);
+  kv.value = buffer;
+  return kv;
+}
+} // anonymous namespace
+
+//==============================================================================
+void PerformanceCounters::Timing::record(const Duration duration)
+{
+  ++count;
+  total += duration;
+  max = std::max(max, duration);
+}
+
+//==============================================================================
+PerformanceCounters::PerformanceCounters(
+  rclcpp::Node& node,
+  const Duration sample_period)
+: _source(node.get_fully_qualified_name()),
+  _enabled(sample_period > Duration(0)),
+  _clock(node.get_clock())
+{
+  if (!_enabled)
+    return;
+
+  _sample_start = std::chrono::steady_clock::now();
+  _publisher = node.create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+    DiagnosticsTopicName,
+    rclcpp::SystemDefaultsQoS().reliable().keep_last(10));
+
+  _timer = node.create_wall_timer(sample_period, [this]() { publish(); });
+}
+
+//==============================================================================
+bool PerformanceCounters::enabled() const
+{
+  return _enabled;
+}
+
+//==============================================================================
+void PerformanceCounters::count(
+  const std::string_view name,
+  const std::size_t amount)
+{
+  if (!_enabled)
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  entry(_sample.counts, name) += amount;
+}
+
+//==============================================================================
+void PerformanceCounters::record(
+  const std::string_view name,
+  const Duration duration)
+{
+  if (!_enabled)
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  entry(_sample.timings, name).record(duration);
+}
+
+//==============================================================================
+void PerformanceCounters::record_since(
+  const std::string_view name,
+  const TimePoint start)
+{
+  if (!_enabled)
+    return;
+
+  record(name, std::chrono::steady_clock::now() - start);
+}
+
+//==============================================================================
+auto PerformanceCounters::now() const -> TimePoint
+{
+  if (!_enabled)
+    return TimePoint();
+
+  return std::chrono::steady_clock::now();
+}
+
+//==============================================================================
+auto PerformanceCounters::take_sample() -> Sample
+{
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(_mutex);
+  Sample sample = std::move(_sample);
+  sample.period = now - _sample_start;
+  _sample = Sample();
+  _sample_start = now;
+  return sample;
+}
+
+//==============================================================================
+void PerformanceCounters::publish()
+{
+  if (!_enabled)
+    return;
+
+  const auto sample = take_sample();
+  const double seconds =
+    std::max(rmf_traffic::time::to_seconds(sample.period), 1e-9);
+
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = _source + ": performance";
+  status.hardware_id = _source;
+  status.message = "Performance counters over the last "
+    + std::to_string(seconds) + " s";
+
+  using rmf_traffic::time::to_seconds;
+  for (const auto& [name, count] : sample.counts)
+  {
+    status.values.push_back(
+      make_key_value(name + ".per_second", count / seconds));
+  }
+
+  for (const auto& [name, timing] : sample.timings)
+  {
+    status.values.push_back(
+      make_key_value(name + ".count", static_cast<double>(timing.count)));
+    status.values.push_back(
+      make_key_value(
+        name + ".mean_ms", 1e3 * to_seconds(timing.total) / timing.count));
+    status.values.push_back(
+      make_key_value(name + ".max_ms", 1e3 * to_seconds(timing.max)));
+    status.values.push_back(
+      make_key_value(
+        name + ".busy_fraction", to_seconds(timing.total) / seconds));
+  }
+
+  diagnostic_msgs::msg::DiagnosticArray msg;
+  msg.header.stamp = _clock->now();
+  msg.status.push_back(std::move(status));
+  _publisher->publish(msg);
+}
+
+//==============================================================================
+PerformanceCounters::Lock::Lock(
+  std::mutex& mutex,
+  PerformanceCounters& counters,
+  const std::string_view name)
+: _counters(counters),
+  _name(name)
+{
+  const auto start = _counters.now();
+  _lock = std::unique_lock<std::mutex>(mutex);
+  _acquired = _counters.now();
+  if (_counters.enabled())
+    _counters.record(std::string(_name) + ".wait", _acquired - start);
+}
+
+//==============================================================================
+std::unique_lock<std::mutex>& PerformanceCounters::Lock::get()
+{
+  return _lock;
+}
+
+//==============================================================================
+PerformanceCounters::Lock::~Lock()
+{
+  if (_counters.enabled() && _lock.owns_lock())
+  {
+    const auto held = std::chrono::steady_clock::now() - _acquired;
+    _lock.unlock();
+    _counters.record(std::string(_name) + ".hold", held);
+  }
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
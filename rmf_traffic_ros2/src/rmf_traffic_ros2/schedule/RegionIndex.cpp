@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_RegionIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+RegionIndex::RegionIndex(const double cell_size)
+: _cell_size(cell_size > 0.0 ? cell_size : 10.0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template<typename F>
+void RegionIndex::_for_each_cell(
+  const double min_x,
+  const double min_y,
+  const double max_x,
+  const double max_y,
+  F&& f) const
+{
+  const auto x0 = static_cast<int64_t>(std::floor(min_x / _cell_size));
+  const auto y0 = static_cast<int64_t>(std::floor(min_y / _cell_size));
+  const auto x1 = static_cast<int64_t>(std::floor(max_x / _cell_size));
+  const auto y1 = static_cast<int64_t>(std::floor(max_y / _cell_size));
+
+  for (int64_t x = x0; x <= x1; ++x)
+  {
+    for (int64_t y = y0; y <= y1; ++y)
+      f(CellKey{x, y});
+  }
+}
+
+//==============================================================================
+void RegionIndex::refresh(const rmf_traffic::schedule::Database& database)
+{
+  if (_database_version == database.latest_version())
+    return;
+
+  _database_version = database.latest_version();
+  const auto participants = database.participant_ids();
+
+  std::vector<ParticipantId> removed;
+  for (const auto& [id, _] : _participants)
+  {
+    if (participants.count(id) == 0)
+      removed.push_back(id);
+  }
+
+  for (const auto id : removed)
+    _erase(id);
+
+  for (const auto id : participants)
+  {
+    const auto version = database.itinerary_version(id);
+    const auto it = _participants.find(id);
+    if (it != _participants.end() && it->second.itinerary_version == version)
+      continue;
+
+    _erase(id);
+    const auto description = database.get_participant(id);
+    const auto itinerary = database.get_itinerary(id);
+    if (description && itinerary)
+      _insert(id, version, *description, *itinerary);
+  }
+}
+
+//==============================================================================
+auto RegionIndex::participants_in(const Regions& regions) const
+-> std::unordered_set<ParticipantId>
+{
+  std::unordered_set<ParticipantId> output;
+  for (const auto& region : regions)
+  {
+    const auto map_it = _maps.find(region.get_map());
+    if (map_it == _maps.end())
+      continue;
+
+    const auto& grid = map_it->second;
+    for (const auto& space : region)
+    {
+      const Eigen::Vector2d center = space.get_pose().translation();
+      const double r = space.get_shape()->get_characteristic_length();
+      const double min_x = center.x() - r;
+      const double min_y = center.y() - r;
+      const double max_x = center.x() + r;
+      const double max_y = center.y() + r;
+
+      const auto collect = [&](const Cell& cell)
+        {
+          for (const auto& [participant, _] : cell)
+            output.insert(participant);
+        };
+
+      // A space that covers more cells than the grid has is cheaper to check
+      // by walking through the occupied cells instead.
+      const double span_x = std::floor(max_x / _cell_size)
+        - std::floor(min_x / _cell_size) + 1.0;
+      const double span_y = std::floor(max_y / _cell_size)
+        - std::floor(min_y / _cell_size) + 1.0;
+      if (span_x * span_y > static_cast<double>(grid.size()))
+      {
+        const auto x0 = static_cast<int64_t>(std::floor(min_x / _cell_size));
+        const auto y0 = static_cast<int64_t>(std::floor(min_y / _cell_size));
+        const auto x1 = static_cast<int64_t>(std::floor(max_x / _cell_size));
+        const auto y1 = static_cast<int64_t>(std::floor(max_y / _cell_size));
+        for (const auto& [key, cell] : grid)
+        {
+          if (x0 <= key.x && key.x <= x1 && y0 <= key.y && key.y <= y1)
+            collect(cell);
+        }
+
+        continue;
+      }
+
+      _for_each_cell(
+        min_x, min_y, max_x, max_y, [&](const CellKey& key)
+        {
+          const auto cell_it = grid.find(key);
+          if (cell_it != grid.end())
+            collect(cell_it->second);
+        });
+    }
+  }
+
+  return output;
+}
+
+//==============================================================================
+std::size_t RegionIndex::size() const
+{
+  return _participants.size();
+}
+
+//==============================================================================
+void RegionIndex::_erase(const ParticipantId participant)
+{
+  const auto it = _participants.find(participant);
+  if (it == _participants.end())
+    return;
+
+  for (const auto& route : it->second.routes)
+  {
+    const auto map_it = _maps.find(route.map);
+    if (map_it == _maps.end())
+      continue;
+
+    auto& grid = map_it->second;
+    const auto& box = route.box;
+    _for_each_cell(
+      box.min_x, box.min_y, box.max_x, box.max_y, [&](const CellKey& key)
+      {
+        const auto cell_it = grid.find(key);
+        if (cell_it == grid.end())
+          return;
+
+        auto& cell = cell_it->second;
+        const auto count_it = cell.find(participant);
+        if (count_it != cell.end() && --count_it->second == 0)
+          cell.erase(count_it);
+
+        if (cell.empty())
+          grid.erase(cell_it);
+      });
+
+    if (grid.empty())
+      _maps.erase(map_it);
+  }
+
+  _participants.erase(it);
+}
+
+//==============================================================================
+void RegionIndex::_insert(
+  const ParticipantId participant,
+  const rmf_traffic::schedule::ItineraryVersion itinerary_version,
+  const rmf_traffic::schedule::ParticipantDescription& description,
+  const rmf_traffic::schedule::Itinerary& itinerary)
+{
+  auto& indexed = _participants[participant];
+  indexed.itinerary_version = itinerary_version;
+  for (const auto& route : itinerary)
+  {
+    if (!route)
+      continue;
+
+    const auto box = compute_box(route->trajectory(), description.profile());
+    if (!box)
+      continue;
+
+    indexed.routes.push_back(IndexedRoute{route->map(), *box});
+    auto& grid = _maps[route->map()];
+    _for_each_cell(
+      box->min_x, box->min_y, box->max_x, box->max_y, [&](const CellKey& key)
+      {
+        ++grid[key][participant];
+      });
+  }
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
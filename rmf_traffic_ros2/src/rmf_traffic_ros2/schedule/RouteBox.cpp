@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic_ros2/schedule/RouteBox.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+bool RouteBox::overlaps(const RouteBox& other) const
+{
+  if (max_x < other.min_x || other.max_x < min_x)
+    return false;
+
+  if (max_y < other.min_y || other.max_y < min_y)
+    return false;
+
+  if (finish < other.start || other.finish < start)
+    return false;
+
+  return true;
+}
+
+//==============================================================================
+std::optional<RouteBox> compute_box(
+  const rmf_traffic::Trajectory& trajectory,
+  const rmf_traffic::Profile& profile)
+{
+  if (trajectory.size() == 0)
+    return std::nullopt;
+
+  double inflation = profile.footprint()->get_characteristic_length();
+  if (profile.vicinity())
+  {
+    inflation = std::max(
+      inflation, profile.vicinity()->get_characteristic_length());
+  }
+
+  const auto& first = *trajectory.begin();
+  RouteBox box{
+    first.position().x(), first.position().y(),
+    first.position().x(), first.position().y(),
+    first.time(), first.time()
+  };
+
+  // The cubic Hermite basis functions that weight the waypoint velocities never
+  // exceed 4/27 in magnitude, so the spline of a segment can never stray
+  // further than this from the segment's waypoints.
+  constexpr double hermite_bound = 4.0/27.0;
+  double spline_margin = 0.0;
+
+  auto prev = trajectory.begin();
+  for (auto it = trajectory.begin(); it != trajectory.end(); ++it)
+  {
+    const Eigen::Vector3d p = it->position();
+    box.min_x = std::min(box.min_x, p.x());
+    box.min_y = std::min(box.min_y, p.y());
+    box.max_x = std::max(box.max_x, p.x());
+    box.max_y = std::max(box.max_y, p.y());
+    box.start = std::min(box.start, it->time());
+    box.finish = std::max(box.finish, it->time());
+
+    if (it != prev)
+    {
+      const double dt = rmf_traffic::time::to_seconds(
+        it->time() - prev->time());
+      const double v0 = prev->velocity().block<2, 1>(0, 0).norm();
+      const double v1 = it->velocity().block<2, 1>(0, 0).norm();
+      spline_margin = std::max(
+        spline_margin, hermite_bound * (v0 + v1) * std::abs(dt));
+      prev = it;
+    }
+  }
+
+  const double margin = inflation + spline_margin;
+  box.min_x -= margin;
+  box.min_y -= margin;
+  box.max_x += margin;
+  box.max_y += margin;
+
+  return box;
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
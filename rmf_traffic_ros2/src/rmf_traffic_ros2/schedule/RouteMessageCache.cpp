@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_RouteMessageCache.hpp"
+
+#include <rmf_traffic_ros2/Route.hpp>
+
+#include <cassert>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+RouteMessageCache::RouteMessageCache(const std::size_t capacity)
+: _capacity(capacity)
+{
+  // Do nothing
+}
+
+//==============================================================================
+rmf_traffic_msgs::msg::Route RouteMessageCache::convert(
+  const rmf_traffic::ConstRoutePtr& route)
+{
+  assert(route);
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _entries.find(route.get());
+  if (it != _entries.end())
+  {
+    // The caller is holding the route, so if the entry's route has expired
+    // then the address has been reused by a different route.
+    if (!it->second.route.expired())
+      return it->second.msg;
+
+    _entries.erase(it);
+  }
+
+  auto msg = rmf_traffic_ros2::convert(*route);
+  if (_capacity == 0)
+    return msg;
+
+  _make_room();
+  _entries.insert({route.get(), Entry{route, msg}});
+  return msg;
+}
+
+//==============================================================================
+std::vector<rmf_traffic_msgs::msg::ScheduleWriterItem>
+RouteMessageCache::convert(const rmf_traffic::schedule::Writer::Input& input)
+{
+  std::vector<rmf_traffic_msgs::msg::ScheduleWriterItem> output;
+  output.reserve(input.size());
+  for (const auto& item : input)
+  {
+    rmf_traffic_msgs::msg::ScheduleWriterItem msg;
+    msg.id = item.id;
+    msg.route = convert(item.route);
+    output.push_back(std::move(msg));
+  }
+
+  return output;
+}
+
+//==============================================================================
+std::vector<rmf_traffic_msgs::msg::Route> RouteMessageCache::convert(
+  const rmf_traffic::schedule::Itinerary& itinerary)
+{
+  std::vector<rmf_traffic_msgs::msg::Route> output;
+  output.reserve(itinerary.size());
+  for (const auto& route : itinerary)
+    output.emplace_back(convert(route));
+
+  return output;
+}
+
+//==============================================================================
+std::vector<rmf_traffic_msgs::msg::Itinerary> RouteMessageCache::convert(
+  const std::vector<rmf_traffic::schedule::Itinerary>& itineraries)
+{
+  std::vector<rmf_traffic_msgs::msg::Itinerary> output;
+  output.reserve(itineraries.size());
+  for (const auto& itinerary : itineraries)
+  {
+    rmf_traffic_msgs::msg::Itinerary msg;
+    msg.routes = convert(itinerary);
+    output.emplace_back(std::move(msg));
+  }
+
+  return output;
+}
+
+//==============================================================================
+std::size_t RouteMessageCache::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+//==============================================================================
+void RouteMessageCache::_make_room()
+{
+  if (_entries.size() < _capacity)
+    return;
+
+  for (auto it = _entries.begin(); it != _entries.end(); )
+  {
+    if (it->second.route.expired())
+      it = _entries.erase(it);
+    else
+      ++it;
+  }
+
+  if (_entries.size() >= _capacity)
+    _entries.clear();
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
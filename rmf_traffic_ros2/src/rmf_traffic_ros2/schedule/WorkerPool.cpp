@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_WorkerPool.hpp"
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+WorkerPool::WorkerPool(const std::size_t num_workers)
+{
+  const std::size_t extra_threads = num_workers > 1 ? num_workers - 1 : 0;
+  _threads.reserve(extra_threads);
+  for (std::size_t i = 0; i < extra_threads; ++i)
+    _threads.emplace_back([this]() { this->_work(); });
+}
+
+//==============================================================================
+void WorkerPool::run(const std::size_t num_jobs, const Job& job)
+{
+  if (num_jobs == 0)
+    return;
+
+  if (_threads.empty() || num_jobs == 1)
+  {
+    for (std::size_t i = 0; i < num_jobs; ++i)
+      job(i);
+
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _job = &job;
+    _num_jobs = num_jobs;
+    _next_job = 0;
+    _busy_workers = _threads.size();
+    ++_generation;
+  }
+  _start_cv.notify_all();
+
+  // The calling thread helps out instead of sitting idle
+  for (std::size_t i = _next_job++; i < num_jobs; i = _next_job++)
+    job(i);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _finish_cv.wait(lock, [&]() { return _busy_workers == 0; });
+  _job = nullptr;
+}
+
+//==============================================================================
+std::size_t WorkerPool::size() const
+{
+  return _threads.size() + 1;
+}
+
+//==============================================================================
+WorkerPool::~WorkerPool()
+{
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _start_cv.notify_all();
+
+  for (auto& thread : _threads)
+  {
+    if (thread.joinable())
+      thread.join();
+  }
+}
+
+//==============================================================================
+void WorkerPool::_work()
+{
+  uint64_t last_generation = 0;
+  while (true)
+  {
+    const Job* job = nullptr;
+    std::size_t num_jobs = 0;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _start_cv.wait(lock, [&]()
+        {
+          return _quit || _generation != last_generation;
+        });
+
+      if (_quit)
+        return;
+
+      last_generation = _generation;
+      job = _job;
+      num_jobs = _num_jobs;
+    }
+
+    for (std::size_t i = _next_job++; i < num_jobs; i = _next_job++)
+      (*job)(i);
+
+    bool finished = false;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      finished = (--_busy_workers == 0);
+    }
+
+    if (finished)
+      _finish_cv.notify_all();
+  }
+}
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
@@ -33,8 +33,18 @@
 #include <rmf_traffic_msgs/srv/register_participant.hpp>
 #include <rmf_traffic_msgs/srv/unregister_participant.hpp>
 
+#include <rmf_utils/Modular.hpp>
 #include <rmf_utils/RateLimiter.hpp>
 
+#include "internal_ItineraryHistory.hpp"
+#include "internal_RouteMessageCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <list>
+#include <mutex>
+
 using namespace std::chrono_literals;
 
 namespace rmf_traffic_ros2 {
@@ -101,6 +111,12 @@ public:
     return requester;
   }
 
+  bool owns(const rmf_traffic::schedule::ParticipantId participant) const
+  {
+    const auto it = rectifier_map.find(participant);
+    return it != rectifier_map.end() && !it->second.expired();
+  }
+
   void check_inconsistencies(const InconsistencyMsg& msg)
   {
     if (msg.ranges.empty())
@@ -252,6 +268,28 @@ RectifierFactory::Requester::Requester(
   // Do nothing
 }
 
+//==============================================================================
+/// Fill in a message and publish it. When the middleware can loan messages of
+/// this type, the message is written straight into the loaned memory, which is
+/// the case for the fixed-size delay and clear messages on shared memory
+/// transports. Otherwise the message is built once in the storage that gets
+/// handed over to the publisher.
+template<typename Message, typename Fill>
+void publish_in_place(rclcpp::Publisher<Message>& publisher, const Fill& fill)
+{
+  if (publisher.can_loan_messages())
+  {
+    auto loaned = publisher.borrow_loaned_message();
+    fill(loaned.get());
+    publisher.publish(std::move(loaned));
+    return;
+  }
+
+  auto msg = std::make_unique<Message>();
+  fill(*msg);
+  publisher.publish(std::move(msg));
+}
+
 } // anonymous namespace
 
 //==============================================================================
@@ -278,6 +316,15 @@ public:
     rclcpp::Publisher<Erase>::SharedPtr erase_pub;
     rclcpp::Publisher<Clear>::SharedPtr clear_pub;
 
+    // Participants often send the same routes again, e.g. when an itinerary
+    // is set to a mix of old and new routes, so we remember their messages.
+    RouteMessageCache route_cache;
+
+    // The recent itineraries of the participants, so that a long range of
+    // missing changes can be replaced by a single itinerary set
+    ItineraryHistory history;
+    std::atomic_size_t rectification_set_threshold = 20;
+
     rclcpp::Context::SharedPtr context;
 
     using Register = rmf_traffic_msgs::srv::RegisterParticipant;
@@ -286,6 +333,19 @@ public:
     rclcpp::Client<Register>::SharedPtr register_client;
     rclcpp::Client<Unregister>::SharedPtr unregister_client;
 
+    // Registration requests that were sent before their participant started
+    // being created. Creating a participant blocks until its registration is
+    // answered, so sending every request of a batch up front lets the whole
+    // batch wait for one round trip instead of one per participant.
+    using RegisterResponse = std::shared_future<Register::Response::SharedPtr>;
+    struct PendingRegistration
+    {
+      rmf_traffic::schedule::ParticipantDescription description;
+      RegisterResponse response;
+    };
+    std::mutex pending_registrations_mutex;
+    std::list<PendingRegistration> pending_registrations;
+
     using FailOverEvent = rmf_traffic_msgs::msg::FailOverEvent;
     using FailOverEventSub = rclcpp::Subscription<FailOverEvent>::SharedPtr;
     FailOverEventSub fail_over_event_sub;
@@ -363,7 +423,7 @@ public:
         [w = transport->weak_from_this()](const InconsistencyMsg::UniquePtr msg)
         {
           if (const auto self = w.lock())
-            self->rectifier_factory->check_inconsistencies(*msg);
+            self->handle_inconsistencies(*msg);
         });
 
       return transport;
@@ -374,12 +434,22 @@ public:
       const Input& itinerary,
       const rmf_traffic::schedule::ItineraryVersion version) final
     {
-      Set msg;
-      msg.participant = participant;
-      msg.itinerary = convert(itinerary);
-      msg.itinerary_version = version;
+      history.set(participant, itinerary, version);
+      publish_set(participant, itinerary, version);
+    }
 
-      set_pub->publish(std::move(msg));
+    void publish_set(
+      const rmf_traffic::schedule::ParticipantId participant,
+      const Input& itinerary,
+      const rmf_traffic::schedule::ItineraryVersion version)
+    {
+      publish_in_place(
+        *set_pub, [&](Set& msg)
+        {
+          msg.participant = participant;
+          msg.itinerary = route_cache.convert(itinerary);
+          msg.itinerary_version = version;
+        });
     }
 
     void extend(
@@ -387,12 +457,14 @@ public:
       const Input& routes,
       const rmf_traffic::schedule::ItineraryVersion version) final
     {
-      Extend msg;
-      msg.participant = participant;
-      msg.routes = convert(routes);
-      msg.itinerary_version = version;
-
-      extend_pub->publish(std::move(msg));
+      history.extend(participant, routes, version);
+      publish_in_place(
+        *extend_pub, [&](Extend& msg)
+        {
+          msg.participant = participant;
+          msg.routes = route_cache.convert(routes);
+          msg.itinerary_version = version;
+        });
     }
 
     void delay(
@@ -400,12 +472,14 @@ public:
       const rmf_traffic::Duration duration,
       const rmf_traffic::schedule::ItineraryVersion version) final
     {
-      Delay msg;
-      msg.participant = participant;
-      msg.delay = duration.count();
-      msg.itinerary_version = version;
-
-      delay_pub->publish(std::move(msg));
+      history.delay(participant, duration, version);
+      publish_in_place(
+        *delay_pub, [&](Delay& msg)
+        {
+          msg.participant = participant;
+          msg.delay = duration.count();
+          msg.itinerary_version = version;
+        });
     }
 
     void erase(
@@ -413,34 +487,149 @@ public:
       const std::vector<rmf_traffic::RouteId>& routes,
       const rmf_traffic::schedule::ItineraryVersion version) final
     {
-      Erase msg;
-      msg.participant = participant;
-      msg.routes = routes;
-      msg.itinerary_version = version;
-
-      erase_pub->publish(std::move(msg));
+      history.erase(participant, routes, version);
+      publish_in_place(
+        *erase_pub, [&](Erase& msg)
+        {
+          msg.participant = participant;
+          msg.routes = routes;
+          msg.itinerary_version = version;
+        });
     }
 
     void erase(
       const rmf_traffic::schedule::ParticipantId participant,
       const rmf_traffic::schedule::ItineraryVersion version) final
     {
-      Clear msg;
-      msg.participant = participant;
-      msg.itinerary_version = version;
+      history.clear(participant, version);
+      publish_clear(participant, version);
+    }
+
+    void publish_clear(
+      const rmf_traffic::schedule::ParticipantId participant,
+      const rmf_traffic::schedule::ItineraryVersion version)
+    {
+      publish_in_place(
+        *clear_pub, [&](Clear& msg)
+        {
+          msg.participant = participant;
+          msg.itinerary_version = version;
+        });
+    }
 
-      clear_pub->publish(std::move(msg));
+    void handle_inconsistencies(const InconsistencyMsg& msg)
+    {
+      if (!collapse_inconsistencies(msg))
+        rectifier_factory->check_inconsistencies(msg);
     }
 
-    Registration register_participant(
-      rmf_traffic::schedule::ParticipantDescription participant_info) final
+    /// A set or clear replaces every earlier change of an itinerary, so when
+    /// many changes are missing we send one of those instead of retransmitting
+    /// each change. Returns false if the missing changes still need to be
+    /// retransmitted.
+    bool collapse_inconsistencies(const InconsistencyMsg& msg)
     {
-      using namespace std::chrono_literals;
+      const std::size_t threshold = rectification_set_threshold;
+      if (threshold == 0 || msg.ranges.empty())
+        return false;
 
+      if (!rectifier_factory->owns(msg.participant))
+        return false;
+
+      std::size_t missing = 0;
+      auto last_missing = msg.ranges.front().upper;
+      for (const auto& r : msg.ranges)
+      {
+        missing += r.upper - r.lower + 1;
+        if (rmf_utils::modular(last_missing).less_than(r.upper))
+          last_missing = r.upper;
+      }
+
+      if (missing < threshold)
+        return false;
+
+      const auto latest = history.latest_version(msg.participant);
+      if (!latest.has_value())
+        return false;
+
+      // If the schedule has not heard about our latest change yet, then our
+      // latest itinerary covers everything. Otherwise we send the itinerary as
+      // of the last missing change, and the schedule applies the changes that
+      // it already received after that on top of it.
+      const auto version =
+        rmf_utils::modular(msg.last_known_version).less_than(*latest) ?
+        *latest : last_missing;
+
+      const auto itinerary = history.itinerary(msg.participant, version);
+      if (!itinerary.has_value())
+        return false;
+
+      if (itinerary->empty())
+        publish_clear(msg.participant, version);
+      else
+        publish_set(msg.participant, *itinerary, version);
+
+      return true;
+    }
+
+    RegisterResponse send_registration(
+      const rmf_traffic::schedule::ParticipantDescription& participant_info)
+    {
       auto request = std::make_shared<Register::Request>();
       request->description = convert(participant_info);
 
-      auto future = register_client->async_send_request(std::move(request));
+      auto promise =
+        std::make_shared<std::promise<Register::Response::SharedPtr>>();
+      RegisterResponse response = promise->get_future().share();
+
+      register_client->async_send_request(
+        std::move(request),
+        [promise](const rclcpp::Client<Register>::SharedFuture future)
+        {
+          promise->set_value(future.get());
+        });
+
+      return response;
+    }
+
+    void send_registration_ahead(
+      rmf_traffic::schedule::ParticipantDescription participant_info)
+    {
+      auto response = send_registration(participant_info);
+      std::lock_guard<std::mutex> lock(pending_registrations_mutex);
+      pending_registrations.push_back(
+        PendingRegistration{std::move(participant_info), std::move(response)});
+    }
+
+    RegisterResponse take_registration(
+      const rmf_traffic::schedule::ParticipantDescription& participant_info)
+    {
+      {
+        std::lock_guard<std::mutex> lock(pending_registrations_mutex);
+        const auto it = std::find_if(
+          pending_registrations.begin(), pending_registrations.end(),
+          [&](const PendingRegistration& pending)
+          {
+            return pending.description == participant_info;
+          });
+
+        if (it != pending_registrations.end())
+        {
+          auto response = std::move(it->response);
+          pending_registrations.erase(it);
+          return response;
+        }
+      }
+
+      return send_registration(participant_info);
+    }
+
+    Registration register_participant(
+      rmf_traffic::schedule::ParticipantDescription participant_info) final
+    {
+      using namespace std::chrono_literals;
+
+      const auto future = take_registration(participant_info);
       while (future.wait_for(100ms) != std::future_status::ready)
       {
         if (!rclcpp::ok(context))
@@ -499,6 +688,8 @@ public:
     void unregister_participant(
       const rmf_traffic::schedule::ParticipantId participant) final
     {
+      history.forget(participant);
+
       auto request = std::make_shared<Unregister::Request>();
       request->participant_id = participant;
 
@@ -527,7 +718,13 @@ public:
       RCLCPP_INFO(
         node->get_logger(),
         "Reconnecting services for Writer::Transport");
-      // Deleting the old services will shut them down
+      // Deleting the old services will shut them down. Any registration that
+      // was sent ahead to the old service gets sent again when it is needed.
+      {
+        std::lock_guard<std::mutex> lock(pending_registrations_mutex);
+        pending_registrations.clear();
+      }
+
       register_client =
         node->create_client<Register>(RegisterParticipantSrvName);
       unregister_client =
@@ -617,6 +814,10 @@ public:
     rmf_traffic::schedule::ParticipantDescription description,
     std::function<void(rmf_traffic::schedule::Participant)> ready_callback)
   {
+    // Send the registration right away so that participants which are made
+    // in quick succession do not wait on each other's round trips.
+    transport->send_registration_ahead(description);
+
     std::thread worker(
       [description = std::move(description),
       this,
@@ -636,6 +837,34 @@ public:
 
     worker.detach();
   }
+
+  void async_make_participants(
+    std::vector<rmf_traffic::schedule::ParticipantDescription> descriptions,
+    std::function<void(std::vector<rmf_traffic::schedule::Participant>)>
+    ready_callback)
+  {
+    for (const auto& description : descriptions)
+      transport->send_registration_ahead(description);
+
+    std::thread worker(
+      [descriptions = std::move(descriptions),
+      this,
+      ready_callback = std::move(ready_callback)]() mutable
+      {
+        std::vector<rmf_traffic::schedule::Participant> participants;
+        participants.reserve(descriptions.size());
+        for (auto& description : descriptions)
+        {
+          participants.push_back(rmf_traffic::schedule::make_participant(
+            std::move(description), transport, transport->rectifier_factory));
+        }
+
+        if (ready_callback)
+          ready_callback(std::move(participants));
+      });
+
+    worker.detach();
+  }
 };
 
 //==============================================================================
@@ -691,6 +920,29 @@ void Writer::async_make_participant(
     std::move(description), std::move(ready_callback));
 }
 
+//==============================================================================
+void Writer::async_make_participants(
+  std::vector<rmf_traffic::schedule::ParticipantDescription> descriptions,
+  std::function<void(std::vector<rmf_traffic::schedule::Participant>)>
+  ready_callback)
+{
+  _pimpl->async_make_participants(
+    std::move(descriptions), std::move(ready_callback));
+}
+
+//==============================================================================
+Writer& Writer::rectification_set_threshold(std::size_t threshold)
+{
+  _pimpl->transport->rectification_set_threshold = threshold;
+  return *this;
+}
+
+//==============================================================================
+std::size_t Writer::rectification_set_threshold() const
+{
+  return _pimpl->transport->rectification_set_threshold;
+}
+
 //==============================================================================
 Writer::Writer()
 {
@@ -25,6 +25,7 @@ std::vector<rmf_traffic_msgs::msg::Route> convert(
   const rmf_traffic::schedule::Itinerary& from)
 {
   std::vector<rmf_traffic_msgs::msg::Route> output;
+  output.reserve(from.size());
   for (const auto& r : from)
     output.emplace_back(convert(*r));
 
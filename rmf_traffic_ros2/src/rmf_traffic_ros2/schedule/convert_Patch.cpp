@@ -17,6 +17,7 @@
 
 #include <rmf_traffic_ros2/schedule/Patch.hpp>
 #include <rmf_traffic_ros2/schedule/Change.hpp>
+#include <rmf_traffic_ros2/Route.hpp>
 
 #include <rmf_traffic_msgs/msg/schedule_participant_patch.hpp>
 #include <rmf_traffic_msgs/msg/schedule_change_cull.hpp>
@@ -107,6 +108,56 @@ rmf_traffic_msgs::msg::SchedulePatch convert(
   return output;
 }
 
+//==============================================================================
+void convert(
+  const rmf_traffic::schedule::Patch::Participant& from,
+  rmf_traffic_msgs::msg::ScheduleParticipantPatch& into)
+{
+  into.participant_id = from.participant_id();
+  into.itinerary_version = from.itinerary_version();
+  into.erasures = from.erasures().ids();
+
+  const auto& delays = from.delays();
+  into.delays.resize(delays.size());
+  for (std::size_t i = 0; i < delays.size(); ++i)
+    into.delays[i].delay = delays[i].duration().count();
+
+  const auto& additions = from.additions().items();
+  into.additions.resize(additions.size());
+  for (std::size_t i = 0; i < additions.size(); ++i)
+  {
+    const auto& item = additions[i];
+    if (!item.route)
+      throw std::runtime_error("Cannot convert a nullptr route into a message");
+
+    into.additions[i].id = item.id;
+    convert(*item.route, into.additions[i].route);
+  }
+}
+
+//==============================================================================
+void convert(
+  const rmf_traffic::schedule::Patch& from,
+  rmf_traffic_msgs::msg::SchedulePatch& into)
+{
+  into.participants.resize(from.size());
+  auto participant = into.participants.begin();
+  for (const auto& p : from)
+    convert(p, *participant++);
+
+  if (const auto& cull = from.cull())
+  {
+    into.cull.resize(1);
+    into.cull.front().time = cull->time().time_since_epoch().count();
+  }
+  else
+    into.cull.clear();
+
+  into.has_base_version = from.base_version().has_value();
+  into.base_version = from.base_version().value_or(0);
+  into.latest_version = from.latest_version();
+}
+
 //==============================================================================
 rmf_traffic::schedule::Patch convert(
   const rmf_traffic_msgs::msg::SchedulePatch& from)
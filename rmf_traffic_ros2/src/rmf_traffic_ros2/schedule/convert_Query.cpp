@@ -124,11 +124,12 @@ geometry_msgs::msg::Pose2D from_eigen(const Eigen::Isometry2d& pose)
 }
 
 //==============================================================================
-rmf_traffic_msgs::msg::Timespan convert_timespan(
+void convert_timespan(
   const rmf_traffic::Time* lower_bound,
-  const rmf_traffic::Time* upper_bound)
+  const rmf_traffic::Time* upper_bound,
+  rmf_traffic_msgs::msg::Timespan& msg)
 {
-  rmf_traffic_msgs::msg::Timespan msg;
+  msg.maps.clear();
   if (lower_bound)
   {
     msg.has_lower_bound = true;
@@ -144,8 +145,18 @@ rmf_traffic_msgs::msg::Timespan convert_timespan(
   }
   else
     msg.has_upper_bound = false;
+}
 
-  return msg;
+//==============================================================================
+/// Get the element of a message vector at an index, adding one if the vector
+/// is not that long yet. Elements that already exist are reused as they are.
+template<typename T>
+T& reuse_element(std::vector<T>& elements, const std::size_t index)
+{
+  if (elements.size() <= index)
+    elements.emplace_back();
+
+  return elements[index];
 }
 
 //==============================================================================
@@ -154,26 +165,29 @@ void convert_regions(
   const rmf_traffic::schedule::Query::Spacetime::Regions& from)
 {
   geometry::ShapeContext shape_context;
+  std::size_t num_regions = 0;
   for (const auto& region : from)
   {
-    rmf_traffic_msgs::msg::Region region_msg;
+    auto& region_msg = reuse_element(msg.regions, num_regions++);
     region_msg.map = region.get_map();
 
-    region_msg.timespan = convert_timespan(
+    convert_timespan(
       region.get_lower_time_bound(),
-      region.get_upper_time_bound());
+      region.get_upper_time_bound(),
+      region_msg.timespan);
 
+    std::size_t num_spaces = 0;
     for (const auto& space : region)
     {
-      rmf_traffic_msgs::msg::Space space_msg;
+      auto& space_msg = reuse_element(region_msg.spaces, num_spaces++);
       space_msg.shape = shape_context.insert(space.get_shape());
       space_msg.pose = from_eigen(space.get_pose());
-      region_msg.spaces.emplace_back(std::move(space_msg));
     }
 
-    msg.regions.emplace_back(std::move(region_msg));
+    region_msg.spaces.resize(num_spaces);
   }
 
+  msg.regions.resize(num_regions);
   msg.shape_context = convert(shape_context);
 }
 
@@ -182,9 +196,10 @@ void convert_timespan(
   rmf_traffic_msgs::msg::ScheduleQuerySpacetime& msg,
   const rmf_traffic::schedule::Query::Spacetime::Timespan& from)
 {
-  msg.timespan = convert_timespan(
+  convert_timespan(
     from.get_lower_time_bound(),
-    from.get_upper_time_bound());
+    from.get_upper_time_bound(),
+    msg.timespan);
 }
 } // anonymous namespace
 
@@ -193,15 +208,32 @@ rmf_traffic_msgs::msg::ScheduleQuerySpacetime convert(
   const rmf_traffic::schedule::Query::Spacetime& from)
 {
   rmf_traffic_msgs::msg::ScheduleQuerySpacetime msg;
+  convert(from, msg);
+  return msg;
+}
+
+//==============================================================================
+void convert(
+  const rmf_traffic::schedule::Query::Spacetime& from,
+  rmf_traffic_msgs::msg::ScheduleQuerySpacetime& into)
+{
   const auto mode = from.get_mode();
-  msg.type = static_cast<uint16_t>(mode);
+  into.type = static_cast<uint16_t>(mode);
 
   if (rmf_traffic::schedule::Query::Spacetime::Mode::Regions == mode)
-    convert_regions(msg, *from.regions());
-  else if (rmf_traffic::schedule::Query::Spacetime::Mode::Timespan == mode)
-    convert_timespan(msg, *from.timespan());
+  {
+    convert_regions(into, *from.regions());
+  }
+  else
+  {
+    into.regions.clear();
+    into.shape_context = rmf_traffic_msgs::msg::ShapeContext();
+  }
 
-  return msg;
+  if (rmf_traffic::schedule::Query::Spacetime::Mode::Timespan == mode)
+    convert_timespan(into, *from.timespan());
+  else
+    into.timespan = rmf_traffic_msgs::msg::Timespan();
 }
 
 //==============================================================================
@@ -229,19 +261,27 @@ rmf_traffic::schedule::Query::Participants convert(
 rmf_traffic_msgs::msg::ScheduleQueryParticipants convert(
   const rmf_traffic::schedule::Query::Participants& from)
 {
-  using Participants = rmf_traffic::schedule::Query::Participants;
-
   rmf_traffic_msgs::msg::ScheduleQueryParticipants output;
+  convert(from, output);
+  return output;
+}
+
+//==============================================================================
+void convert(
+  const rmf_traffic::schedule::Query::Participants& from,
+  rmf_traffic_msgs::msg::ScheduleQueryParticipants& into)
+{
+  using Participants = rmf_traffic::schedule::Query::Participants;
 
   const auto mode = from.get_mode();
-  output.type = static_cast<uint16_t>(mode);
+  into.type = static_cast<uint16_t>(mode);
 
   if (Participants::Mode::Exclude == mode)
-    output.ids = from.exclude()->get_ids();
+    into.ids = from.exclude()->get_ids();
   else if (Participants::Mode::Include == mode)
-    output.ids = from.include()->get_ids();
-
-  return output;
+    into.ids = from.include()->get_ids();
+  else
+    into.ids.clear();
 }
 
 //==============================================================================
@@ -260,10 +300,17 @@ rmf_traffic_msgs::msg::ScheduleQuery convert(
   const rmf_traffic::schedule::Query& from)
 {
   rmf_traffic_msgs::msg::ScheduleQuery output;
-  output.spacetime = convert(from.spacetime());
-  output.participants = convert(from.participants());
-
+  convert(from, output);
   return output;
 }
 
+//==============================================================================
+void convert(
+  const rmf_traffic::schedule::Query& from,
+  rmf_traffic_msgs::msg::ScheduleQuery& into)
+{
+  convert(from.spacetime(), into.spacetime);
+  convert(from.participants(), into.participants);
+}
+
 } // namespace rmf_traffic_ros2
@@ -25,6 +25,7 @@ rmf_traffic::schedule::Writer::Input convert(
   const std::vector<rmf_traffic_msgs::msg::ScheduleWriterItem>& from)
 {
   rmf_traffic::schedule::Writer::Input output;
+  output.reserve(from.size());
   for (const auto& item : from)
   {
     output.emplace_back(
@@ -42,6 +43,7 @@ std::vector<rmf_traffic_msgs::msg::ScheduleWriterItem> convert(
   const rmf_traffic::schedule::Writer::Input& from)
 {
   std::vector<rmf_traffic_msgs::msg::ScheduleWriterItem> output;
+  output.reserve(from.size());
   for (const auto& item : from)
   {
     rmf_traffic_msgs::msg::ScheduleWriterItem msg;
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CHECKEDROUTES_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CHECKEDROUTES_HPP
+
+#include <rmf_traffic/Route.hpp>
+#include <rmf_traffic/schedule/Itinerary.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Remembers the itinerary of each participant as it was the last time it was
+/// checked for conflicts, so a changed route only needs to be checked from the
+/// point where it stopped matching a route that was already checked. This is
+/// common when a participant replans and sets an itinerary that starts the
+/// same way as its previous one.
+///
+/// A participant that was found in a conflict does not have its routes
+/// remembered, so conflicts in the unchanged part of a route keep getting
+/// reported for as long as they remain.
+class CheckedRoutes
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+
+  /// Get the part of a route that has changed since the participant's routes
+  /// were last checked. This is the whole route if it does not start the same
+  /// way as any checked route, and a nullptr if nothing has changed.
+  rmf_traffic::ConstRoutePtr changed_part(
+    ParticipantId participant,
+    const rmf_traffic::ConstRoutePtr& route) const;
+
+  /// Remember the itineraries of participants that have just been checked.
+  /// Participants that are in a conflict get forgotten instead.
+  void update(
+    const std::unordered_map<ParticipantId, rmf_traffic::schedule::Itinerary>&
+    checked,
+    const std::unordered_set<ParticipantId>& in_conflict);
+
+  /// Forget every participant, e.g. because their profiles may have changed
+  void clear();
+
+private:
+  std::unordered_map<ParticipantId, rmf_traffic::schedule::Itinerary> _routes;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CHECKEDROUTES_HPP
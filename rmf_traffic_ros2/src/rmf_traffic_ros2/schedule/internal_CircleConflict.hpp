@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CIRCLECONFLICT_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CIRCLECONFLICT_HPP
+
+#include <rmf_traffic/Profile.hpp>
+#include <rmf_traffic/Trajectory.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// The segments of a trajectory whose profile only uses circles, stored as a
+/// structure of arrays so that many pairs of segments can be compared in one
+/// tight loop that the compiler can vectorize.
+///
+/// Each segment is bounded by the box around the control points of its
+/// Bezier form, and the curve of a cubic spline never leaves the hull of its
+/// control points. That makes the comparison conservative: it can rule a pair
+/// of trajectories out, but it cannot confirm a conflict.
+struct CircleSegments
+{
+  /// Take apart a trajectory. Returns std::nullopt if the profile uses any
+  /// shape other than a circle, or if the trajectory has no segments.
+  static std::optional<CircleSegments> make(
+    const rmf_traffic::Profile& profile,
+    const rmf_traffic::Trajectory& trajectory);
+
+  /// The largest radius out of the footprint and the vicinity
+  double radius = 0.0;
+
+  // The span of time of each segment, in seconds since the clock's epoch
+  std::vector<double> start;
+  std::vector<double> finish;
+
+  // The box that each segment stays inside of
+  std::vector<double> min_x;
+  std::vector<double> max_x;
+  std::vector<double> min_y;
+  std::vector<double> max_y;
+};
+
+//==============================================================================
+/// Check whether any pair of segments that overlap in time come close enough
+/// together for the circles to touch. A false result means the trajectories
+/// cannot be in conflict.
+bool may_conflict(const CircleSegments& a, const CircleSegments& b);
+
+//==============================================================================
+/// Same as rmf_traffic::DetectConflict::between(~).has_value(), except that
+/// pairs of circle profiles are ruled out by may_conflict(~) first. The exact
+/// test only runs for the pairs that it cannot rule out. The segments of the
+/// first trajectory may be given if they were already made.
+bool detect_conflict(
+  const rmf_traffic::Profile& profile_a,
+  const rmf_traffic::Trajectory& trajectory_a,
+  const rmf_traffic::Profile& profile_b,
+  const rmf_traffic::Trajectory& trajectory_b,
+  const CircleSegments* segments_a = nullptr);
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CIRCLECONFLICT_HPP
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_COMPACTPATCH_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_COMPACTPATCH_HPP
+
+#include <rmf_traffic/schedule/Patch.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Settings that the encoder and decoder of a compact patch stream share
+struct CompactPatchOptions
+{
+  /// Positions and linear velocities are rounded to a multiple of this many
+  /// meters (or meters per second)
+  double position_resolution = 1e-3;
+
+  /// Orientations and angular velocities are rounded to a multiple of this
+  /// many radians (or radians per second)
+  double angle_resolution = 1e-4;
+
+  /// How many of the most recently sent routes can be referred to by later
+  /// patches instead of being sent again
+  std::size_t route_history = 1024;
+};
+
+//==============================================================================
+/// Encodes a stream of patches into a compact binary format. Waypoints are
+/// quantized and delta-encoded as variable length integers, and a route whose
+/// shape matches a recently sent route is sent as a reference to that route
+/// plus its new start time, which covers the routes that get resent by an
+/// itinerary set or shifted by a delay.
+///
+/// References make the stream stateful, so every encoded patch must be
+/// decoded, in order, by the same CompactPatchDecoder. If the receiver misses
+/// a patch, both sides need to be reset. The first patch after a reset starts
+/// a new stream that any decoder can pick up, so one encoder can serve
+/// receivers that join at different times. The options are written into each
+/// patch, so the decoder does not need to be told about them.
+class CompactPatchEncoder
+{
+public:
+
+  CompactPatchEncoder(CompactPatchOptions options = CompactPatchOptions());
+
+  /// Encode the next patch of the stream
+  std::string encode(const rmf_traffic::schedule::Patch& patch);
+
+  /// Forget every route that has been sent so far
+  void reset();
+
+private:
+  CompactPatchOptions _options;
+  uint64_t _next_sequence = 0;
+
+  // The encoded shape of each recently sent route, and its sequence number
+  std::unordered_map<std::string, uint64_t> _sequence_of_shape;
+  std::vector<std::string> _history;
+};
+
+//==============================================================================
+/// Decodes the patches that were produced by a CompactPatchEncoder
+class CompactPatchDecoder
+{
+public:
+
+  /// Decode the next patch of the stream. A patch that starts a new stream is
+  /// always accepted.
+  ///
+  /// \throws std::runtime_error if the data is malformed or does not follow
+  /// the last patch that was decoded. The decoder must be reset afterwards.
+  rmf_traffic::schedule::Patch decode(const std::string& data);
+
+  /// Forget every route that has been received so far
+  void reset();
+
+  // The parts of a route that remain the same when it gets delayed
+  struct Waypoint
+  {
+    rmf_traffic::Duration offset;
+    Eigen::Vector3d position;
+    Eigen::Vector3d velocity;
+  };
+
+  struct Shape
+  {
+    std::string map;
+    std::vector<Waypoint> waypoints;
+  };
+
+private:
+  uint64_t _next_sequence = 0;
+  std::vector<Shape> _history;
+};
+
+//==============================================================================
+/// What a compact update message carries besides its encoded patch. These are
+/// the other fields of a MirrorUpdate message.
+struct CompactUpdateHeader
+{
+  uint64_t node_version = 0;
+  uint64_t database_version = 0;
+  bool is_remedial_update = false;
+};
+
+//==============================================================================
+/// Put a header in front of an encoded patch to make the data of a compact
+/// update message
+std::vector<uint8_t> make_compact_update(
+  const CompactUpdateHeader& header,
+  const std::string& patch);
+
+//==============================================================================
+/// Split the data of a compact update message into its header and its encoded
+/// patch
+///
+/// \throws std::runtime_error if the header is malformed
+CompactUpdateHeader read_compact_update(
+  const std::vector<uint8_t>& data,
+  std::string& patch);
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_COMPACTPATCH_HPP
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CONFLICTINDEX_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CONFLICTINDEX_HPP
+
+#include <rmf_traffic/Profile.hpp>
+#include <rmf_traffic/Route.hpp>
+#include <rmf_traffic/schedule/Itinerary.hpp>
+#include <rmf_traffic/schedule/ParticipantDescription.hpp>
+
+#include <rmf_traffic_ros2/schedule/RouteBox.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// A broad phase index for conflict detection. The routes of every participant
+/// on the schedule are bucketed into a uniform grid of cells for each map.
+/// Candidate pairs for the narrow phase are found by only looking at routes
+/// that share a cell with the route being checked and whose time span overlaps
+/// with it.
+///
+/// The index is kept up to date incrementally: only the participants whose
+/// itineraries have changed need to be refreshed on each iteration.
+///
+/// Unresponsive participants are kept in separate grids. Two unresponsive
+/// participants never get a conflict raised between them, so the routes of an
+/// unresponsive participant only need to be compared against the responsive
+/// grid, without ever looking at the other unresponsive routes.
+///
+/// The const member functions do not modify the index, so they may be called
+/// from several threads at once, as long as no thread is updating the index.
+class ConflictIndex
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+  using ParticipantDescription = rmf_traffic::schedule::ParticipantDescription;
+  using ConstRoutePtr = rmf_traffic::ConstRoutePtr;
+
+  struct Candidate
+  {
+    ParticipantId participant;
+    const ParticipantDescription* description;
+    ConstRoutePtr route;
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] cell_size
+  ///   The side length of each grid cell, in meters.
+  ConflictIndex(double cell_size = 5.0);
+
+  /// Replace all the indexed routes of a participant with a new itinerary.
+  void update(
+    ParticipantId participant,
+    const ParticipantDescription& description,
+    const rmf_traffic::schedule::Itinerary& itinerary);
+
+  /// Remove a participant from the index entirely.
+  void erase(ParticipantId participant);
+
+  /// Remove every participant that is not in the given set.
+  void retain(const std::unordered_set<ParticipantId>& participants);
+
+  /// Get the description that was used when the participant was last indexed.
+  const ParticipantDescription* description(ParticipantId participant) const;
+
+  /// Find all the routes of other participants that might conflict with the
+  /// given route. The routes of unresponsive participants are left out if
+  /// include_unresponsive is false.
+  std::vector<Candidate> candidates(
+    ParticipantId participant,
+    const rmf_traffic::Route& route,
+    const rmf_traffic::Profile& profile,
+    bool include_unresponsive = true) const;
+
+  /// Get the number of participants that are currently indexed.
+  std::size_t size() const;
+
+private:
+
+  struct CellKey
+  {
+    int64_t x;
+    int64_t y;
+
+    bool operator==(const CellKey& other) const
+    {
+      return x == other.x && y == other.y;
+    }
+  };
+
+  struct CellHash
+  {
+    std::size_t operator()(const CellKey& key) const
+    {
+      return std::hash<int64_t>()(key.x) ^ (std::hash<int64_t>()(key.y) << 1);
+    }
+  };
+
+  struct Entry
+  {
+    ParticipantId participant;
+    const ParticipantDescription* description;
+    ConstRoutePtr route;
+    RouteBox box;
+  };
+
+  using Cell = std::vector<const Entry*>;
+  using Grid = std::unordered_map<CellKey, Cell, CellHash>;
+
+  struct MapGrids
+  {
+    Grid responsive;
+    Grid unresponsive;
+
+    Grid& get(bool is_unresponsive)
+    {
+      return is_unresponsive ? unresponsive : responsive;
+    }
+  };
+
+  struct ParticipantEntries
+  {
+    ParticipantDescription description;
+    std::vector<std::unique_ptr<Entry>> entries;
+  };
+
+  template<typename F>
+  void _for_each_cell(const RouteBox& box, F&& f) const;
+
+  void _find_candidates(
+    const Grid& grid,
+    ParticipantId participant,
+    const RouteBox& box,
+    std::vector<Candidate>& output) const;
+
+  double _cell_size;
+  std::unordered_map<std::string, MapGrids> _maps;
+  std::unordered_map<ParticipantId, ParticipantEntries> _participants;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_CONFLICTINDEX_HPP
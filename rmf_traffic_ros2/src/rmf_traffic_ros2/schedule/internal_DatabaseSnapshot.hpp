@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_DATABASESNAPSHOT_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_DATABASESNAPSHOT_HPP
+
+#include <rmf_traffic/schedule/Change.hpp>
+#include <rmf_traffic/schedule/Database.hpp>
+
+#include <rmf_traffic_msgs/msg/itinerary_clear.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_delay.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_erase.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_extend.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_set.hpp>
+
+#include <optional>
+#include <string>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+using Database = rmf_traffic::schedule::Database;
+using Version = rmf_traffic::schedule::Version;
+
+//==============================================================================
+/// Serialize every participant and itinerary of a database, along with its
+/// version. This only touches memory, so it can be done while holding the
+/// database mutex, and the result can be saved after the mutex is released.
+std::string serialize_snapshot(const Database& database);
+
+//==============================================================================
+/// Atomically replace the snapshot file with a serialized snapshot.
+///
+/// \throws std::runtime_error if the snapshot could not be written.
+void save_snapshot(const std::string& file_path, const std::string& snapshot);
+
+//==============================================================================
+/// Restore a database from a snapshot file. The restored database will have
+/// the same version as the database that the snapshot was taken from.
+///
+/// \returns std::nullopt if the file does not exist.
+///
+/// \throws std::runtime_error if the file is not a valid snapshot.
+std::optional<Database> load_snapshot(const std::string& file_path);
+
+//==============================================================================
+/// A log of every change that was made to the database since the last
+/// snapshot was taken. Each record is tagged with the database version that
+/// it produced, so replaying the log on top of a snapshot reproduces the exact
+/// same versions, and records that are already part of the snapshot get
+/// skipped.
+class TailLog
+{
+public:
+
+  using ItinerarySet = rmf_traffic_msgs::msg::ItinerarySet;
+  using ItineraryExtend = rmf_traffic_msgs::msg::ItineraryExtend;
+  using ItineraryDelay = rmf_traffic_msgs::msg::ItineraryDelay;
+  using ItineraryErase = rmf_traffic_msgs::msg::ItineraryErase;
+  using ItineraryClear = rmf_traffic_msgs::msg::ItineraryClear;
+  using ParticipantDescription = rmf_traffic::schedule::ParticipantDescription;
+
+  /// Open the log at the given location for appending.
+  ///
+  /// \throws std::runtime_error if the file cannot be opened.
+  TailLog(std::string file_path);
+
+  /// Record a participant being registered or having its description updated
+  void record(const ParticipantDescription& description, Version version);
+
+  void record(const ItinerarySet& set, Version version);
+  void record(const ItineraryExtend& extend, Version version);
+  void record(const ItineraryDelay& delay, Version version);
+  void record(const ItineraryErase& erase, Version version);
+  void record(const ItineraryClear& clear, Version version);
+  void record(const rmf_traffic::schedule::Change::Cull& cull, Version version);
+
+  /// Move the current records aside and start an empty log. This should be
+  /// called while holding the database mutex, right when a snapshot is
+  /// serialized. Once the snapshot is saved, call discard_rotated().
+  void rotate();
+
+  /// Delete the records that were moved aside by rotate().
+  void discard_rotated();
+
+  /// Apply the records of a log to a database that was restored from a
+  /// snapshot. Replay stops early if a record does not produce the version
+  /// that it was tagged with, since that means the log does not belong to the
+  /// database's history.
+  ///
+  /// \returns the number of records that were applied.
+  ///
+  /// \throws std::runtime_error if a record before the end of the log is
+  /// malformed. A malformed final record is assumed to be the result of an
+  /// interrupted write and is ignored.
+  static std::size_t replay(const std::string& file_path, Database& database);
+
+  ~TailLog();
+
+private:
+  void _open();
+  void _append(uint8_t type, Version version, const std::string& payload);
+
+  std::string _file_path;
+  int _fd = -1;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_DATABASESNAPSHOT_HPP
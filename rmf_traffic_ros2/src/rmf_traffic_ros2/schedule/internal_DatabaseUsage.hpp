@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_DATABASEUSAGE_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_DATABASEUSAGE_HPP
+
+#include <rmf_traffic/schedule/Database.hpp>
+
+#include <map>
+#include <string>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// An estimate of the memory that the itineraries of a database occupy. This
+/// only accounts for the routes that are currently in the schedule, not for
+/// the history of changes that the database keeps alongside them.
+struct DatabaseUsage
+{
+  struct Entry
+  {
+    std::size_t routes = 0;
+    std::size_t waypoints = 0;
+    std::size_t bytes = 0;
+
+    void add(const rmf_traffic::Route& route);
+  };
+
+  Entry total;
+  std::map<std::string, Entry> maps;
+
+  // Participants are identified by "<owner>/<name>"
+  std::map<std::string, Entry> participants;
+};
+
+//==============================================================================
+DatabaseUsage measure_usage(const rmf_traffic::schedule::Database& database);
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_DATABASEUSAGE_HPP
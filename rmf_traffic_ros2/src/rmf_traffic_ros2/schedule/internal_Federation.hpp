@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_FEDERATION_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_FEDERATION_HPP
+
+#include <rmf_traffic/Route.hpp>
+#include <rmf_traffic/schedule/Mirror.hpp>
+#include <rmf_traffic/schedule/ParticipantDescription.hpp>
+
+#include <rmf_traffic_msgs/msg/mirror_update.hpp>
+#include <rmf_traffic_msgs/msg/participants.hpp>
+#include <rmf_traffic_msgs/srv/register_query.hpp>
+#include <rmf_traffic_msgs/srv/request_changes.hpp>
+
+#include <rclcpp/node.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Participants that a schedule node imports from its neighbours are owned by
+/// this prefix, followed by the namespace of the neighbour. Participants with
+/// this prefix are never imported again, so routes do not bounce back and
+/// forth between neighbours.
+const std::string FederationOwnerPrefix = "federation:";
+
+//==============================================================================
+/// Mirrors the boundary maps of a neighbouring schedule node, i.e. a schedule
+/// node that runs in another namespace and owns other maps. Whenever the
+/// routes of a neighbouring participant on the boundary maps change, the
+/// handler is told about it so that the participant can be imported.
+///
+/// The interfaces of the neighbour are reached through absolute names inside
+/// of its namespace, so the link runs on the node that owns it.
+class FederationLink
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+  using ParticipantDescription = rmf_traffic::schedule::ParticipantDescription;
+
+  struct Change
+  {
+    /// The ID of the participant in the neighbouring schedule
+    ParticipantId participant;
+
+    /// The routes of the participant on the boundary maps
+    std::vector<rmf_traffic::Route> routes;
+
+    /// std::nullopt if the participant has left the neighbouring schedule
+    std::optional<ParticipantDescription> description;
+  };
+
+  using Handler = std::function<void(const std::vector<Change>&)>;
+
+  /// Constructor
+  ///
+  /// \param[in] node
+  ///   The node that the link communicates through. It must outlive the link.
+  ///
+  /// \param[in] neighbour
+  ///   The namespace of the neighbouring schedule node
+  ///
+  /// \param[in] boundary_maps
+  ///   The maps that this schedule node shares with the neighbour
+  ///
+  /// \param[in] handler
+  ///   Called with the participants whose boundary routes have changed
+  FederationLink(
+    rclcpp::Node& node,
+    std::string neighbour,
+    std::vector<std::string> boundary_maps,
+    Handler handler);
+
+  /// The namespace of the neighbour
+  const std::string& neighbour() const;
+
+  /// Get the owner that imported participants of this neighbour are given
+  std::string proxy_owner(const std::string& owner) const;
+
+  /// True if the participant of a neighbour was itself imported from another
+  /// schedule node
+  static bool is_proxy(const ParticipantDescription& description);
+
+private:
+  using MirrorUpdate = rmf_traffic_msgs::msg::MirrorUpdate;
+  using Participants = rmf_traffic_msgs::msg::Participants;
+  using RegisterQuery = rmf_traffic_msgs::srv::RegisterQuery;
+  using RequestChanges = rmf_traffic_msgs::srv::RequestChanges;
+
+  std::string _name(const std::string& base) const;
+  void _check();
+  void _register_query();
+  void _request_changes(bool full_update);
+  void _handle_update(const MirrorUpdate& msg);
+  void _handle_participants(const Participants& msg);
+  Change _describe(ParticipantId participant) const;
+
+  rclcpp::Node& _node;
+  std::string _neighbour;
+  std::vector<std::string> _boundary_maps;
+  Handler _handler;
+
+  rmf_traffic::schedule::Mirror _mirror;
+  std::unordered_set<ParticipantId> _known;
+  std::optional<uint64_t> _query_id;
+  std::optional<uint64_t> _node_version;
+  bool _registration_pending = false;
+  std::chrono::steady_clock::time_point _last_update;
+
+  rclcpp::Client<RegisterQuery>::SharedPtr _register_query_client;
+  rclcpp::Client<RequestChanges>::SharedPtr _request_changes_client;
+  rclcpp::Subscription<Participants>::SharedPtr _participants_sub;
+  rclcpp::Subscription<MirrorUpdate>::SharedPtr _update_sub;
+  rclcpp::TimerBase::SharedPtr _timer;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_FEDERATION_HPP
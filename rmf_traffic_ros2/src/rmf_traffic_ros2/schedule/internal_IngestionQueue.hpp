@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_INGESTIONQUEUE_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_INGESTIONQUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// A multi-producer single-consumer queue of itinerary changes. Any number of
+/// threads can push changes without taking a lock, while one consumer thread
+/// takes everything that has been pushed so far as a single batch.
+///
+/// The consumer reports each batch as finished once it has been applied, which
+/// lets other threads flush() the queue to make sure that every change they
+/// have pushed is visible before they read the database.
+class IngestionQueue
+{
+public:
+
+  using Change = std::function<void()>;
+
+  IngestionQueue() = default;
+
+  IngestionQueue(const IngestionQueue&) = delete;
+  IngestionQueue& operator=(const IngestionQueue&) = delete;
+
+  /// Add a change to the end of the queue. This can be called from any thread.
+  void push(Change change);
+
+  /// Take every change that has been pushed so far, in the order that they
+  /// were pushed. If nothing has been pushed, wait up to the timeout for a
+  /// change to arrive. Only one thread may call this.
+  std::vector<Change> take(std::chrono::milliseconds timeout);
+
+  /// Tell the queue that a number of changes have been applied
+  void finish(std::size_t count);
+
+  /// Block until every change that was pushed before this call has been
+  /// finished, or until stop() is called
+  void flush();
+
+  /// Wake up the consumer and anyone waiting in flush(). Changes can still be
+  /// pushed afterwards, but nobody will wait for them.
+  void stop();
+
+  /// Delete every change that was never taken
+  ~IngestionQueue();
+
+private:
+
+  struct Node
+  {
+    Change change;
+    Node* next;
+  };
+
+  // Changes are pushed onto a lock-free stack, and the consumer takes the
+  // whole stack at once and reverses it to recover the order of arrival.
+  std::atomic<Node*> _head = nullptr;
+  std::atomic_uint64_t _pushed = 0;
+  std::atomic_uint64_t _finished = 0;
+  std::atomic_bool _consumer_waiting = false;
+  std::atomic_bool _stopped = false;
+
+  // These are only used to sleep. Producers only touch them when the consumer
+  // is waiting for work.
+  std::mutex _mutex;
+  std::condition_variable _changes_cv;
+  std::condition_variable _finished_cv;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_INGESTIONQUEUE_HPP
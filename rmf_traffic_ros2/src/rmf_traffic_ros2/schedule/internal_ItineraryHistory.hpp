@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_ITINERARYHISTORY_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_ITINERARYHISTORY_HPP
+
+#include <rmf_traffic/schedule/Writer.hpp>
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Remembers what the itinerary of each participant was after each of the most
+/// recent changes that a Writer sent for it. When the schedule is missing a
+/// long range of changes, the itinerary as of the last missing version can be
+/// sent as one itinerary set, which makes every change before it irrelevant.
+///
+/// Delays are only applied to the routes when an itinerary is requested, so
+/// remembering a change costs one copy of the route pointers.
+///
+/// This class is thread-safe.
+class ItineraryHistory
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+  using ItineraryVersion = rmf_traffic::schedule::ItineraryVersion;
+  using Input = rmf_traffic::schedule::Writer::Input;
+
+  /// Constructor
+  ///
+  /// \param[in] depth
+  ///   How many of the most recent versions to remember for each participant
+  ItineraryHistory(std::size_t depth = 64);
+
+  /// Remember the changes that a writer sends. These mirror the functions of
+  /// rmf_traffic::schedule::Writer.
+  void set(
+    ParticipantId participant,
+    const Input& itinerary,
+    ItineraryVersion version);
+
+  void extend(
+    ParticipantId participant,
+    const Input& routes,
+    ItineraryVersion version);
+
+  void delay(
+    ParticipantId participant,
+    rmf_traffic::Duration duration,
+    ItineraryVersion version);
+
+  void erase(
+    ParticipantId participant,
+    const std::vector<rmf_traffic::RouteId>& routes,
+    ItineraryVersion version);
+
+  void clear(ParticipantId participant, ItineraryVersion version);
+
+  /// Forget everything about this participant
+  void forget(ParticipantId participant);
+
+  /// The latest version that was sent for the participant
+  std::optional<ItineraryVersion> latest_version(
+    ParticipantId participant) const;
+
+  /// The itinerary of the participant right after the change with this
+  /// version, or nullopt if that version is not remembered. A version that
+  /// was not sent with a full itinerary, e.g. because the participant was
+  /// first seen through an extend, is not remembered either.
+  std::optional<Input> itinerary(
+    ParticipantId participant, ItineraryVersion version) const;
+
+private:
+
+  struct Item
+  {
+    rmf_traffic::RouteId id;
+    rmf_traffic::ConstRoutePtr route;
+    rmf_traffic::Duration delay;
+  };
+
+  struct Snapshot
+  {
+    ItineraryVersion version;
+    std::vector<Item> items;
+  };
+
+  // Must be called while _mutex is locked. Returns a new snapshot that starts
+  // as a copy of the latest one, or nullptr if there is no full itinerary to
+  // copy.
+  Snapshot* _next(ParticipantId participant, ItineraryVersion version);
+
+  std::size_t _depth;
+  mutable std::mutex _mutex;
+  std::unordered_map<ParticipantId, std::deque<Snapshot>> _snapshots;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_ITINERARYHISTORY_HPP
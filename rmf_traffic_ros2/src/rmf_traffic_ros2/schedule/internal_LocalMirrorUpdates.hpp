@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_LOCALMIRRORUPDATES_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_LOCALMIRRORUPDATES_HPP
+
+#include <rmf_traffic/schedule/Patch.hpp>
+
+#include <rclcpp/node.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Carries mirror updates from a schedule node to the mirrors that live in the
+/// same process, e.g. because they were loaded into the same component
+/// container. The mirrors receive the patch that the schedule node computed,
+/// so it never gets converted into a message or serialized for them.
+///
+/// Several schedule nodes may live in one process, e.g. in different
+/// namespaces of one component container. Each of them provides its updates on
+/// its own channel, which is the fully qualified base name of its update
+/// topics, so a mirror only receives the patches of the schedule node whose
+/// update topics it would otherwise subscribe to.
+///
+/// Listeners are called from the thread of the schedule node, so they should
+/// hand the update over to their own thread.
+///
+/// All of the functions of this class are thread-safe.
+class LocalMirrorUpdates
+{
+public:
+
+  struct Update
+  {
+    uint64_t node_version;
+    uint64_t database_version;
+    std::shared_ptr<const rmf_traffic::schedule::Patch> patch;
+    bool is_remedial_update;
+  };
+
+  /// Receives the updates of a query. A nullopt means that the schedule node
+  /// has gone away, so the listener should go back to its update topic.
+  using Listener = std::function<void(const std::optional<Update>&)>;
+
+  /// Get the instance for this process
+  static LocalMirrorUpdates& get();
+
+  /// Get the channel that the update topics of a node resolve to. A schedule
+  /// node and a mirror use the same channel exactly when the mirror would
+  /// subscribe to the update topics of that schedule node.
+  static std::string channel(const rclcpp::Node& node);
+
+  /// Offer the updates of a schedule node to the mirrors of this process. The
+  /// offer lasts until the returned handle is destroyed, or until another
+  /// schedule node of this process makes an offer on the same channel.
+  std::shared_ptr<void> provide(
+    const std::string& channel,
+    uint64_t node_version);
+
+  /// Get the version of the schedule node that provides updates on a channel,
+  /// if there is one
+  std::optional<uint64_t> provider(const std::string& channel) const;
+
+  /// Listen to the updates of a query on a channel. The listener stays
+  /// registered until the returned handle is destroyed. A nullptr is returned
+  /// if no schedule node of this process provides updates on the channel.
+  std::shared_ptr<void> listen(
+    const std::string& channel,
+    uint64_t query_id,
+    Listener listener);
+
+  /// Give an update to the listeners of a query on a channel. This returns how
+  /// many listeners received it.
+  std::size_t deliver(
+    const std::string& channel,
+    uint64_t query_id,
+    const Update& update) const;
+
+private:
+
+  LocalMirrorUpdates() = default;
+
+  // Calls its release function when the last copy of it is destroyed
+  struct Handle
+  {
+    Handle(std::function<void()> release_)
+    : release(std::move(release_))
+    {
+      // Do nothing
+    }
+
+    ~Handle()
+    {
+      release();
+    }
+
+    std::function<void()> release;
+  };
+
+  void _withdraw(const std::string& channel, uint64_t token);
+  void _forget(const std::string& channel, uint64_t query_id, uint64_t token);
+
+  using Listeners = std::unordered_map<uint64_t, Listener>;
+  struct Channel
+  {
+    std::optional<uint64_t> provider_token;
+    std::optional<uint64_t> provider_version;
+    std::unordered_map<uint64_t, Listeners> listeners;
+  };
+
+  mutable std::mutex _mutex;
+  uint64_t _next_token = 0;
+  std::unordered_map<std::string, Channel> _channels;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_LOCALMIRRORUPDATES_HPP
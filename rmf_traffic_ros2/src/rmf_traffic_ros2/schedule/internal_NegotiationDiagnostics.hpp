@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_NEGOTIATIONDIAGNOSTICS_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_NEGOTIATIONDIAGNOSTICS_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <rclcpp/node.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Collects how long each phase of the negotiations takes, and periodically
+/// publishes a histogram of every phase as a DiagnosticArray on the
+/// NegotiationDiagnosticsTopicName topic, with one status per phase. Recording
+/// is thread-safe.
+class NegotiationDiagnostics
+{
+public:
+
+  using Duration = rmf_traffic::Duration;
+
+  struct Histogram
+  {
+    /// The upper bound of each bucket, in milliseconds. There is one more
+    /// bucket after these for everything that is larger.
+    static const std::vector<double>& bounds();
+
+    std::vector<std::size_t> counts = std::vector<std::size_t>(
+      bounds().size() + 1, 0);
+    std::size_t count = 0;
+    Duration total = Duration(0);
+    Duration max = Duration(0);
+
+    void record(Duration duration);
+  };
+
+  NegotiationDiagnostics(
+    rclcpp::Node& node,
+    Duration publish_period = std::chrono::seconds(10));
+
+  /// Record one measurement of a phase
+  void record(const std::string& phase, Duration duration);
+
+  /// Record the time that has passed since start
+  void record_since(
+    const std::string& phase,
+    std::chrono::steady_clock::time_point start);
+
+  /// Get the histograms that have been collected so far
+  std::map<std::string, Histogram> histograms() const;
+
+  /// Publish the histograms if anything was recorded since they were last
+  /// published
+  void publish();
+
+private:
+  std::string _source;
+  rclcpp::Clock::SharedPtr _clock;
+  mutable std::mutex _mutex;
+  std::map<std::string, Histogram> _histograms;
+  bool _changed = false;
+
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr
+    _publisher;
+  rclcpp::TimerBase::SharedPtr _timer;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_NEGOTIATIONDIAGNOSTICS_HPP
@@ -19,11 +19,21 @@
 #define SRC__RMF_TRAFFIC_SCHEDULE__SCHEDULENODE_HPP
 
 #include "NegotiationRoom.hpp"
+#include "internal_CompactPatch.hpp"
+#include "internal_DatabaseSnapshot.hpp"
+#include "internal_DatabaseUsage.hpp"
+#include "internal_Federation.hpp"
+#include "internal_IngestionQueue.hpp"
+#include "internal_NegotiationDiagnostics.hpp"
+#include "internal_PerformanceCounters.hpp"
+#include "internal_RegionIndex.hpp"
 
 #include <rmf_traffic/schedule/Database.hpp>
 #include <rmf_traffic/schedule/Negotiation.hpp>
 
 #include <rclcpp/node.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
 
 #include <rmf_traffic_msgs/msg/mirror_update.hpp>
 #include <rmf_traffic_msgs/msg/participant.hpp>
@@ -59,10 +69,14 @@
 #include <rmf_traffic_ros2/schedule/ParticipantRegistry.hpp>
 
 #include <rmf_utils/Modular.hpp>
+#include <std_msgs/msg/u_int8_multi_array.hpp>
 
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace rmf_traffic_ros2 {
@@ -124,9 +138,12 @@ public:
     const RegisterQuery::Request::SharedPtr& request,
     const RegisterQuery::Response::SharedPtr& response);
 
+  // The last_sent_version is the version that the mirrors of this query are
+  // assumed to already have. Use std::nullopt to begin with a full update.
   void register_query(
     uint64_t query_id,
-    const rmf_traffic::schedule::Query& query);
+    const rmf_traffic::schedule::Query& query,
+    VersionOpt last_sent_version = std::nullopt);
 
   RegisterQueryService::SharedPtr register_query_service;
 
@@ -168,21 +185,63 @@ public:
   using MirrorUpdate = rmf_traffic_msgs::msg::MirrorUpdate;
   using MirrorUpdateTopicPublisher = rclcpp::Publisher<MirrorUpdate>::SharedPtr;
 
+  // Compact updates carry a header and a CompactPatchEncoder stream as bytes
+  using CompactUpdate = std_msgs::msg::UInt8MultiArray;
+  using CompactUpdatePublisher = rclcpp::Publisher<CompactUpdate>::SharedPtr;
+
   void add_query_topic(uint64_t query_id);
   void remove_query_topic(uint64_t query_id);
 
   void make_mirror_update_topics(const QueryMap& queries);
 
+  // The database version that this node inherited when it took over from a
+  // failed schedule node. Mirrors are only trusted to hold exactly this
+  // version, so any remediation request from before it gets a full update.
+  VersionOpt inherited_version;
+
   using SingleParticipantInfo = rmf_traffic_msgs::msg::Participant;
   using ParticipantsInfo = rmf_traffic_msgs::msg::Participants;
   rclcpp::Publisher<ParticipantsInfo>::SharedPtr participants_info_pub;
+
+  // Request a broadcast of the participants. Registrations tend to arrive in
+  // bursts, e.g. while a whole site is starting up, so the broadcasts are
+  // batched into one per participants_broadcast_interval. The caller must be
+  // holding database_mutex.
   virtual void broadcast_participants();
 
+  std::chrono::milliseconds participants_broadcast_interval =
+    std::chrono::milliseconds(100);
+  rclcpp::TimerBase::SharedPtr participants_broadcast_timer;
+  bool participants_broadcast_pending = false;
+
+  // Publish the participants if a broadcast is pending. The caller must be
+  // holding database_mutex.
+  void publish_participants();
+
+  // The converted description of each participant from the last broadcast.
+  // They are reused for as long as the descriptions stay the same.
+  struct ParticipantInfoCacheEntry
+  {
+    rmf_traffic::schedule::ParticipantDescription description;
+    SingleParticipantInfo msg;
+  };
+  std::unordered_map<
+    rmf_traffic::schedule::ParticipantId, ParticipantInfoCacheEntry>
+  participant_info_cache;
+
   using ScheduleQuery = rmf_traffic_msgs::msg::ScheduleQuery;
   using ScheduleQueries = rmf_traffic_msgs::msg::ScheduleQueries;
   rclcpp::Publisher<ScheduleQueries>::SharedPtr queries_info_pub;
   virtual void broadcast_queries();
 
+  // Ask for the queries to be broadcast. A storm of registrations, e.g. from
+  // every mirror after a restart, gets batched into one broadcast per
+  // queries_broadcast_interval.
+  void request_queries_broadcast();
+  std::chrono::milliseconds queries_broadcast_interval =
+    std::chrono::milliseconds(100);
+  rclcpp::TimerBase::SharedPtr queries_broadcast_timer;
+
   using RequestChanges = rmf_traffic_msgs::srv::RequestChanges;
   using RequestChangesSrv = rclcpp::Service<RequestChanges>;
   void request_changes(
@@ -213,22 +272,150 @@ public:
   void itinerary_clear(const ItineraryClear& clear);
   rclcpp::Subscription<ItineraryClear>::SharedPtr itinerary_clear_sub;
 
+  // These apply an itinerary change to the database. The caller must already
+  // be holding both database_mutex and active_conflicts_mutex.
+  void apply_itinerary_set(const ItinerarySet& set);
+  void apply_itinerary_extend(const ItineraryExtend& extend);
+  void apply_itinerary_delay(const ItineraryDelay& delay);
+  void apply_itinerary_erase(const ItineraryErase& erase);
+  void apply_itinerary_clear(const ItineraryClear& clear);
+
+  // Stop waiting for a participant once its itinerary has reached the version
+  // that it promised in its acknowledgment, and remember the itinerary that it
+  // ended up with. The caller must be holding both mutexes.
+  void check_conflict_wait(
+    rmf_traffic::schedule::ParticipantId participant,
+    rmf_traffic::schedule::ItineraryVersion version);
+  void record_adopted_itinerary(rmf_traffic::schedule::ParticipantId p);
+
+  // Itinerary messages are pushed onto the ingestion queue as they arrive, and
+  // a dedicated thread drains the queue in batches. Each batch is applied
+  // under a single acquisition of the locks, so itinerary changes only ever
+  // have one writer, no matter how many threads the subscriptions run on.
+  IngestionQueue ingestion_queue;
+  std::thread ingestion_thread;
+  std::atomic_bool ingestion_quit = false;
+  void queue_itinerary_change(std::function<void()> change);
+  void start_ingestion_thread();
+  void apply_itinerary_batch(const std::vector<IngestionQueue::Change>& batch);
+
   virtual void setup_itinerary_topics();
 
   using InconsistencyMsg = rmf_traffic_msgs::msg::ScheduleInconsistency;
   rclcpp::Publisher<InconsistencyMsg>::SharedPtr inconsistency_pub;
+
+  // Inconsistency reports are only published when the inconsistency of a
+  // participant changes, or when the same report has gone unanswered for
+  // inconsistency_retry_interval. Otherwise a participant whose messages keep
+  // getting lost would be told about the same gap after every change that it
+  // sends, and each report triggers another round of resends.
+  struct ReportedInconsistency
+  {
+    InconsistencyMsg msg;
+    std::chrono::steady_clock::time_point time;
+  };
+  std::unordered_map<rmf_traffic::schedule::ParticipantId,
+    ReportedInconsistency> reported_inconsistencies;
+  std::chrono::milliseconds inconsistency_retry_interval = 1000ms;
+
+  // Participants that need their inconsistencies checked. While a batch of
+  // itinerary changes is being applied, these are collected so that each
+  // participant gets at most one report per batch.
+  std::unordered_set<rmf_traffic::schedule::ParticipantId>
+  pending_inconsistencies;
+  bool defer_inconsistencies = false;
+
+  // These must be called while database_mutex is locked
   void publish_inconsistencies(rmf_traffic::schedule::ParticipantId id);
+  void flush_inconsistencies();
 
   virtual void setup_incosistency_pub();
 
+  // Mirrors are updated when the database changes instead of on a fixed
+  // period. Bursts of changes are coalesced by waiting for
+  // mirror_update_min_interval of quiet, but no change will wait longer than
+  // mirror_update_max_latency before being published.
+  std::chrono::milliseconds mirror_update_min_interval = 1ms;
+  std::chrono::milliseconds mirror_update_max_latency = 10ms;
+  std::optional<std::chrono::steady_clock::time_point> first_pending_change;
   rclcpp::TimerBase::SharedPtr mirror_update_timer;
+  void schedule_mirror_update();
   void update_mirrors();
-  void update_query(
+
+  // Topics that have gone quiet for a heartbeat period get an empty update
+  // which carries the latest database version, so their mirrors notice a
+  // dropped patch without waiting for the next change or polling for one.
+  rclcpp::TimerBase::SharedPtr version_summary_timer;
+  void publish_version_summaries();
+
+  // A patch that has already been computed and converted during the current
+  // round of mirror updates, so it can be reused by any other topic that needs
+  // the same changes.
+  struct PatchCacheEntry
+  {
+    const rmf_traffic::schedule::Query* query;
+    VersionOpt from;
+    bool is_remedial;
+    std::optional<rmf_traffic::Time> cutoff;
+
+    // The serialized MirrorUpdate message. This is only made once a mirror in
+    // another process needs the patch.
+    std::optional<rclcpp::SerializedMessage> msg;
+
+    // The patch that was published. This will be a nullptr if there was
+    // nothing to publish. Mirrors in this process share it directly.
+    std::shared_ptr<const rmf_traffic::schedule::Patch> patch;
+  };
+
+  // The entries are indexed by a hash of the query hash, starting version,
+  // remediation, and cutoff, so each lookup only compares the few entries that
+  // share its hash instead of every patch made during the update.
+  using PatchCache = std::unordered_multimap<std::size_t, PatchCacheEntry>;
+
+  // Every patch gets converted into this message before it is serialized, so
+  // that the memory of its routes and waypoints is reused between updates
+  rmf_traffic_msgs::msg::MirrorUpdate mirror_update_msg;
+
+  // Returns true if a message was published
+  bool update_query(
+    uint64_t query_id,
     const MirrorUpdateTopicPublisher& publisher,
     const rmf_traffic::schedule::Query& query,
     VersionOpt last_sent_version,
     bool is_remedial);
 
+  // Returns the cache entry of the message that was published, or a nullptr if
+  // nothing was published. Routes that finish before the cutoff are left out
+  // of the patch, and the mirrors are told to cull them.
+  const PatchCacheEntry* update_query(
+    uint64_t query_id,
+    const MirrorUpdateTopicPublisher& publisher,
+    const rmf_traffic::schedule::Query& query,
+    std::size_t query_hash,
+    VersionOpt last_sent_version,
+    bool is_remedial,
+    PatchCache& cache,
+    std::optional<rmf_traffic::Time> cutoff = std::nullopt);
+
+  // Send the patch of a cache entry to the mirrors of a query. Mirrors in this
+  // process are handed the patch itself, and the message is only converted
+  // and serialized if a mirror in another process subscribes to the topic.
+  void publish_patch(
+    uint64_t query_id,
+    const MirrorUpdateTopicPublisher& publisher,
+    PatchCacheEntry& entry);
+
+  // Lets the mirrors in the same process receive patches without going through
+  // the update topics. This is only set while the local_mirror_updates
+  // parameter is true. The channel is the fully qualified base name of the
+  // update topics of this node.
+  std::shared_ptr<void> local_mirror_provider;
+  std::string local_mirror_channel;
+
+  // Counters for the hot paths of this node. These are only collected when
+  // the performance_sample_period parameter is positive.
+  std::unique_ptr<PerformanceCounters> performance_counters;
+
   // TODO(MXG): Consider using libguarded instead of a database_mutex
   std::mutex database_mutex;
   std::shared_ptr<rmf_traffic::schedule::Database> database;
@@ -240,12 +427,115 @@ public:
     VersionOpt last_sent_version;
     std::chrono::steady_clock::time_point last_registration_time;
     std::unordered_set<VersionOpt> remediation_requests;
+
+    // Time between a database change and its publication on this topic
+    struct Latency
+    {
+      std::size_t count = 0;
+      rmf_traffic::Duration last = rmf_traffic::Duration(0);
+      rmf_traffic::Duration max = rmf_traffic::Duration(0);
+      rmf_traffic::Duration total = rmf_traffic::Duration(0);
+
+      void record(rmf_traffic::Duration latency)
+      {
+        ++count;
+        last = latency;
+        max = std::max(max, latency);
+        total += latency;
+      }
+    };
+    Latency publish_latency = {};
+
+    // The query as it gets broadcast, with its ids and maps sorted so that
+    // equivalent queries produce the same hash
+    ScheduleQuery msg = {};
+    std::size_t hash = 0;
+
+    // The update preferences that the mirrors of this query have asked for.
+    // Changes are held back until min_update_interval has passed since the
+    // last update, and background queries are updated after every other
+    // query.
+    rmf_traffic::Duration min_update_interval = rmf_traffic::Duration(0);
+    bool background = false;
+
+    // Routes that finished longer ago than this are evicted from the mirrors
+    // of this query. std::nullopt keeps every route.
+    std::optional<rmf_traffic::Duration> history = std::nullopt;
+    std::optional<std::chrono::steady_clock::time_point> last_update_time = {};
+
+    // When anything was last published on this topic, including remedial
+    // updates and version summaries
+    std::optional<std::chrono::steady_clock::time_point> last_publish_time = {};
+
+    // When the oldest change that is being held back was made
+    std::optional<std::chrono::steady_clock::time_point> held_since = {};
+
+    // Only made once a mirror of this query asks for compact updates. The
+    // encoder is reset for every remedial update, so mirrors that join the
+    // compact topic late can pick up the stream from there.
+    CompactUpdatePublisher compact_publisher = nullptr;
+    std::optional<CompactPatchEncoder> compact_encoder = std::nullopt;
   };
   using QueryInfoMap = std::unordered_map<uint64_t, QueryInfo>;
 
   std::size_t last_query_id = 0;
   QueryInfoMap registered_queries;
 
+  // Finds the IDs of the registered queries whose canonical messages have a
+  // given hash, so new registrations do not need to compare against every
+  // registered query.
+  std::unordered_multimap<std::size_t, uint64_t> query_index;
+
+  // Encode a patch for the mirrors that subscribe to the compact update topic
+  // of a query, if any of them do. Returns true if it was published.
+  bool publish_compact_patch(
+    QueryInfo& query_info,
+    const rmf_traffic::schedule::Patch& patch,
+    bool is_remedial);
+
+  void erase_query_index(const QueryInfoMap::const_iterator& it);
+
+  // Mirrors set the update preferences of their query through parameters of
+  // this node, because the RegisterQuery service has no room for them.
+  OnSetParametersCallbackHandle::SharedPtr query_preferences_handle;
+  void declare_query_preferences(uint64_t query_id);
+  void undeclare_query_preferences(uint64_t query_id);
+  rcl_interfaces::msg::SetParametersResult set_query_preferences(
+    const std::vector<rclcpp::Parameter>& parameters);
+
+  // Runs update_mirrors again once the changes that were held back from a
+  // rate limited query are due
+  rclcpp::TimerBase::SharedPtr throttled_update_timer;
+  std::optional<std::chrono::steady_clock::time_point> throttled_update_due;
+  void schedule_throttled_update(std::chrono::steady_clock::time_point due);
+
+  // Side length of the grid cells used by the conflict detection broad phase
+  double conflict_index_cell_size = 5.0;
+
+  // Finds the participants that might be inside the regions of a query, so
+  // that the database only has to evaluate their changes for it. This is
+  // refreshed lazily, at most once per database version.
+  bool use_region_index = true;
+  RegionIndex region_index;
+
+  // The participants that have been part of a patch for a narrowed query.
+  // They stay included in every narrowed query so that mirrors still hear
+  // about them leaving the regions. This is shared by all the queries because
+  // equal queries share their patches.
+  std::unordered_set<rmf_traffic::schedule::ParticipantId> region_participants;
+
+  // Returns a copy of a query for regions that only includes the participants
+  // which the region index found for it. Returns std::nullopt if the query
+  // cannot be narrowed down.
+  std::optional<rmf_traffic::schedule::Query> narrow_region_query(
+    const rmf_traffic::schedule::Query& query);
+
+  // Number of threads that run the conflict detection narrow phase
+  std::size_t conflict_check_threads = 1;
+
+  // Only check the parts of routes that changed since they were last checked
+  bool conflict_check_changed_parts = true;
+
   // TODO(MXG): Make this a separate node
   std::thread conflict_check_thread;
   std::condition_variable conflict_check_cv;
@@ -284,6 +574,8 @@ public:
   using ConflictConclusionPub = rclcpp::Publisher<ConflictConclusion>;
   ConflictConclusionPub::SharedPtr conflict_conclusion_pub;
 
+  std::shared_ptr<NegotiationDiagnostics> negotiation_diagnostics;
+
   using Version = rmf_traffic::schedule::Version;
   using ItineraryVersion = rmf_traffic::schedule::ItineraryVersion;
   using ParticipantId = rmf_traffic::schedule::ParticipantId;
@@ -303,6 +595,21 @@ public:
       rmf_utils::optional<ItineraryVersion> itinerary_update_version;
     };
 
+    // A resolved negotiation is remembered for a while along with the
+    // itineraries that its participants adopted afterwards. When the same
+    // participants come into conflict again without having changed those
+    // itineraries, a new negotiation would only reach the same agreement, so
+    // the conflict is not announced.
+    struct Agreement
+    {
+      std::chrono::steady_clock::time_point concluded;
+      std::unordered_map<ParticipantId, std::optional<std::size_t>>
+      fingerprints;
+    };
+
+    // How long an agreement is remembered. Zero disables the debouncing.
+    rmf_traffic::Duration cooldown = std::chrono::seconds(10);
+
     ConflictRecord(
       std::shared_ptr<const rmf_traffic::schedule::Snappable> viewer)
     : _viewer(std::move(viewer))
@@ -401,6 +708,80 @@ public:
       _negotiations.erase(negotiation_it);
     }
 
+    // Remember that the participants of this negotiation have agreed on a
+    // resolution. This must be called before conclude().
+    void agree(const Version version)
+    {
+      if (cooldown <= rmf_traffic::Duration(0))
+        return;
+
+      const auto negotiation_it = _negotiations.find(version);
+      if (negotiation_it == _negotiations.end())
+        return;
+
+      auto agreement = std::make_shared<Agreement>();
+      agreement->concluded = std::chrono::steady_clock::now();
+      for (const auto p : negotiation_it->second->negotiation.participants())
+      {
+        agreement->fingerprints[p] = std::nullopt;
+        _agreements[p] = agreement;
+      }
+    }
+
+    // Record the fingerprint of the itinerary that a participant adopted after
+    // an agreement
+    void adopt(const ParticipantId p, const std::size_t fingerprint)
+    {
+      const auto it = _agreements.find(p);
+      if (it == _agreements.end())
+        return;
+
+      it->second->fingerprints[p] = fingerprint;
+    }
+
+    // Returns true if this conflict is between participants that recently
+    // agreed with each other and are all still following the itineraries that
+    // they adopted for that agreement. The fingerprint_of argument gets called
+    // with a participant ID and returns the fingerprint of its current
+    // itinerary, or std::nullopt if it does not have one.
+    template<typename FingerprintOf>
+    bool debounce(
+      const ConflictSet& conflicts,
+      const FingerprintOf& fingerprint_of)
+    {
+      const auto now = std::chrono::steady_clock::now();
+      const Agreement* agreement = nullptr;
+      for (const auto p : conflicts)
+      {
+        const auto it = _agreements.find(p);
+        if (it == _agreements.end())
+          return false;
+
+        if (cooldown < now - it->second->concluded)
+        {
+          _agreements.erase(it);
+          return false;
+        }
+
+        if (agreement && agreement != it->second.get())
+          return false;
+
+        agreement = it->second.get();
+        const auto& adopted = agreement->fingerprints.at(p);
+        if (!adopted)
+          return false;
+
+        if (adopted != fingerprint_of(p))
+        {
+          // This participant has moved on from the agreement
+          _agreements.erase(it);
+          return false;
+        }
+      }
+
+      return agreement != nullptr;
+    }
+
     void refuse(const Version version)
     {
       const auto negotiation_it = _negotiations.find(version);
@@ -417,8 +798,9 @@ public:
     }
 
     // Tell the ConflictRecord what ItineraryVersion will resolve this
-    // negotiation.
-    void acknowledge(
+    // negotiation. Returns true if we are no longer waiting for the
+    // participant.
+    bool acknowledge(
       const Version negotiation_version,
       const ParticipantId p,
       const rmf_utils::optional<ItineraryVersion> update_version)
@@ -433,7 +815,7 @@ public:
                   << "] for negotiation [" << negotiation_version << "]"
                   << std::endl;
         assert(false);
-        return;
+        return false;
       }
 
       const auto expected_negotiation = wait_it->second.negotiation_version;
@@ -447,29 +829,38 @@ public:
                   << "] but received an acknowledgment for negotiation ["
                   << negotiation_version << "] instead." << std::endl;
         assert(false);
-        return;
+        return false;
       }
 
       if (update_version)
+      {
         wait_it->second.itinerary_update_version = *update_version;
-      else
-        _waiting.erase(wait_it);
+        return false;
+      }
+
+      _waiting.erase(wait_it);
+      return true;
     }
 
-    void check(const ParticipantId p, const ItineraryVersion version)
+    // Returns true if this version of the itinerary ended our wait for the
+    // participant
+    bool check(const ParticipantId p, const ItineraryVersion version)
     {
       const auto wait_it = _waiting.find(p);
       if (wait_it == _waiting.end())
-        return;
+        return false;
 
       const auto expected_version = wait_it->second.itinerary_update_version;
       if (!expected_version)
-        return;
+        return false;
 
       if (rmf_utils::modular(*expected_version).less_than_or_equal(version))
       {
         _waiting.erase(wait_it);
+        return true;
       }
+
+      return false;
     }
 
 //  private:
@@ -477,6 +868,7 @@ public:
     std::unordered_map<Version,
       rmf_utils::optional<NegotiationRoom>> _negotiations;
     std::unordered_map<ParticipantId, Wait> _waiting;
+    std::unordered_map<ParticipantId, std::shared_ptr<Agreement>> _agreements;
     std::shared_ptr<const rmf_traffic::schedule::Snappable> _viewer;
     Version _next_negotiation_version = 0;
   };
@@ -485,8 +877,56 @@ public:
   std::mutex active_conflicts_mutex;
   std::shared_ptr<ParticipantRegistry> participant_registry;
 
+  // Periodic snapshots of the database, plus a log of every change made since
+  // the last snapshot, let a restarted node resume at the version it had
+  // reached instead of starting over from an empty schedule.
+  std::string snapshot_file;
+  std::chrono::milliseconds snapshot_period = 10s;
+  std::optional<Version> last_snapshot_version;
+  std::unique_ptr<TailLog> tail_log;
+  rclcpp::TimerBase::SharedPtr snapshot_timer;
+  void restore_snapshot();
+  void take_snapshot();
+
+  // Routes that finished longer than cull_retention ago get culled from the
+  // database every cull_period. If the itineraries still take up more than
+  // cull_memory_budget bytes after that, the retention is cut in half until
+  // they fit. A budget of 0 means there is no limit.
+  std::chrono::milliseconds cull_period = 1min;
+  rmf_traffic::Duration cull_retention = 10min;
+  std::size_t cull_memory_budget = 0;
+  rclcpp::TimerBase::SharedPtr cull_timer;
+  void cull_database();
+
+  // Record a change in the tail log if it modified the database. The caller
+  // must be holding database_mutex.
+  template<typename Change>
+  void log_change(const Change& change, Version previous_version);
+
   virtual void setup_conflict_topics_and_thread();
 
+  // In federation mode, each schedule node runs in the namespace of a
+  // building and owns the maps of that building. The participants of the
+  // neighbouring schedule nodes that have routes on the boundary maps are
+  // imported as unresponsive proxy participants, so conflicts across the
+  // boundary get detected on both sides.
+  void setup_federation();
+  void import_boundary(
+    const FederationLink& link,
+    const std::vector<FederationLink::Change>& changes);
+
+  struct FederationProxy
+  {
+    ParticipantId id;
+    rmf_traffic::schedule::ItineraryVersion itinerary_version;
+  };
+
+  std::vector<std::unique_ptr<FederationLink>> federation_links;
+
+  // The proxy of each imported participant, keyed by the namespace of its
+  // schedule node and its ID there
+  std::unordered_map<std::string, FederationProxy> federation_proxies;
+
   // TODO(MXG): Build this into the Database/Mirror class, tracking participant
   // description versions separately from itinerary versions.
   std::size_t last_known_participants_version = 0;
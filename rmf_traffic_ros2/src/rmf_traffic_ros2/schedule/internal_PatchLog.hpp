@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_PATCHLOG_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_PATCHLOG_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <rclcpp/serialized_message.hpp>
+
+#include <string>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// The kinds of messages that a patch log can hold. Each record holds one
+/// serialized message of the matching type.
+enum class PatchLogRecordType : uint8_t
+{
+  ItinerarySet = 1,
+  ItineraryExtend,
+  ItineraryDelay,
+  ItineraryErase,
+  ItineraryClear,
+  Participants,
+  MirrorUpdate
+};
+
+//==============================================================================
+/// Appends serialized schedule traffic to a memory-mapped log file, so that
+/// the load of a real deployment can be recorded and replayed offline.
+///
+/// The file grows in chunks, and the unused part of the last chunk is cut off
+/// when the writer is destroyed. If the recorder gets killed instead, the
+/// unused part stays zeroed, which PatchLogReader treats as the end of the
+/// log.
+class PatchLogWriter
+{
+public:
+
+  /// Create the log file, replacing any file that is already there.
+  ///
+  /// \throws std::runtime_error if the file cannot be created or mapped.
+  PatchLogWriter(std::string file_path);
+
+  /// Append a record that was received at the given time.
+  ///
+  /// \throws std::runtime_error if the log cannot grow.
+  void append(
+    PatchLogRecordType type,
+    rmf_traffic::Time time,
+    const rclcpp::SerializedMessage& message);
+
+  /// The number of records that have been appended
+  std::size_t records() const;
+
+  /// The number of bytes that the records take up in the file
+  std::size_t bytes() const;
+
+  PatchLogWriter(const PatchLogWriter&) = delete;
+  PatchLogWriter& operator=(const PatchLogWriter&) = delete;
+
+  ~PatchLogWriter();
+
+private:
+  void _map(std::size_t capacity);
+
+  std::string _file_path;
+  int _fd = -1;
+  uint8_t* _data = nullptr;
+  std::size_t _capacity = 0;
+  std::size_t _end = 0;
+  std::size_t _records = 0;
+};
+
+//==============================================================================
+/// Maps a patch log into memory for replay. The records point into the
+/// mapping, so nothing is copied until a message gets deserialized.
+class PatchLogReader
+{
+public:
+
+  struct Record
+  {
+    PatchLogRecordType type;
+    rmf_traffic::Time time;
+    const uint8_t* data;
+    std::size_t size;
+
+    /// Copy the payload into a message that rclcpp can deserialize
+    rclcpp::SerializedMessage message() const;
+  };
+
+  /// Map a patch log.
+  ///
+  /// \throws std::runtime_error if the file cannot be mapped, is not a patch
+  /// log, or has a malformed record before its end.
+  PatchLogReader(const std::string& file_path);
+
+  /// The records of the log, in the order that they were appended
+  const std::vector<Record>& records() const;
+
+  PatchLogReader(const PatchLogReader&) = delete;
+  PatchLogReader& operator=(const PatchLogReader&) = delete;
+
+  ~PatchLogReader();
+
+private:
+  const uint8_t* _data = nullptr;
+  std::size_t _size = 0;
+  std::vector<Record> _records;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_PATCHLOG_HPP
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_PERFORMANCECOUNTERS_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_PERFORMANCECOUNTERS_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <rclcpp/node.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Counts events and measures the durations of the hot paths of the schedule
+/// node, and publishes a summary of each sampling period on the
+/// DiagnosticsTopicName topic. Recording is thread-safe. When the counters are
+/// disabled, recording returns right away without locking anything.
+class PerformanceCounters
+{
+public:
+
+  using Duration = rmf_traffic::Duration;
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  struct Timing
+  {
+    std::size_t count = 0;
+    Duration total = Duration(0);
+    Duration max = Duration(0);
+
+    void record(Duration duration);
+  };
+
+  struct Sample
+  {
+    Duration period = Duration(0);
+    std::map<std::string, std::size_t, std::less<>> counts;
+    std::map<std::string, Timing, std::less<>> timings;
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] node
+  ///   The node that will publish the counters
+  ///
+  /// \param[in] sample_period
+  ///   How often to publish the counters. A zero period disables them.
+  PerformanceCounters(rclcpp::Node& node, Duration sample_period);
+
+  /// True if the counters are being collected
+  bool enabled() const;
+
+  /// Add to the count of an event
+  void count(std::string_view name, std::size_t amount = 1);
+
+  /// Record one measurement of a duration
+  void record(std::string_view name, Duration duration);
+
+  /// Record the time that has passed since start
+  void record_since(std::string_view name, TimePoint start);
+
+  /// The current time, or a default time point if the counters are disabled,
+  /// so the clock is not read needlessly
+  TimePoint now() const;
+
+  /// Get what has been recorded since the last sample, and start a new one
+  Sample take_sample();
+
+  /// Publish the current sample and start a new one
+  void publish();
+
+  /// Locks a mutex, and records how long it waited for the mutex and how long
+  /// it held on to it
+  class Lock
+  {
+  public:
+    Lock(
+      std::mutex& mutex,
+      PerformanceCounters& counters,
+      std::string_view name);
+
+    /// The underlying lock, for use with condition variables
+    std::unique_lock<std::mutex>& get();
+
+    ~Lock();
+
+  private:
+    PerformanceCounters& _counters;
+    std::string_view _name;
+    std::unique_lock<std::mutex> _lock;
+    TimePoint _acquired;
+  };
+
+private:
+  std::string _source;
+  bool _enabled;
+  mutable std::mutex _mutex;
+  Sample _sample;
+  TimePoint _sample_start;
+
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr
+    _publisher;
+  rclcpp::TimerBase::SharedPtr _timer;
+  rclcpp::Clock::SharedPtr _clock;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_PERFORMANCECOUNTERS_HPP
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_REGIONINDEX_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_REGIONINDEX_HPP
+
+#include <rmf_traffic/schedule/Database.hpp>
+#include <rmf_traffic/schedule/Query.hpp>
+
+#include <rmf_traffic_ros2/schedule/RouteBox.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// A spatial index of where the participants of the database have routes,
+/// used to evaluate queries for regions without looking at every participant.
+/// The routes are bucketed into a uniform grid of cells for each map, and a
+/// region is looked up through the cells that its bounding box covers.
+///
+/// The lookup only considers space, not time, so it can return participants
+/// whose routes are in the region at other times, but it never misses a
+/// participant whose routes are in the region.
+class RegionIndex
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+  using Regions = rmf_traffic::schedule::Query::Spacetime::Regions;
+
+  /// Constructor
+  ///
+  /// \param[in] cell_size
+  ///   The side length of each grid cell, in meters.
+  RegionIndex(double cell_size = 10.0);
+
+  /// Bring the index up to date with the database. Only the participants
+  /// whose itinerary versions have changed since the last refresh get indexed
+  /// again.
+  void refresh(const rmf_traffic::schedule::Database& database);
+
+  /// Get the participants that might have a route inside any of the regions.
+  std::unordered_set<ParticipantId> participants_in(
+    const Regions& regions) const;
+
+  /// Get the number of participants that are currently indexed.
+  std::size_t size() const;
+
+private:
+
+  struct CellKey
+  {
+    int64_t x;
+    int64_t y;
+
+    bool operator==(const CellKey& other) const
+    {
+      return x == other.x && y == other.y;
+    }
+  };
+
+  struct CellHash
+  {
+    std::size_t operator()(const CellKey& key) const
+    {
+      return std::hash<int64_t>()(key.x) ^ (std::hash<int64_t>()(key.y) << 1);
+    }
+  };
+
+  // How many routes of each participant touch a cell
+  using Cell = std::unordered_map<ParticipantId, std::size_t>;
+  using Grid = std::unordered_map<CellKey, Cell, CellHash>;
+
+  struct IndexedRoute
+  {
+    std::string map;
+    RouteBox box;
+  };
+
+  struct IndexedParticipant
+  {
+    rmf_traffic::schedule::ItineraryVersion itinerary_version;
+    std::vector<IndexedRoute> routes;
+  };
+
+  template<typename F>
+  void _for_each_cell(
+    double min_x, double min_y, double max_x, double max_y, F&& f) const;
+
+  void _erase(ParticipantId participant);
+
+  void _insert(
+    ParticipantId participant,
+    rmf_traffic::schedule::ItineraryVersion itinerary_version,
+    const rmf_traffic::schedule::ParticipantDescription& description,
+    const rmf_traffic::schedule::Itinerary& itinerary);
+
+  double _cell_size;
+  std::optional<rmf_traffic::schedule::Version> _database_version;
+  std::unordered_map<std::string, Grid> _maps;
+  std::unordered_map<ParticipantId, IndexedParticipant> _participants;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_REGIONINDEX_HPP
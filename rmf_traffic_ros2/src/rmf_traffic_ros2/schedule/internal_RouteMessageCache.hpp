@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_ROUTEMESSAGECACHE_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_ROUTEMESSAGECACHE_HPP
+
+#include <rmf_traffic/schedule/Itinerary.hpp>
+#include <rmf_traffic/schedule/Writer.hpp>
+
+#include <rmf_traffic_msgs/msg/itinerary.hpp>
+#include <rmf_traffic_msgs/msg/route.hpp>
+#include <rmf_traffic_msgs/msg/schedule_writer_item.hpp>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// Remembers the message that each route was converted into, so that a route
+/// which gets published more than once does not need to be encoded again.
+///
+/// Routes are shared as immutable ConstRoutePtr instances, so the cache is
+/// keyed by the identity of the route. An entry is only used while the route
+/// that it was made from is still alive, which prevents a new route that
+/// happens to reuse the address of an old one from getting a stale message.
+///
+/// This class is thread-safe.
+class RouteMessageCache
+{
+public:
+
+  /// Constructor
+  ///
+  /// \param[in] capacity
+  ///   How many routes to remember. When the cache is full, the entries of
+  ///   routes that no longer exist are dropped, and if that is not enough then
+  ///   every entry is dropped.
+  RouteMessageCache(std::size_t capacity = 1024);
+
+  /// Convert a route, reusing its message if it was converted before
+  rmf_traffic_msgs::msg::Route convert(
+    const rmf_traffic::ConstRoutePtr& route);
+
+  /// Convert the input of a schedule writer
+  std::vector<rmf_traffic_msgs::msg::ScheduleWriterItem> convert(
+    const rmf_traffic::schedule::Writer::Input& input);
+
+  /// Convert an itinerary
+  std::vector<rmf_traffic_msgs::msg::Route> convert(
+    const rmf_traffic::schedule::Itinerary& itinerary);
+
+  /// Convert a set of itineraries
+  std::vector<rmf_traffic_msgs::msg::Itinerary> convert(
+    const std::vector<rmf_traffic::schedule::Itinerary>& itineraries);
+
+  /// Get the number of routes that are currently remembered
+  std::size_t size() const;
+
+private:
+
+  struct Entry
+  {
+    std::weak_ptr<const rmf_traffic::Route> route;
+    rmf_traffic_msgs::msg::Route msg;
+  };
+
+  void _make_room();
+
+  std::size_t _capacity;
+  std::unordered_map<const rmf_traffic::Route*, Entry> _entries;
+  mutable std::mutex _mutex;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_ROUTEMESSAGECACHE_HPP
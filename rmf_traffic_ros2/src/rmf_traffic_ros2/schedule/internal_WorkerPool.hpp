@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_WORKERPOOL_HPP
+#define SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_WORKERPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// A fixed pool of worker threads that can be used to evaluate a batch of
+/// independent jobs in parallel. The thread that calls run() participates in
+/// the work, so a pool of size 1 will not spawn any additional threads.
+class WorkerPool
+{
+public:
+
+  using Job = std::function<void(std::size_t)>;
+
+  /// Constructor
+  ///
+  /// \param[in] num_workers
+  ///   The total number of threads that should evaluate jobs, including the
+  ///   thread that calls run(). A value of 0 is treated as 1.
+  WorkerPool(std::size_t num_workers);
+
+  /// Call job(i) for every i in [0, num_jobs) and block until every job is
+  /// finished. This can only be called from one thread at a time.
+  void run(std::size_t num_jobs, const Job& job);
+
+  /// Get the total number of threads that evaluate jobs.
+  std::size_t size() const;
+
+  ~WorkerPool();
+
+private:
+
+  void _work();
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _start_cv;
+  std::condition_variable _finish_cv;
+
+  const Job* _job = nullptr;
+  std::size_t _num_jobs = 0;
+  std::atomic_size_t _next_job = 0;
+  std::size_t _busy_workers = 0;
+  uint64_t _generation = 0;
+  bool _quit = false;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+#endif // SRC__RMF_TRAFFIC_ROS2__SCHEDULE__INTERNAL_WORKERPOOL_HPP
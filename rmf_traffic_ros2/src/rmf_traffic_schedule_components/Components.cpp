@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic_ros2/schedule/MonitorNode.hpp>
+#include <rmf_traffic_ros2/schedule/Node.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_components/register_node_macro.hpp>
+
+#include <mutex>
+#include <thread>
+
+namespace rmf_traffic_ros2 {
+namespace schedule {
+
+//==============================================================================
+/// The traffic schedule node as a component. When mirrors are loaded into the
+/// same container, they receive their patches from it directly instead of
+/// through the update topics.
+class ScheduleComponent
+{
+public:
+
+  ScheduleComponent(const rclcpp::NodeOptions& options)
+  : _node(make_node(options))
+  {
+    RCLCPP_INFO(_node->get_logger(), "Beginning traffic schedule component");
+  }
+
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr
+  get_node_base_interface() const
+  {
+    return _node->get_node_base_interface();
+  }
+
+private:
+  std::shared_ptr<rclcpp::Node> _node;
+};
+
+//==============================================================================
+/// The schedule monitor as a component. The replacement schedule node that it
+/// creates is not known to the container, so it gets spun by an executor of
+/// its own.
+class MonitorComponent
+{
+public:
+
+  MonitorComponent(const rclcpp::NodeOptions& options)
+  {
+    _monitor = make_monitor_node(
+      [this](std::shared_ptr<rclcpp::Node> new_active_schedule_node)
+      {
+        start_replacement(std::move(new_active_schedule_node));
+      },
+      options);
+  }
+
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr
+  get_node_base_interface() const
+  {
+    return _monitor->get_node_base_interface();
+  }
+
+  ~MonitorComponent()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_executor)
+      _executor->cancel();
+
+    if (_spin_thread.joinable())
+      _spin_thread.join();
+  }
+
+private:
+
+  void start_replacement(std::shared_ptr<rclcpp::Node> node)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_replacement)
+    {
+      // Only the first replacement gets used, the same as the standalone
+      // monitor, which stops spinning once it has one.
+      return;
+    }
+
+    RCLCPP_INFO(node->get_logger(), "Spinning up replacement schedule node");
+    _replacement = std::move(node);
+    _executor = std::make_shared<rclcpp::executors::SingleThreadedExecutor>();
+    _executor->add_node(_replacement);
+    _spin_thread = std::thread(
+      [executor = _executor]()
+      {
+        executor->spin();
+      });
+  }
+
+  std::mutex _mutex;
+  std::shared_ptr<rclcpp::Node> _monitor;
+  std::shared_ptr<rclcpp::Node> _replacement;
+  std::shared_ptr<rclcpp::executors::SingleThreadedExecutor> _executor;
+  std::thread _spin_thread;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic_ros2
+
+RCLCPP_COMPONENTS_REGISTER_NODE(rmf_traffic_ros2::schedule::ScheduleComponent)
+RCLCPP_COMPONENTS_REGISTER_NODE(rmf_traffic_ros2::schedule::MonitorComponent)
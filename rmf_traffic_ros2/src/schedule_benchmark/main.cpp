@@ -0,0 +1,654 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This benchmark puts a synthetic load on a running schedule node and
+/// reports how well it keeps up. It creates a number of participants that keep
+/// changing their itineraries with a mix of sets, extends, and delays, plus a
+/// number of mirrors that each register a distinct query for the whole
+/// schedule. For each stage of the run it reports:
+///  - itinerary-to-mirror latency: from sending a change until each mirror
+///    holds it. Mirrors are polled every millisecond, which bounds the
+///    resolution of this measurement.
+///  - conflict notice latency: from the latest change of any participant in a
+///    conflict until the notice for the conflict arrives. Pairs of
+///    participants are sent along the same lane in opposite directions to
+///    produce conflicts. Nobody answers the negotiations, so each pair only
+///    gets noticed once.
+///  - CPU and resident memory of the schedule node, if its PID is given
+///
+/// With colocated:=true the benchmark runs its own schedule node in this
+/// process, so its mirrors receive patches directly from the schedule instead
+/// of through the update topics. Comparing the latencies of such a run with
+/// one against a separate rmf_traffic_schedule shows what the topics cost. The
+/// CPU and memory that get reported are then those of this whole process.
+///
+/// Every stage doubles the update rate of the stage before it. The run stops
+/// at the first stage that saturates the schedule, meaning its 99th percentile
+/// latency goes above saturation_latency_ms or less than 95% of the changes
+/// reach the mirrors.
+///
+/// Usage:
+///   ros2 run rmf_traffic_ros2 schedule_benchmark --ros-args
+///     -p participants:=50 -p conflict_pairs:=5 -p mirrors:=4
+///     -p waypoints:=30 -p update_rate:=1.0
+///     -p set_weight:=1.0 -p extend_weight:=1.0 -p delay_weight:=4.0
+///     -p stages:=5 -p stage_duration:=20 -p saturation_latency_ms:=100.0
+///     -p schedule_pid:=<pid of rmf_traffic_schedule> -p colocated:=false
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+#include <rmf_traffic_ros2/Time.hpp>
+#include <rmf_traffic_ros2/schedule/MirrorManager.hpp>
+#include <rmf_traffic_ros2/schedule/Node.hpp>
+#include <rmf_traffic_ros2/schedule/Writer.hpp>
+
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include <rmf_traffic_msgs/msg/negotiation_notice.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <unistd.h>
+
+namespace {
+using namespace std::chrono_literals;
+using SteadyTime = std::chrono::steady_clock::time_point;
+using NegotiationNotice = rmf_traffic_msgs::msg::NegotiationNotice;
+
+// Itineraries get replaced by a set once they have this many routes, so an
+// extend-heavy mix does not grow them without bound.
+const std::size_t MaxRoutes = 5;
+
+//==============================================================================
+struct Settings
+{
+  std::size_t participants;
+  std::size_t conflict_pairs;
+  std::size_t mirrors;
+  std::size_t waypoints;
+  double update_rate;
+  double set_weight;
+  double extend_weight;
+  double delay_weight;
+  std::size_t stages;
+  rmf_traffic::Duration stage_duration;
+  double saturation_latency_ms;
+  int64_t schedule_pid;
+  bool colocated;
+};
+
+//==============================================================================
+Settings load_settings(rclcpp::Node& node)
+{
+  const auto count = [&node](const std::string& name, const int64_t value)
+    {
+      node.declare_parameter<int64_t>(name, value);
+      return static_cast<std::size_t>(
+        std::max<int64_t>(0, node.get_parameter(name).as_int()));
+    };
+
+  const auto number = [&node](const std::string& name, const double value)
+    {
+      node.declare_parameter<double>(name, value);
+      return std::max(0.0, node.get_parameter(name).as_double());
+    };
+
+  Settings settings;
+  settings.participants = count("participants", 20);
+  settings.conflict_pairs =
+    std::min(count("conflict_pairs", 2), settings.participants / 2);
+  settings.mirrors = count("mirrors", 4);
+  settings.waypoints = std::max<std::size_t>(2, count("waypoints", 20));
+  settings.update_rate = number("update_rate", 1.0);
+  settings.set_weight = number("set_weight", 1.0);
+  settings.extend_weight = number("extend_weight", 1.0);
+  settings.delay_weight = number("delay_weight", 4.0);
+  settings.stages = std::max<std::size_t>(1, count("stages", 1));
+  settings.stage_duration =
+    std::chrono::seconds(std::max<std::size_t>(1, count("stage_duration", 20)));
+  settings.saturation_latency_ms = number("saturation_latency_ms", 100.0);
+  settings.schedule_pid = static_cast<int64_t>(count("schedule_pid", 0));
+  node.declare_parameter<bool>("colocated", false);
+  settings.colocated = node.get_parameter("colocated").as_bool();
+  if (settings.colocated && settings.schedule_pid == 0)
+    settings.schedule_pid = getpid();
+  return settings;
+}
+
+//==============================================================================
+/// Percentiles of a set of latencies, in milliseconds
+struct Summary
+{
+  std::size_t count = 0;
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+//==============================================================================
+Summary summarize(std::vector<double> samples)
+{
+  Summary summary;
+  summary.count = samples.size();
+  if (samples.empty())
+    return summary;
+
+  std::sort(samples.begin(), samples.end());
+  const auto at = [&samples](const double q)
+    {
+      const auto i = static_cast<std::size_t>(q * samples.size());
+      return samples[std::min(i, samples.size() - 1)];
+    };
+
+  summary.p50 = at(0.5);
+  summary.p90 = at(0.9);
+  summary.p99 = at(0.99);
+  summary.max = samples.back();
+  return summary;
+}
+
+//==============================================================================
+/// CPU time and resident memory of a process, read from /proc
+struct ProcessUsage
+{
+  bool valid = false;
+  double cpu_seconds = 0.0;
+  std::size_t rss_kb = 0;
+};
+
+//==============================================================================
+ProcessUsage read_process_usage(const int64_t pid)
+{
+  ProcessUsage usage;
+  if (pid <= 0)
+    return usage;
+
+  const std::string proc = "/proc/" + std::to_string(pid);
+  std::ifstream stat(proc + "/stat");
+  std::string line;
+  if (!std::getline(stat, line))
+    return usage;
+
+  // The command name may contain spaces, so the fields are counted from its
+  // closing parenthesis. The state that follows it is field 3, and the user
+  // and system times are fields 14 and 15.
+  const auto close = line.rfind(')');
+  if (close == std::string::npos)
+    return usage;
+
+  std::istringstream fields(line.substr(close + 1));
+  std::string field;
+  uint64_t ticks = 0;
+  for (int i = 3; i <= 15 && fields >> field; ++i)
+  {
+    if (i == 14 || i == 15)
+      ticks += std::stoull(field);
+  }
+
+  usage.cpu_seconds =
+    static_cast<double>(ticks) / static_cast<double>(::sysconf(_SC_CLK_TCK));
+
+  std::ifstream status(proc + "/status");
+  while (std::getline(status, line))
+  {
+    if (line.rfind("VmRSS:", 0) == 0)
+      usage.rss_kb = std::stoull(line.substr(6));
+  }
+
+  usage.valid = true;
+  return usage;
+}
+
+//==============================================================================
+double to_ms(const rmf_traffic::Duration duration)
+{
+  return rmf_traffic::time::to_seconds(duration) * 1e3;
+}
+
+//==============================================================================
+class ScheduleBenchmark
+{
+public:
+
+  ScheduleBenchmark(std::shared_ptr<rclcpp::Node> node, Settings settings)
+  : _node(std::move(node)),
+    _settings(std::move(settings)),
+    _writer(rmf_traffic_ros2::schedule::Writer::make(_node))
+  {
+    // Do nothing
+  }
+
+  /// Create the participants and mirrors, then run every stage
+  void run()
+  {
+    setup();
+
+    _notice_sub = _node->create_subscription<NegotiationNotice>(
+      rmf_traffic_ros2::NegotiationNoticeTopicName,
+      rclcpp::SystemDefaultsQoS().reliable(),
+      [this](const NegotiationNotice::SharedPtr msg)
+      {
+        receive_notice(*msg);
+      });
+
+    double rate = _settings.update_rate;
+    for (std::size_t stage = 0; stage < _settings.stages; ++stage)
+    {
+      if (!run_stage(stage, rate))
+        break;
+
+      rate *= 2.0;
+    }
+  }
+
+private:
+
+  struct Synthetic
+  {
+    std::optional<rmf_traffic::schedule::Participant> participant;
+    double lane = 0.0;
+    bool reverse = false;
+    std::size_t routes = 0;
+
+    // The start of the latest route in the itinerary, which identifies each
+    // change that gets sent
+    rmf_traffic::Time key;
+    rmf_traffic::Time finish;
+    SteadyTime last_sent;
+  };
+
+  // A change that has not reached every mirror yet
+  struct Pending
+  {
+    std::size_t participant;
+    rmf_traffic::Time key;
+    SteadyTime sent;
+    std::vector<bool> reached;
+    std::size_t remaining;
+  };
+
+  void setup()
+  {
+    while (!_writer->ready())
+      rclcpp::spin_some(_node);
+
+    const auto& s = _settings;
+    _participants.resize(s.participants);
+    std::size_t made = 0;
+    for (std::size_t i = 0; i < s.participants; ++i)
+    {
+      auto& synthetic = _participants[i];
+      const bool paired = i < 2 * s.conflict_pairs;
+      synthetic.lane = 10.0 * static_cast<double>(
+        paired ? i / 2 : s.conflict_pairs + i);
+      synthetic.reverse = paired && (i % 2 == 1);
+
+      // Participants that are not meant to conflict are unresponsive, so the
+      // schedule does not bother to negotiate between them.
+      using Rx = rmf_traffic::schedule::ParticipantDescription::Rx;
+      _writer->async_make_participant(
+        rmf_traffic::schedule::ParticipantDescription(
+          "benchmark_" + std::to_string(i),
+          "schedule_benchmark",
+          paired ? Rx::Responsive : Rx::Unresponsive,
+          rmf_traffic::Profile(
+            rmf_traffic::geometry::make_final_convex<
+              rmf_traffic::geometry::Circle>(0.5))),
+        [this, i, &made](rmf_traffic::schedule::Participant participant)
+        {
+          _participants[i].participant = std::move(participant);
+          _index_of_id[_participants[i].participant->id()] = i;
+          ++made;
+        });
+    }
+
+    while (made < s.participants)
+      rclcpp::spin_some(_node);
+
+    for (std::size_t m = 0; m < s.mirrors; ++m)
+    {
+      // Excluding an ID that will never be used makes every query distinct,
+      // so the schedule has to serve each mirror separately.
+      auto query = rmf_traffic::schedule::query_all();
+      query.participants() =
+        rmf_traffic::schedule::Query::Participants::make_all_except(
+        {std::numeric_limits<rmf_traffic::schedule::ParticipantId>::max() - m});
+
+      auto future = rmf_traffic_ros2::schedule::make_mirror(_node, query);
+      while (future.wait_for(10ms) != std::future_status::ready)
+        rclcpp::spin_some(_node);
+
+      _mirrors.emplace_back(future.get());
+    }
+
+    std::cout << "Created " << s.participants << " participants ("
+              << s.conflict_pairs << " conflicting pairs) and " << s.mirrors
+              << " mirrors" << std::endl;
+
+    // Start every participant with an itinerary
+    for (std::size_t i = 0; i < s.participants; ++i)
+      send_set(i);
+  }
+
+  rmf_traffic::Route make_route(
+    const Synthetic& synthetic,
+    const rmf_traffic::Time start) const
+  {
+    const double speed = 1.0;
+    const auto step = 2s;
+    const double length =
+      speed * rmf_traffic::time::to_seconds(step)
+      * static_cast<double>(_settings.waypoints - 1);
+
+    rmf_traffic::Trajectory trajectory;
+    for (std::size_t i = 0; i < _settings.waypoints; ++i)
+    {
+      const double travelled =
+        speed * rmf_traffic::time::to_seconds(step) * static_cast<double>(i);
+      const double x = synthetic.reverse ? length - travelled : travelled;
+      const double yaw = synthetic.reverse ? M_PI : 0.0;
+      const double v = synthetic.reverse ? -speed : speed;
+      trajectory.insert(
+        start + static_cast<int>(i) * step,
+        {x, synthetic.lane, yaw},
+        {v, 0.0, 0.0});
+    }
+
+    return rmf_traffic::Route("benchmark_map", std::move(trajectory));
+  }
+
+  void send_set(const std::size_t i)
+  {
+    auto& synthetic = _participants[i];
+    const auto now = rmf_traffic_ros2::convert(_node->get_clock()->now());
+    const auto start = std::max(now, synthetic.key + 1ms);
+    auto route = make_route(synthetic, start);
+    synthetic.finish = *route.trajectory().finish_time();
+    synthetic.participant->set({std::move(route)});
+    synthetic.routes = 1;
+    sent(i, start);
+  }
+
+  void send_extend(const std::size_t i)
+  {
+    auto& synthetic = _participants[i];
+    const auto start = synthetic.finish + 1s;
+    auto route = make_route(synthetic, start);
+    synthetic.finish = *route.trajectory().finish_time();
+    synthetic.participant->extend({std::move(route)});
+    ++synthetic.routes;
+    sent(i, start);
+  }
+
+  void send_delay(const std::size_t i)
+  {
+    auto& synthetic = _participants[i];
+    const auto delay = std::chrono::milliseconds(
+      std::uniform_int_distribution<int>(100, 2000)(_rng));
+    synthetic.participant->delay(delay);
+    synthetic.finish += delay;
+    sent(i, synthetic.key + delay);
+  }
+
+  void sent(const std::size_t i, const rmf_traffic::Time key)
+  {
+    auto& synthetic = _participants[i];
+    synthetic.key = key;
+    synthetic.last_sent = std::chrono::steady_clock::now();
+    ++_sent;
+
+    if (_mirrors.empty())
+      return;
+
+    _pending.push_back(
+      Pending{
+        i, key, synthetic.last_sent,
+        std::vector<bool>(_mirrors.size(), false), _mirrors.size()
+      });
+  }
+
+  void send_change(const std::size_t i)
+  {
+    const auto& synthetic = _participants[i];
+    if (synthetic.routes >= MaxRoutes)
+      return send_set(i);
+
+    const double total = _settings.set_weight + _settings.extend_weight
+      + _settings.delay_weight;
+    if (total <= 0.0)
+      return send_set(i);
+
+    const double choice =
+      std::uniform_real_distribution<double>(0.0, total)(_rng);
+    if (choice < _settings.set_weight)
+      return send_set(i);
+
+    if (choice < _settings.set_weight + _settings.extend_weight)
+      return send_extend(i);
+
+    send_delay(i);
+  }
+
+  bool has_change(
+    const rmf_traffic_ros2::schedule::MirrorManager& mirror,
+    const rmf_traffic::schedule::ParticipantId id,
+    const rmf_traffic::Time key) const
+  {
+    const auto itinerary = mirror.viewer().get_itinerary(id);
+    if (!itinerary.has_value())
+      return false;
+
+    for (const auto& route : *itinerary)
+    {
+      const auto* start = route->trajectory().start_time();
+      if (start && key <= *start)
+        return true;
+    }
+
+    return false;
+  }
+
+  void poll_mirrors()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    auto it = _pending.begin();
+    while (it != _pending.end())
+    {
+      const auto id = _participants[it->participant].participant->id();
+      for (std::size_t m = 0; m < _mirrors.size(); ++m)
+      {
+        if (it->reached[m] || !has_change(_mirrors[m], id, it->key))
+          continue;
+
+        it->reached[m] = true;
+        --it->remaining;
+        _latencies.push_back(to_ms(now - it->sent));
+      }
+
+      if (it->remaining == 0)
+        it = _pending.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  void receive_notice(const NegotiationNotice& msg)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    std::optional<SteadyTime> latest;
+    for (const auto id : msg.participants)
+    {
+      const auto it = _index_of_id.find(id);
+      if (it == _index_of_id.end())
+        continue;
+
+      const auto sent = _participants[it->second].last_sent;
+      if (!latest.has_value() || *latest < sent)
+        latest = sent;
+    }
+
+    if (latest.has_value())
+      _notice_latencies.push_back(to_ms(now - *latest));
+  }
+
+  /// Returns false if the schedule was saturated during this stage
+  bool run_stage(const std::size_t stage, const double rate)
+  {
+    _latencies.clear();
+    _notice_latencies.clear();
+    _pending.clear();
+    _sent = 0;
+
+    const auto usage_start = read_process_usage(_settings.schedule_pid);
+    const auto start = std::chrono::steady_clock::now();
+    const double total_rate =
+      rate * static_cast<double>(_participants.size());
+    std::size_t next = 0;
+
+    const auto timer = _node->create_wall_timer(
+      1ms,
+      [&]()
+      {
+        // Catch up on every change that is due, in case the timer fell behind
+        const double elapsed = rmf_traffic::time::to_seconds(
+          std::chrono::steady_clock::now() - start);
+        const auto due = static_cast<std::size_t>(elapsed * total_rate);
+        while (_sent < due && !_participants.empty())
+        {
+          send_change(next);
+          next = (next + 1) % _participants.size();
+        }
+
+        poll_mirrors();
+      });
+
+    while (std::chrono::steady_clock::now() - start < _settings.stage_duration)
+      rclcpp::spin_some(_node);
+
+    timer->cancel();
+
+    // Give the changes that are still in flight a moment to arrive
+    const auto drain_start = std::chrono::steady_clock::now();
+    while (!_pending.empty()
+      && std::chrono::steady_clock::now() - drain_start < 1s)
+    {
+      rclcpp::spin_some(_node);
+      poll_mirrors();
+    }
+
+    const auto seconds = rmf_traffic::time::to_seconds(
+      std::chrono::steady_clock::now() - start);
+    const auto usage_end = read_process_usage(_settings.schedule_pid);
+
+    const std::size_t expected = _sent * _mirrors.size();
+    const double delivered = expected == 0 ? 1.0 :
+      static_cast<double>(_latencies.size()) / static_cast<double>(expected);
+
+    const auto latency = summarize(_latencies);
+    const auto notice = summarize(_notice_latencies);
+
+    std::printf(
+      "Stage %lu: %.1f updates/s (%.2f Hz per participant), %lu sent\n",
+      stage, static_cast<double>(_sent) / seconds, rate, _sent);
+    std::printf(
+      "  itinerary-to-mirror latency (ms): p50 %.2f | p90 %.2f | p99 %.2f | "
+      "max %.2f | %.1f%% delivered\n",
+      latency.p50, latency.p90, latency.p99, latency.max, 100.0 * delivered);
+    std::printf(
+      "  conflict notice latency (ms): %lu notices | p50 %.2f | max %.2f\n",
+      notice.count, notice.p50, notice.max);
+
+    if (usage_start.valid && usage_end.valid)
+    {
+      std::printf(
+        "  schedule node: %.1f%% CPU | %lu kB resident\n",
+        100.0 * (usage_end.cpu_seconds - usage_start.cpu_seconds) / seconds,
+        usage_end.rss_kb);
+    }
+
+    const bool saturated = _settings.saturation_latency_ms < latency.p99
+      || delivered < 0.95;
+    if (saturated)
+      std::printf("  The schedule is saturated at this rate\n");
+
+    std::fflush(stdout);
+    return !saturated;
+  }
+
+  std::shared_ptr<rclcpp::Node> _node;
+  Settings _settings;
+  rmf_traffic_ros2::schedule::WriterPtr _writer;
+  std::vector<Synthetic> _participants;
+  std::unordered_map<rmf_traffic::schedule::ParticipantId, std::size_t>
+  _index_of_id;
+  std::vector<rmf_traffic_ros2::schedule::MirrorManager> _mirrors;
+  rclcpp::Subscription<NegotiationNotice>::SharedPtr _notice_sub;
+  std::mt19937 _rng = std::mt19937(42);
+
+  std::list<Pending> _pending;
+  std::vector<double> _latencies;
+  std::vector<double> _notice_latencies;
+  std::size_t _sent = 0;
+};
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<rclcpp::Node>("schedule_benchmark");
+  const auto settings = load_settings(*node);
+
+  // The schedule gets its own executor so that it keeps up independently of
+  // the waiting that the benchmark does.
+  std::shared_ptr<rclcpp::Node> schedule_node;
+  rclcpp::executors::SingleThreadedExecutor schedule_executor;
+  std::thread schedule_thread;
+  if (settings.colocated)
+  {
+    schedule_node = rmf_traffic_ros2::schedule::make_node();
+    schedule_executor.add_node(schedule_node);
+    schedule_thread = std::thread([&]() { schedule_executor.spin(); });
+  }
+
+  {
+    ScheduleBenchmark benchmark(node, settings);
+    benchmark.run();
+  }
+
+  if (schedule_thread.joinable())
+  {
+    schedule_executor.cancel();
+    schedule_thread.join();
+  }
+
+  rclcpp::shutdown();
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This tool records the traffic of a running schedule into a patch log
+/// so that its load can be replayed offline with schedule_replay. It records:
+///  - every itinerary change that participants send to the schedule
+///  - the participants info that the schedule publishes
+///  - the mirror updates of a query for the whole schedule, starting with a
+///    full update
+///
+/// Messages are appended without being deserialized. Mirror updates that get
+/// dropped on the way are not requested again, so a replay into a mirror may
+/// report patches that failed to apply.
+///
+/// Usage:
+///   ros2 run rmf_traffic_ros2 schedule_recorder --ros-args
+///     -p file:=schedule.patchlog -p itineraries:=true -p mirror_updates:=true
+
+#include "../rmf_traffic_ros2/schedule/internal_PatchLog.hpp"
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+#include <rmf_traffic_ros2/Time.hpp>
+#include <rmf_traffic_ros2/schedule/Query.hpp>
+
+#include <rmf_traffic/schedule/Query.hpp>
+
+#include <rmf_traffic_msgs/msg/itinerary_clear.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_delay.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_erase.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_extend.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_set.hpp>
+#include <rmf_traffic_msgs/msg/mirror_update.hpp>
+#include <rmf_traffic_msgs/msg/participants.hpp>
+#include <rmf_traffic_msgs/srv/register_query.hpp>
+#include <rmf_traffic_msgs/srv/request_changes.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+using namespace std::chrono_literals;
+using rmf_traffic_ros2::schedule::PatchLogRecordType;
+using rmf_traffic_ros2::schedule::PatchLogWriter;
+using RegisterQuery = rmf_traffic_msgs::srv::RegisterQuery;
+using RequestChanges = rmf_traffic_msgs::srv::RequestChanges;
+
+//==============================================================================
+class ScheduleRecorder
+{
+public:
+
+  ScheduleRecorder(std::shared_ptr<rclcpp::Node> node)
+  : _node(std::move(node))
+  {
+    const auto file = _node->declare_parameter<std::string>(
+      "file", "schedule.patchlog");
+    const bool itineraries =
+      _node->declare_parameter<bool>("itineraries", true);
+    const bool mirror_updates =
+      _node->declare_parameter<bool>("mirror_updates", true);
+
+    _log = std::make_unique<PatchLogWriter>(file);
+    RCLCPP_INFO(
+      _node->get_logger(), "Recording schedule traffic into [%s]",
+      file.c_str());
+
+    if (itineraries)
+    {
+      // Use the same QoS as the schedule node so that nothing gets recorded
+      // that the schedule would not have received.
+      const auto itinerary_qos =
+        rclcpp::SystemDefaultsQoS().reliable().keep_last(100);
+
+      using namespace rmf_traffic_msgs::msg;
+      record<ItinerarySet>(
+        rmf_traffic_ros2::ItinerarySetTopicName,
+        itinerary_qos, PatchLogRecordType::ItinerarySet);
+      record<ItineraryExtend>(
+        rmf_traffic_ros2::ItineraryExtendTopicName,
+        itinerary_qos, PatchLogRecordType::ItineraryExtend);
+      record<ItineraryDelay>(
+        rmf_traffic_ros2::ItineraryDelayTopicName,
+        itinerary_qos, PatchLogRecordType::ItineraryDelay);
+      record<ItineraryErase>(
+        rmf_traffic_ros2::ItineraryEraseTopicName,
+        itinerary_qos, PatchLogRecordType::ItineraryErase);
+      record<ItineraryClear>(
+        rmf_traffic_ros2::ItineraryClearTopicName,
+        itinerary_qos, PatchLogRecordType::ItineraryClear);
+    }
+
+    // The participants are needed to replay either kind of record
+    record<rmf_traffic_msgs::msg::Participants>(
+      rmf_traffic_ros2::ParticipantsInfoTopicName,
+      rclcpp::SystemDefaultsQoS().reliable().keep_last(100).transient_local(),
+      PatchLogRecordType::Participants);
+
+    if (mirror_updates)
+      register_query();
+  }
+
+  ~ScheduleRecorder()
+  {
+    // Stop receiving before the log gets closed
+    _subscriptions.clear();
+    RCLCPP_INFO(
+      _node->get_logger(), "Recorded %lu messages in %lu bytes",
+      _log->records(), _log->bytes());
+  }
+
+private:
+
+  template<typename Message>
+  void record(
+    const std::string& topic,
+    const rclcpp::QoS& qos,
+    const PatchLogRecordType type)
+  {
+    _subscriptions.push_back(
+      _node->create_subscription<Message>(
+        topic, qos,
+        [this, type](std::shared_ptr<rclcpp::SerializedMessage> msg)
+        {
+          _log->append(type, rmf_traffic_ros2::convert(_node->now()), *msg);
+        }));
+  }
+
+  void register_query()
+  {
+    _register_query_client =
+      _node->create_client<RegisterQuery>(
+      rmf_traffic_ros2::RegisterQueryServiceName);
+    _request_changes_client =
+      _node->create_client<RequestChanges>(
+      rmf_traffic_ros2::RequestChangesServiceName);
+
+    _discovery_timer = _node->create_wall_timer(
+      100ms, [this]()
+      {
+        if (!_register_query_client->service_is_ready())
+          return;
+
+        _discovery_timer.reset();
+        auto request = std::make_shared<RegisterQuery::Request>();
+        request->query = rmf_traffic_ros2::convert(
+          rmf_traffic::schedule::query_all());
+
+        _register_query_client->async_send_request(
+          request,
+          [this](rclcpp::Client<RegisterQuery>::SharedFuture future)
+          {
+            subscribe_to_updates(future.get()->query_id);
+          });
+      });
+  }
+
+  void subscribe_to_updates(const uint64_t query_id)
+  {
+    RCLCPP_INFO(
+      _node->get_logger(), "Recording the mirror updates of query [%lu]",
+      query_id);
+
+    record<rmf_traffic_msgs::msg::MirrorUpdate>(
+      rmf_traffic_ros2::QueryUpdateTopicNameBase + std::to_string(query_id),
+      rclcpp::SystemDefaultsQoS(),
+      PatchLogRecordType::MirrorUpdate);
+
+    // Start the log with everything that is already on the schedule. The
+    // subscription may take a moment to be matched, so the request is delayed
+    // a little.
+    _full_update_timer = _node->create_wall_timer(
+      500ms, [this, query_id]()
+      {
+        if (!_request_changes_client->service_is_ready())
+          return;
+
+        _full_update_timer.reset();
+        auto request = std::make_shared<RequestChanges::Request>();
+        request->query_id = query_id;
+        request->version = 0;
+        request->full_update = true;
+        _request_changes_client->async_send_request(request);
+      });
+  }
+
+  std::shared_ptr<rclcpp::Node> _node;
+  std::unique_ptr<PatchLogWriter> _log;
+  std::vector<rclcpp::SubscriptionBase::SharedPtr> _subscriptions;
+  rclcpp::Client<RegisterQuery>::SharedPtr _register_query_client;
+  rclcpp::Client<RequestChanges>::SharedPtr _request_changes_client;
+  rclcpp::TimerBase::SharedPtr _discovery_timer;
+  rclcpp::TimerBase::SharedPtr _full_update_timer;
+};
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<rclcpp::Node>("schedule_recorder");
+  {
+    ScheduleRecorder recorder(node);
+    rclcpp::spin(node);
+  }
+  rclcpp::shutdown();
+}
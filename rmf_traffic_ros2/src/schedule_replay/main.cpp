@@ -0,0 +1,452 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/// Note: This tool replays a patch log that was made by schedule_recorder, to
+/// reproduce the load of a real deployment offline. It has two targets:
+///  - mirror: the recorded mirror updates are applied to a mirror in this
+///    process, and the time it takes to deserialize, convert, and apply each
+///    of them is reported.
+///  - schedule: the recorded itinerary changes are sent to a running schedule
+///    node, e.g. a fresh rmf_traffic_schedule that is being profiled. The
+///    recorded participants get registered with it first, and their changes
+///    are renumbered to the IDs and itinerary versions that it hands out. The
+///    changes of a participant are skipped until its first set or clear, and
+///    every route gets shifted so that it starts as far from now as it
+///    originally started from the moment it was recorded.
+///
+/// Records are sent at the speed they were recorded at, multiplied by speed.
+/// A speed of 0 replays the log as fast as possible.
+///
+/// Usage:
+///   ros2 run rmf_traffic_ros2 schedule_replay --ros-args
+///     -p file:=schedule.patchlog -p target:=mirror -p speed:=1.0
+
+#include "../rmf_traffic_ros2/schedule/internal_PatchLog.hpp"
+
+#include <rmf_traffic_ros2/StandardNames.hpp>
+#include <rmf_traffic_ros2/Time.hpp>
+#include <rmf_traffic_ros2/schedule/ParticipantDescription.hpp>
+#include <rmf_traffic_ros2/schedule/Patch.hpp>
+
+#include <rmf_traffic/schedule/Mirror.hpp>
+
+#include <rmf_traffic_msgs/msg/itinerary_clear.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_delay.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_erase.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_extend.hpp>
+#include <rmf_traffic_msgs/msg/itinerary_set.hpp>
+#include <rmf_traffic_msgs/msg/mirror_update.hpp>
+#include <rmf_traffic_msgs/msg/participants.hpp>
+#include <rmf_traffic_msgs/srv/register_participant.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp/serialization.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+using namespace std::chrono_literals;
+using rmf_traffic_ros2::schedule::PatchLogReader;
+using rmf_traffic_ros2::schedule::PatchLogRecordType;
+using Record = PatchLogReader::Record;
+using SteadyClock = std::chrono::steady_clock;
+
+//==============================================================================
+template<typename Message>
+Message deserialize(const Record& record)
+{
+  static const rclcpp::Serialization<Message> serializer;
+  const auto serialized = record.message();
+  Message msg;
+  serializer.deserialize_message(&serialized, &msg);
+  return msg;
+}
+
+//==============================================================================
+double to_ms(const SteadyClock::duration duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+//==============================================================================
+void print_summary(const std::string& name, std::vector<double> samples)
+{
+  if (samples.empty())
+  {
+    std::cout << name << ": no samples" << std::endl;
+    return;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  const auto at = [&samples](const double q)
+    {
+      const auto i = static_cast<std::size_t>(q * samples.size());
+      return samples[std::min(i, samples.size() - 1)];
+    };
+
+  std::cout << name << " (ms): count " << samples.size()
+            << " | p50 " << at(0.5) << " | p90 " << at(0.9)
+            << " | p99 " << at(0.99) << " | max " << samples.back()
+            << std::endl;
+}
+
+//==============================================================================
+/// Waits until each record is due, based on the time it was recorded at
+class Pacer
+{
+public:
+
+  Pacer(const std::vector<Record>& records, const double speed)
+  : _speed(speed),
+    _start(SteadyClock::now())
+  {
+    if (!records.empty())
+      _first = records.front().time;
+  }
+
+  /// Sleep until the record is due
+  void wait_for(const Record& record)
+  {
+    if (_speed <= 0.0)
+      return;
+
+    const auto offset = std::chrono::duration_cast<SteadyClock::duration>(
+      std::chrono::duration<double>(
+        rmf_traffic::time::to_seconds(record.time - _first) / _speed));
+    std::this_thread::sleep_until(_start + offset);
+  }
+
+private:
+  double _speed;
+  SteadyClock::time_point _start;
+  rmf_traffic::Time _first;
+};
+
+//==============================================================================
+int replay_into_mirror(const PatchLogReader& log, const double speed)
+{
+  rmf_traffic::schedule::Mirror mirror;
+  Pacer pacer(log.records(), speed);
+
+  std::vector<double> decode_ms;
+  std::vector<double> update_ms;
+  std::size_t failed = 0;
+  const auto start = SteadyClock::now();
+  for (const auto& record : log.records())
+  {
+    if (record.type == PatchLogRecordType::Participants)
+    {
+      pacer.wait_for(record);
+      const auto msg = deserialize<rmf_traffic_msgs::msg::Participants>(record);
+      mirror.update_participants_info(rmf_traffic_ros2::convert(msg));
+    }
+    else if (record.type == PatchLogRecordType::MirrorUpdate)
+    {
+      pacer.wait_for(record);
+      const auto decode_start = SteadyClock::now();
+      const auto msg =
+        deserialize<rmf_traffic_msgs::msg::MirrorUpdate>(record);
+      const auto patch = rmf_traffic_ros2::convert(msg.patch);
+      const auto update_start = SteadyClock::now();
+      if (!mirror.update(patch) && !msg.is_remedial_update)
+        ++failed;
+
+      const auto finish = SteadyClock::now();
+      decode_ms.push_back(to_ms(update_start - decode_start));
+      update_ms.push_back(to_ms(finish - update_start));
+    }
+  }
+
+  std::cout << "Replayed " << update_ms.size() << " mirror updates in "
+            << to_ms(SteadyClock::now() - start) << " ms, " << failed
+            << " failed to apply" << std::endl;
+  print_summary("deserialize and convert", std::move(decode_ms));
+  print_summary("mirror update", std::move(update_ms));
+  std::cout << "Mirror is at version " << mirror.latest_version()
+            << " with " << mirror.participant_ids().size() << " participants"
+            << std::endl;
+  return 0;
+}
+
+//==============================================================================
+class ScheduleReplay
+{
+public:
+
+  using ParticipantId = rmf_traffic::schedule::ParticipantId;
+  using ItineraryVersion = rmf_traffic::schedule::ItineraryVersion;
+  using Register = rmf_traffic_msgs::srv::RegisterParticipant;
+
+  ScheduleReplay(std::shared_ptr<rclcpp::Node> node)
+  : _node(std::move(node))
+  {
+    const auto qos = rclcpp::SystemDefaultsQoS().reliable().keep_last(100);
+    using namespace rmf_traffic_msgs::msg;
+    _set_pub = _node->create_publisher<ItinerarySet>(
+      rmf_traffic_ros2::ItinerarySetTopicName, qos);
+    _extend_pub = _node->create_publisher<ItineraryExtend>(
+      rmf_traffic_ros2::ItineraryExtendTopicName, qos);
+    _delay_pub = _node->create_publisher<ItineraryDelay>(
+      rmf_traffic_ros2::ItineraryDelayTopicName, qos);
+    _erase_pub = _node->create_publisher<ItineraryErase>(
+      rmf_traffic_ros2::ItineraryEraseTopicName, qos);
+    _clear_pub = _node->create_publisher<ItineraryClear>(
+      rmf_traffic_ros2::ItineraryClearTopicName, qos);
+    _register_client = _node->create_client<Register>(
+      rmf_traffic_ros2::RegisterParticipantSrvName);
+  }
+
+  int run(const PatchLogReader& log, const double speed)
+  {
+    while (!_register_client->wait_for_service(1s))
+    {
+      if (!rclcpp::ok())
+        return 1;
+
+      RCLCPP_INFO(_node->get_logger(), "Waiting for the schedule node");
+    }
+
+    Pacer pacer(log.records(), speed);
+    const auto start = SteadyClock::now();
+    for (const auto& record : log.records())
+    {
+      if (!rclcpp::ok())
+        return 1;
+
+      if (record.type == PatchLogRecordType::MirrorUpdate)
+        continue;
+
+      pacer.wait_for(record);
+      send(record);
+    }
+
+    std::cout << "Sent " << _sent << " itinerary changes to the schedule in "
+              << to_ms(SteadyClock::now() - start) << " ms, skipped "
+              << _skipped << " of them. Registered " << _participants.size()
+              << " participants." << std::endl;
+    return 0;
+  }
+
+private:
+
+  struct Participant
+  {
+    ParticipantId id;
+    ItineraryVersion last_version;
+
+    // Added to each recorded itinerary version. This is only known once the
+    // first set or clear of the participant has been seen.
+    std::optional<ItineraryVersion> version_offset;
+  };
+
+  void send(const Record& record)
+  {
+    using namespace rmf_traffic_msgs::msg;
+    switch (record.type)
+    {
+      case PatchLogRecordType::Participants:
+        register_participants(deserialize<Participants>(record));
+        return;
+      case PatchLogRecordType::ItinerarySet:
+      {
+        auto msg = deserialize<ItinerarySet>(record);
+        if (renumber(msg, true))
+        {
+          shift(msg.itinerary, record.time);
+          _set_pub->publish(msg);
+        }
+        return;
+      }
+      case PatchLogRecordType::ItineraryExtend:
+      {
+        auto msg = deserialize<ItineraryExtend>(record);
+        if (renumber(msg, false))
+        {
+          shift(msg.routes, record.time);
+          _extend_pub->publish(msg);
+        }
+        return;
+      }
+      case PatchLogRecordType::ItineraryDelay:
+      {
+        auto msg = deserialize<ItineraryDelay>(record);
+        if (renumber(msg, false))
+          _delay_pub->publish(msg);
+        return;
+      }
+      case PatchLogRecordType::ItineraryErase:
+      {
+        auto msg = deserialize<ItineraryErase>(record);
+        if (renumber(msg, false))
+          _erase_pub->publish(msg);
+        return;
+      }
+      case PatchLogRecordType::ItineraryClear:
+      {
+        auto msg = deserialize<ItineraryClear>(record);
+        if (renumber(msg, true))
+          _clear_pub->publish(msg);
+        return;
+      }
+      case PatchLogRecordType::MirrorUpdate:
+        return;
+    }
+  }
+
+  void register_participants(const rmf_traffic_msgs::msg::Participants& msg)
+  {
+    for (const auto& participant : msg.participants)
+    {
+      if (_participants.count(participant.id))
+        continue;
+
+      auto request = std::make_shared<Register::Request>();
+      request->description = participant.description;
+      auto future = _register_client->async_send_request(request);
+      if (rclcpp::spin_until_future_complete(_node, future, 5s)
+        != rclcpp::FutureReturnCode::SUCCESS)
+      {
+        RCLCPP_ERROR(
+          _node->get_logger(), "Failed to register participant [%s]",
+          participant.description.name.c_str());
+        continue;
+      }
+
+      const auto response = future.get();
+      if (!response->error.empty())
+      {
+        RCLCPP_ERROR(
+          _node->get_logger(), "Failed to register participant [%s]: %s",
+          participant.description.name.c_str(), response->error.c_str());
+        continue;
+      }
+
+      _participants[participant.id] = Participant{
+        response->participant_id,
+        response->last_itinerary_version,
+        std::nullopt
+      };
+    }
+  }
+
+  /// Give a change the ID and itinerary version that the schedule expects.
+  /// Returns false if the change should be skipped.
+  template<typename Message>
+  bool renumber(Message& msg, const bool replaces_itinerary)
+  {
+    const auto it = _participants.find(msg.participant);
+    if (it == _participants.end())
+    {
+      ++_skipped;
+      return false;
+    }
+
+    auto& participant = it->second;
+    if (!participant.version_offset.has_value())
+    {
+      if (!replaces_itinerary)
+      {
+        ++_skipped;
+        return false;
+      }
+
+      // The versions wrap around, so the offset is allowed to underflow
+      participant.version_offset =
+        participant.last_version + 1 - msg.itinerary_version;
+    }
+
+    msg.participant = participant.id;
+    msg.itinerary_version += *participant.version_offset;
+    ++_sent;
+    return true;
+  }
+
+  void shift(
+    std::vector<rmf_traffic_msgs::msg::Route>& routes,
+    const rmf_traffic::Time recorded_at)
+  {
+    const auto offset =
+      (rmf_traffic_ros2::convert(_node->now()) - recorded_at).count();
+    for (auto& route : routes)
+    {
+      for (auto& waypoint : route.trajectory.waypoints)
+        waypoint.time += offset;
+    }
+  }
+
+  std::shared_ptr<rclcpp::Node> _node;
+  rclcpp::Publisher<rmf_traffic_msgs::msg::ItinerarySet>::SharedPtr _set_pub;
+  rclcpp::Publisher<rmf_traffic_msgs::msg::ItineraryExtend>::SharedPtr
+    _extend_pub;
+  rclcpp::Publisher<rmf_traffic_msgs::msg::ItineraryDelay>::SharedPtr
+    _delay_pub;
+  rclcpp::Publisher<rmf_traffic_msgs::msg::ItineraryErase>::SharedPtr
+    _erase_pub;
+  rclcpp::Publisher<rmf_traffic_msgs::msg::ItineraryClear>::SharedPtr
+    _clear_pub;
+  rclcpp::Client<Register>::SharedPtr _register_client;
+  std::unordered_map<ParticipantId, Participant> _participants;
+  std::size_t _sent = 0;
+  std::size_t _skipped = 0;
+};
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<rclcpp::Node>("schedule_replay");
+  const auto file =
+    node->declare_parameter<std::string>("file", "schedule.patchlog");
+  const auto target = node->declare_parameter<std::string>("target", "mirror");
+  const double speed = std::max(0.0, node->declare_parameter("speed", 1.0));
+
+  int result = 0;
+  try
+  {
+    const PatchLogReader log(file);
+    RCLCPP_INFO(
+      node->get_logger(), "Replaying %lu records from [%s] into the %s",
+      log.records().size(), file.c_str(), target.c_str());
+
+    if (target == "mirror")
+      result = replay_into_mirror(log, speed);
+    else if (target == "schedule")
+      result = ScheduleReplay(node).run(log, speed);
+    else
+    {
+      RCLCPP_ERROR(
+        node->get_logger(),
+        "Unknown target [%s]; it must be either mirror or schedule",
+        target.c_str());
+      result = 1;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_ERROR(node->get_logger(), "%s", e.what());
+    result = 1;
+  }
+
+  rclcpp::shutdown();
+  return result;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef TEST__UNIT__TRAFFICFIXTURES_HPP
+#define TEST__UNIT__TRAFFICFIXTURES_HPP
+
+#include <rmf_traffic/Route.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+#include <rmf_traffic/schedule/ParticipantDescription.hpp>
+
+#include <memory>
+#include <string>
+
+namespace rmf_traffic_ros2_test {
+
+//==============================================================================
+/// Describe a participant with a circular footprint
+inline rmf_traffic::schedule::ParticipantDescription make_description(
+  const std::string& name,
+  const std::string& owner,
+  const rmf_traffic::schedule::ParticipantDescription::Rx responsiveness =
+  rmf_traffic::schedule::ParticipantDescription::Rx::Responsive)
+{
+  return rmf_traffic::schedule::ParticipantDescription(
+    name,
+    owner,
+    responsiveness,
+    rmf_traffic::Profile{
+      rmf_traffic::geometry::make_final_convex<
+        rmf_traffic::geometry::Circle>(0.5)
+    });
+}
+
+//==============================================================================
+/// Make a straight route that takes ten seconds to go from one point to the
+/// other
+inline rmf_traffic::Route make_route(
+  const std::string& map,
+  const rmf_traffic::Time start,
+  const Eigen::Vector3d& from = Eigen::Vector3d::Zero(),
+  const Eigen::Vector3d& to = Eigen::Vector3d(10.0, 0.0, 0.0))
+{
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(start, from, Eigen::Vector3d::Zero());
+  trajectory.insert(
+    start + std::chrono::seconds(10), to, Eigen::Vector3d::Zero());
+  return rmf_traffic::Route(map, std::move(trajectory));
+}
+
+//==============================================================================
+inline rmf_traffic::ConstRoutePtr make_route_ptr(
+  const std::string& map,
+  const rmf_traffic::Time start,
+  const Eigen::Vector3d& from = Eigen::Vector3d::Zero(),
+  const Eigen::Vector3d& to = Eigen::Vector3d(10.0, 0.0, 0.0))
+{
+  return std::make_shared<rmf_traffic::Route>(make_route(map, start, from, to));
+}
+
+} // namespace rmf_traffic_ros2_test
+
+#endif // TEST__UNIT__TRAFFICFIXTURES_HPP
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_CheckedRoutes.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+/// A route along the x axis with a waypoint every 10 seconds, which turns
+/// toward y = turn_y after the given number of waypoints
+rmf_traffic::ConstRoutePtr make_route(
+  const rmf_traffic::Time start,
+  const std::size_t waypoints,
+  const std::size_t turn_after = 1000,
+  const double turn_y = 5.0)
+{
+  rmf_traffic::Trajectory trajectory;
+  for (std::size_t i = 0; i < waypoints; ++i)
+  {
+    const double y = i < turn_after ? 0.0 : turn_y;
+    trajectory.insert(
+      start + static_cast<int>(i) * 10s,
+      {10.0 * static_cast<double>(i), y, 0.0},
+      Eigen::Vector3d::Zero());
+  }
+
+  return std::make_shared<rmf_traffic::Route>("L1", std::move(trajectory));
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Restricting conflict checks to the parts of routes that changed")
+{
+  const auto now = std::chrono::steady_clock::now();
+  CheckedRoutes checked_routes;
+  const auto original = make_route(now, 10);
+
+  GIVEN("A participant that has never been checked")
+  {
+    CHECK(checked_routes.changed_part(0, original) == original);
+  }
+
+  GIVEN("A participant whose routes were checked")
+  {
+    checked_routes.update({{0, {original}}}, {});
+
+    THEN("Sending the same route again leaves nothing to check")
+    {
+      CHECK_FALSE(checked_routes.changed_part(0, make_route(now, 10)));
+    }
+
+    THEN("A route that changes its tail only needs the tail checked")
+    {
+      const auto changed =
+        checked_routes.changed_part(0, make_route(now, 10, 6));
+      REQUIRE(changed);
+      CHECK(changed->trajectory().size() == 5);
+      CHECK(*changed->trajectory().start_time() == now + 50s);
+      CHECK(*changed->trajectory().finish_time() == now + 90s);
+    }
+
+    THEN("A route that resumes partway along the old one is compared there")
+    {
+      const auto resumed = make_route(now, 10, 6);
+      rmf_traffic::Trajectory trimmed;
+      for (auto it = ++resumed->trajectory().begin();
+        it != resumed->trajectory().end(); ++it)
+      {
+        trimmed.insert(it->time(), it->position(), it->velocity());
+      }
+
+      const auto changed = checked_routes.changed_part(
+        0, std::make_shared<rmf_traffic::Route>("L1", std::move(trimmed)));
+      REQUIRE(changed);
+      CHECK(*changed->trajectory().start_time() == now + 50s);
+    }
+
+    THEN("A route that changes from its first segment is checked entirely")
+    {
+      const auto route = make_route(now, 10, 1);
+      CHECK(checked_routes.changed_part(0, route) == route);
+    }
+
+    THEN("A delayed route is checked entirely")
+    {
+      const auto route = make_route(now + 5s, 10);
+      CHECK(checked_routes.changed_part(0, route) == route);
+    }
+
+    THEN("Other participants are not affected")
+    {
+      CHECK(checked_routes.changed_part(1, original) == original);
+    }
+
+    WHEN("The participant gets into a conflict")
+    {
+      checked_routes.update({{0, {original}}}, {0});
+
+      THEN("Its routes are checked entirely")
+      {
+        CHECK(checked_routes.changed_part(0, original) == original);
+      }
+    }
+
+    WHEN("The checked routes are cleared")
+    {
+      checked_routes.clear();
+
+      THEN("Its routes are checked entirely")
+      {
+        CHECK(checked_routes.changed_part(0, original) == original);
+      }
+    }
+  }
+}
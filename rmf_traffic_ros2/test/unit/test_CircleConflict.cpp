@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic/DetectConflict.hpp>
+#include <rmf_traffic/geometry/Box.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_CircleConflict.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+rmf_traffic::Trajectory make_trajectory(
+  const rmf_traffic::Time start,
+  const Eigen::Vector3d& p0,
+  const Eigen::Vector3d& p1)
+{
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(start, p0, Eigen::Vector3d::Zero());
+  trajectory.insert(start + 10s, p1, Eigen::Vector3d::Zero());
+  return trajectory;
+}
+
+//==============================================================================
+bool exact(
+  const rmf_traffic::Profile& profile_a,
+  const rmf_traffic::Trajectory& a,
+  const rmf_traffic::Profile& profile_b,
+  const rmf_traffic::Trajectory& b)
+{
+  return rmf_traffic::DetectConflict::between(
+    profile_a, a, profile_b, b).has_value();
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Circle conflict kernel")
+{
+  const auto now = std::chrono::steady_clock::now();
+  const rmf_traffic::Profile circle{
+    rmf_traffic::geometry::make_final_convex<
+      rmf_traffic::geometry::Circle>(0.5)
+  };
+
+  const auto horizontal = make_trajectory(
+    now, {-10.0, 0.0, 0.0}, {10.0, 0.0, 0.0});
+
+  GIVEN("A profile with a shape other than a circle")
+  {
+    const rmf_traffic::Profile box{
+      rmf_traffic::geometry::make_final_convex<
+        rmf_traffic::geometry::Box>(1.0, 1.0)
+    };
+
+    CHECK_FALSE(CircleSegments::make(box, horizontal).has_value());
+  }
+
+  GIVEN("Two routes that cross at the same time")
+  {
+    const auto vertical = make_trajectory(
+      now, {0.0, -10.0, 0.0}, {0.0, 10.0, 0.0});
+
+    const auto a = CircleSegments::make(circle, horizontal);
+    const auto b = CircleSegments::make(circle, vertical);
+    REQUIRE(a.has_value());
+    REQUIRE(b.has_value());
+    CHECK(a->start.size() == 1);
+    CHECK(may_conflict(*a, *b));
+    CHECK(detect_conflict(circle, horizontal, circle, vertical)
+      == exact(circle, horizontal, circle, vertical));
+  }
+
+  GIVEN("Two routes that cross at different times")
+  {
+    const auto vertical = make_trajectory(
+      now + 1min, {0.0, -10.0, 0.0}, {0.0, 10.0, 0.0});
+
+    const auto a = CircleSegments::make(circle, horizontal);
+    const auto b = CircleSegments::make(circle, vertical);
+    CHECK_FALSE(may_conflict(*a, *b));
+    CHECK_FALSE(detect_conflict(circle, horizontal, circle, vertical));
+  }
+
+  GIVEN("Two parallel routes that stay apart")
+  {
+    const auto parallel = make_trajectory(
+      now, {-10.0, 1.5, 0.0}, {10.0, 1.5, 0.0});
+
+    const auto a = CircleSegments::make(circle, horizontal);
+    const auto b = CircleSegments::make(circle, parallel);
+    CHECK_FALSE(may_conflict(*a, *b));
+    CHECK_FALSE(exact(circle, horizontal, circle, parallel));
+    CHECK_FALSE(detect_conflict(circle, horizontal, circle, parallel));
+  }
+
+  GIVEN("Two parallel routes that are close enough to touch")
+  {
+    const auto parallel = make_trajectory(
+      now, {-10.0, 0.5, 0.0}, {10.0, 0.5, 0.0});
+
+    const auto a = CircleSegments::make(circle, horizontal);
+    const auto b = CircleSegments::make(circle, parallel);
+    CHECK(may_conflict(*a, *b));
+    CHECK(detect_conflict(circle, horizontal, circle, parallel, &*a)
+      == exact(circle, horizontal, circle, parallel));
+  }
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_CompactPatch.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace rmf_traffic::schedule;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+rmf_traffic::ConstRoutePtr make_route(
+  const rmf_traffic::Time start,
+  const double x = 1.2345)
+{
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(start, {x, 2.0, 0.1}, {0.5, 0.0, 0.0});
+  trajectory.insert(start + 3s, {x + 4.0, 2.0, 0.1}, Eigen::Vector3d::Zero());
+  return std::make_shared<rmf_traffic::Route>(
+    "test_map", std::move(trajectory));
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Compact patch encoding")
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  const Patch first(
+    {Patch::Participant(
+        3, 7, Change::Erase({1, 2}), {Change::Delay(5s)},
+        Change::Add({{10, make_route(now)}}))},
+    Change::Cull(now), 4, 9);
+
+  // The same route shape, shifted in time
+  const Patch second(
+    {Patch::Participant(
+        3, 8, Change::Erase({10}), {},
+        Change::Add({{11, make_route(now + 5s)}}))},
+    std::nullopt, std::nullopt, 10);
+
+  CompactPatchEncoder encoder;
+  const auto first_data = encoder.encode(first);
+  const auto second_data = encoder.encode(second);
+
+  THEN("A resent route shape is sent as a reference")
+  {
+    CHECK(second_data.size() < first_data.size());
+  }
+
+  THEN("The decoder reproduces the patches")
+  {
+    CompactPatchDecoder decoder;
+    const auto first_out = decoder.decode(first_data);
+    CHECK(first_out.latest_version() == 9);
+    REQUIRE(first_out.base_version().has_value());
+    CHECK(*first_out.base_version() == 4);
+    REQUIRE(first_out.cull());
+    CHECK(first_out.cull()->time() == now);
+
+    REQUIRE(first_out.size() == 1);
+    const auto& p = *first_out.begin();
+    CHECK(p.participant_id() == 3);
+    CHECK(p.itinerary_version() == 7);
+    CHECK(p.erasures().ids().size() == 2);
+    REQUIRE(p.delays().size() == 1);
+    CHECK(p.delays()[0].duration() == 5s);
+    REQUIRE(p.additions().items().size() == 1);
+    const auto& route = *p.additions().items()[0].route;
+    CHECK(route.map() == "test_map");
+    CHECK(route.trajectory().size() == 2);
+    CHECK(route.trajectory().begin()->time() == now);
+    CHECK(route.trajectory().begin()->position().x() ==
+      Approx(1.2345).margin(1e-3));
+
+    const auto second_out = decoder.decode(second_data);
+    CHECK_FALSE(second_out.base_version().has_value());
+    CHECK_FALSE(second_out.cull());
+    REQUIRE(second_out.size() == 1);
+    const auto& item = second_out.begin()->additions().items().at(0);
+    CHECK(item.id == 11);
+    CHECK(item.route->trajectory().begin()->time() == now + 5s);
+  }
+
+  THEN("A decoder that missed a patch refuses the next one")
+  {
+    CompactPatchDecoder decoder;
+    CHECK_THROWS_AS(decoder.decode(second_data), std::runtime_error);
+  }
+
+  WHEN("The encoder is reset")
+  {
+    CompactPatchDecoder in_sync;
+    in_sync.decode(first_data);
+    in_sync.decode(second_data);
+
+    encoder.reset();
+    const auto restart_data = encoder.encode(second);
+
+    THEN("Every decoder follows the new stream")
+    {
+      // This decoder joined partway through the old stream
+      CompactPatchDecoder joining;
+      CHECK_THROWS_AS(joining.decode(second_data), std::runtime_error);
+      joining.reset();
+
+      CompactPatchDecoder fresh;
+      for (auto* decoder : {&in_sync, &joining, &fresh})
+      {
+        const auto out = decoder->decode(restart_data);
+        REQUIRE(out.size() == 1);
+        const auto& item = out.begin()->additions().items().at(0);
+        CHECK(item.route->trajectory().begin()->time() == now + 5s);
+      }
+    }
+  }
+
+  THEN("The header of a compact update is kept in front of its patch")
+  {
+    CompactUpdateHeader header;
+    header.node_version = 5;
+    header.database_version = 300;
+    header.is_remedial_update = true;
+    const auto data = make_compact_update(header, first_data);
+
+    std::string patch_data;
+    const auto read = read_compact_update(data, patch_data);
+    CHECK(read.node_version == 5);
+    CHECK(read.database_version == 300);
+    CHECK(read.is_remedial_update);
+    CHECK(patch_data == first_data);
+
+    CHECK_THROWS_AS(
+      read_compact_update(std::vector<uint8_t>(), patch_data),
+      std::runtime_error);
+  }
+
+  WHEN("Routes fall out of a short history")
+  {
+    CompactPatchOptions options;
+    options.route_history = 2;
+    CompactPatchEncoder short_encoder(options);
+    CompactPatchDecoder decoder;
+
+    for (std::size_t i = 0; i < 20; ++i)
+    {
+      const double x = static_cast<double>(i % 3);
+      const Patch patch(
+        {Patch::Participant(
+            1, i, Change::Erase({}), {},
+            Change::Add({{i, make_route(now, x)}}))},
+        std::nullopt, std::nullopt, i);
+
+      const auto out = decoder.decode(short_encoder.encode(patch));
+      const auto& route = *out.begin()->additions().items().at(0).route;
+      CHECK(route.trajectory().begin()->position().x() == Approx(x));
+    }
+  }
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_ConflictIndex.hpp"
+#include "TrafficFixtures.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace rmf_traffic_ros2_test;
+using namespace std::chrono_literals;
+
+//==============================================================================
+SCENARIO("Conflict index broad phase")
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto description =
+    make_description("participant", "test_ConflictIndex");
+  ConflictIndex index(2.0);
+
+  index.update(
+    0, description,
+    {make_route_ptr("L1", now, {0.0, 0.0, 0.0}, {10.0, 0.0, 0.0})});
+  index.update(
+    1, description,
+    {make_route_ptr("L1", now, {50.0, 50.0, 0.0}, {60.0, 50.0, 0.0})});
+  index.update(
+    2, description,
+    {make_route_ptr("L2", now, {0.0, 0.0, 0.0}, {10.0, 0.0, 0.0})});
+  index.update(
+    3, description,
+    {make_route_ptr("L1", now + 1h, {0.0, 0.0, 0.0}, {10.0, 0.0, 0.0})});
+  CHECK(index.size() == 4);
+
+  const auto route =
+    make_route_ptr("L1", now, {5.0, -5.0, 0.0}, {5.0, 5.0, 0.0});
+
+  WHEN("Looking for candidates of a route that crosses participant 0")
+  {
+    const auto candidates = index.candidates(
+      4, *route, description.profile());
+
+    // Participant 1 is too far away, participant 2 is on a different map, and
+    // participant 3 is on the same path but an hour later.
+    REQUIRE(candidates.size() == 1);
+    CHECK(candidates.front().participant == 0);
+    CHECK(candidates.front().description == index.description(0));
+  }
+
+  WHEN("The route belongs to the only nearby participant")
+  {
+    const auto candidates = index.candidates(
+      0, *route, description.profile());
+    CHECK(candidates.empty());
+  }
+
+  WHEN("Participant 0 moves away")
+  {
+    index.update(
+      0, description,
+      {make_route_ptr("L1", now, {-50.0, 0.0, 0.0}, {-40.0, 0.0, 0.0})});
+
+    const auto candidates = index.candidates(
+      4, *route, description.profile());
+    CHECK(candidates.empty());
+  }
+
+  WHEN("Participant 0 is removed")
+  {
+    index.retain({1, 2, 3});
+    CHECK(index.size() == 3);
+    CHECK(index.description(0) == nullptr);
+
+    const auto candidates = index.candidates(
+      4, *route, description.profile());
+    CHECK(candidates.empty());
+  }
+}
+
+//==============================================================================
+SCENARIO("Conflict index with unresponsive participants")
+{
+  using Rx = rmf_traffic::schedule::ParticipantDescription::Rx;
+  const auto now = std::chrono::steady_clock::now();
+  const auto responsive =
+    make_description("participant", "test_ConflictIndex", Rx::Responsive);
+  const auto unresponsive =
+    make_description("participant", "test_ConflictIndex", Rx::Unresponsive);
+  ConflictIndex index(2.0);
+
+  index.update(
+    0, responsive,
+    {make_route_ptr("L1", now, {0.0, 0.0, 0.0}, {10.0, 0.0, 0.0})});
+  index.update(
+    1, unresponsive,
+    {make_route_ptr("L1", now, {0.0, 1.0, 0.0}, {10.0, 1.0, 0.0})});
+
+  const auto route =
+    make_route_ptr("L1", now, {5.0, -5.0, 0.0}, {5.0, 5.0, 0.0});
+
+  WHEN("Unresponsive routes are included")
+  {
+    const auto candidates = index.candidates(4, *route, responsive.profile());
+    CHECK(candidates.size() == 2);
+  }
+
+  WHEN("Unresponsive routes are left out")
+  {
+    const auto candidates =
+      index.candidates(4, *route, unresponsive.profile(), false);
+    REQUIRE(candidates.size() == 1);
+    CHECK(candidates.front().participant == 0);
+  }
+
+  WHEN("The unresponsive participant is removed")
+  {
+    index.erase(1);
+    CHECK(index.size() == 1);
+
+    const auto candidates = index.candidates(4, *route, responsive.profile());
+    REQUIRE(candidates.size() == 1);
+    CHECK(candidates.front().participant == 0);
+  }
+}
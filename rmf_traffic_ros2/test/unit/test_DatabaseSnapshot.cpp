@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <filesystem>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_DatabaseSnapshot.hpp"
+#include "TrafficFixtures.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace rmf_traffic_ros2_test;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+void remove_files(const std::string& snapshot_file)
+{
+  for (const auto& suffix : {"", ".tail", ".tail.rotated", ".tmp"})
+    std::filesystem::remove(snapshot_file + suffix);
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Restoring a database from a snapshot and tail log")
+{
+  const std::string snapshot_file = "test_database_snapshot.bin";
+  const std::string tail_file = snapshot_file + ".tail";
+  remove_files(snapshot_file);
+
+  const auto now = std::chrono::steady_clock::now();
+  Database original;
+  const auto p0 = original.register_participant(
+    make_description("p0", "test_DatabaseSnapshot")).id();
+  original.set(p0, {make_route("test_map", now)}, 1);
+
+  GIVEN("No snapshot file")
+  {
+    CHECK_FALSE(load_snapshot(snapshot_file).has_value());
+  }
+
+  GIVEN("A saved snapshot")
+  {
+    save_snapshot(snapshot_file, serialize_snapshot(original));
+
+    THEN("The restored database has the same version and content")
+    {
+      auto restored = load_snapshot(snapshot_file);
+      REQUIRE(restored.has_value());
+      CHECK(restored->latest_version() == original.latest_version());
+      CHECK(restored->participant_ids() == original.participant_ids());
+      CHECK(restored->itinerary_version(p0) == original.itinerary_version(p0));
+      REQUIRE(restored->get_itinerary(p0).has_value());
+      CHECK(restored->get_itinerary(p0)->size() == 1);
+    }
+
+    WHEN("More changes are recorded in the tail log")
+    {
+      {
+        TailLog tail_log(tail_file);
+
+        auto previous = original.latest_version();
+        const auto description =
+          make_description("p1", "test_DatabaseSnapshot");
+        original.register_participant(description);
+        REQUIRE(original.latest_version() != previous);
+        tail_log.record(description, original.latest_version());
+
+        TailLog::ItineraryClear clear;
+        clear.participant = p0;
+        clear.itinerary_version = 2;
+        previous = original.latest_version();
+        original.erase(clear.participant, clear.itinerary_version);
+        REQUIRE(original.latest_version() != previous);
+        tail_log.record(clear, original.latest_version());
+      }
+
+      THEN("Replaying the log reproduces the same versions")
+      {
+        auto restored = load_snapshot(snapshot_file);
+        REQUIRE(restored.has_value());
+        CHECK(TailLog::replay(tail_file, *restored) == 2);
+        CHECK(restored->latest_version() == original.latest_version());
+        CHECK(restored->participant_ids() == original.participant_ids());
+        CHECK(restored->itinerary_version(p0) == 2);
+      }
+
+      AND_WHEN("The database gets culled")
+      {
+        {
+          TailLog tail_log(tail_file);
+          const auto previous = original.latest_version();
+          const rmf_traffic::schedule::Change::Cull cull(now + 1h);
+          original.cull(cull.time());
+          REQUIRE(original.latest_version() != previous);
+          tail_log.record(cull, original.latest_version());
+        }
+
+        THEN("Replaying the log reproduces the cull")
+        {
+          auto restored = load_snapshot(snapshot_file);
+          REQUIRE(restored.has_value());
+          CHECK(TailLog::replay(tail_file, *restored) == 3);
+          CHECK(restored->latest_version() == original.latest_version());
+        }
+      }
+
+      AND_WHEN("A new snapshot is taken")
+      {
+        TailLog tail_log(tail_file);
+        const auto snapshot = serialize_snapshot(original);
+        tail_log.rotate();
+        save_snapshot(snapshot_file, snapshot);
+        tail_log.discard_rotated();
+
+        THEN("Nothing is left to replay")
+        {
+          auto restored = load_snapshot(snapshot_file);
+          REQUIRE(restored.has_value());
+          CHECK(TailLog::replay(tail_file, *restored) == 0);
+          CHECK(restored->latest_version() == original.latest_version());
+        }
+      }
+    }
+  }
+
+  remove_files(snapshot_file);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_DatabaseUsage.hpp"
+#include "TrafficFixtures.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace rmf_traffic_ros2_test;
+using namespace std::chrono_literals;
+
+//==============================================================================
+SCENARIO("Measuring the memory used by a database")
+{
+  const auto now = std::chrono::steady_clock::now();
+  rmf_traffic::schedule::Database database;
+  const auto p0 = database.register_participant(
+    make_description("p0", "test_DatabaseUsage")).id();
+  const auto p1 = database.register_participant(
+    make_description("p1", "test_DatabaseUsage")).id();
+  database.set(p0, {make_route("L1", now), make_route("L2", now)}, 1);
+  database.set(p1, {make_route("L1", now + 20s)}, 1);
+
+  const auto usage = measure_usage(database);
+  CHECK(usage.total.routes == 3);
+  CHECK(usage.total.waypoints == 6);
+  CHECK(usage.total.bytes > 0);
+
+  REQUIRE(usage.maps.count("L1") == 1);
+  CHECK(usage.maps.at("L1").routes == 2);
+  REQUIRE(usage.maps.count("L2") == 1);
+  CHECK(usage.maps.at("L2").routes == 1);
+
+  REQUIRE(usage.participants.count("test_DatabaseUsage/p0") == 1);
+  CHECK(usage.participants.at("test_DatabaseUsage/p0").routes == 2);
+  REQUIRE(usage.participants.count("test_DatabaseUsage/p1") == 1);
+  CHECK(usage.participants.at("test_DatabaseUsage/p1").routes == 1);
+
+  WHEN("The finished routes are culled")
+  {
+    database.cull(now + 15s);
+    const auto culled = measure_usage(database);
+
+    THEN("Only the unfinished route is counted")
+    {
+      CHECK(culled.total.routes == 1);
+      CHECK(culled.total.bytes < usage.total.bytes);
+      CHECK(culled.participants.at("test_DatabaseUsage/p1").routes == 1);
+    }
+  }
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_ItineraryHistory.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+rmf_traffic::ConstRoutePtr make_route(const double x)
+{
+  const auto start = rmf_traffic::Time(0s);
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(start, {x, 0.0, 0.0}, Eigen::Vector3d::Zero());
+  trajectory.insert(start + 10s, {x + 10.0, 0.0, 0.0}, Eigen::Vector3d::Zero());
+  return std::make_shared<rmf_traffic::Route>(
+    "test_map", std::move(trajectory));
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Remembering the itineraries that a writer sent")
+{
+  ItineraryHistory history(3);
+  const rmf_traffic::schedule::ParticipantId p = 0;
+
+  CHECK_FALSE(history.latest_version(p).has_value());
+
+  const auto route_a = make_route(0.0);
+  const auto route_b = make_route(5.0);
+  history.set(p, {{0, route_a}}, 1);
+  REQUIRE(history.latest_version(p).has_value());
+  CHECK(*history.latest_version(p) == 1);
+
+  GIVEN("An extend")
+  {
+    history.extend(p, {{1, route_b}}, 2);
+    const auto itinerary = history.itinerary(p, 2);
+    REQUIRE(itinerary.has_value());
+    REQUIRE(itinerary->size() == 2);
+    CHECK(itinerary->at(0).route == route_a);
+    CHECK(itinerary->at(1).route == route_b);
+
+    THEN("The earlier version is still available")
+    {
+      const auto earlier = history.itinerary(p, 1);
+      REQUIRE(earlier.has_value());
+      CHECK(earlier->size() == 1);
+    }
+
+    AND_WHEN("A route is erased")
+    {
+      history.erase(p, {0}, 3);
+      const auto erased = history.itinerary(p, 3);
+      REQUIRE(erased.has_value());
+      REQUIRE(erased->size() == 1);
+      CHECK(erased->front().id == 1);
+    }
+  }
+
+  GIVEN("Several delays")
+  {
+    history.delay(p, 2s, 2);
+    history.delay(p, 3s, 3);
+    const auto itinerary = history.itinerary(p, 3);
+    REQUIRE(itinerary.has_value());
+    REQUIRE(itinerary->size() == 1);
+    const auto& trajectory = itinerary->front().route->trajectory();
+    CHECK(*trajectory.start_time() == rmf_traffic::Time(5s));
+    CHECK(*trajectory.finish_time() == rmf_traffic::Time(15s));
+
+    THEN("The original route is not changed")
+    {
+      CHECK(*route_a->trajectory().start_time() == rmf_traffic::Time(0s));
+    }
+  }
+
+  GIVEN("More changes than the history can hold")
+  {
+    for (std::size_t v = 2; v <= 5; ++v)
+      history.delay(p, 1s, v);
+
+    CHECK_FALSE(history.itinerary(p, 1).has_value());
+    CHECK_FALSE(history.itinerary(p, 2).has_value());
+    CHECK(history.itinerary(p, 3).has_value());
+    CHECK(history.itinerary(p, 5).has_value());
+  }
+
+  GIVEN("A clear")
+  {
+    history.clear(p, 2);
+    const auto itinerary = history.itinerary(p, 2);
+    REQUIRE(itinerary.has_value());
+    CHECK(itinerary->empty());
+  }
+
+  GIVEN("A participant that was forgotten")
+  {
+    history.forget(p);
+    CHECK_FALSE(history.latest_version(p).has_value());
+
+    THEN("Changes other than a set are not remembered")
+    {
+      history.extend(p, {{1, route_b}}, 2);
+      CHECK_FALSE(history.itinerary(p, 2).has_value());
+    }
+  }
+}
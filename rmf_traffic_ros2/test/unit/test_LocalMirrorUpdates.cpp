@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <rmf_traffic/schedule/Query.hpp>
+#include <rmf_traffic_ros2/schedule/MirrorManager.hpp>
+#include <rmf_traffic_ros2/schedule/Node.hpp>
+#include <rmf_traffic_ros2/schedule/Writer.hpp>
+#include <rmf_utils/catch.hpp>
+
+#include <rclcpp/executors/single_threaded_executor.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_LocalMirrorUpdates.hpp"
+#include "TrafficFixtures.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace rmf_traffic_ros2_test;
+using namespace std::chrono_literals;
+
+//==============================================================================
+SCENARIO("Local mirror updates are kept apart per channel")
+{
+  auto& local = LocalMirrorUpdates::get();
+  const std::string channel_a = "/channel_a/rmf_traffic/query_update_";
+  const std::string channel_b = "/channel_b/rmf_traffic/query_update_";
+  const std::string channel_c = "/channel_c/rmf_traffic/query_update_";
+
+  // Both schedule nodes start with the same node version, and both of their
+  // mirrors track a query with the same ID.
+  auto provider_a = local.provide(channel_a, 0);
+  auto provider_b = local.provide(channel_b, 0);
+  CHECK(local.provider(channel_a) == 0);
+  CHECK(local.provider(channel_b) == 0);
+  CHECK_FALSE(local.provider(channel_c).has_value());
+
+  std::size_t received_a = 0;
+  std::size_t withdrawn_a = 0;
+  auto listener_a = local.listen(
+    channel_a, 1, [&](const std::optional<LocalMirrorUpdates::Update>& u)
+    {
+      if (u.has_value())
+        ++received_a;
+      else
+        ++withdrawn_a;
+    });
+  REQUIRE(listener_a);
+
+  std::size_t received_b = 0;
+  std::size_t withdrawn_b = 0;
+  auto listener_b = local.listen(
+    channel_b, 1, [&](const std::optional<LocalMirrorUpdates::Update>& u)
+    {
+      if (u.has_value())
+        ++received_b;
+      else
+        ++withdrawn_b;
+    });
+  REQUIRE(listener_b);
+
+  CHECK_FALSE(local.listen(channel_c, 1, [](auto) {}));
+
+  const auto patch = std::make_shared<const rmf_traffic::schedule::Patch>(
+    std::vector<rmf_traffic::schedule::Patch::Participant>(),
+    std::nullopt, std::nullopt, 1);
+  const LocalMirrorUpdates::Update update{0, 1, patch, false};
+
+  CHECK(local.deliver(channel_a, 1, update) == 1);
+  CHECK(received_a == 1);
+  CHECK(received_b == 0);
+
+  CHECK(local.deliver(channel_b, 1, update) == 1);
+  CHECK(received_a == 1);
+  CHECK(received_b == 1);
+
+  CHECK(local.deliver(channel_a, 2, update) == 0);
+
+  // Withdrawing one schedule node only sends its own mirrors back to their
+  // update topics
+  provider_a.reset();
+  CHECK(withdrawn_a == 1);
+  CHECK(withdrawn_b == 0);
+  CHECK_FALSE(local.provider(channel_a).has_value());
+  CHECK(local.provider(channel_b) == 0);
+  CHECK(local.deliver(channel_a, 1, update) == 0);
+
+  listener_a.reset();
+  listener_b.reset();
+  provider_b.reset();
+  CHECK(withdrawn_b == 0);
+}
+
+namespace {
+//==============================================================================
+rclcpp::NodeOptions make_options(
+  const std::shared_ptr<rclcpp::Context>& context,
+  const std::string& ns)
+{
+  return rclcpp::NodeOptions()
+    .context(context)
+    .use_global_arguments(false)
+    .arguments({"--ros-args", "-r", "__ns:=" + ns});
+}
+
+//==============================================================================
+bool wait_until(const std::function<bool()>& condition)
+{
+  const auto stop = std::chrono::steady_clock::now() + 10s;
+  while (!condition())
+  {
+    if (stop < std::chrono::steady_clock::now())
+      return false;
+
+    std::this_thread::sleep_for(10ms);
+  }
+
+  return true;
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Schedule nodes and mirrors in one process")
+{
+  const std::string log_a = "test_local_mirror_updates_a.yaml";
+  const std::string log_b = "test_local_mirror_updates_b.yaml";
+  std::filesystem::remove(log_a);
+  std::filesystem::remove(log_b);
+
+  auto context = std::make_shared<rclcpp::Context>();
+  context->init(0, nullptr);
+
+  // Two schedule nodes in different namespaces of the same process start with
+  // the same node version and hand out the same query IDs.
+  const auto schedule_a = make_node(
+    make_options(context, "/a").parameter_overrides(
+      {rclcpp::Parameter("log_file_location", log_a)}));
+  const auto schedule_b = make_node(
+    make_options(context, "/b").parameter_overrides(
+      {rclcpp::Parameter("log_file_location", log_b)}));
+
+  const auto mirror_node_a = std::make_shared<rclcpp::Node>(
+    "test_mirror", make_options(context, "/a"));
+  const auto mirror_node_b = std::make_shared<rclcpp::Node>(
+    "test_mirror", make_options(context, "/b"));
+  const auto writer_node = std::make_shared<rclcpp::Node>(
+    "test_writer", make_options(context, "/a"));
+
+  rclcpp::ExecutorOptions executor_options;
+  executor_options.context = context;
+  rclcpp::executors::SingleThreadedExecutor executor(executor_options);
+  for (const auto& node :
+    {schedule_a, schedule_b, mirror_node_a, mirror_node_b, writer_node})
+  {
+    executor.add_node(node);
+  }
+
+  std::thread spin_thread([&executor]() { executor.spin(); });
+
+  auto mirror_future_a = make_mirror(
+    mirror_node_a, rmf_traffic::schedule::query_all());
+  auto mirror_future_b = make_mirror(
+    mirror_node_b, rmf_traffic::schedule::query_all());
+  REQUIRE(mirror_future_a.wait_for(10s) == std::future_status::ready);
+  REQUIRE(mirror_future_b.wait_for(10s) == std::future_status::ready);
+  auto mirror_a = mirror_future_a.get();
+  auto mirror_b = mirror_future_b.get();
+
+  const auto writer = Writer::make(writer_node);
+  REQUIRE(writer->wait_for_service(
+      std::chrono::steady_clock::now() + 10s));
+
+  auto participant_future = writer->make_participant(
+    make_description("p0", "test_LocalMirrorUpdates"));
+  REQUIRE(participant_future.wait_for(10s) == std::future_status::ready);
+  auto participant = participant_future.get();
+
+  const auto now = std::chrono::steady_clock::now();
+  participant.set({make_route("test_map", now + 1min)});
+
+  THEN("Only the mirror of the schedule that was written to sees the route")
+  {
+    CHECK(
+      wait_until(
+        [&]()
+        {
+          const auto& viewer = mirror_a.viewer();
+          if (viewer.participant_ids().count(participant.id()) == 0)
+            return false;
+
+          return viewer.query(rmf_traffic::schedule::query_all()).size() > 0;
+        }));
+
+    // Give the other schedule node time to publish anything it might wrongly
+    // send to the mirror in its namespace
+    std::this_thread::sleep_for(200ms);
+    CHECK(
+      mirror_b.viewer().query(rmf_traffic::schedule::query_all()).size() == 0);
+  }
+
+  executor.cancel();
+  spin_thread.join();
+  context->shutdown("test finished");
+  std::filesystem::remove(log_a);
+  std::filesystem::remove(log_b);
+}
+
+//==============================================================================
+SCENARIO("A mirror follows the compact updates of a schedule node")
+{
+  const std::string log = "test_compact_mirror_updates.yaml";
+  std::filesystem::remove(log);
+
+  auto context = std::make_shared<rclcpp::Context>();
+  context->init(0, nullptr);
+
+  // Local mirror updates are turned off so the updates go over the topics
+  const auto schedule = make_node(
+    make_options(context, "/compact").parameter_overrides(
+      {
+        rclcpp::Parameter("log_file_location", log),
+        rclcpp::Parameter("local_mirror_updates", false)
+      }));
+
+  const auto mirror_node = std::make_shared<rclcpp::Node>(
+    "test_mirror", make_options(context, "/compact"));
+  const auto writer_node = std::make_shared<rclcpp::Node>(
+    "test_writer", make_options(context, "/compact"));
+
+  rclcpp::ExecutorOptions executor_options;
+  executor_options.context = context;
+  rclcpp::executors::SingleThreadedExecutor executor(executor_options);
+  for (const auto& node : {schedule, mirror_node, writer_node})
+    executor.add_node(node);
+
+  std::thread spin_thread([&executor]() { executor.spin(); });
+
+  auto mirror_future = make_mirror(
+    mirror_node, rmf_traffic::schedule::query_all(),
+    MirrorManager::Options().compact_updates(true));
+  REQUIRE(mirror_future.wait_for(10s) == std::future_status::ready);
+  auto mirror = mirror_future.get();
+  CHECK(mirror.get_options().compact_updates());
+
+  const auto writer = Writer::make(writer_node);
+  REQUIRE(writer->wait_for_service(
+      std::chrono::steady_clock::now() + 10s));
+
+  auto participant_future = writer->make_participant(
+    make_description("p0", "test_LocalMirrorUpdates"));
+  REQUIRE(participant_future.wait_for(10s) == std::future_status::ready);
+  auto participant = participant_future.get();
+
+  const auto count_routes = [&]()
+    {
+      return mirror.viewer().query(rmf_traffic::schedule::query_all()).size();
+    };
+
+  const auto now = std::chrono::steady_clock::now();
+  participant.set({make_route("test_map", now + 1min)});
+  CHECK(wait_until([&]() { return count_routes() == 1; }));
+
+  // The second route is sent as a follow up in the same compact stream
+  participant.set(
+    {
+      make_route("test_map", now + 1min),
+      make_route("test_map", now + 2min)
+    });
+  CHECK(wait_until([&]() { return count_routes() == 2; }));
+
+  executor.cancel();
+  spin_thread.join();
+  context->shutdown("test finished");
+  std::filesystem::remove(log);
+}
@@ -0,0 +1,530 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <rmf_traffic/schedule/Database.hpp>
+#include <rmf_traffic_ros2/StandardNames.hpp>
+#include <rmf_traffic_ros2/schedule/Negotiation.hpp>
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_traffic_msgs/msg/negotiation_ack.hpp>
+#include <rmf_traffic_msgs/msg/negotiation_conclusion.hpp>
+#include <rmf_traffic_msgs/msg/negotiation_notice.hpp>
+#include <rmf_traffic_msgs/msg/negotiation_proposal.hpp>
+
+#include <rclcpp/executors/single_threaded_executor.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "TrafficFixtures.hpp"
+
+using namespace rmf_traffic_ros2_test;
+using namespace std::chrono_literals;
+
+using ParticipantId = rmf_traffic::schedule::ParticipantId;
+using Notice = rmf_traffic_msgs::msg::NegotiationNotice;
+using Conclusion = rmf_traffic_msgs::msg::NegotiationConclusion;
+using Proposal = rmf_traffic_msgs::msg::NegotiationProposal;
+using Ack = rmf_traffic_msgs::msg::NegotiationAck;
+using Key = rmf_traffic_msgs::msg::NegotiationKey;
+
+namespace {
+//==============================================================================
+bool wait_until(const std::function<bool()>& condition)
+{
+  const auto stop = std::chrono::steady_clock::now() + 10s;
+  while (!condition())
+  {
+    if (stop < std::chrono::steady_clock::now())
+      return false;
+
+    std::this_thread::sleep_for(10ms);
+  }
+
+  return true;
+}
+
+//==============================================================================
+/// Runs the jobs of each negotiation on one of several threads, the way the
+/// negotiation workers of a fleet adapter do
+class PoolWorker : public rmf_traffic_ros2::schedule::Negotiation::Worker
+{
+public:
+
+  PoolWorker(std::size_t size)
+  : _queues(size)
+  {
+    for (auto& queue : _queues)
+      _threads.emplace_back([this, &queue]() { run(queue); });
+  }
+
+  void schedule(std::function<void()> job) final
+  {
+    schedule_negotiation(0, std::move(job));
+  }
+
+  void schedule_negotiation(
+    uint64_t conflict_version,
+    std::function<void()> job) final
+  {
+    auto& queue = _queues[conflict_version % _queues.size()];
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      queue.push_back(std::move(job));
+    }
+    _cv.notify_all();
+  }
+
+  ~PoolWorker()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _cv.notify_all();
+
+    for (auto& thread : _threads)
+      thread.join();
+  }
+
+private:
+
+  using Queue = std::deque<std::function<void()>>;
+
+  void run(Queue& queue)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+      _cv.wait(lock, [&]() { return _stop || !queue.empty(); });
+      if (_stop)
+        return;
+
+      auto job = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+  }
+
+  std::vector<Queue> _queues;
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  bool _stop = false;
+};
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Conclusions of negotiations that were resolved locally")
+{
+  auto context = std::make_shared<rclcpp::Context>();
+  context->init(0, nullptr);
+
+  const auto options = rclcpp::NodeOptions()
+    .context(context)
+    .use_global_arguments(false)
+    .arguments({"--ros-args", "-r", "__ns:=/test_negotiation"});
+
+  const auto fleet_node =
+    std::make_shared<rclcpp::Node>("test_fleet", options);
+  const auto schedule_node =
+    std::make_shared<rclcpp::Node>("test_schedule", options);
+
+  const auto database = std::make_shared<rmf_traffic::schedule::Database>();
+  const auto p0 = database->register_participant(
+    make_description("p0", "test_Negotiation")).id();
+  const auto p1 = database->register_participant(
+    make_description("p1", "test_Negotiation")).id();
+
+  rmf_traffic_ros2::schedule::Negotiation negotiation(*fleet_node, database);
+  negotiation.resolve_local_negotiations(true);
+
+  // Everything below is only touched while holding this mutex, because the
+  // callbacks run on the spin thread.
+  std::mutex mutex;
+  std::vector<std::vector<ParticipantId>> approved;
+  std::size_t failures = 0;
+  std::vector<Proposal> proposals;
+  std::vector<Ack> acks;
+
+  const auto make_negotiator = [&]()
+    {
+      return [&](
+        rmf_traffic_ros2::schedule::Negotiation::TableViewPtr view,
+        rmf_traffic_ros2::schedule::Negotiation::ResponderPtr responder)
+        {
+          std::vector<ParticipantId> sequence;
+          for (const auto& key : view->sequence())
+            sequence.push_back(key.participant);
+
+          responder->submit(
+            {},
+            [&mutex, &approved, sequence]()
+            -> rmf_utils::optional<rmf_traffic::schedule::ItineraryVersion>
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              approved.push_back(sequence);
+              return rmf_utils::nullopt;
+            });
+        };
+    };
+
+  const auto on_failure = [&]()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++failures;
+    };
+
+  const auto handle_0 =
+    negotiation.register_negotiator(p0, make_negotiator(), on_failure);
+  const auto handle_1 =
+    negotiation.register_negotiator(p1, make_negotiator(), on_failure);
+
+  const auto qos = rclcpp::ServicesQoS().reliable().keep_last(1000);
+  const auto notice_pub = schedule_node->create_publisher<Notice>(
+    rmf_traffic_ros2::NegotiationNoticeTopicName, qos);
+  const auto conclusion_pub = schedule_node->create_publisher<Conclusion>(
+    rmf_traffic_ros2::NegotiationConclusionTopicName, qos);
+  const auto proposal_sub = schedule_node->create_subscription<Proposal>(
+    rmf_traffic_ros2::NegotiationProposalTopicName, qos,
+    [&](const Proposal::UniquePtr msg)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      proposals.push_back(*msg);
+    });
+  const auto ack_sub = schedule_node->create_subscription<Ack>(
+    rmf_traffic_ros2::NegotiationAckTopicName, qos,
+    [&](const Ack::UniquePtr msg)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      acks.push_back(*msg);
+    });
+
+  rclcpp::ExecutorOptions executor_options;
+  executor_options.context = context;
+  rclcpp::executors::SingleThreadedExecutor executor(executor_options);
+  executor.add_node(fleet_node);
+  executor.add_node(schedule_node);
+  std::thread spin_thread([&executor]() { executor.spin(); });
+
+  const auto locked = [&](const std::function<bool()>& condition)
+    {
+      return [&mutex, condition]()
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          return condition();
+        };
+    };
+
+  REQUIRE(
+    wait_until(
+      [&]()
+      {
+        return schedule_node->count_subscribers(
+          rmf_traffic_ros2::NegotiationNoticeTopicName) > 0
+        && schedule_node->count_publishers(
+          rmf_traffic_ros2::NegotiationAckTopicName) > 0;
+      }));
+
+  const uint64_t conflict_version = 1;
+  Notice notice;
+  notice.conflict_version = conflict_version;
+  notice.participants = {p0, p1};
+  notice_pub->publish(notice);
+
+  // Both participants are local, so the first complete table gets approved
+  // without waiting for the conclusion. Wait until both complete tables have
+  // been proposed so the conclusion can pick either of them.
+  const auto is_complete = [](const Proposal& p)
+    {
+      return p.to_accommodate.size() == 1;
+    };
+
+  REQUIRE(
+    wait_until(
+      locked([&]()
+      {
+        return approved.size() == 2
+        && std::count_if(proposals.begin(), proposals.end(), is_complete) == 2;
+      })));
+
+  std::vector<Key> early_table;
+  std::vector<Key> other_table;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ParticipantId early_root = p0;
+    for (const auto& sequence : approved)
+    {
+      if (sequence.size() == 1)
+        early_root = sequence.front();
+    }
+
+    for (const auto& p : proposals)
+    {
+      if (!is_complete(p))
+        continue;
+
+      auto table = p.to_accommodate;
+      Key key;
+      key.participant = p.for_participant;
+      key.version = p.proposal_version;
+      table.push_back(key);
+
+      if (table.front().participant == early_root)
+        early_table = table;
+      else
+        other_table = table;
+    }
+  }
+
+  REQUIRE(early_table.size() == 2);
+  REQUIRE(other_table.size() == 2);
+
+  const auto conclude = [&](bool resolved, const std::vector<Key>& table)
+    {
+      Conclusion conclusion;
+      conclusion.conflict_version = conflict_version;
+      conclusion.resolved = resolved;
+      conclusion.table = table;
+      conclusion_pub->publish(conclusion);
+    };
+
+  const auto received_ack = locked([&]() { return !acks.empty(); });
+
+  WHEN("The schedule concludes with the table that was approved early")
+  {
+    conclude(true, early_table);
+    REQUIRE(wait_until(received_ack));
+
+    THEN("Nobody gets approved again")
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      CHECK(approved.size() == 2);
+      CHECK(failures == 0);
+      CHECK(acks.front().acknowledgments.size() == 2);
+    }
+  }
+
+  WHEN("The schedule concludes with a different table")
+  {
+    conclude(true, other_table);
+    REQUIRE(wait_until(received_ack));
+
+    THEN("Only the tables of the concluded sequence get approved")
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      REQUIRE(approved.size() == 4);
+      CHECK(approved[2].size() == 1);
+      CHECK(approved[2].back() == other_table.front().participant);
+      CHECK(approved[3].size() == 2);
+      CHECK(approved[3].back() == other_table.back().participant);
+      CHECK(failures == 0);
+      CHECK(acks.front().acknowledgments.size() == 2);
+    }
+  }
+
+  WHEN("The negotiation fails after it was approved early")
+  {
+    conclude(false, {});
+    REQUIRE(wait_until(received_ack));
+
+    THEN("Every participant is asked to replan")
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      CHECK(approved.size() == 2);
+      CHECK(failures == 2);
+      for (const auto& ack : acks.front().acknowledgments)
+        CHECK_FALSE(ack.updating);
+    }
+  }
+
+  executor.cancel();
+  spin_thread.join();
+  context->shutdown("test finished");
+}
+
+//==============================================================================
+SCENARIO("Negotiations that are handled on several workers")
+{
+  auto context = std::make_shared<rclcpp::Context>();
+  context->init(0, nullptr);
+
+  const auto options = rclcpp::NodeOptions()
+    .context(context)
+    .use_global_arguments(false)
+    .arguments({"--ros-args", "-r", "__ns:=/test_negotiation_workers"});
+
+  const auto fleet_node =
+    std::make_shared<rclcpp::Node>("test_fleet", options);
+  const auto schedule_node =
+    std::make_shared<rclcpp::Node>("test_schedule", options);
+
+  const auto database = std::make_shared<rmf_traffic::schedule::Database>();
+  std::vector<ParticipantId> participants;
+  for (std::size_t i = 0; i < 4; ++i)
+  {
+    participants.push_back(
+      database->register_participant(
+        make_description("p" + std::to_string(i), "test_Negotiation")).id());
+  }
+
+  const auto worker = std::make_shared<PoolWorker>(4);
+  rmf_traffic_ros2::schedule::Negotiation negotiation(
+    *fleet_node, database, worker);
+
+  std::mutex mutex;
+  std::size_t approved = 0;
+  std::vector<Proposal> proposals;
+  std::vector<Ack> acks;
+
+  const auto make_negotiator = [&]()
+    {
+      return [&](
+        rmf_traffic_ros2::schedule::Negotiation::TableViewPtr,
+        rmf_traffic_ros2::schedule::Negotiation::ResponderPtr responder)
+        {
+          responder->submit(
+            {},
+            [&mutex, &approved]()
+            -> rmf_utils::optional<rmf_traffic::schedule::ItineraryVersion>
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              ++approved;
+              return rmf_utils::nullopt;
+            });
+        };
+    };
+
+  std::vector<std::shared_ptr<void>> handles;
+  for (const auto p : participants)
+    handles.push_back(negotiation.register_negotiator(p, make_negotiator()));
+
+  const auto qos = rclcpp::ServicesQoS().reliable().keep_last(1000);
+  const auto notice_pub = schedule_node->create_publisher<Notice>(
+    rmf_traffic_ros2::NegotiationNoticeTopicName, qos);
+  const auto conclusion_pub = schedule_node->create_publisher<Conclusion>(
+    rmf_traffic_ros2::NegotiationConclusionTopicName, qos);
+  const auto proposal_sub = schedule_node->create_subscription<Proposal>(
+    rmf_traffic_ros2::NegotiationProposalTopicName, qos,
+    [&](const Proposal::UniquePtr msg)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      proposals.push_back(*msg);
+    });
+  const auto ack_sub = schedule_node->create_subscription<Ack>(
+    rmf_traffic_ros2::NegotiationAckTopicName, qos,
+    [&](const Ack::UniquePtr msg)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      acks.push_back(*msg);
+    });
+
+  rclcpp::ExecutorOptions executor_options;
+  executor_options.context = context;
+  rclcpp::executors::SingleThreadedExecutor executor(executor_options);
+  executor.add_node(fleet_node);
+  executor.add_node(schedule_node);
+  std::thread spin_thread([&executor]() { executor.spin(); });
+
+  REQUIRE(
+    wait_until(
+      [&]()
+      {
+        return schedule_node->count_subscribers(
+          rmf_traffic_ros2::NegotiationNoticeTopicName) > 0
+        && schedule_node->count_publishers(
+          rmf_traffic_ros2::NegotiationAckTopicName) > 0;
+      }));
+
+  // Every negotiation has three participants, so they overlap with each other
+  // and their tables get submitted from different workers at the same time.
+  const std::size_t negotiation_count = 12;
+  for (uint64_t v = 1; v <= negotiation_count; ++v)
+  {
+    Notice notice;
+    notice.conflict_version = v;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      notice.participants.push_back(
+        participants[(v + i) % participants.size()]);
+    }
+
+    notice_pub->publish(notice);
+  }
+
+  // Each of the three participants ends up last in two complete tables
+  const auto is_complete = [](const Proposal& p)
+    {
+      return p.to_accommodate.size() == 2;
+    };
+
+  REQUIRE(
+    wait_until(
+      [&]()
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<std::size_t>(
+          std::count_if(proposals.begin(), proposals.end(), is_complete))
+        == 6*negotiation_count;
+      }));
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::set<uint64_t> concluded;
+    for (const auto& p : proposals)
+    {
+      if (!is_complete(p) || !concluded.insert(p.conflict_version).second)
+        continue;
+
+      Conclusion conclusion;
+      conclusion.conflict_version = p.conflict_version;
+      conclusion.resolved = true;
+      conclusion.table = p.to_accommodate;
+      Key key;
+      key.participant = p.for_participant;
+      key.version = p.proposal_version;
+      conclusion.table.push_back(key);
+      conclusion_pub->publish(conclusion);
+    }
+  }
+
+  THEN("Every negotiation is acknowledged with all of its approvals")
+  {
+    CHECK(
+      wait_until(
+        [&]()
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          return acks.size() == negotiation_count;
+        }));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(approved == 3*negotiation_count);
+    for (const auto& ack : acks)
+      CHECK(ack.acknowledgments.size() == 3);
+  }
+
+  executor.cancel();
+  spin_thread.join();
+  context->shutdown("test finished");
+}
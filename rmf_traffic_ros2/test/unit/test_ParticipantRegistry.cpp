@@ -174,6 +174,16 @@ SCENARIO("Participant registry restores participants from logger")
         REQUIRE(*_p2 == p2);
         REQUIRE(*_p3 == p3);
       }
+
+      THEN("Restoring onto a DB that already has the participants")
+      {
+        auto logger2 = std::make_unique<TestOperationLogger>(&journal);
+        ParticipantRegistry registry2(std::move(logger2), db1);
+        REQUIRE(db1->participant_ids().size() == 3);
+        CHECK(registry2.add_or_retrieve_participant(p2).id()
+          == participant_id2.id());
+        CHECK(journal.size() == 3);
+      }
     }
   }
 }
@@ -288,3 +298,154 @@ SCENARIO("Test file logger")
     }
   }
 }
+
+SCENARIO("Test journal logger")
+{
+  if (std::filesystem::exists("test_journallogger.jsonl"))
+  {
+    std::remove("test_journallogger.jsonl");
+  }
+
+  const auto shape = rmf_traffic::geometry::make_final_convex<
+    rmf_traffic::geometry::Circle>(1.0);
+
+  rmf_traffic::schedule::ParticipantDescription p1(
+    "participant 1",
+    "test_Participant",
+    rmf_traffic::schedule::ParticipantDescription::Rx::Responsive,
+    rmf_traffic::Profile{shape});
+
+  rmf_traffic::schedule::ParticipantDescription p1_updated(
+    "participant 1",
+    "test_Participant",
+    rmf_traffic::schedule::ParticipantDescription::Rx::Unresponsive,
+    rmf_traffic::Profile{shape});
+
+  rmf_traffic::schedule::ParticipantDescription p2(
+    "participant 2",
+    "test_Participant",
+    rmf_traffic::schedule::ParticipantDescription::Rx::Responsive,
+    rmf_traffic::Profile{shape});
+
+  const auto read_all = [](JournalLogger& logger)
+    {
+      std::vector<AtomicOperation> records;
+      while (auto record = logger.read_next_record())
+        records.push_back(*record);
+
+      return records;
+    };
+
+  GIVEN("non-existant file")
+  {
+    WHEN("Storing two records and an update")
+    {
+      {
+        JournalLogger logger1("test_journallogger.jsonl");
+        logger1.write_operation({AtomicOperation::OpType::Add, p1});
+        logger1.write_operation({AtomicOperation::OpType::Add, p2});
+        logger1.write_operation({AtomicOperation::OpType::Update, p1_updated});
+      }
+
+      THEN("The latest descriptions are restored in registration order")
+      {
+        JournalLogger logger2("test_journallogger.jsonl");
+        const auto records = read_all(logger2);
+        REQUIRE(records.size() == 2);
+        CHECK(records[0] ==
+          AtomicOperation{AtomicOperation::OpType::Add, p1_updated});
+        CHECK(records[1] == AtomicOperation{AtomicOperation::OpType::Add, p2});
+      }
+
+      AND_WHEN("The final record was torn by an interrupted write")
+      {
+        std::ofstream file(
+          "test_journallogger.jsonl", std::ofstream::out | std::ofstream::app);
+        file << "{\"operation\": \"Ad";
+        file.close();
+
+        THEN("The torn record is discarded")
+        {
+          JournalLogger logger2("test_journallogger.jsonl");
+          CHECK(read_all(logger2).size() == 2);
+        }
+      }
+    }
+
+    WHEN("Two participants have names and owners that join the same way")
+    {
+      const rmf_traffic::schedule::ParticipantDescription ab_c(
+        "ab", "c",
+        rmf_traffic::schedule::ParticipantDescription::Rx::Responsive,
+        rmf_traffic::Profile{shape});
+
+      const rmf_traffic::schedule::ParticipantDescription a_bc(
+        "a", "bc",
+        rmf_traffic::schedule::ParticipantDescription::Rx::Responsive,
+        rmf_traffic::Profile{shape});
+
+      {
+        JournalLogger logger1("test_journallogger.jsonl");
+        logger1.write_operation({AtomicOperation::OpType::Add, ab_c});
+        logger1.write_operation({AtomicOperation::OpType::Add, a_bc});
+      }
+
+      THEN("Both participants are restored")
+      {
+        JournalLogger logger2("test_journallogger.jsonl");
+        const auto records = read_all(logger2);
+        REQUIRE(records.size() == 2);
+        CHECK(records[0] ==
+          AtomicOperation{AtomicOperation::OpType::Add, ab_c});
+        CHECK(records[1] ==
+          AtomicOperation{AtomicOperation::OpType::Add, a_bc});
+      }
+    }
+
+    WHEN("Many updates are written")
+    {
+      JournalLogger::Options options;
+      options.min_compaction_size = 4;
+      {
+        JournalLogger logger1("test_journallogger.jsonl", options);
+        logger1.write_operation({AtomicOperation::OpType::Add, p2});
+        for (std::size_t i = 0; i < 10; ++i)
+        {
+          logger1.write_operation(
+            {AtomicOperation::OpType::Update, i%2 == 0 ? p1 : p1_updated});
+        }
+      }
+
+      THEN("The journal is compacted")
+      {
+        std::ifstream file("test_journallogger.jsonl");
+        std::size_t lines = 0;
+        std::string line;
+        while (std::getline(file, line))
+          ++lines;
+
+        CHECK(lines <= 4);
+
+        JournalLogger logger2("test_journallogger.jsonl", options);
+        const auto records = read_all(logger2);
+        REQUIRE(records.size() == 2);
+        CHECK(records[0] == AtomicOperation{AtomicOperation::OpType::Add, p2});
+        CHECK(records[1] ==
+          AtomicOperation{AtomicOperation::OpType::Add, p1_updated});
+      }
+    }
+  }
+
+  GIVEN("a journal with a corrupt record before the end")
+  {
+    std::ofstream invalid;
+    invalid.open("test_journallogger.jsonl", std::ofstream::out);
+    invalid << "\"rubbish json^\n{}\n";
+    invalid.close();
+
+    THEN("throws exception")
+    {
+      REQUIRE_THROWS(JournalLogger("test_journallogger.jsonl"));
+    }
+  }
+}
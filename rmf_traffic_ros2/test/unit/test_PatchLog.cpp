@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_PatchLog.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+
+namespace {
+//==============================================================================
+rclcpp::SerializedMessage make_message(const std::string& payload)
+{
+  rclcpp::SerializedMessage msg(payload.size());
+  auto& raw = msg.get_rcl_serialized_message();
+  std::memcpy(raw.buffer, payload.data(), payload.size());
+  raw.buffer_length = payload.size();
+  return msg;
+}
+
+//==============================================================================
+std::string payload_of(const PatchLogReader::Record& record)
+{
+  return std::string(reinterpret_cast<const char*>(record.data), record.size);
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Recording and reading a patch log")
+{
+  const std::string file = "test_patch_log.bin";
+  std::filesystem::remove(file);
+
+  const auto start = rmf_traffic::Time(std::chrono::seconds(100));
+
+  GIVEN("A log with more records than fit in one chunk")
+  {
+    const std::size_t count = 20000;
+    {
+      PatchLogWriter writer(file);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        writer.append(
+          PatchLogRecordType::MirrorUpdate,
+          start + std::chrono::milliseconds(i),
+          make_message(std::string(i % 1500, 'a' + i % 26)));
+      }
+
+      writer.append(
+        PatchLogRecordType::Participants, start, make_message(""));
+      CHECK(writer.records() == count + 1);
+    }
+
+    THEN("Every record is read back in order")
+    {
+      PatchLogReader reader(file);
+      const auto& records = reader.records();
+      REQUIRE(records.size() == count + 1);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        CHECK(records[i].type == PatchLogRecordType::MirrorUpdate);
+        CHECK(records[i].time == start + std::chrono::milliseconds(i));
+        CHECK(payload_of(records[i]) == std::string(i % 1500, 'a' + i % 26));
+      }
+
+      CHECK(records.back().type == PatchLogRecordType::Participants);
+      CHECK(records.back().size == 0);
+      CHECK(records[7].message().size() == 7);
+    }
+  }
+
+  GIVEN("A log that was not closed")
+  {
+    {
+      std::ofstream out(file, std::ios::binary);
+      out.write("RMFPLOG1", 8);
+      const std::string zeros(64, '\0');
+      out.write(zeros.data(), zeros.size());
+    }
+
+    THEN("The zeroed space is treated as the end of the log")
+    {
+      PatchLogReader reader(file);
+      CHECK(reader.records().empty());
+    }
+  }
+
+  GIVEN("A file that is not a patch log")
+  {
+    {
+      std::ofstream out(file);
+      out << "not a patch log";
+    }
+
+    THEN("Reading it throws")
+    {
+      CHECK_THROWS_AS(PatchLogReader(file), std::runtime_error);
+    }
+  }
+
+  std::filesystem::remove(file);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic/geometry/Box.hpp>
+#include <rmf_utils/catch.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_RegionIndex.hpp"
+#include "TrafficFixtures.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace rmf_traffic_ros2_test;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+RegionIndex::Regions make_regions(const double x, const double y)
+{
+  rmf_traffic::Region region("test_map", {});
+  Eigen::Isometry2d pose = Eigen::Isometry2d::Identity();
+  pose.translation() = Eigen::Vector2d(x, y);
+  region.push_back(
+    rmf_traffic::geometry::Space(
+      rmf_traffic::geometry::make_final_convex<
+        rmf_traffic::geometry::Box>(4.0, 4.0),
+      pose));
+
+  return {region};
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Looking up the participants inside of regions")
+{
+  const auto now = std::chrono::steady_clock::now();
+  rmf_traffic::schedule::Database database;
+  const auto near = database.register_participant(
+    make_description("near", "test_RegionIndex")).id();
+  const auto far = database.register_participant(
+    make_description("far", "test_RegionIndex")).id();
+
+  database.set(near, {make_route("test_map", now, {0, 0, 0}, {10, 0, 0})}, 1);
+  database.set(
+    far, {make_route("test_map", now, {500, 500, 0}, {510, 500, 0})}, 1);
+
+  RegionIndex index(5.0);
+  index.refresh(database);
+  CHECK(index.size() == 2);
+
+  THEN("Only the participants near a region are found")
+  {
+    const auto found = index.participants_in(make_regions(5.0, 0.0));
+    CHECK(found.count(near) == 1);
+    CHECK(found.count(far) == 0);
+  }
+
+  THEN("A region away from every route finds nobody")
+  {
+    CHECK(index.participants_in(make_regions(-200.0, -200.0)).empty());
+  }
+
+  WHEN("A participant moves into the region")
+  {
+    database.set(far, {make_route("test_map", now, {4, 0, 0}, {6, 0, 0})}, 2);
+    index.refresh(database);
+
+    THEN("It is found after the index is refreshed")
+    {
+      const auto found = index.participants_in(make_regions(5.0, 0.0));
+      CHECK(found.count(near) == 1);
+      CHECK(found.count(far) == 1);
+      CHECK(index.participants_in(make_regions(505.0, 500.0)).empty());
+    }
+  }
+
+  WHEN("A participant leaves the schedule")
+  {
+    database.unregister_participant(near);
+    index.refresh(database);
+
+    THEN("It is no longer found")
+    {
+      CHECK(index.size() == 1);
+      CHECK(index.participants_in(make_regions(5.0, 0.0)).empty());
+    }
+  }
+}
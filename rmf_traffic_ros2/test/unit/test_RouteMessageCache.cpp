@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_traffic_ros2/Route.hpp>
+
+#include "../../src/rmf_traffic_ros2/schedule/internal_RouteMessageCache.hpp"
+
+using namespace rmf_traffic_ros2::schedule;
+using namespace std::chrono_literals;
+
+namespace {
+//==============================================================================
+rmf_traffic::ConstRoutePtr make_route(const double x)
+{
+  const auto start = rmf_traffic::Time(0s);
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(start, {x, 0.0, 0.0}, Eigen::Vector3d::Zero());
+  trajectory.insert(start + 10s, {x + 10.0, 0.0, 0.0}, Eigen::Vector3d::Zero());
+  return std::make_shared<rmf_traffic::Route>(
+    "test_map", std::move(trajectory));
+}
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Converting routes through a RouteMessageCache")
+{
+  RouteMessageCache cache(2);
+
+  const auto route_a = make_route(0.0);
+  const auto msg_a = cache.convert(route_a);
+  CHECK(msg_a == rmf_traffic_ros2::convert(*route_a));
+  CHECK(cache.size() == 1);
+
+  GIVEN("The same route again")
+  {
+    CHECK(cache.convert(route_a) == msg_a);
+    CHECK(cache.size() == 1);
+  }
+
+  GIVEN("A route whose original has expired")
+  {
+    {
+      const auto temporary = make_route(5.0);
+      cache.convert(temporary);
+      CHECK(cache.size() == 2);
+    }
+
+    THEN("Its entry is dropped to make room for new routes")
+    {
+      const auto route_b = make_route(20.0);
+      CHECK(cache.convert(route_b) == rmf_traffic_ros2::convert(*route_b));
+      CHECK(cache.size() == 2);
+      CHECK(cache.convert(route_a) == msg_a);
+    }
+  }
+
+  GIVEN("An itinerary")
+  {
+    const auto route_b = make_route(20.0);
+    const auto msgs = cache.convert(
+      rmf_traffic::schedule::Itinerary{route_a, route_b});
+    REQUIRE(msgs.size() == 2);
+    CHECK(msgs[0] == msg_a);
+    CHECK(msgs[1] == rmf_traffic_ros2::convert(*route_b));
+  }
+}
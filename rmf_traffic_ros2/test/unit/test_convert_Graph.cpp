@@ -77,6 +77,59 @@ SCENARIO("Test conversion from rmf_building_map_msgs to rmf_traffic")
     }
   }
 
+  GIVEN("A map that lists a lane before its vertices")
+  {
+    const std::string contents = R"({
+      "features": [
+        {
+          "feature_type": "rmf_lane",
+          "geometry": {
+            "coordinates": [
+              [103.5824722729539, 1.0255337442883958],
+              [103.58696991419195, 1.0166571149261503]
+            ],
+            "type": "LineString"
+          },
+          "properties": {"bidirectional": true, "level_idx": 0},
+          "type": "Feature"
+        },
+        {
+          "feature_type": "rmf_vertex",
+          "geometry": {
+            "coordinates": [103.5824722729539, 1.0255337442883958],
+            "type": "Point"
+          },
+          "properties": {"level_idx": 0, "name": "a"},
+          "type": "Feature"
+        },
+        {
+          "feature_type": "rmf_vertex",
+          "geometry": {
+            "coordinates": [103.58696991419195, 1.0166571149261503],
+            "type": "Point"
+          },
+          "properties": {"level_idx": 0, "name": "b"},
+          "type": "Feature"
+        }
+      ],
+      "preferred_crs": "EPSG:3414",
+      "site_name": "building"
+    })";
+
+    rmf_site_map_msgs::msg::SiteMap msg;
+    msg.encoding = msg.MAP_DATA_GEOJSON;
+    msg.data = {contents.begin(), contents.end()};
+    const auto graph = rmf_traffic_ros2::convert(msg, 0);
+
+    THEN("The lane still connects both vertices")
+    {
+      CHECK(graph.num_waypoints() == 2);
+      REQUIRE(graph.find_waypoint("a") != nullptr);
+      REQUIRE(graph.find_waypoint("b") != nullptr);
+      CHECK(graph.num_lanes() == 2);
+      CHECK(graph.lanes_from(graph.find_waypoint("a")->index()).size() == 1);
+    }
+  }
 }
 
 /*
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic/geometry/Circle.hpp>
+#include <rmf_traffic_ros2/Profile.hpp>
+
+#include <rmf_utils/catch.hpp>
+
+//==============================================================================
+SCENARIO("Converting profiles shares identical shapes")
+{
+  using rmf_traffic::geometry::Circle;
+  using rmf_traffic::geometry::make_final_convex;
+
+  const rmf_traffic::Profile profile{
+    make_final_convex<Circle>(0.5),
+    make_final_convex<Circle>(1.5)
+  };
+
+  const auto msg = rmf_traffic_ros2::convert(profile);
+  const auto first = rmf_traffic_ros2::convert(msg);
+  const auto second = rmf_traffic_ros2::convert(msg);
+
+  CHECK(first.footprint() == second.footprint());
+  CHECK(first.vicinity() == second.vicinity());
+  CHECK(first.footprint() != first.vicinity());
+
+  GIVEN("A message whose shape context repeats a circle")
+  {
+    auto repeated = msg;
+    repeated.shape_context.circles.push_back(
+      repeated.shape_context.circles.front());
+    repeated.vicinity.index = repeated.shape_context.circles.size() - 1;
+
+    THEN("The indices of the message are kept")
+    {
+      const auto converted = rmf_traffic_ros2::convert(repeated);
+      REQUIRE(converted.vicinity());
+      CHECK(converted.vicinity() == converted.footprint());
+    }
+  }
+}